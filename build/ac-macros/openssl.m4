@@ -0,0 +1,107 @@
+dnl ===================================================================
+dnl   Licensed to the Apache Software Foundation (ASF) under one
+dnl   or more contributor license agreements.  See the NOTICE file
+dnl   distributed with this work for additional information
+dnl   regarding copyright ownership.  The ASF licenses this file
+dnl   to you under the Apache License, Version 2.0 (the
+dnl   "License"); you may not use this file except in compliance
+dnl   with the License.  You may obtain a copy of the License at
+dnl
+dnl     http://www.apache.org/licenses/LICENSE-2.0
+dnl
+dnl   Unless required by applicable law or agreed to in writing,
+dnl   software distributed under the License is distributed on an
+dnl   "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+dnl   KIND, either express or implied.  See the License for the
+dnl   specific language governing permissions and limitations
+dnl   under the License.
+dnl ===================================================================
+dnl
+dnl  SVN_LIB_OPENSSL
+dnl
+dnl  Check configure options and assign variables related to
+dnl  the OpenSSL library.  It provides TLS for the svn:// protocol
+dnl  and requires OpenSSL 1.1.1 or newer.
+dnl
+dnl  If we find the library, set the shell variable
+dnl  `svn_lib_openssl' to `yes'.  Otherwise, set `svn_lib_openssl'
+dnl  to `no'.
+
+AC_DEFUN(SVN_LIB_OPENSSL,
+[
+  AC_ARG_WITH(openssl, [AS_HELP_STRING([--with-openssl=PATH],
+                                       [Compile with OpenSSL in PATH])],
+  [
+    with_openssl="$withval"
+    required="yes"
+  ],
+  [
+    with_openssl="yes"
+    required="no"
+  ])
+
+  AC_MSG_CHECKING([whether to look for OpenSSL])
+
+  if test "${with_openssl}" = "no"; then
+    AC_MSG_RESULT([no])
+    svn_lib_openssl=no
+  else
+    AC_MSG_RESULT([yes])
+    saved_LDFLAGS="$LDFLAGS"
+    saved_CPPFLAGS="$CPPFLAGS"
+
+    if test "$with_openssl" = "yes"; then
+      AC_MSG_NOTICE([Looking in default locations])
+      AC_CHECK_HEADER(openssl/ssl.h,
+        [AC_CHECK_LIB(ssl, SSL_CTX_set_ciphersuites,
+                      svn_lib_openssl=yes,
+                      svn_lib_openssl=no, -lcrypto)],
+        svn_lib_openssl=no)
+      if test "$svn_lib_openssl" = "no"; then
+        with_openssl="/usr/local"
+      fi
+    else
+      svn_lib_openssl=no
+    fi
+
+    if test "$svn_lib_openssl" = "no"; then
+      SVN_OPENSSL_INCLUDES="-I${with_openssl}/include"
+      CPPFLAGS="$CPPFLAGS $SVN_OPENSSL_INCLUDES"
+      LDFLAGS="$LDFLAGS `SVN_REMOVE_STANDARD_LIB_DIRS(-L${with_openssl}/lib)`"
+
+      dnl Don't let a failed check in the default locations shadow
+      dnl the one in the given location.
+      unset ac_cv_header_openssl_ssl_h
+      unset ac_cv_lib_ssl_SSL_CTX_set_ciphersuites
+      AC_CHECK_HEADER(openssl/ssl.h,
+        [AC_CHECK_LIB(ssl, SSL_CTX_set_ciphersuites,
+                      svn_lib_openssl=yes,
+                      svn_lib_openssl=no, -lcrypto)],
+        svn_lib_openssl=no)
+    fi
+
+    AC_MSG_CHECKING([for availability of OpenSSL 1.1.1 or newer])
+    if test "$svn_lib_openssl" = "yes"; then
+      SVN_OPENSSL_LIBS="-lssl"
+      SVN_LIBCRYPTO_LIBS="-lcrypto"
+      AC_MSG_RESULT([yes])
+    else
+      AC_MSG_RESULT([no])
+
+      if test "$required" = "yes"; then
+        dnl The user explicitly requested OpenSSL, but we couldn't find it.
+        dnl Exit with an error message.
+        AC_MSG_ERROR([Could not find OpenSSL 1.1.1 or newer])
+      fi
+
+      SVN_OPENSSL_INCLUDES=""
+      LDFLAGS="$saved_LDFLAGS"
+    fi
+
+    CPPFLAGS="$saved_CPPFLAGS"
+  fi
+
+  AC_SUBST(SVN_OPENSSL_INCLUDES)
+  AC_SUBST(SVN_OPENSSL_LIBS)
+  AC_SUBST(SVN_LIBCRYPTO_LIBS)
+])
@@ -120,6 +120,7 @@ class GenDependenciesBase(gen_base.GeneratorBase):
         'ruby',
         'java_sdk',
         'openssl',
+        'libcrypto',
         'apr_memcache',
 
         # So optional, we don't even have any code to detect them on Windows
@@ -898,7 +899,8 @@ class GenDependenciesBase(gen_base.GeneratorBase):
                                                   openssl_version,
                                                   dll_name='%s%s.dll' %
                                                       (libssl, versuffix),
-                                                  dll_dir=bin_dir)
+                                                  dll_dir=bin_dir,
+                                                  defines=['SVN_HAVE_OPENSSL'])
 
     self._libraries['libcrypto'] = SVNCommonLibrary('openssl', inc_dir, lib_dir,
                                                     '%s.lib' % (libcrypto,),
@@ -353,6 +353,32 @@ typedef struct svn_fs_fs__ioctl_revision_size_output_t
 /* See svn_fs_fs__revision_size(). */
 SVN_FS_DECLARE_IOCTL_CODE(SVN_FS_FS__IOCTL_REVISION_SIZE, SVN_FS_TYPE_FSFS, 1003);
 
+/* See svn_fs_fs__bulk_load_checkpoint().  Takes no input and produces
+ * no output. */
+SVN_FS_DECLARE_IOCTL_CODE(SVN_FS_FS__IOCTL_BULK_LOAD_CHECKPOINT, SVN_FS_TYPE_FSFS, 1004);
+
+typedef struct svn_fs_fs__ioctl_plain_contents_input_t
+{
+  svn_fs_root_t *root;
+  const char *path;
+} svn_fs_fs__ioctl_plain_contents_input_t;
+
+typedef struct svn_fs_fs__ioctl_plain_contents_output_t
+{
+  /* Open rev or pack file containing the fulltext verbatim.  NULL if
+   * the contents are not stored that way. */
+  apr_file_t *file;
+
+  /* Position of the first byte of the fulltext within FILE. */
+  apr_off_t offset;
+
+  /* Length of the fulltext in bytes. */
+  svn_filesize_t length;
+} svn_fs_fs__ioctl_plain_contents_output_t;
+
+/* See svn_fs_fs__get_plain_contents(). */
+SVN_FS_DECLARE_IOCTL_CODE(SVN_FS_FS__IOCTL_PLAIN_CONTENTS, SVN_FS_TYPE_FSFS, 1005);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
@@ -211,6 +211,17 @@ svn_fs__get_deleted_node(svn_fs_root_t **node_root,
                          apr_pool_t *result_pool,
                          apr_pool_t *scratch_pool);
 
+/** Return the instance ID of @a fs, which tells it apart from other
+ * filesystems with the same UUID, e.g. a repository that got replaced by
+ * a dump / load cycle or a hotcopy.  Return NULL if the backend or the
+ * repository format does not support instance IDs.  The result lives as
+ * long as @a fs.
+ *
+ * Caches that outlive @a fs should include it in their keys.
+ */
+const char *
+svn_fs__instance_id(svn_fs_t *fs);
+
 
 /** @} */
 
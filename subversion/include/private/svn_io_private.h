@@ -84,6 +84,42 @@ svn_error_t *
 svn_io__file_lock_autocreate(const char *lock_file,
                              apr_pool_t *pool);
 
+/** Set @a *remote to TRUE if @a path resides on a network file system,
+ * such as NFS or SMB, and to FALSE otherwise.  Set it to FALSE as well,
+ * if the file system type cannot be determined on this platform.
+ *
+ * Use @a scratch_pool for temporary allocations.
+ */
+svn_error_t *
+svn_io__is_remote_file_system(svn_boolean_t *remote,
+                              const char *path,
+                              apr_pool_t *scratch_pool);
+
+/** Create a hard link at @a dst_abspath to the existing file at
+ * @a src_abspath.  Both must be on the same file system and
+ * @a dst_abspath must not exist.
+ *
+ * Return #SVN_ERR_UNSUPPORTED_FEATURE if the platform doesn't support
+ * hard links.  Use @a scratch_pool for temporary allocations.
+ */
+svn_error_t *
+svn_io__file_link(const char *src_abspath,
+                  const char *dst_abspath,
+                  apr_pool_t *scratch_pool);
+
+/** Copy the whole contents of @a from_file to @a to_file, like
+ * svn_io_copy_file() does.  Both files must be positioned at their start
+ * and @a to_file must be empty.
+ *
+ * Where the file system supports it, @a to_file shares the data blocks
+ * of @a from_file (copy-on-write) instead of getting a copy of them.
+ * Use @a scratch_pool for temporary allocations.
+ */
+svn_error_t *
+svn_io__copy_file_contents(apr_file_t *from_file,
+                           apr_file_t *to_file,
+                           apr_pool_t *scratch_pool);
+
 
 /** Return the underlying file, if any, associated with the stream, or
  * NULL if not available.  Accessing the file bypasses the stream.
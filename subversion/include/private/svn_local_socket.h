@@ -0,0 +1,80 @@
+/**
+ * @copyright
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ * @endcopyright
+ *
+ * @file svn_local_socket.h
+ * @brief Helpers for Unix domain sockets
+ */
+
+#ifndef SVN_LOCAL_SOCKET_H
+#define SVN_LOCAL_SOCKET_H
+
+#include <apr_pools.h>
+
+#include "svn_types.h"
+#include "svn_error.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+#ifndef WIN32
+
+/** Defined if the functions below are available. */
+#define SVN_HAVE_LOCAL_SOCKETS
+
+struct sockaddr_un;
+
+/**
+ * Set @a *native_path to @a socket_path in native encoding and fill
+ * @a *addr with the address of the Unix domain socket at that path.
+ * Return #SVN_ERR_BAD_FILENAME if the path doesn't fit into @a *addr.
+ * Use @a pool for allocations.
+ */
+svn_error_t *
+svn_io__local_socket_address(const char **native_path,
+                             struct sockaddr_un *addr,
+                             const char *socket_path,
+                             apr_pool_t *pool);
+
+/**
+ * Don't let child processes inherit the file descriptor @a fd.
+ * Failures are ignored.
+ */
+void
+svn_io__set_cloexec(int fd);
+
+/**
+ * Return #svn_tristate_true if the process at the other end of the
+ * connected Unix domain socket @a sock runs as the same user as we do,
+ * #svn_tristate_false if it doesn't or we failed to find out, and
+ * #svn_tristate_unknown if the platform has no way to tell.
+ */
+svn_tristate_t
+svn_io__local_socket_peer_is_self(int sock);
+
+#endif /* WIN32 */
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* SVN_LOCAL_SOCKET_H */
@@ -154,6 +154,67 @@ svn_ra__release_operational_lock(svn_ra_session_t *session,
                                  const svn_string_t *mylocktoken,
                                  apr_pool_t *scratch_pool);
 
+/** Like svn_ra_check_path() but for many @a paths at once.
+ *
+ * @a paths contains <tt>const char *</tt> paths relative to the session
+ * URL and @a revisions the respective #svn_revnum_t to check them in.
+ * Set @a *kinds to an array of #svn_node_kind_t in the same order,
+ * allocated in @a result_pool.
+ *
+ * RA layers that support it send all requests before waiting for the
+ * responses, saving a network round trip per path.
+ *
+ * Use @a scratch_pool for temporary allocations.
+ *
+ * @since New in 1.13.
+ */
+svn_error_t *
+svn_ra__check_paths(svn_ra_session_t *session,
+                    apr_array_header_t **kinds,
+                    const apr_array_header_t *paths,
+                    const apr_array_header_t *revisions,
+                    apr_pool_t *result_pool,
+                    apr_pool_t *scratch_pool);
+
+/** Like svn_ra_get_dir2() but for many directories at once and without
+ * fetching their properties.
+ *
+ * @a paths and @a revisions are the same as for svn_ra__check_paths().
+ * Set @a *dirents to an array of <tt>apr_hash_t *</tt> in the same order,
+ * each mapping the entry names of the respective directory to
+ * <tt>svn_dirent_t *</tt> with the fields selected by @a dirent_fields.
+ * Allocate the result in @a result_pool.
+ *
+ * Use @a scratch_pool for temporary allocations.
+ *
+ * @since New in 1.13.
+ */
+svn_error_t *
+svn_ra__get_dirs(svn_ra_session_t *session,
+                 apr_array_header_t **dirents,
+                 const apr_array_header_t *paths,
+                 const apr_array_header_t *revisions,
+                 apr_uint32_t dirent_fields,
+                 apr_pool_t *result_pool,
+                 apr_pool_t *scratch_pool);
+
+/** Like svn_ra_rev_proplist() but for many @a revisions at once.
+ *
+ * @a revisions contains the #svn_revnum_t to fetch the revision
+ * properties of.  Set @a *props to an array of <tt>apr_hash_t *</tt> in
+ * the same order, allocated in @a result_pool.
+ *
+ * Use @a scratch_pool for temporary allocations.
+ *
+ * @since New in 1.13.
+ */
+svn_error_t *
+svn_ra__rev_proplists(svn_ra_session_t *session,
+                      apr_array_header_t **props,
+                      const apr_array_header_t *revisions,
+                      apr_pool_t *result_pool,
+                      apr_pool_t *scratch_pool);
+
 /** Register CALLBACKS to be used with the Ev2 shims in RA_SESSION. */
 svn_error_t *
 svn_ra__register_editor_shim_callbacks(svn_ra_session_t *ra_session,
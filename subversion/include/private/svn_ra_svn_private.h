@@ -27,6 +27,7 @@
 #ifndef SVN_RA_SVN_PRIVATE_H
 #define SVN_RA_SVN_PRIVATE_H
 
+#include "svn_auth.h"
 #include "svn_ra_svn.h"
 #include "svn_editor.h"
 
@@ -146,6 +147,176 @@ svn_ra_svn__set_shim_callbacks(svn_ra_svn_conn_t *conn,
 apr_pool_t *
 svn_ra_svn__get_pool(svn_ra_svn_conn_t *conn);
 
+/**
+ * Return TRUE if svn_ra_svn__write_string_from_file() can send file
+ * contents directly to the socket of @a conn.
+ */
+svn_boolean_t
+svn_ra_svn__can_sendfile(svn_ra_svn_conn_t *conn);
+
+/**
+ * Return the number of bytes that have been sent directly from files to
+ * the socket of @a conn so far.
+ */
+apr_uint64_t
+svn_ra_svn__sendfile_bytes(svn_ra_svn_conn_t *conn);
+
+/**
+ * Write the @a len bytes at @a data verbatim to @a conn, e.g. a response
+ * recorded earlier through svn_ra_svn__start_recording().  Use @a pool
+ * for temporary allocations.
+ */
+svn_error_t *
+svn_ra_svn__write_raw(svn_ra_svn_conn_t *conn,
+                      apr_pool_t *pool,
+                      const char *data,
+                      apr_size_t len);
+
+/**
+ * Start recording everything subsequently written to @a conn, up to
+ * @a limit bytes.  Allocate the recording in @a pool.
+ *
+ * The recording ends with svn_ra_svn__stop_recording() or, at the latest,
+ * when the command handler that started it returns.
+ */
+void
+svn_ra_svn__start_recording(svn_ra_svn_conn_t *conn,
+                            apr_size_t limit,
+                            apr_pool_t *pool);
+
+/**
+ * Stop recording on @a conn and return all data written since
+ * svn_ra_svn__start_recording().  Return NULL if that exceeded the limit
+ * or could not be recorded or if no recording was active.
+ */
+svn_stringbuf_t *
+svn_ra_svn__stop_recording(svn_ra_svn_conn_t *conn);
+
+/**
+ * Switch @a conn to multiplexed framing.  @a conn itself continues as
+ * channel 0.  Further channels can then be opened with
+ * svn_ra_svn__mux_open() and accepted with svn_ra_svn__mux_accept().
+ * The caller must make sure that the peer switches at the same point
+ * in the data stream.  Use @a scratch_pool for temporary allocations.
+ */
+svn_error_t *
+svn_ra_svn__mux_start(svn_ra_svn_conn_t *conn,
+                      apr_pool_t *scratch_pool);
+
+/**
+ * Return TRUE if @a conn is a channel of a multiplexed connection.
+ */
+svn_boolean_t
+svn_ra_svn__is_multiplexed(svn_ra_svn_conn_t *conn);
+
+/**
+ * Open a new channel on the multiplexed connection that @a conn belongs
+ * to and return it in @a *channel, allocated in @a result_pool.  The
+ * channel gets closed when @a result_pool is cleaned up.  Channels may
+ * outlive @a conn but will report the connection as closed once the
+ * connection behind channel 0 has been destroyed.
+ */
+svn_error_t *
+svn_ra_svn__mux_open(svn_ra_svn_conn_t **channel,
+                     svn_ra_svn_conn_t *conn,
+                     apr_pool_t *result_pool);
+
+/**
+ * Wait for the peer to open a new channel on the multiplexed connection
+ * that @a conn belongs to and return it in @a *channel, allocated in
+ * @a result_pool.  Set @a *channel to NULL once the connection has been
+ * closed.  The channel gets closed when @a result_pool is cleaned up.
+ *
+ * This may be called from another thread than the ones using the other
+ * channels of the connection.
+ */
+svn_error_t *
+svn_ra_svn__mux_accept(svn_ra_svn_conn_t **channel,
+                       svn_ra_svn_conn_t *conn,
+                       apr_pool_t *result_pool);
+
+/**
+ * TLS settings and shared state for the connections of one server or
+ * client.  Only available if Subversion has been built with OpenSSL,
+ * i.e. if @c SVN_HAVE_OPENSSL is defined.
+ */
+typedef struct svn_ra_svn__tls_ctx_t svn_ra_svn__tls_ctx_t;
+
+/**
+ * Create a server-side TLS context in @a *ctx, allocated in @a result_pool,
+ * using the PEM encoded certificate chain in @a cert_file and the private
+ * key in @a key_file.  @a key_file may be the same as @a cert_file.
+ *
+ * Session tickets issued by this context can be used by all connections
+ * that share it, including the ones served by forked child processes.
+ */
+svn_error_t *
+svn_ra_svn__tls_server_ctx_create(svn_ra_svn__tls_ctx_t **ctx,
+                                  const char *cert_file,
+                                  const char *key_file,
+                                  apr_pool_t *result_pool);
+
+/**
+ * Create a client-side TLS context in @a *ctx, allocated in @a result_pool.
+ * Trust the system's default certificate authorities if
+ * @a trust_default_ca is set and the PEM encoded ones in the files listed
+ * in @a authority_files, separated by semicolons.  The latter may be NULL.
+ */
+svn_error_t *
+svn_ra_svn__tls_client_ctx_create(svn_ra_svn__tls_ctx_t **ctx,
+                                  svn_boolean_t trust_default_ca,
+                                  const char *authority_files,
+                                  apr_pool_t *result_pool);
+
+/**
+ * Perform the server side of a TLS handshake on @a conn using @a ctx,
+ * which must outlive @a conn.  All further data on @a conn is encrypted.
+ * Use @a scratch_pool for temporary allocations.
+ */
+svn_error_t *
+svn_ra_svn__tls_accept(svn_ra_svn_conn_t *conn,
+                       svn_ra_svn__tls_ctx_t *ctx,
+                       apr_pool_t *scratch_pool);
+
+/**
+ * Perform the client side of a TLS handshake on @a conn using @a ctx,
+ * which must outlive @a conn, for the server at @a hostname and @a port.
+ * All further data on @a conn is encrypted.
+ *
+ * Resume an earlier session with the same server, if there is one that has
+ * been trusted through svn_ra_svn__tls_set_trusted() in this process.
+ * Set @a *resumed accordingly, unless @a resumed is NULL.
+ *
+ * Set @a *failures to the @c SVN_AUTH_SSL_* flags for all problems found
+ * while verifying the server certificate, i.e. 0 if it can be trusted.
+ * Use @a scratch_pool for temporary allocations.
+ */
+svn_error_t *
+svn_ra_svn__tls_connect(apr_uint32_t *failures,
+                        svn_boolean_t *resumed,
+                        svn_ra_svn_conn_t *conn,
+                        svn_ra_svn__tls_ctx_t *ctx,
+                        const char *hostname,
+                        int port,
+                        apr_pool_t *scratch_pool);
+
+/**
+ * Return a description of the certificate that the server presented to the
+ * client connection @a conn in @a *cert_info, allocated in @a result_pool.
+ */
+svn_error_t *
+svn_ra_svn__tls_get_server_cert(svn_auth_ssl_server_cert_info_t **cert_info,
+                                svn_ra_svn_conn_t *conn,
+                                apr_pool_t *result_pool);
+
+/**
+ * Allow later connections to resume the TLS session of the client
+ * connection @a conn.  Call this once the server certificate has been
+ * accepted.
+ */
+svn_error_t *
+svn_ra_svn__tls_set_trusted(svn_ra_svn_conn_t *conn);
+
 /**
  * @defgroup ra_svn_deprecated ra_svn low-level functions
  * @{
@@ -178,6 +349,21 @@ svn_ra_svn__write_cstring(svn_ra_svn_conn_t *conn,
                           apr_pool_t *pool,
                           const char *s);
 
+/** Write @a len bytes starting at @a offset in @a file over the net as
+ * a single string.
+ *
+ * If @a conn writes to a plain socket and the platform supports it, the
+ * data will be sent directly from the file to the socket (sendfile),
+ * i.e. without copying it through any user-space buffer.  The write
+ * buffer will be flushed before that.
+ */
+svn_error_t *
+svn_ra_svn__write_string_from_file(svn_ra_svn_conn_t *conn,
+                                   apr_pool_t *pool,
+                                   apr_file_t *file,
+                                   apr_off_t offset,
+                                   apr_size_t len);
+
 /** Write a word over the net.
  *
  * Writes will be buffered until the next read or flush.
@@ -335,6 +521,50 @@ svn_ra_svn__read_tuple(svn_ra_svn_conn_t *conn,
                        apr_pool_t *pool,
                        const char *fmt, ...);
 
+/** One element of a precompiled tuple parser, see
+ * svn_ra_svn__read_fields().  @a kind is one of the specs 'n', 'r', 's',
+ * 'c', 'w', 'b', '(', ')' or '?' of svn_ra_svn__parse_tuple().  The
+ * decoded value is stored in the target struct at @a offset, using the
+ * argument type listed there minus one level of indirection.  @a offset
+ * is ignored for '(', ')' and '?'.  A table of fields ends with an entry
+ * whose @a kind is 0.
+ */
+typedef struct svn_ra_svn__field_t
+{
+  char kind;
+  apr_size_t offset;
+} svn_ra_svn__field_t;
+
+/** Read the opening paren and the command word of the next command tuple
+ * from @a conn and return the word in @a *command.  The command
+ * parameters are still pending.  Use svn_ra_svn__read_fields() or
+ * svn_ra_svn__read_item() to read them and svn_ra_svn__read_tuple_end()
+ * to finish the command.
+ */
+svn_error_t *
+svn_ra_svn__read_command_start(svn_ra_svn_conn_t *conn,
+                               apr_pool_t *pool,
+                               const char **command);
+
+/** Read a tuple from the network and decode it directly into the struct
+ * at @a target as described by @a fields.  Unlike svn_ra_svn__read_tuple(),
+ * this does not build an intermediate item tree.  Only strings will be
+ * allocated in @a pool.  Trailing elements not covered by @a fields are
+ * skipped.  Optional parts work as in svn_ra_svn__parse_tuple().
+ */
+svn_error_t *
+svn_ra_svn__read_fields(svn_ra_svn_conn_t *conn,
+                        apr_pool_t *pool,
+                        const svn_ra_svn__field_t *fields,
+                        void *target);
+
+/** Skip the remaining elements of the tuple that is currently being read
+ * from @a conn, including its closing paren.
+ */
+svn_error_t *
+svn_ra_svn__read_tuple_end(svn_ra_svn_conn_t *conn,
+                           apr_pool_t *pool);
+
 /** Parse an array of @c svn_ra_svn__item_t structures as a list of
  * properties, storing the properties in a hash table.
  *
@@ -419,6 +649,21 @@ svn_ra_svn__write_cmd_failure(svn_ra_svn_conn_t *conn,
                               apr_pool_t *pool,
                               const svn_error_t *err);
 
+/** Return a pointer to the error chain child of @a err which contains the
+ * first "real" error message, not merely one of the
+ * @c SVN_ERR_RA_SVN_CMD_ERR wrapper errors.
+ */
+svn_error_t *
+svn_ra_svn__locate_real_error_child(svn_error_t *err);
+
+/** Signal a new request / response pair on @a conn.  That resets the I/O
+ * counters we use to limit the size of individual requests / response
+ * pairs.  Command loops that don't use svn_ra_svn__handle_commands2()
+ * must call this before reading each command.
+ */
+void
+svn_ra_svn__reset_command_io_counters(svn_ra_svn_conn_t *conn);
+
 /**
  * @}
  */
@@ -687,6 +932,15 @@ svn_ra_svn__write_cmd_reparent(svn_ra_svn_conn_t *conn,
                                apr_pool_t *pool,
                                const char *url);
 
+/** Send a "multiplex" command over connection @a conn.
+ * Use @a pool for allocations.
+ *
+ * @see svn_ra_svn__mux_start() for a description.
+ */
+svn_error_t *
+svn_ra_svn__write_cmd_multiplex(svn_ra_svn_conn_t *conn,
+                                apr_pool_t *pool);
+
 /** Send a "get-latest-rev" command over connection @a conn.
  * Use @a pool for allocations.
  *
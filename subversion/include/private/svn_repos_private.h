@@ -129,6 +129,23 @@ svn_repos__fs_type(const char **fs_type,
                    apr_pool_t *pool);
 
 
+/* Let reports on REPOS read the sub-trees that an update or checkout
+ * adds in worker threads, ahead of the editor drive, if PREFETCH is set.
+ * This warms the FS caches at the cost of some threads and FS instances
+ * per report.  It is off by default and has no effect if the FS caches
+ * are not shared between threads or APR has no thread support. */
+void
+svn_repos__set_report_prefetch(svn_repos_t *repos,
+                               svn_boolean_t prefetch);
+
+/* Return a string identifying the rules in AUTHZ, such that two authz
+ * objects with the same ID grant the same access.  Return NULL if AUTHZ
+ * has not been read from files, i.e. there is no such ID.  Allocate the
+ * result in RESULT_POOL. */
+const char *
+svn_repos__authz_id(const svn_authz_t *authz,
+                    apr_pool_t *result_pool);
+
 /* Create a commit editor for REPOS, based on REVISION.  */
 svn_error_t *
 svn_repos__get_commit_ev2(svn_editor_t **editor,
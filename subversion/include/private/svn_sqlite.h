@@ -133,6 +133,38 @@ svn_sqlite__open(svn_sqlite__db_t **db, const char *path,
 svn_error_t *
 svn_sqlite__close(svn_sqlite__db_t *db);
 
+/* Switch DB to write-ahead logging if ENABLE is svn_tristate_true, or back
+   to the rollback journal if it is svn_tristate_false, and set *WAL to
+   whether DB uses write-ahead logging afterwards.  svn_tristate_unknown
+   keeps the current journal mode.  Switching back is not possible while
+   other connections use the database; we don't wait for them but simply
+   keep using the log in that case.
+
+   With write-ahead logging, readers don't block the writer and vice versa.
+   But it needs shared memory between all connections to the database, so
+   don't enable it for databases on network file systems.  The choice is
+   stored in the database and used by all connections until it changes.
+
+   If AUTOCHECKPOINT is positive, have SQLite copy the log back into the
+   database whenever it grows beyond that many pages.  0 disables automatic
+   checkpoints and negative values keep the SQLite default.  Use
+   SCRATCH_POOL for temporary allocations. */
+svn_error_t *
+svn_sqlite__set_wal(svn_boolean_t *wal,
+                    svn_sqlite__db_t *db,
+                    svn_tristate_t enable,
+                    int autocheckpoint,
+                    apr_pool_t *scratch_pool);
+
+/* Set the page cache of DB to CACHE_SIZE KiB and let SQLite memory map up
+   to MMAP_SIZE bytes of the database file.  Negative values keep the
+   respective SQLite default.  Use SCRATCH_POOL for temporary allocations. */
+svn_error_t *
+svn_sqlite__set_cache_size(svn_sqlite__db_t *db,
+                           apr_int64_t cache_size,
+                           apr_int64_t mmap_size,
+                           apr_pool_t *scratch_pool);
+
 /* Add a custom function to be used with this database connection.  The data
    in BATON should live at least as long as the connection in DB.
 
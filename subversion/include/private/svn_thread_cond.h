@@ -0,0 +1,84 @@
+/**
+ * @copyright
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ * @endcopyright
+ *
+ * @file svn_thread_cond.h
+ * @brief Condition variables
+ */
+
+#ifndef SVN_THREAD_COND_H
+#define SVN_THREAD_COND_H
+
+#include <apr_pools.h>
+
+#if APR_HAS_THREADS
+#include <apr_thread_cond.h>
+#endif
+
+#include "svn_error.h"
+#include "private/svn_mutex.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/**
+ * This is a simple wrapper around @c apr_thread_cond_t and will be a
+ * valid identifier even if APR does not support threading.  In that
+ * case, all operations are no-ops.
+ */
+#if APR_HAS_THREADS
+typedef apr_thread_cond_t svn_thread_cond__t;
+#else
+typedef int svn_thread_cond__t;
+#endif
+
+/** Create a condition variable in @a *cond with a lifetime defined by
+ * @a result_pool.
+ */
+svn_error_t *
+svn_thread_cond__create(svn_thread_cond__t **cond,
+                        apr_pool_t *result_pool);
+
+/** Wake up one thread waiting for @a cond.
+ */
+svn_error_t *
+svn_thread_cond__signal(svn_thread_cond__t *cond);
+
+/** Wake up all threads waiting for @a cond.
+ */
+svn_error_t *
+svn_thread_cond__broadcast(svn_thread_cond__t *cond);
+
+/** Wait for @a cond to be signaled.  The caller must hold @a mutex,
+ * which will be released while waiting and reacquired before returning.
+ * Spurious wake-ups are possible, so callers should check their
+ * condition in a loop.
+ */
+svn_error_t *
+svn_thread_cond__wait(svn_thread_cond__t *cond,
+                      svn_mutex__t *mutex);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* SVN_THREAD_COND_H */
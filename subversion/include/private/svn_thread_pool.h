@@ -0,0 +1,94 @@
+/**
+ * @copyright
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ * @endcopyright
+ *
+ * @file svn_thread_pool.h
+ * @brief Process-wide worker thread pools
+ */
+
+#ifndef SVN_THREAD_POOL_H
+#define SVN_THREAD_POOL_H
+
+#include <apr_pools.h>
+
+#if APR_HAS_THREADS
+#include <apr_thread_pool.h>
+#endif
+
+#include "svn_error.h"
+#include "private/svn_atomic.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+#if APR_HAS_THREADS
+
+/**
+ * A pool of worker threads that gets created upon first use and is
+ * shared by all users within the process.  Declare instances as static
+ * variables and initialize them with #SVN_THREAD_POOL__SHARED_INIT.
+ */
+typedef struct svn_thread_pool__shared_t
+{
+  /** Maximum number of threads in @a thread_pool. */
+  apr_size_t max_threads;
+
+  /** Untranslated error message to use if @a thread_pool can't be
+   * created.  Mark it with N_() for translation. */
+  const char *error_message;
+
+  /** The thread pool itself.  NULL until it got created. */
+  apr_thread_pool_t *thread_pool;
+
+  /** Keeps track on whether we already created @a thread_pool. */
+  volatile svn_atomic_t initialized;
+} svn_thread_pool__shared_t;
+
+/** Static initializer for #svn_thread_pool__shared_t with up to
+ * @a max_threads threads.  Creation failures will be reported using
+ * @a error_message, which must be a string literal marked with N_().
+ */
+#define SVN_THREAD_POOL__SHARED_INIT(max_threads, error_message) \
+  { (max_threads), (error_message), NULL, FALSE }
+
+/** Set @a *thread_pool to the threads of @a shared, creating them if this
+ * is the first call.  Idle threads will linger for a while before they
+ * terminate and tasks only get queued once all threads are busy.
+ *
+ * The thread pool lives until the end of the process.  If @a owning_pool
+ * is not @c NULL, the thread pool will be destroyed early when
+ * @a owning_pool gets cleaned up; the next call will then create a new
+ * one.  Use @a scratch_pool for temporary allocations.
+ */
+svn_error_t *
+svn_thread_pool__get_shared(apr_thread_pool_t **thread_pool,
+                            svn_thread_pool__shared_t *shared,
+                            apr_pool_t *owning_pool,
+                            apr_pool_t *scratch_pool);
+
+#endif /* APR_HAS_THREADS */
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* SVN_THREAD_POOL_H */
@@ -348,6 +348,19 @@ svn_wc__get_wcroot(const char **wcroot_abspath,
                    apr_pool_t *result_pool,
                    apr_pool_t *scratch_pool);
 
+/** Watch the working copy rooted at @a wcroot_abspath for file system
+ * changes until @a cancel_func returns an error, and tell status walks
+ * in that working copy which directories they don't need to read from
+ * disk.  Only one monitor may run per working copy.
+ *
+ * Return #SVN_ERR_UNSUPPORTED_FEATURE on platforms without inotify.
+ */
+svn_error_t *
+svn_wc__fsmonitor_run(const char *wcroot_abspath,
+                      svn_cancel_func_t cancel_func,
+                      void *cancel_baton,
+                      apr_pool_t *scratch_pool);
+
 /** Set @a *dir to the abspath of the directory in which administrative
  * data for experimental features may be stored. This directory is inside
  * the WC's administrative directory. Ensure the directory exists.
@@ -1042,7 +1055,9 @@ svn_wc__node_get_md5_from_sha1(const svn_checksum_t **md5_checksum,
 /* Like svn_wc_get_pristine_contents2(), but keyed on the CHECKSUM
    rather than on the local absolute path of the working file.
    WRI_ABSPATH is any versioned path of the working copy in whose
-   pristine database we'll be looking for these contents.  */
+   pristine database we'll be looking for these contents.  If that
+   doesn't have them, look in the shared pristine store configured for
+   WC_CTX, if any.  */
 svn_error_t *
 svn_wc__get_pristine_contents_by_checksum(svn_stream_t **contents,
                                           svn_wc_context_t *wc_ctx,
@@ -1051,6 +1066,27 @@ svn_wc__get_pristine_contents_by_checksum(svn_stream_t **contents,
                                           apr_pool_t *result_pool,
                                           apr_pool_t *scratch_pool);
 
+/* A callback type to write the text of the file REPOS_RELPATH in REVISION
+   of the repository at REPOS_ROOT_URL to STREAM.  It must not close STREAM.
+
+   Working copies in lazy-pristines mode don't keep all pristine texts on
+   disk, and this is how they restore those that can't be found
+   elsewhere.  */
+typedef svn_error_t *(*svn_wc__fetch_pristine_func_t)(
+  void *baton,
+  svn_stream_t *stream,
+  const char *repos_root_url,
+  const char *repos_relpath,
+  svn_revnum_t revision,
+  apr_pool_t *scratch_pool);
+
+/* Let all operations using WC_CTX call FETCH_FUNC with FETCH_BATON to
+   fetch pristine texts from the repository.  FETCH_FUNC may be NULL.  */
+void
+svn_wc__context_set_fetch_pristine_func(svn_wc_context_t *wc_ctx,
+                                        svn_wc__fetch_pristine_func_t fetch_func,
+                                        void *fetch_baton);
+
 /* Gets an array of const char *repos_relpaths of descendants of LOCAL_ABSPATH,
  * which must be the op root of an addition, copy or move. The descendants
  * returned are at the same op_depth, but are to be deleted by the commit
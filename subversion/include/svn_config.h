@@ -117,6 +117,10 @@ typedef struct svn_config_t svn_config_t;
 #define SVN_CONFIG_OPTION_SERF_LOG_COMPONENTS       "serf-log-components"
 /** @since New in 1.9. */
 #define SVN_CONFIG_OPTION_SERF_LOG_LEVEL            "serf-log-level"
+/** @since New in 1.13. */
+#define SVN_CONFIG_OPTION_SVN_MAX_CONNECTIONS       "svn-max-connections"
+/** @since New in 1.13. */
+#define SVN_CONFIG_OPTION_SVN_TLS                   "svn-tls"
 
 
 #define SVN_CONFIG_CATEGORY_CONFIG          "config"
@@ -171,6 +175,18 @@ typedef struct svn_config_t svn_config_t;
 #define SVN_CONFIG_OPTION_SQLITE_EXCLUSIVE_CLIENTS  "exclusive-locking-clients"
 /** @since New in 1.9. */
 #define SVN_CONFIG_OPTION_SQLITE_BUSY_TIMEOUT       "busy-timeout"
+/** @since New in 1.13. */
+#define SVN_CONFIG_OPTION_SQLITE_JOURNAL_MODE       "journal-mode"
+/** @since New in 1.13. */
+#define SVN_CONFIG_OPTION_SQLITE_WAL_AUTOCHECKPOINT "wal-autocheckpoint"
+/** @since New in 1.13. */
+#define SVN_CONFIG_OPTION_SQLITE_CACHE_SIZE         "cache-size"
+/** @since New in 1.13. */
+#define SVN_CONFIG_OPTION_SQLITE_MMAP_SIZE          "mmap-size"
+/** @since New in 1.13. */
+#define SVN_CONFIG_OPTION_SHARED_PRISTINE_STORE     "shared-pristine-store"
+/** @since New in 1.13. */
+#define SVN_CONFIG_OPTION_LAZY_PRISTINES            "lazy-pristines"
 /** @} */
 
 /** @name Repository conf directory configuration files strings
@@ -191,6 +207,8 @@ typedef struct svn_config_t svn_config_t;
 #define SVN_CONFIG_OPTION_FORCE_USERNAME_CASE       "force-username-case"
 /** @since New in 1.8. */
 #define SVN_CONFIG_OPTION_HOOKS_ENV                 "hooks-env"
+/** @since New in 1.13. */
+#define SVN_CONFIG_OPTION_REPORT_PREFETCH           "report-prefetch"
 /** @since New in 1.5. */
 #define SVN_CONFIG_SECTION_SASL                 "sasl"
 /** @since New in 1.5. */
@@ -235,6 +253,8 @@ typedef struct svn_config_t svn_config_t;
 #define SVN_CONFIG_DEFAULT_OPTION_STORE_SSL_CLIENT_CERT_PP_PLAINTEXT \
                                                              SVN_CONFIG_ASK
 #define SVN_CONFIG_DEFAULT_OPTION_HTTP_MAX_CONNECTIONS       4
+/** @since New in 1.13. */
+#define SVN_CONFIG_DEFAULT_OPTION_SVN_MAX_CONNECTIONS        1
 
 /** Read configuration information from the standard sources and merge it
  * into the hash @a *cfg_hash.  If @a config_dir is not NULL it specifies a
@@ -1597,6 +1597,16 @@ SVN_ERROR_START
              SVN_ERR_RA_SVN_CATEGORY_START + 10,
              "Server response too long")
 
+  /** @since New in 1.13  */
+  SVN_ERRDEF(SVN_ERR_RA_SVN_TLS_ERROR,
+             SVN_ERR_RA_SVN_CATEGORY_START + 11,
+             "TLS connection error")
+
+  /** @since New in 1.13  */
+  SVN_ERRDEF(SVN_ERR_RA_SVN_TLS_CERT_UNTRUSTED,
+             SVN_ERR_RA_SVN_CATEGORY_START + 12,
+             "Server certificate verification failed")
+
   /* libsvn_auth errors */
 
        /* this error can be used when an auth provider doesn't have
@@ -227,6 +227,29 @@ typedef struct svn_fs_t svn_fs_t;
  */
 #define SVN_FS_CONFIG_NO_FLUSH_TO_DISK          "no-flush-to-disk"
 
+/** String with a decimal number of revisions N.  A positive value puts
+ * a FSFS repository into bulk-load mode, meant for filling a fresh
+ * repository, e.g. by svn_repos_load_fs6().
+ *
+ * In this mode, individual commits do not force their data to disk and
+ * new rep-cache entries are collected in memory.  Every N revisions, a
+ * checkpoint makes all revisions committed so far durable and then writes
+ * the collected rep-cache entries in a single database transaction.  The
+ * rep-cache will therefore never refer to data that may get lost in a
+ * crash.
+ *
+ * After a system crash, revisions newer than the latest checkpoint may be
+ * missing or incomplete.  Run svn_repos_recover4() on the repository and
+ * resume the load from the next revision.
+ *
+ * @note The final checkpoint has to be triggered explicitly using the
+ * #SVN_FS_FS__IOCTL_BULK_LOAD_CHECKPOINT ioctl.  Otherwise, the rep-cache
+ * entries of the latest revisions will not be written.
+ *
+ * @since New in 1.13.
+ */
+#define SVN_FS_CONFIG_FSFS_BULK_LOAD_CHECKPOINT "fsfs-bulk-load-checkpoint"
+
 /** @} */
 
 
@@ -71,6 +71,12 @@ extern "C" {
 #define SVN_RA_SVN_CAP_GET_FILE_REVS_REVERSE "file-revs-reverse"
 /* maps to SVN_RA_CAPABILITY_LIST */
 #define SVN_RA_SVN_CAP_LIST "list"
+/* server accepts commands before the previous responses have been read */
+#define SVN_RA_SVN_CAP_PIPELINING "pipelining"
+/* server can carry several sessions over one connection */
+#define SVN_RA_SVN_CAP_MULTIPLEX "multiplex"
+/* server can switch the connection to TLS */
+#define SVN_RA_SVN_CAP_STARTTLS "starttls"
 
 
 /** ra_svn passes @c svn_dirent_t fields over the wire as a list of
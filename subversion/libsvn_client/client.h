@@ -63,6 +63,10 @@ typedef struct svn_client__private_ctx_t
   /* Total number of bytes transferred over network across all RA sessions. */
   apr_off_t total_progress;
 
+  /* RA sessions opened by svn_client__fetch_pristine(), keyed by
+     repository root URL, each parented at that root. */
+  apr_hash_t *pristine_sessions;
+
   /* The public context. */
   svn_client_ctx_t public_ctx;
 } svn_client__private_ctx_t;
@@ -316,6 +320,18 @@ svn_client__open_ra_session_internal(svn_ra_session_t **ra_session,
                                      apr_pool_t *result_pool,
                                      apr_pool_t *scratch_pool);
 
+/* Implements svn_wc__fetch_pristine_func_t, using the svn_client_ctx_t *
+   BATON.  Keeps one RA session per repository root open for the lifetime
+   of the context, so restoring many texts doesn't open a session for each
+   of them.  Registered by svn_client_create_context2(). */
+svn_error_t *
+svn_client__fetch_pristine(void *baton,
+                           svn_stream_t *stream,
+                           const char *repos_root_url,
+                           const char *repos_relpath,
+                           svn_revnum_t revision,
+                           apr_pool_t *scratch_pool);
+
 
 svn_error_t *
 svn_client__ra_provide_base(svn_stream_t **contents,
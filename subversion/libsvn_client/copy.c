@@ -1452,7 +1452,8 @@ repos_to_repos_copy(const apr_array_header_t *copy_pairs,
   apr_array_header_t *new_dirs = NULL;
   apr_hash_t *commit_revprops;
   apr_array_header_t *pin_externals_only_infos = NULL;
-  int i;
+  apr_array_header_t *check_paths, *check_revs, *check_kinds;
+  int i, k;
   svn_client__copy_pair_t *first_pair =
     APR_ARRAY_IDX(copy_pairs, 0, svn_client__copy_pair_t *);
 
@@ -1663,8 +1664,36 @@ repos_to_repos_copy(const apr_array_header_t *copy_pairs,
      what we've learned into the INFO array.  (For copies -- that is,
      non-moves -- the relative source URL NULL because it isn't a
      child of the TOP_URL at all.  That's okay, we'll deal with
-     it.)  */
+     it.)
+
+     Query the kinds of all paths within the session scope at once, so
+     the RA layer may pipeline these requests. */
+  check_paths = apr_array_make(pool, 2 * copy_pairs->nelts,
+                               sizeof(const char *));
+  check_revs = apr_array_make(pool, 2 * copy_pairs->nelts,
+                              sizeof(svn_revnum_t));
   for (i = 0; i < copy_pairs->nelts; i++)
+    {
+      svn_client__copy_pair_t *pair =
+        APR_ARRAY_IDX(copy_pairs, i, svn_client__copy_pair_t *);
+      const char *src_rel;
+
+      src_rel = svn_uri_skip_ancestor(top_url, pair->src_abspath_or_url, pool);
+      if (src_rel)
+        {
+          APR_ARRAY_PUSH(check_paths, const char *) = src_rel;
+          APR_ARRAY_PUSH(check_revs, svn_revnum_t) = pair->src_revnum;
+        }
+
+      APR_ARRAY_PUSH(check_paths, const char *)
+        = svn_uri_skip_ancestor(top_url, pair->dst_abspath_or_url, pool);
+      APR_ARRAY_PUSH(check_revs, svn_revnum_t) = SVN_INVALID_REVNUM;
+    }
+
+  SVN_ERR(svn_ra__check_paths(ra_session, &check_kinds, check_paths,
+                              check_revs, pool, pool));
+
+  for (i = 0, k = 0; i < copy_pairs->nelts; i++)
     {
       svn_client__copy_pair_t *pair =
         APR_ARRAY_IDX(copy_pairs, i, svn_client__copy_pair_t *);
@@ -1676,8 +1705,7 @@ repos_to_repos_copy(const apr_array_header_t *copy_pairs,
       src_rel = svn_uri_skip_ancestor(top_url, pair->src_abspath_or_url, pool);
       if (src_rel)
         {
-          SVN_ERR(svn_ra_check_path(ra_session, src_rel, pair->src_revnum,
-                                    &info->src_kind, pool));
+          info->src_kind = APR_ARRAY_IDX(check_kinds, k++, svn_node_kind_t);
         }
       else
         {
@@ -1701,8 +1729,7 @@ repos_to_repos_copy(const apr_array_header_t *copy_pairs,
       /* Figure out the basename that will result from this operation,
          and ensure that we aren't trying to overwrite existing paths.  */
       dst_rel = svn_uri_skip_ancestor(top_url, pair->dst_abspath_or_url, pool);
-      SVN_ERR(svn_ra_check_path(ra_session, dst_rel, SVN_INVALID_REVNUM,
-                                &dst_kind, pool));
+      dst_kind = APR_ARRAY_IDX(check_kinds, k++, svn_node_kind_t);
       if (dst_kind != svn_node_none)
         return svn_error_createf(SVN_ERR_FS_ALREADY_EXISTS, NULL,
                                  _("Path '%s' already exists"),
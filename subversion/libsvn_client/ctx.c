@@ -106,6 +106,7 @@ svn_client_create_context2(svn_client_ctx_t **ctx,
 
   private_ctx->magic_null = 0;
   private_ctx->magic_id = CLIENT_CTX_MAGIC;
+  private_ctx->pristine_sessions = apr_hash_make(pool);
 
   public_ctx->notify_func2 = call_notify_func;
   public_ctx->notify_baton2 = public_ctx;
@@ -122,6 +123,9 @@ svn_client_create_context2(svn_client_ctx_t **ctx,
 
   SVN_ERR(svn_wc_context_create(&public_ctx->wc_ctx, cfg_config,
                                 pool, pool));
+  svn_wc__context_set_fetch_pristine_func(public_ctx->wc_ctx,
+                                          svn_client__fetch_pristine,
+                                          public_ctx);
   *ctx = public_ctx;
 
   return SVN_NO_ERROR;
@@ -36,6 +36,7 @@
 
 #include "svn_private_config.h"
 #include "private/svn_fspath.h"
+#include "private/svn_ra_private.h"
 #include "private/svn_sorts_private.h"
 #include "private/svn_wc_private.h"
 
@@ -180,11 +181,15 @@ build_info_from_dirent(svn_client_info2_t **info,
    svn_depth_files, then invoke RECEIVER on file children of DIR but
    not on subdirectories; if svn_depth_infinity, recurse fully.
    DIR is a relpath, relative to the root of RA_SESSION.
+
+   If TMPDIRENTS is not NULL, it contains the entries of DIR as returned
+   by svn_ra_get_dir2() with DIRENT_FIELDS.
 */
 static svn_error_t *
 push_dir_info(svn_ra_session_t *ra_session,
               const svn_client__pathrev_t *pathrev,
               const char *dir,
+              apr_hash_t *tmpdirents,
               svn_client_info_receiver2_t receiver,
               void *receiver_baton,
               svn_depth_t depth,
@@ -192,12 +197,45 @@ push_dir_info(svn_ra_session_t *ra_session,
               apr_hash_t *locks,
               apr_pool_t *pool)
 {
-  apr_hash_t *tmpdirents;
+  apr_hash_t *subdir_dirents = NULL;
   apr_hash_index_t *hi;
   apr_pool_t *subpool = svn_pool_create(pool);
 
-  SVN_ERR(svn_ra_get_dir2(ra_session, &tmpdirents, NULL, NULL,
-                          dir, pathrev->rev, DIRENT_FIELDS, pool));
+  if (tmpdirents == NULL)
+    SVN_ERR(svn_ra_get_dir2(ra_session, &tmpdirents, NULL, NULL,
+                            dir, pathrev->rev, DIRENT_FIELDS, pool));
+
+  /* List all subdirectories that we are going to recurse into with a
+     single call, so the RA layer may pipeline the requests. */
+  if (depth == svn_depth_infinity)
+    {
+      apr_array_header_t *subdirs = apr_array_make(pool, 0,
+                                                   sizeof(const char *));
+      apr_array_header_t *revs = apr_array_make(pool, 0,
+                                                sizeof(svn_revnum_t));
+      apr_array_header_t *listings;
+      int i;
+
+      for (hi = apr_hash_first(pool, tmpdirents); hi; hi = apr_hash_next(hi))
+        {
+          svn_dirent_t *the_ent = apr_hash_this_val(hi);
+
+          if (the_ent->kind != svn_node_dir)
+            continue;
+
+          APR_ARRAY_PUSH(subdirs, const char *)
+            = svn_relpath_join(dir, apr_hash_this_key(hi), pool);
+          APR_ARRAY_PUSH(revs, svn_revnum_t) = pathrev->rev;
+        }
+
+      SVN_ERR(svn_ra__get_dirs(ra_session, &listings, subdirs, revs,
+                               DIRENT_FIELDS, pool, pool));
+
+      subdir_dirents = apr_hash_make(pool);
+      for (i = 0; i < subdirs->nelts; i++)
+        svn_hash_sets(subdir_dirents, APR_ARRAY_IDX(subdirs, i, const char *),
+                      APR_ARRAY_IDX(listings, i, apr_hash_t *));
+    }
 
   for (hi = apr_hash_first(pool, tmpdirents); hi; hi = apr_hash_next(hi))
     {
@@ -231,6 +269,7 @@ push_dir_info(svn_ra_session_t *ra_session,
       if (depth == svn_depth_infinity && the_ent->kind == svn_node_dir)
         {
           SVN_ERR(push_dir_info(ra_session, child_pathrev, path,
+                                svn_hash_gets(subdir_dirents, path),
                                 receiver, receiver_baton,
                                 depth, ctx, locks, subpool));
         }
@@ -453,7 +492,7 @@ svn_client_info4(const char *abspath_or_url,
       else
         locks = apr_hash_make(pool); /* use an empty hash */
 
-      SVN_ERR(push_dir_info(ra_session, pathrev, "",
+      SVN_ERR(push_dir_info(ra_session, pathrev, "", NULL,
                             receiver, receiver_baton,
                             depth, ctx, locks, pool));
     }
@@ -478,6 +478,46 @@ svn_client_open_ra_session2(svn_ra_session_t **session,
                                                   scratch_pool));
 }
 
+svn_error_t *
+svn_client__fetch_pristine(void *baton,
+                           svn_stream_t *stream,
+                           const char *repos_root_url,
+                           const char *repos_relpath,
+                           svn_revnum_t revision,
+                           apr_pool_t *scratch_pool)
+{
+  svn_client_ctx_t *ctx = baton;
+  apr_hash_t *sessions = svn_client__get_private_ctx(ctx)->pristine_sessions;
+  svn_ra_session_t *ra_session = svn_hash_gets(sessions, repos_root_url);
+  svn_error_t *err;
+
+  if (!ra_session)
+    {
+      apr_pool_t *session_pool = apr_hash_pool_get(sessions);
+
+      /* Don't let the RA layer look for the text in the working copy that
+         asked for it. */
+      SVN_ERR(svn_client__open_ra_session_internal(&ra_session, NULL,
+                                                   repos_root_url,
+                                                   NULL, NULL, FALSE, FALSE,
+                                                   ctx, session_pool,
+                                                   scratch_pool));
+      svn_hash_sets(sessions, apr_pstrdup(session_pool, repos_root_url),
+                    ra_session);
+    }
+
+  err = svn_ra_get_file(ra_session, repos_relpath, revision,
+                        svn_stream_disown(stream, scratch_pool),
+                        NULL, NULL, scratch_pool);
+
+  /* A failed transfer may leave the session in the middle of a response;
+     open a new one next time. */
+  if (err)
+    svn_hash_sets(sessions, repos_root_url, NULL);
+
+  return svn_error_trace(err);
+}
+
 svn_error_t *
 svn_client__resolve_rev_and_url(svn_client__pathrev_t **resolved_loc_p,
                                 svn_ra_session_t *ra_session,
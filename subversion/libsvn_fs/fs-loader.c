@@ -504,6 +504,7 @@ fs_new(apr_hash_t *fs_config, apr_pool_t *pool)
   fs->vtable = NULL;
   fs->fsap_data = NULL;
   fs->uuid = NULL;
+  fs->instance_id = NULL;
   return fs;
 }
 
@@ -1728,6 +1729,12 @@ svn_fs_get_file_delta_stream(svn_txdelta_stream_t **stream_p,
                            target_root, target_path, pool));
 }
 
+const char *
+svn_fs__instance_id(svn_fs_t *fs)
+{
+  return fs->instance_id;
+}
+
 svn_error_t *
 svn_fs__get_deleted_node(svn_fs_root_t **node_root,
                          const char **node_path,
@@ -503,6 +503,11 @@ struct svn_fs_t
 
   /* UUID, stored by open(), create(), and set_uuid(). */
   const char *uuid;
+
+  /* Instance ID telling this filesystem apart from others with the same
+     UUID, e.g. after a dump / load cycle.  Stored along with UUID by
+     backends that support it, NULL otherwise. */
+  const char *instance_id;
 };
 
 
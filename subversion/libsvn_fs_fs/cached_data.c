@@ -2210,6 +2210,49 @@ rep_read_contents(void *baton,
   return SVN_NO_ERROR;
 }
 
+svn_error_t *
+svn_fs_fs__get_plain_contents(apr_file_t **file,
+                              apr_off_t *offset,
+                              svn_filesize_t *length,
+                              svn_fs_t *fs,
+                              node_revision_t *noderev,
+                              apr_pool_t *result_pool,
+                              apr_pool_t *scratch_pool)
+{
+  representation_t *rep = noderev->data_rep;
+  svn_fs_fs__revision_file_t *rev_file;
+  svn_fs_fs__rep_header_t *header;
+  apr_off_t rep_offset;
+
+  *file = NULL;
+
+  /* Only committed reps can be accessed without further ado.  Their
+     on-disk size must match the fulltext size. */
+  if (   !rep
+      || svn_fs_fs__id_txn_used(&rep->txn_id)
+      || (rep->expanded_size && rep->expanded_size != rep->size))
+    return SVN_NO_ERROR;
+
+  SVN_ERR(svn_fs_fs__ensure_revision_exists(rep->revision, fs,
+                                            scratch_pool));
+  SVN_ERR(svn_fs_fs__open_pack_or_rev_file(&rev_file, fs, rep->revision,
+                                           result_pool, scratch_pool));
+  SVN_ERR(svn_fs_fs__item_offset(&rep_offset, fs, rev_file, rep->revision,
+                                 NULL, rep->item_index, scratch_pool));
+  SVN_ERR(aligned_seek(fs, rev_file->file, NULL, rep_offset, scratch_pool));
+  SVN_ERR(svn_fs_fs__read_rep_header(&header, rev_file->stream,
+                                     scratch_pool, scratch_pool));
+
+  if (header->type != svn_fs_fs__rep_plain)
+    return svn_error_trace(svn_fs_fs__close_revision_file(rev_file));
+
+  *file = rev_file->file;
+  *offset = rep_offset + header->header_size;
+  *length = rep->size;
+
+  return SVN_NO_ERROR;
+}
+
 svn_error_t *
 svn_fs_fs__get_contents(svn_stream_t **contents_p,
                         svn_fs_t *fs,
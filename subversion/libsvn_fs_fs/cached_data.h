@@ -81,6 +81,24 @@ svn_fs_fs__rep_chain_length(int *chain_length,
                             svn_fs_t *fs,
                             apr_pool_t *scratch_pool);
 
+/* If the text representation of NODEREV in FS is stored in a revision
+   or pack file as a plain, uncompressed fulltext, set *FILE to that file,
+   opened in RESULT_POOL, and set *OFFSET and *LENGTH to the location of
+   the fulltext within that file.  Otherwise, set *FILE to NULL.
+   Use SCRATCH_POOL for temporary allocations.
+
+   This allows callers to e.g. send the contents directly from the file
+   to the network.  Note that the contents will not be verified against
+   the representation's checksum in that case. */
+svn_error_t *
+svn_fs_fs__get_plain_contents(apr_file_t **file,
+                              apr_off_t *offset,
+                              svn_filesize_t *length,
+                              svn_fs_t *fs,
+                              node_revision_t *noderev,
+                              apr_pool_t *result_pool,
+                              apr_pool_t *scratch_pool);
+
 /* Set *CONTENTS_P to be a readable svn_stream_t that receives the text
    representation REP as seen in filesystem FS.  If CACHE_FULLTEXT is
    not set, bypass fulltext cache lookup for this rep and don't put the
@@ -34,6 +34,7 @@
 #include "svn_pools.h"
 #include "fs.h"
 #include "fs_fs.h"
+#include "cached_data.h"
 #include "tree.h"
 #include "lock.h"
 #include "hotcopy.h"
@@ -308,6 +309,34 @@ fs_ioctl(svn_fs_t *fs, svn_fs_ioctl_code_t ctlcode,
                                            scratch_pool));
           *output_p = output;
         }
+      else if (ctlcode.code == SVN_FS_FS__IOCTL_BULK_LOAD_CHECKPOINT.code)
+        {
+          SVN_ERR(svn_fs_fs__bulk_load_checkpoint(fs, scratch_pool));
+          *output_p = NULL;
+        }
+      else if (ctlcode.code == SVN_FS_FS__IOCTL_PLAIN_CONTENTS.code)
+        {
+          svn_fs_fs__ioctl_plain_contents_input_t *input = input_void;
+          svn_fs_fs__ioctl_plain_contents_output_t *output
+            = apr_pcalloc(result_pool, sizeof(*output));
+          const svn_fs_id_t *id;
+          node_revision_t *noderev;
+
+          SVN_ERR(svn_fs_fs__node_id(&id, input->root, input->path,
+                                     scratch_pool));
+          SVN_ERR(svn_fs_fs__get_node_revision(&noderev, fs, id,
+                                               scratch_pool, scratch_pool));
+          if (noderev->kind != svn_node_file)
+            return svn_error_createf(SVN_ERR_FS_NOT_FILE, NULL,
+                                     _("'%s' is not a file"), input->path);
+
+          SVN_ERR(svn_fs_fs__get_plain_contents(&output->file,
+                                                &output->offset,
+                                                &output->length,
+                                                fs, noderev,
+                                                result_pool, scratch_pool));
+          *output_p = output;
+        }
       else
         return svn_error_create(SVN_ERR_FS_UNRECOGNIZED_IOCTL_CODE, NULL, NULL);
     }
@@ -356,6 +385,7 @@ initialize_fs_struct(svn_fs_t *fs)
   ffd->use_log_addressing = FALSE;
   ffd->revprop_prefix = 0;
   ffd->flush_to_disk = TRUE;
+  ffd->bulk_load_synced_rev = SVN_INVALID_REVNUM;
 
   fs->vtable = &fs_vtable;
   fs->fsap_data = ffd;
@@ -514,6 +514,24 @@ typedef struct fs_fs_data_t
   /* Ensure that all filesystem changes are written to disk. */
   svn_boolean_t flush_to_disk;
 
+  /* Number of revisions between two bulk-load checkpoints.
+     0 if bulk-load mode is disabled. */
+  svn_revnum_t bulk_load_checkpoint;
+
+  /* Youngest revision covered by the latest bulk-load checkpoint. */
+  svn_revnum_t bulk_load_synced_rev;
+
+  /* Rep-cache entries (representation_t *) of revisions committed after
+     the latest bulk-load checkpoint.  Allocated in BULK_LOAD_POOL.
+     Both are NULL if there are no such entries. */
+  apr_array_header_t *bulk_load_reps;
+
+  /* The same entries as in BULK_LOAD_REPS, indexed by their SHA1 digest. */
+  apr_hash_t *bulk_load_reps_hash;
+
+  /* Pool for the pending bulk-load data; cleared at every checkpoint. */
+  apr_pool_t *bulk_load_pool;
+
   /* Pointer to svn_fs_open. */
   svn_error_t *(*svn_fs_open_)(svn_fs_t **, const char *, apr_hash_t *,
                                apr_pool_t *, apr_pool_t *);
@@ -1071,6 +1071,8 @@ write_config(svn_fs_t *fs,
 "### Versions prior to Subversion 1.10 will ignore this option."             NL
 "### The default value is 'lz4' if supported by the repository format and"   NL
 "### 'zlib' otherwise.  'zlib' is currently equivalent to 'zlib-5'."         NL
+"### With 'none', new file contents that don't get deltified are stored"     NL
+"### verbatim, which lets svnserve send them without copying them around."   NL
 "# " CONFIG_OPTION_COMPRESSION " = lz4"                                      NL
 "###"                                                                        NL
 "### DEPRECATED: The new '" CONFIG_OPTION_COMPRESSION "' option deprecates previously used" NL
@@ -1166,6 +1168,7 @@ static svn_error_t *
 read_global_config(svn_fs_t *fs)
 {
   fs_fs_data_t *ffd = fs->fsap_data;
+  const char *checkpoint_str;
 
   ffd->use_block_read = svn_hash__get_bool(fs->config,
                                            SVN_FS_CONFIG_FSFS_BLOCK_READ,
@@ -1174,6 +1177,26 @@ read_global_config(svn_fs_t *fs)
                                            SVN_FS_CONFIG_NO_FLUSH_TO_DISK,
                                            FALSE);
 
+  checkpoint_str = svn_hash_gets(fs->config,
+                                 SVN_FS_CONFIG_FSFS_BULK_LOAD_CHECKPOINT);
+  if (checkpoint_str)
+    {
+      apr_int64_t val;
+      SVN_ERR(svn_cstring_strtoi64(&val, checkpoint_str, 0,
+                                   APR_INT32_MAX, 10));
+
+      ffd->bulk_load_checkpoint = (svn_revnum_t) val;
+    }
+
+#ifdef SVN_ON_POSIX
+  /* In bulk-load mode, durability is deferred to the next checkpoint.
+     Syncing files after the fact only works reliably on POSIX, though.
+     Elsewhere, we keep flushing every commit and only batch the rep-cache
+     updates. */
+  if (ffd->bulk_load_checkpoint)
+    ffd->flush_to_disk = FALSE;
+#endif
+
   /* Ignore the user-specified larger block size if we don't use block-read.
      Defaulting to 4k gives us the same access granularity in format 7 as in
      older formats. */
@@ -1209,10 +1232,12 @@ read_uuid(svn_fs_t *fs,
       SVN_ERR(svn_io_read_length_line(uuid_file, buf, &limit,
                                       scratch_pool));
       ffd->instance_id = apr_pstrdup(fs->pool, buf);
+      fs->instance_id = ffd->instance_id;
     }
   else
     {
       ffd->instance_id = fs->uuid;
+      fs->instance_id = NULL;
     }
 
   SVN_ERR(svn_io_file_close(uuid_file, scratch_pool));
@@ -2013,9 +2038,15 @@ svn_fs_fs__set_uuid(svn_fs_t *fs,
   fs->uuid = apr_pstrdup(fs->pool, uuid);
 
   if (ffd->format >= SVN_FS_FS__MIN_INSTANCE_ID_FORMAT)
-    ffd->instance_id = apr_pstrdup(fs->pool, instance_id);
+    {
+      ffd->instance_id = apr_pstrdup(fs->pool, instance_id);
+      fs->instance_id = ffd->instance_id;
+    }
   else
-    ffd->instance_id = fs->uuid;
+    {
+      ffd->instance_id = fs->uuid;
+      fs->instance_id = NULL;
+    }
 
   return SVN_NO_ERROR;
 }
@@ -281,6 +281,19 @@ svn_fs_fs__get_rep_reference(representation_t **rep_p,
                             _("Only SHA1 checksums can be used as keys in the "
                               "rep_cache table.\n"));
 
+  /* In bulk-load mode, the latest entries have not been written to the
+     database yet.  They refer to committed revisions, though. */
+  if (ffd->bulk_load_reps_hash)
+    {
+      rep = apr_hash_get(ffd->bulk_load_reps_hash, checksum->digest,
+                         APR_SHA1_DIGESTSIZE);
+      if (rep)
+        {
+          *rep_p = svn_fs_fs__rep_copy(rep, pool);
+          return SVN_NO_ERROR;
+        }
+    }
+
   SVN_ERR(svn_sqlite__get_statement(&stmt, ffd->rep_cache_db, STMT_GET_REP));
   SVN_ERR(svn_sqlite__bindf(stmt, "s",
                             svn_checksum_to_cstring(checksum, pool)));
@@ -2198,6 +2198,7 @@ rep_write_get_baton(struct rep_write_baton **wb_p,
                     node_revision_t *noderev,
                     apr_pool_t *pool)
 {
+  fs_fs_data_t *ffd = fs->fsap_data;
   struct rep_write_baton *b;
   apr_file_t *file;
   representation_t *base_rep;
@@ -2243,6 +2244,12 @@ rep_write_get_baton(struct rep_write_baton **wb_p,
       header.base_length = base_rep->size;
       header.type = svn_fs_fs__rep_delta;
     }
+  else if (ffd->delta_compression_type == compression_type_none)
+    {
+      /* An uncompressed self-delta would only add overhead.  Verbatim
+         fulltexts can also be sent to clients without copying. */
+      header.type = svn_fs_fs__rep_plain;
+    }
   else
     {
       header.type = svn_fs_fs__rep_self_delta;
@@ -2258,11 +2265,15 @@ rep_write_get_baton(struct rep_write_baton **wb_p,
   apr_pool_cleanup_register(b->scratch_pool, b, rep_write_cleanup,
                             apr_pool_cleanup_null);
 
-  /* Prepare to write the svndiff data. */
-  txdelta_to_svndiff(&wh, &whb, b->rep_stream, fs, pool);
+  /* Prepare to write the svndiff data.  PLAIN data goes straight to
+     REP_STREAM. */
+  if (header.type != svn_fs_fs__rep_plain)
+    {
+      txdelta_to_svndiff(&wh, &whb, b->rep_stream, fs, pool);
 
-  b->delta_stream = svn_txdelta_target_push(wh, whb, source,
-                                            b->scratch_pool);
+      b->delta_stream = svn_txdelta_target_push(wh, whb, source,
+                                                b->scratch_pool);
+    }
 
   *wb_p = b;
 
@@ -3954,6 +3965,70 @@ write_reps_to_cache(svn_fs_t *fs,
   return SVN_NO_ERROR;
 }
 
+/* Like write_reps_to_cache() but wrap the whole update in a single
+ * sqlite transaction.  The rep-cache of FS must already be open. */
+static svn_error_t *
+write_reps_to_cache_txn(svn_fs_t *fs,
+                        const apr_array_header_t *reps_to_cache,
+                        apr_pool_t *scratch_pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  svn_error_t *err;
+
+  /* We use an sqlite transaction to speed things up;
+   * see <http://www.sqlite.org/faq.html#q19>.
+   */
+  SVN_ERR(svn_sqlite__begin_transaction(ffd->rep_cache_db));
+  err = write_reps_to_cache(fs, reps_to_cache, scratch_pool);
+  err = svn_sqlite__finish_transaction(ffd->rep_cache_db, err);
+
+  if (svn_error_find_cause(err, SVN_ERR_SQLITE_ROLLBACK_FAILED))
+    {
+      /* Failed rollback means that our db connection is unusable, and
+         the only thing we can do is close it.  The connection will be
+         reopened during the next operation with rep-cache.db. */
+      return svn_error_trace(
+          svn_error_compose_create(err,
+                                   svn_fs_fs__close_rep_cache(fs)));
+    }
+
+  return svn_error_trace(err);
+}
+
+/* Bulk-load mode: Add copies of the representations in REPS_TO_CACHE
+ * (an array of representation_t *) to the list of rep-cache entries
+ * to write at the next checkpoint of FS. */
+static void
+defer_reps_to_cache(svn_fs_t *fs,
+                    const apr_array_header_t *reps_to_cache)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  int i;
+
+  if (!ffd->bulk_load_pool)
+    ffd->bulk_load_pool = svn_pool_create(fs->pool);
+
+  if (!ffd->bulk_load_reps)
+    {
+      ffd->bulk_load_reps = apr_array_make(ffd->bulk_load_pool,
+                                           reps_to_cache->nelts,
+                                           sizeof(representation_t *));
+      ffd->bulk_load_reps_hash = apr_hash_make(ffd->bulk_load_pool);
+    }
+
+  for (i = 0; i < reps_to_cache->nelts; i++)
+    {
+      representation_t *rep
+        = svn_fs_fs__rep_copy(APR_ARRAY_IDX(reps_to_cache, i,
+                                            representation_t *),
+                              ffd->bulk_load_pool);
+
+      APR_ARRAY_PUSH(ffd->bulk_load_reps, representation_t *) = rep;
+      apr_hash_set(ffd->bulk_load_reps_hash, rep->sha1_digest,
+                   sizeof(rep->sha1_digest), rep);
+    }
+}
+
 svn_error_t *
 svn_fs_fs__commit(svn_revnum_t *new_rev_p,
                   svn_fs_t *fs,
@@ -3985,37 +4060,138 @@ svn_fs_fs__commit(svn_revnum_t *new_rev_p,
   /* At this point, *NEW_REV_P has been set, so errors below won't affect
      the success of the commit.  (See svn_fs_commit_txn().)  */
 
-  if (ffd->rep_sharing_allowed)
+  if (ffd->bulk_load_checkpoint)
     {
-      svn_error_t *err;
+      /* Don't touch the rep-cache yet but remember the new entries until
+         the next checkpoint. */
+      if (ffd->rep_sharing_allowed)
+        defer_reps_to_cache(fs, cb.reps_to_cache);
 
+      if (!SVN_IS_VALID_REVNUM(ffd->bulk_load_synced_rev))
+        ffd->bulk_load_synced_rev = *new_rev_p - 1;
+
+      if (*new_rev_p - ffd->bulk_load_synced_rev
+          >= ffd->bulk_load_checkpoint)
+        SVN_ERR(svn_fs_fs__bulk_load_checkpoint(fs, pool));
+    }
+  else if (ffd->rep_sharing_allowed)
+    {
       SVN_ERR(svn_fs_fs__open_rep_cache(fs, pool));
 
-      /* Write new entries to the rep-sharing database.
-       *
-       * We use an sqlite transaction to speed things up;
-       * see <http://www.sqlite.org/faq.html#q19>.
-       */
+      /* Write new entries to the rep-sharing database. */
       /* ### A commit that touches thousands of files will starve other
              (reader/writer) commits for the duration of the below call.
              Maybe write in batches? */
-      SVN_ERR(svn_sqlite__begin_transaction(ffd->rep_cache_db));
-      err = write_reps_to_cache(fs, cb.reps_to_cache, pool);
-      err = svn_sqlite__finish_transaction(ffd->rep_cache_db, err);
+      SVN_ERR(write_reps_to_cache_txn(fs, cb.reps_to_cache, pool));
+    }
+
+  return SVN_NO_ERROR;
+}
+
+#ifdef SVN_ON_POSIX
+/* Force the file or directory at PATH to disk. */
+static svn_error_t *
+sync_path(const char *path,
+          apr_pool_t *scratch_pool)
+{
+  apr_file_t *file;
+
+  SVN_ERR(svn_io_file_open(&file, path, APR_READ, APR_OS_DEFAULT,
+                           scratch_pool));
+  SVN_ERR(svn_io_file_flush_to_disk(file, scratch_pool));
+  return svn_error_trace(svn_io_file_close(file, scratch_pool));
+}
+
+/* Force the rev and revprop files of all unpacked revisions from START_REV
+ * to END_REV in FS to disk, followed by the directories containing them
+ * and the 'current' file.  Use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+sync_revisions(svn_fs_t *fs,
+               svn_revnum_t start_rev,
+               svn_revnum_t end_rev,
+               apr_pool_t *scratch_pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  svn_revnum_t rev;
+
+  for (rev = start_rev; rev <= end_rev; ++rev)
+    {
+      const char *rev_path;
+      const char *revprops_path = NULL;
+
+      svn_pool_clear(iterpool);
 
-      if (svn_error_find_cause(err, SVN_ERR_SQLITE_ROLLBACK_FAILED))
+      /* Packing flushes its output by itself. */
+      if (svn_fs_fs__is_packed_rev(fs, rev))
+        continue;
+
+      rev_path = svn_fs_fs__path_rev_absolute(fs, rev, iterpool);
+      SVN_ERR(sync_path(rev_path, iterpool));
+
+      if (!svn_fs_fs__is_packed_revprop(fs, rev))
         {
-          /* Failed rollback means that our db connection is unusable, and
-             the only thing we can do is close it.  The connection will be
-             reopened during the next operation with rep-cache.db. */
-          return svn_error_trace(
-              svn_error_compose_create(err,
-                                       svn_fs_fs__close_rep_cache(fs)));
+          revprops_path = svn_fs_fs__path_revprops(fs, rev, iterpool);
+          SVN_ERR(sync_path(revprops_path, iterpool));
         }
-      else if (err)
-        return svn_error_trace(err);
+
+      /* Sync each shard directory once, after its last file. */
+      if (rev == end_rev
+          || (ffd->max_files_per_dir
+              && (rev + 1) % ffd->max_files_per_dir == 0))
+        {
+          SVN_ERR(sync_path(svn_dirent_dirname(rev_path, iterpool),
+                            iterpool));
+          if (!svn_fs_fs__is_packed_revprop(fs, rev))
+            SVN_ERR(sync_path(svn_dirent_dirname(revprops_path, iterpool),
+                              iterpool));
+        }
+    }
+
+  svn_pool_clear(iterpool);
+  SVN_ERR(sync_path(svn_fs_fs__path_current(fs, iterpool), iterpool));
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+#endif
+
+svn_error_t *
+svn_fs_fs__bulk_load_checkpoint(svn_fs_t *fs,
+                                apr_pool_t *scratch_pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  svn_revnum_t youngest;
+
+  /* Nothing to do outside bulk-load mode. */
+  if (!ffd->bulk_load_checkpoint)
+    return SVN_NO_ERROR;
+
+  SVN_ERR(svn_fs_fs__youngest_rev(&youngest, fs, scratch_pool));
+  if (!SVN_IS_VALID_REVNUM(ffd->bulk_load_synced_rev))
+    ffd->bulk_load_synced_rev = youngest;
+
+  /* First, make all new revisions durable ... */
+#ifdef SVN_ON_POSIX
+  if (!ffd->flush_to_disk && youngest > ffd->bulk_load_synced_rev)
+    SVN_ERR(sync_revisions(fs, ffd->bulk_load_synced_rev + 1, youngest,
+                           scratch_pool));
+#endif
+
+  /* ... and only then let the rep-cache refer to them. */
+  if (ffd->bulk_load_reps)
+    {
+      SVN_ERR(svn_fs_fs__open_rep_cache(fs, scratch_pool));
+      SVN_ERR(write_reps_to_cache_txn(fs, ffd->bulk_load_reps,
+                                      scratch_pool));
+
+      ffd->bulk_load_reps = NULL;
+      ffd->bulk_load_reps_hash = NULL;
+      svn_pool_clear(ffd->bulk_load_pool);
     }
 
+  ffd->bulk_load_synced_rev = youngest;
+
   return SVN_NO_ERROR;
 }
 
@@ -220,6 +220,14 @@ svn_fs_fs__commit(svn_revnum_t *new_rev_p,
                   svn_fs_txn_t *txn,
                   apr_pool_t *pool);
 
+/* Bulk-load mode: Make all revisions committed to FS so far durable and
+   write the rep-cache entries collected since the previous checkpoint.
+   This is a no-op if FS is not in bulk-load mode.  Use SCRATCH_POOL for
+   temporary allocations. */
+svn_error_t *
+svn_fs_fs__bulk_load_checkpoint(svn_fs_t *fs,
+                                apr_pool_t *scratch_pool);
+
 /* Set *NAMES_P to an array of names which are all the active
    transactions in filesystem FS.  Allocate the array from POOL. */
 svn_error_t *
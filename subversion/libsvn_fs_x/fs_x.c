@@ -573,6 +573,7 @@ read_uuid(svn_fs_t *fs,
   SVN_ERR(svn_io_read_length_line(uuid_file, buf, &limit,
                                   scratch_pool));
   ffd->instance_id = apr_pstrdup(fs->pool, buf);
+  fs->instance_id = ffd->instance_id;
 
   SVN_ERR(svn_io_file_close(uuid_file, scratch_pool));
 
@@ -1121,6 +1122,7 @@ svn_fs_x__set_uuid(svn_fs_t *fs,
 
   fs->uuid = apr_pstrdup(fs->pool, uuid);
   ffd->instance_id = apr_pstrdup(fs->pool, instance_id);
+  fs->instance_id = ffd->instance_id;
 
   return SVN_NO_ERROR;
 }
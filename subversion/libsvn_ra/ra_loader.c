@@ -1480,6 +1480,113 @@ svn_ra_print_ra_libraries(svn_stringbuf_t **descriptions,
 }
 
 
+svn_error_t *
+svn_ra__check_paths(svn_ra_session_t *session,
+                    apr_array_header_t **kinds,
+                    const apr_array_header_t *paths,
+                    const apr_array_header_t *revisions,
+                    apr_pool_t *result_pool,
+                    apr_pool_t *scratch_pool)
+{
+  apr_pool_t *iterpool;
+  int i;
+
+  SVN_ERR_ASSERT(paths->nelts == revisions->nelts);
+  for (i = 0; i < paths->nelts; i++)
+    SVN_ERR_ASSERT(svn_relpath_is_canonical(APR_ARRAY_IDX(paths, i,
+                                                          const char *)));
+
+  if (session->vtable->check_paths)
+    return svn_error_trace(session->vtable->check_paths(session, kinds,
+                                                        paths, revisions,
+                                                        result_pool,
+                                                        scratch_pool));
+
+  /* Check one path after the other. */
+  *kinds = apr_array_make(result_pool, paths->nelts, sizeof(svn_node_kind_t));
+  iterpool = svn_pool_create(scratch_pool);
+  for (i = 0; i < paths->nelts; i++)
+    {
+      svn_node_kind_t kind;
+
+      svn_pool_clear(iterpool);
+      SVN_ERR(svn_ra_check_path(session, APR_ARRAY_IDX(paths, i, const char *),
+                                APR_ARRAY_IDX(revisions, i, svn_revnum_t),
+                                &kind, iterpool));
+      APR_ARRAY_PUSH(*kinds, svn_node_kind_t) = kind;
+    }
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_ra__get_dirs(svn_ra_session_t *session,
+                 apr_array_header_t **dirents,
+                 const apr_array_header_t *paths,
+                 const apr_array_header_t *revisions,
+                 apr_uint32_t dirent_fields,
+                 apr_pool_t *result_pool,
+                 apr_pool_t *scratch_pool)
+{
+  int i;
+
+  SVN_ERR_ASSERT(paths->nelts == revisions->nelts);
+  for (i = 0; i < paths->nelts; i++)
+    SVN_ERR_ASSERT(svn_relpath_is_canonical(APR_ARRAY_IDX(paths, i,
+                                                          const char *)));
+
+  if (session->vtable->get_dirs)
+    return svn_error_trace(session->vtable->get_dirs(session, dirents,
+                                                     paths, revisions,
+                                                     dirent_fields,
+                                                     result_pool,
+                                                     scratch_pool));
+
+  /* List one directory after the other. */
+  *dirents = apr_array_make(result_pool, paths->nelts, sizeof(apr_hash_t *));
+  for (i = 0; i < paths->nelts; i++)
+    SVN_ERR(svn_ra_get_dir2(session,
+                            &APR_ARRAY_PUSH(*dirents, apr_hash_t *),
+                            NULL, NULL,
+                            APR_ARRAY_IDX(paths, i, const char *),
+                            APR_ARRAY_IDX(revisions, i, svn_revnum_t),
+                            dirent_fields, result_pool));
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_ra__rev_proplists(svn_ra_session_t *session,
+                      apr_array_header_t **props,
+                      const apr_array_header_t *revisions,
+                      apr_pool_t *result_pool,
+                      apr_pool_t *scratch_pool)
+{
+  int i;
+
+  for (i = 0; i < revisions->nelts; i++)
+    SVN_ERR_ASSERT(SVN_IS_VALID_REVNUM(APR_ARRAY_IDX(revisions, i,
+                                                     svn_revnum_t)));
+
+  if (session->vtable->rev_proplists)
+    return svn_error_trace(session->vtable->rev_proplists(session, props,
+                                                          revisions,
+                                                          result_pool,
+                                                          scratch_pool));
+
+  /* Fetch one revision after the other. */
+  *props = apr_array_make(result_pool, revisions->nelts,
+                          sizeof(apr_hash_t *));
+  for (i = 0; i < revisions->nelts; i++)
+    SVN_ERR(svn_ra_rev_proplist(session,
+                                APR_ARRAY_IDX(revisions, i, svn_revnum_t),
+                                &APR_ARRAY_PUSH(*props, apr_hash_t *),
+                                result_pool));
+
+  return SVN_NO_ERROR;
+}
+
 svn_error_t *
 svn_ra__register_editor_shim_callbacks(svn_ra_session_t *session,
                                        svn_delta_shim_callbacks_t *callbacks)
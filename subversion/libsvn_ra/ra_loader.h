@@ -378,6 +378,30 @@ typedef struct svn_ra__vtable_t {
     void *replay_baton,
     apr_pool_t *scratch_pool);
 
+  /* See svn_ra__check_paths().  May be NULL. */
+  svn_error_t *(*check_paths)(svn_ra_session_t *session,
+                              apr_array_header_t **kinds,
+                              const apr_array_header_t *paths,
+                              const apr_array_header_t *revisions,
+                              apr_pool_t *result_pool,
+                              apr_pool_t *scratch_pool);
+
+  /* See svn_ra__get_dirs().  May be NULL. */
+  svn_error_t *(*get_dirs)(svn_ra_session_t *session,
+                           apr_array_header_t **dirents,
+                           const apr_array_header_t *paths,
+                           const apr_array_header_t *revisions,
+                           apr_uint32_t dirent_fields,
+                           apr_pool_t *result_pool,
+                           apr_pool_t *scratch_pool);
+
+  /* See svn_ra__rev_proplists().  May be NULL. */
+  svn_error_t *(*rev_proplists)(svn_ra_session_t *session,
+                                apr_array_header_t **props,
+                                const apr_array_header_t *revisions,
+                                apr_pool_t *result_pool,
+                                apr_pool_t *scratch_pool);
+
 } svn_ra__vtable_t;
 
 /* The RA session object. */
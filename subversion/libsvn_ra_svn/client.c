@@ -51,6 +51,7 @@
 #include "svn_private_config.h"
 
 #include "private/svn_fspath.h"
+#include "private/svn_sorts_private.h"
 #include "private/svn_string_private.h"
 #include "private/svn_subr_private.h"
 
@@ -249,7 +250,16 @@ static svn_error_t *handle_auth_request(svn_ra_svn__session_baton_t *sess,
   SVN_ERR(svn_ra_svn__read_cmd_response(conn, pool, "lc", &mechlist, &realm));
   if (mechlist->nelts == 0)
     return SVN_NO_ERROR;
-  return DO_AUTH(sess, mechlist, realm, pool);
+  SVN_ERR(DO_AUTH(sess, mechlist, realm, pool));
+
+  /* After a non-anonymous login, the server will not challenge us again.
+     Neither will it, if it cannot authenticate users at all. */
+  if (   !svn_ra_svn__find_mech(mechlist, "ANONYMOUS")
+      || mechlist->nelts == 1
+      || (sess->is_tunneled && svn_ra_svn__find_mech(mechlist, "EXTERNAL")))
+    sess->auth_settled = TRUE;
+
+  return SVN_NO_ERROR;
 }
 
 /* --- REPORTER IMPLEMENTATION --- */
@@ -604,12 +614,228 @@ static apr_status_t close_tunnel_cleanup(void *baton)
   return APR_SUCCESS; /* ignored */
 }
 
+/* Read the server's greeting on CONN and check that we can talk to it.
+   Use POOL for allocations. */
+static svn_error_t *
+read_greeting(svn_ra_svn_conn_t *conn,
+              apr_pool_t *pool)
+{
+  apr_uint64_t minver, maxver;
+  svn_ra_svn__list_t *mechlist, *server_caplist;
+
+  SVN_ERR(svn_ra_svn__read_cmd_response(conn, pool, "nnll", &minver, &maxver,
+                                        &mechlist, &server_caplist));
+
+  /* We support protocol version 2. */
+  if (minver > 2)
+    return svn_error_createf(SVN_ERR_RA_SVN_BAD_VERSION, NULL,
+                             _("Server requires minimum version %d"),
+                             (int) minver);
+  if (maxver < 2)
+    return svn_error_createf(SVN_ERR_RA_SVN_BAD_VERSION, NULL,
+                             _("Server only supports versions up to %d"),
+                             (int) maxver);
+  SVN_ERR(svn_ra_svn__set_capabilities(conn, server_caplist));
+
+  /* All released versions of Subversion support edit-pipeline,
+   * so we do not support servers that do not. */
+  if (! svn_ra_svn_has_capability(conn, SVN_RA_SVN_CAP_EDIT_PIPELINE))
+    return svn_error_create(SVN_ERR_RA_SVN_BAD_VERSION, NULL,
+                            _("Server does not support edit pipelining"));
+
+  return SVN_NO_ERROR;
+}
+
+#ifdef SVN_HAVE_OPENSSL
+/* Append REASON to ERRMSG, separated by commas. */
+static void
+append_reason(svn_stringbuf_t *errmsg,
+              const char *reason,
+              int *reasons)
+{
+  svn_stringbuf_appendcstr(errmsg, *reasons ? ", " : ": ");
+  svn_stringbuf_appendcstr(errmsg, reason);
+  (*reasons)++;
+}
+
+/* The TLS handshake on the connection of SESS to the server at PORT found
+   the problems given by the SVN_AUTH_SSL_* flags in FAILURES.  Ask the
+   auth providers whether the server may be trusted anyway and return an
+   error if not.  Use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+verify_server_cert(svn_ra_svn__session_baton_t *sess,
+                   apr_uint32_t failures,
+                   int port,
+                   apr_pool_t *scratch_pool)
+{
+  svn_auth_ssl_server_cert_info_t *cert_info;
+  svn_auth_cred_ssl_server_trust_t *server_creds;
+  svn_auth_iterstate_t *state;
+  const char *realmstring;
+  void *creds = NULL;
+
+  SVN_ERR(svn_ra_svn__tls_get_server_cert(&cert_info, sess->conn,
+                                          scratch_pool));
+  realmstring = apr_psprintf(scratch_pool, "svn://%s:%d", sess->hostname,
+                             port);
+
+  if (sess->auth_baton)
+    {
+      svn_auth_set_parameter(sess->auth_baton,
+                             SVN_AUTH_PARAM_SSL_SERVER_FAILURES, &failures);
+      svn_auth_set_parameter(sess->auth_baton,
+                             SVN_AUTH_PARAM_SSL_SERVER_CERT_INFO, cert_info);
+
+      SVN_ERR(svn_auth_first_credentials(&creds, &state,
+                                         SVN_AUTH_CRED_SSL_SERVER_TRUST,
+                                         realmstring, sess->auth_baton,
+                                         scratch_pool));
+      while (failures && creds)
+        {
+          server_creds = creds;
+          failures &= ~server_creds->accepted_failures;
+          SVN_ERR(svn_auth_save_credentials(state, scratch_pool));
+
+          if (failures)
+            SVN_ERR(svn_auth_next_credentials(&creds, state, scratch_pool));
+        }
+
+      svn_auth_set_parameter(sess->auth_baton,
+                             SVN_AUTH_PARAM_SSL_SERVER_CERT_INFO, NULL);
+      svn_auth_set_parameter(sess->auth_baton,
+                             SVN_AUTH_PARAM_SSL_SERVER_FAILURES, NULL);
+    }
+
+  /* Are there non accepted failures left? */
+  if (failures)
+    {
+      svn_stringbuf_t *errmsg;
+      int reasons = 0;
+
+      errmsg = svn_stringbuf_create(
+                 _("Server TLS certificate verification failed"),
+                 scratch_pool);
+
+      if (failures & SVN_AUTH_SSL_NOTYETVALID)
+        append_reason(errmsg, _("certificate is not yet valid"), &reasons);
+
+      if (failures & SVN_AUTH_SSL_EXPIRED)
+        append_reason(errmsg, _("certificate has expired"), &reasons);
+
+      if (failures & SVN_AUTH_SSL_CNMISMATCH)
+        append_reason(errmsg,
+                      _("certificate issued for a different hostname"),
+                      &reasons);
+
+      if (failures & SVN_AUTH_SSL_UNKNOWNCA)
+        append_reason(errmsg, _("issuer is not trusted"), &reasons);
+
+      if (failures & SVN_AUTH_SSL_OTHER)
+        append_reason(errmsg, _("and other reason(s)"), &reasons);
+
+      return svn_error_create(SVN_ERR_RA_SVN_TLS_CERT_UNTRUSTED, NULL,
+                              errmsg->data);
+    }
+
+  return SVN_NO_ERROR;
+}
+#endif
+
+/* Switch the connection of SESS to the server at PORT to TLS, if the
+   "servers" configuration asks for that and the server supports it.
+   The server then greets us again, through TLS.  Use POOL for
+   allocations that live as long as SESS. */
+static svn_error_t *
+start_tls(svn_ra_svn__session_baton_t *sess,
+          int port,
+          apr_pool_t *pool)
+{
+  svn_config_t *cfg = sess->config
+                    ? svn_hash_gets(sess->config, SVN_CONFIG_CATEGORY_SERVERS)
+                    : NULL;
+  const char *server_group = NULL;
+  svn_tristate_t use_tls;
+  svn_boolean_t trust_default_ca;
+  const char *authority_files;
+
+  if (cfg)
+    server_group = svn_config_find_group(cfg, sess->hostname,
+                                         SVN_CONFIG_SECTION_GROUPS, pool);
+
+  SVN_ERR(svn_config_get_tristate(cfg, &use_tls, SVN_CONFIG_SECTION_GLOBAL,
+                                  SVN_CONFIG_OPTION_SVN_TLS, "auto",
+                                  svn_tristate_false));
+  SVN_ERR(svn_config_get_bool(cfg, &trust_default_ca,
+                              SVN_CONFIG_SECTION_GLOBAL,
+                              SVN_CONFIG_OPTION_SSL_TRUST_DEFAULT_CA, TRUE));
+  svn_config_get(cfg, &authority_files, SVN_CONFIG_SECTION_GLOBAL,
+                 SVN_CONFIG_OPTION_SSL_AUTHORITY_FILES, NULL);
+  if (server_group)
+    {
+      SVN_ERR(svn_config_get_tristate(cfg, &use_tls, server_group,
+                                      SVN_CONFIG_OPTION_SVN_TLS, "auto",
+                                      use_tls));
+      SVN_ERR(svn_config_get_bool(cfg, &trust_default_ca, server_group,
+                                  SVN_CONFIG_OPTION_SSL_TRUST_DEFAULT_CA,
+                                  trust_default_ca));
+      svn_config_get(cfg, &authority_files, server_group,
+                     SVN_CONFIG_OPTION_SSL_AUTHORITY_FILES, authority_files);
+    }
+
+  if (use_tls == svn_tristate_false)
+    return SVN_NO_ERROR;
+
+  /* "auto" means "if the server offers it". */
+  if (! svn_ra_svn_has_capability(sess->conn, SVN_RA_SVN_CAP_STARTTLS))
+    {
+      if (use_tls == svn_tristate_unknown)
+        return SVN_NO_ERROR;
+
+      return svn_error_createf(SVN_ERR_RA_SVN_TLS_ERROR, NULL,
+                               _("Server '%s' does not support TLS"),
+                               sess->hostname);
+    }
+
+#ifdef SVN_HAVE_OPENSSL
+  {
+    svn_ra_svn__tls_ctx_t *ctx;
+    apr_uint32_t failures;
+
+    SVN_ERR(svn_ra_svn__tls_client_ctx_create(&ctx, trust_default_ca,
+                                              authority_files, pool));
+
+    SVN_ERR(svn_ra_svn__write_tuple(sess->conn, pool, "w()", "starttls"));
+    SVN_ERR(svn_ra_svn__read_cmd_response(sess->conn, pool, ""));
+    SVN_ERR(svn_ra_svn__tls_connect(&failures, NULL, sess->conn, ctx,
+                                    sess->hostname, port, pool));
+    if (failures)
+      SVN_ERR(verify_server_cert(sess, failures, port, pool));
+    SVN_ERR(svn_ra_svn__tls_set_trusted(sess->conn));
+
+    /* Start over, now through TLS. */
+    apr_hash_clear(sess->conn->capabilities);
+    SVN_ERR(read_greeting(sess->conn, pool));
+  }
+
+  return SVN_NO_ERROR;
+#else
+  if (use_tls == svn_tristate_unknown)
+    return SVN_NO_ERROR;
+
+  return svn_error_create(SVN_ERR_RA_SVN_TLS_ERROR, NULL,
+                          _("This client has been built without TLS "
+                            "support"));
+#endif
+}
+
 /* Open a session to URL, returning it in *SESS_P, allocating it in POOL.
    URI is a parsed version of URL.  CALLBACKS and CALLBACKS_BATON
    are provided by the caller of ra_svn_open. If TUNNEL_NAME is not NULL,
    it is the name of the tunnel type parsed from the URL scheme.
    If TUNNEL_ARGV is not NULL, it points to a program argument list to use
-   when invoking the tunnel agent.
+   when invoking the tunnel agent.  If MUX_CONN is not NULL, open the
+   session on a new channel of that multiplexed connection instead of
+   connecting to the server.
 */
 static svn_error_t *open_session(svn_ra_svn__session_baton_t **sess_p,
                                  const char *url,
@@ -620,14 +846,14 @@ static svn_error_t *open_session(svn_ra_svn__session_baton_t **sess_p,
                                  const svn_ra_callbacks2_t *callbacks,
                                  void *callbacks_baton,
                                  svn_auth_baton_t *auth_baton,
+                                 svn_ra_svn_conn_t *mux_conn,
                                  apr_pool_t *result_pool,
                                  apr_pool_t *scratch_pool)
 {
   svn_ra_svn__session_baton_t *sess;
   svn_ra_svn_conn_t *conn;
   apr_socket_t *sock;
-  apr_uint64_t minver, maxver;
-  svn_ra_svn__list_t *mechlist, *server_caplist, *repos_caplist;
+  svn_ra_svn__list_t *repos_caplist;
   const char *client_string = NULL;
   apr_pool_t *pool = result_pool;
   svn_ra_svn__parent_t *parent;
@@ -640,6 +866,7 @@ static svn_error_t *open_session(svn_ra_svn__session_baton_t **sess_p,
   sess = apr_palloc(pool, sizeof(*sess));
   sess->pool = pool;
   sess->is_tunneled = (tunnel_name != NULL);
+  sess->auth_settled = FALSE;
   sess->parent = parent;
   sess->user = uri->user;
   sess->hostname = uri->hostname;
@@ -661,7 +888,9 @@ static svn_error_t *open_session(svn_ra_svn__session_baton_t **sess_p,
                                         tunnel_name,
                                         uri->hostname, uri->port);
 
-      if (tunnel_argv)
+      if (mux_conn)
+        SVN_ERR(svn_ra_svn__mux_open(&conn, mux_conn, pool));
+      else if (tunnel_argv)
         SVN_ERR(make_tunnel(tunnel_argv, &conn, pool));
       else
         {
@@ -692,12 +921,19 @@ static svn_error_t *open_session(svn_ra_svn__session_baton_t **sess_p,
       sess->realm_prefix = apr_psprintf(pool, "<svn://%s:%d>", uri->hostname,
                                         uri->port ? uri->port : SVN_RA_SVN_PORT);
 
-      SVN_ERR(make_connection(uri->hostname,
-                              uri->port ? uri->port : SVN_RA_SVN_PORT,
-                              &sock, pool));
-      conn = svn_ra_svn_create_conn5(sock, NULL, NULL,
-                                     SVN_DELTA_COMPRESSION_LEVEL_DEFAULT,
-                                     0, 0, 0, 0, pool);
+      if (mux_conn)
+        {
+          SVN_ERR(svn_ra_svn__mux_open(&conn, mux_conn, pool));
+        }
+      else
+        {
+          SVN_ERR(make_connection(uri->hostname,
+                                  uri->port ? uri->port : SVN_RA_SVN_PORT,
+                                  &sock, pool));
+          conn = svn_ra_svn_create_conn5(sock, NULL, NULL,
+                                         SVN_DELTA_COMPRESSION_LEVEL_DEFAULT,
+                                         0, 0, 0, 0, pool);
+        }
     }
 
   /* Build the useragent string, querying the client for any
@@ -723,25 +959,11 @@ static svn_error_t *open_session(svn_ra_svn__session_baton_t **sess_p,
   conn->session = sess;
 
   /* Read server's greeting. */
-  SVN_ERR(svn_ra_svn__read_cmd_response(conn, pool, "nnll", &minver, &maxver,
-                                        &mechlist, &server_caplist));
-
-  /* We support protocol version 2. */
-  if (minver > 2)
-    return svn_error_createf(SVN_ERR_RA_SVN_BAD_VERSION, NULL,
-                             _("Server requires minimum version %d"),
-                             (int) minver);
-  if (maxver < 2)
-    return svn_error_createf(SVN_ERR_RA_SVN_BAD_VERSION, NULL,
-                             _("Server only supports versions up to %d"),
-                             (int) maxver);
-  SVN_ERR(svn_ra_svn__set_capabilities(conn, server_caplist));
+  SVN_ERR(read_greeting(conn, pool));
 
-  /* All released versions of Subversion support edit-pipeline,
-   * so we do not support servers that do not. */
-  if (! svn_ra_svn_has_capability(conn, SVN_RA_SVN_CAP_EDIT_PIPELINE))
-    return svn_error_create(SVN_ERR_RA_SVN_BAD_VERSION, NULL,
-                            _("Server does not support edit pipelining"));
+  /* Channels of a multiplexed connection share its TLS layer. */
+  if (!tunnel_name && !mux_conn)
+    SVN_ERR(start_tls(sess, uri->port ? uri->port : SVN_RA_SVN_PORT, pool));
 
   /* In protocol version 2, we send back our protocol version, our
    * capability list, and the URL, and subsequently there is an auth
@@ -899,12 +1121,61 @@ static svn_error_t *ra_svn_open(svn_ra_session_t *session,
      reparent with a server that doesn't support reparenting. */
   SVN_ERR(open_session(&sess, url, &uri, tunnel, tunnel_argv, config,
                        callbacks, callback_baton,
-                       auth_baton, sess_pool, scratch_pool));
+                       auth_baton, NULL, sess_pool, scratch_pool));
   session->priv = sess;
 
   return SVN_NO_ERROR;
 }
 
+/* Open NEW_SESSION to URL as a new channel of OLD_SESSION's connection,
+   switching that to multiplexed mode first if necessary.  Allocate the
+   session in RESULT_POOL and use SCRATCH_POOL for temporaries. */
+static svn_error_t *open_channel(svn_ra_session_t *new_session,
+                                 svn_ra_session_t *old_session,
+                                 const char *url,
+                                 apr_pool_t *result_pool,
+                                 apr_pool_t *scratch_pool)
+{
+  svn_ra_svn__session_baton_t *old_sess = old_session->priv;
+  svn_ra_svn_conn_t *conn = old_sess->conn;
+  apr_pool_t *sess_pool;
+  svn_ra_svn__session_baton_t *sess;
+  apr_uri_t uri;
+  svn_error_t *err;
+
+  if (!svn_ra_svn__is_multiplexed(conn))
+    {
+      SVN_ERR(svn_ra_svn__write_cmd_multiplex(conn, scratch_pool));
+      SVN_ERR(handle_auth_request(old_sess, scratch_pool));
+      SVN_ERR(svn_ra_svn__read_cmd_response(conn, scratch_pool, ""));
+      SVN_ERR(svn_ra_svn__mux_start(conn, scratch_pool));
+    }
+
+  sess_pool = svn_pool_create(result_pool);
+  err = parse_url(url, &uri, sess_pool);
+
+  /* Channels never need to reconnect, hence no tunnel agent. */
+  if (!err)
+    err = open_session(&sess, url, &uri,
+                       old_sess->tunnel_name
+                         ? apr_pstrdup(sess_pool, old_sess->tunnel_name)
+                         : NULL,
+                       NULL, old_sess->config,
+                       old_sess->callbacks, old_sess->callbacks_baton,
+                       old_sess->auth_baton, conn, sess_pool, scratch_pool);
+
+  /* Make sure a failed channel gets closed right away. */
+  if (err)
+    {
+      svn_pool_destroy(sess_pool);
+      return svn_error_trace(err);
+    }
+
+  new_session->priv = sess;
+
+  return SVN_NO_ERROR;
+}
+
 static svn_error_t *ra_svn_dup_session(svn_ra_session_t *new_session,
                                        svn_ra_session_t *old_session,
                                        const char *new_session_url,
@@ -913,6 +1184,21 @@ static svn_error_t *ra_svn_dup_session(svn_ra_session_t *new_session,
 {
   svn_ra_svn__session_baton_t *old_sess = old_session->priv;
 
+  /* Rather than connecting and authenticating again, share the existing
+     connection if the server lets us.  Servers may refuse to open more
+     channels, so fall back to a separate connection upon failure. */
+  if (svn_ra_svn__is_multiplexed(old_sess->conn)
+      || svn_ra_svn_has_capability(old_sess->conn, SVN_RA_SVN_CAP_MULTIPLEX))
+    {
+      svn_error_t *err = open_channel(new_session, old_session,
+                                      new_session_url, result_pool,
+                                      scratch_pool);
+      if (!err)
+        return SVN_NO_ERROR;
+
+      svn_error_clear(err);
+    }
+
   SVN_ERR(ra_svn_open(new_session, NULL, new_session_url,
                       old_sess->callbacks, old_sess->callbacks_baton,
                       old_sess->auth_baton, old_sess->config,
@@ -958,7 +1244,7 @@ reparent_server(svn_ra_session_t *ra_session,
   if (! err)
     err = open_session(&new_sess, url, &uri, sess->tunnel_name, sess->tunnel_argv,
                        sess->config, sess->callbacks, sess->callbacks_baton,
-                       sess->auth_baton, sess_pool, sess_pool);
+                       sess->auth_baton, NULL, sess_pool, sess_pool);
   /* We destroy the new session pool on error, since it is allocated in
      the main session pool. */
   if (err)
@@ -1539,29 +1825,50 @@ send_dirent_fields(svn_ra_svn_conn_t *conn,
   return SVN_NO_ERROR;
 }
 
-static svn_error_t *ra_svn_get_dir(svn_ra_session_t *session,
-                                   apr_hash_t **dirents,
-                                   svn_revnum_t *fetched_rev,
-                                   apr_hash_t **props,
-                                   const char *path,
-                                   svn_revnum_t rev,
-                                   apr_uint32_t dirent_fields,
-                                   apr_pool_t *pool)
+/* Write a get-dir command for PATH@REV to SESSION.  Ask for the
+ * properties if WANT_PROPS is set and for the entries with the fields
+ * selected by DIRENT_FIELDS if WANT_CONTENTS is set.  Use SCRATCH_POOL
+ * for temporary allocations. */
+static svn_error_t *
+write_get_dir(svn_ra_session_t *session,
+              const char *path,
+              svn_revnum_t rev,
+              svn_boolean_t want_props,
+              svn_boolean_t want_contents,
+              apr_uint32_t dirent_fields,
+              apr_pool_t *scratch_pool)
 {
   svn_ra_svn__session_baton_t *sess_baton = session->priv;
   svn_ra_svn_conn_t *conn = sess_baton->conn;
-  svn_ra_svn__list_t *proplist, *dirlist;
-  int i;
 
-  path = reparent_path(session, path, pool);
-  SVN_ERR(svn_ra_svn__write_tuple(conn, pool, "w(c(?r)bb(!", "get-dir", path,
-                                  rev, (props != NULL), (dirents != NULL)));
-  SVN_ERR(send_dirent_fields(conn, dirent_fields, pool));
+  path = reparent_path(session, path, scratch_pool);
+  SVN_ERR(svn_ra_svn__write_tuple(conn, scratch_pool, "w(c(?r)bb(!",
+                                  "get-dir", path, rev, want_props,
+                                  want_contents));
+  SVN_ERR(send_dirent_fields(conn, dirent_fields, scratch_pool));
 
   /* Always send the, nominally optional, want-iprops as "false" to
      workaround a bug in svnserve 1.8.0-1.8.8 that causes the server
      to see "true" if it is omitted. */
-  SVN_ERR(svn_ra_svn__write_tuple(conn, pool, "!)b)", FALSE));
+  SVN_ERR(svn_ra_svn__write_tuple(conn, scratch_pool, "!)b)", FALSE));
+
+  return SVN_NO_ERROR;
+}
+
+/* Read the response to a get-dir command from SESS_BATON and return the
+ * results in *DIRENTS, *FETCHED_REV and *PROPS like svn_ra_get_dir2().
+ * Allocate them in POOL. */
+static svn_error_t *
+read_get_dir_response(apr_hash_t **dirents,
+                      svn_revnum_t *fetched_rev,
+                      apr_hash_t **props,
+                      svn_ra_svn__session_baton_t *sess_baton,
+                      apr_pool_t *pool)
+{
+  svn_ra_svn_conn_t *conn = sess_baton->conn;
+  svn_ra_svn__list_t *proplist, *dirlist;
+  svn_revnum_t rev;
+  int i;
 
   SVN_ERR(handle_auth_request(sess_baton, pool));
   SVN_ERR(svn_ra_svn__read_cmd_response(conn, pool, "rll", &rev, &proplist,
@@ -1625,6 +1932,23 @@ static svn_error_t *ra_svn_get_dir(svn_ra_session_t *session,
   return SVN_NO_ERROR;
 }
 
+static svn_error_t *ra_svn_get_dir(svn_ra_session_t *session,
+                                   apr_hash_t **dirents,
+                                   svn_revnum_t *fetched_rev,
+                                   apr_hash_t **props,
+                                   const char *path,
+                                   svn_revnum_t rev,
+                                   apr_uint32_t dirent_fields,
+                                   apr_pool_t *pool)
+{
+  SVN_ERR(write_get_dir(session, path, rev, (props != NULL),
+                        (dirents != NULL), dirent_fields, pool));
+  SVN_ERR(read_get_dir_response(dirents, fetched_rev, props, session->priv,
+                                pool));
+
+  return SVN_NO_ERROR;
+}
+
 /* Converts a apr_uint64_t with values TRUE, FALSE or
    SVN_RA_SVN_UNSPECIFIED_NUMBER as provided by svn_ra_svn__parse_tuple
    to a svn_tristate_t */
@@ -1703,95 +2027,1125 @@ static svn_error_t *ra_svn_get_mergeinfo(svn_ra_session_t *session,
   return SVN_NO_ERROR;
 }
 
-static svn_error_t *ra_svn_update(svn_ra_session_t *session,
-                                  const svn_ra_reporter3_t **reporter,
-                                  void **report_baton, svn_revnum_t rev,
-                                  const char *target, svn_depth_t depth,
-                                  svn_boolean_t send_copyfrom_args,
-                                  svn_boolean_t ignore_ancestry,
-                                  const svn_delta_editor_t *update_editor,
-                                  void *update_baton,
-                                  apr_pool_t *pool,
-                                  apr_pool_t *scratch_pool)
+/* --- PARALLEL CHECKOUT --- */
+
+/* Amount of read-ahead data per extra session that we keep in memory
+   before spilling it to a temporary file. */
+#define CHECKOUT_READAHEAD_MEMORY (1024 * 1024)
+
+/* Maximum number of reads per extra session and read-ahead round.
+   Keeps a fast connection from delaying the sub-tree being applied. */
+#define CHECKOUT_READAHEAD_READS 16
+
+/* Read-ahead for the connection of an extra session.  Only one sub-tree
+   drive can be applied to the working copy at a time.  While that is
+   going on, we keep receiving the other sub-trees into these buffers,
+   so the server can send them in parallel. */
+typedef struct checkout_readahead_t
 {
-  svn_ra_svn__session_baton_t *sess_baton = session->priv;
-  svn_ra_svn_conn_t *conn = sess_baton->conn;
-  svn_boolean_t recurse = DEPTH_TO_RECURSE(depth);
+  /* The extra session, also used as the key in the hash of all
+     read-aheads. */
+  svn_ra_session_t *session;
 
-  /* Callbacks may assume that all data is relative the sessions's URL. */
-  SVN_ERR(ensure_exact_server_parent(session, scratch_pool));
+  /* The connection's original stream. */
+  svn_ra_svn__stream_t *transport;
 
-  /* Tell the server we want to start an update. */
-  SVN_ERR(svn_ra_svn__write_cmd_update(conn, pool, rev, target, recurse,
-                                       depth, send_copyfrom_args,
-                                       ignore_ancestry));
-  SVN_ERR(handle_auth_request(sess_baton, pool));
+  /* Data read from TRANSPORT ahead of time and the number of bytes in
+     there. */
+  svn_spillbuf_reader_t *buffer;
+  svn_filesize_t buffered;
 
-  /* Fetch a reporter for the caller to drive.  The reporter will drive
-   * update_editor upon finish_report(). */
-  SVN_ERR(ra_svn_get_reporter(sess_baton, pool, update_editor, update_baton,
-                              target, depth, reporter, report_baton));
-  return SVN_NO_ERROR;
-}
+  apr_pool_t *scratch_pool;
+} checkout_readahead_t;
 
-static svn_error_t *
-ra_svn_switch(svn_ra_session_t *session,
-              const svn_ra_reporter3_t **reporter,
-              void **report_baton, svn_revnum_t rev,
-              const char *target, svn_depth_t depth,
-              const char *switch_url,
-              svn_boolean_t send_copyfrom_args,
-              svn_boolean_t ignore_ancestry,
-              const svn_delta_editor_t *update_editor,
-              void *update_baton,
-              apr_pool_t *result_pool,
-              apr_pool_t *scratch_pool)
+/* A top-level directory of a checkout that gets fetched by an update
+   of its own. */
+typedef struct checkout_subtree_t
 {
-  apr_pool_t *pool = result_pool;
-  svn_ra_svn__session_baton_t *sess_baton = session->priv;
-  svn_ra_svn_conn_t *conn = sess_baton->conn;
-  svn_boolean_t recurse = DEPTH_TO_RECURSE(depth);
+  /* Name of the directory within the checkout root. */
+  const char *name;
 
-  /* Callbacks may assume that all data is relative the sessions's URL. */
-  SVN_ERR(ensure_exact_server_parent(session, scratch_pool));
+  /* The extra session running the update for this sub-tree.
+     NULL, if that update has not been started (yet). */
+  svn_ra_session_t *session;
 
-  /* Tell the server we want to start a switch. */
-  SVN_ERR(svn_ra_svn__write_cmd_switch(conn, pool, rev, target, recurse,
-                                       switch_url, depth,
-                                       send_copyfrom_args, ignore_ancestry));
-  SVN_ERR(handle_auth_request(sess_baton, pool));
+  /* TRUE, if the main editor drive added this directory. */
+  svn_boolean_t added;
 
-  /* Fetch a reporter for the caller to drive.  The reporter will drive
-   * update_editor upon finish_report(). */
-  SVN_ERR(ra_svn_get_reporter(sess_baton, pool, update_editor, update_baton,
-                              target, depth, reporter, report_baton));
-  return SVN_NO_ERROR;
-}
+  /* TRUE, once this sub-tree has been spliced into the main drive. */
+  svn_boolean_t done;
+} checkout_subtree_t;
 
-static svn_error_t *ra_svn_status(svn_ra_session_t *session,
-                                  const svn_ra_reporter3_t **reporter,
-                                  void **report_baton,
-                                  const char *target, svn_revnum_t rev,
-                                  svn_depth_t depth,
-                                  const svn_delta_editor_t *status_editor,
-                                  void *status_baton, apr_pool_t *pool)
+/* Directory baton for the main and sub-tree drives. */
+typedef struct checkout_dir_t
 {
-  svn_ra_svn__session_baton_t *sess_baton = session->priv;
-  svn_ra_svn_conn_t *conn = sess_baton->conn;
-  svn_boolean_t recurse = DEPTH_TO_RECURSE(depth);
+  struct checkout_baton_t *cb;
 
-  /* Callbacks may assume that all data is relative the sessions's URL. */
-  SVN_ERR(ensure_exact_server_parent(session, pool));
+  /* The directory baton of the wrapped editor.  NULL for top-level
+     directories in the main drive, which a sub-tree drive will add. */
+  void *baton;
 
-  /* Tell the server we want to start a status operation. */
-  SVN_ERR(svn_ra_svn__write_cmd_status(conn, pool, target, recurse, rev,
-                                       depth));
-  SVN_ERR(handle_auth_request(sess_baton, pool));
+  /* TRUE for the checkout root. */
+  svn_boolean_t is_root;
 
-  /* Fetch a reporter for the caller to drive.  The reporter will drive
-   * status_editor upon finish_report(). */
-  SVN_ERR(ra_svn_get_reporter(sess_baton, pool, status_editor, status_baton,
-                              target, depth, reporter, report_baton));
+  /* TRUE, if this baton belongs to a sub-tree drive. */
+  svn_boolean_t in_subtree;
+} checkout_dir_t;
+
+/* Baton for the checkout reporter and the editors that it uses to splice
+   the sub-tree updates into the main editor drive. */
+typedef struct checkout_baton_t
+{
+  /* The main session and its update parameters. */
+  svn_ra_session_t *session;
+  svn_revnum_t rev;
+  svn_boolean_t send_copyfrom_args;
+  svn_boolean_t ignore_ancestry;
+  const svn_delta_editor_t *editor;
+  void *edit_baton;
+
+  /* The plain update reporter, once we decided against splitting. */
+  ra_svn_reporter_baton_t *plain;
+
+  /* The root report, once we received it. */
+  svn_boolean_t reported;
+  svn_revnum_t report_rev;
+
+  /* Maximum number of extra sessions to use. */
+  int max_sessions;
+
+  /* Pool for all extra sessions, each one in a sub-pool of its own. */
+  apr_pool_t *sessions_pool;
+
+  /* Extra sessions that are not running an update right now. */
+  apr_array_header_t *idle;
+
+  /* All extra sessions' checkout_readahead_t, keyed by session. */
+  apr_hash_t *readaheads;
+
+  /* The sub-tree that gets spliced into the main drive right now. */
+  struct checkout_subtree_t *current;
+
+  /* All top-level directories, as checkout_subtree_t *, in the order
+     we splice them into the main editor drive.  BY_NAME maps the
+     directory names to the same elements. */
+  apr_array_header_t *subtrees;
+  apr_hash_t *by_name;
+
+  /* Index of the first element in SUBTREES that may still need its
+     update to be started. */
+  int next_start;
+
+  /* Root directory baton of EDITOR. */
+  void *root_baton;
+
+  /* Wrappers around EDITOR for the main and the sub-tree drives. */
+  svn_delta_editor_t main_editor;
+  svn_delta_editor_t subtree_editor;
+
+  apr_pool_t *pool;
+} checkout_baton_t;
+
+/* Return the number of parallel connections that the "servers" config
+   of SESS allows for a single operation. */
+static int
+get_max_connections(svn_ra_svn__session_baton_t *sess,
+                    apr_pool_t *scratch_pool)
+{
+  svn_config_t *cfg = sess->config
+                    ? svn_hash_gets(sess->config, SVN_CONFIG_CATEGORY_SERVERS)
+                    : NULL;
+  const char *server_group = NULL;
+  apr_int64_t max_connections;
+  svn_error_t *err;
+
+  if (cfg)
+    server_group = svn_config_find_group(cfg, sess->hostname,
+                                         SVN_CONFIG_SECTION_GROUPS,
+                                         scratch_pool);
+
+  /* An invalid setting should not make checkouts fail. */
+  err = svn_config_get_server_setting_int(
+                          cfg, server_group,
+                          SVN_CONFIG_OPTION_SVN_MAX_CONNECTIONS,
+                          SVN_CONFIG_DEFAULT_OPTION_SVN_MAX_CONNECTIONS,
+                          &max_connections, scratch_pool);
+  if (err)
+    {
+      svn_error_clear(err);
+      max_connections = SVN_CONFIG_DEFAULT_OPTION_SVN_MAX_CONNECTIONS;
+    }
+
+  if (max_connections < 1)
+    return 1;
+  if (max_connections > 16)
+    return 16;
+
+  return (int)max_connections;
+}
+
+/* Send the "update" command for CB's whole target on the main session
+   and set CB->PLAIN to a normal reporter for it.  Replay the root report,
+   if we already received one. */
+static svn_error_t *
+checkout_start_plain(checkout_baton_t *cb,
+                     apr_pool_t *scratch_pool)
+{
+  svn_ra_svn__session_baton_t *sess = cb->session->priv;
+  const svn_ra_reporter3_t *reporter;
+  void *report_baton;
+
+  SVN_ERR(svn_ra_svn__write_cmd_update(sess->conn, cb->pool, cb->rev, "",
+                                       TRUE, svn_depth_infinity,
+                                       cb->send_copyfrom_args,
+                                       cb->ignore_ancestry));
+  SVN_ERR(handle_auth_request(sess, cb->pool));
+  SVN_ERR(ra_svn_get_reporter(sess, cb->pool, cb->editor, cb->edit_baton,
+                              "", svn_depth_infinity,
+                              &reporter, &report_baton));
+  cb->plain = report_baton;
+
+  if (cb->reported)
+    SVN_ERR(ra_svn_set_path(cb->plain, "", cb->report_rev,
+                            svn_depth_infinity, TRUE, NULL, scratch_pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_read_fn_t for a checkout_readahead_t. */
+static svn_error_t *
+readahead_read_cb(void *baton,
+                  char *buffer,
+                  apr_size_t *len)
+{
+  checkout_readahead_t *ra = baton;
+  apr_size_t amount;
+
+  if (ra->buffered == 0)
+    return svn_error_trace(svn_ra_svn__stream_read(ra->transport, buffer,
+                                                   len));
+
+  svn_pool_clear(ra->scratch_pool);
+  SVN_ERR(svn_spillbuf__reader_read(&amount, ra->buffer, buffer, *len,
+                                    ra->scratch_pool));
+  ra->buffered -= amount;
+  *len = amount;
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_write_fn_t for a checkout_readahead_t. */
+static svn_error_t *
+readahead_write_cb(void *baton,
+                   const char *buffer,
+                   apr_size_t *len)
+{
+  checkout_readahead_t *ra = baton;
+  return svn_error_trace(svn_ra_svn__stream_write(ra->transport, buffer,
+                                                  len));
+}
+
+/* Implements svn_stream_data_available_fn_t for a checkout_readahead_t. */
+static svn_error_t *
+readahead_data_available_cb(void *baton,
+                            svn_boolean_t *data_available)
+{
+  checkout_readahead_t *ra = baton;
+
+  if (ra->buffered > 0)
+    {
+      *data_available = TRUE;
+      return SVN_NO_ERROR;
+    }
+
+  return svn_error_trace(svn_ra_svn__stream_data_available(ra->transport,
+                                                           data_available));
+}
+
+/* Implements ra_svn_timeout_fn_t for a checkout_readahead_t. */
+static void
+readahead_timeout_cb(void *baton,
+                     apr_interval_time_t interval)
+{
+  checkout_readahead_t *ra = baton;
+  svn_ra_svn__stream_timeout(ra->transport, interval);
+}
+
+/* Put a read-ahead buffer between the extra SESSION of CB and its
+   connection's stream.  Allocate it in SESSION's pool. */
+static void
+readahead_install(checkout_baton_t *cb,
+                  svn_ra_session_t *session)
+{
+  svn_ra_svn_conn_t *conn = ((svn_ra_svn__session_baton_t *)session->priv)
+                              ->conn;
+  checkout_readahead_t *ra = apr_pcalloc(session->pool, sizeof(*ra));
+  svn_stream_t *stream;
+
+  ra->session = session;
+  ra->transport = conn->stream;
+  ra->buffer = svn_spillbuf__reader_create(SVN_RA_SVN__READBUF_SIZE,
+                                           CHECKOUT_READAHEAD_MEMORY,
+                                           session->pool);
+  ra->buffered = 0;
+  ra->scratch_pool = svn_pool_create(session->pool);
+
+  stream = svn_stream_create(ra, session->pool);
+  svn_stream_set_read2(stream, readahead_read_cb, NULL /* use default */);
+  svn_stream_set_write(stream, readahead_write_cb);
+  svn_stream_set_data_available(stream, readahead_data_available_cb);
+
+  conn->stream = svn_ra_svn__stream_create(stream, stream, ra,
+                                           readahead_timeout_cb,
+                                           session->pool);
+  apr_hash_set(cb->readaheads, &ra->session, sizeof(ra->session), ra);
+}
+
+/* Receive whatever the server already sent for the sub-trees of CB that
+   are not being spliced right now.  Never block. */
+static svn_error_t *
+readahead_fill(checkout_baton_t *cb)
+{
+  char buffer[SVN_RA_SVN__READBUF_SIZE];
+  int i, k;
+
+  for (i = 0; i < cb->subtrees->nelts; ++i)
+    {
+      checkout_subtree_t *subtree
+        = APR_ARRAY_IDX(cb->subtrees, i, checkout_subtree_t *);
+      checkout_readahead_t *ra;
+
+      if (!subtree->session || subtree == cb->current)
+        continue;
+
+      ra = apr_hash_get(cb->readaheads, &subtree->session,
+                        sizeof(subtree->session));
+      for (k = 0; ra && k < CHECKOUT_READAHEAD_READS; ++k)
+        {
+          svn_boolean_t available;
+          apr_size_t len = sizeof(buffer);
+
+          SVN_ERR(svn_ra_svn__stream_data_available(ra->transport,
+                                                    &available));
+          if (!available)
+            break;
+
+          /* A closed connection will be reported by the sub-tree drive. */
+          SVN_ERR(svn_ra_svn__stream_read(ra->transport, buffer, &len));
+          if (len == 0)
+            break;
+
+          svn_pool_clear(ra->scratch_pool);
+          SVN_ERR(svn_spillbuf__reader_write(ra->buffer, buffer, len,
+                                             ra->scratch_pool));
+          ra->buffered += len;
+        }
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Start the update for SUBTREE of CB on an idle extra session, opening a
+   new one if there is none.  Upon failure, discard the session. */
+static svn_error_t *
+checkout_start_subtree(checkout_baton_t *cb,
+                       checkout_subtree_t *subtree,
+                       apr_pool_t *scratch_pool)
+{
+  svn_ra_svn__session_baton_t *main_sess = cb->session->priv;
+  svn_ra_session_t *session;
+  svn_ra_svn__session_baton_t *sess;
+  svn_error_t *err;
+
+  if (cb->idle->nelts)
+    {
+      session = *(svn_ra_session_t **)apr_array_pop(cb->idle);
+    }
+  else
+    {
+      apr_pool_t *sess_pool = svn_pool_create(cb->sessions_pool);
+
+      session = apr_pcalloc(sess_pool, sizeof(*session));
+      session->vtable = cb->session->vtable;
+      session->cancel_func = cb->session->cancel_func;
+      session->cancel_baton = cb->session->cancel_baton;
+      session->pool = sess_pool;
+
+      err = ra_svn_open(session, NULL, main_sess->parent->client_url->data,
+                        main_sess->callbacks, main_sess->callbacks_baton,
+                        main_sess->auth_baton, main_sess->config,
+                        sess_pool, scratch_pool);
+      if (err)
+        {
+          svn_pool_destroy(sess_pool);
+          return svn_error_trace(err);
+        }
+
+      readahead_install(cb, session);
+    }
+
+  /* Report an empty root, so the server adds the whole sub-tree. */
+  sess = session->priv;
+  err = svn_ra_svn__write_cmd_update(sess->conn, scratch_pool, cb->rev,
+                                     subtree->name, TRUE, svn_depth_infinity,
+                                     cb->send_copyfrom_args,
+                                     cb->ignore_ancestry);
+  if (!err)
+    err = handle_auth_request(sess, scratch_pool);
+  if (!err)
+    err = svn_ra_svn__write_cmd_set_path(sess->conn, scratch_pool, "",
+                                         cb->report_rev, TRUE, NULL,
+                                         svn_depth_infinity);
+  if (!err)
+    err = svn_ra_svn__write_cmd_finish_report(sess->conn, scratch_pool);
+  if (!err)
+    err = handle_auth_request(sess, scratch_pool);
+
+  if (err)
+    {
+      apr_hash_set(cb->readaheads, &session, sizeof(session), NULL);
+      svn_pool_destroy(session->pool);
+      return svn_error_trace(err);
+    }
+
+  subtree->session = session;
+
+  return SVN_NO_ERROR;
+}
+
+/* Start the update for the next sub-tree of CB that needs one. */
+static svn_error_t *
+checkout_start_next(checkout_baton_t *cb,
+                    apr_pool_t *scratch_pool)
+{
+  for (; cb->next_start < cb->subtrees->nelts; ++cb->next_start)
+    {
+      checkout_subtree_t *subtree
+        = APR_ARRAY_IDX(cb->subtrees, cb->next_start, checkout_subtree_t *);
+
+      if (subtree->added && !subtree->session && !subtree->done)
+        {
+          ++cb->next_start;
+          return svn_error_trace(checkout_start_subtree(cb, subtree,
+                                                        scratch_pool));
+        }
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Drive CB's editor with the update for SUBTREE, starting it first if
+   necessary.  Afterwards, use the session for the next sub-tree.
+
+   The working copy takes the sub-trees one at a time.  Meanwhile, the
+   editor callbacks keep receiving the other sub-trees, see
+   readahead_fill(). */
+static svn_error_t *
+checkout_splice_subtree(checkout_baton_t *cb,
+                        checkout_subtree_t *subtree,
+                        apr_pool_t *scratch_pool)
+{
+  svn_ra_svn__session_baton_t *sess;
+
+  if (!subtree->session)
+    SVN_ERR(checkout_start_subtree(cb, subtree, scratch_pool));
+
+  sess = subtree->session->priv;
+  cb->current = subtree;
+  SVN_ERR(svn_ra_svn_drive_editor2(sess->conn, scratch_pool,
+                                   &cb->subtree_editor, cb, NULL, FALSE));
+  SVN_ERR(svn_ra_svn__read_cmd_response(sess->conn, scratch_pool, ""));
+  cb->current = NULL;
+
+  APR_ARRAY_PUSH(cb->idle, svn_ra_session_t *) = subtree->session;
+  subtree->session = NULL;
+  subtree->done = TRUE;
+
+  /* Should this fail, we will try again when we get to that sub-tree
+     and report the error then. */
+  svn_error_clear(checkout_start_next(cb, scratch_pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* Return a new directory baton for CB wrapping BATON, inheriting
+   IN_SUBTREE from PARENT.  Allocate it in RESULT_POOL. */
+static checkout_dir_t *
+make_checkout_dir(checkout_baton_t *cb,
+                  checkout_dir_t *parent,
+                  void *baton,
+                  apr_pool_t *result_pool)
+{
+  checkout_dir_t *dir = apr_pcalloc(result_pool, sizeof(*dir));
+
+  dir->cb = cb;
+  dir->baton = baton;
+  dir->in_subtree = parent->in_subtree;
+
+  return dir;
+}
+
+/* Set *BATON to the wrapped editor's baton for DIR, which must exist. */
+static svn_error_t *
+checkout_dir_baton(void **baton,
+                   checkout_dir_t *dir)
+{
+  if (!dir->baton)
+    return svn_error_create(SVN_ERR_RA_SVN_MALFORMED_DATA, NULL,
+                            _("Unexpected editor command within "
+                              "a top-level directory"));
+
+  *baton = dir->baton;
+  return SVN_NO_ERROR;
+}
+
+/* The main editor drive has depth "immediates" and passes everything on
+   to the wrapped editor, except for the top-level directories.  Those
+   get added by the sub-tree drives, which we splice in right before
+   closing the root.  The sub-tree drives in turn skip everything that
+   the main drive takes care of:  opening and closing the edit and the
+   root directory. */
+static svn_error_t *
+checkout_set_target_revision(void *edit_baton,
+                             svn_revnum_t target_revision,
+                             apr_pool_t *pool)
+{
+  checkout_baton_t *cb = edit_baton;
+
+  return svn_error_trace(cb->editor->set_target_revision(cb->edit_baton,
+                                                         target_revision,
+                                                         pool));
+}
+
+static svn_error_t *
+checkout_open_root(void *edit_baton,
+                   svn_revnum_t base_revision,
+                   apr_pool_t *pool,
+                   void **root_baton)
+{
+  checkout_baton_t *cb = edit_baton;
+  checkout_dir_t *root = apr_pcalloc(pool, sizeof(*root));
+
+  SVN_ERR(cb->editor->open_root(cb->edit_baton, base_revision, pool,
+                                &cb->root_baton));
+
+  root->cb = cb;
+  root->baton = cb->root_baton;
+  root->is_root = TRUE;
+  *root_baton = root;
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+checkout_delete_entry(const char *path,
+                      svn_revnum_t revision,
+                      void *parent_baton,
+                      apr_pool_t *pool)
+{
+  checkout_dir_t *parent = parent_baton;
+  void *baton;
+
+  SVN_ERR(checkout_dir_baton(&baton, parent));
+  return svn_error_trace(parent->cb->editor->delete_entry(path, revision,
+                                                          baton, pool));
+}
+
+static svn_error_t *
+checkout_add_directory(const char *path,
+                       void *parent_baton,
+                       const char *copyfrom_path,
+                       svn_revnum_t copyfrom_revision,
+                       apr_pool_t *pool,
+                       void **child_baton)
+{
+  checkout_dir_t *parent = parent_baton;
+  checkout_baton_t *cb = parent->cb;
+  void *baton;
+
+  /* Leave top-level directories to the sub-tree drives. */
+  if (parent->is_root && !parent->in_subtree)
+    {
+      const char *name = svn_relpath_basename(path, NULL);
+      checkout_subtree_t *subtree = svn_hash_gets(cb->by_name, name);
+
+      if (!subtree)
+        {
+          subtree = apr_pcalloc(cb->pool, sizeof(*subtree));
+          subtree->name = apr_pstrdup(cb->pool, name);
+          APR_ARRAY_PUSH(cb->subtrees, checkout_subtree_t *) = subtree;
+          svn_hash_sets(cb->by_name, subtree->name, subtree);
+        }
+
+      subtree->added = TRUE;
+      *child_baton = make_checkout_dir(cb, parent, NULL, pool);
+
+      return SVN_NO_ERROR;
+    }
+
+  SVN_ERR(checkout_dir_baton(&baton, parent));
+  SVN_ERR(cb->editor->add_directory(path, baton, copyfrom_path,
+                                    copyfrom_revision, pool, &baton));
+  *child_baton = make_checkout_dir(cb, parent, baton, pool);
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+checkout_open_directory(const char *path,
+                        void *parent_baton,
+                        svn_revnum_t base_revision,
+                        apr_pool_t *pool,
+                        void **child_baton)
+{
+  checkout_dir_t *parent = parent_baton;
+  void *baton;
+
+  SVN_ERR(checkout_dir_baton(&baton, parent));
+  SVN_ERR(parent->cb->editor->open_directory(path, baton, base_revision,
+                                             pool, &baton));
+  *child_baton = make_checkout_dir(parent->cb, parent, baton, pool);
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+checkout_change_dir_prop(void *dir_baton,
+                         const char *name,
+                         const svn_string_t *value,
+                         apr_pool_t *pool)
+{
+  checkout_dir_t *dir = dir_baton;
+
+  /* The sub-tree drive will send these again. */
+  if (!dir->baton)
+    return SVN_NO_ERROR;
+
+  return svn_error_trace(dir->cb->editor->change_dir_prop(dir->baton, name,
+                                                          value, pool));
+}
+
+static svn_error_t *
+checkout_close_directory(void *dir_baton,
+                         apr_pool_t *pool)
+{
+  checkout_dir_t *dir = dir_baton;
+  checkout_baton_t *cb = dir->cb;
+
+  if (!dir->baton)
+    return SVN_NO_ERROR;
+
+  if (dir->is_root)
+    {
+      apr_pool_t *iterpool;
+      int i;
+
+      /* Sub-tree drives must not close the root. */
+      if (dir->in_subtree)
+        return SVN_NO_ERROR;
+
+      /* The main drive is done with the root's direct children.  Add the
+         sub-trees now, in the order that we started their updates in.
+         Updates for directories that the main drive did not add are of
+         no use. */
+      for (i = 0; i < cb->subtrees->nelts; ++i)
+        {
+          checkout_subtree_t *subtree
+            = APR_ARRAY_IDX(cb->subtrees, i, checkout_subtree_t *);
+
+          if (subtree->session && !subtree->added)
+            {
+              apr_hash_set(cb->readaheads, &subtree->session,
+                           sizeof(subtree->session), NULL);
+              svn_pool_destroy(subtree->session->pool);
+              subtree->session = NULL;
+            }
+        }
+
+      iterpool = svn_pool_create(pool);
+      for (i = 0; i < cb->subtrees->nelts; ++i)
+        {
+          checkout_subtree_t *subtree
+            = APR_ARRAY_IDX(cb->subtrees, i, checkout_subtree_t *);
+
+          svn_pool_clear(iterpool);
+          if (subtree->added)
+            SVN_ERR(checkout_splice_subtree(cb, subtree, iterpool));
+        }
+      svn_pool_destroy(iterpool);
+    }
+  else
+    {
+      SVN_ERR(readahead_fill(cb));
+    }
+
+  return svn_error_trace(cb->editor->close_directory(dir->baton, pool));
+}
+
+static svn_error_t *
+checkout_absent_directory(const char *path,
+                          void *parent_baton,
+                          apr_pool_t *pool)
+{
+  checkout_dir_t *parent = parent_baton;
+  void *baton;
+
+  SVN_ERR(checkout_dir_baton(&baton, parent));
+  return svn_error_trace(parent->cb->editor->absent_directory(path, baton,
+                                                              pool));
+}
+
+static svn_error_t *
+checkout_add_file(const char *path,
+                  void *parent_baton,
+                  const char *copyfrom_path,
+                  svn_revnum_t copyfrom_revision,
+                  apr_pool_t *pool,
+                  void **file_baton)
+{
+  checkout_dir_t *parent = parent_baton;
+  void *baton;
+
+  SVN_ERR(checkout_dir_baton(&baton, parent));
+  SVN_ERR(readahead_fill(parent->cb));
+  return svn_error_trace(parent->cb->editor->add_file(path, baton,
+                                                      copyfrom_path,
+                                                      copyfrom_revision,
+                                                      pool, file_baton));
+}
+
+static svn_error_t *
+checkout_open_file(const char *path,
+                   void *parent_baton,
+                   svn_revnum_t base_revision,
+                   apr_pool_t *pool,
+                   void **file_baton)
+{
+  checkout_dir_t *parent = parent_baton;
+  void *baton;
+
+  SVN_ERR(checkout_dir_baton(&baton, parent));
+  return svn_error_trace(parent->cb->editor->open_file(path, baton,
+                                                       base_revision,
+                                                       pool, file_baton));
+}
+
+static svn_error_t *
+checkout_absent_file(const char *path,
+                     void *parent_baton,
+                     apr_pool_t *pool)
+{
+  checkout_dir_t *parent = parent_baton;
+  void *baton;
+
+  SVN_ERR(checkout_dir_baton(&baton, parent));
+  return svn_error_trace(parent->cb->editor->absent_file(path, baton, pool));
+}
+
+static svn_error_t *
+checkout_close_edit(void *edit_baton,
+                    apr_pool_t *pool)
+{
+  checkout_baton_t *cb = edit_baton;
+
+  return svn_error_trace(cb->editor->close_edit(cb->edit_baton, pool));
+}
+
+static svn_error_t *
+checkout_abort_edit(void *edit_baton,
+                    apr_pool_t *pool)
+{
+  checkout_baton_t *cb = edit_baton;
+
+  return svn_error_trace(cb->editor->abort_edit(cb->edit_baton, pool));
+}
+
+static svn_error_t *
+checkout_subtree_set_target_revision(void *edit_baton,
+                                     svn_revnum_t target_revision,
+                                     apr_pool_t *pool)
+{
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+checkout_subtree_open_root(void *edit_baton,
+                           svn_revnum_t base_revision,
+                           apr_pool_t *pool,
+                           void **root_baton)
+{
+  checkout_baton_t *cb = edit_baton;
+  checkout_dir_t *root = apr_pcalloc(pool, sizeof(*root));
+
+  root->cb = cb;
+  root->baton = cb->root_baton;
+  root->is_root = TRUE;
+  root->in_subtree = TRUE;
+  *root_baton = root;
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+checkout_subtree_close_edit(void *edit_baton,
+                            apr_pool_t *pool)
+{
+  return SVN_NO_ERROR;
+}
+
+/* Initialize the main and sub-tree editors of CB. */
+static void
+init_checkout_editors(checkout_baton_t *cb)
+{
+  svn_delta_editor_t *editor = &cb->main_editor;
+
+  /* File batons are the wrapped editor's own. */
+  *editor = *cb->editor;
+  editor->set_target_revision = checkout_set_target_revision;
+  editor->open_root = checkout_open_root;
+  editor->delete_entry = checkout_delete_entry;
+  editor->add_directory = checkout_add_directory;
+  editor->open_directory = checkout_open_directory;
+  editor->change_dir_prop = checkout_change_dir_prop;
+  editor->close_directory = checkout_close_directory;
+  editor->absent_directory = checkout_absent_directory;
+  editor->add_file = checkout_add_file;
+  editor->open_file = checkout_open_file;
+  editor->absent_file = checkout_absent_file;
+  editor->close_edit = checkout_close_edit;
+  editor->abort_edit = checkout_abort_edit;
+
+  /* Errors in a sub-tree drive abort the main drive. */
+  cb->subtree_editor = *editor;
+  cb->subtree_editor.set_target_revision
+    = checkout_subtree_set_target_revision;
+  cb->subtree_editor.open_root = checkout_subtree_open_root;
+  cb->subtree_editor.close_edit = checkout_subtree_close_edit;
+  cb->subtree_editor.abort_edit = checkout_subtree_close_edit;
+}
+
+/* Fetch CB's checkout with one update per top-level directory, using up
+   to CB->MAX_SESSIONS extra sessions.  Set *DONE to FALSE and send
+   nothing, if this is not worthwhile or not possible. */
+static svn_error_t *
+checkout_split(svn_boolean_t *done,
+               checkout_baton_t *cb,
+               apr_pool_t *scratch_pool)
+{
+  svn_ra_svn__session_baton_t *sess = cb->session->priv;
+  svn_ra_svn_conn_t *conn = sess->conn;
+  apr_hash_t *dirents;
+  apr_array_header_t *sorted;
+  svn_error_t *err;
+  int i;
+
+  *done = FALSE;
+
+  /* Pin the revision, so all updates agree upon the tree. */
+  err = ra_svn_get_dir(cb->session, &dirents, &cb->rev, NULL, "", cb->rev,
+                       SVN_DIRENT_KIND, scratch_pool);
+  if (err)
+    {
+      svn_error_clear(err);
+      return SVN_NO_ERROR;
+    }
+
+  sorted = svn_sort__hash(dirents, svn_sort_compare_items_lexically,
+                          scratch_pool);
+  for (i = 0; i < sorted->nelts; ++i)
+    {
+      svn_sort__item_t *item = &APR_ARRAY_IDX(sorted, i, svn_sort__item_t);
+      svn_dirent_t *dirent = item->value;
+      checkout_subtree_t *subtree;
+
+      if (dirent->kind != svn_node_dir)
+        continue;
+
+      subtree = apr_pcalloc(cb->pool, sizeof(*subtree));
+      subtree->name = apr_pstrdup(cb->pool, item->key);
+      APR_ARRAY_PUSH(cb->subtrees, checkout_subtree_t *) = subtree;
+      svn_hash_sets(cb->by_name, subtree->name, subtree);
+    }
+
+  /* A single sub-tree would not run in parallel to anything. */
+  if (cb->subtrees->nelts < 2)
+    return SVN_NO_ERROR;
+
+  /* Get the first sub-trees going.  If we can't even open one extra
+     session, do a plain update instead. */
+  cb->sessions_pool = svn_pool_create(cb->pool);
+  for (i = 0; i < cb->subtrees->nelts && i < cb->max_sessions; ++i)
+    {
+      err = checkout_start_subtree(cb,
+                                   APR_ARRAY_IDX(cb->subtrees, i,
+                                                 checkout_subtree_t *),
+                                   scratch_pool);
+      if (err)
+        {
+          svn_error_clear(err);
+          break;
+        }
+    }
+
+  if (i == 0)
+    {
+      svn_pool_destroy(cb->sessions_pool);
+      apr_hash_clear(cb->readaheads);
+      return SVN_NO_ERROR;
+    }
+
+  cb->next_start = i;
+
+  /* Fetch the root and its immediate children on the main session.
+     Splicing the sub-trees happens within that editor drive. */
+  init_checkout_editors(cb);
+  err = svn_ra_svn__write_cmd_update(conn, scratch_pool, cb->rev, "",
+                                     FALSE, svn_depth_immediates,
+                                     cb->send_copyfrom_args,
+                                     cb->ignore_ancestry);
+  if (!err)
+    err = handle_auth_request(sess, scratch_pool);
+  if (!err)
+    err = svn_ra_svn__write_cmd_set_path(conn, scratch_pool, "",
+                                         cb->report_rev, TRUE, NULL,
+                                         svn_depth_infinity);
+  if (!err)
+    err = svn_ra_svn__write_cmd_finish_report(conn, scratch_pool);
+  if (!err)
+    err = handle_auth_request(sess, scratch_pool);
+  if (!err)
+    err = svn_ra_svn_drive_editor2(conn, scratch_pool, &cb->main_editor, cb,
+                                   NULL, FALSE);
+  if (!err)
+    err = svn_ra_svn__read_cmd_response(conn, scratch_pool, "");
+
+  /* Close all extra connections. */
+  svn_pool_destroy(cb->sessions_pool);
+  apr_hash_clear(cb->readaheads);
+  *done = TRUE;
+
+  return svn_error_trace(err);
+}
+
+/* --- CHECKOUT REPORTER IMPLEMENTATION ---
+ *
+ * A fresh checkout reports nothing but an empty root.  This reporter
+ * holds that report back and splits the checkout at the top-level
+ * directories when it gets finished.  Any other report makes it fall
+ * back to a plain update.
+ */
+
+static svn_error_t *checkout_set_path(void *baton, const char *path,
+                                      svn_revnum_t rev,
+                                      svn_depth_t depth,
+                                      svn_boolean_t start_empty,
+                                      const char *lock_token,
+                                      apr_pool_t *pool)
+{
+  checkout_baton_t *cb = baton;
+
+  if (!cb->plain && !cb->reported && *path == '\0'
+      && depth == svn_depth_infinity && start_empty && !lock_token)
+    {
+      cb->reported = TRUE;
+      cb->report_rev = rev;
+      return SVN_NO_ERROR;
+    }
+
+  if (!cb->plain)
+    SVN_ERR(checkout_start_plain(cb, pool));
+
+  return svn_error_trace(ra_svn_set_path(cb->plain, path, rev, depth,
+                                         start_empty, lock_token, pool));
+}
+
+static svn_error_t *checkout_delete_path(void *baton, const char *path,
+                                         apr_pool_t *pool)
+{
+  checkout_baton_t *cb = baton;
+
+  if (!cb->plain)
+    SVN_ERR(checkout_start_plain(cb, pool));
+
+  return svn_error_trace(ra_svn_delete_path(cb->plain, path, pool));
+}
+
+static svn_error_t *checkout_link_path(void *baton, const char *path,
+                                       const char *url,
+                                       svn_revnum_t rev,
+                                       svn_depth_t depth,
+                                       svn_boolean_t start_empty,
+                                       const char *lock_token,
+                                       apr_pool_t *pool)
+{
+  checkout_baton_t *cb = baton;
+
+  if (!cb->plain)
+    SVN_ERR(checkout_start_plain(cb, pool));
+
+  return svn_error_trace(ra_svn_link_path(cb->plain, path, url, rev, depth,
+                                          start_empty, lock_token, pool));
+}
+
+static svn_error_t *checkout_finish_report(void *baton,
+                                           apr_pool_t *pool)
+{
+  checkout_baton_t *cb = baton;
+
+  if (!cb->plain && cb->reported)
+    {
+      svn_boolean_t done;
+
+      SVN_ERR(checkout_split(&done, cb, pool));
+      if (done)
+        return SVN_NO_ERROR;
+    }
+
+  if (!cb->plain)
+    SVN_ERR(checkout_start_plain(cb, pool));
+
+  return svn_error_trace(ra_svn_finish_report(cb->plain, pool));
+}
+
+static svn_error_t *checkout_abort_report(void *baton,
+                                          apr_pool_t *pool)
+{
+  checkout_baton_t *cb = baton;
+
+  /* Nothing has been sent, yet? */
+  if (!cb->plain)
+    return SVN_NO_ERROR;
+
+  return svn_error_trace(ra_svn_abort_report(cb->plain, pool));
+}
+
+static svn_ra_reporter3_t checkout_reporter = {
+  checkout_set_path,
+  checkout_delete_path,
+  checkout_link_path,
+  checkout_finish_report,
+  checkout_abort_report
+};
+
+static svn_error_t *ra_svn_update(svn_ra_session_t *session,
+                                  const svn_ra_reporter3_t **reporter,
+                                  void **report_baton, svn_revnum_t rev,
+                                  const char *target, svn_depth_t depth,
+                                  svn_boolean_t send_copyfrom_args,
+                                  svn_boolean_t ignore_ancestry,
+                                  const svn_delta_editor_t *update_editor,
+                                  void *update_baton,
+                                  apr_pool_t *pool,
+                                  apr_pool_t *scratch_pool)
+{
+  svn_ra_svn__session_baton_t *sess_baton = session->priv;
+  svn_ra_svn_conn_t *conn = sess_baton->conn;
+  svn_boolean_t recurse = DEPTH_TO_RECURSE(depth);
+  int max_connections;
+
+  /* Callbacks may assume that all data is relative the sessions's URL. */
+  SVN_ERR(ensure_exact_server_parent(session, scratch_pool));
+
+  /* Checkouts may get split into several updates running in parallel.
+     Don't do that for tunnels, which would have to spawn more agents. */
+  max_connections = get_max_connections(sess_baton, scratch_pool);
+  if (*target == '\0' && depth == svn_depth_infinity
+      && max_connections > 1 && !sess_baton->is_tunneled
+      && svn_ra_svn_has_capability(conn, SVN_RA_SVN_CAP_DEPTH))
+    {
+      checkout_baton_t *cb = apr_pcalloc(pool, sizeof(*cb));
+
+      cb->session = session;
+      cb->rev = rev;
+      cb->send_copyfrom_args = send_copyfrom_args;
+      cb->ignore_ancestry = ignore_ancestry;
+      cb->editor = update_editor;
+      cb->edit_baton = update_baton;
+      cb->max_sessions = max_connections - 1;
+      cb->idle = apr_array_make(pool, cb->max_sessions,
+                                sizeof(svn_ra_session_t *));
+      cb->readaheads = apr_hash_make(pool);
+      cb->subtrees = apr_array_make(pool, 16, sizeof(checkout_subtree_t *));
+      cb->by_name = apr_hash_make(pool);
+      cb->pool = pool;
+
+      *reporter = &checkout_reporter;
+      *report_baton = cb;
+
+      return SVN_NO_ERROR;
+    }
+
+  /* Tell the server we want to start an update. */
+  SVN_ERR(svn_ra_svn__write_cmd_update(conn, pool, rev, target, recurse,
+                                       depth, send_copyfrom_args,
+                                       ignore_ancestry));
+  SVN_ERR(handle_auth_request(sess_baton, pool));
+
+  /* Fetch a reporter for the caller to drive.  The reporter will drive
+   * update_editor upon finish_report(). */
+  SVN_ERR(ra_svn_get_reporter(sess_baton, pool, update_editor, update_baton,
+                              target, depth, reporter, report_baton));
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+ra_svn_switch(svn_ra_session_t *session,
+              const svn_ra_reporter3_t **reporter,
+              void **report_baton, svn_revnum_t rev,
+              const char *target, svn_depth_t depth,
+              const char *switch_url,
+              svn_boolean_t send_copyfrom_args,
+              svn_boolean_t ignore_ancestry,
+              const svn_delta_editor_t *update_editor,
+              void *update_baton,
+              apr_pool_t *result_pool,
+              apr_pool_t *scratch_pool)
+{
+  apr_pool_t *pool = result_pool;
+  svn_ra_svn__session_baton_t *sess_baton = session->priv;
+  svn_ra_svn_conn_t *conn = sess_baton->conn;
+  svn_boolean_t recurse = DEPTH_TO_RECURSE(depth);
+
+  /* Callbacks may assume that all data is relative the sessions's URL. */
+  SVN_ERR(ensure_exact_server_parent(session, scratch_pool));
+
+  /* Tell the server we want to start a switch. */
+  SVN_ERR(svn_ra_svn__write_cmd_switch(conn, pool, rev, target, recurse,
+                                       switch_url, depth,
+                                       send_copyfrom_args, ignore_ancestry));
+  SVN_ERR(handle_auth_request(sess_baton, pool));
+
+  /* Fetch a reporter for the caller to drive.  The reporter will drive
+   * update_editor upon finish_report(). */
+  SVN_ERR(ra_svn_get_reporter(sess_baton, pool, update_editor, update_baton,
+                              target, depth, reporter, report_baton));
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *ra_svn_status(svn_ra_session_t *session,
+                                  const svn_ra_reporter3_t **reporter,
+                                  void **report_baton,
+                                  const char *target, svn_revnum_t rev,
+                                  svn_depth_t depth,
+                                  const svn_delta_editor_t *status_editor,
+                                  void *status_baton, apr_pool_t *pool)
+{
+  svn_ra_svn__session_baton_t *sess_baton = session->priv;
+  svn_ra_svn_conn_t *conn = sess_baton->conn;
+  svn_boolean_t recurse = DEPTH_TO_RECURSE(depth);
+
+  /* Callbacks may assume that all data is relative the sessions's URL. */
+  SVN_ERR(ensure_exact_server_parent(session, pool));
+
+  /* Tell the server we want to start a status operation. */
+  SVN_ERR(svn_ra_svn__write_cmd_status(conn, pool, target, recurse, rev,
+                                       depth));
+  SVN_ERR(handle_auth_request(sess_baton, pool));
+
+  /* Fetch a reporter for the caller to drive.  The reporter will drive
+   * status_editor upon finish_report(). */
+  SVN_ERR(ra_svn_get_reporter(sess_baton, pool, status_editor, status_baton,
+                              target, depth, reporter, report_baton));
   return SVN_NO_ERROR;
 }
 
@@ -2133,20 +3487,22 @@ static svn_error_t *handle_unsupported_cmd(svn_error_t *err,
 }
 
 
-static svn_error_t *ra_svn_stat(svn_ra_session_t *session,
-                                const char *path, svn_revnum_t rev,
-                                svn_dirent_t **dirent, apr_pool_t *pool)
+/* Read the response to a 'stat' command from SESS and return the result
+   in *DIRENT, allocated in RESULT_POOL.  Use SCRATCH_POOL for temporary
+   allocations. */
+static svn_error_t *
+read_stat_response(svn_dirent_t **dirent,
+                   svn_ra_svn__session_baton_t *sess,
+                   apr_pool_t *result_pool,
+                   apr_pool_t *scratch_pool)
 {
-  svn_ra_svn__session_baton_t *sess_baton = session->priv;
-  svn_ra_svn_conn_t *conn = sess_baton->conn;
   svn_ra_svn__list_t *list = NULL;
   svn_dirent_t *the_dirent;
 
-  path = reparent_path(session, path, pool);
-  SVN_ERR(svn_ra_svn__write_cmd_stat(conn, pool, path, rev));
-  SVN_ERR(handle_unsupported_cmd(handle_auth_request(sess_baton, pool),
+  SVN_ERR(handle_unsupported_cmd(handle_auth_request(sess, scratch_pool),
                                  N_("'stat' not implemented")));
-  SVN_ERR(svn_ra_svn__read_cmd_response(conn, pool, "(?l)", &list));
+  SVN_ERR(svn_ra_svn__read_cmd_response(sess->conn, scratch_pool, "(?l)",
+                                        &list));
 
   if (! list)
     {
@@ -2163,13 +3519,13 @@ static svn_error_t *ra_svn_stat(svn_ra_session_t *session,
                                       &kind, &size, &has_props,
                                       &crev, &cdate, &cauthor));
 
-      the_dirent = svn_dirent_create(pool);
+      the_dirent = svn_dirent_create(result_pool);
       the_dirent->kind = svn_node_kind_from_word(kind);
       the_dirent->size = size;/* FIXME: svn_filesize_t */
       the_dirent->has_props = has_props;
       the_dirent->created_rev = crev;
-      SVN_ERR(svn_time_from_cstring(&the_dirent->time, cdate, pool));
-      the_dirent->last_author = cauthor;
+      SVN_ERR(svn_time_from_cstring(&the_dirent->time, cdate, scratch_pool));
+      the_dirent->last_author = apr_pstrdup(result_pool, cauthor);
 
       *dirent = the_dirent;
     }
@@ -2177,6 +3533,293 @@ static svn_error_t *ra_svn_stat(svn_ra_session_t *session,
   return SVN_NO_ERROR;
 }
 
+static svn_error_t *ra_svn_stat(svn_ra_session_t *session,
+                                const char *path, svn_revnum_t rev,
+                                svn_dirent_t **dirent, apr_pool_t *pool)
+{
+  svn_ra_svn__session_baton_t *sess_baton = session->priv;
+  svn_ra_svn_conn_t *conn = sess_baton->conn;
+
+  path = reparent_path(session, path, pool);
+  SVN_ERR(svn_ra_svn__write_cmd_stat(conn, pool, path, rev));
+  SVN_ERR(read_stat_response(dirent, sess_baton, pool, pool));
+
+  return SVN_NO_ERROR;
+}
+
+
+/* --- PIPELINED COMMANDS --- */
+
+/* Maximum number of commands that we send ahead of their responses.
+   The server replies while we are still sending.  Don't let the
+   responses pile up beyond what the socket buffers can hold or both
+   sides might block on their writes. */
+#define PIPELINE_WINDOW 32
+
+/* Callback type used by pipeline().  Send the I-th request resp. read
+   the I-th response for SESSION.  BATON is the pipeline()'s BATON. */
+typedef svn_error_t *(*pipeline_func_t)(svn_ra_session_t *session,
+                                        int i,
+                                        void *baton,
+                                        apr_pool_t *scratch_pool);
+
+/* Process COUNT independent commands on SESSION.  Use SEND_REQUEST to
+   write them and READ_RESPONSE to process the responses, in the same
+   order.  If the server supports it, send up to PIPELINE_WINDOW commands
+   before reading the first response.  Use SCRATCH_POOL for temporary
+   allocations. */
+static svn_error_t *
+pipeline(svn_ra_session_t *session,
+         int count,
+         pipeline_func_t send_request,
+         pipeline_func_t read_response,
+         void *baton,
+         apr_pool_t *scratch_pool)
+{
+  svn_ra_svn__session_baton_t *sess = session->priv;
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  int window = 1;
+  int sent = 0;
+  int received;
+
+  if (sess->auth_settled
+      && svn_ra_svn_has_capability(sess->conn, SVN_RA_SVN_CAP_PIPELINING))
+    window = PIPELINE_WINDOW;
+
+  for (received = 0; received < count; received++)
+    {
+      svn_error_t *err;
+
+      svn_pool_clear(iterpool);
+
+      /* Requests get buffered and will be sent as soon as we wait for
+         the next response. */
+      for (; sent < count && sent - received < window; sent++)
+        SVN_ERR(send_request(session, sent, baton, iterpool));
+
+      err = read_response(session, received, baton, iterpool);
+      if (err)
+        {
+          /* Drain the responses to the commands still in flight to keep
+             the connection usable. */
+          for (received++; received < sent; received++)
+            {
+              svn_error_t *err2;
+
+              svn_pool_clear(iterpool);
+              err2 = handle_auth_request(sess, iterpool);
+              if (!err2)
+                err2 = svn_ra_svn__read_cmd_response(sess->conn, iterpool,
+                                                     "");
+              svn_error_clear(err2);
+            }
+
+          svn_pool_destroy(iterpool);
+          return svn_error_trace(err);
+        }
+    }
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Baton type used with pipeline() by ra_svn_check_paths,
+   ra_svn_get_dirs and ra_svn_rev_proplists. */
+typedef struct paths_baton_t
+{
+  /* Paths and revisions of the requests.  PATHS is NULL for
+     revision-only requests. */
+  const apr_array_header_t *paths;
+  const apr_array_header_t *revisions;
+
+  /* Results array to append to. */
+  apr_array_header_t *results;
+  apr_pool_t *result_pool;
+} paths_baton_t;
+
+/* Implements pipeline_func_t. */
+static svn_error_t *
+send_check_path(svn_ra_session_t *session,
+                int i,
+                void *baton,
+                apr_pool_t *scratch_pool)
+{
+  svn_ra_svn__session_baton_t *sess = session->priv;
+  paths_baton_t *b = baton;
+  const char *path = APR_ARRAY_IDX(b->paths, i, const char *);
+
+  path = reparent_path(session, path, scratch_pool);
+  return svn_error_trace(svn_ra_svn__write_cmd_check_path(
+                            sess->conn, scratch_pool, path,
+                            APR_ARRAY_IDX(b->revisions, i, svn_revnum_t)));
+}
+
+/* Implements pipeline_func_t. */
+static svn_error_t *
+read_check_path(svn_ra_session_t *session,
+                int i,
+                void *baton,
+                apr_pool_t *scratch_pool)
+{
+  svn_ra_svn__session_baton_t *sess = session->priv;
+  paths_baton_t *b = baton;
+  const char *kind_word;
+
+  SVN_ERR(handle_auth_request(sess, scratch_pool));
+  SVN_ERR(svn_ra_svn__read_cmd_response(sess->conn, scratch_pool, "w",
+                                        &kind_word));
+  APR_ARRAY_PUSH(b->results, svn_node_kind_t)
+    = svn_node_kind_from_word(kind_word);
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+ra_svn_check_paths(svn_ra_session_t *session,
+                   apr_array_header_t **kinds,
+                   const apr_array_header_t *paths,
+                   const apr_array_header_t *revisions,
+                   apr_pool_t *result_pool,
+                   apr_pool_t *scratch_pool)
+{
+  paths_baton_t baton;
+
+  baton.paths = paths;
+  baton.revisions = revisions;
+  baton.results = apr_array_make(result_pool, paths->nelts,
+                                 sizeof(svn_node_kind_t));
+  baton.result_pool = result_pool;
+
+  SVN_ERR(pipeline(session, paths->nelts, send_check_path, read_check_path,
+                   &baton, scratch_pool));
+  *kinds = baton.results;
+
+  return SVN_NO_ERROR;
+}
+
+/* Baton type used with pipeline() by ra_svn_get_dirs. */
+typedef struct get_dirs_baton_t
+{
+  paths_baton_t pb;
+  apr_uint32_t dirent_fields;
+} get_dirs_baton_t;
+
+/* Implements pipeline_func_t. */
+static svn_error_t *
+send_get_dir(svn_ra_session_t *session,
+             int i,
+             void *baton,
+             apr_pool_t *scratch_pool)
+{
+  get_dirs_baton_t *b = baton;
+
+  return svn_error_trace(write_get_dir(
+                            session,
+                            APR_ARRAY_IDX(b->pb.paths, i, const char *),
+                            APR_ARRAY_IDX(b->pb.revisions, i, svn_revnum_t),
+                            FALSE, TRUE, b->dirent_fields, scratch_pool));
+}
+
+/* Implements pipeline_func_t. */
+static svn_error_t *
+read_get_dir(svn_ra_session_t *session,
+             int i,
+             void *baton,
+             apr_pool_t *scratch_pool)
+{
+  get_dirs_baton_t *b = baton;
+
+  SVN_ERR(read_get_dir_response(&APR_ARRAY_PUSH(b->pb.results, apr_hash_t *),
+                                NULL, NULL, session->priv,
+                                b->pb.result_pool));
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+ra_svn_get_dirs(svn_ra_session_t *session,
+                apr_array_header_t **dirents,
+                const apr_array_header_t *paths,
+                const apr_array_header_t *revisions,
+                apr_uint32_t dirent_fields,
+                apr_pool_t *result_pool,
+                apr_pool_t *scratch_pool)
+{
+  get_dirs_baton_t baton;
+
+  baton.pb.paths = paths;
+  baton.pb.revisions = revisions;
+  baton.pb.results = apr_array_make(result_pool, paths->nelts,
+                                    sizeof(apr_hash_t *));
+  baton.pb.result_pool = result_pool;
+  baton.dirent_fields = dirent_fields;
+
+  SVN_ERR(pipeline(session, paths->nelts, send_get_dir, read_get_dir,
+                   &baton, scratch_pool));
+  *dirents = baton.pb.results;
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements pipeline_func_t. */
+static svn_error_t *
+send_rev_proplist(svn_ra_session_t *session,
+                  int i,
+                  void *baton,
+                  apr_pool_t *scratch_pool)
+{
+  svn_ra_svn__session_baton_t *sess = session->priv;
+  paths_baton_t *b = baton;
+
+  return svn_error_trace(svn_ra_svn__write_cmd_rev_proplist(
+                            sess->conn, scratch_pool,
+                            APR_ARRAY_IDX(b->revisions, i, svn_revnum_t)));
+}
+
+/* Implements pipeline_func_t. */
+static svn_error_t *
+read_rev_proplist(svn_ra_session_t *session,
+                  int i,
+                  void *baton,
+                  apr_pool_t *scratch_pool)
+{
+  svn_ra_svn__session_baton_t *sess = session->priv;
+  paths_baton_t *b = baton;
+  svn_ra_svn__list_t *proplist;
+
+  SVN_ERR(handle_auth_request(sess, scratch_pool));
+  SVN_ERR(svn_ra_svn__read_cmd_response(sess->conn, scratch_pool, "l",
+                                        &proplist));
+  SVN_ERR(svn_ra_svn__parse_proplist(proplist, b->result_pool,
+                                     &APR_ARRAY_PUSH(b->results,
+                                                     apr_hash_t *)));
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+ra_svn_rev_proplists(svn_ra_session_t *session,
+                     apr_array_header_t **props,
+                     const apr_array_header_t *revisions,
+                     apr_pool_t *result_pool,
+                     apr_pool_t *scratch_pool)
+{
+  paths_baton_t baton;
+
+  baton.paths = NULL;
+  baton.revisions = revisions;
+  baton.results = apr_array_make(result_pool, revisions->nelts,
+                                 sizeof(apr_hash_t *));
+  baton.result_pool = result_pool;
+
+  SVN_ERR(pipeline(session, revisions->nelts, send_rev_proplist,
+                   read_rev_proplist, &baton, scratch_pool));
+  *props = baton.results;
+
+  return SVN_NO_ERROR;
+}
+
 
 static svn_error_t *ra_svn_get_locations(svn_ra_session_t *session,
                                          apr_hash_t **locations,
@@ -3284,7 +4927,10 @@ static const svn_ra__vtable_t ra_svn_vtable = {
   ra_svn_list,
   ra_svn_register_editor_shim_callbacks,
   NULL /* commit_ev2 */,
-  NULL /* replay_range_ev2 */
+  NULL /* replay_range_ev2 */,
+  ra_svn_check_paths,
+  ra_svn_get_dirs,
+  ra_svn_rev_proplists
 };
 
 svn_error_t *
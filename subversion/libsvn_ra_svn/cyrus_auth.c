@@ -704,11 +704,20 @@ static void sasl_timeout_cb(void *baton, apr_interval_time_t interval)
   svn_ra_svn__stream_timeout(sasl_baton->stream, interval);
 }
 
-/* Implements svn_stream_data_available_fn_t. */
+/* Implements svn_stream_data_available_fn_t.  A single SASL packet may
+   decode to more data than the caller read, i.e. there may be data left
+   in our read buffer while the socket has been drained already. */
 static svn_error_t *
 sasl_data_available_cb(void *baton, svn_boolean_t *data_available)
 {
   sasl_baton_t *sasl_baton = baton;
+
+  if (sasl_baton->read_buf && sasl_baton->read_len > 0)
+    {
+      *data_available = TRUE;
+      return SVN_NO_ERROR;
+    }
+
   return svn_error_trace(svn_ra_svn__stream_data_available(sasl_baton->stream,
                                                          data_available));
 }
@@ -784,6 +793,9 @@ svn_error_t *svn_ra_svn__enable_sasl_encryption(svn_ra_svn_conn_t *conn,
           }
           /* Yay, we have a security layer! */
           conn->encrypted = TRUE;
+
+          /* All data must pass through that layer from now on. */
+          conn->sendfile_sock = NULL;
         }
     }
   return SVN_NO_ERROR;
@@ -528,15 +528,30 @@ static void remove_token(ra_svn_driver_state_t *ds,
   ds->last_token = NULL;
 }
 
+/* Parameters of an editor command.  They are decoded straight from the
+   network into this struct, according to the command's field table in
+   ra_svn_edit_cmds.  Members not used by a command remain undefined. */
+typedef struct edit_params_t
+{
+  const char *path;
+  svn_string_t *token;
+  svn_string_t *child_token;
+  const char *copy_path;
+  svn_revnum_t rev;
+  const char *name;
+  svn_string_t *value;
+  const char *checksum;
+} edit_params_t;
+
 static svn_error_t *
 ra_svn_handle_target_rev(svn_ra_svn_conn_t *conn,
                          apr_pool_t *pool,
-                         const svn_ra_svn__list_t *params,
+                         const edit_params_t *params,
                          ra_svn_driver_state_t *ds)
 {
   svn_revnum_t rev;
 
-  SVN_ERR(svn_ra_svn__parse_tuple(params, "r", &rev));
+  rev = params->rev;
   SVN_CMD_ERR(ds->editor->set_target_revision(ds->edit_baton, rev, pool));
   return SVN_NO_ERROR;
 }
@@ -544,7 +559,7 @@ ra_svn_handle_target_rev(svn_ra_svn_conn_t *conn,
 static svn_error_t *
 ra_svn_handle_open_root(svn_ra_svn_conn_t *conn,
                         apr_pool_t *pool,
-                        const svn_ra_svn__list_t *params,
+                        const edit_params_t *params,
                         ra_svn_driver_state_t *ds)
 {
   svn_revnum_t rev;
@@ -552,7 +567,8 @@ ra_svn_handle_open_root(svn_ra_svn_conn_t *conn,
   svn_string_t *token;
   void *root_baton;
 
-  SVN_ERR(svn_ra_svn__parse_tuple(params, "(?r)s", &rev, &token));
+  rev = params->rev;
+  token = params->token;
   subpool = svn_pool_create(ds->pool);
   SVN_CMD_ERR(ds->editor->open_root(ds->edit_baton, rev, subpool,
                                     &root_baton));
@@ -563,7 +579,7 @@ ra_svn_handle_open_root(svn_ra_svn_conn_t *conn,
 static svn_error_t *
 ra_svn_handle_delete_entry(svn_ra_svn_conn_t *conn,
                            apr_pool_t *pool,
-                           const svn_ra_svn__list_t *params,
+                           const edit_params_t *params,
                            ra_svn_driver_state_t *ds)
 {
   const char *path;
@@ -571,8 +587,9 @@ ra_svn_handle_delete_entry(svn_ra_svn_conn_t *conn,
   svn_revnum_t rev;
   ra_svn_token_entry_t *entry;
 
-  SVN_ERR(svn_ra_svn__parse_tuple(params, "c(?r)s",
-                                  &path, &rev, &token));
+  path = params->path;
+  rev = params->rev;
+  token = params->token;
   SVN_ERR(lookup_token(ds, token, FALSE, &entry));
   path = svn_relpath_canonicalize(path, pool);
   SVN_CMD_ERR(ds->editor->delete_entry(path, rev, entry->baton, pool));
@@ -582,7 +599,7 @@ ra_svn_handle_delete_entry(svn_ra_svn_conn_t *conn,
 static svn_error_t *
 ra_svn_handle_add_dir(svn_ra_svn_conn_t *conn,
                       apr_pool_t *pool,
-                      const svn_ra_svn__list_t *params,
+                      const edit_params_t *params,
                       ra_svn_driver_state_t *ds)
 {
   const char *path, *copy_path;
@@ -592,8 +609,11 @@ ra_svn_handle_add_dir(svn_ra_svn_conn_t *conn,
   apr_pool_t *subpool;
   void *child_baton;
 
-  SVN_ERR(svn_ra_svn__parse_tuple(params, "css(?cr)", &path, &token,
-                                  &child_token, &copy_path, &copy_rev));
+  path = params->path;
+  token = params->token;
+  child_token = params->child_token;
+  copy_path = params->copy_path;
+  copy_rev = params->rev;
   SVN_ERR(lookup_token(ds, token, FALSE, &entry));
   subpool = svn_pool_create(entry->pool);
   path = svn_relpath_canonicalize(path, pool);
@@ -617,7 +637,7 @@ ra_svn_handle_add_dir(svn_ra_svn_conn_t *conn,
 static svn_error_t *
 ra_svn_handle_open_dir(svn_ra_svn_conn_t *conn,
                        apr_pool_t *pool,
-                       const svn_ra_svn__list_t *params,
+                       const edit_params_t *params,
                        ra_svn_driver_state_t *ds)
 {
   const char *path;
@@ -627,8 +647,10 @@ ra_svn_handle_open_dir(svn_ra_svn_conn_t *conn,
   apr_pool_t *subpool;
   void *child_baton;
 
-  SVN_ERR(svn_ra_svn__parse_tuple(params, "css(?r)", &path, &token,
-                                  &child_token, &rev));
+  path = params->path;
+  token = params->token;
+  child_token = params->child_token;
+  rev = params->rev;
   SVN_ERR(lookup_token(ds, token, FALSE, &entry));
   subpool = svn_pool_create(entry->pool);
   path = svn_relpath_canonicalize(path, pool);
@@ -641,7 +663,7 @@ ra_svn_handle_open_dir(svn_ra_svn_conn_t *conn,
 static svn_error_t *
 ra_svn_handle_change_dir_prop(svn_ra_svn_conn_t *conn,
                               apr_pool_t *pool,
-                              const svn_ra_svn__list_t *params,
+                              const edit_params_t *params,
                               ra_svn_driver_state_t *ds)
 {
   svn_string_t *token;
@@ -649,8 +671,9 @@ ra_svn_handle_change_dir_prop(svn_ra_svn_conn_t *conn,
   svn_string_t *value;
   ra_svn_token_entry_t *entry;
 
-  SVN_ERR(svn_ra_svn__parse_tuple(params, "sc(?s)", &token, &name,
-                                  &value));
+  token = params->token;
+  name = params->name;
+  value = params->value;
   SVN_ERR(lookup_token(ds, token, FALSE, &entry));
   SVN_CMD_ERR(ds->editor->change_dir_prop(entry->baton, name, value,
                                           entry->pool));
@@ -660,14 +683,14 @@ ra_svn_handle_change_dir_prop(svn_ra_svn_conn_t *conn,
 static svn_error_t *
 ra_svn_handle_close_dir(svn_ra_svn_conn_t *conn,
                         apr_pool_t *pool,
-                        const svn_ra_svn__list_t *params,
+                        const edit_params_t *params,
                         ra_svn_driver_state_t *ds)
 {
   svn_string_t *token;
   ra_svn_token_entry_t *entry;
 
   /* Parse and look up the directory token. */
-  SVN_ERR(svn_ra_svn__parse_tuple(params, "s", &token));
+  token = params->token;
   SVN_ERR(lookup_token(ds, token, FALSE, &entry));
 
   /* Close the directory and destroy the baton. */
@@ -680,7 +703,7 @@ ra_svn_handle_close_dir(svn_ra_svn_conn_t *conn,
 static svn_error_t *
 ra_svn_handle_absent_dir(svn_ra_svn_conn_t *conn,
                          apr_pool_t *pool,
-                         const svn_ra_svn__list_t *params,
+                         const edit_params_t *params,
                          ra_svn_driver_state_t *ds)
 {
   const char *path;
@@ -688,7 +711,8 @@ ra_svn_handle_absent_dir(svn_ra_svn_conn_t *conn,
   ra_svn_token_entry_t *entry;
 
   /* Parse parameters and look up the directory token. */
-  SVN_ERR(svn_ra_svn__parse_tuple(params, "cs", &path, &token));
+  path = params->path;
+  token = params->token;
   SVN_ERR(lookup_token(ds, token, FALSE, &entry));
 
   /* Call the editor. */
@@ -699,7 +723,7 @@ ra_svn_handle_absent_dir(svn_ra_svn_conn_t *conn,
 static svn_error_t *
 ra_svn_handle_add_file(svn_ra_svn_conn_t *conn,
                        apr_pool_t *pool,
-                       const svn_ra_svn__list_t *params,
+                       const edit_params_t *params,
                        ra_svn_driver_state_t *ds)
 {
   const char *path, *copy_path;
@@ -707,8 +731,11 @@ ra_svn_handle_add_file(svn_ra_svn_conn_t *conn,
   svn_revnum_t copy_rev;
   ra_svn_token_entry_t *entry, *file_entry;
 
-  SVN_ERR(svn_ra_svn__parse_tuple(params, "css(?cr)", &path, &token,
-                                  &file_token, &copy_path, &copy_rev));
+  path = params->path;
+  token = params->token;
+  file_token = params->child_token;
+  copy_path = params->copy_path;
+  copy_rev = params->rev;
   SVN_ERR(lookup_token(ds, token, FALSE, &entry));
   ds->file_refs++;
 
@@ -735,7 +762,7 @@ ra_svn_handle_add_file(svn_ra_svn_conn_t *conn,
 static svn_error_t *
 ra_svn_handle_open_file(svn_ra_svn_conn_t *conn,
                         apr_pool_t *pool,
-                        const svn_ra_svn__list_t *params,
+                        const edit_params_t *params,
                         ra_svn_driver_state_t *ds)
 {
   const char *path;
@@ -743,8 +770,10 @@ ra_svn_handle_open_file(svn_ra_svn_conn_t *conn,
   svn_revnum_t rev;
   ra_svn_token_entry_t *entry, *file_entry;
 
-  SVN_ERR(svn_ra_svn__parse_tuple(params, "css(?r)", &path, &token,
-                                  &file_token, &rev));
+  path = params->path;
+  token = params->token;
+  file_token = params->child_token;
+  rev = params->rev;
   SVN_ERR(lookup_token(ds, token, FALSE, &entry));
   ds->file_refs++;
 
@@ -761,18 +790,18 @@ ra_svn_handle_open_file(svn_ra_svn_conn_t *conn,
 static svn_error_t *
 ra_svn_handle_apply_textdelta(svn_ra_svn_conn_t *conn,
                               apr_pool_t *pool,
-                              const svn_ra_svn__list_t *params,
+                              const edit_params_t *params,
                               ra_svn_driver_state_t *ds)
 {
   svn_string_t *token;
   ra_svn_token_entry_t *entry;
   svn_txdelta_window_handler_t wh;
   void *wh_baton;
-  char *base_checksum;
+  const char *base_checksum;
 
   /* Parse arguments and look up the token. */
-  SVN_ERR(svn_ra_svn__parse_tuple(params, "s(?c)",
-                                  &token, &base_checksum));
+  token = params->token;
+  base_checksum = params->checksum;
   SVN_ERR(lookup_token(ds, token, TRUE, &entry));
   if (entry->dstream)
     return svn_error_create(SVN_ERR_RA_SVN_MALFORMED_DATA, NULL,
@@ -787,7 +816,7 @@ ra_svn_handle_apply_textdelta(svn_ra_svn_conn_t *conn,
 static svn_error_t *
 ra_svn_handle_textdelta_chunk(svn_ra_svn_conn_t *conn,
                               apr_pool_t *pool,
-                              const svn_ra_svn__list_t *params,
+                              const edit_params_t *params,
                               ra_svn_driver_state_t *ds)
 {
   svn_string_t *token;
@@ -795,7 +824,8 @@ ra_svn_handle_textdelta_chunk(svn_ra_svn_conn_t *conn,
   svn_string_t *str;
 
   /* Parse arguments and look up the token. */
-  SVN_ERR(svn_ra_svn__parse_tuple(params, "ss", &token, &str));
+  token = params->token;
+  str = params->value;
   SVN_ERR(lookup_token(ds, token, TRUE, &entry));
   if (!entry->dstream)
     return svn_error_create(SVN_ERR_RA_SVN_MALFORMED_DATA, NULL,
@@ -807,14 +837,14 @@ ra_svn_handle_textdelta_chunk(svn_ra_svn_conn_t *conn,
 static svn_error_t *
 ra_svn_handle_textdelta_end(svn_ra_svn_conn_t *conn,
                             apr_pool_t *pool,
-                            const svn_ra_svn__list_t *params,
+                            const edit_params_t *params,
                             ra_svn_driver_state_t *ds)
 {
   svn_string_t *token;
   ra_svn_token_entry_t *entry;
 
   /* Parse arguments and look up the token. */
-  SVN_ERR(svn_ra_svn__parse_tuple(params, "s", &token));
+  token = params->token;
   SVN_ERR(lookup_token(ds, token, TRUE, &entry));
   if (!entry->dstream)
     return svn_error_create(SVN_ERR_RA_SVN_MALFORMED_DATA, NULL,
@@ -828,15 +858,16 @@ ra_svn_handle_textdelta_end(svn_ra_svn_conn_t *conn,
 static svn_error_t *
 ra_svn_handle_change_file_prop(svn_ra_svn_conn_t *conn,
                                apr_pool_t *pool,
-                               const svn_ra_svn__list_t *params,
+                               const edit_params_t *params,
                                ra_svn_driver_state_t *ds)
 {
   const char *name;
   svn_string_t *token, *value;
   ra_svn_token_entry_t *entry;
 
-  SVN_ERR(svn_ra_svn__parse_tuple(params, "sc(?s)", &token, &name,
-                                  &value));
+  token = params->token;
+  name = params->name;
+  value = params->value;
   SVN_ERR(lookup_token(ds, token, TRUE, &entry));
   SVN_CMD_ERR(ds->editor->change_file_prop(entry->baton, name, value, pool));
   return SVN_NO_ERROR;
@@ -845,7 +876,7 @@ ra_svn_handle_change_file_prop(svn_ra_svn_conn_t *conn,
 static svn_error_t *
 ra_svn_handle_close_file(svn_ra_svn_conn_t *conn,
                          apr_pool_t *pool,
-                         const svn_ra_svn__list_t *params,
+                         const edit_params_t *params,
                          ra_svn_driver_state_t *ds)
 {
   svn_string_t *token;
@@ -853,8 +884,8 @@ ra_svn_handle_close_file(svn_ra_svn_conn_t *conn,
   const char *text_checksum;
 
   /* Parse arguments and look up the file token. */
-  SVN_ERR(svn_ra_svn__parse_tuple(params, "s(?c)",
-                                  &token, &text_checksum));
+  token = params->token;
+  text_checksum = params->checksum;
   SVN_ERR(lookup_token(ds, token, TRUE, &entry));
 
   /* Close the file and destroy the baton. */
@@ -868,7 +899,7 @@ ra_svn_handle_close_file(svn_ra_svn_conn_t *conn,
 static svn_error_t *
 ra_svn_handle_absent_file(svn_ra_svn_conn_t *conn,
                           apr_pool_t *pool,
-                          const svn_ra_svn__list_t *params,
+                          const edit_params_t *params,
                           ra_svn_driver_state_t *ds)
 {
   const char *path;
@@ -876,7 +907,8 @@ ra_svn_handle_absent_file(svn_ra_svn_conn_t *conn,
   ra_svn_token_entry_t *entry;
 
   /* Parse parameters and look up the parent directory token. */
-  SVN_ERR(svn_ra_svn__parse_tuple(params, "cs", &path, &token));
+  path = params->path;
+  token = params->token;
   SVN_ERR(lookup_token(ds, token, FALSE, &entry));
 
   /* Call the editor. */
@@ -887,7 +919,7 @@ ra_svn_handle_absent_file(svn_ra_svn_conn_t *conn,
 static svn_error_t *
 ra_svn_handle_close_edit(svn_ra_svn_conn_t *conn,
                          apr_pool_t *pool,
-                         const svn_ra_svn__list_t *params,
+                         const edit_params_t *params,
                          ra_svn_driver_state_t *ds)
 {
   SVN_CMD_ERR(ds->editor->close_edit(ds->edit_baton, pool));
@@ -908,7 +940,7 @@ ra_svn_handle_close_edit(svn_ra_svn_conn_t *conn,
 static svn_error_t *
 ra_svn_handle_abort_edit(svn_ra_svn_conn_t *conn,
                          apr_pool_t *pool,
-                         const svn_ra_svn__list_t *params,
+                         const edit_params_t *params,
                          ra_svn_driver_state_t *ds)
 {
   ds->done = TRUE;
@@ -921,7 +953,7 @@ ra_svn_handle_abort_edit(svn_ra_svn_conn_t *conn,
 static svn_error_t *
 ra_svn_handle_finish_replay(svn_ra_svn_conn_t *conn,
                             apr_pool_t *pool,
-                            const svn_ra_svn__list_t *params,
+                            const edit_params_t *params,
                             ra_svn_driver_state_t *ds)
 {
   if (!ds->for_replay)
@@ -937,32 +969,104 @@ ra_svn_handle_finish_replay(svn_ra_svn_conn_t *conn,
 /* Common function signature for all editor command handlers. */
 typedef svn_error_t *(*cmd_handler_t)(svn_ra_svn_conn_t *conn,
                                       apr_pool_t *pool,
-                                      const svn_ra_svn__list_t *params,
+                                      const edit_params_t *params,
                                       ra_svn_driver_state_t *ds);
 
+/* Field tables describing the parameters of the editor commands.
+   They correspond to the following svn_ra_svn__parse_tuple formats. */
+#define FIELD(kind, member) { kind, APR_OFFSETOF(edit_params_t, member) }
+#define MARK(kind) { kind, 0 }
+
+/* "r" */
+static const svn_ra_svn__field_t rev_fields[] = {
+  FIELD('r', rev), MARK(0)
+};
+
+/* "(?r)s" */
+static const svn_ra_svn__field_t rev_token_fields[] = {
+  MARK('('), MARK('?'), FIELD('r', rev), MARK(')'), FIELD('s', token),
+  MARK(0)
+};
+
+/* "c(?r)s" */
+static const svn_ra_svn__field_t path_rev_token_fields[] = {
+  FIELD('c', path), MARK('('), MARK('?'), FIELD('r', rev), MARK(')'),
+  FIELD('s', token), MARK(0)
+};
+
+/* "css(?cr)" */
+static const svn_ra_svn__field_t add_fields[] = {
+  FIELD('c', path), FIELD('s', token), FIELD('s', child_token),
+  MARK('('), MARK('?'), FIELD('c', copy_path), FIELD('r', rev), MARK(')'),
+  MARK(0)
+};
+
+/* "css(?r)" */
+static const svn_ra_svn__field_t open_fields[] = {
+  FIELD('c', path), FIELD('s', token), FIELD('s', child_token),
+  MARK('('), MARK('?'), FIELD('r', rev), MARK(')'), MARK(0)
+};
+
+/* "sc(?s)" */
+static const svn_ra_svn__field_t prop_fields[] = {
+  FIELD('s', token), FIELD('c', name),
+  MARK('('), MARK('?'), FIELD('s', value), MARK(')'), MARK(0)
+};
+
+/* "s" */
+static const svn_ra_svn__field_t token_fields[] = {
+  FIELD('s', token), MARK(0)
+};
+
+/* "cs" */
+static const svn_ra_svn__field_t path_token_fields[] = {
+  FIELD('c', path), FIELD('s', token), MARK(0)
+};
+
+/* "s(?c)" */
+static const svn_ra_svn__field_t token_checksum_fields[] = {
+  FIELD('s', token), MARK('('), MARK('?'), FIELD('c', checksum), MARK(')'),
+  MARK(0)
+};
+
+/* "ss" */
+static const svn_ra_svn__field_t token_value_fields[] = {
+  FIELD('s', token), FIELD('s', value), MARK(0)
+};
+
+/* "" */
+static const svn_ra_svn__field_t no_fields[] = {
+  MARK(0)
+};
+
+#undef FIELD
+#undef MARK
+
 static const struct {
   const char *cmd;
+  const svn_ra_svn__field_t *fields;
   cmd_handler_t handler;
 } ra_svn_edit_cmds[] = {
-  { "change-file-prop", ra_svn_handle_change_file_prop },
-  { "open-file",        ra_svn_handle_open_file },
-  { "apply-textdelta",  ra_svn_handle_apply_textdelta },
-  { "textdelta-chunk",  ra_svn_handle_textdelta_chunk },
-  { "close-file",       ra_svn_handle_close_file },
-  { "add-dir",          ra_svn_handle_add_dir },
-  { "open-dir",         ra_svn_handle_open_dir },
-  { "change-dir-prop",  ra_svn_handle_change_dir_prop },
-  { "delete-entry",     ra_svn_handle_delete_entry },
-  { "close-dir",        ra_svn_handle_close_dir },
-  { "absent-dir",       ra_svn_handle_absent_dir },
-  { "add-file",         ra_svn_handle_add_file },
-  { "textdelta-end",    ra_svn_handle_textdelta_end },
-  { "absent-file",      ra_svn_handle_absent_file },
-  { "abort-edit",       ra_svn_handle_abort_edit },
-  { "finish-replay",    ra_svn_handle_finish_replay },
-  { "target-rev",       ra_svn_handle_target_rev },
-  { "open-root",        ra_svn_handle_open_root },
-  { "close-edit",       ra_svn_handle_close_edit },
+  { "change-file-prop", prop_fields, ra_svn_handle_change_file_prop },
+  { "open-file",        open_fields, ra_svn_handle_open_file },
+  { "apply-textdelta",  token_checksum_fields,
+                        ra_svn_handle_apply_textdelta },
+  { "textdelta-chunk",  token_value_fields, ra_svn_handle_textdelta_chunk },
+  { "close-file",       token_checksum_fields, ra_svn_handle_close_file },
+  { "add-dir",          add_fields, ra_svn_handle_add_dir },
+  { "open-dir",         open_fields, ra_svn_handle_open_dir },
+  { "change-dir-prop",  prop_fields, ra_svn_handle_change_dir_prop },
+  { "delete-entry",     path_rev_token_fields, ra_svn_handle_delete_entry },
+  { "close-dir",        token_fields, ra_svn_handle_close_dir },
+  { "absent-dir",       path_token_fields, ra_svn_handle_absent_dir },
+  { "add-file",         add_fields, ra_svn_handle_add_file },
+  { "textdelta-end",    token_fields, ra_svn_handle_textdelta_end },
+  { "absent-file",      path_token_fields, ra_svn_handle_absent_file },
+  { "abort-edit",       no_fields, ra_svn_handle_abort_edit },
+  { "finish-replay",    no_fields, ra_svn_handle_finish_replay },
+  { "target-rev",       rev_fields, ra_svn_handle_target_rev },
+  { "open-root",        rev_token_fields, ra_svn_handle_open_root },
+  { "close-edit",       no_fields, ra_svn_handle_close_edit },
   { NULL }
 };
 
@@ -972,6 +1076,7 @@ static const struct {
    It is similar to ra_svn_edit_cmds but uses our SVN string type. */
 typedef struct cmd_t {
   svn_string_t cmd;
+  const svn_ra_svn__field_t *fields;
   cmd_handler_t handler;
 } cmd_t;
 
@@ -1020,15 +1125,16 @@ init_cmd_hash(void *baton,
 
       cmd_hash[value].cmd.data = ra_svn_edit_cmds[i].cmd;
       cmd_hash[value].cmd.len = len;
+      cmd_hash[value].fields = ra_svn_edit_cmds[i].fields;
       cmd_hash[value].handler = ra_svn_edit_cmds[i].handler;
     }
 
   return SVN_NO_ERROR;
 }
 
-/* Return the command handler function for the command name CMD.
-   Return NULL if no such handler exists */
-static cmd_handler_t
+/* Return the hash table entry for the command name CMD.
+   Return NULL if no such command exists */
+static const cmd_t *
 cmd_lookup(const char *cmd)
 {
   apr_size_t value;
@@ -1049,7 +1155,7 @@ cmd_lookup(const char *cmd)
     return NULL;
 
   /* Yes! */
-  return cmd_hash[value].handler;
+  return &cmd_hash[value];
 }
 
 static svn_error_t *blocked_write(svn_ra_svn_conn_t *conn, apr_pool_t *pool,
@@ -1106,26 +1212,42 @@ svn_error_t *svn_ra_svn_drive_editor2(svn_ra_svn_conn_t *conn,
       svn_ra_svn__reset_command_io_counters(conn);
       if (editor)
         {
-          cmd_handler_t handler;
-          SVN_ERR(svn_ra_svn__read_tuple(conn, subpool, "wl", &cmd, &params));
-          handler = cmd_lookup(cmd);
+          const cmd_t *entry;
+          SVN_ERR(svn_ra_svn__read_command_start(conn, subpool, &cmd));
+          entry = cmd_lookup(cmd);
 
-          if (handler)
-            err = (*handler)(conn, subpool, params, &state);
+          if (entry)
+            {
+              /* Decode the parameters in place, without an item tree.
+                 Consume the whole command before executing it. */
+              edit_params_t edit_params;
+              SVN_ERR(svn_ra_svn__read_fields(conn, subpool, entry->fields,
+                                              &edit_params));
+              SVN_ERR(svn_ra_svn__read_tuple_end(conn, subpool));
+              err = entry->handler(conn, subpool, &edit_params, &state);
+            }
           else if (strcmp(cmd, "failure") == 0)
             {
+              svn_ra_svn__item_t *item;
+              SVN_ERR(svn_ra_svn__read_item(conn, subpool, &item));
+              SVN_ERR(svn_ra_svn__read_tuple_end(conn, subpool));
+              if (item->kind != SVN_RA_SVN_LIST)
+                return svn_error_create(SVN_ERR_RA_SVN_MALFORMED_DATA, NULL,
+                                        _("Malformed network data"));
+
               /* While not really an editor command this can occur when
                 reporter->finish_report() fails before the first editor
                 command */
               if (aborted)
                 *aborted = TRUE;
-              err = svn_ra_svn__handle_failure_status(params);
+              err = svn_ra_svn__handle_failure_status(&item->u.list);
               return svn_error_compose_create(
                                 err,
                                 editor->abort_edit(edit_baton, subpool));
             }
           else
             {
+              SVN_ERR(svn_ra_svn__read_tuple_end(conn, subpool));
               err = svn_error_createf(SVN_ERR_RA_SVN_UNKNOWN_CMD, NULL,
                                       _("Unknown editor command '%s'"), cmd);
               err = svn_error_create(SVN_ERR_RA_SVN_CMD_ERR, err, NULL);
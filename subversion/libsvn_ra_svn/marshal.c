@@ -215,12 +215,22 @@ svn_ra_svn_conn_t *svn_ra_svn_create_conn5(apr_socket_t *sock,
   conn->capabilities = apr_hash_make(result_pool);
   conn->compression_level = compression_level;
   conn->zero_copy_limit = zero_copy_limit;
+  conn->sendfile_sock = NULL;
+  conn->sendfile_bytes = 0;
+  conn->mux = NULL;
+  conn->tls = NULL;
+  conn->recording = NULL;
+  conn->recording_skip = 0;
+  conn->recording_limit = 0;
   conn->pool = result_pool;
 
   if (sock != NULL)
     {
       apr_sockaddr_t *sa;
       conn->stream = svn_ra_svn__stream_from_sock(sock, result_pool);
+#if APR_HAS_SENDFILE
+      conn->sendfile_sock = sock;
+#endif
       if (!(apr_socket_addr_get(&sa, APR_REMOTE, sock) == APR_SUCCESS
             && apr_sockaddr_ip_get(&conn->remote_ip, sa) == APR_SUCCESS))
         conn->remote_ip = NULL;
@@ -315,6 +325,18 @@ svn_ra_svn_zero_copy_limit(svn_ra_svn_conn_t *conn)
   return conn->zero_copy_limit;
 }
 
+svn_boolean_t
+svn_ra_svn__can_sendfile(svn_ra_svn_conn_t *conn)
+{
+  return conn->sendfile_sock != NULL;
+}
+
+apr_uint64_t
+svn_ra_svn__sendfile_bytes(svn_ra_svn_conn_t *conn)
+{
+  return conn->sendfile_bytes;
+}
+
 const char *svn_ra_svn_conn_remote_host(svn_ra_svn_conn_t *conn)
 {
   return conn->remote_ip;
@@ -363,14 +385,49 @@ check_io_limits(svn_ra_svn_conn_t *conn)
   return SVN_NO_ERROR;
 }
 
-/* Write data to socket or output file as appropriate. */
-static svn_error_t *writebuf_output(svn_ra_svn_conn_t *conn, apr_pool_t *pool,
-                                    const char *data, apr_size_t len)
+/* Append the NVEC buffers in VEC to the recording of CONN, if any.
+   Give up on the recording once it exceeds its limit. */
+static void record_output(svn_ra_svn_conn_t *conn,
+                          const struct iovec *vec, int nvec)
 {
-  const char *end = data + len;
+  int i;
+
+  for (i = 0; i < nvec && conn->recording; i++)
+    {
+      const char *data = vec[i].iov_base;
+      apr_size_t len = vec[i].iov_len;
+      apr_size_t skip = MIN(len, conn->recording_skip);
+
+      /* Data buffered before the recording started is not part of it. */
+      conn->recording_skip -= skip;
+      data += skip;
+      len -= skip;
+
+      if (conn->recording->len + len > conn->recording_limit)
+        conn->recording = NULL;
+      else
+        svn_stringbuf_appendbytes(conn->recording, data, len);
+    }
+}
+
+/* Write the NVEC buffers in VEC to the socket or output file as
+   appropriate.  Socket connections send all buffers with a single
+   system call.  VEC will be modified. */
+static svn_error_t *writebuf_output_vec(svn_ra_svn_conn_t *conn,
+                                        apr_pool_t *pool,
+                                        struct iovec *vec, int nvec)
+{
+  apr_size_t len = 0;
   apr_size_t count;
   apr_pool_t *subpool = NULL;
   svn_ra_svn__session_baton_t *session = conn->session;
+  int i;
+
+  for (i = 0; i < nvec; i++)
+    len += vec[i].iov_len;
+
+  if (conn->recording)
+    record_output(conn, vec, nvec);
 
   /* Limit the size of the response, if a limit has been configured.
    * This is to limit the server load in case users e.g. accidentally ran
@@ -378,14 +435,22 @@ static svn_error_t *writebuf_output(svn_ra_svn_conn_t *conn, apr_pool_t *pool,
   conn->current_out += len;
   SVN_ERR(check_io_limits(conn));
 
-  while (data < end)
+  while (TRUE)
     {
-      count = end - data;
+      /* Skip buffers that have been sent completely. */
+      while (nvec > 0 && vec->iov_len == 0)
+        {
+          vec++;
+          nvec--;
+        }
+
+      if (nvec == 0)
+        break;
 
       if (session && session->callbacks && session->callbacks->cancel_func)
         SVN_ERR((session->callbacks->cancel_func)(session->callbacks_baton));
 
-      SVN_ERR(svn_ra_svn__stream_write(conn->stream, data, &count));
+      SVN_ERR(svn_ra_svn__stream_writev(conn->stream, vec, nvec, &count));
       if (count == 0)
         {
           if (!subpool)
@@ -394,7 +459,6 @@ static svn_error_t *writebuf_output(svn_ra_svn_conn_t *conn, apr_pool_t *pool,
             svn_pool_clear(subpool);
           SVN_ERR(conn->block_handler(conn, subpool, conn->block_baton));
         }
-      data += count;
 
       if (session)
         {
@@ -405,6 +469,13 @@ static svn_error_t *writebuf_output(svn_ra_svn_conn_t *conn, apr_pool_t *pool,
             (cb->progress_func)(session->bytes_written + session->bytes_read,
                                 -1, cb->progress_baton, subpool);
         }
+
+      /* Advance to the first byte not written, yet. */
+      for (; count > vec->iov_len; vec++, nvec--)
+        count -= vec->iov_len;
+
+      vec->iov_base = (char *)vec->iov_base + count;
+      vec->iov_len -= count;
     }
 
   conn->written_since_error_check += len;
@@ -416,6 +487,17 @@ static svn_error_t *writebuf_output(svn_ra_svn_conn_t *conn, apr_pool_t *pool,
   return SVN_NO_ERROR;
 }
 
+/* Write data to socket or output file as appropriate. */
+static svn_error_t *writebuf_output(svn_ra_svn_conn_t *conn, apr_pool_t *pool,
+                                    const char *data, apr_size_t len)
+{
+  struct iovec vec;
+  vec.iov_base = (char *)data;
+  vec.iov_len = len;
+
+  return svn_error_trace(writebuf_output_vec(conn, pool, &vec, 1));
+}
+
 /* Write data from the write buffer out to the socket. */
 static svn_error_t *writebuf_flush(svn_ra_svn_conn_t *conn, apr_pool_t *pool)
 {
@@ -427,23 +509,35 @@ static svn_error_t *writebuf_flush(svn_ra_svn_conn_t *conn, apr_pool_t *pool)
   return SVN_NO_ERROR;
 }
 
-static svn_error_t *writebuf_write(svn_ra_svn_conn_t *conn, apr_pool_t *pool,
-                                   const char *data, apr_size_t len)
+/* Send the contents of the write buffer followed by LEN bytes from DATA.
+   Rather than copying DATA into the buffer, both get passed to the
+   stream in one vectored write. */
+static svn_error_t *writebuf_flush_with(svn_ra_svn_conn_t *conn,
+                                        apr_pool_t *pool,
+                                        const char *data, apr_size_t len)
 {
-  /* data >= 8k is sent immediately */
-  if (len >= sizeof(conn->write_buf) / 2)
-    {
-      if (conn->write_pos > 0)
-        SVN_ERR(writebuf_flush(conn, pool));
+  struct iovec vec[2];
+  vec[0].iov_base = conn->write_buf;
+  vec[0].iov_len = conn->write_pos;
+  vec[1].iov_base = (char *)data;
+  vec[1].iov_len = len;
 
-      return writebuf_output(conn, pool, data, len);
-    }
+  /* Clear conn->write_pos first in case the block handler does a read. */
+  conn->write_pos = 0;
+  SVN_ERR(writebuf_output_vec(conn, pool, vec, 2));
+  return SVN_NO_ERROR;
+}
 
-  /* ensure room for the data to add */
-  if (conn->write_pos + len > sizeof(conn->write_buf))
-    SVN_ERR(writebuf_flush(conn, pool));
+static svn_error_t *writebuf_write(svn_ra_svn_conn_t *conn, apr_pool_t *pool,
+                                   const char *data, apr_size_t len)
+{
+  /* data >= 8k is sent immediately, together with anything buffered.
+     The same applies to data that would not fit into the buffer. */
+  if (   len >= sizeof(conn->write_buf) / 2
+      || conn->write_pos + len > sizeof(conn->write_buf))
+    return svn_error_trace(writebuf_flush_with(conn, pool, data, len));
 
-  /* buffer the new data block as well */
+  /* buffer the new data block */
   memcpy(conn->write_buf + conn->write_pos, data, len);
   conn->write_pos += len;
 
@@ -475,6 +569,49 @@ writebuf_writechar(svn_ra_svn_conn_t *conn, apr_pool_t *pool, char data)
   }
 }
 
+svn_error_t *
+svn_ra_svn__write_raw(svn_ra_svn_conn_t *conn,
+                      apr_pool_t *pool,
+                      const char *data,
+                      apr_size_t len)
+{
+  return svn_error_trace(writebuf_write(conn, pool, data, len));
+}
+
+void
+svn_ra_svn__start_recording(svn_ra_svn_conn_t *conn,
+                            apr_size_t limit,
+                            apr_pool_t *pool)
+{
+  conn->recording = svn_stringbuf_create_ensure(MIN(limit,
+                                                    sizeof(conn->write_buf)),
+                                                pool);
+  conn->recording_skip = conn->write_pos;
+  conn->recording_limit = limit;
+}
+
+svn_stringbuf_t *
+svn_ra_svn__stop_recording(svn_ra_svn_conn_t *conn)
+{
+  svn_stringbuf_t *recording = conn->recording;
+
+  conn->recording = NULL;
+
+  /* Add what is still in our write buffer. */
+  if (recording)
+    {
+      apr_size_t skip = MIN(conn->recording_skip, conn->write_pos);
+      apr_size_t len = conn->write_pos - skip;
+
+      if (recording->len + len > conn->recording_limit)
+        return NULL;
+
+      svn_stringbuf_appendbytes(recording, conn->write_buf + skip, len);
+    }
+
+  return recording;
+}
+
 /* --- READ BUFFER MANAGEMENT --- */
 
 /* Read bytes into DATA until either the read buffer is empty or
@@ -771,6 +908,69 @@ svn_ra_svn__write_cstring(svn_ra_svn_conn_t *conn,
   return SVN_NO_ERROR;
 }
 
+svn_error_t *
+svn_ra_svn__write_string_from_file(svn_ra_svn_conn_t *conn,
+                                   apr_pool_t *pool,
+                                   apr_file_t *file,
+                                   apr_off_t offset,
+                                   apr_size_t len)
+{
+  SVN_ERR(write_number(conn, pool, len, ':'));
+
+#if APR_HAS_SENDFILE
+  if (conn->sendfile_sock)
+    {
+      /* Everything before the string data must go out first. */
+      SVN_ERR(writebuf_flush(conn, pool));
+
+      /* The file contents bypass our buffers and cannot be recorded. */
+      conn->recording = NULL;
+
+      conn->current_out += len;
+      SVN_ERR(check_io_limits(conn));
+
+      conn->written_since_error_check += len;
+      conn->may_check_for_error
+        = conn->written_since_error_check >= conn->error_check_interval;
+
+      while (len > 0)
+        {
+          apr_size_t count = len;
+          apr_off_t file_offset = offset;
+          apr_status_t status;
+
+          status = apr_socket_sendfile(conn->sendfile_sock, file, NULL,
+                                       &file_offset, &count, 0);
+          if (status)
+            return svn_error_wrap_apr(status, _("Can't write to connection"));
+          if (count == 0)
+            return svn_error_create(SVN_ERR_RA_SVN_IO_ERROR, NULL,
+                                    _("Unexpected end of file contents"));
+
+          offset += count;
+          len -= count;
+          conn->sendfile_bytes += count;
+        }
+
+      return svn_error_trace(writebuf_writechar(conn, pool, ' '));
+    }
+#endif
+
+  /* No direct access to the socket.  Copy through our buffers. */
+  SVN_ERR(svn_io_file_seek(file, APR_SET, &offset, pool));
+  while (len > 0)
+    {
+      char buffer[SVN__STREAM_CHUNK_SIZE];
+      apr_size_t count = MIN(len, sizeof(buffer));
+
+      SVN_ERR(svn_io_file_read_full2(file, buffer, count, NULL, NULL, pool));
+      SVN_ERR(writebuf_write(conn, pool, buffer, count));
+      len -= count;
+    }
+
+  return svn_error_trace(writebuf_writechar(conn, pool, ' '));
+}
+
 svn_error_t *
 svn_ra_svn__write_word(svn_ra_svn_conn_t *conn,
                        apr_pool_t *pool,
@@ -1762,6 +1962,210 @@ svn_ra_svn__read_command_only(svn_ra_svn_conn_t *conn,
 }
 
 
+svn_error_t *
+svn_ra_svn__read_command_start(svn_ra_svn_conn_t *conn,
+                               apr_pool_t *pool,
+                               const char **command)
+{
+  svn_ra_svn__item_t item;
+  char c;
+
+  SVN_ERR(readbuf_getchar_skip_whitespace(conn, pool, &c));
+  if (c != '(')
+    return svn_error_create(SVN_ERR_RA_SVN_MALFORMED_DATA, NULL,
+                            _("Malformed network data"));
+
+  SVN_ERR(readbuf_getchar_skip_whitespace(conn, pool, &c));
+  if (!svn_ctype_isalpha(c))
+    return svn_error_create(SVN_ERR_RA_SVN_MALFORMED_DATA, NULL,
+                            _("Malformed network data"));
+
+  SVN_ERR(read_item(conn, pool, &item, c, 0));
+  *command = item.u.word.data;
+
+  return SVN_NO_ERROR;
+}
+
+/* Set the members of TARGET described by *FIELDS to their defaults for
+ * missing optional data, up to the end of the current (sub-)tuple.
+ * Advance *FIELDS behind that tuple specification. */
+static void
+default_fields(const svn_ra_svn__field_t **fields,
+               char *target)
+{
+  int nesting_level = 0;
+
+  for (; (*fields)->kind; ++*fields)
+    {
+      void *member = target + (*fields)->offset;
+      switch ((*fields)->kind)
+        {
+          case 'r':
+            *(svn_revnum_t *)member = SVN_INVALID_REVNUM;
+            break;
+          case 's':
+            *(svn_string_t **)member = NULL;
+            break;
+          case 'c':
+          case 'w':
+            *(const char **)member = NULL;
+            break;
+          case 'n':
+            *(apr_uint64_t *)member = SVN_RA_SVN_UNSPECIFIED_NUMBER;
+            break;
+          case 'b':
+            *(svn_boolean_t *)member = FALSE;
+            break;
+          case '(':
+            nesting_level++;
+            break;
+          case ')':
+            if (--nesting_level < 0)
+              {
+                ++*fields;
+                return;
+              }
+            break;
+          default:
+            break;
+        }
+    }
+}
+
+/* Read the elements of a tuple from CONN, whose opening paren has already
+ * been read, and decode them into TARGET as described by *FIELDS.  Advance
+ * *FIELDS behind the tuple specification.  LEVEL is the current nesting
+ * level as in read_item(). */
+static svn_error_t *
+read_fields(svn_ra_svn_conn_t *conn,
+            apr_pool_t *pool,
+            const svn_ra_svn__field_t **fields,
+            char *target,
+            int level)
+{
+  svn_ra_svn__item_t item;
+  char c;
+
+  if (++level >= ITEM_NESTING_LIMIT)
+    return svn_error_create(SVN_ERR_RA_SVN_MALFORMED_DATA, NULL,
+                            _("Items are nested too deeply"));
+
+  while (1)
+    {
+      const svn_ra_svn__field_t *field;
+      void *member;
+
+      SVN_ERR(readbuf_getchar_skip_whitespace(conn, pool, &c));
+      if (c == ')')
+        break;
+
+      /* '?' just means the tuple may stop; skip past it. */
+      if ((*fields)->kind == '?')
+        ++*fields;
+
+      /* Skip elements that we don't know about. */
+      field = *fields;
+      if (field->kind == 0 || field->kind == ')')
+        {
+          SVN_ERR(read_item(conn, pool, &item, c, level));
+          continue;
+        }
+
+      ++*fields;
+      if (field->kind == '(' && c == '(')
+        {
+          SVN_ERR(read_fields(conn, pool, fields, target, level));
+          continue;
+        }
+
+      /* Only scalars from here on.  Don't even read a list. */
+      if (field->kind == '(' || c == '(')
+        return svn_error_create(SVN_ERR_RA_SVN_MALFORMED_DATA, NULL,
+                                _("Malformed network data"));
+
+      SVN_ERR(read_item(conn, pool, &item, c, level));
+      member = target + field->offset;
+
+      if (field->kind == 'c' && item.kind == SVN_RA_SVN_STRING)
+        *(const char **)member = item.u.string.data;
+      else if (field->kind == 's' && item.kind == SVN_RA_SVN_STRING)
+        *(svn_string_t **)member = apr_pmemdup(pool, &item.u.string,
+                                               sizeof(item.u.string));
+      else if (field->kind == 'r' && item.kind == SVN_RA_SVN_NUMBER)
+        *(svn_revnum_t *)member = (svn_revnum_t) item.u.number;
+      else if (field->kind == 'n' && item.kind == SVN_RA_SVN_NUMBER)
+        *(apr_uint64_t *)member = item.u.number;
+      else if (field->kind == 'w' && item.kind == SVN_RA_SVN_WORD)
+        *(const char **)member = item.u.word.data;
+      else if (field->kind == 'b' && item.kind == SVN_RA_SVN_WORD
+               && svn_string_compare(&item.u.word, &str_true))
+        *(svn_boolean_t *)member = TRUE;
+      else if (field->kind == 'b' && item.kind == SVN_RA_SVN_WORD
+               && svn_string_compare(&item.u.word, &str_false))
+        *(svn_boolean_t *)member = FALSE;
+      else
+        return svn_error_create(SVN_ERR_RA_SVN_MALFORMED_DATA, NULL,
+                                _("Malformed network data"));
+    }
+
+  /* Like read_item(), consume the whitespace following the list. */
+  SVN_ERR(readbuf_getchar(conn, pool, &c));
+  if (!svn_iswhitespace(c))
+    return svn_error_create(SVN_ERR_RA_SVN_MALFORMED_DATA, NULL,
+                            _("Malformed network data"));
+
+  /* The tuple may only end at a '?' or at the end of its specification. */
+  if ((*fields)->kind == '?')
+    default_fields(fields, target);
+  else if ((*fields)->kind == ')')
+    ++*fields;
+  else if ((*fields)->kind != 0)
+    return svn_error_create(SVN_ERR_RA_SVN_MALFORMED_DATA, NULL,
+                            _("Malformed network data"));
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_ra_svn__read_fields(svn_ra_svn_conn_t *conn,
+                        apr_pool_t *pool,
+                        const svn_ra_svn__field_t *fields,
+                        void *target)
+{
+  char c;
+
+  SVN_ERR(readbuf_getchar_skip_whitespace(conn, pool, &c));
+  if (c != '(')
+    return svn_error_create(SVN_ERR_RA_SVN_MALFORMED_DATA, NULL,
+                            _("Malformed network data"));
+
+  return svn_error_trace(read_fields(conn, pool, &fields, target, 0));
+}
+
+svn_error_t *
+svn_ra_svn__read_tuple_end(svn_ra_svn_conn_t *conn,
+                           apr_pool_t *pool)
+{
+  svn_ra_svn__item_t item;
+  char c;
+
+  while (1)
+    {
+      SVN_ERR(readbuf_getchar_skip_whitespace(conn, pool, &c));
+      if (c == ')')
+        break;
+
+      SVN_ERR(read_item(conn, pool, &item, c, 0));
+    }
+
+  SVN_ERR(readbuf_getchar(conn, pool, &c));
+  if (!svn_iswhitespace(c))
+    return svn_error_create(SVN_ERR_RA_SVN_MALFORMED_DATA, NULL,
+                            _("Malformed network data"));
+
+  return SVN_NO_ERROR;
+}
+
 svn_error_t *
 svn_ra_svn__parse_proplist(const svn_ra_svn__list_t *list,
                            apr_pool_t *pool,
@@ -1952,6 +2356,10 @@ svn_ra_svn__handle_command(svn_boolean_t *terminate,
                                                baton);
         }
 
+      /* Recordings end with the command that started them, no matter
+       * whether it completed them. */
+      conn->recording = NULL;
+
       /* The command implementation may have swallowed or wrapped the I/O
        * error not knowing that we may no longer be able to send data.
        *
@@ -2348,6 +2756,13 @@ svn_ra_svn__write_cmd_reparent(svn_ra_svn_conn_t *conn,
   return SVN_NO_ERROR;
 }
 
+svn_error_t *
+svn_ra_svn__write_cmd_multiplex(svn_ra_svn_conn_t *conn,
+                                apr_pool_t *pool)
+{
+  return writebuf_write_literal(conn, pool, "( multiplex ( ) ) ");
+}
+
 svn_error_t *
 svn_ra_svn__write_cmd_get_latest_rev(svn_ra_svn_conn_t *conn,
                                    apr_pool_t *pool)
@@ -0,0 +1,848 @@
+/*
+ * mux.c :  carrying multiple ra_svn connections over a single stream
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+
+
+#include <string.h>
+
+#include <apr_general.h>
+
+#include "svn_types.h"
+#include "svn_error.h"
+#include "svn_pools.h"
+#include "svn_io.h"
+#include "svn_sorts.h"
+#include "svn_private_config.h"
+
+#include "private/svn_mutex.h"
+#include "private/svn_sorts_private.h"
+#include "private/svn_thread_cond.h"
+
+#include "ra_svn.h"
+
+/* Every frame starts with a header of this many bytes:
+ * 4 bytes channel ID, 1 byte frame type and 3 bytes payload length,
+ * all in network byte order. */
+#define FRAME_HEADER_SIZE 8
+
+/* Maximum payload of a single frame.  Must be less than 2^24. */
+#define MAX_FRAME_PAYLOAD 0x10000
+
+/* Refuse to open more than this many channels per connection. */
+#define MAX_CHANNELS 16
+
+/* Number of data bytes that either side may send on a channel before
+ * the receiver grants more.  Bounds the amount of data that we buffer
+ * for channels that don't get read. */
+#define CHANNEL_WINDOW 0x40000
+
+/* Size of the payload of a window frame. */
+#define WINDOW_PAYLOAD 4
+
+/* Frame types as defined in the protocol description. */
+typedef enum frame_type_t
+{
+  frame_open = 1,
+  frame_data = 2,
+  frame_close = 3,
+  frame_window = 4
+} frame_type_t;
+
+/* One logical connection within a multiplexed stream. */
+typedef struct channel_t
+{
+  /* The multiplexer that we belong to. */
+  svn_ra_svn__mux_t *mux;
+
+  /* Sub-pool of MUX->POOL that this structure lives in. */
+  apr_pool_t *pool;
+
+  /* Channel ID as used on the wire. */
+  apr_uint32_t id;
+
+  /* Data received for this channel but not read yet. */
+  svn_stringbuf_t *received;
+
+  /* The peer closed this channel. */
+  svn_boolean_t eof;
+
+  /* Number of data bytes that we may still send to the peer. */
+  apr_size_t send_window;
+
+  /* Number of data bytes that the peer may still send to us. */
+  apr_size_t recv_window;
+
+  /* Number of bytes read from RECEIVED but not granted back to the
+   * peer, yet. */
+  apr_size_t consumed;
+} channel_t;
+
+struct svn_ra_svn__mux_t
+{
+  /* Root pool for this structure and all channel_t.  Gets destroyed
+   * together with the last reference to this multiplexer. */
+  apr_pool_t *pool;
+
+  /* Number of connection objects using this multiplexer. */
+  int refcount;
+
+  /* The underlying stream.  Owned by the connection behind channel 0.
+   * NULL once that has been destroyed.  Readers may only use it while
+   * BROKEN is not set; writers may only use it while holding WRITE_MUTEX.
+   * Closing channel 0 waits for both to drain before resetting this. */
+  svn_ra_svn__stream_t *transport;
+
+  /* TRUE after TRANSPORT got closed or failed.  No further frames will
+   * be received. */
+  svn_boolean_t broken;
+
+  /* TRUE while some thread reads from TRANSPORT or routes a frame with
+   * MUTEX released. */
+  svn_boolean_t reading;
+
+  /* All open channels, keyed by their apr_uint32_t ID. */
+  apr_hash_t *channels;
+
+  /* Channels opened by the peer that have not been accepted yet. */
+  apr_array_header_t *incoming;
+
+  /* ID to use for the next channel that we open. */
+  apr_uint32_t next_id;
+
+  /* Payload buffer of MAX_FRAME_PAYLOAD bytes.  Only the thread that
+   * reads from TRANSPORT may use it. */
+  char *frame;
+
+  /* Serializes access to all members above.  Signal COND whenever a
+   * frame has been received. */
+  svn_mutex__t *mutex;
+  svn_thread_cond__t *cond;
+
+  /* Serializes writes to TRANSPORT and guards resetting it.  Never
+   * acquire MUTEX while holding this one. */
+  svn_mutex__t *write_mutex;
+
+  /* Connection settings to use for new channels. */
+  int compression_level;
+  apr_size_t zero_copy_limit;
+  apr_size_t error_check_interval;
+  apr_uint64_t max_in;
+  apr_uint64_t max_out;
+  char *remote_ip;
+};
+
+
+/*** Low-level frame I/O ***/
+
+/* Read exactly LEN bytes from STREAM into BUFFER. */
+static svn_error_t *
+read_fully(svn_ra_svn__stream_t *stream,
+           char *buffer,
+           apr_size_t len)
+{
+  while (len)
+    {
+      apr_size_t count = len;
+      SVN_ERR(svn_ra_svn__stream_read(stream, buffer, &count));
+
+      buffer += count;
+      len -= count;
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Read the next frame from MUX->TRANSPORT and return its header data in
+ * *TYPE, *ID and *LEN.  The payload will be in MUX->FRAME. */
+static svn_error_t *
+receive_frame(frame_type_t *type,
+              apr_uint32_t *id,
+              apr_size_t *len,
+              svn_ra_svn__mux_t *mux)
+{
+  unsigned char header[FRAME_HEADER_SIZE];
+
+  SVN_ERR(read_fully(mux->transport, (char *)header, sizeof(header)));
+
+  *id = ((apr_uint32_t)header[0] << 24)
+      | ((apr_uint32_t)header[1] << 16)
+      | ((apr_uint32_t)header[2] << 8)
+      |  (apr_uint32_t)header[3];
+  *type = (frame_type_t)header[4];
+  *len = ((apr_size_t)header[5] << 16)
+       | ((apr_size_t)header[6] << 8)
+       |  (apr_size_t)header[7];
+
+  if (*len > MAX_FRAME_PAYLOAD)
+    return svn_error_create(SVN_ERR_RA_SVN_MALFORMED_DATA, NULL,
+                            _("Multiplexed frame too large"));
+
+  return svn_error_trace(read_fully(mux->transport, mux->frame, *len));
+}
+
+/* Send a frame of TYPE for channel ID with LEN bytes of payload in DATA
+ * through MUX. */
+static svn_error_t *
+send_frame(svn_ra_svn__mux_t *mux,
+           frame_type_t type,
+           apr_uint32_t id,
+           const char *data,
+           apr_size_t len)
+{
+  char header[FRAME_HEADER_SIZE];
+  struct iovec vec[2];
+  svn_error_t *err = SVN_NO_ERROR;
+
+  SVN_ERR_ASSERT(len <= MAX_FRAME_PAYLOAD);
+
+  header[0] = (char)(id >> 24);
+  header[1] = (char)(id >> 16);
+  header[2] = (char)(id >> 8);
+  header[3] = (char)id;
+  header[4] = (char)type;
+  header[5] = (char)(len >> 16);
+  header[6] = (char)(len >> 8);
+  header[7] = (char)len;
+
+  vec[0].iov_base = header;
+  vec[0].iov_len = sizeof(header);
+  vec[1].iov_base = (void *)data;
+  vec[1].iov_len = len;
+
+  /* Header and payload must not get interleaved with other frames. */
+  SVN_ERR(svn_mutex__lock(mux->write_mutex));
+  if (!mux->transport)
+    err = svn_error_create(SVN_ERR_RA_SVN_CONNECTION_CLOSED, NULL, NULL);
+
+  while (!err && vec[0].iov_len + vec[1].iov_len)
+    {
+      apr_size_t count;
+      int i;
+
+      err = svn_ra_svn__stream_writev(mux->transport, vec, 2, &count);
+      for (i = 0; !err && i < 2; i++)
+        {
+          apr_size_t consumed = MIN(count, vec[i].iov_len);
+
+          vec[i].iov_base = (char *)vec[i].iov_base + consumed;
+          vec[i].iov_len -= consumed;
+          count -= consumed;
+        }
+    }
+
+  return svn_error_trace(svn_mutex__unlock(mux->write_mutex, err));
+}
+
+/* Grant the peer CREDIT more bytes of data on channel ID of MUX. */
+static svn_error_t *
+send_window(svn_ra_svn__mux_t *mux,
+            apr_uint32_t id,
+            apr_size_t credit)
+{
+  char payload[WINDOW_PAYLOAD];
+
+  payload[0] = (char)(credit >> 24);
+  payload[1] = (char)(credit >> 16);
+  payload[2] = (char)(credit >> 8);
+  payload[3] = (char)credit;
+
+  return svn_error_trace(send_frame(mux, frame_window, id, payload,
+                                    sizeof(payload)));
+}
+
+
+/*** Channel management ***/
+
+/* Create a new channel with the given ID in MUX and return it.
+ * The caller must hold MUX->MUTEX. */
+static channel_t *
+create_channel(svn_ra_svn__mux_t *mux,
+               apr_uint32_t id)
+{
+  apr_pool_t *pool = svn_pool_create(mux->pool);
+  channel_t *channel = apr_pcalloc(pool, sizeof(*channel));
+
+  channel->mux = mux;
+  channel->pool = pool;
+  channel->id = id;
+  channel->received = svn_stringbuf_create_empty(pool);
+  channel->eof = FALSE;
+  channel->send_window = CHANNEL_WINDOW;
+  channel->recv_window = CHANNEL_WINDOW;
+  channel->consumed = 0;
+
+  apr_hash_set(mux->channels, &channel->id, sizeof(channel->id), channel);
+
+  return channel;
+}
+
+/* Process the frame of TYPE for channel ID that has just been received
+ * with LEN bytes of payload in MUX->FRAME.  Set *REFUSE if the caller
+ * shall close the channel again.  The caller must hold MUX->MUTEX. */
+static svn_error_t *
+route_frame(svn_boolean_t *refuse,
+            svn_ra_svn__mux_t *mux,
+            frame_type_t type,
+            apr_uint32_t id,
+            apr_size_t len)
+{
+  channel_t *channel = apr_hash_get(mux->channels, &id, sizeof(id));
+  const unsigned char *payload = (const unsigned char *)mux->frame;
+  apr_size_t credit;
+
+  *refuse = FALSE;
+  switch (type)
+    {
+      case frame_open:
+        if (channel)
+          return svn_error_create(SVN_ERR_RA_SVN_MALFORMED_DATA, NULL,
+                                  _("Channel opened twice"));
+
+        /* Be nice to the other side and tell it right away. */
+        if (apr_hash_count(mux->channels) >= MAX_CHANNELS)
+          {
+            *refuse = TRUE;
+            break;
+          }
+
+        channel = create_channel(mux, id);
+        APR_ARRAY_PUSH(mux->incoming, channel_t *) = channel;
+        break;
+
+      case frame_data:
+        /* Data for channels that we closed already gets discarded. */
+        if (channel)
+          {
+            if (len > channel->recv_window)
+              return svn_error_create(SVN_ERR_RA_SVN_MALFORMED_DATA, NULL,
+                                      _("Channel window exceeded"));
+
+            svn_stringbuf_appendbytes(channel->received, mux->frame, len);
+            channel->recv_window -= len;
+          }
+        break;
+
+      case frame_window:
+        if (len != WINDOW_PAYLOAD)
+          return svn_error_create(SVN_ERR_RA_SVN_MALFORMED_DATA, NULL,
+                                  _("Invalid window frame"));
+
+        credit = ((apr_size_t)payload[0] << 24)
+               | ((apr_size_t)payload[1] << 16)
+               | ((apr_size_t)payload[2] << 8)
+               |  (apr_size_t)payload[3];
+
+        if (channel)
+          {
+            if (credit > CHANNEL_WINDOW - channel->send_window)
+              return svn_error_create(SVN_ERR_RA_SVN_MALFORMED_DATA, NULL,
+                                      _("Channel window overflow"));
+
+            channel->send_window += credit;
+          }
+        break;
+
+      case frame_close:
+        if (channel)
+          channel->eof = TRUE;
+        break;
+
+      default:
+        return svn_error_create(SVN_ERR_RA_SVN_MALFORMED_DATA, NULL,
+                                _("Unknown frame type"));
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Receive one frame from MUX->TRANSPORT and route it.  The caller must
+ * hold MUX->MUTEX; it will be released while waiting for data. */
+static svn_error_t *
+receive_locked(svn_ra_svn__mux_t *mux)
+{
+  frame_type_t type = frame_data;
+  apr_uint32_t id = 0;
+  apr_size_t len = 0;
+  svn_boolean_t refuse = FALSE;
+  svn_error_t *err, *lock_err;
+
+  /* Closing channel 0 sets BROKEN before it resets TRANSPORT. */
+  if (mux->broken)
+    return SVN_NO_ERROR;
+
+  /* While READING is set, TRANSPORT stays valid even without MUTEX. */
+  mux->reading = TRUE;
+  SVN_ERR(svn_mutex__unlock(mux->mutex, SVN_NO_ERROR));
+  err = receive_frame(&type, &id, &len, mux);
+  lock_err = svn_mutex__lock(mux->mutex);
+  if (lock_err)
+    {
+      svn_error_clear(err);
+      return svn_error_trace(lock_err);
+    }
+
+  if (!err)
+    err = route_frame(&refuse, mux, type, id, len);
+
+  /* Sending may block, so don't do that while holding MUTEX. */
+  if (!err && refuse)
+    {
+      SVN_ERR(svn_mutex__unlock(mux->mutex, SVN_NO_ERROR));
+      err = send_frame(mux, frame_close, id, NULL, 0);
+      lock_err = svn_mutex__lock(mux->mutex);
+      if (lock_err)
+        {
+          svn_error_clear(err);
+          return svn_error_trace(lock_err);
+        }
+    }
+
+  mux->reading = FALSE;
+
+  /* A broken connection is reported as "closed" on all channels. */
+  if (err)
+    {
+      svn_error_clear(err);
+      mux->broken = TRUE;
+    }
+
+  return svn_error_trace(svn_thread_cond__broadcast(mux->cond));
+}
+
+/* Receive frames from MUX until READY returns TRUE for BATON or until the
+ * underlying stream breaks.  Only one thread may read at any time; all
+ * others wait for it to route the frames.  The caller must hold
+ * MUX->MUTEX. */
+static svn_error_t *
+wait_locked(svn_ra_svn__mux_t *mux,
+            svn_boolean_t (*ready)(void *baton),
+            void *baton)
+{
+  while (!ready(baton) && !mux->broken)
+    {
+      if (mux->reading)
+        SVN_ERR(svn_thread_cond__wait(mux->cond, mux->mutex));
+      else
+        SVN_ERR(receive_locked(mux));
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Drop one reference to MUX and destroy it with the last one. */
+static void
+release_mux(svn_ra_svn__mux_t *mux)
+{
+  svn_boolean_t last;
+
+  svn_error_clear(svn_mutex__lock(mux->mutex));
+  last = --mux->refcount == 0;
+  svn_error_clear(svn_mutex__unlock(mux->mutex, SVN_NO_ERROR));
+
+  if (last)
+    svn_pool_destroy(mux->pool);
+}
+
+/* Pool cleanup function closing the channel_t given by BATON.  Closing
+ * channel 0 detaches the multiplexer from the underlying stream.
+ *
+ * The stream will be closed together with channel 0's connection, so we
+ * must wait for all threads to stop using it.  A thread blocked in a read
+ * will keep us waiting until a frame arrives or the stream fails; owners
+ * of such threads should shut the stream down before closing channel 0. */
+static apr_status_t
+close_channel(void *baton)
+{
+  channel_t *channel = baton;
+  svn_ra_svn__mux_t *mux = channel->mux;
+  apr_uint32_t id = channel->id;
+  svn_boolean_t send_close;
+
+  svn_error_clear(svn_mutex__lock(mux->mutex));
+
+  apr_hash_set(mux->channels, &channel->id, sizeof(channel->id), NULL);
+  send_close = id != 0 && !channel->eof && !mux->broken;
+  svn_pool_destroy(channel->pool);
+
+  /* No new readers after this.  Let the current one finish. */
+  if (id == 0)
+    {
+      mux->broken = TRUE;
+      svn_error_clear(svn_thread_cond__broadcast(mux->cond));
+
+      while (mux->reading)
+        svn_error_clear(svn_thread_cond__wait(mux->cond, mux->mutex));
+    }
+
+  svn_error_clear(svn_mutex__unlock(mux->mutex, SVN_NO_ERROR));
+
+  /* Wait for the current writer, if any, and stop all future ones. */
+  if (id == 0)
+    {
+      svn_error_clear(svn_mutex__lock(mux->write_mutex));
+      mux->transport = NULL;
+      svn_error_clear(svn_mutex__unlock(mux->write_mutex, SVN_NO_ERROR));
+    }
+
+  if (send_close)
+    svn_error_clear(send_frame(mux, frame_close, id, NULL, 0));
+
+  release_mux(mux);
+
+  return APR_SUCCESS;
+}
+
+
+/*** Channel stream callbacks ***/
+
+/* Implements the READY callback of wait_locked() for channel_t BATON. */
+static svn_boolean_t
+has_data(void *baton)
+{
+  channel_t *channel = baton;
+  return channel->received->len > 0 || channel->eof;
+}
+
+/* Implements the READY callback of wait_locked() for MUX given as BATON. */
+static svn_boolean_t
+has_incoming(void *baton)
+{
+  svn_ra_svn__mux_t *mux = baton;
+  return mux->incoming->nelts > 0;
+}
+
+/* Implements the READY callback of wait_locked() for channel_t BATON. */
+static svn_boolean_t
+has_window(void *baton)
+{
+  channel_t *channel = baton;
+  return channel->send_window > 0 || channel->eof;
+}
+
+/* Core of channel_read_cb.  If the peer shall be granted more data, set
+ * *CREDIT to the number of bytes and to 0 otherwise.  The caller must
+ * hold the mutex. */
+static svn_error_t *
+read_locked(apr_size_t *credit,
+            channel_t *channel,
+            char *buffer,
+            apr_size_t *len)
+{
+  SVN_ERR(wait_locked(channel->mux, has_data, channel));
+
+  /* Returning 0 bytes signals the end of the stream. */
+  *len = MIN(*len, channel->received->len);
+  memcpy(buffer, channel->received->data, *len);
+  svn_stringbuf_remove(channel->received, 0, *len);
+
+  /* Batch credit to not send a window frame for every read. */
+  channel->consumed += *len;
+  if (   channel->consumed >= CHANNEL_WINDOW / 2
+      && !channel->eof && !channel->mux->broken)
+    {
+      *credit = channel->consumed;
+      channel->recv_window += channel->consumed;
+      channel->consumed = 0;
+    }
+  else
+    {
+      *credit = 0;
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_read_fn_t */
+static svn_error_t *
+channel_read_cb(void *baton,
+                char *buffer,
+                apr_size_t *len)
+{
+  channel_t *channel = baton;
+  apr_size_t credit;
+
+  SVN_MUTEX__WITH_LOCK(channel->mux->mutex,
+                       read_locked(&credit, channel, buffer, len));
+
+  /* If this fails, the connection is broken and the next read will
+   * report that. */
+  if (credit)
+    svn_error_clear(send_window(channel->mux, channel->id, credit));
+
+  return SVN_NO_ERROR;
+}
+
+/* Core of channel_write_cb.  Wait until CHANNEL may send data and take up
+ * to *COUNT bytes from its window, setting *COUNT to the amount taken.
+ * The caller must hold the mutex. */
+static svn_error_t *
+reserve_locked(apr_size_t *count,
+               channel_t *channel)
+{
+  SVN_ERR(wait_locked(channel->mux, has_window, channel));
+
+  /* The peer would discard everything that we send. */
+  if (channel->eof || channel->mux->broken)
+    return svn_error_create(SVN_ERR_RA_SVN_CONNECTION_CLOSED, NULL, NULL);
+
+  *count = MIN(*count, channel->send_window);
+  channel->send_window -= *count;
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_write_fn_t */
+static svn_error_t *
+channel_write_cb(void *baton,
+                 const char *buffer,
+                 apr_size_t *len)
+{
+  channel_t *channel = baton;
+  apr_size_t count = MIN(*len, MAX_FRAME_PAYLOAD);
+
+  SVN_MUTEX__WITH_LOCK(channel->mux->mutex,
+                       reserve_locked(&count, channel));
+
+  SVN_ERR(send_frame(channel->mux, frame_data, channel->id, buffer, count));
+  *len = count;
+
+  return SVN_NO_ERROR;
+}
+
+/* Core of channel_data_available_cb.  The caller must hold the mutex. */
+static svn_error_t *
+data_available_locked(channel_t *channel,
+                      svn_boolean_t *data_available)
+{
+  svn_ra_svn__mux_t *mux = channel->mux;
+
+  /* If there is a frame waiting in the underlying stream, it may be for
+   * us.  Frames are sent in one go, so receiving them will not block. */
+  if (!has_data(channel) && !mux->broken && !mux->reading)
+    {
+      svn_boolean_t pending;
+
+      SVN_ERR(svn_ra_svn__stream_data_available(mux->transport, &pending));
+      if (pending)
+        SVN_ERR(receive_locked(mux));
+    }
+
+  *data_available = has_data(channel) || mux->broken;
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_stream_data_available_fn_t */
+static svn_error_t *
+channel_data_available_cb(void *baton,
+                          svn_boolean_t *data_available)
+{
+  channel_t *channel = baton;
+
+  SVN_MUTEX__WITH_LOCK(channel->mux->mutex,
+                       data_available_locked(channel, data_available));
+
+  return SVN_NO_ERROR;
+}
+
+/* Return a stream reading from and writing to CHANNEL, allocated in
+ * RESULT_POOL. */
+static svn_stream_t *
+channel_stream(channel_t *channel,
+               apr_pool_t *result_pool)
+{
+  svn_stream_t *stream = svn_stream_create(channel, result_pool);
+
+  svn_stream_set_read2(stream, channel_read_cb, NULL /* use default */);
+  svn_stream_set_write(stream, channel_write_cb);
+  svn_stream_set_data_available(stream, channel_data_available_cb);
+
+  return stream;
+}
+
+/* Return a new connection object for CHANNEL, allocated in RESULT_POOL.
+ * The caller must hold the mutex. */
+static svn_ra_svn_conn_t *
+channel_conn(channel_t *channel,
+             apr_pool_t *result_pool)
+{
+  svn_ra_svn__mux_t *mux = channel->mux;
+  svn_stream_t *stream = channel_stream(channel, result_pool);
+  svn_ra_svn_conn_t *conn;
+
+  conn = svn_ra_svn_create_conn5(NULL, stream, stream,
+                                 mux->compression_level,
+                                 mux->zero_copy_limit,
+                                 mux->error_check_interval,
+                                 mux->max_in, mux->max_out,
+                                 result_pool);
+  conn->remote_ip = mux->remote_ip;
+  conn->mux = mux;
+
+  ++mux->refcount;
+  apr_pool_cleanup_register(result_pool, channel, close_channel,
+                            apr_pool_cleanup_null);
+
+  return conn;
+}
+
+
+/*** Public API ***/
+
+svn_error_t *
+svn_ra_svn__mux_start(svn_ra_svn_conn_t *conn,
+                      apr_pool_t *scratch_pool)
+{
+  apr_pool_t *pool;
+  svn_ra_svn__mux_t *mux;
+  channel_t *channel;
+  svn_stream_t *stream;
+
+  SVN_ERR_ASSERT(!conn->mux);
+
+  /* Everything sent or received up to here belongs to the raw stream. */
+  SVN_ERR(svn_ra_svn__flush(conn, scratch_pool));
+  if (conn->read_ptr != conn->read_end)
+    return svn_error_create(SVN_ERR_RA_SVN_MALFORMED_DATA, NULL,
+                            _("Unexpected data before multiplexing"));
+
+  /* The multiplexer may outlive CONN, so it gets its own pool. */
+  pool = svn_pool_create(NULL);
+  mux = apr_pcalloc(pool, sizeof(*mux));
+  mux->pool = pool;
+  mux->refcount = 0;
+  mux->transport = conn->stream;
+  mux->broken = FALSE;
+  mux->reading = FALSE;
+  mux->channels = apr_hash_make(pool);
+  mux->incoming = apr_array_make(pool, 4, sizeof(channel_t *));
+  mux->next_id = 1;
+  mux->frame = apr_palloc(pool, MAX_FRAME_PAYLOAD);
+  SVN_ERR(svn_mutex__init(&mux->mutex, TRUE, pool));
+  SVN_ERR(svn_mutex__init(&mux->write_mutex, TRUE, pool));
+  SVN_ERR(svn_thread_cond__create(&mux->cond, pool));
+
+  mux->compression_level = conn->compression_level;
+  mux->zero_copy_limit = conn->zero_copy_limit;
+  mux->error_check_interval = conn->error_check_interval;
+  mux->max_in = conn->max_in;
+  mux->max_out = conn->max_out;
+  mux->remote_ip = conn->remote_ip ? apr_pstrdup(pool, conn->remote_ip)
+                                   : NULL;
+
+  /* Readers wait for whole frames and writers must not give up halfway
+   * through a frame. */
+  svn_ra_svn__stream_timeout(mux->transport, -1);
+
+  /* CONN continues as channel 0.  Data must not bypass the framing. */
+  channel = create_channel(mux, 0);
+  stream = channel_stream(channel, conn->pool);
+  conn->stream = svn_ra_svn__stream_from_streams(stream, stream, conn->pool);
+  conn->sendfile_sock = NULL;
+  conn->mux = mux;
+
+  ++mux->refcount;
+  apr_pool_cleanup_register(conn->pool, channel, close_channel,
+                            apr_pool_cleanup_null);
+
+  return SVN_NO_ERROR;
+}
+
+svn_boolean_t
+svn_ra_svn__is_multiplexed(svn_ra_svn_conn_t *conn)
+{
+  return conn->mux != NULL;
+}
+
+/* Core of svn_ra_svn__mux_open.  The caller must hold the mutex. */
+static svn_error_t *
+open_locked(svn_ra_svn_conn_t **channel,
+            apr_uint32_t *id,
+            svn_ra_svn__mux_t *mux,
+            apr_pool_t *result_pool)
+{
+  if (mux->broken)
+    return svn_error_create(SVN_ERR_RA_SVN_CONNECTION_CLOSED, NULL, NULL);
+
+  *id = mux->next_id++;
+  *channel = channel_conn(create_channel(mux, *id), result_pool);
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_ra_svn__mux_open(svn_ra_svn_conn_t **channel,
+                     svn_ra_svn_conn_t *conn,
+                     apr_pool_t *result_pool)
+{
+  svn_ra_svn__mux_t *mux = conn->mux;
+  apr_uint32_t id;
+
+  SVN_ERR_ASSERT(mux);
+
+  SVN_MUTEX__WITH_LOCK(mux->mutex,
+                       open_locked(channel, &id, mux, result_pool));
+
+  /* The peer will answer with the usual greeting on the new channel. */
+  SVN_ERR(send_frame(mux, frame_open, id, NULL, 0));
+
+  return SVN_NO_ERROR;
+}
+
+/* Core of svn_ra_svn__mux_accept.  The caller must hold the mutex. */
+static svn_error_t *
+accept_locked(svn_ra_svn_conn_t **channel,
+              svn_ra_svn__mux_t *mux,
+              apr_pool_t *result_pool)
+{
+  SVN_ERR(wait_locked(mux, has_incoming, mux));
+
+  if (mux->incoming->nelts)
+    {
+      channel_t *accepted = APR_ARRAY_IDX(mux->incoming, 0, channel_t *);
+      svn_sort__array_delete(mux->incoming, 0, 1);
+
+      *channel = channel_conn(accepted, result_pool);
+    }
+  else
+    {
+      *channel = NULL;
+    }
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_ra_svn__mux_accept(svn_ra_svn_conn_t **channel,
+                       svn_ra_svn_conn_t *conn,
+                       apr_pool_t *result_pool)
+{
+  svn_ra_svn__mux_t *mux = conn->mux;
+
+  SVN_ERR_ASSERT(mux);
+
+  SVN_MUTEX__WITH_LOCK(mux->mutex,
+                       accept_locked(channel, mux, result_pool));
+
+  return SVN_NO_ERROR;
+}
@@ -53,6 +53,13 @@ typedef void (*ra_svn_timeout_fn_t)(void *baton, apr_interval_time_t timeout);
  */
 typedef struct svn_ra_svn__stream_st svn_ra_svn__stream_t;
 
+/* Multiplexer carrying several connections over a single stream.
+ * See mux.c. */
+typedef struct svn_ra_svn__mux_t svn_ra_svn__mux_t;
+
+/* TLS layer of a connection.  See tls.c. */
+typedef struct svn_ra_svn__tls_t svn_ra_svn__tls_t;
+
 /* Handler for blocked writes. */
 typedef svn_error_t *(*ra_svn_block_handler_t)(svn_ra_svn_conn_t *conn,
                                                apr_pool_t *pool,
@@ -115,6 +122,26 @@ struct svn_ra_svn_conn_st {
   int compression_level;
   apr_size_t zero_copy_limit;
 
+  /* Socket that file contents may be sent to directly, bypassing our
+     buffers and STREAM.  NULL if STREAM is not a plain socket stream. */
+  apr_socket_t *sendfile_sock;
+
+  /* Number of bytes sent through SENDFILE_SOCK so far. */
+  apr_uint64_t sendfile_bytes;
+
+  /* Multiplexer that STREAM belongs to.  NULL if not multiplexed. */
+  svn_ra_svn__mux_t *mux;
+
+  /* TLS layer that STREAM goes through.  NULL if not encrypted by TLS. */
+  svn_ra_svn__tls_t *tls;
+
+  /* Output written since svn_ra_svn__start_recording(), not counting the
+     first RECORDING_SKIP bytes that were already buffered at that time.
+     NULL if not recording or if the output exceeded RECORDING_LIMIT. */
+  svn_stringbuf_t *recording;
+  apr_size_t recording_skip;
+  apr_size_t recording_limit;
+
   /* who's on the other side of the connection? */
   char *remote_ip;
 
@@ -160,6 +187,10 @@ struct svn_ra_svn__session_baton_t {
   apr_off_t bytes_read, bytes_written; /* apr_off_t's because that's what
                                           the callback interface uses */
   const char *useragent;
+
+  /* TRUE, if the server will not send any further auth challenges.
+     Only then may we pipeline commands. */
+  svn_boolean_t auth_settled;
 };
 
 /* Set a callback for blocked writes on conn.  This handler may
@@ -175,22 +206,11 @@ void svn_ra_svn__set_block_handler(svn_ra_svn_conn_t *conn,
 svn_error_t *svn_ra_svn__data_available(svn_ra_svn_conn_t *conn,
                                        svn_boolean_t *data_available);
 
-/* Signal a new request / response pair on CONN.  That resets the I/O
- * counters we use to limit the size of individual requests / response pairs.
- */
-void
-svn_ra_svn__reset_command_io_counters(svn_ra_svn_conn_t *conn);
-
 /* CRAM-MD5 client implementation. */
 svn_error_t *svn_ra_svn__cram_client(svn_ra_svn_conn_t *conn, apr_pool_t *pool,
                                      const char *user, const char *password,
                                      const char **message);
 
-/* Return a pointer to the error chain child of ERR which contains the
- * first "real" error message, not merely one of the
- * SVN_ERR_RA_SVN_CMD_ERR wrapper errors. */
-svn_error_t *svn_ra_svn__locate_real_error_child(svn_error_t *err);
-
 /* Return an error chain based on @a params (which contains a
  * command response indicating failure).  The error chain will be
  * in the same order as the errors indicated in @a params. */
@@ -222,6 +242,14 @@ svn_ra_svn__stream_t *svn_ra_svn__stream_create(svn_stream_t *in_stream,
 svn_error_t *svn_ra_svn__stream_write(svn_ra_svn__stream_t *stream,
                                       const char *data, apr_size_t *len);
 
+/* Write the NVEC buffers in VEC to STREAM, returning the total number of
+ * bytes written in *LEN.  Socket streams send all buffers at once, other
+ * streams may write less than the first non-empty buffer.
+ */
+svn_error_t *svn_ra_svn__stream_writev(svn_ra_svn__stream_t *stream,
+                                       const struct iovec *vec, int nvec,
+                                       apr_size_t *len);
+
 /* Read *LEN bytes from STREAM into DATA, returning the number of bytes
  * read in *LEN.
  */
@@ -0,0 +1,964 @@
+/*
+ * tls.c :  TLS transport for the ra_svn protocol, based on OpenSSL
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+#include "svn_private_config.h"
+#ifdef SVN_HAVE_OPENSSL
+
+#define APR_WANT_STRFUNC
+#include <apr_want.h>
+#include <apr_general.h>
+#include <apr_strings.h>
+
+#include <openssl/bio.h>
+#include <openssl/err.h>
+#include <openssl/evp.h>
+#include <openssl/ssl.h>
+#include <openssl/x509.h>
+#include <openssl/x509v3.h>
+
+#include "svn_types.h"
+#include "svn_string.h"
+#include "svn_error.h"
+#include "svn_pools.h"
+#include "svn_auth.h"
+#include "svn_base64.h"
+#include "svn_dirent_uri.h"
+#include "svn_hash.h"
+#include "svn_path.h"
+
+#include "private/svn_atomic.h"
+#include "private/svn_mutex.h"
+
+#include "ra_svn.h"
+
+/* OpenSSL never puts more than this into a single TLS record. */
+#define TLS_MAX_WRITE 16384
+
+/* Ciphers that we allow for TLS 1.2.  TLS 1.3 suites are all fine. */
+#define TLS_CIPHER_LIST "ECDHE+AESGCM:ECDHE+CHACHA20"
+
+struct svn_ra_svn__tls_ctx_t
+{
+  SSL_CTX *ssl_ctx;
+
+  /* TRUE for svnserve, FALSE for clients. */
+  svn_boolean_t is_server;
+};
+
+/* Per-connection state, hooked up as CONN->TLS.  The connection's stream
+ * gets replaced by one that encrypts through SSL and passes the resulting
+ * records on to the original STREAM.  SSL talks to memory BIOs only,
+ * so all actual I/O goes through the original stream and keeps its
+ * timeout and data_available behavior.
+ *
+ * A multiplexed connection reads in one thread and writes in others.
+ * MUTEX serializes all access to SSL and the BIOs.  It is never held
+ * while waiting for the network.  Encrypted output produced while
+ * reading gets sent along with the next write.
+ */
+struct svn_ra_svn__tls_t
+{
+  svn_ra_svn__stream_t *stream; /* Inherited stream. */
+  SSL *ssl;
+  BIO *rbio;                    /* Network data not yet decrypted. */
+  BIO *wbio;                    /* Encrypted data not yet taken out. */
+  svn_mutex__t *mutex;
+
+  /* Client-side verification results. */
+  const char *session_key;      /* "host:port" of the server. */
+  apr_uint32_t failures;        /* SVN_AUTH_SSL_* flags. */
+  svn_boolean_t trusted;        /* Sessions may be resumed. */
+  SSL_SESSION *pending_session; /* Received before being trusted. */
+
+  /* Plaintext bytes encrypted by a write that could not be sent
+     completely.  The next call repeats that write. */
+  apr_size_t write_consumed;
+
+  /* Encrypted data taken out of WBIO but not sent yet. */
+  char out_buf[TLS_MAX_WRITE];
+  const char *out_ptr;
+  apr_size_t out_len;
+
+  /* Buffer for reading from STREAM. */
+  char in_buf[SVN_RA_SVN__READBUF_SIZE];
+};
+
+/* Return an error with MESSAGE and the reason given by OpenSSL's error
+   queue.  Clear that queue. */
+static svn_error_t *
+tls_error(const char *message)
+{
+  unsigned long code = ERR_get_error();
+  char reason[256];
+
+  ERR_clear_error();
+  if (code == 0)
+    return svn_error_create(SVN_ERR_RA_SVN_TLS_ERROR, NULL, message);
+
+  ERR_error_string_n(code, reason, sizeof(reason));
+  return svn_error_createf(SVN_ERR_RA_SVN_TLS_ERROR, NULL, "%s: %s",
+                           message, reason);
+}
+
+
+/*** Client-side session cache. ***/
+
+/* Sessions of trusted servers, keyed by "host:port", for resumption by
+ * later connections within this process.  Each entry holds a reference
+ * to its SSL_SESSION.  All of this is protected by SESSION_CACHE_MUTEX.
+ */
+static volatile svn_atomic_t session_cache_status = 0;
+static svn_mutex__t *session_cache_mutex = NULL;
+static apr_hash_t *session_cache = NULL;
+
+/* Implements svn_atomic__init_once_fn_t. */
+static svn_error_t *
+init_session_cache(void *baton,
+                   apr_pool_t *scratch_pool)
+{
+  /* Lives as long as the process. */
+  apr_pool_t *pool = svn_pool_create(NULL);
+
+  SVN_ERR(svn_mutex__init(&session_cache_mutex, TRUE, pool));
+  session_cache = apr_hash_make(pool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Store SESSION for KEY, taking over the caller's reference.
+   The caller must hold SESSION_CACHE_MUTEX. */
+static svn_error_t *
+store_session_locked(const char *key,
+                     SSL_SESSION *session)
+{
+  SSL_SESSION *old_session = svn_hash_gets(session_cache, key);
+
+  if (old_session)
+    {
+      SSL_SESSION_free(old_session);
+      svn_hash_sets(session_cache, key, session);
+    }
+  else
+    {
+      apr_pool_t *pool = apr_hash_pool_get(session_cache);
+      svn_hash_sets(session_cache, apr_pstrdup(pool, key), session);
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Store SESSION for KEY, taking over the caller's reference. */
+static svn_error_t *
+store_session(const char *key,
+              SSL_SESSION *session)
+{
+  SVN_MUTEX__WITH_LOCK(session_cache_mutex,
+                       store_session_locked(key, session));
+
+  return SVN_NO_ERROR;
+}
+
+/* Set *SESSION to a new reference to the session stored for KEY or to
+   NULL.  The caller must hold SESSION_CACHE_MUTEX. */
+static svn_error_t *
+find_session_locked(SSL_SESSION **session,
+                    const char *key)
+{
+  *session = svn_hash_gets(session_cache, key);
+  if (*session && !SSL_SESSION_up_ref(*session))
+    *session = NULL;
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements the new_session_cb of SSL_CTX_sess_set_new_cb().  Servers
+ * send session tickets during the TLS 1.2 handshake, i.e. before we get
+ * to verify the server certificate, but TLS 1.3 tickets only arrive with
+ * the first data read afterwards.  Keep early sessions until we know
+ * whether the server can be trusted.
+ */
+static int
+new_session_cb(SSL *ssl,
+               SSL_SESSION *session)
+{
+  svn_ra_svn__tls_t *tls = SSL_get_app_data(ssl);
+
+  if (!tls || !tls->session_key)
+    return 0;
+
+  if (tls->trusted)
+    {
+      /* Can only fail to lock the mutex.  Then, we just lose the session. */
+      svn_error_clear(store_session(tls->session_key, session));
+    }
+  else
+    {
+      if (tls->pending_session)
+        SSL_SESSION_free(tls->pending_session);
+      tls->pending_session = session;
+    }
+
+  /* We took over the reference. */
+  return 1;
+}
+
+
+/*** The TLS stream. ***/
+
+/* Take the next chunk of encrypted output out of TLS->WBIO.
+   The caller must hold TLS->MUTEX. */
+static svn_error_t *
+take_output_locked(svn_ra_svn__tls_t *tls)
+{
+  int len = BIO_read(tls->wbio, tls->out_buf, sizeof(tls->out_buf));
+
+  tls->out_ptr = tls->out_buf;
+  tls->out_len = len > 0 ? len : 0;
+
+  return SVN_NO_ERROR;
+}
+
+/* Send all encrypted output of TLS to its inner stream.  If the inner
+   stream does not take all of it, set *BLOCKED and keep the rest. */
+static svn_error_t *
+send_output(svn_boolean_t *blocked,
+            svn_ra_svn__tls_t *tls)
+{
+  while (TRUE)
+    {
+      apr_size_t len;
+
+      if (tls->out_len == 0)
+        {
+          SVN_MUTEX__WITH_LOCK(tls->mutex, take_output_locked(tls));
+          if (tls->out_len == 0)
+            break;
+        }
+
+      len = tls->out_len;
+      SVN_ERR(svn_ra_svn__stream_write(tls->stream, tls->out_ptr, &len));
+      if (len == 0)
+        {
+          *blocked = TRUE;
+          return SVN_NO_ERROR;
+        }
+
+      tls->out_ptr += len;
+      tls->out_len -= len;
+    }
+
+  *blocked = FALSE;
+  return SVN_NO_ERROR;
+}
+
+/* Read more encrypted data from the inner stream of TLS and hand it to
+   OpenSSL. */
+static svn_error_t *
+receive_input(svn_ra_svn__tls_t *tls)
+{
+  apr_size_t len = sizeof(tls->in_buf);
+
+  /* Does not return with LEN == 0. */
+  SVN_ERR(svn_ra_svn__stream_read(tls->stream, tls->in_buf, &len));
+
+  SVN_MUTEX__WITH_LOCK(tls->mutex,
+                       BIO_write(tls->rbio, tls->in_buf, (int)len) == (int)len
+                         ? SVN_NO_ERROR
+                         : tls_error(_("Can't buffer TLS data")));
+
+  return SVN_NO_ERROR;
+}
+
+/* Baton for ssl_read_locked. */
+typedef struct read_baton_t
+{
+  char *buffer;
+  int len;
+  int result;
+  int code;
+} read_baton_t;
+
+/* Decrypt up to B->LEN bytes into B->BUFFER and set B->RESULT and B->CODE
+   to the return value of SSL_read and to its SSL_get_error code.
+   The caller must hold TLS->MUTEX. */
+static svn_error_t *
+ssl_read_locked(read_baton_t *b,
+                svn_ra_svn__tls_t *tls)
+{
+  ERR_clear_error();
+  b->result = SSL_read(tls->ssl, b->buffer, b->len);
+  b->code = b->result > 0 ? SSL_ERROR_NONE
+                          : SSL_get_error(tls->ssl, b->result);
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_read_fn_t. */
+static svn_error_t *
+tls_read_cb(void *baton,
+            char *buffer,
+            apr_size_t *len)
+{
+  svn_ra_svn__tls_t *tls = baton;
+  read_baton_t b;
+
+  b.buffer = buffer;
+  b.len = *len > APR_INT32_MAX ? APR_INT32_MAX : (int)*len;
+
+  while (TRUE)
+    {
+      SVN_MUTEX__WITH_LOCK(tls->mutex, ssl_read_locked(&b, tls));
+      if (b.result > 0)
+        {
+          *len = b.result;
+          return SVN_NO_ERROR;
+        }
+
+      /* The peer closed the TLS session. */
+      if (b.code == SSL_ERROR_ZERO_RETURN)
+        {
+          *len = 0;
+          return SVN_NO_ERROR;
+        }
+
+      if (b.code != SSL_ERROR_WANT_READ)
+        return svn_error_trace(tls_error(_("Can't read from TLS "
+                                           "connection")));
+
+      SVN_ERR(receive_input(tls));
+    }
+}
+
+/* Encrypt the LEN bytes at DATA into TLS->WBIO.
+   The caller must hold TLS->MUTEX. */
+static svn_error_t *
+ssl_write_locked(svn_ra_svn__tls_t *tls,
+                 const char *data,
+                 apr_size_t len)
+{
+  /* Writes to memory BIOs are never partial. */
+  ERR_clear_error();
+  if (SSL_write(tls->ssl, data, (int)len) != (int)len)
+    return svn_error_trace(tls_error(_("Can't write to TLS connection")));
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_write_fn_t. */
+static svn_error_t *
+tls_write_cb(void *baton,
+             const char *buffer,
+             apr_size_t *len)
+{
+  svn_ra_svn__tls_t *tls = baton;
+  svn_boolean_t blocked;
+
+  if (*len == 0)
+    return SVN_NO_ERROR;
+
+  /* Unless this repeats a blocked write, encrypt new data. */
+  if (tls->write_consumed == 0)
+    {
+      apr_size_t to_write = *len > TLS_MAX_WRITE ? TLS_MAX_WRITE : *len;
+
+      SVN_MUTEX__WITH_LOCK(tls->mutex,
+                           ssl_write_locked(tls, buffer, to_write));
+      tls->write_consumed = to_write;
+    }
+
+  SVN_ERR(send_output(&blocked, tls));
+  if (blocked)
+    {
+      /* The output stays in TLS and gets sent by the next call, which
+         will have the same arguments. */
+      *len = 0;
+      return SVN_NO_ERROR;
+    }
+
+  *len = tls->write_consumed;
+  tls->write_consumed = 0;
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements ra_svn_timeout_fn_t. */
+static void
+tls_timeout_cb(void *baton,
+               apr_interval_time_t interval)
+{
+  svn_ra_svn__tls_t *tls = baton;
+  svn_ra_svn__stream_timeout(tls->stream, interval);
+}
+
+/* Set *DATA_AVAILABLE if TLS has data that has not been read, yet.
+   The caller must hold TLS->MUTEX. */
+static svn_error_t *
+has_pending_locked(svn_boolean_t *data_available,
+                   svn_ra_svn__tls_t *tls)
+{
+  *data_available = SSL_pending(tls->ssl) > 0
+                 || BIO_ctrl_pending(tls->rbio) > 0;
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_stream_data_available_fn_t.  Like with SASL, a single
+   TLS record may carry more data than the caller read. */
+static svn_error_t *
+tls_data_available_cb(void *baton,
+                      svn_boolean_t *data_available)
+{
+  svn_ra_svn__tls_t *tls = baton;
+
+  SVN_MUTEX__WITH_LOCK(tls->mutex, has_pending_locked(data_available, tls));
+  if (*data_available)
+    return SVN_NO_ERROR;
+
+  return svn_error_trace(svn_ra_svn__stream_data_available(tls->stream,
+                                                           data_available));
+}
+
+/* Pool cleanup for svn_ra_svn__tls_t. */
+static apr_status_t
+tls_cleanup(void *data)
+{
+  svn_ra_svn__tls_t *tls = data;
+
+  if (tls->pending_session)
+    SSL_SESSION_free(tls->pending_session);
+
+  /* Also frees the BIOs. */
+  SSL_free(tls->ssl);
+
+  return APR_SUCCESS;
+}
+
+/* Create the TLS state for CONN using CTX and return it in *TLS_P.
+   Allocate it in the connection's pool. */
+static svn_error_t *
+tls_create(svn_ra_svn__tls_t **tls_p,
+           svn_ra_svn_conn_t *conn,
+           svn_ra_svn__tls_ctx_t *ctx)
+{
+  svn_ra_svn__tls_t *tls = apr_pcalloc(conn->pool, sizeof(*tls));
+
+  SVN_ERR(svn_mutex__init(&tls->mutex, TRUE, conn->pool));
+
+  ERR_clear_error();
+  tls->ssl = SSL_new(ctx->ssl_ctx);
+  if (!tls->ssl)
+    return svn_error_trace(tls_error(_("Can't create TLS connection")));
+
+  tls->rbio = BIO_new(BIO_s_mem());
+  tls->wbio = BIO_new(BIO_s_mem());
+  if (!tls->rbio || !tls->wbio)
+    {
+      BIO_free(tls->rbio);
+      BIO_free(tls->wbio);
+      SSL_free(tls->ssl);
+      return svn_error_trace(tls_error(_("Can't create TLS connection")));
+    }
+
+  /* Running out of data means "try again", not EOF. */
+  BIO_set_mem_eof_return(tls->rbio, -1);
+  BIO_set_mem_eof_return(tls->wbio, -1);
+  SSL_set_bio(tls->ssl, tls->rbio, tls->wbio);
+  SSL_set_app_data(tls->ssl, tls);
+
+  apr_pool_cleanup_register(conn->pool, tls, tls_cleanup,
+                            apr_pool_cleanup_null);
+  *tls_p = tls;
+
+  return SVN_NO_ERROR;
+}
+
+/* Run the TLS handshake for TLS over the stream of CONN, then make CONN
+   use TLS for all further data.  Use SCRATCH_POOL for temporary
+   allocations. */
+static svn_error_t *
+tls_start(svn_ra_svn_conn_t *conn,
+          svn_ra_svn__tls_t *tls,
+          apr_pool_t *scratch_pool)
+{
+  svn_stream_t *tls_in, *tls_out;
+
+  /* Flush the connection, as we're about to replace its stream. */
+  SVN_ERR(svn_ra_svn__flush(conn, scratch_pool));
+  tls->stream = conn->stream;
+
+  /* The peer may have started the handshake already. */
+  if (conn->read_end > conn->read_ptr)
+    {
+      int len = (int)(conn->read_end - conn->read_ptr);
+      if (BIO_write(tls->rbio, conn->read_ptr, len) != len)
+        return svn_error_trace(tls_error(_("Can't buffer TLS data")));
+
+      conn->read_ptr = conn->read_buf;
+      conn->read_end = conn->read_buf;
+    }
+
+  /* Nobody else uses the connection during the handshake,
+     so we don't lock TLS->MUTEX here. */
+  while (TRUE)
+    {
+      svn_boolean_t blocked;
+      int result, code;
+
+      ERR_clear_error();
+      result = SSL_do_handshake(tls->ssl);
+      code = result == 1 ? SSL_ERROR_NONE : SSL_get_error(tls->ssl, result);
+
+      /* Send whatever the handshake produced.  The stream is blocking at
+         this point, so we only need to loop for very large outputs. */
+      do
+        SVN_ERR(send_output(&blocked, tls));
+      while (blocked);
+
+      if (result == 1)
+        break;
+
+      if (code != SSL_ERROR_WANT_READ)
+        return svn_error_trace(tls_error(_("TLS handshake failed")));
+
+      SVN_ERR(receive_input(tls));
+    }
+
+  tls_in = svn_stream_create(tls, conn->pool);
+  tls_out = svn_stream_create(tls, conn->pool);
+  svn_stream_set_read2(tls_in, tls_read_cb, NULL /* use default */);
+  svn_stream_set_data_available(tls_in, tls_data_available_cb);
+  svn_stream_set_write(tls_out, tls_write_cb);
+
+  conn->stream = svn_ra_svn__stream_create(tls_in, tls_out, tls,
+                                           tls_timeout_cb, conn->pool);
+  conn->tls = tls;
+
+  /* All data must pass through that layer from now on. */
+  conn->sendfile_sock = NULL;
+
+  return SVN_NO_ERROR;
+}
+
+
+/*** TLS contexts. ***/
+
+/* Pool cleanup for svn_ra_svn__tls_ctx_t. */
+static apr_status_t
+ctx_cleanup(void *data)
+{
+  svn_ra_svn__tls_ctx_t *ctx = data;
+  SSL_CTX_free(ctx->ssl_ctx);
+
+  return APR_SUCCESS;
+}
+
+/* Create a TLS context for servers if IS_SERVER is set and for clients
+   otherwise.  Apply our common settings and return it in *CTX, allocated
+   in RESULT_POOL. */
+static svn_error_t *
+ctx_create(svn_ra_svn__tls_ctx_t **ctx,
+           svn_boolean_t is_server,
+           apr_pool_t *result_pool)
+{
+  svn_ra_svn__tls_ctx_t *new_ctx = apr_pcalloc(result_pool, sizeof(*new_ctx));
+
+  ERR_clear_error();
+  new_ctx->is_server = is_server;
+  new_ctx->ssl_ctx = SSL_CTX_new(is_server ? TLS_server_method()
+                                           : TLS_client_method());
+  if (!new_ctx->ssl_ctx)
+    return svn_error_trace(tls_error(_("Can't create TLS context")));
+
+  apr_pool_cleanup_register(result_pool, new_ctx, ctx_cleanup,
+                            apr_pool_cleanup_null);
+
+  if (!SSL_CTX_set_min_proto_version(new_ctx->ssl_ctx, TLS1_2_VERSION)
+      || !SSL_CTX_set_cipher_list(new_ctx->ssl_ctx, TLS_CIPHER_LIST))
+    return svn_error_trace(tls_error(_("Can't configure TLS context")));
+
+  SSL_CTX_set_options(new_ctx->ssl_ctx,
+                      SSL_OP_NO_COMPRESSION | SSL_OP_NO_RENEGOTIATION
+                      | (is_server ? SSL_OP_CIPHER_SERVER_PREFERENCE : 0));
+
+  *ctx = new_ctx;
+
+  return SVN_NO_ERROR;
+}
+
+/* Convert the UTF-8 encoded path PATH into the local style and encoding
+   expected by OpenSSL and return it in *LOCAL_PATH, allocated in POOL. */
+static svn_error_t *
+local_path(const char **local_path,
+           const char *path,
+           apr_pool_t *pool)
+{
+  return svn_error_trace(
+           svn_path_cstring_from_utf8(local_path,
+                                      svn_dirent_local_style(path, pool),
+                                      pool));
+}
+
+svn_error_t *
+svn_ra_svn__tls_server_ctx_create(svn_ra_svn__tls_ctx_t **ctx,
+                                  const char *cert_file,
+                                  const char *key_file,
+                                  apr_pool_t *result_pool)
+{
+  static const unsigned char session_id_context[] = "svnserve";
+  svn_ra_svn__tls_ctx_t *new_ctx;
+  const char *local_cert_file, *local_key_file;
+
+  SVN_ERR(ctx_create(&new_ctx, TRUE, result_pool));
+  SVN_ERR(local_path(&local_cert_file, cert_file, result_pool));
+  SVN_ERR(local_path(&local_key_file, key_file, result_pool));
+
+  ERR_clear_error();
+  if (!SSL_CTX_use_certificate_chain_file(new_ctx->ssl_ctx, local_cert_file))
+    return svn_error_trace(
+             svn_error_quick_wrapf(tls_error(_("Can't load certificate")),
+                                   _("Can't use '%s'"),
+                                   svn_dirent_local_style(cert_file,
+                                                          result_pool)));
+
+  if (!SSL_CTX_use_PrivateKey_file(new_ctx->ssl_ctx, local_key_file,
+                                   SSL_FILETYPE_PEM)
+      || !SSL_CTX_check_private_key(new_ctx->ssl_ctx))
+    return svn_error_trace(
+             svn_error_quick_wrapf(tls_error(_("Can't load private key")),
+                                   _("Can't use '%s'"),
+                                   svn_dirent_local_style(key_file,
+                                                          result_pool)));
+
+  /* Resumption needs a session id context.  Session tickets are encrypted
+     with keys generated for this context, so forked children that
+     inherit it accept each other's tickets. */
+  if (!SSL_CTX_set_session_id_context(new_ctx->ssl_ctx, session_id_context,
+                                      sizeof(session_id_context) - 1))
+    return svn_error_trace(tls_error(_("Can't configure TLS context")));
+
+  *ctx = new_ctx;
+
+  return SVN_NO_ERROR;
+}
+
+/* Map the OpenSSL certificate verification error CODE to SVN_AUTH_SSL_*
+   flags. */
+static apr_uint32_t
+convert_verify_error(int code)
+{
+  switch (code)
+    {
+      case X509_V_ERR_CERT_NOT_YET_VALID:
+        return SVN_AUTH_SSL_NOTYETVALID;
+
+      case X509_V_ERR_CERT_HAS_EXPIRED:
+        return SVN_AUTH_SSL_EXPIRED;
+
+      case X509_V_ERR_HOSTNAME_MISMATCH:
+      case X509_V_ERR_IP_ADDRESS_MISMATCH:
+        return SVN_AUTH_SSL_CNMISMATCH;
+
+      case X509_V_ERR_DEPTH_ZERO_SELF_SIGNED_CERT:
+      case X509_V_ERR_SELF_SIGNED_CERT_IN_CHAIN:
+      case X509_V_ERR_UNABLE_TO_GET_ISSUER_CERT:
+      case X509_V_ERR_UNABLE_TO_GET_ISSUER_CERT_LOCALLY:
+      case X509_V_ERR_UNABLE_TO_VERIFY_LEAF_SIGNATURE:
+      case X509_V_ERR_CERT_UNTRUSTED:
+        return SVN_AUTH_SSL_UNKNOWNCA;
+
+      default:
+        return SVN_AUTH_SSL_OTHER;
+    }
+}
+
+/* Implements the verify_callback of SSL_CTX_set_verify().  Collect all
+   problems in the connection's FAILURES and let the handshake continue,
+   so the user can decide whether to trust the server anyway. */
+static int
+verify_cb(int preverify_ok,
+          X509_STORE_CTX *store_ctx)
+{
+  SSL *ssl = X509_STORE_CTX_get_ex_data(store_ctx,
+                                        SSL_get_ex_data_X509_STORE_CTX_idx());
+  svn_ra_svn__tls_t *tls = ssl ? SSL_get_app_data(ssl) : NULL;
+
+  if (!preverify_ok && tls)
+    tls->failures
+      |= convert_verify_error(X509_STORE_CTX_get_error(store_ctx));
+
+  return 1;
+}
+
+svn_error_t *
+svn_ra_svn__tls_client_ctx_create(svn_ra_svn__tls_ctx_t **ctx,
+                                  svn_boolean_t trust_default_ca,
+                                  const char *authority_files,
+                                  apr_pool_t *result_pool)
+{
+  svn_ra_svn__tls_ctx_t *new_ctx;
+
+  SVN_ERR(ctx_create(&new_ctx, FALSE, result_pool));
+
+  ERR_clear_error();
+  if (trust_default_ca
+      && !SSL_CTX_set_default_verify_paths(new_ctx->ssl_ctx))
+    return svn_error_trace(tls_error(_("Can't load the default "
+                                       "certificate authorities")));
+
+  if (authority_files)
+    {
+      apr_array_header_t *files = svn_cstring_split(authority_files, ";",
+                                                    TRUE, result_pool);
+      int i;
+
+      for (i = 0; i < files->nelts; i++)
+        {
+          const char *file = APR_ARRAY_IDX(files, i, const char *);
+          const char *local_file;
+
+          SVN_ERR(local_path(&local_file, file, result_pool));
+          if (!SSL_CTX_load_verify_locations(new_ctx->ssl_ctx, local_file,
+                                             NULL))
+            return svn_error_trace(
+                     svn_error_quick_wrapf(
+                       tls_error(_("Can't load certificate authority")),
+                       _("Can't use '%s'"),
+                       svn_dirent_local_style(file, result_pool)));
+        }
+    }
+
+  SSL_CTX_set_verify(new_ctx->ssl_ctx, SSL_VERIFY_PEER, verify_cb);
+
+  /* We keep sessions ourselves, see new_session_cb. */
+  SSL_CTX_set_session_cache_mode(new_ctx->ssl_ctx,
+                                 SSL_SESS_CACHE_CLIENT
+                                 | SSL_SESS_CACHE_NO_INTERNAL_STORE);
+  SSL_CTX_sess_set_new_cb(new_ctx->ssl_ctx, new_session_cb);
+
+  *ctx = new_ctx;
+
+  return SVN_NO_ERROR;
+}
+
+
+/*** Handshakes. ***/
+
+svn_error_t *
+svn_ra_svn__tls_accept(svn_ra_svn_conn_t *conn,
+                       svn_ra_svn__tls_ctx_t *ctx,
+                       apr_pool_t *scratch_pool)
+{
+  svn_ra_svn__tls_t *tls;
+
+  SVN_ERR_ASSERT(ctx->is_server && !conn->tls);
+
+  SVN_ERR(tls_create(&tls, conn, ctx));
+  SSL_set_accept_state(tls->ssl);
+
+  return svn_error_trace(tls_start(conn, tls, scratch_pool));
+}
+
+svn_error_t *
+svn_ra_svn__tls_connect(apr_uint32_t *failures,
+                        svn_boolean_t *resumed,
+                        svn_ra_svn_conn_t *conn,
+                        svn_ra_svn__tls_ctx_t *ctx,
+                        const char *hostname,
+                        int port,
+                        apr_pool_t *scratch_pool)
+{
+  svn_ra_svn__tls_t *tls;
+  X509_VERIFY_PARAM *param;
+  SSL_SESSION *session;
+
+  SVN_ERR_ASSERT(!ctx->is_server && !conn->tls);
+
+  SVN_ERR(svn_atomic__init_once(&session_cache_status, init_session_cache,
+                                NULL, scratch_pool));
+
+  SVN_ERR(tls_create(&tls, conn, ctx));
+  tls->session_key = apr_psprintf(conn->pool, "%s:%d", hostname, port);
+  SSL_set_connect_state(tls->ssl);
+
+  /* Check the certificate against HOSTNAME, which may be an IP address.
+     Only real host names get sent for SNI. */
+  ERR_clear_error();
+  param = SSL_get0_param(tls->ssl);
+  if (!X509_VERIFY_PARAM_set1_ip_asc(param, hostname))
+    {
+      ERR_clear_error();
+      if (!X509_VERIFY_PARAM_set1_host(param, hostname, 0)
+          || !SSL_set_tlsext_host_name(tls->ssl, hostname))
+        return svn_error_trace(tls_error(_("Can't configure TLS "
+                                           "connection")));
+    }
+
+  SVN_MUTEX__WITH_LOCK(session_cache_mutex,
+                       find_session_locked(&session, tls->session_key));
+  if (session)
+    {
+      /* Takes its own reference. */
+      SSL_set_session(tls->ssl, session);
+      SSL_SESSION_free(session);
+    }
+
+  SVN_ERR(tls_start(conn, tls, scratch_pool));
+
+  /* The certificate of a resumed session has been trusted before.
+     OpenSSL does not verify it again. */
+  if (SSL_session_reused(tls->ssl))
+    {
+      SVN_ERR(svn_ra_svn__tls_set_trusted(conn));
+      tls->failures = 0;
+    }
+
+  *failures = tls->failures;
+  if (resumed)
+    *resumed = SSL_session_reused(tls->ssl);
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_ra_svn__tls_set_trusted(svn_ra_svn_conn_t *conn)
+{
+  svn_ra_svn__tls_t *tls = conn->tls;
+  SSL_SESSION *session;
+
+  SVN_ERR_ASSERT(tls);
+  if (tls->trusted)
+    return SVN_NO_ERROR;
+
+  tls->trusted = TRUE;
+  session = tls->pending_session;
+  tls->pending_session = NULL;
+  if (session)
+    SVN_ERR(store_session(tls->session_key, session));
+
+  return SVN_NO_ERROR;
+}
+
+/* Return the text that ASN1_TIME_print() gives for TIME, allocated in
+   POOL, or a placeholder if that fails. */
+static const char *
+time_to_cstring(const ASN1_TIME *time,
+                apr_pool_t *pool)
+{
+  BIO *bio = BIO_new(BIO_s_mem());
+  const char *result = NULL;
+
+  if (bio && ASN1_TIME_print(bio, time))
+    {
+      char *data;
+      long len = BIO_get_mem_data(bio, &data);
+      result = apr_pstrmemdup(pool, data, len);
+    }
+
+  BIO_free(bio);
+  return result ? result : "[invalid date]";
+}
+
+/* Return the one-line form of NAME, allocated in POOL. */
+static const char *
+name_to_cstring(X509_NAME *name,
+                apr_pool_t *pool)
+{
+  BIO *bio = BIO_new(BIO_s_mem());
+  const char *result = NULL;
+
+  if (bio && X509_NAME_print_ex(bio, name, 0, XN_FLAG_ONELINE) >= 0)
+    {
+      char *data;
+      long len = BIO_get_mem_data(bio, &data);
+      result = apr_pstrmemdup(pool, data, len);
+    }
+
+  BIO_free(bio);
+  return result ? result : "";
+}
+
+svn_error_t *
+svn_ra_svn__tls_get_server_cert(svn_auth_ssl_server_cert_info_t **cert_info,
+                                svn_ra_svn_conn_t *conn,
+                                apr_pool_t *result_pool)
+{
+  svn_auth_ssl_server_cert_info_t *info;
+  svn_stringbuf_t *fingerprint;
+  unsigned char digest[EVP_MAX_MD_SIZE];
+  unsigned int digest_len = 0;
+  unsigned char *der = NULL;
+  char common_name[256];
+  X509 *cert;
+  int der_len;
+  unsigned int i;
+
+  SVN_ERR_ASSERT(conn->tls);
+
+  cert = SSL_get_peer_certificate(conn->tls->ssl);
+  if (!cert)
+    return svn_error_create(SVN_ERR_RA_SVN_TLS_ERROR, NULL,
+                            _("Server did not send a certificate"));
+
+  info = apr_pcalloc(result_pool, sizeof(*info));
+
+  if (X509_NAME_get_text_by_NID(X509_get_subject_name(cert), NID_commonName,
+                                common_name, sizeof(common_name)) >= 0)
+    info->hostname = apr_pstrdup(result_pool, common_name);
+  else
+    info->hostname = "";
+
+  fingerprint = svn_stringbuf_create_empty(result_pool);
+  if (X509_digest(cert, EVP_sha1(), digest, &digest_len))
+    for (i = 0; i < digest_len; i++)
+      svn_stringbuf_appendcstr(fingerprint,
+                               apr_psprintf(result_pool, i ? ":%02X" : "%02X",
+                                            digest[i]));
+  info->fingerprint = fingerprint->len ? fingerprint->data : "<unknown>";
+
+  info->valid_from = time_to_cstring(X509_get0_notBefore(cert), result_pool);
+  info->valid_until = time_to_cstring(X509_get0_notAfter(cert), result_pool);
+  info->issuer_dname = name_to_cstring(X509_get_issuer_name(cert),
+                                       result_pool);
+
+  der_len = i2d_X509(cert, &der);
+  if (der_len > 0)
+    {
+      const svn_string_t *ascii_cert
+        = svn_base64_encode_string2(svn_string_ncreate((const char *)der,
+                                                       der_len, result_pool),
+                                    FALSE, result_pool);
+      info->ascii_cert = ascii_cert->data;
+      OPENSSL_free(der);
+    }
+  else
+    {
+      info->ascii_cert = "";
+    }
+
+  X509_free(cert);
+  *cert_info = info;
+
+  return SVN_NO_ERROR;
+}
+
+#endif /* SVN_HAVE_OPENSSL */
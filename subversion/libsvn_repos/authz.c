@@ -1653,6 +1653,30 @@ svn_repos_authz_read4(svn_authz_t **authz_p,
 }
 
 
+const char *
+svn_repos__authz_id(const svn_authz_t *authz,
+                    apr_pool_t *result_pool)
+{
+  static const char hex[] = "0123456789abcdef";
+  const unsigned char *data;
+  char *result;
+  apr_size_t i;
+
+  if (!authz->authz_id)
+    return NULL;
+
+  data = authz->authz_id->data;
+  result = apr_palloc(result_pool, 2 * authz->authz_id->size + 1);
+  for (i = 0; i < authz->authz_id->size; ++i)
+    {
+      result[2 * i] = hex[data[i] >> 4];
+      result[2 * i + 1] = hex[data[i] & 0xf];
+    }
+  result[2 * i] = '\0';
+
+  return result;
+}
+
 svn_error_t *
 svn_repos_authz_parse2(svn_authz_t **authz_p,
                        svn_stream_t *stream,
@@ -32,12 +32,16 @@
 #include "svn_pools.h"
 #include "svn_props.h"
 #include "repos.h"
+#include "svn_cache_config.h"
 #include "svn_private_config.h"
 
+#include "private/svn_atomic.h"
 #include "private/svn_dep_compat.h"
 #include "private/svn_fspath.h"
+#include "private/svn_mutex.h"
 #include "private/svn_subr_private.h"
 #include "private/svn_string_private.h"
+#include "private/svn_thread_pool.h"
 
 #define NUM_CACHED_SOURCE_ROOTS 4
 
@@ -143,6 +147,9 @@ typedef struct report_baton_t
 
   /* This will not change. So, fetch it once and reuse it. */
   svn_string_t *repos_uuid;
+
+  /* Reads added sub-trees ahead of the editor drive.  May be NULL. */
+  struct prefetch_t *prefetch;
   apr_pool_t *pool;
 } report_baton_t;
 
@@ -1095,6 +1102,353 @@ update_entry(report_baton_t *b, svn_revnum_t s_rev, const char *s_path,
     }
 }
 
+/* --- PREFETCHING ADDED SUBTREES --- */
+
+/* The editor must be driven depth-first from a single thread and FS
+   roots must not be shared between threads.  What we can do, however,
+   is to read ahead:  Whenever a directory gains several new sub-trees
+   (e.g. during a checkout), worker threads walk the sub-trees that the
+   editor drive will get to only later.  They use FS instances of their
+   own, which each report opens once per concurrently running task, and
+   only read data, i.e. node revisions, directory listings, properties
+   and the contents of small files.  Since the FS caches are shared
+   within the process, the editor drive on the main thread will then
+   find most of the data already cached.
+
+   Prefetching is strictly best-effort:  Errors in worker threads are
+   ignored and the order of the editor calls is not affected at all.
+   It is off unless enabled with svn_repos__set_report_prefetch(). */
+
+/* Files larger than this will not have their contents prefetched. */
+#define PREFETCH_MAX_FILE_SIZE 0x10000
+
+/* Maximum number of threads in PREFETCH_THREADS, i.e. number of
+   sub-trees that we read concurrently throughout the process. */
+#define PREFETCH_MAX_THREADS 8
+
+/* A filesystem instance that prefetch tasks can use one at a time. */
+typedef struct prefetch_fs_t
+{
+  /* The root of the report's target revision. */
+  svn_fs_root_t *root;
+
+  /* Private root pool containing ROOT and its FS. */
+  apr_pool_t *pool;
+} prefetch_fs_t;
+
+/* Prefetch context for a single report. */
+typedef struct prefetch_t
+{
+  /* Parameters to open the repository's filesystem with. */
+  const char *fs_path;
+  apr_hash_t *fs_config;
+
+  /* The revision that the report transmits. */
+  svn_revnum_t rev;
+
+  /* Whether to prefetch file contents. */
+  svn_boolean_t text_deltas;
+
+  /* Set when the report is done.  Tasks shall stop ASAP. */
+  volatile svn_atomic_t cancelled;
+
+#if APR_HAS_THREADS
+  /* The shared threads that run our tasks. */
+  apr_thread_pool_t *threads;
+#endif
+
+  /* prefetch_fs_t * that no task is using at the moment.  Never holds
+     more than PREFETCH_MAX_THREADS elements, so that pushing to it does
+     not allocate.  Protected by MUTEX. */
+  apr_array_header_t *idle_fs;
+  svn_mutex__t *mutex;
+
+  /* Pool to allocate tasks from.  Outlives all tasks. */
+  apr_pool_t *pool;
+} prefetch_t;
+
+/* A single prefetch task, i.e. a sub-tree to read. */
+typedef struct prefetch_task_t
+{
+  prefetch_t *prefetch;
+
+  /* Root of the sub-tree to read. */
+  const char *path;
+} prefetch_task_t;
+
+#if APR_HAS_THREADS
+
+/* Threads to execute the prefetch tasks of all reports. */
+static svn_thread_pool__shared_t prefetch_threads
+  = SVN_THREAD_POOL__SHARED_INIT(PREFETCH_MAX_THREADS,
+                                 N_("Can't create reporter thread pool"));
+
+/* Set *FS to an idle filesystem instance of PREFETCH or to NULL if there
+   is none.  To be called with PREFETCH->MUTEX held. */
+static svn_error_t *
+take_idle_fs(prefetch_fs_t **fs,
+             prefetch_t *prefetch)
+{
+  *fs = prefetch->idle_fs->nelts
+      ? *(prefetch_fs_t **)apr_array_pop(prefetch->idle_fs)
+      : NULL;
+
+  return SVN_NO_ERROR;
+}
+
+/* Make FS available to other tasks of PREFETCH or, if there are enough
+   of them already, close it.  To be called with PREFETCH->MUTEX held. */
+static svn_error_t *
+return_idle_fs(prefetch_t *prefetch,
+               prefetch_fs_t *fs)
+{
+  if (prefetch->idle_fs->nelts < prefetch->idle_fs->nalloc)
+    APR_ARRAY_PUSH(prefetch->idle_fs, prefetch_fs_t *) = fs;
+  else
+    svn_pool_destroy(fs->pool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Set *FS to a filesystem instance of PREFETCH that no other task uses,
+   opening a new one if necessary. */
+static svn_error_t *
+acquire_fs(prefetch_fs_t **fs,
+           prefetch_t *prefetch)
+{
+  prefetch_fs_t *result;
+  svn_fs_t *new_fs;
+  apr_pool_t *pool;
+  svn_error_t *err;
+
+  SVN_MUTEX__WITH_LOCK(prefetch->mutex, take_idle_fs(&result, prefetch));
+  if (result)
+    {
+      *fs = result;
+      return SVN_NO_ERROR;
+    }
+
+  /* Pools are not thread-safe.  Use one that is private to the new
+     instance. */
+  pool = svn_pool_create(NULL);
+  result = apr_palloc(pool, sizeof(*result));
+  result->pool = pool;
+
+  err = svn_fs_open2(&new_fs, prefetch->fs_path, prefetch->fs_config,
+                     pool, pool);
+  if (!err)
+    err = svn_fs_revision_root(&result->root, new_fs, prefetch->rev, pool);
+  if (err)
+    {
+      svn_pool_destroy(pool);
+      return svn_error_trace(err);
+    }
+
+  *fs = result;
+  return SVN_NO_ERROR;
+}
+
+/* Read the node at PATH of KIND in ROOT and, if it is a directory, all
+   nodes below it, as described by PREFETCH.  Use SCRATCH_POOL for
+   temporaries. */
+static svn_error_t *
+prefetch_node(prefetch_t *prefetch,
+              svn_fs_root_t *root,
+              const char *path,
+              svn_node_kind_t kind,
+              apr_pool_t *scratch_pool)
+{
+  apr_hash_t *props;
+  svn_revnum_t created_rev;
+
+  if (svn_atomic_read(&prefetch->cancelled))
+    return SVN_NO_ERROR;
+
+  /* These are what delta_proplists() will ask for. */
+  SVN_ERR(svn_fs_node_proplist(&props, root, path, scratch_pool));
+  SVN_ERR(svn_fs_node_created_rev(&created_rev, root, path, scratch_pool));
+
+  if (kind == svn_node_file)
+    {
+      svn_checksum_t *checksum;
+      svn_filesize_t length;
+
+      SVN_ERR(svn_fs_file_checksum(&checksum, svn_checksum_md5, root, path,
+                                   TRUE, scratch_pool));
+
+      SVN_ERR(svn_fs_file_length(&length, root, path, scratch_pool));
+      if (prefetch->text_deltas && length <= PREFETCH_MAX_FILE_SIZE)
+        {
+          svn_stream_t *contents;
+
+          SVN_ERR(svn_fs_file_contents(&contents, root, path, scratch_pool));
+          SVN_ERR(svn_stream_copy3(contents, svn_stream_empty(scratch_pool),
+                                   NULL, NULL, scratch_pool));
+        }
+    }
+  else if (kind == svn_node_dir)
+    {
+      apr_hash_t *entries;
+      apr_array_header_t *ordered;
+      apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+      int i;
+
+      /* Walk the entries in the same order as delta_dirs() will. */
+      SVN_ERR(svn_fs_dir_entries(&entries, root, path, scratch_pool));
+      SVN_ERR(svn_fs_dir_optimal_order(&ordered, root, entries,
+                                       scratch_pool, iterpool));
+      for (i = 0; i < ordered->nelts; ++i)
+        {
+          const svn_fs_dirent_t *entry
+            = APR_ARRAY_IDX(ordered, i, svn_fs_dirent_t *);
+
+          svn_pool_clear(iterpool);
+          SVN_ERR(prefetch_node(prefetch, root,
+                                svn_fspath__join(path, entry->name,
+                                                 iterpool),
+                                entry->kind, iterpool));
+        }
+
+      svn_pool_destroy(iterpool);
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Thread-pool task reading the sub-tree given by the prefetch_task_t
+   instance DATA. */
+static void * APR_THREAD_FUNC
+prefetch_task(apr_thread_t *tid,
+              void *data)
+{
+  prefetch_task_t *task = data;
+  prefetch_t *prefetch = task->prefetch;
+  prefetch_fs_t *fs;
+  svn_node_kind_t kind;
+  apr_pool_t *scratch_pool;
+  svn_error_t *err;
+
+  if (svn_atomic_read(&prefetch->cancelled))
+    return NULL;
+
+  /* The main thread will run into any real problem itself. */
+  err = acquire_fs(&fs, prefetch);
+  if (err)
+    {
+      svn_error_clear(err);
+      return NULL;
+    }
+
+  scratch_pool = svn_pool_create(fs->pool);
+  err = svn_fs_check_path(&kind, fs->root, task->path, scratch_pool);
+  if (!err)
+    err = prefetch_node(prefetch, fs->root, task->path, kind, scratch_pool);
+  svn_error_clear(err);
+  svn_pool_destroy(scratch_pool);
+
+  err = svn_mutex__lock(prefetch->mutex);
+  if (!err)
+    err = svn_mutex__unlock(prefetch->mutex, return_idle_fs(prefetch, fs));
+  svn_error_clear(err);
+
+  return NULL;
+}
+
+#endif
+
+/* Set B->PREFETCH to a new prefetch context for the report B, if this
+   platform and configuration allow for it.  Otherwise, set it to NULL. */
+static void
+prefetch_create(report_baton_t *b)
+{
+#if APR_HAS_THREADS
+  apr_thread_pool_t *threads;
+  svn_mutex__t *mutex;
+  svn_error_t *err;
+#endif
+
+  b->prefetch = NULL;
+
+#if APR_HAS_THREADS
+  if (!b->repos->report_prefetch)
+    return;
+
+  /* The caches must be thread-safe for the main thread to actually
+     benefit from the data read by the worker threads. */
+  if (svn_cache_config_get()->single_threaded)
+    return;
+
+  /* No prefetching if we can't get the worker threads. */
+  err = svn_thread_pool__get_shared(&threads, &prefetch_threads, NULL,
+                                    b->pool);
+  if (!err)
+    err = svn_mutex__init(&mutex, TRUE, b->pool);
+  if (err)
+    {
+      svn_error_clear(err);
+      return;
+    }
+
+  b->prefetch = apr_pcalloc(b->pool, sizeof(*b->prefetch));
+  b->prefetch->fs_path = svn_fs_path(b->repos->fs, b->pool);
+  b->prefetch->fs_config = svn_fs_config(b->repos->fs, b->pool);
+  b->prefetch->rev = b->t_rev;
+  b->prefetch->text_deltas = b->text_deltas;
+  b->prefetch->threads = threads;
+  b->prefetch->idle_fs = apr_array_make(b->pool, PREFETCH_MAX_THREADS,
+                                        sizeof(prefetch_fs_t *));
+  b->prefetch->mutex = mutex;
+  b->prefetch->pool = b->pool;
+#endif
+}
+
+/* Schedule reading the sub-tree at PATH in the target revision of the
+   report B, if B->PREFETCH is enabled. */
+static void
+prefetch_schedule(report_baton_t *b,
+                  const char *path)
+{
+#if APR_HAS_THREADS
+  prefetch_task_t *task;
+
+  if (!b->prefetch)
+    return;
+
+  task = apr_palloc(b->prefetch->pool, sizeof(*task));
+  task->prefetch = b->prefetch;
+  task->path = apr_pstrdup(b->prefetch->pool, path);
+
+  /* Failing to schedule the task is not an error; the data will simply
+     be read on demand by the main thread. */
+  apr_thread_pool_push(b->prefetch->threads, prefetch_task, task,
+                       APR_THREAD_TASK_PRIORITY_NORMAL, b->prefetch);
+#endif
+}
+
+/* Stop all prefetch tasks of the report B, wait for those already
+   running and close their filesystems.  No-op if B->PREFETCH is not
+   enabled. */
+static void
+prefetch_stop(report_baton_t *b)
+{
+#if APR_HAS_THREADS
+  int i;
+
+  if (!b->prefetch)
+    return;
+
+  svn_atomic_set(&b->prefetch->cancelled, TRUE);
+  apr_thread_pool_tasks_cancel(b->prefetch->threads, b->prefetch);
+
+  /* No task is left, so all instances are idle. */
+  for (i = 0; i < b->prefetch->idle_fs->nelts; ++i)
+    svn_pool_destroy(APR_ARRAY_IDX(b->prefetch->idle_fs, i,
+                                   prefetch_fs_t *)->pool);
+
+  b->prefetch = NULL;
+#endif
+}
+
 /* A helper macro for when we have to recurse into subdirectories. */
 #define DEPTH_BELOW_HERE(depth) ((depth) == svn_depth_immediates) ? \
                                  svn_depth_empty : (depth)
@@ -1304,6 +1658,36 @@ delta_dirs(report_baton_t *b, svn_revnum_t s_rev, const char *s_path,
       /* Loop over the dirents in the target. */
       SVN_ERR(svn_fs_dir_optimal_order(&t_ordered_entries, b->t_root,
                                        t_entries, subpool, iterpool));
+
+      /* If this directory gains several new sub-directories, let worker
+         threads read all but the first one while we drive the editor
+         through them.  Sub-trees of added directories will be covered
+         by those workers already, so only do this for directories that
+         existed in the source. */
+      if (b->prefetch && s_path
+          && (requested_depth == svn_depth_infinity
+              || (requested_depth == svn_depth_unknown
+                  && wc_depth == svn_depth_infinity)))
+        {
+          svn_boolean_t first = TRUE;
+
+          for (i = 0; i < t_ordered_entries->nelts; ++i)
+            {
+              const svn_fs_dirent_t *t_entry
+                 = APR_ARRAY_IDX(t_ordered_entries, i, svn_fs_dirent_t *);
+
+              if (t_entry->kind != svn_node_dir
+                  || (s_entries && svn_hash_gets(s_entries, t_entry->name)))
+                continue;
+
+              if (first)
+                first = FALSE;
+              else
+                prefetch_schedule(b, svn_fspath__join(t_path, t_entry->name,
+                                                      iterpool));
+            }
+        }
+
       for (i = 0; i < t_ordered_entries->nelts; ++i)
         {
           const svn_fs_dirent_t *t_entry
@@ -1472,7 +1856,11 @@ finish_report(report_baton_t *b, apr_pool_t *pool)
     b->s_roots[i] = NULL;
 
   {
-    svn_error_t *err = svn_error_trace(drive(b, s_rev, info, pool));
+    svn_error_t *err;
+
+    prefetch_create(b);
+    err = svn_error_trace(drive(b, s_rev, info, pool));
+    prefetch_stop(b);
 
     if (err == SVN_NO_ERROR)
       return svn_error_trace(b->editor->close_edit(b->edit_baton, pool));
@@ -1634,6 +2022,7 @@ svn_repos_begin_report3(void **report_baton,
                                           1000000 /* maxsize */,
                                           pool);
   b->repos_uuid = svn_string_create(uuid, pool);
+  b->prefetch = NULL;
 
   /* Hand reporter back to client. */
   *report_baton = b;
@@ -878,6 +878,10 @@ create_conf(svn_repos_t *repos, apr_pool_t *pool)
 "### Unless you specify an absolute path, the file's location is relative"   NL
 "### to the directory containing this file."                                 NL
 "# hooks-env = " SVN_REPOS__CONF_HOOKS_ENV                                   NL
+"### The report-prefetch option lets checkouts and updates read the"         NL
+"### sub-trees that they add in background threads.  This requires"          NL
+"### svnserve to run with --threads.  Default is false."                     NL
+"# report-prefetch = true"                                                   NL
 ""                                                                           NL
 "[sasl]"                                                                     NL
 "### This option specifies whether you want to use the Cyrus SASL"           NL
@@ -1011,6 +1015,13 @@ svn_repos_hooks_setenv(svn_repos_t *repos,
   return SVN_NO_ERROR;
 }
 
+void
+svn_repos__set_report_prefetch(svn_repos_t *repos,
+                               svn_boolean_t prefetch)
+{
+  repos->report_prefetch = prefetch;
+}
+
 /* Allocate and return a new svn_repos_t * object, initializing the
    directory pathname members based on PATH, and initializing the
    REPOSITORY_CAPABILITIES member.
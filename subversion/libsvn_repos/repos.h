@@ -135,6 +135,10 @@ struct svn_repos_t
   /* The FS backend in use within this repository. */
   const char *fs_type;
 
+  /* Whether reports read added sub-trees ahead in worker threads.
+     See svn_repos__set_report_prefetch(). */
+  svn_boolean_t report_prefetch;
+
   /* If non-null, a list of all the capabilities the client (on the
      current connection) has self-reported.  Each element is a
      'const char *', one of SVN_RA_CAPABILITY_*.
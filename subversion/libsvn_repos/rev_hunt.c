@@ -37,9 +37,11 @@
 #include "svn_props.h"
 #include "svn_mergeinfo.h"
 #include "repos.h"
+#include "private/svn_cache.h"
 #include "private/svn_fspath.h"
 #include "private/svn_fs_private.h"
 #include "private/svn_sorts_private.h"
+#include "private/svn_temp_serializer.h"
 
 
 /* Note:  this binary search assumes that the datestamp properties on
@@ -574,6 +576,144 @@ check_ancestry_of_peg_path(svn_boolean_t *is_ancestor,
 }
 
 
+/* Cached result of svn_repos__prev_location() for some PATH@REVISION. */
+typedef struct prev_location_t
+{
+  svn_revnum_t appeared_rev;
+  svn_revnum_t prev_rev;
+
+  /* NULL if there was no copy in PATH@REVISION's history. */
+  const char *prev_path;
+} prev_location_t;
+
+/* Implement svn_cache__serialize_func_t for prev_location_t. */
+static svn_error_t *
+serialize_prev_location(void **data,
+                        apr_size_t *data_len,
+                        void *in,
+                        apr_pool_t *pool)
+{
+  prev_location_t *location = in;
+  svn_temp_serializer__context_t *context;
+  svn_stringbuf_t *serialized;
+
+  context = svn_temp_serializer__init(location, sizeof(*location), 128,
+                                      pool);
+  svn_temp_serializer__add_string(context, &location->prev_path);
+
+  serialized = svn_temp_serializer__get(context);
+  *data = serialized->data;
+  *data_len = serialized->len;
+
+  return SVN_NO_ERROR;
+}
+
+/* Implement svn_cache__deserialize_func_t for prev_location_t. */
+static svn_error_t *
+deserialize_prev_location(void **out,
+                          void *data,
+                          apr_size_t data_len,
+                          apr_pool_t *pool)
+{
+  prev_location_t *location = data;
+
+  svn_temp_deserializer__resolve(location, (void **)&location->prev_path);
+  *out = location;
+
+  return SVN_NO_ERROR;
+}
+
+/* Set *CACHE to a cache for svn_repos__prev_location() results in FS,
+   keyed by "<revision><path>".  History is immutable, so the entries
+   never need to be invalidated and can be shared through the global
+   membuffer cache with every other user of the same repository in this
+   process.  A repository that gets replaced, e.g. reloaded with the same
+   UUID, has a different instance ID and doesn't see the old entries.
+   Set *CACHE to NULL if there is no global membuffer cache or FS has no
+   instance ID.  Allocate the cache in RESULT_POOL and use SCRATCH_POOL
+   for temporaries.
+ */
+static svn_error_t *
+create_prev_location_cache(svn_cache__t **cache,
+                           svn_fs_t *fs,
+                           apr_pool_t *result_pool,
+                           apr_pool_t *scratch_pool)
+{
+  svn_membuffer_t *membuffer = svn_cache__get_global_membuffer_cache();
+  const char *instance_id = svn_fs__instance_id(fs);
+  const char *uuid;
+  const char *prefix;
+
+  *cache = NULL;
+  if (! membuffer || ! instance_id)
+    return SVN_NO_ERROR;
+
+  SVN_ERR(svn_fs_get_uuid(fs, &uuid, scratch_pool));
+  prefix = apr_pstrcat(scratch_pool, "repos:prev-location:", uuid, "--",
+                       instance_id, "/", svn_fs_path(fs, scratch_pool), ":",
+                       SVN_VA_NULL);
+
+  SVN_ERR(svn_cache__create_membuffer_cache(
+            cache, membuffer, serialize_prev_location,
+            deserialize_prev_location, APR_HASH_KEY_STRING, prefix,
+            SVN_CACHE__MEMBUFFER_DEFAULT_PRIORITY, TRUE, FALSE,
+            result_pool, scratch_pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* Like svn_repos__prev_location() but look up the result in CACHE first
+   and store it there otherwise.  CACHE may be NULL. */
+static svn_error_t *
+prev_location(svn_revnum_t *appeared_rev,
+              const char **prev_path,
+              svn_revnum_t *prev_rev,
+              svn_cache__t *cache,
+              svn_fs_t *fs,
+              svn_revnum_t revision,
+              const char *path,
+              apr_pool_t *pool)
+{
+  const char *key = NULL;
+  prev_location_t *location;
+  svn_boolean_t found;
+
+  if (cache)
+    {
+      /* PATH is absolute, i.e. the key is unambiguous. */
+      key = apr_psprintf(pool, "%ld%s", revision, path);
+      SVN_ERR(svn_cache__get((void **)&location, &found, cache, key, pool));
+      if (found)
+        {
+          if (appeared_rev)
+            *appeared_rev = location->appeared_rev;
+          if (prev_rev)
+            *prev_rev = location->prev_rev;
+          if (prev_path)
+            *prev_path = location->prev_path;
+
+          return SVN_NO_ERROR;
+        }
+    }
+
+  location = apr_pcalloc(pool, sizeof(*location));
+  SVN_ERR(svn_repos__prev_location(&location->appeared_rev,
+                                   &location->prev_path,
+                                   &location->prev_rev,
+                                   fs, revision, path, pool));
+  if (cache)
+    SVN_ERR(svn_cache__set(cache, key, location, pool));
+
+  if (appeared_rev)
+    *appeared_rev = location->appeared_rev;
+  if (prev_rev)
+    *prev_rev = location->prev_rev;
+  if (prev_path)
+    *prev_path = location->prev_path;
+
+  return SVN_NO_ERROR;
+}
+
 svn_error_t *
 svn_repos__prev_location(svn_revnum_t *appeared_rev,
                          const char **prev_path,
@@ -645,6 +785,7 @@ svn_repos_trace_node_locations(svn_fs_t *fs,
   svn_revnum_t revision;
   svn_boolean_t is_ancestor;
   apr_pool_t *lastpool, *currpool;
+  svn_cache__t *cache;
 
   SVN_ERR_ASSERT(location_revisions_orig->elt_size == sizeof(svn_revnum_t));
 
@@ -668,6 +809,8 @@ svn_repos_trace_node_locations(svn_fs_t *fs,
   lastpool = svn_pool_create(pool);
   currpool = svn_pool_create(pool);
 
+  SVN_ERR(create_prev_location_cache(&cache, fs, pool, currpool));
+
   /* First - let's sort the array of the revisions from the greatest revision
    * downward, so it will be easier to search on. */
   location_revisions = apr_array_copy(pool, location_revisions_orig);
@@ -707,8 +850,8 @@ svn_repos_trace_node_locations(svn_fs_t *fs,
 
       /* Find the target of the innermost copy relevant to path@revision.
          The copy may be of path itself, or of a parent directory. */
-      SVN_ERR(svn_repos__prev_location(&appeared_rev, &prev_path, &prev_rev,
-                                       fs, revision, path, currpool));
+      SVN_ERR(prev_location(&appeared_rev, &prev_path, &prev_rev, cache,
+                            fs, revision, path, currpool));
       if (! prev_path)
         break;
 
@@ -838,6 +981,7 @@ svn_repos_node_location_segments(svn_repos_t *repos,
   svn_stringbuf_t *current_path;
   svn_revnum_t youngest_rev, current_rev;
   apr_pool_t *subpool;
+  svn_cache__t *cache;
 
   SVN_ERR(svn_fs_youngest_rev(&youngest_rev, fs, pool));
 
@@ -884,6 +1028,7 @@ svn_repos_node_location_segments(svn_repos_t *repos,
 
   /* Okay, let's get searching! */
   subpool = svn_pool_create(pool);
+  SVN_ERR(create_prev_location_cache(&cache, fs, pool, subpool));
   current_rev = peg_revision;
   current_path = svn_stringbuf_create(path, pool);
   while (current_rev >= end_rev)
@@ -902,8 +1047,8 @@ svn_repos_node_location_segments(svn_repos_t *repos,
       /* segment path should be absolute without leading '/'. */
       segment->path = cur_path + 1;
 
-      SVN_ERR(svn_repos__prev_location(&appeared_rev, &prev_path, &prev_rev,
-                                       fs, current_rev, cur_path, subpool));
+      SVN_ERR(prev_location(&appeared_rev, &prev_path, &prev_rev, cache,
+                            fs, current_rev, cur_path, subpool));
 
       /* If there are no previous locations for this thing (meaning,
          it originated at the current path), then we simply need to
@@ -1341,6 +1486,11 @@ find_merged_revisions(apr_array_header_t **merged_path_revisions_out,
   return SVN_NO_ERROR;
 }
 
+/* File revisions up to this size will be kept in memory between calls to
+   send_path_revision() such that the next delta can be computed without
+   reconstructing the previous fulltext again. */
+#define MAX_CACHED_FULLTEXT_SIZE (16 * 1024 * 1024)
+
 struct send_baton
 {
   apr_pool_t *iterpool;
@@ -1348,9 +1498,83 @@ struct send_baton
   apr_hash_t *last_props;
   const char *last_path;
   svn_fs_root_t *last_root;
+
+  /* Fulltext of LAST_PATH in LAST_ROOT, allocated in LAST_POOL.
+     NULL if unknown, e.g. because the file was too large. */
+  svn_stringbuf_t *last_contents;
   svn_boolean_t include_merged_revisions;
 };
 
+/* Set *DELTA_STREAM to a txdelta from the last file revision recorded in
+   SB to PATH in ROOT.  If the fulltext of the latter has been read into
+   memory for that, return it in *CONTENTS.  Otherwise, set *CONTENTS to
+   NULL.  Allocate everything in POOL.
+
+   Subsequent file revisions will typically share large parts of their
+   representation chains.  Keeping the last fulltext around turns every
+   delta computation into a single fulltext reconstruction plus an
+   in-memory delta, instead of reconstructing both sides each time. */
+static svn_error_t *
+get_file_delta_stream(svn_txdelta_stream_t **delta_stream,
+                      svn_stringbuf_t **contents,
+                      struct send_baton *sb,
+                      svn_fs_root_t *root,
+                      const char *path,
+                      apr_pool_t *pool)
+{
+  svn_filesize_t length;
+  svn_stringbuf_t *source;
+  svn_stream_t *stream;
+
+  *contents = NULL;
+
+  /* Get the source fulltext, reading it only if we don't have it yet. */
+  if (! sb->last_root)
+    {
+      source = svn_stringbuf_create_empty(pool);
+    }
+  else if (sb->last_contents)
+    {
+      source = sb->last_contents;
+    }
+  else
+    {
+      SVN_ERR(svn_fs_file_length(&length, sb->last_root, sb->last_path,
+                                 pool));
+      if (length > MAX_CACHED_FULLTEXT_SIZE)
+        return svn_error_trace(svn_fs_get_file_delta_stream(delta_stream,
+                                                            sb->last_root,
+                                                            sb->last_path,
+                                                            root, path,
+                                                            pool));
+
+      SVN_ERR(svn_fs_file_contents(&stream, sb->last_root, sb->last_path,
+                                   pool));
+      SVN_ERR(svn_stringbuf_from_stream(&source, stream, (apr_size_t)length,
+                                        pool));
+    }
+
+  /* Don't keep overly large fulltexts in memory.  Let the FS handle those
+     the usual way. */
+  SVN_ERR(svn_fs_file_length(&length, root, path, pool));
+  if (length > MAX_CACHED_FULLTEXT_SIZE)
+    return svn_error_trace(svn_fs_get_file_delta_stream(delta_stream,
+                                                        sb->last_root,
+                                                        sb->last_path,
+                                                        root, path, pool));
+
+  SVN_ERR(svn_fs_file_contents(&stream, root, path, pool));
+  SVN_ERR(svn_stringbuf_from_stream(contents, stream, (apr_size_t)length,
+                                    pool));
+
+  svn_txdelta2(delta_stream,
+               svn_stream_from_stringbuf(source, pool),
+               svn_stream_from_stringbuf(*contents, pool),
+               FALSE, pool);
+
+  return SVN_NO_ERROR;
+}
+
 /* Send PATH_REV to HANDLER and HANDLER_BATON, using information provided by
    SB. */
 static svn_error_t *
@@ -1367,6 +1591,7 @@ send_path_revision(struct path_revision *path_rev,
   svn_txdelta_stream_t *delta_stream;
   svn_txdelta_window_handler_t delta_handler = NULL;
   void *delta_baton = NULL;
+  svn_stringbuf_t *contents = NULL;
   apr_pool_t *tmp_pool;  /* For swapping */
   svn_boolean_t contents_changed;
   svn_boolean_t props_changed;
@@ -1452,20 +1677,24 @@ send_path_revision(struct path_revision *path_rev,
   if (delta_handler && delta_handler != svn_delta_noop_window_handler)
     {
       /* Get the content delta. */
-      SVN_ERR(svn_fs_get_file_delta_stream(&delta_stream,
-                                           sb->last_root, sb->last_path,
-                                           root, path_rev->path,
-                                           sb->iterpool));
+      SVN_ERR(get_file_delta_stream(&delta_stream, &contents, sb,
+                                    root, path_rev->path, sb->iterpool));
       /* And send. */
       SVN_ERR(svn_txdelta_send_txstream(delta_stream,
                                         delta_handler, delta_baton,
                                         sb->iterpool));
     }
+  else if (! contents_changed && sb->last_contents)
+    {
+      /* Same contents as before.  Carry them over to the next iteration. */
+      contents = svn_stringbuf_dup(sb->last_contents, sb->iterpool);
+    }
 
-  /* Remember root, path and props for next iteration. */
+  /* Remember root, path, props and contents for next iteration. */
   sb->last_root = root;
   sb->last_path = path_rev->path;
   sb->last_props = props;
+  sb->last_contents = contents;
 
   /* Swap the pools. */
   tmp_pool = sb->iterpool;
@@ -1511,6 +1740,7 @@ get_file_revs_backwards(svn_repos_t *repos,
   /* We want the first txdelta to be against the empty file. */
   sb.last_root = NULL;
   sb.last_path = NULL;
+  sb.last_contents = NULL;
 
   /* Create an empty hash table for the first property diff. */
   sb.last_props = apr_hash_make(sb.last_pool);
@@ -1662,6 +1892,7 @@ svn_repos_get_file_revs2(svn_repos_t *repos,
   /* We want the first txdelta to be against the empty file. */
   sb.last_root = NULL;
   sb.last_path = NULL;
+  sb.last_contents = NULL;
 
   /* Create an empty hash table for the first property diff. */
   sb.last_props = apr_hash_make(sb.last_pool);
@@ -1169,6 +1169,17 @@ svn_config_ensure(const char *config_dir, apr_pool_t *pool)
         "###   http-bulk-updates          Whether to request bulk update"    NL
         "###                              responses or to fetch each file"   NL
         "###                              in an individual request. "        NL
+        "###   svn-max-connections        Maximum number of parallel server" NL
+        "###                              connections to use for a checkout" NL
+        "###                              via svn:// (not svn+ssh://)."      NL
+        "###                              Defaults to 1, i.e. no parallel"   NL
+        "###                              connections."                      NL
+        "###   svn-tls                    Whether svn:// connections switch" NL
+        "###                              to TLS: 'yes', 'no' or 'auto' (if" NL
+        "###                              the server offers it).  Defaults"  NL
+        "###                              to 'no'.  The server certificate"  NL
+        "###                              is checked against ssl-authority-" NL
+        "###                              files and ssl-trust-default-ca."   NL
         "###   store-passwords            Specifies whether passwords used"  NL
         "###                              to authenticate against a"         NL
         "###                              Subversion server may be cached"   NL
@@ -1552,6 +1563,46 @@ svn_config_ensure(const char *config_dir, apr_pool_t *pool)
         "### returning an error.  The default is 10000, i.e. 10 seconds."    NL
         "### Longer values may be useful when exclusive locking is enabled." NL
         "# busy-timeout = 10000"                                             NL
+        "### Set to 'wal' to let SQLite use a write-ahead log for working"   NL
+        "### copies.  This lets 'svn status' and other readers run while"    NL
+        "### another client writes to the working copy, at the cost of"      NL
+        "### two additional files next to wc.db.  It is not used for"        NL
+        "### working copies on network file systems or with exclusive"       NL
+        "### locking.  Set to 'truncate' to return to the rollback journal"  NL
+        "### once no other client uses the working copy.  'default' keeps"   NL
+        "### the journal mode that the working copy currently uses."         NL
+        "# journal-mode = default"                                           NL
+        "### Set the number of pages after which SQLite copies the"          NL
+        "### write-ahead log back into wc.db.  The SQLite default is 1000."  NL
+        "# wal-autocheckpoint = 1000"                                        NL
+        "### Set the size of the SQLite page cache per working copy in KiB," NL
+        "### and the number of bytes of wc.db that SQLite may access"        NL
+        "### through memory mapping.  Larger values can speed up"            NL
+        "### operations on large working copies.  By default, SQLite's own"  NL
+        "### defaults are used."                                             NL
+        "# cache-size = 2000"                                                NL
+        "# mmap-size = 0"                                                    NL
+        "### Set to a directory to let all working copies on this host"      NL
+        "### share their pristine copies of file texts through it.  Texts"   NL
+        "### already in the store are linked into new working copies"        NL
+        "### instead of being copied or, where the server allows it,"        NL
+        "### downloaded again.  This only works for working copies on the"   NL
+        "### same file system as the store, and only texts that belong to"   NL
+        "### the user and match their checksums are used.  'svn cleanup"     NL
+        "### --vacuum-pristines' removes texts that are no longer used."     NL
+        "# shared-pristine-store = /var/cache/svn/pristine"                  NL
+        "### Set to true to check out new working copies in a mode that"     NL
+        "### keeps pristine copies of file texts only as long as they are"   NL
+        "### needed.  Files without svn:eol-style, svn:keywords or"          NL
+        "### svn:special then take their disk space only once.  The"         NL
+        "### pristine copy is restored from the shared pristine store, the"  NL
+        "### unmodified working file or the repository when an operation"    NL
+        "### needs it, so 'svn diff' and 'svn revert' of modified files may" NL
+        "### need access to the repository.  The mode is recorded in each"   NL
+        "### working copy, so this option doesn't affect existing ones, and" NL
+        "### clients older than 1.13 refuse to work with working copies"     NL
+        "### checked out in this mode."                                      NL
+        "# lazy-pristines = false"                                           NL
         ;
 
       err = svn_io_file_open(&f, path,
@@ -51,6 +51,20 @@
 #include <fcntl.h>
 #endif
 
+#ifdef HAVE_SYS_VFS_H
+#include <sys/vfs.h>
+#endif
+#ifdef HAVE_SYS_PARAM_H
+#include <sys/param.h>
+#endif
+#ifdef HAVE_SYS_MOUNT_H
+#include <sys/mount.h>
+#endif
+#ifdef HAVE_LINUX_FS_H
+#include <sys/ioctl.h>
+#include <linux/fs.h>
+#endif
+
 #include "svn_hash.h"
 #include "svn_types.h"
 #include "svn_dirent_uri.h"
@@ -917,12 +931,113 @@ copy_contents(apr_file_t *from_file,
 }
 
 
+/* Try to copy the contents of FROM_FILE to the empty file TO_FILE without
+ * reading and writing them, and set *DONE to whether that worked.  Both
+ * files must be positioned at their start, and nothing may have been
+ * written to TO_FILE.
+ *
+ * On file systems that support it, such as Btrfs and XFS, let TO_FILE
+ * share the data blocks of FROM_FILE until either of them is modified.
+ * Otherwise, let the kernel copy the data, which may still use server-side
+ * copies or other shortcuts.  If neither is possible, set *DONE to FALSE
+ * and leave the files untouched.
+ */
+static apr_status_t
+clone_contents(svn_boolean_t *done,
+               apr_file_t *from_file,
+               apr_file_t *to_file)
+{
+#if defined(FICLONE) || defined(HAVE_COPY_FILE_RANGE)
+  apr_os_file_t from_fd;
+  apr_os_file_t to_fd;
+  apr_status_t status;
+
+  *done = FALSE;
+
+  status = apr_os_file_get(&from_fd, from_file);
+  if (!status)
+    status = apr_os_file_get(&to_fd, to_file);
+  if (status)
+    return status;
+
+#ifdef FICLONE
+  if (ioctl(to_fd, FICLONE, from_fd) == 0)
+    {
+      *done = TRUE;
+      return APR_SUCCESS;
+    }
+#endif
+
+#ifdef HAVE_COPY_FILE_RANGE
+  {
+    svn_boolean_t first = TRUE;
+
+    while (TRUE)
+      {
+        ssize_t copied = copy_file_range(from_fd, NULL, to_fd, NULL,
+                                         APR_INT32_MAX, 0);
+
+        if (copied == 0)
+          {
+            /* Some file systems, e.g. procfs and certain FUSE or network
+               file systems, report 0 instead of an error when they can't
+               copy anything.  An empty source file is no different; let
+               the caller copy the contents the usual way. */
+            *done = !first;
+            return APR_SUCCESS;
+          }
+        else if (copied < 0)
+          {
+            status = apr_get_os_error();
+
+            if (APR_STATUS_IS_EINTR(status))
+              continue;
+
+            /* Not supported by the kernel or between these file systems;
+               nothing has been copied yet. */
+            if (first)
+              return APR_SUCCESS;
+
+            return status;
+          }
+
+        first = FALSE;
+      }
+  }
+#endif
+#else
+  *done = FALSE;
+#endif
+
+  return APR_SUCCESS;
+}
+
+svn_error_t *
+svn_io__copy_file_contents(apr_file_t *from_file,
+                           apr_file_t *to_file,
+                           apr_pool_t *scratch_pool)
+{
+  svn_boolean_t done;
+  apr_status_t apr_err;
+
+  apr_err = clone_contents(&done, from_file, to_file);
+  if (!apr_err && !done)
+    apr_err = copy_contents(from_file, to_file, scratch_pool);
+
+  /* Not every APR file knows its name, e.g. install streams on Windows. */
+  if (apr_err)
+    return svn_error_wrap_apr(apr_err, _("Can't copy file contents"));
+
+  return SVN_NO_ERROR;
+}
+
 svn_error_t *
 svn_io_copy_file(const char *src,
                  const char *dst,
                  svn_boolean_t copy_perms,
                  apr_pool_t *pool)
 {
+  svn_boolean_t cloned;
   apr_file_t *from_file, *to_file;
   apr_status_t apr_err;
   const char *dst_tmp;
@@ -956,7 +1071,9 @@ svn_io_copy_file(const char *src,
                                    svn_dirent_dirname(dst, pool),
                                    svn_io_file_del_none, pool, pool));
 
-  apr_err = copy_contents(from_file, to_file, pool);
+  apr_err = clone_contents(&cloned, from_file, to_file);
+  if (!apr_err && !cloned)
+    apr_err = copy_contents(from_file, to_file, pool);
 
   if (apr_err)
     {
@@ -2696,6 +2813,125 @@ svn_io__file_lock_autocreate(const char *lock_file,
   return svn_error_trace(err);
 }
 
+svn_error_t *
+svn_io__is_remote_file_system(svn_boolean_t *remote,
+                              const char *path,
+                              apr_pool_t *scratch_pool)
+{
+#if defined(WIN32)
+  const WCHAR *wpath;
+  WCHAR volume[MAX_PATH];
+
+  *remote = FALSE;
+
+  SVN_ERR(svn_io__utf8_to_unicode_longpath(&wpath,
+                                           svn_dirent_local_style(path,
+                                                                  scratch_pool),
+                                           scratch_pool));
+
+  if (GetVolumePathNameW(wpath, volume, MAX_PATH)
+      && GetDriveTypeW(volume) == DRIVE_REMOTE)
+    *remote = TRUE;
+
+#elif defined(HAVE_SYS_VFS_H) && defined(__linux__)
+  struct statfs info;
+  const char *path_apr;
+
+  *remote = FALSE;
+
+  SVN_ERR(cstring_from_utf8(&path_apr, path, scratch_pool));
+  if (statfs(path_apr, &info) == 0)
+    switch ((apr_uint32_t)info.f_type)
+      {
+        case 0x6969:      /* NFS */
+        case 0x517B:      /* SMB */
+        case 0xFF534D42:  /* CIFS */
+        case 0xFE534D42:  /* SMB2 */
+        case 0x5346414F:  /* AFS */
+        case 0x73757245:  /* CODA */
+        case 0x564C:      /* NCP */
+        case 0x01021997:  /* 9P */
+        case 0x65735546:  /* FUSE, which is often sshfs or similar */
+          *remote = TRUE;
+          break;
+
+        default:
+          break;
+      }
+
+#elif defined(HAVE_SYS_MOUNT_H) && defined(MNT_LOCAL)
+  struct statfs info;
+  const char *path_apr;
+
+  *remote = FALSE;
+
+  SVN_ERR(cstring_from_utf8(&path_apr, path, scratch_pool));
+  if (statfs(path_apr, &info) == 0)
+    *remote = !(info.f_flags & MNT_LOCAL);
+
+#else
+  *remote = FALSE;
+#endif
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_io__file_link(const char *src_abspath,
+                  const char *dst_abspath,
+                  apr_pool_t *scratch_pool)
+{
+#if defined(WIN32)
+  const WCHAR *src_apr;
+  const WCHAR *dst_apr;
+
+  SVN_ERR(svn_io__utf8_to_unicode_longpath(&src_apr,
+                                           svn_dirent_local_style(
+                                             src_abspath, scratch_pool),
+                                           scratch_pool));
+  SVN_ERR(svn_io__utf8_to_unicode_longpath(&dst_apr,
+                                           svn_dirent_local_style(
+                                             dst_abspath, scratch_pool),
+                                           scratch_pool));
+
+  if (!CreateHardLinkW(dst_apr, src_apr, NULL))
+    return svn_error_wrap_apr(apr_get_os_error(),
+                              _("Can't create hard link from '%s' to '%s'"),
+                              svn_dirent_local_style(src_abspath,
+                                                     scratch_pool),
+                              svn_dirent_local_style(dst_abspath,
+                                                     scratch_pool));
+
+  return SVN_NO_ERROR;
+#elif defined(HAVE_SYMLINK)
+  /* Every system with symlink() has link() as well. */
+  const char *src_apr;
+  const char *dst_apr;
+  int rv;
+
+  SVN_ERR(cstring_from_utf8(&src_apr, src_abspath, scratch_pool));
+  SVN_ERR(cstring_from_utf8(&dst_apr, dst_abspath, scratch_pool));
+
+  do {
+    rv = link(src_apr, dst_apr);
+  } while (rv == -1 && APR_STATUS_IS_EINTR(apr_get_os_error()));
+
+  if (rv == -1)
+    return svn_error_wrap_apr(apr_get_os_error(),
+                              _("Can't create hard link from '%s' to '%s'"),
+                              svn_dirent_local_style(src_abspath,
+                                                     scratch_pool),
+                              svn_dirent_local_style(dst_abspath,
+                                                     scratch_pool));
+
+  return SVN_NO_ERROR;
+#else
+  return svn_error_create(SVN_ERR_UNSUPPORTED_FEATURE, NULL,
+                          _("Hard links are not supported on this "
+                            "platform"));
+#endif
+}
+
 
 
 /* Data consistency/coherency operations. */
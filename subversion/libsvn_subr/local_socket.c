@@ -0,0 +1,102 @@
+/*
+ * local_socket.c :  helpers for Unix domain sockets
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+
+
+#include <string.h>
+
+#include "svn_dirent_uri.h"
+#include "svn_path.h"
+
+#include "svn_private_config.h"
+#include "private/svn_local_socket.h"
+
+#ifdef SVN_HAVE_LOCAL_SOCKETS
+
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <sys/un.h>
+
+#ifdef HAVE_UNISTD_H
+#include <unistd.h>
+#endif
+
+svn_error_t *
+svn_io__local_socket_address(const char **native_path,
+                             struct sockaddr_un *addr,
+                             const char *socket_path,
+                             apr_pool_t *pool)
+{
+  SVN_ERR(svn_path_cstring_from_utf8(native_path,
+                                     svn_dirent_local_style(socket_path,
+                                                            pool),
+                                     pool));
+
+  if (strlen(*native_path) >= sizeof(addr->sun_path))
+    return svn_error_createf(SVN_ERR_BAD_FILENAME, NULL,
+                             _("Socket path '%s' is too long"),
+                             svn_dirent_local_style(socket_path, pool));
+
+  memset(addr, 0, sizeof(*addr));
+  addr->sun_family = AF_UNIX;
+  strcpy(addr->sun_path, *native_path);
+
+  return SVN_NO_ERROR;
+}
+
+void
+svn_io__set_cloexec(int fd)
+{
+  int flags = fcntl(fd, F_GETFD);
+  if (flags >= 0)
+    fcntl(fd, F_SETFD, flags | FD_CLOEXEC);
+}
+
+svn_tristate_t
+svn_io__local_socket_peer_is_self(int sock)
+{
+#if defined(__linux__) && defined(SO_PEERCRED)
+  struct ucred cred;
+  socklen_t len = sizeof(cred);
+
+  if (getsockopt(sock, SOL_SOCKET, SO_PEERCRED, &cred, &len) == 0
+      && cred.uid == geteuid())
+    return svn_tristate_true;
+
+  return svn_tristate_false;
+#elif defined(__APPLE__) || defined(__FreeBSD__) || defined(__NetBSD__) \
+   || defined(__OpenBSD__) || defined(__DragonFly__)
+  uid_t uid;
+  gid_t gid;
+
+  if (getpeereid(sock, &uid, &gid) == 0 && uid == geteuid())
+    return svn_tristate_true;
+
+  return svn_tristate_false;
+#else
+  return svn_tristate_unknown;
+#endif
+}
+
+#endif /* SVN_HAVE_LOCAL_SOCKETS */
@@ -142,6 +142,9 @@ struct svn_sqlite__db_t
   svn_sqlite__stmt_t **prepared_stmts;
   apr_pool_t *state_pool;
 
+  /* The busy timeout in ms. */
+  apr_int32_t timeout;
+
 #ifdef SVN_UNICODE_NORMALIZATION_FIXES
   /* Buffers for SQLite extensoins. */
   svn_membuf_t sqlext_buf1;
@@ -912,6 +915,7 @@ internal_open(svn_sqlite__db_t *db, const char *path, svn_sqlite__mode_t mode,
   /* Retry until timeout when database is busy. */
   SQLITE_ERR_CLOSE(sqlite3_busy_timeout(db->db3, timeout),
                    db, scratch_pool);
+  db->timeout = timeout;
 
   return SVN_NO_ERROR;
 }
@@ -1069,6 +1073,46 @@ like_ucs_nfd(sqlite3_context *context,
 }
 #endif /* SVN_UNICODE_NORMALIZATION_FIXES */
 
+/* Set *MODE to the journal mode that DB currently uses, allocated in
+   RESULT_POOL. */
+static svn_error_t *
+get_journal_mode(const char **mode,
+                 svn_sqlite__db_t *db,
+                 apr_pool_t *result_pool)
+{
+  svn_sqlite__stmt_t *stmt;
+  svn_error_t *err;
+
+  SVN_ERR(prepare_statement(&stmt, db, "PRAGMA journal_mode;", result_pool));
+  err = svn_sqlite__step_row(stmt);
+  if (!err)
+    *mode = svn_sqlite__column_text(stmt, 0, result_pool);
+
+  return svn_error_compose_create(err, svn_sqlite__finalize(stmt));
+}
+
+/* Switch DB to the journal MODE and set *RESULT to the journal mode that
+   DB uses afterwards, allocated in RESULT_POOL. */
+static svn_error_t *
+set_journal_mode(const char **result,
+                 svn_sqlite__db_t *db,
+                 const char *mode,
+                 apr_pool_t *result_pool)
+{
+  svn_sqlite__stmt_t *stmt;
+  svn_error_t *err;
+
+  SVN_ERR(prepare_statement(&stmt, db,
+                            apr_psprintf(result_pool,
+                                         "PRAGMA journal_mode = %s;", mode),
+                            result_pool));
+  err = svn_sqlite__step_row(stmt);
+  if (!err)
+    *result = svn_sqlite__column_text(stmt, 0, result_pool);
+
+  return svn_error_compose_create(err, svn_sqlite__finalize(stmt));
+}
+
 svn_error_t *
 svn_sqlite__open(svn_sqlite__db_t **db, const char *path,
                  svn_sqlite__mode_t mode, const char * const statements[],
@@ -1164,11 +1208,25 @@ svn_sqlite__open(svn_sqlite__db_t **db, const char *path,
                  affects application(read: Subversion) performance/behavior. */
               "PRAGMA foreign_keys=OFF;"      /* SQLITE_DEFAULT_FOREIGN_KEYS*/
               "PRAGMA locking_mode = NORMAL;" /* SQLITE_DEFAULT_LOCKING_MODE */
-              /* Testing shows TRUNCATE is faster than DELETE on Windows. */
-              "PRAGMA journal_mode = TRUNCATE;"
               ),
                 *db);
 
+  /* Testing shows TRUNCATE is faster than DELETE on Windows.
+
+     Leave databases that have been switched to write-ahead logging alone,
+     though (see svn_sqlite__set_wal()).  Switching them back requires
+     exclusive access, so we would block here while anybody else has
+     the database open.  */
+  {
+    const char *journal_mode;
+
+    SVN_SQLITE__ERR_CLOSE(get_journal_mode(&journal_mode, *db, scratch_pool),
+                          *db);
+    if (!journal_mode || strcmp(journal_mode, "wal") != 0)
+      SVN_SQLITE__ERR_CLOSE(exec_sql(*db, "PRAGMA journal_mode = TRUNCATE;"),
+                            *db);
+  }
+
 #if defined(SVN_DEBUG)
   /* When running in debug mode, enable the checking of foreign key
      constraints.  This has possible performance implications, so we don't
@@ -1232,6 +1290,73 @@ svn_sqlite__close(svn_sqlite__db_t *db)
   return svn_error_wrap_apr(result, NULL);
 }
 
+svn_error_t *
+svn_sqlite__set_wal(svn_boolean_t *wal,
+                    svn_sqlite__db_t *db,
+                    svn_tristate_t enable,
+                    int autocheckpoint,
+                    apr_pool_t *scratch_pool)
+{
+  const char *mode;
+
+  SVN_ERR(get_journal_mode(&mode, db, scratch_pool));
+  *wal = (mode && strcmp(mode, "wal") == 0);
+
+  if (enable == svn_tristate_true && !*wal)
+    {
+      SVN_ERR(set_journal_mode(&mode, db, "WAL", scratch_pool));
+      *wal = (mode && strcmp(mode, "wal") == 0);
+    }
+  else if (enable == svn_tristate_false && *wal)
+    {
+      svn_error_t *err;
+
+      /* Don't wait for other connections to go away; we'll simply try
+         again the next time.  Write-ahead logging works just as well
+         until then. */
+      SQLITE_ERR(sqlite3_busy_timeout(db->db3, 0), db);
+      err = set_journal_mode(&mode, db, "TRUNCATE", scratch_pool);
+      SQLITE_ERR(sqlite3_busy_timeout(db->db3, db->timeout), db);
+
+      if (err && err->apr_err == SVN_ERR_SQLITE_BUSY)
+        svn_error_clear(err);
+      else if (err)
+        return svn_error_trace(err);
+      else
+        *wal = (mode && strcmp(mode, "wal") == 0);
+    }
+
+  if (*wal && autocheckpoint >= 0)
+    SVN_ERR(exec_sql(db, apr_psprintf(scratch_pool,
+                                      "PRAGMA wal_autocheckpoint = %d;",
+                                      autocheckpoint)));
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_sqlite__set_cache_size(svn_sqlite__db_t *db,
+                           apr_int64_t cache_size,
+                           apr_int64_t mmap_size,
+                           apr_pool_t *scratch_pool)
+{
+  /* Negative values for cache_size are in KiB rather than in pages. */
+  if (cache_size >= 0)
+    SVN_ERR(exec_sql(db, apr_psprintf(scratch_pool,
+                                      "PRAGMA cache_size = -%" APR_INT64_T_FMT
+                                      ";",
+                                      cache_size)));
+
+  /* SQLite silently limits this to its compile-time maximum. */
+  if (mmap_size >= 0)
+    SVN_ERR(exec_sql(db, apr_psprintf(scratch_pool,
+                                      "PRAGMA mmap_size = %" APR_INT64_T_FMT
+                                      ";",
+                                      mmap_size)));
+
+  return SVN_NO_ERROR;
+}
+
 static svn_error_t *
 reset_all_statements(svn_sqlite__db_t *db,
                      svn_error_t *error_to_wrap)
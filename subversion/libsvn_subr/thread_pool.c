@@ -0,0 +1,124 @@
+/*
+ * thread_pool.c: routines for process-wide worker thread pools.
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+#include "svn_pools.h"
+
+#include "svn_private_config.h"
+#include "private/svn_thread_pool.h"
+
+#if APR_HAS_THREADS
+
+/* Number of microseconds that an unused thread remains in the pool
+ * before being terminated.
+ *
+ * Higher values are useful if clients frequently send small requests and
+ * you want to minimize the latency for those.
+ */
+#define THREADPOOL_THREAD_IDLE_LIMIT 1000000
+
+/* Baton for create_shared_thread_pool(). */
+typedef struct create_baton_t
+{
+  svn_thread_pool__shared_t *shared;
+  apr_pool_t *owning_pool;
+} create_baton_t;
+
+/* Destructor function that implicitly cleans up any running threads
+ * in the svn_thread_pool__shared_t given as DATA *once*.
+ *
+ * Must be run as a pre-cleanup hook.
+ */
+static apr_status_t
+thread_pool_pre_cleanup(void *data)
+{
+  svn_thread_pool__shared_t *shared = data;
+  apr_thread_pool_t *tp = shared->thread_pool;
+  if (!tp)
+    return APR_SUCCESS;
+
+  shared->thread_pool = NULL;
+  svn_atomic_set(&shared->initialized, FALSE);
+
+  return apr_thread_pool_destroy(tp);
+}
+
+/* svn_atomic__init_once callback creating the threads of the
+ * svn_thread_pool__shared_t in the create_baton_t BATON. */
+static svn_error_t *
+create_shared_thread_pool(void *baton,
+                          apr_pool_t *scratch_pool)
+{
+  create_baton_t *b = baton;
+  svn_thread_pool__shared_t *shared = b->shared;
+  apr_status_t status;
+
+  /* The thread-pool must be allocated from a thread-safe pool that
+     lives until the end of the process. */
+  apr_pool_t *pool = svn_pool_create(NULL);
+
+  status = apr_thread_pool_create(&shared->thread_pool, 0,
+                                  shared->max_threads, pool);
+  if (status)
+    {
+      svn_pool_destroy(pool);
+      return svn_error_wrap_apr(status, "%s", _(shared->error_message));
+    }
+
+  /* Work around an APR bug:  The cleanup must happen in the pre-cleanup
+     hook instead of the normal cleanup hook.  Otherwise, the sub-pools
+     containing the thread objects would already be invalid. */
+  apr_pool_pre_cleanup_register(pool, shared, thread_pool_pre_cleanup);
+  if (b->owning_pool)
+    apr_pool_pre_cleanup_register(b->owning_pool, shared,
+                                  thread_pool_pre_cleanup);
+
+  /* let idle threads linger for a while in case more requests are
+     coming in */
+  apr_thread_pool_idle_wait_set(shared->thread_pool,
+                                THREADPOOL_THREAD_IDLE_LIMIT);
+
+  /* don't queue requests unless we reached the worker thread limit */
+  apr_thread_pool_threshold_set(shared->thread_pool, 0);
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_thread_pool__get_shared(apr_thread_pool_t **thread_pool,
+                            svn_thread_pool__shared_t *shared,
+                            apr_pool_t *owning_pool,
+                            apr_pool_t *scratch_pool)
+{
+  create_baton_t baton;
+
+  baton.shared = shared;
+  baton.owning_pool = owning_pool;
+  SVN_ERR(svn_atomic__init_once(&shared->initialized,
+                                create_shared_thread_pool, &baton,
+                                scratch_pool));
+
+  *thread_pool = shared->thread_pool;
+  return SVN_NO_ERROR;
+}
+
+#endif /* APR_HAS_THREADS */
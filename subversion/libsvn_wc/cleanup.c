@@ -133,17 +133,24 @@ cleanup_internal(svn_wc__db_t *db,
 
   if (fix_recorded_timestamps)
     {
+      svn_error_t *err;
+
       /* Instead of implementing a separate repair step here, use the standard
          status walker's optimized implementation, which performs repairs when
-         there is a lock. */
-      SVN_ERR(svn_wc__internal_walk_status(db, dir_abspath, svn_depth_infinity,
-                                           FALSE /* get_all */,
-                                           FALSE /* no_ignore */,
-                                           FALSE /* ignore_text_mods */,
-                                           NULL /* ignore patterns */,
-                                           status_dummy_callback, NULL,
-                                           cancel_func, cancel_baton,
-                                           scratch_pool));
+         there is a lock.  It compares the files in parallel; collect the
+         repairs in a single transaction instead of committing every file
+         on its own. */
+      SVN_ERR(svn_wc__db_batch_begin(db, dir_abspath, scratch_pool));
+      err = svn_wc__internal_walk_status(db, dir_abspath, svn_depth_infinity,
+                                         FALSE /* get_all */,
+                                         FALSE /* no_ignore */,
+                                         FALSE /* ignore_text_mods */,
+                                         NULL /* ignore patterns */,
+                                         status_dummy_callback, NULL,
+                                         cancel_func, cancel_baton,
+                                         scratch_pool);
+      SVN_ERR(svn_error_compose_create(
+                err, svn_wc__db_batch_end(db, dir_abspath, scratch_pool)));
     }
 
   /* All done, toss the lock */
@@ -106,6 +106,15 @@ svn_wc__context_create_with_db(svn_wc_context_t **wc_ctx,
 }
 
 
+void
+svn_wc__context_set_fetch_pristine_func(svn_wc_context_t *wc_ctx,
+                                        svn_wc__fetch_pristine_func_t fetch_func,
+                                        void *fetch_baton)
+{
+  svn_wc__db_set_fetch_pristine_func(wc_ctx->db, fetch_func, fetch_baton);
+}
+
+
 svn_error_t *
 svn_wc_context_destroy(svn_wc_context_t *wc_ctx)
 {
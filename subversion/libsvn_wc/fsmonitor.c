@@ -0,0 +1,1067 @@
+/*
+ * fsmonitor.c :  keeping track of changed directories in a working copy
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+
+
+#include <string.h>
+
+#include <apr_pools.h>
+#include <apr_hash.h>
+#include <apr_portable.h>
+
+#include "svn_dirent_uri.h"
+#include "svn_error.h"
+#include "svn_hash.h"
+#include "svn_io.h"
+#include "svn_path.h"
+#include "svn_pools.h"
+#include "svn_string.h"
+#include "svn_wc.h"
+
+#include "adm_files.h"
+#include "fsmonitor.h"
+
+#include "svn_private_config.h"
+#include "private/svn_local_socket.h"
+#include "private/svn_string_private.h"
+#include "private/svn_wc_private.h"
+
+#ifndef WIN32
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/un.h>
+
+#ifdef HAVE_UNISTD_H
+#include <unistd.h>
+#endif
+
+#define FSMONITOR_HAVE_SOCKETS
+#endif
+
+#if defined(FSMONITOR_HAVE_SOCKETS) && defined(HAVE_SYS_INOTIFY_H)
+#include <poll.h>
+#include <sys/inotify.h>
+
+#define FSMONITOR_HAVE_INOTIFY
+#endif
+
+
+/* The monitor process listens on a Unix domain socket in the working
+ * copy's administrative directory.  Each connection carries a single
+ * request, terminated by the client shutting down its side of the
+ * connection, and a single response, terminated by the monitor closing
+ * the connection.  Both are sequences of lines:
+ *
+ *   query                          Ask for the changed directories.
+ *
+ *   valid SEQ                      Response: all directories but the
+ *   d RELPATH                      ones listed are clean.  SEQ identifies
+ *   ...                            this point in the monitor's event
+ *   end                            stream.
+ *
+ *   invalid SEQ                    Response: nothing is known about the
+ *   end                            state of the working copy.
+ *
+ *   sync SEQ full|partial          A status walk that began with a query
+ *   c RELPATH                      answered with SEQ found the listed
+ *   d RELPATH                      directories clean or not.  "full"
+ *   ...                            walks covered all directories.
+ *   end
+ *
+ *   ok | stale                     Response: whether the monitor used
+ *                                  the information.
+ *
+ * All RELPATHs are relative to the working copy root.
+ */
+
+/* Name of the monitor's socket within the administrative directory. */
+#define FSMONITOR_SOCKET "fsmonitor"
+
+#define SDB_FILE  "wc.db"
+
+/* Seconds to wait for the other side of the connection before giving up.
+ * A status walk should rather read all directories than hang. */
+#define FSMONITOR_TIMEOUT 5
+
+#ifdef FSMONITOR_HAVE_SOCKETS
+
+/* Set *NATIVE_PATH and *ADDR to describe the monitor socket of the working
+ * copy at WCROOT_ABSPATH.  Use POOL for allocations. */
+static svn_error_t *
+make_address(const char **native_path,
+             struct sockaddr_un *addr,
+             const char *wcroot_abspath,
+             apr_pool_t *pool)
+{
+  return svn_error_trace(svn_io__local_socket_address(
+                           native_path, addr,
+                           svn_wc__adm_child(wcroot_abspath,
+                                             FSMONITOR_SOCKET, pool),
+                           pool));
+}
+
+/* Limit the time that reading from or writing to SOCK may block. */
+static void
+set_timeouts(int sock)
+{
+  struct timeval tv;
+
+  tv.tv_sec = FSMONITOR_TIMEOUT;
+  tv.tv_usec = 0;
+  setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+  setsockopt(sock, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+}
+
+/* Write all of DATA to SOCK.  Neither side may get killed by SIGPIPE
+ * just because the other one went away. */
+static svn_error_t *
+send_all(int sock,
+         const svn_stringbuf_t *data)
+{
+  apr_size_t offset = 0;
+  int flags = 0;
+
+#ifdef MSG_NOSIGNAL
+  flags = MSG_NOSIGNAL;
+#elif defined(SO_NOSIGPIPE)
+  int on = 1;
+  setsockopt(sock, SOL_SOCKET, SO_NOSIGPIPE, &on, sizeof(on));
+#endif
+
+  while (offset < data->len)
+    {
+      ssize_t count = send(sock, data->data + offset, data->len - offset,
+                           flags);
+      if (count < 0 && errno == EINTR)
+        continue;
+      if (count < 0)
+        return svn_error_wrap_apr(apr_get_netos_error(),
+                                  _("Can't write to monitor connection"));
+
+      offset += count;
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Return SOCK as a stream in *STREAM that will close SOCK when POOL gets
+ * cleared or destroyed. */
+static svn_error_t *
+wrap_socket(svn_stream_t **stream,
+            int sock,
+            apr_pool_t *pool)
+{
+  apr_file_t *file;
+  apr_os_file_t os_file = sock;
+  apr_status_t status = apr_os_pipe_put_ex(&file, &os_file, TRUE, pool);
+  if (status)
+    {
+      close(sock);
+      return svn_error_wrap_apr(status, _("Can't use monitor connection"));
+    }
+
+  *stream = svn_stream_from_aprfile2(file, FALSE, pool);
+  return SVN_NO_ERROR;
+}
+
+/* Return an error if the process at the other end of SOCK runs as a
+ * different user than we do, or if we can't tell.  Both sides check:
+ * walkers must not take directories for clean on the word of some other
+ * user's process that took over the socket path. */
+static svn_error_t *
+check_peer(int sock)
+{
+  if (svn_io__local_socket_peer_is_self(sock) == svn_tristate_true)
+    return SVN_NO_ERROR;
+
+  return svn_error_create(SVN_ERR_WC_PATH_ACCESS_DENIED, NULL,
+                          _("Rejected monitor connection of another user"));
+}
+
+/* Send REQUEST to the monitor of the working copy at WCROOT_ABSPATH and
+ * return its response in *RESPONSE, allocated in RESULT_POOL.  Use
+ * SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+exchange(svn_stringbuf_t **response,
+         const char *wcroot_abspath,
+         const svn_stringbuf_t *request,
+         apr_pool_t *result_pool,
+         apr_pool_t *scratch_pool)
+{
+  const char *native_path;
+  struct sockaddr_un addr;
+  svn_stream_t *stream;
+  int sock;
+
+  SVN_ERR(make_address(&native_path, &addr, wcroot_abspath, scratch_pool));
+
+  sock = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (sock < 0)
+    return svn_error_wrap_apr(apr_get_netos_error(),
+                              _("Can't create monitor socket"));
+
+  svn_io__set_cloexec(sock);
+  set_timeouts(sock);
+  SVN_ERR(wrap_socket(&stream, sock, scratch_pool));
+
+  if (connect(sock, (struct sockaddr *)&addr, sizeof(addr)) < 0)
+    return svn_error_wrap_apr(apr_get_netos_error(),
+                              _("Can't connect to monitor"));
+
+  SVN_ERR(check_peer(sock));
+  SVN_ERR(send_all(sock, request));
+  if (shutdown(sock, SHUT_WR) < 0)
+    return svn_error_wrap_apr(apr_get_netos_error(),
+                              _("Can't send monitor request"));
+
+  return svn_error_trace(svn_stringbuf_from_stream(response, stream, 0,
+                                                   result_pool));
+}
+
+#endif /* FSMONITOR_HAVE_SOCKETS */
+
+/* Split TEXT into lines and return them in *LINES, allocated in POOL.
+ * Return an error if the last line is not "end". */
+static svn_error_t *
+split_message(apr_array_header_t **lines,
+              const char *text,
+              apr_pool_t *pool)
+{
+  *lines = svn_cstring_split(text, "\n", FALSE, pool);
+  if ((*lines)->nelts == 0
+      || strcmp(APR_ARRAY_IDX(*lines, (*lines)->nelts - 1, const char *),
+                "end") != 0)
+    return svn_error_create(SVN_ERR_STREAM_MALFORMED_DATA, NULL,
+                            _("Incomplete monitor message"));
+
+  return SVN_NO_ERROR;
+}
+
+
+/*** Status walker side ***/
+
+struct svn_wc__fsmonitor_t
+{
+  /* The working copy that the monitor watches. */
+  const char *wcroot_abspath;
+
+  /* The monitor's SEQ as returned by the query. */
+  const char *seq;
+
+  /* Whether directories not in CHANGED are clean. */
+  svn_boolean_t valid;
+
+  /* Relpaths of all directories that may not be clean, mapped to "". */
+  apr_hash_t *changed;
+
+  /* The sync request under construction. */
+  svn_stringbuf_t *records;
+};
+
+svn_error_t *
+svn_wc__fsmonitor_query(svn_wc__fsmonitor_t **fsmonitor,
+                        const char *wcroot_abspath,
+                        apr_pool_t *result_pool,
+                        apr_pool_t *scratch_pool)
+{
+#ifdef FSMONITOR_HAVE_SOCKETS
+  svn_wc__fsmonitor_t *result;
+  svn_stringbuf_t *response;
+  apr_array_header_t *lines;
+  const char *header;
+  svn_error_t *err;
+  int i;
+
+  *fsmonitor = NULL;
+
+  /* No monitor is the normal case and anything going wrong with it simply
+     means that we have to read all directories. */
+  err = exchange(&response, wcroot_abspath,
+                 svn_stringbuf_create("query\n", scratch_pool),
+                 scratch_pool, scratch_pool);
+  if (!err)
+    err = split_message(&lines, response->data, scratch_pool);
+  if (err)
+    {
+      svn_error_clear(err);
+      return SVN_NO_ERROR;
+    }
+
+  result = apr_pcalloc(result_pool, sizeof(*result));
+  result->wcroot_abspath = apr_pstrdup(result_pool, wcroot_abspath);
+  result->changed = apr_hash_make(result_pool);
+  result->records = svn_stringbuf_create_empty(result_pool);
+
+  header = APR_ARRAY_IDX(lines, 0, const char *);
+  if (strncmp(header, "valid ", 6) == 0)
+    {
+      result->valid = TRUE;
+      result->seq = apr_pstrdup(result_pool, header + 6);
+    }
+  else if (strncmp(header, "invalid ", 8) == 0)
+    result->seq = apr_pstrdup(result_pool, header + 8);
+  else
+    return SVN_NO_ERROR;
+
+  for (i = 1; i < lines->nelts - 1; i++)
+    {
+      const char *line = APR_ARRAY_IDX(lines, i, const char *);
+
+      if (strncmp(line, "d ", 2) != 0)
+        return SVN_NO_ERROR;
+
+      svn_hash_sets(result->changed, apr_pstrdup(result_pool, line + 2), "");
+    }
+
+  *fsmonitor = result;
+#else
+  *fsmonitor = NULL;
+#endif
+
+  return SVN_NO_ERROR;
+}
+
+svn_boolean_t
+svn_wc__fsmonitor_is_clean(const svn_wc__fsmonitor_t *fsmonitor,
+                           const char *local_abspath)
+{
+  const char *relpath;
+
+  if (!fsmonitor || !fsmonitor->valid)
+    return FALSE;
+
+  relpath = svn_dirent_skip_ancestor(fsmonitor->wcroot_abspath,
+                                     local_abspath);
+
+  return relpath && !svn_hash_gets(fsmonitor->changed, relpath);
+}
+
+void
+svn_wc__fsmonitor_record(svn_wc__fsmonitor_t *fsmonitor,
+                         const char *local_abspath,
+                         svn_boolean_t clean)
+{
+  const char *relpath = svn_dirent_skip_ancestor(fsmonitor->wcroot_abspath,
+                                                 local_abspath);
+
+  /* Versioned paths never contain newlines, so we only skip paths that
+     the monitor would not ask us about anyway. */
+  if (!relpath || strchr(relpath, '\n'))
+    return;
+
+  svn_stringbuf_appendcstr(fsmonitor->records, clean ? "c " : "d ");
+  svn_stringbuf_appendcstr(fsmonitor->records, relpath);
+  svn_stringbuf_appendbyte(fsmonitor->records, '\n');
+}
+
+svn_error_t *
+svn_wc__fsmonitor_sync(svn_wc__fsmonitor_t *fsmonitor,
+                       svn_boolean_t full,
+                       apr_pool_t *scratch_pool)
+{
+#ifdef FSMONITOR_HAVE_SOCKETS
+  svn_stringbuf_t *request;
+  svn_stringbuf_t *response;
+
+  if (!full && svn_stringbuf_isempty(fsmonitor->records))
+    return SVN_NO_ERROR;
+
+  request = svn_stringbuf_createf(scratch_pool, "sync %s %s\n",
+                                  fsmonitor->seq,
+                                  full ? "full" : "partial");
+  svn_stringbuf_appendstr(request, fsmonitor->records);
+  svn_stringbuf_appendcstr(request, "end\n");
+
+  /* The monitor is only an optimization. */
+  svn_error_clear(exchange(&response, fsmonitor->wcroot_abspath, request,
+                           scratch_pool, scratch_pool));
+  svn_stringbuf_setempty(fsmonitor->records);
+#endif
+
+  return SVN_NO_ERROR;
+}
+
+
+/*** Monitor side ***/
+
+#ifdef FSMONITOR_HAVE_INOTIFY
+
+/* Events that may indicate a change of a directory's contents as seen by
+ * the status walker. */
+#define DIR_EVENTS (IN_ATTRIB | IN_CLOSE_WRITE | IN_CREATE | IN_DELETE \
+                    | IN_DELETE_SELF | IN_MODIFY | IN_MOVE_SELF          \
+                    | IN_MOVED_FROM | IN_MOVED_TO)
+
+/* Events in the administrative directory that may indicate a change of
+ * wc.db. */
+#define ADM_EVENTS (IN_CREATE | IN_DELETE | IN_DELETE_SELF | IN_MODIFY \
+                    | IN_MOVE_SELF | IN_MOVED_FROM | IN_MOVED_TO)
+
+/* Compact a hash once it has seen this many more removals than it has
+ * entries, so that long-running monitors don't grow without bounds. */
+#define COMPACT_THRESHOLD 1024
+
+/* The state of a running monitor. */
+typedef struct monitor_t
+{
+  /* The working copy that we watch. */
+  const char *wcroot_abspath;
+
+  /* The inotify instance and the watch on the administrative directory. */
+  int inotify_fd;
+  int adm_wd;
+
+  /* The socket that the status walkers connect to. */
+  int listen_fd;
+
+  /* Relpaths of the watched directories, keyed by watch descriptor. */
+  apr_hash_t *watches;
+  int removed_watches;
+  apr_pool_t *watches_pool;
+
+  /* Whether all directories not in CHANGED are clean. */
+  svn_boolean_t valid;
+
+  /* Set if we could not watch some directory.  The monitor will then never
+     become valid again. */
+  svn_boolean_t incomplete;
+
+  /* Counts all events.  Never 0 after initialization. */
+  apr_uint64_t seq;
+
+  /* Value of SEQ when we last became invalid. */
+  apr_uint64_t invalidated_seq;
+
+  /* Relpaths of the directories that may not be clean, mapped to the SEQ
+     (apr_uint64_t *) of their latest event or to 0 if we only know that
+     from some status walk. */
+  apr_hash_t *changed;
+  int removed_changes;
+  apr_pool_t *changed_pool;
+
+  /* Parent of the other pools. */
+  apr_pool_t *pool;
+} monitor_t;
+
+/* Forget everything about the state of M's working copy. */
+static void
+invalidate(monitor_t *m)
+{
+  m->valid = FALSE;
+  m->invalidated_seq = ++m->seq;
+
+  svn_pool_clear(m->changed_pool);
+  m->changed = apr_hash_make(m->changed_pool);
+  m->removed_changes = 0;
+}
+
+/* Set the SEQ of the directory at RELPATH in M->CHANGED to SEQ, adding the
+ * directory if necessary.  Don't lower an existing SEQ if KEEP_NEWER is
+ * set. */
+static void
+set_changed(monitor_t *m,
+            const char *relpath,
+            apr_uint64_t seq,
+            svn_boolean_t keep_newer)
+{
+  apr_uint64_t *value = svn_hash_gets(m->changed, relpath);
+
+  if (!value)
+    {
+      value = apr_palloc(m->changed_pool, sizeof(*value));
+      *value = seq;
+      svn_hash_sets(m->changed, apr_pstrdup(m->changed_pool, relpath), value);
+    }
+  else if (!keep_newer || *value < seq)
+    *value = seq;
+}
+
+/* Copy M->CHANGED and M->WATCHES into fresh pools if they have seen too
+ * many removals. */
+static void
+compact(monitor_t *m)
+{
+  apr_hash_index_t *hi;
+  apr_pool_t *pool;
+  apr_hash_t *hash;
+
+  if (m->removed_changes > COMPACT_THRESHOLD
+      && m->removed_changes > (int)apr_hash_count(m->changed))
+    {
+      pool = svn_pool_create(m->pool);
+      hash = apr_hash_make(pool);
+      for (hi = apr_hash_first(pool, m->changed); hi; hi = apr_hash_next(hi))
+        svn_hash_sets(hash, apr_pstrdup(pool, apr_hash_this_key(hi)),
+                      apr_pmemdup(pool, apr_hash_this_val(hi),
+                                  sizeof(apr_uint64_t)));
+
+      svn_pool_destroy(m->changed_pool);
+      m->changed_pool = pool;
+      m->changed = hash;
+      m->removed_changes = 0;
+    }
+
+  if (m->removed_watches > COMPACT_THRESHOLD
+      && m->removed_watches > (int)apr_hash_count(m->watches))
+    {
+      pool = svn_pool_create(m->pool);
+      hash = apr_hash_make(pool);
+      for (hi = apr_hash_first(pool, m->watches); hi; hi = apr_hash_next(hi))
+        apr_hash_set(hash,
+                     apr_pmemdup(pool, apr_hash_this_key(hi), sizeof(int)),
+                     sizeof(int),
+                     apr_pstrdup(pool, apr_hash_this_val(hi)));
+
+      svn_pool_destroy(m->watches_pool);
+      m->watches_pool = pool;
+      m->watches = hash;
+      m->removed_watches = 0;
+    }
+}
+
+/* Start watching the directory at RELPATH in M's working copy and all
+ * directories below it.  If MARK_CHANGED is set, add all of them to
+ * M->CHANGED.  Use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+add_watches(monitor_t *m,
+            const char *relpath,
+            svn_boolean_t mark_changed,
+            apr_pool_t *scratch_pool)
+{
+  const char *abspath = svn_dirent_join(m->wcroot_abspath, relpath,
+                                        scratch_pool);
+  const char *native_path;
+  apr_hash_t *dirents;
+  apr_hash_index_t *hi;
+  apr_pool_t *iterpool;
+  const char *old_relpath;
+  svn_error_t *err;
+  int wd;
+
+  SVN_ERR(svn_path_cstring_from_utf8(&native_path,
+                                     svn_dirent_local_style(abspath,
+                                                            scratch_pool),
+                                     scratch_pool));
+
+  wd = inotify_add_watch(m->inotify_fd, native_path,
+                         DIR_EVENTS | IN_ONLYDIR | IN_DONT_FOLLOW
+                         | IN_EXCL_UNLINK);
+  if (wd < 0)
+    {
+      /* Directories may disappear at any time.  We will get an event
+         for that on the parent. */
+      if (errno == ENOENT || errno == ENOTDIR)
+        return SVN_NO_ERROR;
+
+      /* Typically, we ran out of watches.  Fall back to full scans. */
+      m->incomplete = TRUE;
+      invalidate(m);
+      return SVN_NO_ERROR;
+    }
+
+  /* Moved directories keep their watch descriptor. */
+  old_relpath = apr_hash_get(m->watches, &wd, sizeof(wd));
+  if (!old_relpath || strcmp(old_relpath, relpath) != 0)
+    {
+      if (old_relpath)
+        m->removed_watches++;
+
+      apr_hash_set(m->watches,
+                   apr_pmemdup(m->watches_pool, &wd, sizeof(wd)), sizeof(wd),
+                   apr_pstrdup(m->watches_pool, relpath));
+    }
+
+  if (mark_changed)
+    set_changed(m, relpath, ++m->seq, FALSE);
+
+  err = svn_io_get_dirents3(&dirents, abspath, TRUE /* only_check_type */,
+                            scratch_pool, scratch_pool);
+  if (err)
+    {
+      svn_error_clear(err);
+      return SVN_NO_ERROR;
+    }
+
+  iterpool = svn_pool_create(scratch_pool);
+  for (hi = apr_hash_first(scratch_pool, dirents); hi; hi = apr_hash_next(hi))
+    {
+      const char *name = apr_hash_this_key(hi);
+      const svn_io_dirent2_t *dirent = apr_hash_this_val(hi);
+
+      if (dirent->kind != svn_node_dir || dirent->special
+          || svn_wc_is_adm_dir(name, iterpool))
+        continue;
+
+      svn_pool_clear(iterpool);
+      SVN_ERR(add_watches(m, svn_relpath_join(relpath, name, iterpool),
+                          mark_changed, iterpool));
+    }
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Process the inotify EVENT for monitor M.  Use SCRATCH_POOL for
+ * temporary allocations. */
+static svn_error_t *
+handle_event(monitor_t *m,
+             const struct inotify_event *event,
+             apr_pool_t *scratch_pool)
+{
+  const char *relpath;
+  const char *name = NULL;
+
+  if (event->mask & IN_Q_OVERFLOW)
+    {
+      invalidate(m);
+      return SVN_NO_ERROR;
+    }
+
+  if (event->len)
+    {
+      svn_error_t *err = svn_path_cstring_to_utf8(&name, event->name,
+                                                  scratch_pool);
+
+      /* We can't tell what changed. */
+      if (err)
+        {
+          svn_error_clear(err);
+          invalidate(m);
+          return SVN_NO_ERROR;
+        }
+    }
+
+  if (event->wd == m->adm_wd)
+    {
+      /* Any change to wc.db may change what "clean" means.  Readers don't
+         modify the database, its journal or its WAL, but they do write to
+         the WAL index (wc.db-shm). */
+      if (event->mask & (IN_DELETE_SELF | IN_MOVE_SELF | IN_IGNORED))
+        {
+          m->incomplete = TRUE;
+          invalidate(m);
+        }
+      else if (name
+               && strncmp(name, SDB_FILE, strlen(SDB_FILE)) == 0
+               && strcmp(name, SDB_FILE "-shm") != 0
+               && ((event->mask & IN_MODIFY)
+                   || strcmp(name, SDB_FILE) == 0))
+        invalidate(m);
+
+      return SVN_NO_ERROR;
+    }
+
+  relpath = apr_hash_get(m->watches, &event->wd, sizeof(event->wd));
+  if (!relpath)
+    return SVN_NO_ERROR;
+
+  if (event->mask & IN_IGNORED)
+    {
+      apr_hash_set(m->watches, &event->wd, sizeof(event->wd), NULL);
+      m->removed_watches++;
+      return SVN_NO_ERROR;
+    }
+
+  /* The administrative area is none of the status walker's business. */
+  if (name && *relpath == '\0' && svn_wc_is_adm_dir(name, scratch_pool))
+    return SVN_NO_ERROR;
+
+  set_changed(m, relpath, ++m->seq, FALSE);
+
+  /* New directories may already contain anything. */
+  if (name
+      && (event->mask & IN_ISDIR)
+      && (event->mask & (IN_CREATE | IN_MOVED_TO)))
+    SVN_ERR(add_watches(m, svn_relpath_join(relpath, name, scratch_pool),
+                        TRUE, scratch_pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* Read and process all pending events of monitor M.  Use SCRATCH_POOL for
+ * temporary allocations. */
+static svn_error_t *
+read_events(monitor_t *m,
+            apr_pool_t *scratch_pool)
+{
+  /* Large enough for at least one event with the longest name and
+     suitably aligned for the event structs. */
+  union
+    {
+      struct inotify_event event;
+      char data[64 * 1024];
+    } buffer;
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+
+  while (TRUE)
+    {
+      ssize_t len = read(m->inotify_fd, buffer.data, sizeof(buffer.data));
+      ssize_t offset;
+
+      if (len < 0 && errno == EINTR)
+        continue;
+      if (len < 0 && errno == EAGAIN)
+        break;
+      if (len <= 0)
+        return svn_error_wrap_apr(apr_get_os_error(),
+                                  _("Can't read file system events"));
+
+      for (offset = 0; offset < len; )
+        {
+          const struct inotify_event *event
+            = (const struct inotify_event *)(buffer.data + offset);
+
+          svn_pool_clear(iterpool);
+          SVN_ERR(handle_event(m, event, iterpool));
+          offset += sizeof(*event) + event->len;
+        }
+    }
+
+  svn_pool_destroy(iterpool);
+  compact(m);
+
+  return SVN_NO_ERROR;
+}
+
+/* Return the response of monitor M to a status walker's query, allocated
+ * in RESULT_POOL. */
+static svn_stringbuf_t *
+answer_query(monitor_t *m,
+             apr_pool_t *result_pool)
+{
+  svn_stringbuf_t *response;
+  apr_hash_index_t *hi;
+
+  if (!m->valid)
+    return svn_stringbuf_createf(result_pool,
+                                 "invalid %" APR_UINT64_T_FMT "\nend\n",
+                                 m->seq);
+
+  response = svn_stringbuf_createf(result_pool,
+                                   "valid %" APR_UINT64_T_FMT "\n", m->seq);
+  for (hi = apr_hash_first(result_pool, m->changed); hi;
+       hi = apr_hash_next(hi))
+    {
+      const char *relpath = apr_hash_this_key(hi);
+
+      /* Such directories can't be versioned. */
+      if (strchr(relpath, '\n'))
+        continue;
+
+      svn_stringbuf_appendcstr(response, "d ");
+      svn_stringbuf_appendcstr(response, relpath);
+      svn_stringbuf_appendbyte(response, '\n');
+    }
+
+  svn_stringbuf_appendcstr(response, "end\n");
+  return response;
+}
+
+/* Let monitor M learn from the sync request in LINES and return the
+ * response, allocated in RESULT_POOL. */
+static svn_stringbuf_t *
+answer_sync(monitor_t *m,
+            const apr_array_header_t *lines,
+            apr_pool_t *result_pool)
+{
+  const char *header = APR_ARRAY_IDX(lines, 0, const char *);
+  apr_array_header_t *words = svn_cstring_split(header, " ", TRUE,
+                                                result_pool);
+  apr_uint64_t seq;
+  svn_boolean_t full;
+  svn_error_t *err;
+  int i;
+
+  if (words->nelts != 3)
+    return svn_stringbuf_create("stale\n", result_pool);
+
+  err = svn_cstring_strtoui64(&seq, APR_ARRAY_IDX(words, 1, const char *),
+                              0, APR_UINT64_MAX, 10);
+  if (err)
+    {
+      svn_error_clear(err);
+      return svn_stringbuf_create("stale\n", result_pool);
+    }
+
+  full = strcmp(APR_ARRAY_IDX(words, 2, const char *), "full") == 0;
+
+  /* The walker may have seen something that we since forgot about.
+     Partial walks can't tell us about directories that they did not
+     visit, so they are only useful if we already know about those. */
+  if (seq < m->invalidated_seq || seq > m->seq || (!m->valid && !full))
+    return svn_stringbuf_create("stale\n", result_pool);
+
+  if (full && !m->incomplete)
+    m->valid = TRUE;
+
+  for (i = 1; i < lines->nelts - 1; i++)
+    {
+      const char *line = APR_ARRAY_IDX(lines, i, const char *);
+
+      if (strncmp(line, "c ", 2) == 0)
+        {
+          apr_uint64_t *value = svn_hash_gets(m->changed, line + 2);
+
+          /* Only if nothing happened after the walker read it. */
+          if (value && *value <= seq)
+            {
+              svn_hash_sets(m->changed, line + 2, NULL);
+              m->removed_changes++;
+            }
+        }
+      else if (strncmp(line, "d ", 2) == 0)
+        set_changed(m, line + 2, 0, TRUE);
+    }
+
+  return svn_stringbuf_create("ok\n", result_pool);
+}
+
+/* Accept the next connection to monitor M and answer its request.  Use
+ * SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+handle_client(monitor_t *m,
+              apr_pool_t *scratch_pool)
+{
+  svn_stream_t *stream;
+  svn_stringbuf_t *request;
+  svn_stringbuf_t *response;
+  apr_array_header_t *lines;
+  const char *header;
+  int sock;
+
+  do
+    sock = accept(m->listen_fd, NULL, NULL);
+  while (sock < 0 && errno == EINTR);
+
+  if (sock < 0)
+    return svn_error_wrap_apr(apr_get_netos_error(),
+                              _("Can't accept monitor client"));
+
+  svn_io__set_cloexec(sock);
+  set_timeouts(sock);
+  SVN_ERR(wrap_socket(&stream, sock, scratch_pool));
+  SVN_ERR(check_peer(sock));
+
+  SVN_ERR(svn_stringbuf_from_stream(&request, stream, 0, scratch_pool));
+  SVN_ERR(split_message(&lines, request->data, scratch_pool));
+
+  /* Process events that happened before the request, so that its
+     response reflects them. */
+  SVN_ERR(read_events(m, scratch_pool));
+
+  header = APR_ARRAY_IDX(lines, 0, const char *);
+  if (strcmp(header, "query") == 0)
+    response = answer_query(m, scratch_pool);
+  else if (strncmp(header, "sync ", 5) == 0)
+    response = answer_sync(m, lines, scratch_pool);
+  else
+    return svn_error_createf(SVN_ERR_STREAM_MALFORMED_DATA, NULL,
+                             _("Unknown monitor request '%s'"), header);
+
+  return svn_error_trace(send_all(sock, response));
+}
+
+/* Pool cleanup handler closing the descriptors of the monitor_t in DATA
+ * and removing its socket file. */
+static apr_status_t
+close_monitor(void *data)
+{
+  monitor_t *m = data;
+
+  if (m->listen_fd >= 0)
+    {
+      struct sockaddr_un addr;
+      socklen_t len = sizeof(addr);
+
+      if (getsockname(m->listen_fd, (struct sockaddr *)&addr, &len) == 0)
+        unlink(addr.sun_path);
+
+      close(m->listen_fd);
+    }
+
+  if (m->inotify_fd >= 0)
+    close(m->inotify_fd);
+
+  return APR_SUCCESS;
+}
+
+/* Create the socket for monitor M.  Use SCRATCH_POOL for temporary
+ * allocations. */
+static svn_error_t *
+listen_socket(monitor_t *m,
+              apr_pool_t *scratch_pool)
+{
+  const char *socket_path = svn_wc__adm_child(m->wcroot_abspath,
+                                              FSMONITOR_SOCKET,
+                                              scratch_pool);
+  const char *native_path;
+  struct sockaddr_un addr;
+  svn_stringbuf_t *response;
+  svn_error_t *err;
+
+  SVN_ERR(make_address(&native_path, &addr, m->wcroot_abspath,
+                       scratch_pool));
+
+  /* Don't steal the socket of another monitor. */
+  err = exchange(&response, m->wcroot_abspath,
+                 svn_stringbuf_create("query\n", scratch_pool),
+                 scratch_pool, scratch_pool);
+  if (!err)
+    return svn_error_createf(SVN_ERR_WC_LOCKED, NULL,
+                             _("Working copy '%s' is already being "
+                               "monitored"),
+                             svn_dirent_local_style(m->wcroot_abspath,
+                                                    scratch_pool));
+  svn_error_clear(err);
+
+  /* Remove the socket left behind by some earlier monitor. */
+  if (unlink(native_path) < 0 && errno != ENOENT)
+    return svn_error_wrap_apr(apr_get_os_error(),
+                              _("Can't remove '%s'"),
+                              svn_dirent_local_style(socket_path,
+                                                     scratch_pool));
+
+  m->listen_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (m->listen_fd < 0)
+    return svn_error_wrap_apr(apr_get_netos_error(),
+                              _("Can't create monitor socket"));
+
+  svn_io__set_cloexec(m->listen_fd);
+
+  if (bind(m->listen_fd, (struct sockaddr *)&addr, sizeof(addr)) < 0)
+    return svn_error_wrap_apr(apr_get_netos_error(),
+                              _("Can't bind monitor socket '%s'"),
+                              svn_dirent_local_style(socket_path,
+                                                     scratch_pool));
+
+  if (chmod(native_path, S_IRUSR | S_IWUSR) < 0)
+    return svn_error_wrap_apr(apr_get_os_error(),
+                              _("Can't set permissions on '%s'"),
+                              svn_dirent_local_style(socket_path,
+                                                     scratch_pool));
+
+  if (listen(m->listen_fd, SOMAXCONN) < 0)
+    return svn_error_wrap_apr(apr_get_netos_error(),
+                              _("Can't listen on monitor socket"));
+
+  return SVN_NO_ERROR;
+}
+
+#endif /* FSMONITOR_HAVE_INOTIFY */
+
+svn_error_t *
+svn_wc__fsmonitor_run(const char *wcroot_abspath,
+                      svn_cancel_func_t cancel_func,
+                      void *cancel_baton,
+                      apr_pool_t *scratch_pool)
+{
+#ifdef FSMONITOR_HAVE_INOTIFY
+  monitor_t *m = apr_pcalloc(scratch_pool, sizeof(*m));
+  const char *adm_abspath = svn_wc__adm_child(wcroot_abspath, NULL,
+                                              scratch_pool);
+  const char *native_path;
+  apr_pool_t *iterpool;
+
+  m->wcroot_abspath = wcroot_abspath;
+  m->pool = scratch_pool;
+  m->inotify_fd = -1;
+  m->listen_fd = -1;
+  m->watches_pool = svn_pool_create(scratch_pool);
+  m->watches = apr_hash_make(m->watches_pool);
+  m->changed_pool = svn_pool_create(scratch_pool);
+  m->changed = apr_hash_make(m->changed_pool);
+  m->seq = 1;
+  m->invalidated_seq = 1;
+
+  apr_pool_cleanup_register(scratch_pool, m, close_monitor,
+                            apr_pool_cleanup_null);
+
+  m->inotify_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+  if (m->inotify_fd < 0)
+    return svn_error_wrap_apr(apr_get_os_error(),
+                              _("Can't watch for file system events"));
+
+  /* Watch wc.db first and the directories before accepting walkers, so
+     that we can't miss any event that happens during their walks. */
+  SVN_ERR(svn_path_cstring_from_utf8(&native_path,
+                                     svn_dirent_local_style(adm_abspath,
+                                                            scratch_pool),
+                                     scratch_pool));
+  m->adm_wd = inotify_add_watch(m->inotify_fd, native_path,
+                                ADM_EVENTS | IN_ONLYDIR);
+  if (m->adm_wd < 0)
+    return svn_error_wrap_apr(apr_get_os_error(),
+                              _("Can't watch '%s'"),
+                              svn_dirent_local_style(adm_abspath,
+                                                     scratch_pool));
+
+  SVN_ERR(add_watches(m, "", FALSE, scratch_pool));
+  if (m->incomplete)
+    return svn_error_createf(SVN_ERR_WC_NOT_WORKING_COPY, NULL,
+                             _("Can't watch all directories of '%s'; "
+                               "the limit on inotify watches may be "
+                               "too low"),
+                             svn_dirent_local_style(wcroot_abspath,
+                                                    scratch_pool));
+
+  SVN_ERR(listen_socket(m, scratch_pool));
+
+  iterpool = svn_pool_create(scratch_pool);
+  while (TRUE)
+    {
+      struct pollfd fds[2];
+      int count;
+
+      svn_pool_clear(iterpool);
+      if (cancel_func)
+        SVN_ERR(cancel_func(cancel_baton));
+
+      fds[0].fd = m->inotify_fd;
+      fds[0].events = POLLIN;
+      fds[1].fd = m->listen_fd;
+      fds[1].events = POLLIN;
+
+      /* Wake up regularly to check for cancellation. */
+      count = poll(fds, 2, 1000);
+      if (count < 0 && errno != EINTR)
+        return svn_error_wrap_apr(apr_get_os_error(),
+                                  _("Can't wait for file system events"));
+      if (count <= 0)
+        continue;
+
+      if (fds[0].revents)
+        SVN_ERR(read_events(m, iterpool));
+
+      /* A misbehaving walker must not stop us. */
+      if (fds[1].revents)
+        svn_error_clear(handle_client(m, iterpool));
+    }
+#else
+  return svn_error_create(SVN_ERR_UNSUPPORTED_FEATURE, NULL,
+                          _("Monitoring working copies is not supported "
+                            "on this platform"));
+#endif
+}
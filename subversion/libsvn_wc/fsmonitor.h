@@ -0,0 +1,91 @@
+/*
+ * fsmonitor.h :  asking a file system monitor which directories changed
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+#ifndef SVN_LIBSVN_WC_FSMONITOR_H
+#define SVN_LIBSVN_WC_FSMONITOR_H
+
+#include <apr_pools.h>
+
+#include "svn_types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/* A working copy may have a monitor process (see svn_wc__fsmonitor_run())
+ * that watches all of its directories for changes.  It keeps a list of
+ * directories whose on-disk contents may no longer match what the status
+ * walker saw when it last read them.  All other directories are "clean":
+ * they contain exactly the nodes recorded in wc.db, with the recorded
+ * kinds, sizes and timestamps, and nothing else.  The status walker does
+ * not need to read clean directories from disk.
+ *
+ * The monitor learns about clean directories from the status walks
+ * themselves, which report what they found via svn_wc__fsmonitor_sync().
+ * Any change to wc.db, an event queue overflow or any other trouble on the
+ * monitor's side makes it forget everything, and the next walk will read
+ * all directories again.
+ */
+typedef struct svn_wc__fsmonitor_t svn_wc__fsmonitor_t;
+
+/* Ask the monitor of the working copy at WCROOT_ABSPATH for the directories
+ * that may have changed and return a new session in *FSMONITOR, allocated
+ * in RESULT_POOL.  Set *FSMONITOR to NULL, if there is no monitor running
+ * or it can't be reached.  Use SCRATCH_POOL for temporary allocations.
+ */
+svn_error_t *
+svn_wc__fsmonitor_query(svn_wc__fsmonitor_t **fsmonitor,
+                        const char *wcroot_abspath,
+                        apr_pool_t *result_pool,
+                        apr_pool_t *scratch_pool);
+
+/* Return TRUE if the directory LOCAL_ABSPATH is known to be clean
+ * according to FSMONITOR.  FSMONITOR may be NULL.
+ */
+svn_boolean_t
+svn_wc__fsmonitor_is_clean(const svn_wc__fsmonitor_t *fsmonitor,
+                           const char *local_abspath);
+
+/* Record in FSMONITOR that the status walker has read the directory
+ * LOCAL_ABSPATH from disk and found it to be CLEAN or not.
+ */
+void
+svn_wc__fsmonitor_record(svn_wc__fsmonitor_t *fsmonitor,
+                         const char *local_abspath,
+                         svn_boolean_t clean);
+
+/* Send the records of FSMONITOR to the monitor process.  Set FULL, if the
+ * status walk covered all directories of the working copy.  Failing to
+ * reach the monitor is not an error.  Use SCRATCH_POOL for temporary
+ * allocations.
+ */
+svn_error_t *
+svn_wc__fsmonitor_sync(svn_wc__fsmonitor_t *fsmonitor,
+                       svn_boolean_t full,
+                       apr_pool_t *scratch_pool);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* SVN_LIBSVN_WC_FSMONITOR_H */
@@ -78,143 +78,42 @@
 */
 
 
-/* Set *MODIFIED_P to TRUE if (after translation) VERSIONED_FILE_ABSPATH
- * (of VERSIONED_FILE_SIZE bytes) differs from PRISTINE_STREAM (of
- * PRISTINE_SIZE bytes), else to FALSE if not.
- *
- * If EXACT_COMPARISON is FALSE, translate VERSIONED_FILE_ABSPATH's EOL
- * style and keywords to repository-normal form according to its properties,
- * and compare the result with PRISTINE_STREAM.  If EXACT_COMPARISON is
- * TRUE, translate PRISTINE_STREAM's EOL style and keywords to working-copy
- * form according to VERSIONED_FILE_ABSPATH's properties, and compare the
- * result with VERSIONED_FILE_ABSPATH.
- *
- * HAS_PROPS should be TRUE if the file had properties when it was not
- * modified, otherwise FALSE.
- *
- * PROPS_MOD should be TRUE if the file's properties have been changed,
- * otherwise FALSE.
- *
- * PRISTINE_STREAM will be closed before a successful return.
- *
- * DB is a wc_db; use SCRATCH_POOL for temporary allocation.
- */
-static svn_error_t *
-compare_and_verify(svn_boolean_t *modified_p,
-                   svn_wc__db_t *db,
-                   const char *versioned_file_abspath,
-                   svn_filesize_t versioned_file_size,
-                   svn_stream_t *pristine_stream,
-                   svn_filesize_t pristine_size,
-                   svn_boolean_t has_props,
-                   svn_boolean_t props_mod,
-                   svn_boolean_t exact_comparison,
-                   apr_pool_t *scratch_pool)
+/* A text modification check prepared by svn_wc__text_check_prepare(). */
+struct svn_wc__text_check_t
 {
-  svn_boolean_t same;
+  /* The working file and its size on disk. */
+  const char *local_abspath;
+  svn_filesize_t local_size;
+  apr_time_t local_mtime;
+
+  /* The open pristine and its size.  PRISTINE_STREAM is NULL if the
+     working file is to be compared with the SHA-1 checksum of the pristine,
+     PRISTINE_CHECKSUM, instead. */
+  svn_stream_t *pristine_stream;
+  svn_filesize_t pristine_size;
+  const svn_checksum_t *pristine_checksum;
+
+  /* See svn_wc__internal_file_modified_p(). */
+  svn_boolean_t exact_comparison;
+
+  /* How to translate between the working file and the pristine. */
+  svn_boolean_t need_translation;
   svn_subst_eol_style_t eol_style;
   const char *eol_str;
   apr_hash_t *keywords;
-  svn_boolean_t special = FALSE;
-  svn_boolean_t need_translation;
-  svn_stream_t *v_stream; /* versioned_file */
-
-  SVN_ERR_ASSERT(svn_dirent_is_absolute(versioned_file_abspath));
-
-  if (props_mod)
-    has_props = TRUE; /* Maybe it didn't have properties; but it has now */
-
-  if (has_props)
-    {
-      SVN_ERR(svn_wc__get_translate_info(&eol_style, &eol_str,
-                                         &keywords,
-                                         &special,
-                                         db, versioned_file_abspath, NULL,
-                                         !exact_comparison,
-                                         scratch_pool, scratch_pool));
-
-      need_translation = svn_subst_translation_required(eol_style, eol_str,
-                                                        keywords, special,
-                                                        TRUE);
-    }
-  else
-    need_translation = FALSE;
-
-  if (! need_translation
-      && (versioned_file_size != pristine_size))
-    {
-      *modified_p = TRUE;
-
-      /* ### Why did we open the pristine? */
-      return svn_error_trace(svn_stream_close(pristine_stream));
-    }
-
-  /* ### Other checks possible? */
-
-  /* Reading files is necessary. */
-  if (special && need_translation)
-    {
-      SVN_ERR(svn_subst_read_specialfile(&v_stream, versioned_file_abspath,
-                                          scratch_pool, scratch_pool));
-    }
-  else
-    {
-      /* We don't use APR-level buffering because the comparison function
-       * will do its own buffering. */
-      apr_file_t *file;
-      SVN_ERR(svn_io_file_open(&file, versioned_file_abspath, APR_READ,
-                               APR_OS_DEFAULT, scratch_pool));
-      v_stream = svn_stream_from_aprfile2(file, FALSE, scratch_pool);
-
-      if (need_translation)
-        {
-          if (!exact_comparison)
-            {
-              if (eol_style == svn_subst_eol_style_native)
-                eol_str = SVN_SUBST_NATIVE_EOL_STR;
-              else if (eol_style != svn_subst_eol_style_fixed
-                       && eol_style != svn_subst_eol_style_none)
-                return svn_error_create(SVN_ERR_IO_UNKNOWN_EOL,
-                                        svn_stream_close(v_stream), NULL);
-
-              /* Wrap file stream to detranslate into normal form,
-               * "repairing" the EOL style if it is inconsistent. */
-              v_stream = svn_subst_stream_translated(v_stream,
-                                                     eol_str,
-                                                     TRUE /* repair */,
-                                                     keywords,
-                                                     FALSE /* expand */,
-                                                     scratch_pool);
-            }
-          else
-            {
-              /* Wrap base stream to translate into working copy form, and
-               * arrange to throw an error if its EOL style is inconsistent. */
-              pristine_stream = svn_subst_stream_translated(pristine_stream,
-                                                            eol_str, FALSE,
-                                                            keywords, TRUE,
-                                                            scratch_pool);
-            }
-        }
-    }
-
-  SVN_ERR(svn_stream_contents_same2(&same, pristine_stream, v_stream,
-                                    scratch_pool));
-
-  *modified_p = (! same);
-
-  return SVN_NO_ERROR;
-}
+  svn_boolean_t special;
+};
 
 svn_error_t *
-svn_wc__internal_file_modified_p(svn_boolean_t *modified_p,
-                                 svn_wc__db_t *db,
-                                 const char *local_abspath,
-                                 svn_boolean_t exact_comparison,
-                                 apr_pool_t *scratch_pool)
+svn_wc__text_check_prepare(svn_wc__text_check_t **check,
+                           svn_boolean_t *modified_p,
+                           svn_wc__db_t *db,
+                           const char *local_abspath,
+                           svn_boolean_t exact_comparison,
+                           apr_pool_t *result_pool,
+                           apr_pool_t *scratch_pool)
 {
-  svn_stream_t *pristine_stream;
-  svn_filesize_t pristine_size;
+  svn_wc__text_check_t *result;
   svn_wc__db_status_t status;
   svn_node_kind_t kind;
   const svn_checksum_t *checksum;
@@ -224,6 +123,8 @@ svn_wc__internal_file_modified_p(svn_boolean_t *modified_p,
   svn_boolean_t props_mod;
   const svn_io_dirent2_t *dirent;
 
+  *check = NULL;
+
   /* Read the relevant info */
   SVN_ERR(svn_wc__db_read_info(&status, &kind, NULL, NULL, NULL, NULL, NULL,
                                NULL, NULL, NULL, &checksum, NULL, NULL, NULL,
@@ -302,45 +203,242 @@ svn_wc__internal_file_modified_p(svn_boolean_t *modified_p,
     }
 
  compare_them:
-  SVN_ERR(svn_wc__db_pristine_read(&pristine_stream, &pristine_size,
-                                   db, local_abspath, checksum,
-                                   scratch_pool, scratch_pool));
+  result = apr_pcalloc(result_pool, sizeof(*result));
+  result->local_abspath = apr_pstrdup(result_pool, local_abspath);
+  result->local_size = dirent->filesize;
+  result->local_mtime = dirent->mtime;
+  result->exact_comparison = exact_comparison;
+
+  /* NODES records the SHA-1 checksum of the pristine, which is also that
+     of the working file in repository-normal form, if it is unmodified.
+     So a heuristic check doesn't need to read the pristine.  In particular,
+     a file that just got a new timestamp is verified by reading it once. */
+  if (exact_comparison)
+    SVN_ERR(svn_wc__db_pristine_read(&result->pristine_stream,
+                                     &result->pristine_size,
+                                     db, local_abspath, checksum,
+                                     result_pool, scratch_pool));
+  else
+    {
+      SVN_ERR(svn_wc__db_pristine_read(NULL, &result->pristine_size,
+                                       db, local_abspath, checksum,
+                                       result_pool, scratch_pool));
+      result->pristine_checksum = svn_checksum_dup(checksum, result_pool);
+    }
 
-  /* Check all bytes, and verify checksum if requested. */
-  {
-    svn_error_t *err;
-    err = compare_and_verify(modified_p, db,
-                             local_abspath, dirent->filesize,
-                             pristine_stream, pristine_size,
-                             has_props, props_mod,
-                             exact_comparison,
-                             scratch_pool);
-
-    /* At this point we already opened the pristine file, so we know that
-       the access denied applies to the working copy path */
-    if (err && APR_STATUS_IS_EACCES(err->apr_err))
-      return svn_error_create(SVN_ERR_WC_PATH_ACCESS_DENIED, err, NULL);
-    else
-      SVN_ERR(err);
-  }
-
-  if (!*modified_p)
+  if (props_mod)
+    has_props = TRUE; /* Maybe it didn't have properties; but it has now */
+
+  if (has_props)
     {
-      svn_boolean_t own_lock;
+      SVN_ERR(svn_wc__get_translate_info(&result->eol_style,
+                                         &result->eol_str,
+                                         &result->keywords,
+                                         &result->special,
+                                         db, local_abspath, NULL,
+                                         !exact_comparison,
+                                         result_pool, scratch_pool));
 
-      /* The timestamp is missing or "broken" so "repair" it if we can. */
-      SVN_ERR(svn_wc__db_wclock_owns_lock(&own_lock, db, local_abspath, FALSE,
-                                          scratch_pool));
-      if (own_lock)
-        SVN_ERR(svn_wc__db_global_record_fileinfo(db, local_abspath,
-                                                  dirent->filesize,
-                                                  dirent->mtime,
-                                                  scratch_pool));
+      result->need_translation
+        = svn_subst_translation_required(result->eol_style, result->eol_str,
+                                         result->keywords, result->special,
+                                         TRUE);
+    }
+
+  *check = result;
+  return SVN_NO_ERROR;
+}
+
+/* Set *MODIFIED_P to TRUE if (after translation) the working file of
+ * CHECK differs from its pristine, else to FALSE if not.
+ *
+ * If CHECK->EXACT_COMPARISON is FALSE, translate the working file's EOL
+ * style and keywords to repository-normal form according to its properties,
+ * and compare the checksum of the result with that of the pristine.  If it
+ * is TRUE, translate the pristine's EOL style and keywords to working-copy
+ * form and compare the result with the working file.
+ *
+ * The pristine stream, if any, will be closed before a successful return.
+ *
+ * Use SCRATCH_POOL for temporary allocation.
+ */
+static svn_error_t *
+compare_and_verify(svn_boolean_t *modified_p,
+                   svn_wc__text_check_t *check,
+                   apr_pool_t *scratch_pool)
+{
+  svn_boolean_t same;
+  svn_stream_t *v_stream; /* versioned_file */
+  svn_stream_t *pristine_stream = check->pristine_stream;
+  const char *eol_str = check->eol_str;
+
+  SVN_ERR_ASSERT(svn_dirent_is_absolute(check->local_abspath));
+
+  if (! check->need_translation
+      && (check->local_size != check->pristine_size))
+    {
+      *modified_p = TRUE;
+
+      /* ### Why did we open the pristine? */
+      if (pristine_stream)
+        SVN_ERR(svn_stream_close(pristine_stream));
+      return SVN_NO_ERROR;
+    }
+
+  /* ### Other checks possible? */
+
+  /* Reading files is necessary. */
+  if (check->special && check->need_translation)
+    {
+      SVN_ERR(svn_subst_read_specialfile(&v_stream, check->local_abspath,
+                                          scratch_pool, scratch_pool));
     }
+  else
+    {
+      /* We don't use APR-level buffering because the comparison function
+       * will do its own buffering. */
+      apr_file_t *file;
+      SVN_ERR(svn_io_file_open(&file, check->local_abspath, APR_READ,
+                               APR_OS_DEFAULT, scratch_pool));
+      v_stream = svn_stream_from_aprfile2(file, FALSE, scratch_pool);
+
+      if (check->need_translation)
+        {
+          if (!check->exact_comparison)
+            {
+              if (check->eol_style == svn_subst_eol_style_native)
+                eol_str = SVN_SUBST_NATIVE_EOL_STR;
+              else if (check->eol_style != svn_subst_eol_style_fixed
+                       && check->eol_style != svn_subst_eol_style_none)
+                return svn_error_create(SVN_ERR_IO_UNKNOWN_EOL,
+                                        svn_stream_close(v_stream), NULL);
+
+              /* Wrap file stream to detranslate into normal form,
+               * "repairing" the EOL style if it is inconsistent. */
+              v_stream = svn_subst_stream_translated(v_stream,
+                                                     eol_str,
+                                                     TRUE /* repair */,
+                                                     check->keywords,
+                                                     FALSE /* expand */,
+                                                     scratch_pool);
+            }
+          else
+            {
+              /* Wrap base stream to translate into working copy form, and
+               * arrange to throw an error if its EOL style is inconsistent. */
+              pristine_stream = svn_subst_stream_translated(pristine_stream,
+                                                            eol_str, FALSE,
+                                                            check->keywords,
+                                                            TRUE,
+                                                            scratch_pool);
+            }
+        }
+    }
+
+  if (! pristine_stream)
+    {
+      svn_checksum_t *checksum;
+
+      SVN_ERR(svn_stream_contents_checksum(&checksum, v_stream,
+                                           check->pristine_checksum->kind,
+                                           scratch_pool, scratch_pool));
+      same = svn_checksum_match(checksum, check->pristine_checksum);
+    }
+  else
+    SVN_ERR(svn_stream_contents_same2(&same, pristine_stream, v_stream,
+                                      scratch_pool));
+
+  *modified_p = (! same);
 
   return SVN_NO_ERROR;
 }
 
+svn_error_t *
+svn_wc__text_check_run(svn_boolean_t *modified_p,
+                       svn_wc__text_check_t *check,
+                       apr_pool_t *scratch_pool)
+{
+  /* Check all bytes, and verify checksum if requested. */
+  svn_error_t *err = compare_and_verify(modified_p, check, scratch_pool);
+
+  /* At this point we already opened the pristine file, so we know that
+     the access denied applies to the working copy path */
+  if (err && APR_STATUS_IS_EACCES(err->apr_err))
+    return svn_error_create(SVN_ERR_WC_PATH_ACCESS_DENIED, err, NULL);
+
+  return svn_error_trace(err);
+}
+
+svn_error_t *
+svn_wc__text_check_finish(svn_wc__db_t *db,
+                          const svn_wc__text_check_t *check,
+                          svn_boolean_t modified,
+                          apr_pool_t *scratch_pool)
+{
+  svn_boolean_t own_lock;
+
+  if (modified)
+    return SVN_NO_ERROR;
+
+  /* The timestamp is missing or "broken" so "repair" it if we can. */
+  SVN_ERR(svn_wc__db_wclock_owns_lock(&own_lock, db, check->local_abspath,
+                                      FALSE, scratch_pool));
+  if (own_lock)
+    SVN_ERR(svn_wc__db_global_record_fileinfo(db, check->local_abspath,
+                                              check->local_size,
+                                              check->local_mtime,
+                                              scratch_pool));
+  else
+    {
+      /* Read-only operations like status don't hold a lock, but without
+         the repair they would read the file again every time.  So lock
+         the directory ourselves if nobody else holds the lock.  Whoever
+         does might be changing the node; then we simply leave the repair
+         to a later run.  This is just an optimization, so don't let it
+         fail the operation, e.g. in a working copy that we can't write. */
+      const char *dir_abspath = svn_dirent_dirname(check->local_abspath,
+                                                   scratch_pool);
+      svn_error_t *err;
+
+      err = svn_wc__db_wclock_obtain(db, dir_abspath, 0, FALSE,
+                                     scratch_pool);
+      if (!err)
+        {
+          err = svn_wc__db_global_record_fileinfo(db, check->local_abspath,
+                                                  check->local_size,
+                                                  check->local_mtime,
+                                                  scratch_pool);
+          err = svn_error_compose_create(
+                  err,
+                  svn_wc__db_wclock_release(db, dir_abspath, scratch_pool));
+        }
+      svn_error_clear(err);
+    }
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_wc__internal_file_modified_p(svn_boolean_t *modified_p,
+                                 svn_wc__db_t *db,
+                                 const char *local_abspath,
+                                 svn_boolean_t exact_comparison,
+                                 apr_pool_t *scratch_pool)
+{
+  svn_wc__text_check_t *check;
+
+  SVN_ERR(svn_wc__text_check_prepare(&check, modified_p, db, local_abspath,
+                                     exact_comparison,
+                                     scratch_pool, scratch_pool));
+  if (!check)
+    return SVN_NO_ERROR;
+
+  SVN_ERR(svn_wc__text_check_run(modified_p, check, scratch_pool));
+
+  return svn_error_trace(svn_wc__text_check_finish(db, check, *modified_p,
+                                                   scratch_pool));
+}
+
 
 svn_error_t *
 svn_wc_text_modified_p2(svn_boolean_t *modified_p,
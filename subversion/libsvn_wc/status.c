@@ -30,6 +30,11 @@
 #include <apr_file_io.h>
 #include <apr_hash.h>
 
+#if APR_HAS_THREADS
+#include <apr_thread_cond.h>
+#include <apr_thread_mutex.h>
+#endif
+
 #include "svn_pools.h"
 #include "svn_types.h"
 #include "svn_delta.h"
@@ -46,11 +51,14 @@
 
 #include "wc.h"
 #include "props.h"
+#include "fsmonitor.h"
 
+#include "private/svn_atomic.h"
 #include "private/svn_sorts_private.h"
 #include "private/svn_wc_private.h"
 #include "private/svn_fspath.h"
 #include "private/svn_editor.h"
+#include "private/svn_thread_pool.h"
 
 
 /* The file internal variant of svn_wc_status3_t, with slightly more
@@ -94,6 +102,9 @@ struct walk_status_baton
   /* Externals info harvested during the status run. */
   apr_hash_t *externals;
 
+  /* The working copy's file system monitor or NULL, if there is none. */
+  svn_wc__fsmonitor_t *fsmonitor;
+
   /*** Repository lock handling ***/
   /* The repository root URL, if set. */
   const char *repos_root;
@@ -333,6 +344,10 @@ internal_status(svn_wc__internal_status_t **status,
    returned to reflect that assumption. If CHECK_WORKING_COPY is FALSE,
    do not adjust the result for missing working copy files.
 
+   If TEXT_MODIFIED is not NULL, it is the result of a text modification
+   check for LOCAL_ABSPATH that has already been made, e.g. by a worker
+   thread.  It will then be used instead of checking again.
+
    The status struct's repos_lock field will be set to REPOS_LOCK.
 */
 static svn_error_t *
@@ -347,6 +362,7 @@ assemble_status(svn_wc__internal_status_t **status,
                 svn_boolean_t get_all,
                 svn_boolean_t ignore_text_mods,
                 svn_boolean_t check_working_copy,
+                const svn_boolean_t *text_modified,
                 const svn_lock_t *repos_lock,
                 apr_pool_t *result_pool,
                 apr_pool_t *scratch_pool)
@@ -468,6 +484,8 @@ assemble_status(svn_wc__internal_status_t **status,
                      && info->recorded_size == dirent->filesize
                      && info->recorded_time == dirent->mtime))
             text_modified_p = FALSE;
+          else if (text_modified)
+            text_modified_p = *text_modified;
           else
             {
               svn_error_t *err;
@@ -797,6 +815,7 @@ send_status_structure(const struct walk_status_baton *wb,
                       const struct svn_wc__db_info_t *info,
                       const svn_io_dirent2_t *dirent,
                       svn_boolean_t get_all,
+                      const svn_boolean_t *text_modified,
                       svn_wc_status_func4_t status_func,
                       void *status_baton,
                       apr_pool_t *scratch_pool)
@@ -831,7 +850,8 @@ send_status_structure(const struct walk_status_baton *wb,
                           parent_repos_uuid,
                           info, dirent, get_all,
                           wb->ignore_text_mods, wb->check_working_copy,
-                          repos_lock, scratch_pool, scratch_pool));
+                          text_modified, repos_lock,
+                          scratch_pool, scratch_pool));
 
   if (statstruct && status_func)
     return svn_error_trace((*status_func)(status_baton, local_abspath,
@@ -1023,6 +1043,594 @@ send_unversioned_item(const struct walk_status_baton *wb,
   return SVN_NO_ERROR;
 }
 
+/* --- PARALLEL STATUS WORK --- */
+
+/* The DB handle may only be used by a single thread and the status
+   callbacks have to be invoked in a well-defined order.  The expensive
+   parts of a status walk, however, are often reading the directories
+   from disk and comparing files against their pristines.  Neither of
+   them needs the DB, so get_dir_status() hands them to worker threads
+   before it gets to the respective nodes:
+
+   * The text modification checks that assemble_status() will need for
+     the children of the directory.  They are prepared and finished on
+     the main thread (see svn_wc__text_check_prepare()), only the actual
+     comparison is done by the workers.
+
+   * Reading the sub-directories that we are going to recurse into,
+     a limited number of them ahead.
+
+   The walk itself still happens on the main thread and in the same order
+   as before; it simply picks up the results.  Any job that failed will be
+   done again synchronously, so errors get reported just as before. */
+
+/* Maximum number of text modification checks of a directory that may
+   be prepared at the same time.  Each of them keeps a pristine open. */
+#define STATUS_MAX_TEXT_CHECKS 64
+
+/* Maximum number of sub-directories of a directory to read ahead. */
+#define STATUS_MAX_DIRENTS_AHEAD 64
+
+typedef struct status_batch_t status_batch_t;
+
+/* A job for a worker thread. */
+typedef struct status_task_t
+{
+  /* The batch that this task belongs to. */
+  status_batch_t *batch;
+
+  /* Root pool private to this task.  Results get allocated in here. */
+  apr_pool_t *pool;
+
+  /* Either the text modification check to run ... */
+  svn_wc__text_check_t *check;
+
+  /* ... or the directory to read. */
+  const char *dir_abspath;
+  svn_boolean_t only_check_type;
+
+  /* Whether the task has been handed to status_task_push(). */
+  svn_boolean_t pushed;
+
+  /* Set under the BATCH's mutex once the task has been completed.
+     Only then may the following results be used. */
+  svn_boolean_t done;
+
+  svn_error_t *err;
+  svn_boolean_t modified;
+  apr_hash_t *dirents;
+} status_task_t;
+
+/* All tasks scheduled by a single get_dir_status() call. */
+struct status_batch_t
+{
+#if APR_HAS_THREADS
+  apr_thread_mutex_t *mutex;
+  apr_thread_cond_t *cond;
+
+  /* The threads executing the tasks. */
+  apr_thread_pool_t *threads;
+#endif
+
+  /* Number of tasks handed to the thread pool but not completed yet. */
+  int pending;
+
+  /* Set when the batch is being destroyed.  Tasks shall stop ASAP. */
+  volatile svn_atomic_t cancelled;
+
+  /* All status_task_t * created for this batch. */
+  apr_array_header_t *tasks;
+
+  /* Pool to allocate the tasks from.  Outlives all of them. */
+  apr_pool_t *pool;
+};
+
+#if APR_HAS_THREADS
+
+/* Maximum number of threads in STATUS_THREADS, i.e. number of files
+   and directories that we read concurrently throughout the process. */
+#define STATUS_MAX_THREADS 16
+
+/* Thread pool to execute the tasks of all status walks. */
+static svn_thread_pool__shared_t status_threads
+  = SVN_THREAD_POOL__SHARED_INIT(STATUS_MAX_THREADS,
+                                 N_("Can't create status thread pool"));
+
+/* Thread-pool function executing the status_task_t given as DATA. */
+static void * APR_THREAD_FUNC
+status_task_func(apr_thread_t *tid,
+                 void *data)
+{
+  status_task_t *task = data;
+  status_batch_t *batch = task->batch;
+
+  if (svn_atomic_read(&batch->cancelled))
+    task->err = svn_error_create(SVN_ERR_CANCELLED, NULL, NULL);
+  else if (task->check)
+    task->err = svn_wc__text_check_run(&task->modified, task->check,
+                                       task->pool);
+  else
+    task->err = svn_io_get_dirents3(&task->dirents, task->dir_abspath,
+                                    task->only_check_type,
+                                    task->pool, task->pool);
+
+  apr_thread_mutex_lock(batch->mutex);
+  task->done = TRUE;
+  batch->pending--;
+  apr_thread_cond_broadcast(batch->cond);
+  apr_thread_mutex_unlock(batch->mutex);
+
+  return NULL;
+}
+
+/* Pool cleanup function making sure that no task of the status_batch_t
+   given as DATA is running anymore and releasing all of them. */
+static apr_status_t
+status_batch_cleanup(void *data)
+{
+  status_batch_t *batch = data;
+  int i;
+
+  svn_atomic_set(&batch->cancelled, TRUE);
+
+  apr_thread_mutex_lock(batch->mutex);
+  while (batch->pending)
+    apr_thread_cond_wait(batch->cond, batch->mutex);
+  apr_thread_mutex_unlock(batch->mutex);
+
+  for (i = 0; i < batch->tasks->nelts; i++)
+    {
+      status_task_t *task = APR_ARRAY_IDX(batch->tasks, i, status_task_t *);
+
+      svn_error_clear(task->err);
+      task->err = NULL;
+      if (task->pool)
+        {
+          svn_pool_destroy(task->pool);
+          task->pool = NULL;
+        }
+    }
+
+  return APR_SUCCESS;
+}
+
+#endif
+
+/* Set *BATCH to a new batch of status tasks allocated in RESULT_POOL, if
+   this platform allows for it.  Otherwise, set it to NULL.  All tasks
+   will be waited for and released when RESULT_POOL gets cleaned up. */
+static void
+status_batch_create(status_batch_t **batch,
+                    apr_pool_t *result_pool)
+{
+#if APR_HAS_THREADS
+  status_batch_t *result;
+  apr_thread_pool_t *threads;
+  svn_error_t *err;
+
+  *batch = NULL;
+
+  /* No parallel work if we can't get the worker threads. */
+  err = svn_thread_pool__get_shared(&threads, &status_threads, NULL,
+                                    result_pool);
+  if (err)
+    {
+      svn_error_clear(err);
+      return;
+    }
+
+  result = apr_pcalloc(result_pool, sizeof(*result));
+  result->threads = threads;
+  if (apr_thread_mutex_create(&result->mutex, APR_THREAD_MUTEX_DEFAULT,
+                              result_pool)
+      || apr_thread_cond_create(&result->cond, result_pool))
+    return;
+
+  result->tasks = apr_array_make(result_pool, 16, sizeof(status_task_t *));
+  result->pool = result_pool;
+
+  /* Register this last, so it runs before the mutex gets destroyed. */
+  apr_pool_cleanup_register(result_pool, result, status_batch_cleanup,
+                            apr_pool_cleanup_null);
+
+  *batch = result;
+#else
+  *batch = NULL;
+#endif
+}
+
+/* Return a new task for BATCH, with a pool of its own. */
+static status_task_t *
+status_task_create(status_batch_t *batch)
+{
+  status_task_t *task = apr_pcalloc(batch->pool, sizeof(*task));
+
+  task->batch = batch;
+  task->pool = svn_pool_create(NULL);
+  APR_ARRAY_PUSH(batch->tasks, status_task_t *) = task;
+
+  return task;
+}
+
+/* Hand TASK over to a worker thread.  If that is not possible, mark it
+   as completed but failed.  Tasks with a HIGH_PRIORITY will be executed
+   before all others. */
+static void
+status_task_push(status_task_t *task,
+                 svn_boolean_t high_priority)
+{
+#if APR_HAS_THREADS
+  status_batch_t *batch = task->batch;
+  apr_status_t status;
+
+  task->pushed = TRUE;
+
+  apr_thread_mutex_lock(batch->mutex);
+  batch->pending++;
+  apr_thread_mutex_unlock(batch->mutex);
+
+  status = apr_thread_pool_push(batch->threads, status_task_func, task,
+                                high_priority
+                                  ? APR_THREAD_TASK_PRIORITY_HIGH
+                                  : APR_THREAD_TASK_PRIORITY_NORMAL,
+                                batch);
+  if (status)
+    {
+      apr_thread_mutex_lock(batch->mutex);
+      batch->pending--;
+      task->err = svn_error_wrap_apr(status, NULL);
+      task->done = TRUE;
+      apr_thread_mutex_unlock(batch->mutex);
+    }
+#else
+  task->pushed = TRUE;
+  task->err = svn_error_create(SVN_ERR_UNSUPPORTED_FEATURE, NULL, NULL);
+  task->done = TRUE;
+#endif
+}
+
+/* Wait until the pushed TASK has been completed. */
+static void
+status_task_wait(status_task_t *task)
+{
+#if APR_HAS_THREADS
+  status_batch_t *batch = task->batch;
+
+  if (!task->pushed)
+    return;
+
+  apr_thread_mutex_lock(batch->mutex);
+  while (!task->done)
+    apr_thread_cond_wait(batch->cond, batch->mutex);
+  apr_thread_mutex_unlock(batch->mutex);
+#endif
+}
+
+/* Wait for TASK to be completed, if it has been pushed, and release all
+   resources held by it.  Its results must not be used afterwards. */
+static void
+status_task_release(status_task_t *task)
+{
+  status_task_wait(task);
+
+  svn_error_clear(task->err);
+  task->err = NULL;
+  svn_pool_destroy(task->pool);
+  task->pool = NULL;
+}
+
+/* Return TRUE if assemble_status() is going to compare the contents of
+   the versioned file described by INFO and DIRENT with its pristine,
+   given the settings in WB.  The checks here mirror those in
+   assemble_status(). */
+static svn_boolean_t
+needs_text_check(const struct walk_status_baton *wb,
+                 const struct svn_wc__db_info_t *info,
+                 const svn_io_dirent2_t *dirent)
+{
+  if (!info || !dirent || wb->ignore_text_mods || !wb->check_working_copy)
+    return FALSE;
+
+  if (info->kind != svn_node_file && info->kind != svn_node_symlink)
+    return FALSE;
+
+  if ((info->status != svn_wc__db_status_normal
+       && info->status != svn_wc__db_status_added)
+      || info->incomplete)
+    return FALSE;
+
+  if (dirent->kind != svn_node_file)
+    return FALSE;
+
+#ifdef HAVE_SYMLINK
+  if (info->special != dirent->special)
+    return FALSE;
+#endif
+
+  if (!info->has_checksum)
+    return FALSE;
+
+  return (info->recorded_size == SVN_INVALID_FILESIZE
+          || info->recorded_time == 0
+          || info->recorded_size != dirent->filesize
+          || info->recorded_time != dirent->mtime);
+}
+
+/* Return TRUE if one_child_status() with DEPTH is going to recurse into
+   the node LOCAL_ABSPATH described by INFO and read it as a directory
+   from disk, given the settings in WB. */
+static svn_boolean_t
+needs_dirents(const struct walk_status_baton *wb,
+              const char *local_abspath,
+              const struct svn_wc__db_info_t *info,
+              svn_depth_t depth)
+{
+  return (wb->check_working_copy
+          && !svn_wc__fsmonitor_is_clean(wb->fsmonitor, local_abspath)
+          && depth == svn_depth_infinity
+          && info
+          && info->has_descendants
+          && info->status != svn_wc__db_status_not_present
+          && info->status != svn_wc__db_status_excluded
+          && info->status != svn_wc__db_status_server_excluded
+          && !(info->kind == svn_node_unknown
+               && info->status == svn_wc__db_status_normal));
+}
+
+/* Check the text of all children of LOCAL_ABSPATH in SORTED_CHILDREN for
+   modifications, where assemble_status() would need to do so, using the
+   worker threads of BATCH.  NODES and DIRENTS are the children's DB and
+   on-disk information, respectively.  Return the results in *TEXT_MODS,
+   mapping the child names to svn_boolean_t *, allocated in RESULT_POOL.
+   Children whose check failed will not be in *TEXT_MODS.
+
+   Use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+check_text_mods(apr_hash_t **text_mods,
+                status_batch_t *batch,
+                const struct walk_status_baton *wb,
+                const char *local_abspath,
+                const apr_array_header_t *sorted_children,
+                apr_hash_t *nodes,
+                apr_hash_t *dirents,
+                svn_cancel_func_t cancel_func,
+                void *cancel_baton,
+                apr_pool_t *result_pool,
+                apr_pool_t *scratch_pool)
+{
+  apr_array_header_t *names;
+  status_task_t **tasks;
+  apr_pool_t *iterpool;
+  int prepared, finished;
+  int i;
+
+  *text_mods = NULL;
+
+  names = apr_array_make(scratch_pool, 16, sizeof(const char *));
+  for (i = 0; i < sorted_children->nelts; i++)
+    {
+      const svn_sort__item_t *item = &APR_ARRAY_IDX(sorted_children, i,
+                                                    svn_sort__item_t);
+
+      if (needs_text_check(wb,
+                           apr_hash_get(nodes, item->key, item->klen),
+                           apr_hash_get(dirents, item->key, item->klen)))
+        APR_ARRAY_PUSH(names, const char *) = item->key;
+    }
+
+  /* Nothing to gain from a single check. */
+  if (names->nelts < 2)
+    return SVN_NO_ERROR;
+
+  *text_mods = apr_hash_make(result_pool);
+  tasks = apr_pcalloc(scratch_pool, names->nelts * sizeof(*tasks));
+  iterpool = svn_pool_create(scratch_pool);
+
+  /* Keep up to STATUS_MAX_TEXT_CHECKS checks in flight while picking up
+     the results in order. */
+  for (prepared = 0, finished = 0; finished < names->nelts; finished++)
+    {
+      status_task_t *task;
+      svn_boolean_t modified = FALSE;
+      svn_error_t *err;
+
+      for (; prepared < names->nelts
+             && prepared - finished < STATUS_MAX_TEXT_CHECKS; prepared++)
+        {
+          const char *name = APR_ARRAY_IDX(names, prepared, const char *);
+
+          svn_pool_clear(iterpool);
+          task = status_task_create(batch);
+          err = svn_wc__text_check_prepare(&task->check, &modified, wb->db,
+                                           svn_dirent_join(local_abspath,
+                                                           name, iterpool),
+                                           FALSE, task->pool, iterpool);
+          if (!err && task->check)
+            {
+              status_task_push(task, TRUE);
+              tasks[prepared] = task;
+              continue;
+            }
+
+          /* Either we already know the result or we leave reporting the
+             error to assemble_status(). */
+          if (!err)
+            svn_hash_sets(*text_mods, name,
+                          apr_pmemdup(result_pool, &modified,
+                                      sizeof(modified)));
+
+          svn_error_clear(err);
+          status_task_release(task);
+        }
+
+      task = tasks[finished];
+      if (!task)
+        continue;
+
+      if (cancel_func)
+        SVN_ERR(cancel_func(cancel_baton));
+
+      svn_pool_clear(iterpool);
+      status_task_wait(task);
+
+      /* On failure, assemble_status() will try again and report it. */
+      err = task->err;
+      if (!err)
+        err = svn_wc__text_check_finish(wb->db, task->check, task->modified,
+                                        iterpool);
+      if (!err)
+        svn_hash_sets(*text_mods,
+                      APR_ARRAY_IDX(names, finished, const char *),
+                      apr_pmemdup(result_pool, &task->modified,
+                                  sizeof(task->modified)));
+      else if (err != task->err)
+        svn_error_clear(err);
+
+      status_task_release(task);
+      tasks[finished] = NULL;
+    }
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+/* --- FILE SYSTEM MONITOR SUPPORT --- */
+
+/* Return TRUE if the node described by INFO should exist on disk, FALSE
+   if it should not, and set *UNKNOWN if we can't tell. */
+static svn_boolean_t
+expected_on_disk(svn_boolean_t *unknown,
+                 const struct svn_wc__db_info_t *info)
+{
+  *unknown = FALSE;
+
+  switch (info->status)
+    {
+      case svn_wc__db_status_normal:
+      case svn_wc__db_status_added:
+        if (!info->incomplete
+            && (info->kind == svn_node_file
+                || info->kind == svn_node_dir
+                || info->kind == svn_node_symlink))
+          return TRUE;
+        break;
+
+      case svn_wc__db_status_deleted:
+      case svn_wc__db_status_not_present:
+      case svn_wc__db_status_excluded:
+      case svn_wc__db_status_server_excluded:
+        return FALSE;
+
+      default:
+        break;
+    }
+
+  *unknown = TRUE;
+  return FALSE;
+}
+
+/* Return TRUE if the on-disk DIRENTS of a directory are exactly what its
+   versioned children NODES say they should be, i.e. if dirents_from_nodes()
+   would return the same.  The administrative directory does not count. */
+static svn_boolean_t
+dirents_match_nodes(apr_hash_t *nodes,
+                    apr_hash_t *dirents,
+                    apr_pool_t *scratch_pool)
+{
+  apr_hash_index_t *hi;
+  svn_boolean_t unknown;
+
+  for (hi = apr_hash_first(scratch_pool, nodes); hi; hi = apr_hash_next(hi))
+    {
+      const struct svn_wc__db_info_t *info = apr_hash_this_val(hi);
+      const svn_io_dirent2_t *dirent;
+      svn_boolean_t expected = expected_on_disk(&unknown, info);
+
+      if (unknown)
+        return FALSE;
+
+      dirent = svn_hash_gets(dirents, apr_hash_this_key(hi));
+      if (!expected || !dirent)
+        {
+          if (expected || dirent)
+            return FALSE;
+
+          continue;
+        }
+
+      if (info->kind == svn_node_dir)
+        {
+          if (dirent->kind != svn_node_dir || dirent->special)
+            return FALSE;
+        }
+      else if (dirent->kind != svn_node_file
+#ifdef HAVE_SYMLINK
+               || dirent->special != info->special
+#else
+               || dirent->special
+#endif
+               || !info->has_checksum
+               || info->recorded_size == SVN_INVALID_FILESIZE
+               || info->recorded_time == 0
+               || info->recorded_size != dirent->filesize
+               || info->recorded_time != dirent->mtime)
+        return FALSE;
+    }
+
+  /* Anything unversioned? */
+  for (hi = apr_hash_first(scratch_pool, dirents); hi; hi = apr_hash_next(hi))
+    {
+      const char *name = apr_hash_this_key(hi);
+
+      if (!svn_hash_gets(nodes, name)
+          && !svn_wc_is_adm_dir(name, scratch_pool))
+        return FALSE;
+    }
+
+  return TRUE;
+}
+
+/* Return the on-disk children of a directory that the file system monitor
+   reported as clean, based on its versioned children NODES.  Allocate the
+   result in RESULT_POOL. */
+static apr_hash_t *
+dirents_from_nodes(apr_hash_t *nodes,
+                   apr_pool_t *result_pool)
+{
+  apr_hash_t *dirents = apr_hash_make(result_pool);
+  apr_hash_index_t *hi;
+  svn_boolean_t unknown;
+
+  for (hi = apr_hash_first(result_pool, nodes); hi; hi = apr_hash_next(hi))
+    {
+      const struct svn_wc__db_info_t *info = apr_hash_this_val(hi);
+      svn_io_dirent2_t *dirent;
+
+      if (!expected_on_disk(&unknown, info))
+        continue;
+
+      dirent = svn_io_dirent2_create(result_pool);
+      if (info->kind == svn_node_dir)
+        {
+          dirent->kind = svn_node_dir;
+        }
+      else
+        {
+          dirent->kind = svn_node_file;
+#ifdef HAVE_SYMLINK
+          dirent->special = info->special;
+#endif
+          dirent->filesize = info->recorded_size;
+          dirent->mtime = info->recorded_time;
+        }
+
+      svn_hash_sets(dirents, apr_hash_this_key(hi), dirent);
+    }
+
+  return dirents;
+}
+
 static svn_error_t *
 get_dir_status(const struct walk_status_baton *wb,
                const char *local_abspath,
@@ -1032,6 +1640,7 @@ get_dir_status(const struct walk_status_baton *wb,
                const char *parent_repos_uuid,
                const struct svn_wc__db_info_t *dir_info,
                const svn_io_dirent2_t *dirent,
+               status_task_t *dirents_task,
                const apr_array_header_t *ignore_patterns,
                svn_depth_t depth,
                svn_boolean_t get_all,
@@ -1059,6 +1668,9 @@ get_dir_status(const struct walk_status_baton *wb,
  *
  * DIRENT should reflect LOCAL_ABSPATH's dirent information.
  *
+ * TEXT_MODIFIED and DIRENTS_TASK are passed on to assemble_status() and
+ * get_dir_status(), respectively, and may be NULL.
+ *
  * DIR_REPOS_* should reflect LOCAL_ABSPATH's parent URL, i.e. LOCAL_ABSPATH's
  * URL treated with svn_uri_dirname(). ### TODO verify this (externals)
  *
@@ -1079,6 +1691,8 @@ one_child_status(const struct walk_status_baton *wb,
                  const char *parent_abspath,
                  const struct svn_wc__db_info_t *info,
                  const svn_io_dirent2_t *dirent,
+                 const svn_boolean_t *text_modified,
+                 status_task_t *dirents_task,
                  const char *dir_repos_root_url,
                  const char *dir_repos_relpath,
                  const char *dir_repos_uuid,
@@ -1115,7 +1729,7 @@ one_child_status(const struct walk_status_baton *wb,
                                     dir_repos_root_url,
                                     dir_repos_relpath,
                                     dir_repos_uuid,
-                                    info, dirent, get_all,
+                                    info, dirent, get_all, text_modified,
                                     status_func, status_baton,
                                     scratch_pool));
 
@@ -1126,7 +1740,7 @@ one_child_status(const struct walk_status_baton *wb,
           SVN_ERR(get_dir_status(wb, local_abspath, TRUE,
                                  dir_repos_root_url, dir_repos_relpath,
                                  dir_repos_uuid, info,
-                                 dirent, ignore_patterns,
+                                 dirent, dirents_task, ignore_patterns,
                                  svn_depth_infinity, get_all,
                                  no_ignore,
                                  status_func, status_baton,
@@ -1206,6 +1820,9 @@ one_child_status(const struct walk_status_baton *wb,
    DIRENT is LOCAL_ABSPATH's own dirent and is only needed if it is reported,
    so if SKIP_THIS_DIR is TRUE, DIRENT can be left NULL.
 
+   DIRENTS_TASK may be a task that has been reading LOCAL_ABSPATH's on-disk
+   children in the background, or NULL.
+
    Other arguments are the same as those passed to
    svn_wc_get_status_editor5().  */
 static svn_error_t *
@@ -1217,6 +1834,7 @@ get_dir_status(const struct walk_status_baton *wb,
                const char *parent_repos_uuid,
                const struct svn_wc__db_info_t *dir_info,
                const svn_io_dirent2_t *dirent,
+               status_task_t *dirents_task,
                const apr_array_header_t *ignore_patterns,
                svn_depth_t depth,
                svn_boolean_t get_all,
@@ -1230,10 +1848,17 @@ get_dir_status(const struct walk_status_baton *wb,
   const char *dir_repos_root_url;
   const char *dir_repos_relpath;
   const char *dir_repos_uuid;
-  apr_hash_t *dirents, *nodes, *conflicts, *all_children;
+  apr_hash_t *dirents = NULL, *nodes, *conflicts, *all_children;
+  apr_hash_t *text_mods = NULL;
   apr_array_header_t *sorted_children;
   apr_array_header_t *collected_ignore_patterns = NULL;
   apr_pool_t *iterpool;
+  apr_pool_t *batch_pool;
+  status_batch_t *batch = NULL;
+  status_task_t **dirents_tasks = NULL;
+  int dirents_ahead = 0;
+  int next_dirents = 0;
+  svn_boolean_t monitored_clean;
   svn_error_t *err;
   int i;
 
@@ -1245,7 +1870,23 @@ get_dir_status(const struct walk_status_baton *wb,
 
   iterpool = svn_pool_create(scratch_pool);
 
-  if (wb->check_working_copy)
+  /* If nothing changed here, we can tell what's on disk from the DB
+     once we have read the children's info below. */
+  monitored_clean = (wb->check_working_copy
+                     && svn_wc__fsmonitor_is_clean(wb->fsmonitor,
+                                                   local_abspath));
+
+  if (wb->check_working_copy && dirents_task)
+    {
+      /* If reading ahead failed, simply try again below. */
+      status_task_wait(dirents_task);
+      if (!dirents_task->err)
+        dirents = apr_hash_copy(scratch_pool, dirents_task->dirents);
+    }
+
+  if (!wb->check_working_copy)
+    dirents = apr_hash_make(scratch_pool);
+  else if (!dirents && !monitored_clean)
     {
       err = svn_io_get_dirents3(&dirents, local_abspath,
                                 wb->ignore_text_mods /* only_check_type*/,
@@ -1260,8 +1901,6 @@ get_dir_status(const struct walk_status_baton *wb,
       else
         SVN_ERR(err);
     }
-  else
-    dirents = apr_hash_make(scratch_pool);
 
   if (!dir_info)
     SVN_ERR(svn_wc__db_read_single_info(&dir_info, wb->db, local_abspath,
@@ -1283,6 +1922,12 @@ get_dir_status(const struct walk_status_baton *wb,
                                         !wb->check_working_copy,
                                         scratch_pool, iterpool));
 
+  if (monitored_clean)
+    dirents = dirents_from_nodes(nodes, scratch_pool);
+  else if (wb->fsmonitor && wb->check_working_copy && !wb->ignore_text_mods)
+    svn_wc__fsmonitor_record(wb->fsmonitor, local_abspath,
+                             dirents_match_nodes(nodes, dirents, iterpool));
+
   all_children = apr_hash_overlay(scratch_pool, nodes, dirents);
   if (apr_hash_count(conflicts) > 0)
     all_children = apr_hash_overlay(scratch_pool, conflicts, all_children);
@@ -1319,6 +1964,7 @@ get_dir_status(const struct walk_status_baton *wb,
                                         parent_repos_relpath,
                                         parent_repos_uuid,
                                         dir_info, this_dirent, get_all,
+                                        NULL /* text_modified */,
                                         status_func, status_baton,
                                         iterpool));
         }
@@ -1328,6 +1974,7 @@ get_dir_status(const struct walk_status_baton *wb,
                                       parent_repos_relpath,
                                       parent_repos_uuid,
                                       dir_info, dirent, get_all,
+                                      NULL /* text_modified */,
                                       status_func, status_baton,
                                       iterpool));
     }
@@ -1340,6 +1987,27 @@ get_dir_status(const struct walk_status_baton *wb,
   sorted_children = svn_sort__hash(all_children,
                                    svn_sort_compare_items_lexically,
                                    scratch_pool);
+
+  /* Let worker threads do the file system access for the children
+     (see "PARALLEL STATUS WORK" above).  Whatever happens, BATCH_POOL's
+     cleanup waits for all of them to finish. */
+  batch_pool = svn_pool_create(scratch_pool);
+  if (wb->check_working_copy && sorted_children->nelts > 1)
+    status_batch_create(&batch, batch_pool);
+
+  if (batch)
+    {
+      SVN_ERR(check_text_mods(&text_mods, batch, wb, local_abspath,
+                              sorted_children, nodes, dirents,
+                              cancel_func, cancel_baton,
+                              scratch_pool, iterpool));
+
+      if (depth == svn_depth_infinity)
+        dirents_tasks = apr_pcalloc(batch_pool,
+                                    sorted_children->nelts
+                                      * sizeof(*dirents_tasks));
+    }
+
   for (i = 0; i < sorted_children->nelts; i++)
     {
       const void *key;
@@ -1351,6 +2019,30 @@ get_dir_status(const struct walk_status_baton *wb,
 
       svn_pool_clear(iterpool);
 
+      /* Read the next few sub-directories ahead of time. */
+      for (; dirents_tasks
+             && next_dirents < sorted_children->nelts
+             && dirents_ahead < STATUS_MAX_DIRENTS_AHEAD; next_dirents++)
+        {
+          status_task_t *task;
+
+          item = APR_ARRAY_IDX(sorted_children, next_dirents,
+                               svn_sort__item_t);
+          child_abspath = svn_dirent_join(local_abspath, item.key, iterpool);
+          if (!needs_dirents(wb, child_abspath,
+                             apr_hash_get(nodes, item.key, item.klen),
+                             depth))
+            continue;
+
+          task = status_task_create(batch);
+          task->dir_abspath = apr_pstrdup(task->pool, child_abspath);
+          task->only_check_type = wb->ignore_text_mods;
+          status_task_push(task, FALSE);
+
+          dirents_tasks[next_dirents] = task;
+          dirents_ahead++;
+        }
+
       item = APR_ARRAY_IDX(sorted_children, i, svn_sort__item_t);
       key = item.key;
       klen = item.klen;
@@ -1364,6 +2056,10 @@ get_dir_status(const struct walk_status_baton *wb,
                                local_abspath,
                                child_info,
                                child_dirent,
+                               text_mods
+                                 ? apr_hash_get(text_mods, key, klen)
+                                 : NULL,
+                               dirents_tasks ? dirents_tasks[i] : NULL,
                                dir_repos_root_url,
                                dir_repos_relpath,
                                dir_repos_uuid,
@@ -1379,9 +2075,17 @@ get_dir_status(const struct walk_status_baton *wb,
                                cancel_baton,
                                scratch_pool,
                                iterpool));
+
+      if (dirents_tasks && dirents_tasks[i])
+        {
+          status_task_release(dirents_tasks[i]);
+          dirents_tasks[i] = NULL;
+          dirents_ahead--;
+        }
     }
 
   /* Destroy our subpools. */
+  svn_pool_destroy(batch_pool);
   svn_pool_destroy(iterpool);
 
   return SVN_NO_ERROR;
@@ -1448,6 +2152,8 @@ get_child_status(const struct walk_status_baton *wb,
                            parent_abspath,
                            info,
                            dirent,
+                           NULL /* text_modified */,
+                           NULL /* dirents_task */,
                            dir_repos_root_url,
                            dir_repos_relpath,
                            dir_repos_uuid,
@@ -1779,7 +2485,8 @@ make_dir_baton(void **dir_baton,
                              NULL /*parent_repos_relpath*/,
                              status_in_parent->s.repos_uuid,
                              NULL,
-                             NULL /* dirent */, ignores,
+                             NULL /* dirent */,
+                             NULL /* dirents_task */, ignores,
                              d->depth == svn_depth_files
                                       ? svn_depth_files
                                       : svn_depth_immediates,
@@ -1971,6 +2678,7 @@ handle_statii(struct edit_baton *eb,
                                  dir_repos_uuid,
                                  NULL,
                                  NULL /* dirent */,
+                                 NULL /* dirents_task */,
                                  ignores, depth, eb->get_all, eb->no_ignore,
                                  status_func, status_baton,
                                  eb->cancel_func, eb->cancel_baton,
@@ -2238,6 +2946,7 @@ close_directory(void *dir_baton,
                                          eb->target_abspath, TRUE,
                                          NULL, NULL, NULL, NULL,
                                          NULL /* dirent */,
+                                         NULL /* dirents_task */,
                                          eb->ignores,
                                          eb->default_depth,
                                          eb->get_all, eb->no_ignore,
@@ -2513,6 +3222,7 @@ svn_wc__get_status_editor(const svn_delta_editor_t **editor,
   eb->wb.check_working_copy = check_working_copy;
   eb->wb.repos_locks      = NULL;
   eb->wb.repos_root       = NULL;
+  eb->wb.fsmonitor        = NULL;
 
   SVN_ERR(svn_wc__db_externals_defined_below(&eb->wb.externals,
                                              wc_ctx->db, eb->target_abspath,
@@ -2644,6 +3354,7 @@ svn_wc__internal_walk_status(svn_wc__db_t *db,
   wb.check_working_copy = TRUE;
   wb.repos_root = NULL;
   wb.repos_locks = NULL;
+  wb.fsmonitor = NULL;
 
   /* Use the caller-provided ignore patterns if provided; the build-time
      configured defaults otherwise. */
@@ -2690,12 +3401,22 @@ svn_wc__internal_walk_status(svn_wc__db_t *db,
       && info->status != svn_wc__db_status_excluded
       && info->status != svn_wc__db_status_server_excluded)
     {
+      const char *wcroot_abspath;
+
+      /* Let the file system monitor, if any, tell us which directories
+         we don't need to read. */
+      SVN_ERR(svn_wc__db_get_wcroot(&wcroot_abspath, db, local_abspath,
+                                    scratch_pool, scratch_pool));
+      SVN_ERR(svn_wc__fsmonitor_query(&wb.fsmonitor, wcroot_abspath,
+                                      scratch_pool, scratch_pool));
+
       SVN_ERR(get_dir_status(&wb,
                              local_abspath,
                              FALSE /* skip_root */,
                              NULL, NULL, NULL,
                              info,
                              dirent,
+                             NULL /* dirents_task */,
                              ignore_patterns,
                              depth,
                              get_all,
@@ -2703,6 +3424,16 @@ svn_wc__internal_walk_status(svn_wc__db_t *db,
                              status_func, status_baton,
                              cancel_func, cancel_baton,
                              scratch_pool));
+
+      /* ... and tell it in turn what we found. */
+      if (wb.fsmonitor)
+        SVN_ERR(svn_wc__fsmonitor_sync(wb.fsmonitor,
+                                       !ignore_text_mods
+                                       && (depth == svn_depth_infinity
+                                           || depth == svn_depth_unknown)
+                                       && !strcmp(local_abspath,
+                                                  wcroot_abspath),
+                                       scratch_pool));
     }
   else
     {
@@ -2900,6 +3631,7 @@ internal_status(svn_wc__internal_status_t **status,
                                          dirent,
                                          TRUE /* get_all */,
                                          FALSE, check_working_copy,
+                                         NULL /* text_modified */,
                                          NULL /* repos_lock */,
                                          result_pool, scratch_pool));
 }
@@ -261,9 +261,76 @@ struct edit_baton
   /* After closing the root directory a copy of its edited value */
   svn_boolean_t edited;
 
+  /* Whether the DB changes of this edit are being batched, and how many
+     nodes have been added to the current batch (see begin_batch()). */
+  svn_boolean_t batching;
+  int batched_nodes;
+
   apr_pool_t *pool;
 };
 
+/* Maximum number of nodes to change in a single DB transaction. */
+#define MAX_BATCHED_NODES 1000
+
+/* Collect the DB changes made by the edit EB in a single transaction,
+   instead of committing every node on its own.  Every time the work queue
+   runs, the batch gets committed; the edit keeps it small enough
+   otherwise.  See svn_wc__db_batch_begin() for the crash safety. */
+static svn_error_t *
+begin_batch(struct edit_baton *eb,
+            apr_pool_t *scratch_pool)
+{
+  SVN_ERR(svn_wc__db_batch_begin(eb->db, eb->wcroot_abspath, scratch_pool));
+  eb->batching = TRUE;
+  eb->batched_nodes = 0;
+
+  return SVN_NO_ERROR;
+}
+
+/* Note that EB added another node to its batch, and commit the batch if
+   it grew too large. */
+static svn_error_t *
+batch_node_done(struct edit_baton *eb,
+                apr_pool_t *scratch_pool)
+{
+  if (eb->batching && ++eb->batched_nodes >= MAX_BATCHED_NODES)
+    {
+      SVN_ERR(svn_wc__db_batch_flush(eb->db, eb->wcroot_abspath,
+                                     scratch_pool));
+      eb->batched_nodes = 0;
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Commit the batch of EB, if any, and stop batching. */
+static svn_error_t *
+end_batch(struct edit_baton *eb,
+          apr_pool_t *scratch_pool)
+{
+  if (! eb->batching)
+    return SVN_NO_ERROR;
+
+  eb->batching = FALSE;
+  return svn_error_trace(svn_wc__db_batch_end(eb->db, eb->wcroot_abspath,
+                                              scratch_pool));
+}
+
+/* Commit the batch of EB, if any.  This is necessary before invoking the
+   conflict resolver, which may be waiting for the user for quite a while,
+   and before changing the disk outside the work queue. */
+static svn_error_t *
+flush_batch(struct edit_baton *eb,
+            apr_pool_t *scratch_pool)
+{
+  if (! eb->batching)
+    return SVN_NO_ERROR;
+
+  eb->batched_nodes = 0;
+  return svn_error_trace(svn_wc__db_batch_flush(eb->db, eb->wcroot_abspath,
+                                                scratch_pool));
+}
+
 
 /* Record in the edit baton EB that LOCAL_ABSPATH's base version is not being
  * updated.
@@ -477,9 +544,14 @@ cleanup_edit_baton(void *edit_baton)
   svn_error_t *err;
   apr_pool_t *pool = apr_pool_parent_get(eb->pool);
 
-  err = svn_wc__wq_run(eb->db, eb->wcroot_abspath,
-                       NULL /* cancel_func */, NULL /* cancel_baton */,
-                       pool);
+  /* Keep the changes of the nodes that were completed. */
+  err = end_batch(eb, pool);
+
+  err = svn_error_compose_create(
+          err,
+          svn_wc__wq_run(eb->db, eb->wcroot_abspath,
+                         NULL /* cancel_func */, NULL /* cancel_baton */,
+                         pool));
 
   if (err)
     {
@@ -1169,6 +1241,8 @@ open_root(void *edit_baton,
      edit run. */
   eb->root_opened = TRUE;
 
+  SVN_ERR(begin_batch(eb, pool));
+
   SVN_ERR(make_dir_baton(&db, NULL, eb, NULL, FALSE, pool));
   *dir_baton = db;
 
@@ -2187,9 +2261,13 @@ add_directory(const char *path,
                                      scratch_pool));
 
   /* Make sure there is a real directory at LOCAL_ABSPATH, unless we are just
-     updating the DB */
+     updating the DB.  Commit its incomplete node first, so that an
+     interrupted edit never leaves an unversioned directory behind. */
   if (!db->shadowed)
-    SVN_ERR(svn_wc__ensure_directory(db->local_abspath, scratch_pool));
+    {
+      SVN_ERR(flush_batch(eb, scratch_pool));
+      SVN_ERR(svn_wc__ensure_directory(db->local_abspath, scratch_pool));
+    }
 
   if (tree_conflict != NULL)
     {
@@ -3033,15 +3111,18 @@ absent_node(const char *path,
     if (tree_conflict)
       {
         if (eb->conflict_func)
-          SVN_ERR(svn_wc__conflict_invoke_resolver(eb->db, local_abspath,
-                                                   kind,
-                                                   tree_conflict,
-                                                   NULL /* merge_options */,
-                                                   eb->conflict_func,
-                                                   eb->conflict_baton,
-                                                   eb->cancel_func,
-                                                   eb->cancel_baton,
-                                                   scratch_pool));
+          {
+            SVN_ERR(flush_batch(eb, scratch_pool));
+            SVN_ERR(svn_wc__conflict_invoke_resolver(eb->db, local_abspath,
+                                                     kind,
+                                                     tree_conflict,
+                                                     NULL /* merge_options */,
+                                                     eb->conflict_func,
+                                                     eb->conflict_baton,
+                                                     eb->cancel_func,
+                                                     eb->cancel_baton,
+                                                     scratch_pool));
+          }
         do_notification(eb, local_abspath, kind, svn_wc_notify_tree_conflict,
                         scratch_pool);
       }
@@ -4584,15 +4665,20 @@ close_file(void *file_baton,
                                    scratch_pool));
 
   if (conflict_skel && eb->conflict_func)
-    SVN_ERR(svn_wc__conflict_invoke_resolver(eb->db, fb->local_abspath,
-                                             svn_node_file,
-                                             conflict_skel,
-                                             NULL /* merge_options */,
-                                             eb->conflict_func,
-                                             eb->conflict_baton,
-                                             eb->cancel_func,
-                                             eb->cancel_baton,
-                                             scratch_pool));
+    {
+      SVN_ERR(flush_batch(eb, scratch_pool));
+      SVN_ERR(svn_wc__conflict_invoke_resolver(eb->db, fb->local_abspath,
+                                               svn_node_file,
+                                               conflict_skel,
+                                               NULL /* merge_options */,
+                                               eb->conflict_func,
+                                               eb->conflict_baton,
+                                               eb->cancel_func,
+                                               eb->cancel_baton,
+                                               scratch_pool));
+    }
+
+  SVN_ERR(batch_node_done(eb, scratch_pool));
 
   /* Deal with the WORKING tree, based on updates to the BASE tree.  */
 
@@ -4849,6 +4935,8 @@ close_edit(void *edit_baton,
      cleanup at the end of this function. */
   apr_pool_cleanup_kill(eb->pool, eb, cleanup_edit_baton);
 
+  SVN_ERR(end_batch(eb, eb->pool));
+
   SVN_ERR(svn_wc__wq_run(eb->db, eb->wcroot_abspath,
                          eb->cancel_func, eb->cancel_baton,
                          eb->pool));
@@ -1669,6 +1669,13 @@ svn_wc__upgrade_sdb(int *result_format,
                                                     scratch_pool),
                              start_format);                             
 
+  /* Lazy-pristines working copies have the current schema. */
+  if (start_format == SVN_WC__LAZY_PRISTINES_VERSION)
+    {
+      *result_format = start_format;
+      return SVN_NO_ERROR;
+    }
+
   /* ### need lock-out. only one upgrade at a time. note that other code
      ### cannot use this un-upgraded database until we finish the upgrade.  */
 
@@ -1933,7 +1940,7 @@ svn_wc_upgrade(svn_wc_context_t *wc_ctx,
       /* Auto-upgrade worked! */
       SVN_ERR(svn_wc__db_close(db));
 
-      SVN_ERR_ASSERT(result_format == SVN_WC__VERSION);
+      SVN_ERR_ASSERT(SVN_WC__IS_CURRENT_FORMAT(result_format));
 
       if (bumped_format && notify_func)
         {
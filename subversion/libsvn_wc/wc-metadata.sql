@@ -699,9 +699,10 @@ WHERE l.op_depth = 0
 
 
 /* ------------------------------------------------------------------------- */
-/* Format 32 ....  */
-/* -- STMT_UPGRADE_TO_32
-PRAGMA user_version = 32; */
+/* Format 32 is format 31 in lazy-pristines mode, where the files of some
+   pristine texts may be missing.  Only the format number changes. */
+-- STMT_UPGRADE_TO_32
+PRAGMA user_version = 32;
 
 
 /* ------------------------------------------------------------------------- */
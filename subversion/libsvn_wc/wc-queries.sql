@@ -880,8 +880,12 @@ INSERT INTO work_queue (work) VALUES (?1)
 -- STMT_SELECT_WORK_ITEM
 SELECT id, work FROM work_queue ORDER BY id LIMIT 1
 
--- STMT_DELETE_WORK_ITEM
-DELETE FROM work_queue WHERE id = ?1
+-- STMT_SELECT_WORK_ITEM_AFTER
+SELECT id, work FROM work_queue WHERE id > ?1 ORDER BY id LIMIT 1
+
+/* Completes a whole run of work items at once; see wq_fetch_next(). */
+-- STMT_DELETE_WORK_ITEMS_UPTO
+DELETE FROM work_queue WHERE id <= ?1
 
 -- STMT_INSERT_OR_IGNORE_PRISTINE
 INSERT OR IGNORE INTO pristine (checksum, md5_checksum, size, refcount)
@@ -906,6 +910,22 @@ SELECT checksum
 FROM pristine
 WHERE md5_checksum = ?1
 
+-- STMT_SELECT_PRISTINE_ORIGINS
+SELECT n.local_relpath, r.root, n.repos_path, n.revision
+FROM nodes n
+LEFT OUTER JOIN repository r ON r.id = n.repos_id
+WHERE n.wc_id = ?1 AND n.local_relpath = ?2 AND n.checksum = ?3
+  AND n.presence = MAP_NORMAL
+ORDER BY n.op_depth DESC
+
+-- STMT_SELECT_OTHER_PRISTINE_ORIGINS
+SELECT n.local_relpath, r.root, n.repos_path, n.revision
+FROM nodes n
+LEFT OUTER JOIN repository r ON r.id = n.repos_id
+WHERE n.wc_id = ?1 AND n.local_relpath != ?2 AND n.checksum = ?3
+  AND n.presence = MAP_NORMAL
+LIMIT 16
+
 -- STMT_SELECT_UNREFERENCED_PRISTINES
 SELECT checksum
 FROM pristine
@@ -161,11 +161,24 @@ extern "C" {
  * == 1.9.x shipped with format 31
  * == 1.10.x shipped with format 31
  *
+ * Format 32 marks working copies that may lack the files of some of their
+ * pristine texts (see SVN_CONFIG_OPTION_LAZY_PRISTINES).  The schema is
+ * that of format 31; the number keeps older clients, which would report
+ * the missing files as corruption, out of these working copies.  Other
+ * working copies stay at format 31.
+ *
  * Please document any further format changes here.
  */
 
 #define SVN_WC__VERSION 31
 
+/* The format of working copies in lazy-pristines mode.  See above.  */
+#define SVN_WC__LAZY_PRISTINES_VERSION 32
+
+/* Whether FORMAT can be used without upgrading it.  */
+#define SVN_WC__IS_CURRENT_FORMAT(format) \
+  ((format) == SVN_WC__VERSION || (format) == SVN_WC__LAZY_PRISTINES_VERSION)
+
 
 /* Formats <= this have no concept of "revert text-base/props".  */
 #define SVN_WC__NO_REVERT_FILES 4
@@ -350,6 +363,50 @@ svn_wc__internal_file_modified_p(svn_boolean_t *modified_p,
                                  svn_boolean_t exact_comparison,
                                  apr_pool_t *scratch_pool);
 
+/* svn_wc__internal_file_modified_p() split into three steps, so that the
+ * expensive content comparison can run without access to DB, e.g. in a
+ * worker thread.
+ */
+typedef struct svn_wc__text_check_t svn_wc__text_check_t;
+
+/* First step of svn_wc__internal_file_modified_p() for LOCAL_ABSPATH in DB
+ * with EXACT_COMPARISON.  If the answer can be given without looking at
+ * the file contents, set *MODIFIED_P and set *CHECK to NULL.  Otherwise,
+ * open the pristine, look up everything needed to compare it against the
+ * working file and return that in *CHECK, allocated in RESULT_POOL.
+ * Use SCRATCH_POOL for temporary allocations.
+ */
+svn_error_t *
+svn_wc__text_check_prepare(svn_wc__text_check_t **check,
+                           svn_boolean_t *modified_p,
+                           svn_wc__db_t *db,
+                           const char *local_abspath,
+                           svn_boolean_t exact_comparison,
+                           apr_pool_t *result_pool,
+                           apr_pool_t *scratch_pool);
+
+/* Second step: compare the contents described by CHECK and set
+ * *MODIFIED_P accordingly.  This does not access the DB, so different
+ * threads may run different checks concurrently, as long as each CHECK
+ * and SCRATCH_POOL is used by one thread at a time only.  Must be called
+ * at most once per CHECK.
+ */
+svn_error_t *
+svn_wc__text_check_run(svn_boolean_t *modified_p,
+                       svn_wc__text_check_t *check,
+                       apr_pool_t *scratch_pool);
+
+/* Final step: if the text has not been MODIFIED according to CHECK,
+ * perform the timestamp repair in DB.  If DB holds no lock for it, try
+ * to lock the node's directory without waiting and skip the repair if
+ * that fails.  Use SCRATCH_POOL for temporary allocations.
+ */
+svn_error_t *
+svn_wc__text_check_finish(svn_wc__db_t *db,
+                          const svn_wc__text_check_t *check,
+                          svn_boolean_t modified,
+                          apr_pool_t *scratch_pool);
+
 
 /* Prepare to merge a file content change into the working copy.
 
@@ -1489,6 +1489,12 @@ svn_wc__db_init(svn_wc__db_t *db,
                     repos_relpath, initial_rev, depth, sqlite_exclusive,
                     sqlite_timeout,
                     db->state_pool, scratch_pool));
+  SVN_ERR(svn_wc__db_util_tune_db(sdb, db, local_abspath, sqlite_exclusive,
+                                  scratch_pool));
+
+  /* Mark the new working copy as lazy before anyone can use it.  */
+  if (db->lazy_pristines)
+    SVN_ERR(svn_sqlite__exec_statements(sdb, STMT_UPGRADE_TO_32));
 
   /* Create the WCROOT for this directory.  */
   SVN_ERR(svn_wc__db_pdh_create_wcroot(&wcroot,
@@ -13473,8 +13479,14 @@ wq_fetch_next(apr_uint64_t *id,
 
   if (completed_id != 0)
     {
+      /* This completes every item queued before COMPLETED_ID as well.
+         svn_wc__wq_run() always starts at the head of the queue and runs
+         the items in order, completing a run of file items (see
+         run_file_tasks() in workqueue.c) by its last id.  Any item before
+         COMPLETED_ID is therefore either part of that run or was already
+         completed, never one that still has to be done. */
       SVN_ERR(svn_sqlite__get_statement(&stmt, wcroot->sdb,
-                                        STMT_DELETE_WORK_ITEM));
+                                        STMT_DELETE_WORK_ITEMS_UPTO));
       SVN_ERR(svn_sqlite__bind_int64(stmt, 1, completed_id));
 
       SVN_ERR(svn_sqlite__step_done(stmt));
@@ -13533,6 +13545,53 @@ svn_wc__db_wq_fetch_next(apr_uint64_t *id,
   return SVN_NO_ERROR;
 }
 
+svn_error_t *
+svn_wc__db_wq_fetch_after(apr_uint64_t *id,
+                          svn_skel_t **work_item,
+                          svn_wc__db_t *db,
+                          const char *wri_abspath,
+                          apr_uint64_t after_id,
+                          apr_pool_t *result_pool,
+                          apr_pool_t *scratch_pool)
+{
+  svn_wc__db_wcroot_t *wcroot;
+  const char *local_relpath;
+  svn_sqlite__stmt_t *stmt;
+  svn_boolean_t have_row;
+
+  SVN_ERR_ASSERT(id != NULL);
+  SVN_ERR_ASSERT(work_item != NULL);
+  SVN_ERR_ASSERT(svn_dirent_is_absolute(wri_abspath));
+
+  SVN_ERR(svn_wc__db_wcroot_parse_local_abspath(&wcroot, &local_relpath, db,
+                              wri_abspath, scratch_pool, scratch_pool));
+  VERIFY_USABLE_WCROOT(wcroot);
+
+  SVN_ERR(svn_sqlite__get_statement(&stmt, wcroot->sdb,
+                                    STMT_SELECT_WORK_ITEM_AFTER));
+  SVN_ERR(svn_sqlite__bind_int64(stmt, 1, after_id));
+  SVN_ERR(svn_sqlite__step(&have_row, stmt));
+
+  if (!have_row)
+    {
+      *id = 0;
+      *work_item = NULL;
+    }
+  else
+    {
+      apr_size_t len;
+      const void *val;
+
+      *id = svn_sqlite__column_int64(stmt, 0);
+
+      val = svn_sqlite__column_blob(stmt, 1, &len, result_pool);
+
+      *work_item = svn_skel__parse(val, len, result_pool);
+    }
+
+  return svn_error_trace(svn_sqlite__reset(stmt));
+}
+
 /* Records timestamp and date for one or more files in wcroot */
 static svn_error_t *
 wq_record(svn_wc__db_wcroot_t *wcroot,
@@ -13597,6 +13656,94 @@ svn_wc__db_wq_record_and_fetch_next(apr_uint64_t *id,
 }
 
 
+svn_error_t *
+svn_wc__db_batch_begin(svn_wc__db_t *db,
+                       const char *wri_abspath,
+                       apr_pool_t *scratch_pool)
+{
+  svn_wc__db_wcroot_t *wcroot;
+  const char *local_relpath;
+
+  SVN_ERR_ASSERT(svn_dirent_is_absolute(wri_abspath));
+
+  SVN_ERR(svn_wc__db_wcroot_parse_local_abspath(&wcroot, &local_relpath, db,
+                              wri_abspath, scratch_pool, scratch_pool));
+  VERIFY_USABLE_WCROOT(wcroot);
+
+  SVN_ERR_ASSERT(! wcroot->batching);
+
+  /* All operations use savepoints, which simply nest in here.  Take the
+     RESERVED lock right away, like a pristine install or removal would;
+     see WITH_PRISTINE_TXN() in wc_db_pristine.c.  */
+  SVN_ERR(svn_sqlite__begin_immediate_transaction(wcroot->sdb));
+  wcroot->batching = TRUE;
+
+  return SVN_NO_ERROR;
+}
+
+/* Commit the batch transaction of WCROOT and start a new one, unless
+   STOP is set.  */
+static svn_error_t *
+batch_commit(svn_wc__db_wcroot_t *wcroot,
+             svn_boolean_t stop)
+{
+  svn_error_t *err;
+
+  /* This rolls back if the commit fails, ending the transaction either way.
+     There is no need to retry a failed commit:  nobody else should be
+     writing to a locked working copy and we don't know what went wrong.  */
+  err = svn_sqlite__finish_transaction(wcroot->sdb, SVN_NO_ERROR);
+  if (err || stop)
+    {
+      wcroot->batching = FALSE;
+      return svn_error_trace(err);
+    }
+
+  err = svn_sqlite__begin_immediate_transaction(wcroot->sdb);
+  if (err)
+    wcroot->batching = FALSE;
+
+  return svn_error_trace(err);
+}
+
+svn_error_t *
+svn_wc__db_batch_flush(svn_wc__db_t *db,
+                       const char *wri_abspath,
+                       apr_pool_t *scratch_pool)
+{
+  svn_wc__db_wcroot_t *wcroot;
+  const char *local_relpath;
+
+  SVN_ERR_ASSERT(svn_dirent_is_absolute(wri_abspath));
+
+  SVN_ERR(svn_wc__db_wcroot_parse_local_abspath(&wcroot, &local_relpath, db,
+                              wri_abspath, scratch_pool, scratch_pool));
+
+  if (! wcroot->sdb || ! wcroot->batching)
+    return SVN_NO_ERROR;
+
+  return svn_error_trace(batch_commit(wcroot, FALSE));
+}
+
+svn_error_t *
+svn_wc__db_batch_end(svn_wc__db_t *db,
+                     const char *wri_abspath,
+                     apr_pool_t *scratch_pool)
+{
+  svn_wc__db_wcroot_t *wcroot;
+  const char *local_relpath;
+
+  SVN_ERR_ASSERT(svn_dirent_is_absolute(wri_abspath));
+
+  SVN_ERR(svn_wc__db_wcroot_parse_local_abspath(&wcroot, &local_relpath, db,
+                              wri_abspath, scratch_pool, scratch_pool));
+
+  if (! wcroot->sdb || ! wcroot->batching)
+    return SVN_NO_ERROR;
+
+  return svn_error_trace(batch_commit(wcroot, TRUE));
+}
+
 
 /* ### temporary API. remove before release.  */
 svn_error_t *
@@ -1040,13 +1040,78 @@ svn_wc__db_pristine_remove(svn_wc__db_t *db,
                            apr_pool_t *scratch_pool);
 
 
-/* Remove all unreferenced pristines in the WC of WRI_ABSPATH in DB. */
+/* Remove all unreferenced pristines in the WC of WRI_ABSPATH in DB.  If DB
+   uses a shared pristine store, also remove all texts from it that no
+   working copy uses anymore. */
 svn_error_t *
 svn_wc__db_pristine_cleanup(svn_wc__db_t *db,
                             const char *wri_abspath,
                             apr_pool_t *scratch_pool);
 
 
+/* Set *CONTENTS to a readable stream of the pristine text with SHA-1
+   checksum SHA1_CHECKSUM in the shared pristine store of DB, allocated in
+   RESULT_POOL.  Set *CONTENTS to NULL if DB doesn't use a shared pristine
+   store or the text is not in it. */
+svn_error_t *
+svn_wc__db_pristine_read_shared(svn_stream_t **contents,
+                                svn_wc__db_t *db,
+                                const svn_checksum_t *sha1_checksum,
+                                apr_pool_t *result_pool,
+                                apr_pool_t *scratch_pool);
+
+
+/* Make sure that the file of the pristine text with SHA-1 checksum
+   SHA1_CHECKSUM in the WC of LOCAL_ABSPATH in DB exists, if the text is
+   in the pristine store at all.
+
+   A file removed by svn_wc__db_pristine_dehydrate() is restored from the
+   first of these that has the text: the shared pristine store of DB, the
+   working file of LOCAL_ABSPATH or of another node that uses the text, or
+   the repository through the function set with
+   svn_wc__db_set_fetch_pristine_func().  Return SVN_ERR_WC_CORRUPT_TEXT_BASE
+   if none of them has it.
+
+   svn_wc__db_pristine_read() and svn_wc__db_pristine_get_path() do this
+   on their own. */
+svn_error_t *
+svn_wc__db_pristine_hydrate(svn_wc__db_t *db,
+                            const char *local_abspath,
+                            const svn_checksum_t *sha1_checksum,
+                            apr_pool_t *scratch_pool);
+
+
+/* If the WC of WRI_ABSPATH in DB is in lazy-pristines mode, remove the
+   file of the pristine text with SHA-1 checksum SHA1_CHECKSUM in it from
+   disk.  The text stays in the pristine store: the caller must make sure
+   that it can be restored by svn_wc__db_pristine_hydrate(), e.g. because
+   a working file has just been installed from it without translation. */
+svn_error_t *
+svn_wc__db_pristine_dehydrate(svn_wc__db_t *db,
+                              const char *wri_abspath,
+                              const svn_checksum_t *sha1_checksum,
+                              apr_pool_t *scratch_pool);
+
+
+/* Put the WC of WRI_ABSPATH in DB into lazy-pristines mode, which
+   svn_wc__db_init() uses for new working copies if DB was opened with the
+   'lazy-pristines' option.  This bumps the WC to format
+   SVN_WC__LAZY_PRISTINES_VERSION, so that older clients refuse to work
+   with it.  Do nothing if the WC is in this mode already. */
+svn_error_t *
+svn_wc__db_enable_lazy_pristines(svn_wc__db_t *db,
+                                 const char *wri_abspath,
+                                 apr_pool_t *scratch_pool);
+
+
+/* Let DB call FETCH_FUNC with FETCH_BATON to restore pristine texts from
+   the repository.  FETCH_FUNC may be NULL. */
+void
+svn_wc__db_set_fetch_pristine_func(svn_wc__db_t *db,
+                                   svn_wc__fetch_pristine_func_t fetch_func,
+                                   void *fetch_baton);
+
+
 /* Set *PRESENT to true if the pristine store for WRI_ABSPATH in DB contains
    a pristine text with SHA-1 checksum SHA1_CHECKSUM, and to false otherwise.
 */
@@ -3002,8 +3067,11 @@ svn_wc__db_wq_add(svn_wc__db_t *db,
    If there are no work items to be completed, then ID will be set to zero,
    and WORK_ITEM to NULL.
 
-   If COMPLETED_ID is not 0, the wq item COMPLETED_ID will be marked as
-   completed before returning the next item.
+   If COMPLETED_ID is not 0, the wq item COMPLETED_ID and all items queued
+   before it will be marked as completed before returning the next item.
+   COMPLETED_ID must therefore be the item returned by the previous call,
+   or an item reached from it with svn_wc__db_wq_fetch_after() after all
+   items in between were run as well.
 
    RESULT_POOL will be used to allocate WORK_ITEM, and SCRATCH_POOL
    will be used for all temporary allocations.  */
@@ -3028,6 +3096,63 @@ svn_wc__db_wq_record_and_fetch_next(apr_uint64_t *id,
                                     apr_pool_t *result_pool,
                                     apr_pool_t *scratch_pool);
 
+/* In the WCROOT associated with DB and WRI_ABSPATH, fetch the work item
+   that was queued right after the item AFTER_ID, without marking anything
+   as completed.  This allows for looking ahead of the item returned by
+   svn_wc__db_wq_fetch_next().  Its identifier is returned in ID, and the
+   data in WORK_ITEM.  If there is no such item, ID will be set to zero,
+   and WORK_ITEM to NULL.
+
+   RESULT_POOL will be used to allocate WORK_ITEM, and SCRATCH_POOL
+   will be used for all temporary allocations.  */
+svn_error_t *
+svn_wc__db_wq_fetch_after(apr_uint64_t *id,
+                          svn_skel_t **work_item,
+                          svn_wc__db_t *db,
+                          const char *wri_abspath,
+                          apr_uint64_t after_id,
+                          apr_pool_t *result_pool,
+                          apr_pool_t *scratch_pool);
+
+
+/* @} */
+
+/* @defgroup svn_wc__db_batch  Batching changes
+   @{
+*/
+
+/* Start collecting all changes that DB makes in the wcroot associated with
+   WRI_ABSPATH in a single SQLite transaction, instead of committing every
+   operation to disk on its own.  This is meant for making many small
+   changes in a row, like the update editor does.
+
+   Every single operation remains atomic.  But if the process dies before
+   the batch is flushed, all changes made since the last flush are lost
+   together, so the working copy remains consistent.  Work items queued
+   during a batch must not be run before they are flushed;
+   svn_wc__wq_run() takes care of that.
+
+   Batches don't nest.  Use SCRATCH_POOL for temporary allocations.  */
+svn_error_t *
+svn_wc__db_batch_begin(svn_wc__db_t *db,
+                       const char *wri_abspath,
+                       apr_pool_t *scratch_pool);
+
+/* Commit all changes collected in the batch for the wcroot associated with
+   DB and WRI_ABSPATH, but continue batching.  Do nothing if there is no
+   batch.  Use SCRATCH_POOL for temporary allocations.  */
+svn_error_t *
+svn_wc__db_batch_flush(svn_wc__db_t *db,
+                       const char *wri_abspath,
+                       apr_pool_t *scratch_pool);
+
+/* Commit all changes collected in the batch for the wcroot associated with
+   DB and WRI_ABSPATH and stop batching.  Do nothing if there is no batch.
+   Use SCRATCH_POOL for temporary allocations.  */
+svn_error_t *
+svn_wc__db_batch_end(svn_wc__db_t *db,
+                     const char *wri_abspath,
+                     apr_pool_t *scratch_pool);
 
 /* @} */
 
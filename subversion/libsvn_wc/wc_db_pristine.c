@@ -25,6 +25,8 @@
 
 #define SVN_WC__I_AM_WC_DB
 
+#include <apr_user.h>
+
 #include "svn_pools.h"
 #include "svn_io.h"
 #include "svn_dirent_uri.h"
@@ -39,7 +41,19 @@
 #define PRISTINE_STORAGE_EXT ".svn-base"
 #define PRISTINE_STORAGE_RELPATH "pristine"
 #define PRISTINE_TEMPDIR_RELPATH "tmp"
+#define SHARED_STORE_LOCK "lock"
 
+/* Evaluate EXPR in a transaction on WCROOT that holds at least a 'RESERVED'
+   lock, like SVN_SQLITE__WITH_IMMEDIATE_TXN().  While WCROOT is batching,
+   its batch transaction already holds that lock and SQLite does not allow
+   nesting transactions, so use a savepoint instead. */
+#define WITH_PRISTINE_TXN(expr, wcroot)                                       \
+  do {                                                                        \
+    if ((wcroot)->batching)                                                   \
+      SVN_SQLITE__WITH_LOCK(expr, (wcroot)->sdb);                             \
+    else                                                                      \
+      SVN_SQLITE__WITH_IMMEDIATE_TXN(expr, (wcroot)->sdb);                    \
+  } while (0)
 
 
 /* Returns in PRISTINE_ABSPATH a new string allocated from RESULT_POOL,
@@ -93,6 +107,452 @@ get_pristine_fname(const char **pristine_abspath,
 }
 
 
+/* Return the local absolute path of the file that holds the pristine text
+   with SHA1_CHECKSUM in the shared pristine store at STORE_ABSPATH,
+   allocated in RESULT_POOL.  The file does not necessarily exist.
+
+   The shared store has the same layout as the pristine store of a working
+   copy, but it doesn't have a database.  Every file in it is a hard link
+   to the pristine files of the working copies that use the text, so the
+   link count of the file tells how many working copies still use it. */
+static const char *
+get_shared_pristine_fname(const char *store_abspath,
+                          const svn_checksum_t *sha1_checksum,
+                          apr_pool_t *result_pool)
+{
+  const char *hexdigest = svn_checksum_to_cstring(sha1_checksum, result_pool);
+  char subdir[3];
+
+  subdir[0] = hexdigest[0];
+  subdir[1] = hexdigest[1];
+  subdir[2] = '\0';
+
+  return svn_dirent_join_many(result_pool, store_abspath, subdir,
+                              apr_pstrcat(result_pool, hexdigest,
+                                          PRISTINE_STORAGE_EXT, SVN_VA_NULL),
+                              SVN_VA_NULL);
+}
+
+/* Lock the shared pristine store at STORE_ABSPATH against other processes
+   adding or removing files, until LOCK_POOL is cleared.  Create the store
+   if it doesn't exist yet. */
+static svn_error_t *
+lock_shared_store(const char *store_abspath,
+                  apr_pool_t *lock_pool)
+{
+  SVN_ERR(svn_io_make_dir_recursively(store_abspath, lock_pool));
+
+  return svn_error_trace(svn_io__file_lock_autocreate(
+                           svn_dirent_join(store_abspath, SHARED_STORE_LOCK,
+                                           lock_pool),
+                           lock_pool));
+}
+
+/* Return an error unless FILE, opened from the shared pristine store or
+   linked to it at LOCAL_ABSPATH, belongs to the current user and contains
+   the text with SHA1_CHECKSUM.  Leave the file pointer of FILE at the
+   start of the file.
+
+   Other users may be able to write to the store, so we can't trust its
+   contents.  Files of our own can't be changed by anyone else later,
+   which checking the contents once can't rule out. */
+static svn_error_t *
+verify_shared_file(apr_file_t *file,
+                   const char *local_abspath,
+                   const svn_checksum_t *sha1_checksum,
+                   apr_pool_t *scratch_pool)
+{
+  apr_finfo_t finfo;
+  apr_uid_t uid;
+  apr_gid_t gid;
+  apr_status_t status;
+  svn_checksum_t *actual_checksum;
+  apr_off_t offset = 0;
+
+  status = apr_file_info_get(&finfo, APR_FINFO_USER, file);
+  if (status && status != APR_INCOMPLETE)
+    return svn_error_wrap_apr(status,
+                              _("Can't get attribute information from "
+                                "file '%s'"),
+                              svn_dirent_local_style(local_abspath,
+                                                     scratch_pool));
+
+  status = apr_uid_current(&uid, &gid, scratch_pool);
+  if (status)
+    return svn_error_wrap_apr(status, _("Error getting UID of process"));
+
+  if (!(finfo.valid & APR_FINFO_USER) || apr_uid_compare(finfo.user, uid))
+    return svn_error_createf(SVN_ERR_WC_CORRUPT_TEXT_BASE, NULL,
+                             _("Shared pristine text '%s' belongs to "
+                               "another user"),
+                             svn_dirent_local_style(local_abspath,
+                                                    scratch_pool));
+
+  SVN_ERR(svn_stream_contents_checksum(&actual_checksum,
+                                       svn_stream_from_aprfile2(
+                                         file, TRUE, scratch_pool),
+                                       svn_checksum_sha1,
+                                       scratch_pool, scratch_pool));
+  if (!svn_checksum_match(actual_checksum, sha1_checksum))
+    return svn_error_trace(svn_checksum_mismatch_err(
+                             sha1_checksum, actual_checksum, scratch_pool,
+                             _("Checksum mismatch for shared pristine "
+                               "text '%s'"),
+                             svn_dirent_local_style(local_abspath,
+                                                    scratch_pool)));
+
+  return svn_error_trace(svn_io_file_seek(file, APR_SET, &offset,
+                                          scratch_pool));
+}
+
+/* Link PRISTINE_ABSPATH to the text with SHA1_CHECKSUM at SHARED_ABSPATH
+   in the shared pristine store and set *LINKED to TRUE.  If the shared
+   file can't be linked or fails verify_shared_file(), make sure that
+   PRISTINE_ABSPATH does not exist and set *LINKED to FALSE.
+
+   We verify our own link to the file, so that nobody can replace the file
+   in the store between the check and the link. */
+static svn_error_t *
+link_shared_pristine(svn_boolean_t *linked,
+                     const char *shared_abspath,
+                     const char *pristine_abspath,
+                     const svn_checksum_t *sha1_checksum,
+                     apr_pool_t *scratch_pool)
+{
+  apr_file_t *file;
+  svn_error_t *err;
+
+  err = svn_io__file_link(shared_abspath, pristine_abspath, scratch_pool);
+  if (err && APR_STATUS_IS_ENOENT(err->apr_err))
+    {
+      svn_error_clear(err);
+      err = svn_io_make_dir_recursively(svn_dirent_dirname(pristine_abspath,
+                                                           scratch_pool),
+                                        scratch_pool);
+      if (!err)
+        err = svn_io__file_link(shared_abspath, pristine_abspath,
+                                scratch_pool);
+    }
+
+  if (!err)
+    {
+      err = svn_io_file_open(&file, pristine_abspath, APR_READ,
+                             APR_OS_DEFAULT, scratch_pool);
+      if (!err)
+        err = svn_error_compose_create(
+                verify_shared_file(file, pristine_abspath, sha1_checksum,
+                                   scratch_pool),
+                svn_io_file_close(file, scratch_pool));
+    }
+
+  *linked = !err;
+  if (err)
+    {
+      svn_error_clear(err);
+      SVN_ERR(svn_io_remove_file2(pristine_abspath, TRUE, scratch_pool));
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Return the absolute path to the temporary directory for pristine text
+   files within WCROOT. */
+static char *
+pristine_get_tempdir(svn_wc__db_wcroot_t *wcroot,
+                     apr_pool_t *result_pool,
+                     apr_pool_t *scratch_pool)
+{
+  return svn_dirent_join_many(result_pool, wcroot->abspath,
+                              svn_wc_get_adm_dir(scratch_pool),
+                              PRISTINE_TEMPDIR_RELPATH, SVN_VA_NULL);
+}
+
+/* A place where a pristine text may be found, for pristine_hydrate(). */
+typedef struct pristine_origin_t
+{
+  svn_wc__db_t *db;
+
+  /* A working file that uses the text, if it isn't modified. */
+  const char *local_abspath;
+
+  /* Where the text is in the repository, if REPOS_ROOT_URL is not NULL. */
+  const char *repos_root_url;
+  const char *repos_relpath;
+  svn_revnum_t revision;
+} pristine_origin_t;
+
+/* Write a text from ORIGIN to STREAM without closing it. */
+typedef svn_error_t *(*pristine_restore_func_t)(
+  const pristine_origin_t *origin,
+  svn_stream_t *stream,
+  apr_pool_t *scratch_pool);
+
+/* Implements pristine_restore_func_t, copying the working file. */
+static svn_error_t *
+restore_from_working_file(const pristine_origin_t *origin,
+                          svn_stream_t *stream,
+                          apr_pool_t *scratch_pool)
+{
+  svn_stream_t *file_stream;
+
+  SVN_ERR(svn_stream_open_readonly(&file_stream, origin->local_abspath,
+                                   scratch_pool, scratch_pool));
+
+  return svn_error_trace(svn_stream_copy3(file_stream,
+                                          svn_stream_disown(stream,
+                                                            scratch_pool),
+                                          NULL, NULL, scratch_pool));
+}
+
+/* Implements pristine_restore_func_t, fetching the text from the
+   repository. */
+static svn_error_t *
+restore_from_repos(const pristine_origin_t *origin,
+                   svn_stream_t *stream,
+                   apr_pool_t *scratch_pool)
+{
+  svn_wc__db_t *db = origin->db;
+
+  return svn_error_trace(db->fetch_pristine_func(db->fetch_pristine_baton,
+                                                 svn_stream_disown(
+                                                   stream, scratch_pool),
+                                                 origin->repos_root_url,
+                                                 origin->repos_relpath,
+                                                 origin->revision,
+                                                 scratch_pool));
+}
+
+/* Let RESTORE_FUNC write a text from ORIGIN and, if it has the SHA-1
+ * checksum SHA1_CHECKSUM, move it to PRISTINE_ABSPATH in the pristine store
+ * of WCROOT.  Set *RESTORED to whether that happened.  Return errors from
+ * RESTORE_FUNC, after removing the text.
+ */
+static svn_error_t *
+pristine_restore(svn_boolean_t *restored,
+                 svn_wc__db_wcroot_t *wcroot,
+                 const svn_checksum_t *sha1_checksum,
+                 const char *pristine_abspath,
+                 pristine_restore_func_t restore_func,
+                 const pristine_origin_t *origin,
+                 apr_pool_t *scratch_pool)
+{
+  svn_stream_t *install_stream;
+  svn_stream_t *stream;
+  svn_checksum_t *actual_checksum = NULL;
+  svn_error_t *err;
+
+  *restored = FALSE;
+
+  SVN_ERR(svn_stream__create_for_install(&install_stream,
+                                         pristine_get_tempdir(wcroot,
+                                                              scratch_pool,
+                                                              scratch_pool),
+                                         scratch_pool, scratch_pool));
+  stream = svn_stream_checksummed2(install_stream, NULL, &actual_checksum,
+                                   svn_checksum_sha1, FALSE, scratch_pool);
+
+  err = restore_func(origin, stream, scratch_pool);
+  err = svn_error_compose_create(err, svn_stream_close(stream));
+
+  if (err || !svn_checksum_match(actual_checksum, sha1_checksum))
+    return svn_error_trace(svn_error_compose_create(
+                             err,
+                             svn_stream__install_delete(install_stream,
+                                                        scratch_pool)));
+
+  SVN_ERR(svn_stream__install_stream(install_stream, pristine_abspath,
+                                     TRUE, scratch_pool));
+  SVN_ERR(svn_io_set_file_read_only(pristine_abspath, FALSE, scratch_pool));
+
+  *restored = TRUE;
+  return SVN_NO_ERROR;
+}
+
+/* Append a pristine_origin_t * to ORIGINS for every row that statement
+ * STMT_IDX yields for LOCAL_RELPATH and SHA1_CHECKSUM in WCROOT of DB.
+ * Allocate them in RESULT_POOL.
+ */
+static svn_error_t *
+read_pristine_origins(apr_array_header_t *origins,
+                      svn_wc__db_t *db,
+                      svn_wc__db_wcroot_t *wcroot,
+                      int stmt_idx,
+                      const char *local_relpath,
+                      const svn_checksum_t *sha1_checksum,
+                      apr_pool_t *result_pool)
+{
+  svn_sqlite__stmt_t *stmt;
+  svn_boolean_t have_row;
+
+  SVN_ERR(svn_sqlite__get_statement(&stmt, wcroot->sdb, stmt_idx));
+  SVN_ERR(svn_sqlite__bindf(stmt, "is", wcroot->wc_id, local_relpath));
+  SVN_ERR(svn_sqlite__bind_checksum(stmt, 3, sha1_checksum, result_pool));
+  SVN_ERR(svn_sqlite__step(&have_row, stmt));
+  while (have_row)
+    {
+      pristine_origin_t *origin = apr_pcalloc(result_pool, sizeof(*origin));
+
+      origin->db = db;
+      origin->local_abspath = svn_dirent_join(
+                                wcroot->abspath,
+                                svn_sqlite__column_text(stmt, 0, NULL),
+                                result_pool);
+      origin->repos_root_url = svn_sqlite__column_text(stmt, 1, result_pool);
+      origin->repos_relpath = svn_sqlite__column_text(stmt, 2, result_pool);
+      origin->revision = svn_sqlite__column_revnum(stmt, 3);
+
+      APR_ARRAY_PUSH(origins, pristine_origin_t *) = origin;
+      SVN_ERR(svn_sqlite__step(&have_row, stmt));
+    }
+
+  return svn_error_trace(svn_sqlite__reset(stmt));
+}
+
+/* Try pristine_restore() with restore_from_working_file() for the
+ * elements of ORIGINS starting at index FIRST, until *RESTORED gets set.
+ */
+static svn_error_t *
+restore_from_working_files(svn_boolean_t *restored,
+                           svn_wc__db_wcroot_t *wcroot,
+                           const svn_checksum_t *sha1_checksum,
+                           const char *pristine_abspath,
+                           const apr_array_header_t *origins,
+                           int first,
+                           apr_pool_t *scratch_pool)
+{
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  int i;
+
+  *restored = FALSE;
+  for (i = first; !*restored && i < origins->nelts; i++)
+    {
+      const pristine_origin_t *origin
+        = APR_ARRAY_IDX(origins, i, const pristine_origin_t *);
+
+      svn_pool_clear(iterpool);
+
+      /* Modified and missing files just don't help. */
+      svn_error_clear(pristine_restore(restored, wcroot, sha1_checksum,
+                                       pristine_abspath,
+                                       restore_from_working_file, origin,
+                                       iterpool));
+    }
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_wc__db_pristine_hydrate() for the text with SHA1_CHECKSUM
+ * in WCROOT, whose file is at PRISTINE_ABSPATH.  Prefer the working file
+ * of LOCAL_RELPATH over those of other nodes.
+ *
+ * This reads WCROOT outside of any txn and doesn't hold one while copying
+ * or fetching texts.
+ */
+static svn_error_t *
+pristine_hydrate(svn_wc__db_t *db,
+                 svn_wc__db_wcroot_t *wcroot,
+                 const char *local_relpath,
+                 const svn_checksum_t *sha1_checksum,
+                 const char *pristine_abspath,
+                 apr_pool_t *scratch_pool)
+{
+  svn_sqlite__stmt_t *stmt;
+  svn_node_kind_t kind;
+  svn_boolean_t have_row;
+  apr_array_header_t *origins;
+  svn_boolean_t restored = FALSE;
+  svn_error_t *fetch_err = SVN_NO_ERROR;
+  apr_pool_t *iterpool;
+  int i;
+
+  SVN_ERR(svn_io_check_path(pristine_abspath, &kind, scratch_pool));
+  if (kind != svn_node_none)
+    return SVN_NO_ERROR;
+
+  /* Texts that aren't in the store are just missing. */
+  SVN_ERR(svn_sqlite__get_statement(&stmt, wcroot->sdb, STMT_SELECT_PRISTINE));
+  SVN_ERR(svn_sqlite__bind_checksum(stmt, 1, sha1_checksum, scratch_pool));
+  SVN_ERR(svn_sqlite__step(&have_row, stmt));
+  SVN_ERR(svn_sqlite__reset(stmt));
+  if (!have_row)
+    return SVN_NO_ERROR;
+
+  if (db->shared_pristine_abspath)
+    {
+      apr_pool_t *lock_pool = svn_pool_create(scratch_pool);
+      svn_boolean_t linked = FALSE;
+      svn_error_t *err;
+
+      err = lock_shared_store(db->shared_pristine_abspath, lock_pool);
+      if (!err)
+        err = link_shared_pristine(&linked,
+                                   get_shared_pristine_fname(
+                                     db->shared_pristine_abspath,
+                                     sha1_checksum, lock_pool),
+                                   pristine_abspath, sha1_checksum,
+                                   lock_pool);
+      svn_pool_destroy(lock_pool);
+
+      if (!err && linked)
+        return SVN_NO_ERROR;
+      svn_error_clear(err);
+    }
+
+  /* Unmodified working files are the cheapest source.  Look at those of
+     other nodes only if LOCAL_RELPATH doesn't help; that reads all
+     nodes. */
+  origins = apr_array_make(scratch_pool, 16, sizeof(pristine_origin_t *));
+  SVN_ERR(read_pristine_origins(origins, db, wcroot,
+                                STMT_SELECT_PRISTINE_ORIGINS, local_relpath,
+                                sha1_checksum, scratch_pool));
+  SVN_ERR(restore_from_working_files(&restored, wcroot, sha1_checksum,
+                                     pristine_abspath, origins, 0,
+                                     scratch_pool));
+  if (!restored)
+    {
+      int first_other = origins->nelts;
+
+      SVN_ERR(read_pristine_origins(origins, db, wcroot,
+                                    STMT_SELECT_OTHER_PRISTINE_ORIGINS,
+                                    local_relpath, sha1_checksum,
+                                    scratch_pool));
+      SVN_ERR(restore_from_working_files(&restored, wcroot, sha1_checksum,
+                                         pristine_abspath, origins,
+                                         first_other, scratch_pool));
+    }
+
+  iterpool = svn_pool_create(scratch_pool);
+  for (i = 0;
+       !restored && db->fetch_pristine_func && i < origins->nelts;
+       i++)
+    {
+      const pristine_origin_t *origin
+        = APR_ARRAY_IDX(origins, i, const pristine_origin_t *);
+
+      if (!origin->repos_root_url || !origin->repos_relpath
+          || !SVN_IS_VALID_REVNUM(origin->revision))
+        continue;
+
+      svn_pool_clear(iterpool);
+      svn_error_clear(fetch_err);
+      fetch_err = pristine_restore(&restored, wcroot, sha1_checksum,
+                                   pristine_abspath, restore_from_repos,
+                                   origin, iterpool);
+    }
+
+  svn_pool_destroy(iterpool);
+
+  if (!restored)
+    return svn_error_createf(SVN_ERR_WC_CORRUPT_TEXT_BASE, fetch_err,
+                             _("Can't restore pristine text '%s'"),
+                             svn_checksum_to_cstring_display(sha1_checksum,
+                                                             scratch_pool));
+
+  svn_error_clear(fetch_err);
+  return SVN_NO_ERROR;
+}
+
 svn_error_t *
 svn_wc__db_pristine_get_path(const char **pristine_abspath,
                              svn_wc__db_t *db,
@@ -121,8 +581,19 @@ svn_wc__db_pristine_get_path(const char **pristine_abspath,
                                              scratch_pool, scratch_pool));
   VERIFY_USABLE_WCROOT(wcroot);
 
+  SVN_ERR(get_pristine_fname(pristine_abspath, wcroot->abspath,
+                             sha1_checksum,
+                             result_pool, scratch_pool));
+
   SVN_ERR(svn_wc__db_pristine_check(&present, db, wri_abspath, sha1_checksum,
                                     scratch_pool));
+  if (! present)
+    {
+      SVN_ERR(pristine_hydrate(db, wcroot, local_relpath, sha1_checksum,
+                               *pristine_abspath, scratch_pool));
+      SVN_ERR(svn_wc__db_pristine_check(&present, db, wri_abspath,
+                                        sha1_checksum, scratch_pool));
+    }
   if (! present)
     return svn_error_createf(SVN_ERR_WC_DB_ERROR, NULL,
                              _("The pristine text with checksum '%s' was "
@@ -130,10 +601,6 @@ svn_wc__db_pristine_get_path(const char **pristine_abspath,
                              svn_checksum_to_cstring_display(sha1_checksum,
                                                              scratch_pool));
 
-  SVN_ERR(get_pristine_fname(pristine_abspath, wcroot->abspath,
-                             sha1_checksum,
-                             result_pool, scratch_pool));
-
   return SVN_NO_ERROR;
 }
 
@@ -154,7 +621,8 @@ svn_wc__db_pristine_get_future_path(const char **pristine_abspath,
  * identified by SHA1_CHECKSUM and PRISTINE_ABSPATH can be read from the
  * pristine store of WCROOT.  If SIZE is not null, set *SIZE to the size
  * in bytes of that text. If that text is not in the pristine store,
- * return an error.
+ * return an error.  If the text is in the store but its file has been
+ * dehydrated, set *CONTENTS to NULL.
  *
  * Even if the pristine text is removed from the store while it is being
  * read, the stream will remain valid and readable until it is closed.
@@ -206,8 +674,17 @@ pristine_read_txn(svn_stream_t **contents,
   if (contents)
     {
       apr_file_t *file;
-      SVN_ERR(svn_io_file_open(&file, pristine_abspath, APR_READ,
-                               APR_OS_DEFAULT, result_pool));
+      svn_error_t *err;
+
+      err = svn_io_file_open(&file, pristine_abspath, APR_READ,
+                             APR_OS_DEFAULT, result_pool);
+      if (err && APR_STATUS_IS_ENOENT(err->apr_err))
+        {
+          svn_error_clear(err);
+          *contents = NULL;
+          return SVN_NO_ERROR;
+        }
+      SVN_ERR(err);
       *contents = svn_stream_from_aprfile2(file, FALSE, result_pool);
     }
 
@@ -252,25 +729,237 @@ svn_wc__db_pristine_read(svn_stream_t **contents,
                       result_pool, scratch_pool),
     wcroot);
 
+  /* Restore a dehydrated text without holding the txn. */
+  if (contents && !*contents)
+    {
+      apr_file_t *file;
+
+      SVN_ERR(pristine_hydrate(db, wcroot, local_relpath, sha1_checksum,
+                               pristine_abspath, scratch_pool));
+      SVN_ERR(svn_io_file_open(&file, pristine_abspath, APR_READ,
+                               APR_OS_DEFAULT, result_pool));
+      *contents = svn_stream_from_aprfile2(file, FALSE, result_pool);
+    }
+
   return SVN_NO_ERROR;
 }
 
 
-/* Return the absolute path to the temporary directory for pristine text
-   files within WCROOT. */
-static char *
-pristine_get_tempdir(svn_wc__db_wcroot_t *wcroot,
-                     apr_pool_t *result_pool,
-                     apr_pool_t *scratch_pool)
+svn_error_t *
+svn_wc__db_pristine_read_shared(svn_stream_t **contents,
+                                svn_wc__db_t *db,
+                                const svn_checksum_t *sha1_checksum,
+                                apr_pool_t *result_pool,
+                                apr_pool_t *scratch_pool)
 {
-  return svn_dirent_join_many(result_pool, wcroot->abspath,
-                              svn_wc_get_adm_dir(scratch_pool),
-                              PRISTINE_TEMPDIR_RELPATH, SVN_VA_NULL);
+  const char *shared_abspath;
+  apr_file_t *file;
+  svn_error_t *err;
+
+  *contents = NULL;
+
+  if (!db->shared_pristine_abspath
+      || sha1_checksum->kind != svn_checksum_sha1)
+    return SVN_NO_ERROR;
+
+  shared_abspath = get_shared_pristine_fname(db->shared_pristine_abspath,
+                                             sha1_checksum, scratch_pool);
+
+  /* Like in pristine_read_txn(), the file remains readable even if it is
+     removed from the store after we opened it. */
+  err = svn_io_file_open(&file, shared_abspath, APR_READ, APR_OS_DEFAULT,
+                         result_pool);
+  if (err)
+    {
+      /* Like a missing text, one that we can't read is not an error. */
+      svn_error_clear(err);
+      return SVN_NO_ERROR;
+    }
+
+  err = verify_shared_file(file, shared_abspath, sha1_checksum,
+                           scratch_pool);
+  if (err)
+    {
+      svn_error_clear(err);
+      return svn_error_trace(svn_io_file_close(file, scratch_pool));
+    }
+
+  *contents = svn_stream_from_aprfile2(file, FALSE, result_pool);
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_wc__db_pristine_hydrate(svn_wc__db_t *db,
+                            const char *local_abspath,
+                            const svn_checksum_t *sha1_checksum,
+                            apr_pool_t *scratch_pool)
+{
+  svn_wc__db_wcroot_t *wcroot;
+  const char *local_relpath;
+  const char *pristine_abspath;
+
+  SVN_ERR_ASSERT(svn_dirent_is_absolute(local_abspath));
+  SVN_ERR_ASSERT(sha1_checksum->kind == svn_checksum_sha1);
+
+  SVN_ERR(svn_wc__db_wcroot_parse_local_abspath(&wcroot, &local_relpath, db,
+                              local_abspath, scratch_pool, scratch_pool));
+  VERIFY_USABLE_WCROOT(wcroot);
+
+  SVN_ERR(get_pristine_fname(&pristine_abspath, wcroot->abspath,
+                             sha1_checksum, scratch_pool, scratch_pool));
+
+  return svn_error_trace(pristine_hydrate(db, wcroot, local_relpath,
+                                          sha1_checksum, pristine_abspath,
+                                          scratch_pool));
+}
+
+svn_error_t *
+svn_wc__db_pristine_dehydrate(svn_wc__db_t *db,
+                              const char *wri_abspath,
+                              const svn_checksum_t *sha1_checksum,
+                              apr_pool_t *scratch_pool)
+{
+  svn_wc__db_wcroot_t *wcroot;
+  const char *local_relpath;
+  const char *pristine_abspath;
+
+  SVN_ERR_ASSERT(svn_dirent_is_absolute(wri_abspath));
+  SVN_ERR_ASSERT(sha1_checksum->kind == svn_checksum_sha1);
+
+  SVN_ERR(svn_wc__db_wcroot_parse_local_abspath(&wcroot, &local_relpath, db,
+                              wri_abspath, scratch_pool, scratch_pool));
+  VERIFY_USABLE_WCROOT(wcroot);
+
+  /* Clients that don't know this mode must not see missing pristines. */
+  if (wcroot->format != SVN_WC__LAZY_PRISTINES_VERSION)
+    return SVN_NO_ERROR;
+
+  SVN_ERR(get_pristine_fname(&pristine_abspath, wcroot->abspath,
+                             sha1_checksum, scratch_pool, scratch_pool));
+
+  /* Readers that have already opened the file can still read it.  Others
+     restore it with pristine_hydrate(). */
+  return svn_error_trace(svn_io_remove_file2(pristine_abspath, TRUE,
+                                             scratch_pool));
+}
+
+svn_error_t *
+svn_wc__db_enable_lazy_pristines(svn_wc__db_t *db,
+                                 const char *wri_abspath,
+                                 apr_pool_t *scratch_pool)
+{
+  svn_wc__db_wcroot_t *wcroot;
+  const char *local_relpath;
+
+  SVN_ERR_ASSERT(svn_dirent_is_absolute(wri_abspath));
+
+  SVN_ERR(svn_wc__db_wcroot_parse_local_abspath(&wcroot, &local_relpath, db,
+                              wri_abspath, scratch_pool, scratch_pool));
+  VERIFY_USABLE_WCROOT(wcroot);
+
+  if (wcroot->format == SVN_WC__LAZY_PRISTINES_VERSION)
+    return SVN_NO_ERROR;
+
+  SVN_ERR(svn_sqlite__exec_statements(wcroot->sdb, STMT_UPGRADE_TO_32));
+  wcroot->format = SVN_WC__LAZY_PRISTINES_VERSION;
+
+  return SVN_NO_ERROR;
+}
+
+void
+svn_wc__db_set_fetch_pristine_func(svn_wc__db_t *db,
+                                   svn_wc__fetch_pristine_func_t fetch_func,
+                                   void *fetch_baton)
+{
+  db->fetch_pristine_func = fetch_func;
+  db->fetch_pristine_baton = fetch_baton;
+}
+
+
+/* Move the new pristine text in INSTALL_STREAM to PRISTINE_ABSPATH, sharing
+ * it with other working copies through the shared pristine store at
+ * STORE_ABSPATH.
+ *
+ * If the shared store already has a usable copy of the text (see
+ * link_shared_pristine()), link PRISTINE_ABSPATH to it and just delete the
+ * new file.  Otherwise, move the new file into place and add a link to it
+ * to the shared store.  The store is just an optimization: if it is on a
+ * different file system or anything else goes wrong with it, the working
+ * copy simply keeps a private copy of the text.
+ */
+static svn_error_t *
+pristine_install_shared(svn_stream_t *install_stream,
+                        const char *pristine_abspath,
+                        const char *store_abspath,
+                        const svn_checksum_t *sha1_checksum,
+                        apr_pool_t *scratch_pool)
+{
+  apr_pool_t *lock_pool = svn_pool_create(scratch_pool);
+  const char *shared_abspath;
+  svn_node_kind_t kind;
+  svn_error_t *err;
+
+  shared_abspath = get_shared_pristine_fname(store_abspath, sha1_checksum,
+                                             lock_pool);
+
+  /* Keep svn_wc__db_pristine_cleanup() in other processes from removing
+     the shared file between our check and our link. */
+  err = lock_shared_store(store_abspath, lock_pool);
+  if (!err)
+    err = svn_io_check_path(shared_abspath, &kind, lock_pool);
+  if (err)
+    {
+      /* Don't touch the store at all. */
+      svn_error_clear(err);
+      kind = svn_node_unknown;
+    }
+
+  if (kind == svn_node_file)
+    {
+      svn_boolean_t linked;
+
+      /* An orphan at PRISTINE_ABSPATH doesn't matter; see below. */
+      SVN_ERR(svn_io_remove_file2(pristine_abspath, TRUE, lock_pool));
+      SVN_ERR(link_shared_pristine(&linked, shared_abspath, pristine_abspath,
+                                   sha1_checksum, lock_pool));
+
+      if (linked)
+        {
+          svn_pool_destroy(lock_pool);
+          return svn_error_trace(svn_stream__install_delete(install_stream,
+                                                            scratch_pool));
+        }
+    }
+
+  /* Move the file to its target location.  (If it is already there, it is
+   * an orphan file and it doesn't matter if we overwrite it.) */
+  SVN_ERR(svn_stream__install_stream(install_stream, pristine_abspath,
+                                     TRUE, lock_pool));
+  SVN_ERR(svn_io_set_file_read_only(pristine_abspath, FALSE, lock_pool));
+
+  if (kind == svn_node_none)
+    {
+      err = svn_io_make_dir_recursively(svn_dirent_dirname(shared_abspath,
+                                                           lock_pool),
+                                        lock_pool);
+      if (!err)
+        err = svn_io__file_link(pristine_abspath, shared_abspath, lock_pool);
+
+      /* Not sharing the text is no problem. */
+      svn_error_clear(err);
+    }
+
+  svn_pool_destroy(lock_pool);
+
+  return SVN_NO_ERROR;
 }
 
 /* Install the pristine text described by BATON into the pristine store of
  * SDB.  If it is already stored then just delete the new file
- * BATON->tempfile_abspath.
+ * BATON->tempfile_abspath, unless the stored file has been dehydrated.
+ * If STORE_ABSPATH is not NULL, share the text through the shared pristine
+ * store at that path.
  *
  * This function expects to be executed inside a SQLite txn that has already
  * acquired a 'RESERVED' lock.
@@ -287,6 +976,8 @@ pristine_install_txn(svn_sqlite__db_t *sdb,
                      const svn_checksum_t *sha1_checksum,
                      /* The pristine text's MD-5 checksum. */
                      const svn_checksum_t *md5_checksum,
+                     /* The shared pristine store or NULL. */
+                     const char *store_abspath,
                      apr_pool_t *scratch_pool)
 {
   svn_sqlite__stmt_t *stmt;
@@ -301,6 +992,26 @@ pristine_install_txn(svn_sqlite__db_t *sdb,
 
   if (have_row)
     {
+      svn_node_kind_t kind;
+
+      /* Use the new file to restore a dehydrated text. */
+      SVN_ERR(svn_io_check_path(pristine_abspath, &kind, scratch_pool));
+      if (kind == svn_node_none)
+        {
+          if (store_abspath)
+            SVN_ERR(pristine_install_shared(install_stream, pristine_abspath,
+                                            store_abspath, sha1_checksum,
+                                            scratch_pool));
+          else
+            SVN_ERR(svn_stream__install_stream(install_stream,
+                                               pristine_abspath,
+                                               TRUE, scratch_pool));
+
+          SVN_ERR(svn_io_set_file_read_only(pristine_abspath, FALSE,
+                                            scratch_pool));
+          return SVN_NO_ERROR;
+        }
+
 #ifdef SVN_DEBUG
       /* Consistency checks.  Verify both files exist and match.
        * ### We could check much more. */
@@ -335,8 +1046,13 @@ pristine_install_txn(svn_sqlite__db_t *sdb,
     apr_finfo_t finfo;
     SVN_ERR(svn_stream__install_get_info(&finfo, install_stream,
                                          APR_FINFO_SIZE, scratch_pool));
-    SVN_ERR(svn_stream__install_stream(install_stream, pristine_abspath,
-                                       TRUE, scratch_pool));
+    if (store_abspath)
+      SVN_ERR(pristine_install_shared(install_stream, pristine_abspath,
+                                      store_abspath, sha1_checksum,
+                                      scratch_pool));
+    else
+      SVN_ERR(svn_stream__install_stream(install_stream, pristine_abspath,
+                                         TRUE, scratch_pool));
 
     SVN_ERR(svn_sqlite__get_statement(&stmt, sdb, STMT_INSERT_PRISTINE));
     SVN_ERR(svn_sqlite__bind_checksum(stmt, 1, sha1_checksum, scratch_pool));
@@ -354,6 +1070,9 @@ struct svn_wc__db_install_data_t
 {
   svn_wc__db_wcroot_t *wcroot;
   svn_stream_t *inner_stream;
+
+  /* The shared pristine store or NULL */
+  const char *store_abspath;
 };
 
 svn_error_t *
@@ -380,6 +1099,7 @@ svn_wc__db_pristine_prepare_install(svn_stream_t **stream,
 
   *install_data = apr_pcalloc(result_pool, sizeof(**install_data));
   (*install_data)->wcroot = wcroot;
+  (*install_data)->store_abspath = db->shared_pristine_abspath;
 
   SVN_ERR_W(svn_stream__create_for_install(stream,
                                            temp_dir_abspath,
@@ -418,12 +1138,13 @@ svn_wc__db_pristine_install(svn_wc__db_install_data_t *install_data,
 
   /* Ensure the SQL txn has at least a 'RESERVED' lock before we start looking
    * at the disk, to ensure no concurrent pristine install/delete txn. */
-  SVN_SQLITE__WITH_IMMEDIATE_TXN(
+  WITH_PRISTINE_TXN(
     pristine_install_txn(wcroot->sdb,
                          install_data->inner_stream, pristine_abspath,
                          sha1_checksum, md5_checksum,
+                         install_data->store_abspath,
                          scratch_pool),
-    wcroot->sdb);
+    wcroot);
 
   return SVN_NO_ERROR;
 }
@@ -513,8 +1234,78 @@ svn_wc__db_pristine_get_sha1(const svn_checksum_t **sha1_checksum,
   return svn_error_trace(svn_sqlite__reset(stmt));
 }
 
+/* Restore the dehydrated pristines in SRC_WCROOT that
+   svn_wc__db_pristine_transfer() would copy from SRC_RELPATH to DST_WCROOT.
+   Texts DST_WCROOT already has are left alone.
+
+   This runs before the transfer's txn on DST_WCROOT, so that the txn isn't
+   held while texts are copied or fetched from the repository. */
+static svn_error_t *
+hydrate_transfer_pristines(svn_wc__db_t *db,
+                           svn_wc__db_wcroot_t *src_wcroot,
+                           const char *src_relpath,
+                           svn_wc__db_wcroot_t *dst_wcroot,
+                           svn_cancel_func_t cancel_func,
+                           void *cancel_baton,
+                           apr_pool_t *scratch_pool)
+{
+  svn_sqlite__stmt_t *stmt;
+  svn_boolean_t got_row;
+  apr_array_header_t *checksums;
+  apr_pool_t *iterpool;
+  int i;
+
+  checksums = apr_array_make(scratch_pool, 16, sizeof(svn_checksum_t *));
+
+  SVN_ERR(svn_sqlite__get_statement(&stmt, src_wcroot->sdb,
+                                    STMT_SELECT_COPY_PRISTINES));
+  SVN_ERR(svn_sqlite__bindf(stmt, "is", src_wcroot->wc_id, src_relpath));
+  SVN_ERR(svn_sqlite__step(&got_row, stmt));
+  while (got_row)
+    {
+      const svn_checksum_t *checksum;
+
+      SVN_ERR(svn_sqlite__column_checksum(&checksum, stmt, 0, scratch_pool));
+      APR_ARRAY_PUSH(checksums, const svn_checksum_t *) = checksum;
+
+      SVN_ERR(svn_sqlite__step(&got_row, stmt));
+    }
+  SVN_ERR(svn_sqlite__reset(stmt));
+
+  iterpool = svn_pool_create(scratch_pool);
+  for (i = 0; i < checksums->nelts; i++)
+    {
+      const svn_checksum_t *checksum
+        = APR_ARRAY_IDX(checksums, i, const svn_checksum_t *);
+      const char *src_abspath;
+      svn_boolean_t have_row;
+
+      svn_pool_clear(iterpool);
+
+      if (cancel_func)
+        SVN_ERR(cancel_func(cancel_baton));
+
+      SVN_ERR(svn_sqlite__get_statement(&stmt, dst_wcroot->sdb,
+                                        STMT_SELECT_PRISTINE));
+      SVN_ERR(svn_sqlite__bind_checksum(stmt, 1, checksum, iterpool));
+      SVN_ERR(svn_sqlite__step(&have_row, stmt));
+      SVN_ERR(svn_sqlite__reset(stmt));
+      if (have_row)
+        continue;
+
+      SVN_ERR(get_pristine_fname(&src_abspath, src_wcroot->abspath, checksum,
+                                 iterpool, iterpool));
+      SVN_ERR(pristine_hydrate(db, src_wcroot, src_relpath, checksum,
+                               src_abspath, iterpool));
+    }
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
 /* Handle the moving of a pristine from SRC_WCROOT to DST_WCROOT. The existing
-   pristine in SRC_WCROOT is described by CHECKSUM, MD5_CHECKSUM and SIZE */
+   pristine in SRC_WCROOT is described by CHECKSUM, MD5_CHECKSUM and SIZE.
+   hydrate_transfer_pristines() has restored it, if it was dehydrated. */
 static svn_error_t *
 maybe_transfer_one_pristine(svn_wc__db_wcroot_t *src_wcroot,
                             svn_wc__db_wcroot_t *dst_wcroot,
@@ -527,7 +1318,7 @@ maybe_transfer_one_pristine(svn_wc__db_wcroot_t *src_wcroot,
 {
   const char *pristine_abspath;
   svn_sqlite__stmt_t *stmt;
-  svn_stream_t *src_stream;
+  apr_file_t *src_file;
   svn_stream_t *dst_stream;
   const char *tmp_abspath;
   const char *src_abspath;
@@ -555,14 +1346,20 @@ maybe_transfer_one_pristine(svn_wc__db_wcroot_t *src_wcroot,
   SVN_ERR(get_pristine_fname(&src_abspath, src_wcroot->abspath, checksum,
                              scratch_pool, scratch_pool));
 
-  SVN_ERR(svn_stream_open_readonly(&src_stream, src_abspath,
-                                   scratch_pool, scratch_pool));
-
-  /* ### Should we verify the SHA1 or MD5 here, or is that too expensive? */
-  SVN_ERR(svn_stream_copy3(src_stream, dst_stream,
-                           cancel_func, cancel_baton,
+  SVN_ERR(svn_io_file_open(&src_file, src_abspath, APR_READ, APR_OS_DEFAULT,
                            scratch_pool));
 
+  if (cancel_func)
+    SVN_ERR(cancel_func(cancel_baton));
+
+  /* ### Should we verify the SHA1 or MD5 here, or is that too expensive?
+     Copy without reading the text where the file system allows it. */
+  err = svn_io__copy_file_contents(src_file, svn_stream__aprfile(dst_stream),
+                                   scratch_pool);
+  err = svn_error_compose_create(err, svn_io_file_close(src_file,
+                                                        scratch_pool));
+  SVN_ERR(svn_error_compose_create(err, svn_stream_close(dst_stream)));
+
   SVN_ERR(get_pristine_fname(&pristine_abspath, dst_wcroot->abspath, checksum,
                              scratch_pool, scratch_pool));
 
@@ -676,6 +1473,10 @@ svn_wc__db_pristine_transfer(svn_wc__db_t *db,
       return SVN_NO_ERROR; /* Nothing to transfer */
     }
 
+  SVN_ERR(hydrate_transfer_pristines(db, src_wcroot, src_relpath, dst_wcroot,
+                                     cancel_func, cancel_baton,
+                                     scratch_pool));
+
   SVN_WC__DB_WITH_TXN(
     pristine_transfer_txn(src_wcroot, dst_wcroot, src_relpath,
                           cancel_func, cancel_baton, scratch_pool),
@@ -713,17 +1514,8 @@ pristine_remove_if_unreferenced_txn(svn_sqlite__db_t *sdb,
   /* If we removed the DB row, then remove the file. */
   if (affected_rows > 0)
     {
-      /* If the file is not present, something has gone wrong, but at this
-       * point it no longer matters.  In a debug build, raise an error, but
-       * in a release build, it is more helpful to ignore it and continue. */
-#ifdef SVN_DEBUG
-      svn_boolean_t ignore_enoent = FALSE;
-#else
-      svn_boolean_t ignore_enoent = TRUE;
-#endif
-
-      SVN_ERR(svn_io_remove_file2(pristine_abspath, ignore_enoent,
-                                  scratch_pool));
+      /* The file is not present if it has been dehydrated. */
+      SVN_ERR(svn_io_remove_file2(pristine_abspath, TRUE, scratch_pool));
     }
 
   return SVN_NO_ERROR;
@@ -746,10 +1538,10 @@ pristine_remove_if_unreferenced(svn_wc__db_wcroot_t *wcroot,
 
   /* Ensure the SQL txn has at least a 'RESERVED' lock before we start looking
    * at the disk, to ensure no concurrent pristine install/delete txn. */
-  SVN_SQLITE__WITH_IMMEDIATE_TXN(
+  WITH_PRISTINE_TXN(
     pristine_remove_if_unreferenced_txn(
       wcroot->sdb, wcroot, sha1_checksum, pristine_abspath, scratch_pool),
-    wcroot->sdb);
+    wcroot);
 
   return SVN_NO_ERROR;
 }
@@ -863,6 +1655,68 @@ pristine_cleanup_wcroot(svn_wc__db_wcroot_t *wcroot,
       svn_error_compose_create(err, svn_sqlite__reset(stmt)));
 }
 
+/* Remove all pristine texts from the shared pristine store at STORE_ABSPATH
+ * that are no longer linked to by any working copy.
+ */
+static svn_error_t *
+pristine_cleanup_shared(const char *store_abspath,
+                        apr_pool_t *scratch_pool)
+{
+  apr_hash_t *subdirs;
+  apr_hash_index_t *hi;
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+
+  SVN_ERR(lock_shared_store(store_abspath, scratch_pool));
+  SVN_ERR(svn_io_get_dirents3(&subdirs, store_abspath, TRUE,
+                              scratch_pool, scratch_pool));
+
+  for (hi = apr_hash_first(scratch_pool, subdirs); hi; hi = apr_hash_next(hi))
+    {
+      const char *name = apr_hash_this_key(hi);
+      const svn_io_dirent2_t *dirent = apr_hash_this_val(hi);
+      const char *subdir_abspath;
+      apr_hash_t *files;
+      apr_hash_index_t *hi2;
+
+      if (dirent->kind != svn_node_dir || strlen(name) != 2)
+        continue;
+
+      svn_pool_clear(iterpool);
+
+      subdir_abspath = svn_dirent_join(store_abspath, name, iterpool);
+      SVN_ERR(svn_io_get_dirents3(&files, subdir_abspath, TRUE,
+                                  iterpool, iterpool));
+
+      for (hi2 = apr_hash_first(iterpool, files); hi2;
+           hi2 = apr_hash_next(hi2))
+        {
+          const char *file_name = apr_hash_this_key(hi2);
+          apr_size_t len = strlen(file_name);
+          const char *file_abspath;
+          apr_finfo_t finfo;
+
+          if (len <= sizeof(PRISTINE_STORAGE_EXT) - 1
+              || strcmp(file_name + len - (sizeof(PRISTINE_STORAGE_EXT) - 1),
+                        PRISTINE_STORAGE_EXT) != 0)
+            continue;
+
+          file_abspath = svn_dirent_join(subdir_abspath, file_name, iterpool);
+          SVN_ERR(svn_io_stat(&finfo, file_abspath,
+                              APR_FINFO_TYPE | APR_FINFO_NLINK, iterpool));
+
+          /* Only the link in the store itself is left. */
+          if (finfo.filetype == APR_REG
+              && (finfo.valid & APR_FINFO_NLINK)
+              && finfo.nlink == 1)
+            SVN_ERR(svn_io_remove_file2(file_abspath, TRUE, iterpool));
+        }
+    }
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
 svn_error_t *
 svn_wc__db_pristine_cleanup(svn_wc__db_t *db,
                             const char *wri_abspath,
@@ -879,6 +1733,10 @@ svn_wc__db_pristine_cleanup(svn_wc__db_t *db,
 
   SVN_ERR(pristine_cleanup_wcroot(wcroot, scratch_pool));
 
+  if (db->shared_pristine_abspath)
+    SVN_ERR(pristine_cleanup_shared(db->shared_pristine_abspath,
+                                    scratch_pool));
+
   return SVN_NO_ERROR;
 }
 
@@ -52,6 +52,29 @@ struct svn_wc__db_t {
   /* Busy timeout in ms., 0 for the libsvn_subr default. */
   apr_int32_t timeout;
 
+  /* Should we let Sqlite use a write-ahead log (unless EXCLUSIVE is set or
+     the database is on a network file system), switch back to the rollback
+     journal or keep whatever the database uses (svn_tristate_unknown)? */
+  svn_tristate_t wal;
+
+  /* WAL checkpoint interval in pages, Sqlite cache size in KiB and mmap
+     size in bytes; -1 for the Sqlite defaults. */
+  int wal_autocheckpoint;
+  apr_int64_t cache_size;
+  apr_int64_t mmap_size;
+
+  /* The host-wide pristine store shared by working copies, or NULL. */
+  const char *shared_pristine_abspath;
+
+  /* Should svn_wc__db_init() create working copies in lazy-pristines
+     mode?  See svn_wc__db_pristine_dehydrate(). */
+  svn_boolean_t lazy_pristines;
+
+  /* How to fetch pristine texts that aren't stored anywhere else from the
+     repository, or NULL. */
+  svn_wc__fetch_pristine_func_t fetch_pristine_func;
+  void *fetch_pristine_baton;
+
   /* Map a given working copy directory to its relevant data.
      const char *local_abspath -> svn_wc__db_wcroot_t *wcroot  */
   apr_hash_t *dir_data;
@@ -107,6 +130,12 @@ typedef struct svn_wc__db_wcroot_t {
      const char *local_abspath -> svn_wc_adm_access_t *adm_access */
   apr_hash_t *access_cache;
 
+  /* TRUE while svn_wc__db_batch_begin() keeps an immediate transaction
+     open on SDB, which collects all changes until the batch gets flushed.
+     Operations that need a transaction of their own must use savepoints
+     while this is set.  */
+  svn_boolean_t batching;
+
 } svn_wc__db_wcroot_t;
 
 
@@ -155,7 +184,7 @@ svn_wc__db_verify_no_work(svn_sqlite__db_t *sdb);
 /* Assert that the given WCROOT is usable.
    NOTE: the expression is multiply-evaluated!!  */
 #define VERIFY_USABLE_WCROOT(wcroot)  SVN_ERR_ASSERT(               \
-    (wcroot) != NULL && (wcroot)->format == SVN_WC__VERSION)
+    (wcroot) != NULL && SVN_WC__IS_CURRENT_FORMAT((wcroot)->format))
 
 /* Check if the WCROOT is usable for light db operations such as path
    calculations */
@@ -216,6 +245,18 @@ svn_wc__db_util_open_db(svn_sqlite__db_t **sdb,
                         apr_pool_t *result_pool,
                         apr_pool_t *scratch_pool);
 
+/* Apply the journal mode and cache settings of DB to the freshly opened
+ * connection SDB to the WC database in DIR_ABSPATH.  Switch to write-ahead
+ * logging only if DB asks for it, EXCLUSIVE is not set and DIR_ABSPATH is
+ * not on a network file system.  Use SCRATCH_POOL for temporary
+ * allocations. */
+svn_error_t *
+svn_wc__db_util_tune_db(svn_sqlite__db_t *sdb,
+                        svn_wc__db_t *db,
+                        const char *dir_abspath,
+                        svn_boolean_t exclusive,
+                        apr_pool_t *scratch_pool);
+
 /* Like svn_wc__db_wq_add() but taking WCROOT */
 svn_error_t *
 svn_wc__db_wq_add_internal(svn_wc__db_wcroot_t *wcroot,
@@ -38,6 +38,8 @@
 #define SVN_WC__I_AM_WC_DB
 
 #include "svn_dirent_uri.h"
+#include "svn_io.h"
+#include "private/svn_io_private.h"
 #include "private/svn_sqlite.h"
 
 #include "wc.h"
@@ -152,3 +154,37 @@ svn_wc__db_util_open_db(svn_sqlite__db_t **sdb,
   return SVN_NO_ERROR;
 }
 
+
+svn_error_t *
+svn_wc__db_util_tune_db(svn_sqlite__db_t *sdb,
+                        svn_wc__db_t *db,
+                        const char *dir_abspath,
+                        svn_boolean_t exclusive,
+                        apr_pool_t *scratch_pool)
+{
+  svn_tristate_t enable_wal = db->wal;
+  svn_boolean_t wal;
+
+  /* All connections to a database in WAL mode share memory through a
+     file next to it, which doesn't work on network file systems. */
+  if (enable_wal == svn_tristate_true)
+    {
+      svn_boolean_t remote;
+
+      SVN_ERR(svn_io__is_remote_file_system(&remote, dir_abspath,
+                                            scratch_pool));
+      if (remote)
+        enable_wal = svn_tristate_false;
+    }
+
+  /* With exclusive locking the journal mode has already been set. */
+  if (!exclusive)
+    SVN_ERR(svn_sqlite__set_wal(&wal, sdb, enable_wal,
+                                db->wal_autocheckpoint, scratch_pool));
+
+  SVN_ERR(svn_sqlite__set_cache_size(sdb, db->cache_size, db->mmap_size,
+                                     scratch_pool));
+
+  return SVN_NO_ERROR;
+}
+
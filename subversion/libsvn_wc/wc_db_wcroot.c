@@ -233,6 +233,11 @@ svn_wc__db_open(svn_wc__db_t **db,
   (*db)->enforce_empty_wq = enforce_empty_wq;
   (*db)->dir_data = apr_hash_make(result_pool);
 
+  (*db)->wal = svn_tristate_unknown;
+  (*db)->wal_autocheckpoint = -1;
+  (*db)->cache_size = -1;
+  (*db)->mmap_size = -1;
+
   (*db)->state_pool = result_pool;
 
   /* Don't need to initialize (*db)->parse_cache, due to the calloc above */
@@ -241,6 +246,9 @@ svn_wc__db_open(svn_wc__db_t **db,
       svn_error_t *err;
       svn_boolean_t sqlite_exclusive = FALSE;
       apr_int64_t timeout;
+      apr_int64_t value;
+      const char *journal_mode;
+      const char *shared_pristine_store;
 
       err = svn_config_get_bool(config, &sqlite_exclusive,
                                 SVN_CONFIG_SECTION_WORKING_COPY,
@@ -261,6 +269,63 @@ svn_wc__db_open(svn_wc__db_t **db,
         svn_error_clear(err);
       else
         (*db)->timeout = (apr_int32_t)timeout;
+
+      svn_config_get(config, &journal_mode,
+                     SVN_CONFIG_SECTION_WORKING_COPY,
+                     SVN_CONFIG_OPTION_SQLITE_JOURNAL_MODE,
+                     "default");
+      if (svn_cstring_casecmp(journal_mode, "wal") == 0)
+        (*db)->wal = svn_tristate_true;
+      else if (svn_cstring_casecmp(journal_mode, "truncate") == 0)
+        (*db)->wal = svn_tristate_false;
+
+      err = svn_config_get_int64(config, &value,
+                                 SVN_CONFIG_SECTION_WORKING_COPY,
+                                 SVN_CONFIG_OPTION_SQLITE_WAL_AUTOCHECKPOINT,
+                                 -1);
+      if (err || value < 0 || value > APR_INT32_MAX)
+        svn_error_clear(err);
+      else
+        (*db)->wal_autocheckpoint = (int)value;
+
+      err = svn_config_get_int64(config, &value,
+                                 SVN_CONFIG_SECTION_WORKING_COPY,
+                                 SVN_CONFIG_OPTION_SQLITE_CACHE_SIZE,
+                                 -1);
+      if (err || value < 0)
+        svn_error_clear(err);
+      else
+        (*db)->cache_size = value;
+
+      err = svn_config_get_int64(config, &value,
+                                 SVN_CONFIG_SECTION_WORKING_COPY,
+                                 SVN_CONFIG_OPTION_SQLITE_MMAP_SIZE,
+                                 -1);
+      if (err || value < 0)
+        svn_error_clear(err);
+      else
+        (*db)->mmap_size = value;
+
+      svn_config_get(config, &shared_pristine_store,
+                     SVN_CONFIG_SECTION_WORKING_COPY,
+                     SVN_CONFIG_OPTION_SHARED_PRISTINE_STORE,
+                     NULL);
+      if (shared_pristine_store && *shared_pristine_store)
+        SVN_ERR(svn_dirent_get_absolute(
+                  &(*db)->shared_pristine_abspath,
+                  svn_dirent_internal_style(shared_pristine_store,
+                                            scratch_pool),
+                  result_pool));
+
+      err = svn_config_get_bool(config, &(*db)->lazy_pristines,
+                                SVN_CONFIG_SECTION_WORKING_COPY,
+                                SVN_CONFIG_OPTION_LAZY_PRISTINES,
+                                FALSE);
+      if (err)
+        {
+          svn_error_clear(err);
+          (*db)->lazy_pristines = FALSE;
+        }
     }
 
   return SVN_NO_ERROR;
@@ -321,7 +386,7 @@ svn_wc__db_pdh_create_wcroot(svn_wc__db_wcroot_t **wcroot,
     }
 
   /* If this working copy is from a future version, then bail out.  */
-  if (format > SVN_WC__VERSION)
+  if (format > SVN_WC__LAZY_PRISTINES_VERSION)
     {
       return svn_error_createf(
         SVN_ERR_WC_UNSUPPORTED_FORMAT, NULL,
@@ -377,6 +442,7 @@ svn_wc__db_pdh_create_wcroot(svn_wc__db_wcroot_t **wcroot,
   (*wcroot)->owned_locks = apr_array_make(result_pool, 8,
                                           sizeof(svn_wc__db_wclock_t));
   (*wcroot)->access_cache = apr_hash_make(result_pool);
+  (*wcroot)->batching = FALSE;
 
   /* SDB will be NULL for pre-NG working copies. We only need to run a
      cleanup when the SDB is present.  */
@@ -645,6 +711,9 @@ svn_wc__db_wcroot_parse_local_abspath(svn_wc__db_wcroot_t **wcroot,
                                         db->state_pool, scratch_pool);
           if (err == NULL)
             {
+              SVN_ERR(svn_wc__db_util_tune_db(sdb, db, local_abspath,
+                                              db->exclusive, scratch_pool));
+
 #ifdef SVN_DEBUG
               /* Install self-verification trigger statements. */
               err = svn_sqlite__exec_statements(sdb,
@@ -23,6 +23,11 @@
 
 #include <apr_pools.h>
 
+#if APR_HAS_THREADS
+#include <apr_thread_cond.h>
+#include <apr_thread_mutex.h>
+#endif
+
 #include "svn_private_config.h"
 #include "svn_types.h"
 #include "svn_pools.h"
@@ -38,8 +43,10 @@
 #include "conflicts.h"
 #include "translate.h"
 
+#include "private/svn_atomic.h"
 #include "private/svn_io_private.h"
 #include "private/svn_skel.h"
+#include "private/svn_thread_pool.h"
 
 
 /* Workqueue operation names.  */
@@ -77,12 +84,11 @@ struct work_item_dispatch {
                        apr_pool_t *scratch_pool);
 };
 
-/* Forward definition */
-static svn_error_t *
-get_and_record_fileinfo(work_item_baton_t *wqb,
-                        const char *local_abspath,
-                        svn_boolean_t ignore_enoent,
-                        apr_pool_t *scratch_pool);
+/* Forward definitions */
+static void
+record_fileinfo(work_item_baton_t *wqb,
+                const char *local_abspath,
+                const svn_io_dirent2_t *dirent);
 
 /* ------------------------------------------------------------------------ */
 /* OP_REMOVE_BASE  */
@@ -445,60 +451,85 @@ svn_wc__wq_build_postupgrade(svn_skel_t **work_item,
 
 /* OP_FILE_INSTALL */
 
-/* Process the OP_FILE_INSTALL work item WORK_ITEM.
- * See svn_wc__wq_build_file_install() which generates this work item.
- * Implements (struct work_item_dispatch).func. */
-static svn_error_t *
-run_file_install(work_item_baton_t *wqb,
-                 svn_wc__db_t *db,
-                 const svn_skel_t *work_item,
-                 const char *wri_abspath,
-                 svn_cancel_func_t cancel_func,
-                 void *cancel_baton,
-                 apr_pool_t *scratch_pool)
+/* Everything needed to install a file, as gathered from the DB by
+   prepare_file_install().  install_file() only uses the file system,
+   so it may run in parallel to other installations.  */
+typedef struct file_install_t
 {
-  const svn_skel_t *arg1 = work_item->children->next;
-  const svn_skel_t *arg4 = arg1->next->next->next;
-  const char *local_relpath;
+  /* The file to install and where to install it from.  */
   const char *local_abspath;
-  svn_boolean_t use_commit_times;
-  svn_boolean_t record_fileinfo;
+  const char *source_abspath;
+
+  /* How to translate the contents.  */
   svn_boolean_t special;
-  svn_stream_t *src_stream;
   svn_subst_eol_style_t style;
   const char *eol;
   apr_hash_t *keywords;
+
+  /* Where to create the temporary file.  Unused for special files.  */
   const char *temp_dir_abspath;
-  svn_stream_t *dst_stream;
+
+  /* What to do with the installed file.  SET_TIME is 0 if the timestamp
+     should be left alone.  */
+  svn_boolean_t set_executable;
+  svn_boolean_t set_read_only;
+  apr_time_t set_time;
+  svn_boolean_t record_fileinfo;
+
+  /* Set by install_file() if RECORD_FILEINFO is set and a file has been
+     installed, otherwise NULL.  */
+  const svn_io_dirent2_t *dirent;
+
+  /* The pristine text that the file is an untranslated copy of, or NULL.
+     See svn_wc__db_pristine_dehydrate().  */
+  const svn_checksum_t *dehydrate_checksum;
+} file_install_t;
+
+/* Read everything needed to process the OP_FILE_INSTALL work item
+   WORK_ITEM from DB and return it in *INSTALL, allocated in RESULT_POOL.
+   Use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+prepare_file_install(file_install_t **install,
+                     svn_wc__db_t *db,
+                     const svn_skel_t *work_item,
+                     const char *wri_abspath,
+                     apr_pool_t *result_pool,
+                     apr_pool_t *scratch_pool)
+{
+  const svn_skel_t *arg1 = work_item->children->next;
+  const svn_skel_t *arg4 = arg1->next->next->next;
+  file_install_t *fi = apr_pcalloc(result_pool, sizeof(*fi));
+  const char *local_relpath;
+  svn_boolean_t use_commit_times;
   apr_int64_t val;
   const char *wcroot_abspath;
-  const char *source_abspath;
   const svn_checksum_t *checksum;
   apr_hash_t *props;
   apr_time_t changed_date;
 
   local_relpath = apr_pstrmemdup(scratch_pool, arg1->data, arg1->len);
-  SVN_ERR(svn_wc__db_from_relpath(&local_abspath, db, wri_abspath,
-                                  local_relpath, scratch_pool, scratch_pool));
+  SVN_ERR(svn_wc__db_from_relpath(&fi->local_abspath, db, wri_abspath,
+                                  local_relpath, result_pool, scratch_pool));
 
   SVN_ERR(svn_skel__parse_int(&val, arg1->next, scratch_pool));
   use_commit_times = (val != 0);
   SVN_ERR(svn_skel__parse_int(&val, arg1->next->next, scratch_pool));
-  record_fileinfo = (val != 0);
+  fi->record_fileinfo = (val != 0);
 
   SVN_ERR(svn_wc__db_read_node_install_info(&wcroot_abspath,
                                             &checksum, &props,
                                             &changed_date,
-                                            db, local_abspath, wri_abspath,
-                                            scratch_pool, scratch_pool));
+                                            db, fi->local_abspath,
+                                            wri_abspath,
+                                            result_pool, scratch_pool));
 
   if (arg4 != NULL)
     {
       /* Use the provided path for the source.  */
       local_relpath = apr_pstrmemdup(scratch_pool, arg4->data, arg4->len);
-      SVN_ERR(svn_wc__db_from_relpath(&source_abspath, db, wri_abspath,
+      SVN_ERR(svn_wc__db_from_relpath(&fi->source_abspath, db, wri_abspath,
                                       local_relpath,
-                                      scratch_pool, scratch_pool));
+                                      result_pool, scratch_pool));
     }
   else if (! checksum)
     {
@@ -513,31 +544,97 @@ run_file_install(work_item_baton_t *wqb,
                                _("Can't install '%s' from pristine store, "
                                  "because no checksum is recorded for this "
                                  "file"),
-                               svn_dirent_local_style(local_abspath,
+                               svn_dirent_local_style(fi->local_abspath,
                                                       scratch_pool));
     }
   else
     {
-      SVN_ERR(svn_wc__db_pristine_get_future_path(&source_abspath,
+      SVN_ERR(svn_wc__db_pristine_get_future_path(&fi->source_abspath,
                                                   wcroot_abspath,
                                                   checksum,
-                                                  scratch_pool, scratch_pool));
+                                                  result_pool, scratch_pool));
+      SVN_ERR(svn_wc__db_pristine_hydrate(db, fi->local_abspath, checksum,
+                                          scratch_pool));
     }
 
-  SVN_ERR(svn_stream_open_readonly(&src_stream, source_abspath,
-                                   scratch_pool, scratch_pool));
-
   /* Fetch all the translation bits.  */
-  SVN_ERR(svn_wc__get_translate_info(&style, &eol,
-                                     &keywords,
-                                     &special, db, local_abspath,
+  SVN_ERR(svn_wc__get_translate_info(&fi->style, &fi->eol,
+                                     &fi->keywords,
+                                     &fi->special, db, fi->local_abspath,
                                      props, FALSE,
-                                     scratch_pool, scratch_pool));
-  if (special)
+                                     result_pool, scratch_pool));
+  if (fi->special)
     {
+      /* No need to set exec or read-only flags on special files.  */
+
+      /* ### Shouldn't this record a timestamp and size, etc.? */
+      *install = fi;
+      return SVN_NO_ERROR;
+    }
+
+  /* The pristine can be restored from a plain copy.  */
+  if (arg4 == NULL
+      && !svn_subst_translation_required(fi->style, fi->eol, fi->keywords,
+                                         FALSE /* special */,
+                                         TRUE /* force_eol_check */))
+    fi->dehydrate_checksum = checksum;
+
+  /* Where is the Right Place to put a temp file in this working copy?  */
+  SVN_ERR(svn_wc__db_temp_wcroot_tempdir(&fi->temp_dir_abspath,
+                                         db, wcroot_abspath,
+                                         result_pool, scratch_pool));
+
+#ifndef WIN32
+  fi->set_executable = (props && svn_hash_gets(props, SVN_PROP_EXECUTABLE));
+#endif
+
+  /* Note that this explicitly checks the pristine properties, to make sure
+     that when the lock is locally set (=modification) it is not read only */
+  if (props && svn_hash_gets(props, SVN_PROP_NEEDS_LOCK))
+    {
+      svn_wc__db_status_t status;
+      svn_wc__db_lock_t *lock;
+      SVN_ERR(svn_wc__db_read_info(&status, NULL, NULL, NULL, NULL, NULL, NULL,
+                                   NULL, NULL, NULL, NULL, NULL, NULL, NULL,
+                                   NULL, NULL, &lock, NULL, NULL, NULL, NULL,
+                                   NULL, NULL, NULL, NULL, NULL, NULL,
+                                   db, fi->local_abspath,
+                                   scratch_pool, scratch_pool));
+
+      fi->set_read_only = (!lock && status != svn_wc__db_status_added);
+    }
+
+  if (use_commit_times)
+    fi->set_time = changed_date;
+
+  *install = fi;
+  return SVN_NO_ERROR;
+}
+
+/* Install the file described by FI, which has been filled in by
+   prepare_file_install(), and set FI->DIRENT.  Allocate FI->DIRENT in
+   RESULT_POOL and use SCRATCH_POOL for temporary allocations.
+   This does not use any DB.  */
+static svn_error_t *
+install_file(file_install_t *fi,
+             svn_cancel_func_t cancel_func,
+             void *cancel_baton,
+             apr_pool_t *result_pool,
+             apr_pool_t *scratch_pool)
+{
+  svn_stream_t *src_stream;
+  svn_stream_t *dst_stream;
+
+  fi->dirent = NULL;
+
+  if (fi->special)
+    {
+      SVN_ERR(svn_stream_open_readonly(&src_stream, fi->source_abspath,
+                                       scratch_pool, scratch_pool));
+
       /* When this stream is closed, the resulting special file will
          atomically be created/moved into place at LOCAL_ABSPATH.  */
-      SVN_ERR(svn_subst_create_specialfile(&dst_stream, local_abspath,
+      SVN_ERR(svn_subst_create_specialfile(&dst_stream, fi->local_abspath,
                                            scratch_pool, scratch_pool));
 
       /* Copy the "repository normal" form of the special file into the
@@ -546,87 +643,107 @@ run_file_install(work_item_baton_t *wqb,
                                cancel_func, cancel_baton,
                                scratch_pool));
 
-      /* No need to set exec or read-only flags on special files.  */
-
-      /* ### Shouldn't this record a timestamp and size, etc.? */
       return SVN_NO_ERROR;
     }
 
-  if (svn_subst_translation_required(style, eol, keywords,
+  /* Translate to a temporary file. We don't want the user seeing a partial
+     file, nor let them muck with it while we translate. We may also need to
+     get its TRANSLATED_SIZE before the user can monkey it.  */
+  SVN_ERR(svn_stream__create_for_install(&dst_stream, fi->temp_dir_abspath,
+                                         scratch_pool, scratch_pool));
+
+  if (svn_subst_translation_required(fi->style, fi->eol, fi->keywords,
                                      FALSE /* special */,
                                      TRUE /* force_eol_check */))
     {
+      SVN_ERR(svn_stream_open_readonly(&src_stream, fi->source_abspath,
+                                       scratch_pool, scratch_pool));
+
       /* Wrap it in a translating (expanding) stream.  */
-      src_stream = svn_subst_stream_translated(src_stream, eol,
+      src_stream = svn_subst_stream_translated(src_stream, fi->eol,
                                                TRUE /* repair */,
-                                               keywords,
+                                               fi->keywords,
                                                TRUE /* expand */,
                                                scratch_pool);
-    }
 
-  /* Where is the Right Place to put a temp file in this working copy?  */
-  SVN_ERR(svn_wc__db_temp_wcroot_tempdir(&temp_dir_abspath,
-                                         db, wcroot_abspath,
-                                         scratch_pool, scratch_pool));
+      /* Copy from the source to the dest, translating as we go. This will
+         also close both streams.  */
+      SVN_ERR(svn_stream_copy3(src_stream, dst_stream,
+                               cancel_func, cancel_baton,
+                               scratch_pool));
+    }
+  else
+    {
+      apr_file_t *src_file;
 
-  /* Translate to a temporary file. We don't want the user seeing a partial
-     file, nor let them muck with it while we translate. We may also need to
-     get its TRANSLATED_SIZE before the user can monkey it.  */
-  SVN_ERR(svn_stream__create_for_install(&dst_stream, temp_dir_abspath,
-                                         scratch_pool, scratch_pool));
+      if (cancel_func)
+        SVN_ERR(cancel_func(cancel_baton));
 
-  /* Copy from the source to the dest, translating as we go. This will also
-     close both streams.  */
-  SVN_ERR(svn_stream_copy3(src_stream, dst_stream,
-                           cancel_func, cancel_baton,
-                           scratch_pool));
+      /* The working file is a plain copy of the pristine, which the file
+         system may be able to make without copying any data. */
+      SVN_ERR(svn_io_file_open(&src_file, fi->source_abspath, APR_READ,
+                               APR_OS_DEFAULT, scratch_pool));
+      SVN_ERR(svn_error_compose_create(
+                svn_io__copy_file_contents(src_file,
+                                           svn_stream__aprfile(dst_stream),
+                                           scratch_pool),
+                svn_io_file_close(src_file, scratch_pool)));
+    }
 
   /* All done. Move the file into place.  */
   /* With a single db we might want to install files in a missing directory.
      Simply trying this scenario on error won't do any harm and at least
      one user reported this problem on IRC. */
-  SVN_ERR(svn_stream__install_stream(dst_stream, local_abspath,
+  SVN_ERR(svn_stream__install_stream(dst_stream, fi->local_abspath,
                                      TRUE /* make_parents*/, scratch_pool));
 
   /* Tweak the on-disk file according to its properties.  */
-#ifndef WIN32
-  if (props && svn_hash_gets(props, SVN_PROP_EXECUTABLE))
-    SVN_ERR(svn_io_set_file_executable(local_abspath, TRUE, FALSE,
+  if (fi->set_executable)
+    SVN_ERR(svn_io_set_file_executable(fi->local_abspath, TRUE, FALSE,
                                        scratch_pool));
-#endif
-
-  /* Note that this explicitly checks the pristine properties, to make sure
-     that when the lock is locally set (=modification) it is not read only */
-  if (props && svn_hash_gets(props, SVN_PROP_NEEDS_LOCK))
-    {
-      svn_wc__db_status_t status;
-      svn_wc__db_lock_t *lock;
-      SVN_ERR(svn_wc__db_read_info(&status, NULL, NULL, NULL, NULL, NULL, NULL,
-                                   NULL, NULL, NULL, NULL, NULL, NULL, NULL,
-                                   NULL, NULL, &lock, NULL, NULL, NULL, NULL,
-                                   NULL, NULL, NULL, NULL, NULL, NULL,
-                                   db, local_abspath,
-                                   scratch_pool, scratch_pool));
 
-      if (!lock && status != svn_wc__db_status_added)
-        SVN_ERR(svn_io_set_file_read_only(local_abspath, FALSE, scratch_pool));
-    }
+  if (fi->set_read_only)
+    SVN_ERR(svn_io_set_file_read_only(fi->local_abspath, FALSE,
+                                      scratch_pool));
 
-  if (use_commit_times)
-    {
-      if (changed_date)
-        SVN_ERR(svn_io_set_file_affected_time(changed_date,
-                                              local_abspath,
-                                              scratch_pool));
-    }
+  if (fi->set_time)
+    SVN_ERR(svn_io_set_file_affected_time(fi->set_time, fi->local_abspath,
+                                          scratch_pool));
 
   /* ### this should happen before we rename the file into place.  */
-  if (record_fileinfo)
-    {
-      SVN_ERR(get_and_record_fileinfo(wqb, local_abspath,
-                                      FALSE /* ignore_enoent */,
-                                      scratch_pool));
-    }
+  if (fi->record_fileinfo)
+    SVN_ERR(svn_io_stat_dirent2(&fi->dirent, fi->local_abspath,
+                                FALSE, FALSE, result_pool, scratch_pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* Process the OP_FILE_INSTALL work item WORK_ITEM.
+ * See svn_wc__wq_build_file_install() which generates this work item.
+ * Implements (struct work_item_dispatch).func. */
+static svn_error_t *
+run_file_install(work_item_baton_t *wqb,
+                 svn_wc__db_t *db,
+                 const svn_skel_t *work_item,
+                 const char *wri_abspath,
+                 svn_cancel_func_t cancel_func,
+                 void *cancel_baton,
+                 apr_pool_t *scratch_pool)
+{
+  file_install_t *fi;
+
+  SVN_ERR(prepare_file_install(&fi, db, work_item, wri_abspath,
+                               scratch_pool, scratch_pool));
+  SVN_ERR(install_file(fi, cancel_func, cancel_baton,
+                       scratch_pool, scratch_pool));
+
+  if (fi->dirent)
+    record_fileinfo(wqb, fi->local_abspath, fi->dirent);
+
+  if (fi->dehydrate_checksum)
+    SVN_ERR(svn_wc__db_pristine_dehydrate(db, wri_abspath,
+                                          fi->dehydrate_checksum,
+                                          scratch_pool));
 
   return SVN_NO_ERROR;
 }
@@ -1166,34 +1283,50 @@ svn_wc__wq_build_prej_install(svn_skel_t **work_item,
 
 /* OP_RECORD_FILEINFO  */
 
-
+/* Parse the OP_RECORD_FILEINFO work item WORK_ITEM from the work queue of
+   WRI_ABSPATH in DB.  Set *LOCAL_ABSPATH to the node to record, allocated
+   in RESULT_POOL, and *SET_TIME to the timestamp to set on it first, or 0.
+   Use SCRATCH_POOL for temporary allocations. */
 static svn_error_t *
-run_record_fileinfo(work_item_baton_t *wqb,
-                    svn_wc__db_t *db,
-                    const svn_skel_t *work_item,
-                    const char *wri_abspath,
-                    svn_cancel_func_t cancel_func,
-                    void *cancel_baton,
-                    apr_pool_t *scratch_pool)
+parse_record_fileinfo(const char **local_abspath,
+                      apr_time_t *set_time,
+                      svn_wc__db_t *db,
+                      const svn_skel_t *work_item,
+                      const char *wri_abspath,
+                      apr_pool_t *result_pool,
+                      apr_pool_t *scratch_pool)
 {
   const svn_skel_t *arg1 = work_item->children->next;
   const char *local_relpath;
-  const char *local_abspath;
-  apr_time_t set_time = 0;
 
   local_relpath = apr_pstrmemdup(scratch_pool, arg1->data, arg1->len);
 
-  SVN_ERR(svn_wc__db_from_relpath(&local_abspath, db, wri_abspath,
-                                  local_relpath, scratch_pool, scratch_pool));
+  SVN_ERR(svn_wc__db_from_relpath(local_abspath, db, wri_abspath,
+                                  local_relpath, result_pool, scratch_pool));
 
+  *set_time = 0;
   if (arg1->next)
     {
       apr_int64_t val;
 
       SVN_ERR(svn_skel__parse_int(&val, arg1->next, scratch_pool));
-      set_time = (apr_time_t)val;
+      *set_time = (apr_time_t)val;
     }
 
+  return SVN_NO_ERROR;
+}
+
+/* Set the timestamp of LOCAL_ABSPATH to SET_TIME, unless that is 0, and
+   return its file info in *DIRENT, allocated in RESULT_POOL.  Only uses
+   the file system, so this may run in parallel to other file operations.
+   Use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+set_time_and_stat(const svn_io_dirent2_t **dirent,
+                  const char *local_abspath,
+                  apr_time_t set_time,
+                  apr_pool_t *result_pool,
+                  apr_pool_t *scratch_pool)
+{
   if (set_time != 0)
     {
       svn_node_kind_t kind;
@@ -1213,10 +1346,33 @@ run_record_fileinfo(work_item_baton_t *wqb,
          filesystem might have a different timestamp granularity */
     }
 
+  return svn_error_trace(svn_io_stat_dirent2(dirent, local_abspath, FALSE,
+                                             TRUE /* ignore_enoent */,
+                                             result_pool, scratch_pool));
+}
 
-  return svn_error_trace(get_and_record_fileinfo(wqb, local_abspath,
-                                                 TRUE /* ignore_enoent */,
-                                                 scratch_pool));
+static svn_error_t *
+run_record_fileinfo(work_item_baton_t *wqb,
+                    svn_wc__db_t *db,
+                    const svn_skel_t *work_item,
+                    const char *wri_abspath,
+                    svn_cancel_func_t cancel_func,
+                    void *cancel_baton,
+                    apr_pool_t *scratch_pool)
+{
+  const char *local_abspath;
+  apr_time_t set_time;
+  const svn_io_dirent2_t *dirent;
+
+  SVN_ERR(parse_record_fileinfo(&local_abspath, &set_time, db, work_item,
+                                wri_abspath, scratch_pool, scratch_pool));
+
+  SVN_ERR(set_time_and_stat(&dirent, local_abspath, set_time,
+                            scratch_pool, scratch_pool));
+
+  record_fileinfo(wqb, local_abspath, dirent);
+
+  return SVN_NO_ERROR;
 }
 
 /* ------------------------------------------------------------------------ */
@@ -1474,6 +1630,563 @@ dispatch_work_item(work_item_baton_t *wqb,
 }
 
 
+/* Return ERR, the error of running the work item ID with the data
+   WORK_ITEM in the work queue of WRI_ABSPATH, wrapped in an error
+   that tells the user which item failed.  */
+static svn_error_t *
+work_item_error(svn_error_t *err,
+                const char *wri_abspath,
+                apr_uint64_t id,
+                const svn_skel_t *work_item,
+                apr_pool_t *scratch_pool)
+{
+  const char *skel = svn_skel__unparse(work_item, scratch_pool)->data;
+
+  return svn_error_createf(SVN_ERR_WC_BAD_ADM_LOG, err,
+                           _("Failed to run the WC DB work queue "
+                             "associated with '%s', work item %d %s"),
+                           svn_dirent_local_style(wri_abspath,
+                                                  scratch_pool),
+                           (int)id, skel);
+}
+
+/* ------------------------------------------------------------------------ */
+
+/* PARALLEL FILE OPERATIONS
+
+   A checkout or update queues one OP_FILE_INSTALL work item for every
+   file it receives, usually many of them in a row, and a revert or an
+   interrupted operation leaves long runs of OP_FILE_INSTALL, OP_FILE_REMOVE
+   and OP_RECORD_FILEINFO items for 'svn cleanup' to replay.  None of them
+   needs the DB to touch the file, so a run of consecutive file items is
+   handed to worker threads, while everything that reads from or writes to
+   the DB stays on the thread running the queue:
+
+   * prepare_file_task() is called for every item of the run, in queue
+     order;
+
+   * the workers call run_file_task() and nothing else;
+
+   * once all of them are done, the file infos get recorded and the whole
+     run is marked as completed in a single transaction, just like a
+     single work item.
+
+   Work items have to be restartable anyway, so if any task in a run
+   fails, we report the first failure in queue order and leave all items
+   of the run in the queue.  The tasks of a run may complete in any order,
+   so a run ends before the first item that depends on an earlier one:
+   no path is written twice, read and written, or written below a path
+   that another task of the run touches.  Directory and DB items always
+   end a run. */
+
+/* Maximum number of file operations run in parallel. */
+#define WQ_MAX_PARALLEL_TASKS 64
+
+typedef struct file_batch_t file_batch_t;
+
+/* The work items that may be run by a worker thread. */
+typedef enum file_task_kind_t
+{
+  file_task_install,
+  file_task_remove,
+  file_task_record_fileinfo
+} file_task_kind_t;
+
+/* A file operation for a worker thread. */
+typedef struct file_task_t
+{
+  /* The batch that this task belongs to. */
+  file_batch_t *batch;
+
+  /* Root pool private to this task. */
+  apr_pool_t *pool;
+
+  /* The work item and what prepare_file_task() made of it. */
+  apr_uint64_t id;
+  const svn_skel_t *work_item;
+  file_task_kind_t kind;
+  const char *local_abspath;
+
+  /* What to install, for file_task_install. */
+  file_install_t *install;
+
+  /* The timestamp to set for file_task_record_fileinfo, or 0. */
+  apr_time_t set_time;
+
+  /* Results of run_file_task().  Only valid once the batch completed.
+     DIRENT is NULL if there is no file info to record. */
+  const svn_io_dirent2_t *dirent;
+  svn_error_t *err;
+} file_task_t;
+
+/* A run of file operations. */
+struct file_batch_t
+{
+#if APR_HAS_THREADS
+  apr_thread_mutex_t *mutex;
+  apr_thread_cond_t *cond;
+
+  /* The threads executing the tasks. */
+  apr_thread_pool_t *threads;
+#endif
+
+  /* Number of tasks handed to the thread pool but not completed yet. */
+  int pending;
+
+  /* Set when the batch is being destroyed.  Tasks shall stop ASAP. */
+  volatile svn_atomic_t cancelled;
+
+  /* All file_task_t * of this batch, in queue order. */
+  apr_array_header_t *tasks;
+};
+
+/* Read everything needed to run WORK_ITEM with the identifier ID from the
+   work queue of WRI_ABSPATH in DB without the DB and return it in *TASK,
+   allocated in RESULT_POOL.  Set *TASK to NULL if WORK_ITEM can't be run
+   by a worker thread.  Use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+prepare_file_task(file_task_t **task,
+                  svn_wc__db_t *db,
+                  const char *wri_abspath,
+                  apr_uint64_t id,
+                  const svn_skel_t *work_item,
+                  apr_pool_t *result_pool,
+                  apr_pool_t *scratch_pool)
+{
+  file_task_t *result;
+
+  *task = NULL;
+
+  result = apr_pcalloc(result_pool, sizeof(*result));
+  result->id = id;
+  result->work_item = work_item;
+
+  if (svn_skel__matches_atom(work_item->children, OP_FILE_INSTALL))
+    {
+      result->kind = file_task_install;
+      SVN_ERR(prepare_file_install(&result->install, db, work_item,
+                                   wri_abspath, result_pool, scratch_pool));
+      result->local_abspath = result->install->local_abspath;
+    }
+  else if (svn_skel__matches_atom(work_item->children, OP_FILE_REMOVE))
+    {
+      const svn_skel_t *arg1 = work_item->children->next;
+      const char *local_relpath;
+
+      result->kind = file_task_remove;
+      local_relpath = apr_pstrmemdup(scratch_pool, arg1->data, arg1->len);
+      SVN_ERR(svn_wc__db_from_relpath(&result->local_abspath, db,
+                                      wri_abspath, local_relpath,
+                                      result_pool, scratch_pool));
+    }
+  else if (svn_skel__matches_atom(work_item->children, OP_RECORD_FILEINFO))
+    {
+      result->kind = file_task_record_fileinfo;
+      SVN_ERR(parse_record_fileinfo(&result->local_abspath,
+                                    &result->set_time, db, work_item,
+                                    wri_abspath, result_pool,
+                                    scratch_pool));
+    }
+  else
+    return SVN_NO_ERROR;
+
+  *task = result;
+  return SVN_NO_ERROR;
+}
+
+/* Run TASK without using the DB.  Allocate the results in TASK->POOL. */
+static svn_error_t *
+run_file_task(file_task_t *task,
+              svn_cancel_func_t cancel_func,
+              void *cancel_baton)
+{
+  switch (task->kind)
+    {
+      case file_task_install:
+        SVN_ERR(install_file(task->install, cancel_func, cancel_baton,
+                             task->pool, task->pool));
+        task->dirent = task->install->dirent;
+        break;
+
+      case file_task_remove:
+        /* Remove the path, no worrying if it isn't there.  */
+        SVN_ERR(svn_io_remove_file2(task->local_abspath, TRUE, task->pool));
+        break;
+
+      case file_task_record_fileinfo:
+        SVN_ERR(set_time_and_stat(&task->dirent, task->local_abspath,
+                                  task->set_time, task->pool, task->pool));
+        break;
+
+      default:
+        SVN_ERR_MALFUNCTION();
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Return TRUE if LOCAL_ABSPATH or any of its ancestors is a key in PATHS.
+   Use SCRATCH_POOL for temporary allocations. */
+static svn_boolean_t
+path_or_ancestor_in(apr_hash_t *paths,
+                    const char *local_abspath,
+                    apr_pool_t *scratch_pool)
+{
+  while (TRUE)
+    {
+      if (svn_hash_gets(paths, local_abspath))
+        return TRUE;
+
+      if (svn_dirent_is_root(local_abspath, strlen(local_abspath)))
+        return FALSE;
+
+      local_abspath = svn_dirent_dirname(local_abspath, scratch_pool);
+    }
+}
+
+/* Add all ancestors of LOCAL_ABSPATH to PATHS, allocated in RESULT_POOL.
+   Stop at the first one that PATHS already contains. */
+static void
+add_ancestors(apr_hash_t *paths,
+              const char *local_abspath,
+              apr_pool_t *result_pool)
+{
+  while (!svn_dirent_is_root(local_abspath, strlen(local_abspath)))
+    {
+      local_abspath = svn_dirent_dirname(local_abspath, result_pool);
+      if (svn_hash_gets(paths, local_abspath))
+        break;
+
+      svn_hash_sets(paths, local_abspath, local_abspath);
+    }
+}
+
+#if APR_HAS_THREADS
+
+/* Maximum number of threads in WQ_THREADS, i.e. number of files
+   that we process concurrently throughout the process. */
+#define WQ_MAX_THREADS 16
+
+/* Thread pool to execute the tasks of all work queue runs. */
+static svn_thread_pool__shared_t wq_threads
+  = SVN_THREAD_POOL__SHARED_INIT(WQ_MAX_THREADS,
+                                 N_("Can't create work queue thread pool"));
+
+/* Implements svn_cancel_func_t for the file_batch_t given as BATON.
+   The caller's cancel function may not be thread-safe, so the workers
+   only check whether their batch got abandoned. */
+static svn_error_t *
+file_batch_cancel(void *baton)
+{
+  file_batch_t *batch = baton;
+
+  if (svn_atomic_read(&batch->cancelled))
+    return svn_error_create(SVN_ERR_CANCELLED, NULL, NULL);
+
+  return SVN_NO_ERROR;
+}
+
+/* Thread-pool function executing the file_task_t given as DATA. */
+static void * APR_THREAD_FUNC
+file_task_func(apr_thread_t *tid,
+               void *data)
+{
+  file_task_t *task = data;
+  file_batch_t *batch = task->batch;
+
+  task->err = run_file_task(task, file_batch_cancel, batch);
+
+  apr_thread_mutex_lock(batch->mutex);
+  batch->pending--;
+  apr_thread_cond_broadcast(batch->cond);
+  apr_thread_mutex_unlock(batch->mutex);
+
+  return NULL;
+}
+
+/* Pool cleanup function making sure that no task of the file_batch_t
+   given as DATA is running anymore and releasing all of them. */
+static apr_status_t
+file_batch_cleanup(void *data)
+{
+  file_batch_t *batch = data;
+  int i;
+
+  svn_atomic_set(&batch->cancelled, TRUE);
+
+  apr_thread_mutex_lock(batch->mutex);
+  while (batch->pending)
+    apr_thread_cond_wait(batch->cond, batch->mutex);
+  apr_thread_mutex_unlock(batch->mutex);
+
+  for (i = 0; i < batch->tasks->nelts; i++)
+    {
+      file_task_t *task = APR_ARRAY_IDX(batch->tasks, i, file_task_t *);
+
+      svn_error_clear(task->err);
+      task->err = NULL;
+      svn_pool_destroy(task->pool);
+    }
+
+  return APR_SUCCESS;
+}
+
+#endif
+
+/* Set *BATCH to a new, empty batch of file operations allocated in
+   RESULT_POOL, if this platform allows for running them in parallel.
+   Otherwise, set it to NULL.  All tasks will be waited for and released
+   when RESULT_POOL gets cleaned up. */
+static void
+file_batch_create(file_batch_t **batch,
+                  apr_pool_t *result_pool)
+{
+#if APR_HAS_THREADS
+  file_batch_t *result;
+  apr_thread_pool_t *threads;
+  svn_error_t *err;
+
+  *batch = NULL;
+
+  /* No parallel work if we can't get the worker threads. */
+  err = svn_thread_pool__get_shared(&threads, &wq_threads, NULL,
+                                    result_pool);
+  if (err)
+    {
+      svn_error_clear(err);
+      return;
+    }
+
+  result = apr_pcalloc(result_pool, sizeof(*result));
+  result->threads = threads;
+  if (apr_thread_mutex_create(&result->mutex, APR_THREAD_MUTEX_DEFAULT,
+                              result_pool)
+      || apr_thread_cond_create(&result->cond, result_pool))
+    return;
+
+  result->tasks = apr_array_make(result_pool, WQ_MAX_PARALLEL_TASKS,
+                                 sizeof(file_task_t *));
+
+  /* Register this last, so it runs before the mutex gets destroyed. */
+  apr_pool_cleanup_register(result_pool, result, file_batch_cleanup,
+                            apr_pool_cleanup_null);
+
+  *batch = result;
+#else
+  *batch = NULL;
+#endif
+}
+
+/* Run all tasks of BATCH and wait for them to complete.  Tasks that
+   can't be handed to a worker thread are run by the calling thread. */
+static void
+file_batch_run(file_batch_t *batch)
+{
+#if APR_HAS_THREADS
+  int i;
+
+  for (i = 0; i < batch->tasks->nelts; i++)
+    {
+      file_task_t *task = APR_ARRAY_IDX(batch->tasks, i, file_task_t *);
+      apr_status_t status;
+
+      apr_thread_mutex_lock(batch->mutex);
+      batch->pending++;
+      apr_thread_mutex_unlock(batch->mutex);
+
+      status = apr_thread_pool_push(batch->threads, file_task_func, task,
+                                    APR_THREAD_TASK_PRIORITY_NORMAL, batch);
+      if (status)
+        {
+          apr_thread_mutex_lock(batch->mutex);
+          batch->pending--;
+          apr_thread_mutex_unlock(batch->mutex);
+
+          task->err = run_file_task(task, file_batch_cancel, batch);
+        }
+    }
+
+  apr_thread_mutex_lock(batch->mutex);
+  while (batch->pending)
+    apr_thread_cond_wait(batch->cond, batch->mutex);
+  apr_thread_mutex_unlock(batch->mutex);
+#endif
+}
+
+/* Run the work item WORK_ITEM with the identifier ID from the work queue
+   of WRI_ABSPATH in DB, which must be one of the items accepted by
+   prepare_file_task(), together with the independent file operations
+   queued right after it, if possible.  Set *LAST_ID to the identifier of
+   the last work item that has been run, record the file infos in WQB and
+   return errors like svn_wc__wq_run() does.
+
+   Only call cancel_func with CANCEL_BATON from the calling thread.  Use
+   SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+run_file_tasks(apr_uint64_t *last_id,
+               work_item_baton_t *wqb,
+               svn_wc__db_t *db,
+               const char *wri_abspath,
+               apr_uint64_t id,
+               svn_skel_t *work_item,
+               svn_cancel_func_t cancel_func,
+               void *cancel_baton,
+               apr_pool_t *scratch_pool)
+{
+  file_batch_t *batch;
+  apr_hash_t *written_paths;
+  apr_hash_t *read_paths;
+  apr_hash_t *parents;
+  apr_pool_t *iterpool;
+  svn_error_t *err;
+  int i;
+
+  *last_id = id;
+
+  file_batch_create(&batch, scratch_pool);
+  if (!batch)
+    {
+      err = dispatch_work_item(wqb, db, wri_abspath, work_item,
+                               cancel_func, cancel_baton, scratch_pool);
+      return err ? work_item_error(err, wri_abspath, id, work_item,
+                                   scratch_pool)
+                 : SVN_NO_ERROR;
+    }
+
+  /* Collect the run of independent file operations starting at ID.
+     WRITTEN_PATHS and READ_PATHS contain the paths that the tasks modify
+     and read, PARENTS all ancestors of these paths. */
+  written_paths = apr_hash_make(scratch_pool);
+  read_paths = apr_hash_make(scratch_pool);
+  parents = apr_hash_make(scratch_pool);
+  iterpool = svn_pool_create(scratch_pool);
+  while (work_item)
+    {
+      file_task_t *task;
+      const char *write_abspath = NULL;
+      const char *read_abspath = NULL;
+
+      svn_pool_clear(iterpool);
+
+      err = prepare_file_task(&task, db, wri_abspath, id, work_item,
+                              scratch_pool, iterpool);
+      if (err)
+        {
+          /* Report the problem with the first item right away.  Later
+             ones will get their turn, once the items before them are
+             completed. */
+          if (batch->tasks->nelts == 0)
+            return work_item_error(err, wri_abspath, id, work_item,
+                                   scratch_pool);
+
+          svn_error_clear(err);
+          break;
+        }
+
+      if (!task)
+        break;
+
+      switch (task->kind)
+        {
+          case file_task_install:
+            write_abspath = task->local_abspath;
+            read_abspath = task->install->source_abspath;
+            break;
+
+          case file_task_remove:
+            write_abspath = task->local_abspath;
+            break;
+
+          case file_task_record_fileinfo:
+            if (task->set_time)
+              write_abspath = task->local_abspath;
+            else
+              read_abspath = task->local_abspath;
+            break;
+        }
+
+      /* Don't touch a path twice, nor anything below a path that another
+         task touches, unless all of them only read it.  Several files may
+         share a pristine, for instance. */
+      if (write_abspath
+          && (svn_hash_gets(read_paths, write_abspath)
+              || svn_hash_gets(parents, write_abspath)
+              || path_or_ancestor_in(written_paths, write_abspath,
+                                     iterpool)))
+        break;
+
+      if (read_abspath
+          && path_or_ancestor_in(written_paths, read_abspath, iterpool))
+        break;
+
+      if (write_abspath)
+        {
+          svn_hash_sets(written_paths, write_abspath, task);
+          add_ancestors(parents, write_abspath, scratch_pool);
+        }
+      if (read_abspath)
+        {
+          svn_hash_sets(read_paths, read_abspath, task);
+          add_ancestors(parents, read_abspath, scratch_pool);
+        }
+
+      task->batch = batch;
+      task->pool = svn_pool_create(NULL);
+      APR_ARRAY_PUSH(batch->tasks, file_task_t *) = task;
+
+      if (batch->tasks->nelts == WQ_MAX_PARALLEL_TASKS)
+        break;
+
+      SVN_ERR(svn_wc__db_wq_fetch_after(&id, &work_item, db, wri_abspath,
+                                        id, scratch_pool, iterpool));
+    }
+  svn_pool_destroy(iterpool);
+
+  /* Threads don't pay off for a single file. */
+  if (batch->tasks->nelts == 1)
+    {
+      file_task_t *task = APR_ARRAY_IDX(batch->tasks, 0, file_task_t *);
+
+      task->err = run_file_task(task, cancel_func, cancel_baton);
+    }
+  else
+    {
+      file_batch_run(batch);
+
+      /* The workers didn't check for it. */
+      if (cancel_func)
+        SVN_ERR(cancel_func(cancel_baton));
+    }
+
+  for (i = 0; i < batch->tasks->nelts; i++)
+    {
+      file_task_t *task = APR_ARRAY_IDX(batch->tasks, i, file_task_t *);
+
+      if (task->err)
+        {
+          err = task->err;
+          task->err = NULL;
+
+          return work_item_error(err, wri_abspath, task->id,
+                                 task->work_item, scratch_pool);
+        }
+
+      if (task->dirent)
+        record_fileinfo(wqb, task->local_abspath, task->dirent);
+
+      /* All tasks are done reading their pristines by now. */
+      if (task->install && task->install->dehydrate_checksum)
+        SVN_ERR(svn_wc__db_pristine_dehydrate(db, wri_abspath,
+                                              task->install->dehydrate_checksum,
+                                              scratch_pool));
+
+      *last_id = task->id;
+    }
+
+  return SVN_NO_ERROR;
+}
+
+
 svn_error_t *
 svn_wc__wq_run(svn_wc__db_t *db,
                const char *wri_abspath,
@@ -1486,6 +2199,9 @@ svn_wc__wq_run(svn_wc__db_t *db,
   work_item_baton_t wib = { 0 };
   wib.result_pool = svn_pool_create(scratch_pool);
 
+  /* Work items may only be run once they are safely on disk.  */
+  SVN_ERR(svn_wc__db_batch_flush(db, wri_abspath, scratch_pool));
+
 #ifdef SVN_DEBUG_WORK_QUEUE
   SVN_DBG(("wq_run: wri='%s'\n", wri_abspath));
   {
@@ -1543,21 +2259,25 @@ svn_wc__wq_run(svn_wc__db_t *db,
       if (work_item == NULL)
         break;
 
-      err = dispatch_work_item(&wib, db, wri_abspath, work_item,
-                               cancel_func, cancel_baton, iterpool);
-      if (err)
+      if (svn_skel__matches_atom(work_item->children, OP_FILE_INSTALL)
+          || svn_skel__matches_atom(work_item->children, OP_FILE_REMOVE)
+          || svn_skel__matches_atom(work_item->children, OP_RECORD_FILEINFO))
+        {
+          /* This may run the items following WORK_ITEM as well.  */
+          SVN_ERR(run_file_tasks(&id, &wib, db, wri_abspath,
+                                 id, work_item,
+                                 cancel_func, cancel_baton, iterpool));
+        }
+      else
         {
-          const char *skel = svn_skel__unparse(work_item, scratch_pool)->data;
-
-          return svn_error_createf(SVN_ERR_WC_BAD_ADM_LOG, err,
-                                   _("Failed to run the WC DB work queue "
-                                     "associated with '%s', work item %d %s"),
-                                   svn_dirent_local_style(wri_abspath,
-                                                          scratch_pool),
-                                   (int)id, skel);
+          err = dispatch_work_item(&wib, db, wri_abspath, work_item,
+                                   cancel_func, cancel_baton, iterpool);
+          if (err)
+            return work_item_error(err, wri_abspath, id, work_item,
+                                   scratch_pool);
         }
 
-      /* The work item finished without error. Mark it completed
+      /* The work item(s) finished without error. Mark them completed
          in the next loop.  */
       last_id = id;
     }
@@ -1615,19 +2335,16 @@ svn_wc__wq_merge(svn_skel_t *work_item1,
 }
 
 
-static svn_error_t *
-get_and_record_fileinfo(work_item_baton_t *wqb,
-                        const char *local_abspath,
-                        svn_boolean_t ignore_enoent,
-                        apr_pool_t *scratch_pool)
+/* Remember to record the size and timestamp of DIRENT for the node
+   LOCAL_ABSPATH, when the current work item gets marked as completed.
+   DIRENT is ignored, if it does not describe a file.  */
+static void
+record_fileinfo(work_item_baton_t *wqb,
+                const char *local_abspath,
+                const svn_io_dirent2_t *dirent)
 {
-  const svn_io_dirent2_t *dirent;
-
-  SVN_ERR(svn_io_stat_dirent2(&dirent, local_abspath, FALSE, ignore_enoent,
-                              wqb->result_pool, scratch_pool));
-
   if (dirent->kind != svn_node_file)
-    return SVN_NO_ERROR;
+    return;
 
   wqb->used = TRUE;
 
@@ -1635,7 +2352,5 @@ get_and_record_fileinfo(work_item_baton_t *wqb,
     wqb->record_map = apr_hash_make(wqb->result_pool);
 
   svn_hash_sets(wqb->record_map, apr_pstrdup(wqb->result_pool, local_abspath),
-                dirent);
-
-  return SVN_NO_ERROR;
+                svn_io_dirent2_dup(dirent, wqb->result_pool));
 }
@@ -155,6 +155,7 @@ enum svnadmin__cmdline_options_t
     svnadmin__check_normalization,
     svnadmin__metadata_only,
     svnadmin__no_flush_to_disk,
+    svnadmin__bulk_checkpoint,
     svnadmin__normalize_props,
     svnadmin__exclude,
     svnadmin__include,
@@ -281,6 +282,14 @@ static const apr_getopt_option_t options_table[] =
      N_("disable flushing to disk during the operation\n"
         "                             (faster, but unsafe on power off)")},
 
+    {"bulk-checkpoint", svnadmin__bulk_checkpoint, 1,
+     N_("bulk-load mode for fresh repositories: do not\n"
+        "                             flush individual revisions to disk and batch\n"
+        "                             rep-cache updates; make the repository durable\n"
+        "                             every ARG revisions.  After a crash, run\n"
+        "                             'svnadmin recover' and resume the load.\n"
+        "                             [used for FSFS repositories only]")},
+
     {"normalize-props", svnadmin__normalize_props, 0,
      N_("normalize property values found in the dumpstream\n"
         "                             (currently, only translates non-LF line endings)")},
@@ -459,7 +468,7 @@ static const svn_opt_subcommand_desc3_t cmd_table[] =
     svnadmin__use_pre_commit_hook, svnadmin__use_post_commit_hook,
     svnadmin__parent_dir, svnadmin__normalize_props,
     svnadmin__bypass_prop_validation, 'M',
-    svnadmin__no_flush_to_disk, 'F'},
+    svnadmin__no_flush_to_disk, svnadmin__bulk_checkpoint, 'F'},
    {{'F', N_("read from file ARG instead of stdin")}} },
 
   {"load-revprops", subcommand_load_revprops, {0}, {N_(
@@ -653,6 +662,7 @@ struct svnadmin_opt_state
   svn_boolean_t bypass_prop_validation;             /* --bypass-prop-validation */
   svn_boolean_t ignore_dates;                       /* --ignore-dates */
   svn_boolean_t no_flush_to_disk;                   /* --no-flush-to-disk */
+  int bulk_checkpoint;                              /* --bulk-checkpoint */
   svn_boolean_t normalize_props;                    /* --normalize_props */
   enum svn_repos_load_uuid uuid_action;             /* --ignore-uuid,
                                                        --force-uuid */
@@ -691,6 +701,9 @@ open_repos(svn_repos_t **repos,
                            use_block_read ? "1" : "0");
   svn_hash_sets(fs_config, SVN_FS_CONFIG_NO_FLUSH_TO_DISK,
                            opt_state->no_flush_to_disk ? "1" : "0");
+  if (opt_state->bulk_checkpoint)
+    svn_hash_sets(fs_config, SVN_FS_CONFIG_FSFS_BULK_LOAD_CHECKPOINT,
+                  apr_itoa(pool, opt_state->bulk_checkpoint));
 
   /* now, open the requested repository */
   SVN_ERR(svn_repos_open3(repos, path, fs_config, pool, pool));
@@ -1731,6 +1744,19 @@ subcommand_load(apr_getopt_t *os, void *baton, apr_pool_t *pool)
                            opt_state->quiet ? NULL : repos_notify_handler,
                            feedback_stream, check_cancel, NULL, pool);
 
+  /* In bulk-load mode, make everything we committed durable, even if
+     the load itself failed. */
+  if (opt_state->bulk_checkpoint)
+    {
+      svn_error_t *err2 = svn_fs_ioctl(svn_repos_fs(repos),
+                                       SVN_FS_FS__IOCTL_BULK_LOAD_CHECKPOINT,
+                                       NULL, NULL, NULL, NULL, pool, pool);
+      if (err2 && err2->apr_err == SVN_ERR_FS_UNRECOGNIZED_IOCTL_CODE)
+        svn_error_clear(err2);
+      else
+        err = svn_error_compose_create(err, err2);
+    }
+
   if (svn_error_find_cause(err, SVN_ERR_BAD_PROPERTY_VALUE_EOL))
     {
       return svn_error_quick_wrap(err,
@@ -3158,6 +3184,14 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
       case svnadmin__no_flush_to_disk:
         opt_state.no_flush_to_disk = TRUE;
         break;
+      case svnadmin__bulk_checkpoint:
+        {
+          apr_int64_t val;
+          SVN_ERR(svn_cstring_strtoi64(&val, opt_arg, 1, APR_INT32_MAX, 10));
+
+          opt_state.bulk_checkpoint = (int) val;
+        }
+        break;
       case svnadmin__normalize_props:
         opt_state.normalize_props = TRUE;
         break;
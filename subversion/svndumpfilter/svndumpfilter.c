@@ -106,47 +106,97 @@ write_propdel_to_stringbuf(svn_stringbuf_t **strbuf,
 }
 
 
-/* Compare the node-path PATH with the (const char *) prefixes in PFXLIST.
- * Return TRUE if any prefix is a prefix of PATH (matching whole path
- * components); FALSE otherwise.
- * PATH starts with a '/', as do the (const char *) paths in PREFIXES. */
-/* This function is a duplicate of svnadmin.c:ary_prefix_match(). */
-static svn_boolean_t
-ary_prefix_match(const apr_array_header_t *pfxlist, const char *path)
+/* The user-given path prefixes (or patterns), preprocessed such that
+ * matching a path does not need to scan the whole list.  Dump streams
+ * easily contain millions of nodes and users may give thousands of
+ * prefixes, so the matching costs need to depend on the path depth only.
+ */
+typedef struct prefix_matcher_t
+{
+  /* Does any prefix match all paths, i.e. is there a "/" prefix? */
+  svn_boolean_t match_all;
+
+  /* Set of literal prefixes (const char * -> non-NULL).  A path matches
+   * if it or any of its parent paths is in this set. */
+  apr_hash_t *prefixes;
+
+  /* Set of literal glob patterns, i.e. patterns without any wildcard
+   * (const char * -> non-NULL).  A path matches if it is in this set. */
+  apr_hash_t *exact;
+
+  /* The remaining glob patterns (const char *).  They have to be checked
+   * one-by-one. */
+  apr_array_header_t *patterns;
+} prefix_matcher_t;
+
+/* Return a new matcher for the (const char *) PREFIXES, allocated in
+ * RESULT_POOL.  If GLOB is set, PREFIXES are treated as glob patterns.
+ * All PREFIXES start with a '/'. */
+static prefix_matcher_t *
+prefix_matcher_create(const apr_array_header_t *prefixes,
+                      svn_boolean_t glob,
+                      apr_pool_t *result_pool)
 {
+  prefix_matcher_t *matcher = apr_pcalloc(result_pool, sizeof(*matcher));
   int i;
-  size_t path_len = strlen(path);
 
-  for (i = 0; i < pfxlist->nelts; i++)
+  matcher->prefixes = apr_hash_make(result_pool);
+  matcher->exact = apr_hash_make(result_pool);
+  matcher->patterns = apr_array_make(result_pool, 0, sizeof(const char *));
+
+  for (i = 0; i < prefixes->nelts; i++)
     {
-      const char *pfx = APR_ARRAY_IDX(pfxlist, i, const char *);
-      size_t pfx_len = strlen(pfx);
+      const char *pfx = APR_ARRAY_IDX(prefixes, i, const char *);
 
-      if (path_len < pfx_len)
-        continue;
-      if (strncmp(path, pfx, pfx_len) == 0
-          && (pfx_len == 1 || path[pfx_len] == '\0' || path[pfx_len] == '/'))
-        return TRUE;
+      if (glob)
+        {
+          /* Without wildcards, a pattern is a plain string comparison. */
+          if (strpbrk(pfx, "*?[\\"))
+            APR_ARRAY_PUSH(matcher->patterns, const char *) = pfx;
+          else
+            svn_hash_sets(matcher->exact, pfx, pfx);
+        }
+      else if (pfx[0] == '\0' || (pfx[0] == '/' && pfx[1] == '\0'))
+        matcher->match_all = TRUE;
+      else
+        svn_hash_sets(matcher->prefixes, pfx, pfx);
     }
 
-  return FALSE;
+  return matcher;
 }
 
-
-/* Check whether we need to skip this PATH based on its presence in
-   the PREFIXES list, and the DO_EXCLUDE option.
-   PATH starts with a '/', as do the (const char *) paths in PREFIXES. */
-static APR_INLINE svn_boolean_t
-skip_path(const char *path, const apr_array_header_t *prefixes,
-          svn_boolean_t do_exclude, svn_boolean_t glob)
+/* Compare the node-path PATH with the prefixes in MATCHER.
+ * Return TRUE if any prefix is a prefix of PATH (matching whole path
+ * components) or any pattern matches PATH; FALSE otherwise.
+ * PATH starts with a '/'. */
+static svn_boolean_t
+prefix_matcher_match(const prefix_matcher_t *matcher,
+                     const char *path)
 {
-  const svn_boolean_t matches =
-    (glob
-     ? svn_cstring_match_glob_list(path, prefixes)
-     : ary_prefix_match(prefixes, path));
+  apr_ssize_t i;
 
-  /* NXOR */
-  return (matches ? do_exclude : !do_exclude);
+  if (matcher->match_all)
+    return TRUE;
+
+  if (apr_hash_count(matcher->exact)
+      && apr_hash_get(matcher->exact, path, APR_HASH_KEY_STRING))
+    return TRUE;
+
+  if (matcher->patterns->nelts
+      && svn_cstring_match_glob_list(path, matcher->patterns))
+    return TRUE;
+
+  if (apr_hash_count(matcher->prefixes) == 0)
+    return FALSE;
+
+  /* Check all parent paths, i.e. all prefixes of PATH that end right
+     before a '/', and PATH itself.  Keys don't need to be NUL-terminated,
+     so we don't need to copy anything. */
+  for (i = 1; path[i]; i++)
+    if (path[i] == '/' && apr_hash_get(matcher->prefixes, path, i))
+      return TRUE;
+
+  return apr_hash_get(matcher->prefixes, path, i) != NULL;
 }
 
 
@@ -174,6 +224,16 @@ struct revmap_t
   svn_boolean_t was_dropped; /* Was this revision dropped? */
 };
 
+/* Dump streams list revisions in ascending order and usually without
+   gaps.  So, rather than hashing, we store the struct revmap_t of
+   revision REV at index REV - BASE_REV in a plain array.  Entries for
+   revisions not in the stream have an invalid REV and are not dropped. */
+typedef struct revmap_table_t
+{
+  svn_revnum_t base_rev;
+  apr_array_header_t *entries;
+} revmap_table_t;
+
 struct parse_baton_t
 {
   /* Command-line options values. */
@@ -187,15 +247,19 @@ struct parse_baton_t
   svn_boolean_t skip_missing_merge_sources;
   svn_boolean_t allow_deltas;
   apr_array_header_t *prefixes;
+  prefix_matcher_t *matcher;
 
-  /* Input and output streams. */
+  /* Input and output streams.  OUT_STREAM writes to the buffered OUT_FILE
+     and does not own it:  the parser closes the content streams that it
+     gets from us, which are OUT_STREAM itself. */
   svn_stream_t *in_stream;
   svn_stream_t *out_stream;
+  apr_file_t *out_file;
 
   /* State for the filtering process. */
   apr_int32_t rev_drop_count;
-  apr_hash_t *dropped_nodes;
-  apr_hash_t *renumber_history;  /* svn_revnum_t -> struct revmap_t */
+  apr_hash_t *dropped_nodes;  /* NULL if QUIET is set */
+  revmap_table_t renumber_history;
   svn_revnum_t last_live_revision;
   /* The oldest original revision, greater than r0, in the input
      stream which was not filtered. */
@@ -261,6 +325,79 @@ struct node_baton_t
 
 
 
+/* Return the entry for REV in PB's renumbering table or NULL, if REV
+   has not been recorded. */
+static struct revmap_t *
+revmap_get(struct parse_baton_t *pb,
+           svn_revnum_t rev)
+{
+  revmap_table_t *table = &pb->renumber_history;
+  struct revmap_t *entry;
+
+  if (rev < table->base_rev
+      || rev - table->base_rev >= table->entries->nelts)
+    return NULL;
+
+  entry = &APR_ARRAY_IDX(table->entries, rev - table->base_rev,
+                         struct revmap_t);
+  if (!SVN_IS_VALID_REVNUM(entry->rev) && !entry->was_dropped)
+    return NULL;
+
+  return entry;
+}
+
+/* Record in PB's renumbering table that REV maps to NEW_REV and whether
+   it WAS_DROPPED. */
+static void
+revmap_set(struct parse_baton_t *pb,
+           svn_revnum_t rev,
+           svn_revnum_t new_rev,
+           svn_boolean_t was_dropped)
+{
+  revmap_table_t *table = &pb->renumber_history;
+  struct revmap_t *entry;
+  struct revmap_t unknown = { SVN_INVALID_REVNUM, FALSE };
+
+  if (!SVN_IS_VALID_REVNUM(table->base_rev))
+    table->base_rev = rev;
+
+  /* Out-of-order streams are unusual but not invalid; make room for
+     older revisions at the front. */
+  if (rev < table->base_rev)
+    {
+      apr_array_header_t *entries
+        = apr_array_make(table->entries->pool,
+                         table->entries->nelts + (int)(table->base_rev - rev),
+                         sizeof(struct revmap_t));
+      for (; rev < table->base_rev; --table->base_rev)
+        APR_ARRAY_PUSH(entries, struct revmap_t) = unknown;
+
+      table->entries = apr_array_append(table->entries->pool, entries,
+                                        table->entries);
+    }
+
+  while (rev - table->base_rev >= table->entries->nelts)
+    APR_ARRAY_PUSH(table->entries, struct revmap_t) = unknown;
+
+  entry = &APR_ARRAY_IDX(table->entries, rev - table->base_rev,
+                         struct revmap_t);
+  entry->rev = new_rev;
+  entry->was_dropped = was_dropped;
+}
+
+/* Check whether we need to skip this PATH based on its presence in
+   PB's prefixes list, and the DO_EXCLUDE option.
+   PATH starts with a '/'. */
+static APR_INLINE svn_boolean_t
+skip_path(const char *path, const struct parse_baton_t *pb)
+{
+  const svn_boolean_t matches = prefix_matcher_match(pb->matcher, path);
+
+  /* NXOR */
+  return (matches ? pb->do_exclude : !pb->do_exclude);
+}
+
+
 /* Filtering vtable members */
 
 /* File-format stamp. */
@@ -394,16 +531,7 @@ output_revision(struct revision_baton_t *rb)
 
       if (rb->pb->do_renumber_revs)
         {
-          svn_revnum_t *rr_key;
-          struct revmap_t *rr_val;
-          apr_pool_t *rr_pool = apr_hash_pool_get(rb->pb->renumber_history);
-          rr_key = apr_palloc(rr_pool, sizeof(*rr_key));
-          rr_val = apr_palloc(rr_pool, sizeof(*rr_val));
-          *rr_key = rb->rev_orig;
-          rr_val->rev = rb->rev_actual;
-          rr_val->was_dropped = FALSE;
-          apr_hash_set(rb->pb->renumber_history, rr_key,
-                       sizeof(*rr_key), rr_val);
+          revmap_set(rb->pb, rb->rev_orig, rb->rev_actual, FALSE);
           rb->pb->last_live_revision = rb->rev_actual;
         }
 
@@ -417,18 +545,7 @@ output_revision(struct revision_baton_t *rb)
       /* We're dropping this revision. */
       rb->pb->rev_drop_count++;
       if (rb->pb->do_renumber_revs)
-        {
-          svn_revnum_t *rr_key;
-          struct revmap_t *rr_val;
-          apr_pool_t *rr_pool = apr_hash_pool_get(rb->pb->renumber_history);
-          rr_key = apr_palloc(rr_pool, sizeof(*rr_key));
-          rr_val = apr_palloc(rr_pool, sizeof(*rr_val));
-          *rr_key = rb->rev_orig;
-          rr_val->rev = rb->pb->last_live_revision;
-          rr_val->was_dropped = TRUE;
-          apr_hash_set(rb->pb->renumber_history, rr_key,
-                       sizeof(*rr_key), rr_val);
-        }
+        revmap_set(rb->pb, rb->rev_orig, rb->pb->last_live_revision, TRUE);
 
       if (! rb->pb->quiet)
         SVN_ERR(svn_cmdline_fprintf(stderr, subpool,
@@ -479,17 +596,17 @@ new_node_record(void **node_baton,
   if (copyfrom_path && copyfrom_path[0] != '/')
     copyfrom_path = apr_pstrcat(pool, "/", copyfrom_path, SVN_VA_NULL);
 
-  nb->do_skip = skip_path(node_path, pb->prefixes,
-                          pb->do_exclude, pb->glob);
+  nb->do_skip = skip_path(node_path, pb);
 
-  /* If we're skipping the node, take note of path, discarding the
-     rest.  */
+  /* If we're skipping the node, take note of path (only needed for the
+     final report), discarding the rest.  */
   if (nb->do_skip)
     {
-      svn_hash_sets(pb->dropped_nodes,
-                    apr_pstrdup(apr_hash_pool_get(pb->dropped_nodes),
-                                node_path),
-                    (void *)1);
+      if (pb->dropped_nodes)
+        svn_hash_sets(pb->dropped_nodes,
+                      apr_pstrdup(apr_hash_pool_get(pb->dropped_nodes),
+                                  node_path),
+                      (void *)1);
       nb->rb->had_dropped_nodes = TRUE;
     }
   else
@@ -500,8 +617,7 @@ new_node_record(void **node_baton,
       tcl = svn_hash_gets(headers, SVN_REPOS_DUMPFILE_TEXT_CONTENT_LENGTH);
 
       /* Test if this node was copied from dropped source. */
-      if (copyfrom_path &&
-          skip_path(copyfrom_path, pb->prefixes, pb->do_exclude, pb->glob))
+      if (copyfrom_path && skip_path(copyfrom_path, pb))
         {
           /* This node was copied from a dropped source.
              We have a problem, since we did not want to drop this node too.
@@ -594,7 +710,7 @@ new_node_record(void **node_baton,
 
           /* Rewrite Node-Copyfrom-Rev if we are renumbering revisions.
              The number points to some revision in the past. We keep track
-             of revision renumbering in an apr_hash, which maps original
+             of revision renumbering in a table, which maps original
              revisions to new ones. Dropped revision are mapped to -1.
              This should never happen here.
           */
@@ -605,9 +721,7 @@ new_node_record(void **node_baton,
               struct revmap_t *cf_renum_val;
 
               cf_orig_rev = SVN_STR_TO_REV(val);
-              cf_renum_val = apr_hash_get(pb->renumber_history,
-                                          &cf_orig_rev,
-                                          sizeof(cf_orig_rev));
+              cf_renum_val = revmap_get(pb, cf_orig_rev);
               if (! (cf_renum_val && SVN_IS_VALID_REVNUM(cf_renum_val->rev)))
                 return svn_error_createf
                   (SVN_ERR_NODE_UNEXPECTED_KIND, NULL,
@@ -674,7 +788,7 @@ adjust_mergeinfo(svn_string_t **final_val, const svn_string_t *initial_val,
       struct parse_baton_t *pb = rb->pb;
 
       /* Determine whether the merge_source is a part of the prefix. */
-      if (skip_path(merge_source, pb->prefixes, pb->do_exclude, pb->glob))
+      if (skip_path(merge_source, pb))
         {
           if (pb->skip_missing_merge_sources)
             continue;
@@ -697,15 +811,13 @@ adjust_mergeinfo(svn_string_t **final_val, const svn_string_t *initial_val,
               svn_merge_range_t *range = APR_ARRAY_IDX(rangelist, i,
                                                        svn_merge_range_t *);
 
-              revmap_start = apr_hash_get(pb->renumber_history,
-                                          &range->start, sizeof(range->start));
+              revmap_start = revmap_get(pb, range->start);
               if (! (revmap_start && SVN_IS_VALID_REVNUM(revmap_start->rev)))
                 return svn_error_createf
                   (SVN_ERR_NODE_UNEXPECTED_KIND, NULL,
                    _("No valid revision range 'start' in filtered stream"));
 
-              revmap_end = apr_hash_get(pb->renumber_history,
-                                        &range->end, sizeof(range->end));
+              revmap_end = revmap_get(pb, range->end);
               if (! (revmap_end && SVN_IS_VALID_REVNUM(revmap_end->rev)))
                 return svn_error_createf
                   (SVN_ERR_NODE_UNEXPECTED_KIND, NULL,
@@ -1037,12 +1149,18 @@ parse_baton_initialize(struct parse_baton_t **pb,
                        apr_pool_t *pool)
 {
   struct parse_baton_t *baton = apr_palloc(pool, sizeof(*baton));
+  apr_status_t apr_err;
 
   /* Read the stream from STDIN.  Users can redirect a file. */
   SVN_ERR(svn_stream_for_stdin2(&baton->in_stream, TRUE, pool));
 
-  /* Have the parser dump results to STDOUT. Users can redirect a file. */
-  SVN_ERR(svn_stream_for_stdout(&baton->out_stream, pool));
+  /* Have the parser dump results to STDOUT. Users can redirect a file.
+     Records and their headers get written piecemeal, so buffer the output
+     to not issue a system call for every one of them. */
+  apr_err = apr_file_open_flags_stdout(&baton->out_file, APR_BUFFERED, pool);
+  if (apr_err)
+    return svn_error_wrap_apr(apr_err, _("Can't open stdout"));
+  baton->out_stream = svn_stream_from_aprfile2(baton->out_file, TRUE, pool);
 
   baton->do_exclude = do_exclude;
 
@@ -1058,10 +1176,14 @@ parse_baton_initialize(struct parse_baton_t **pb,
   baton->quiet = opt_state->quiet;
   baton->glob = opt_state->glob;
   baton->prefixes = opt_state->prefixes;
+  baton->matcher = prefix_matcher_create(opt_state->prefixes,
+                                         opt_state->glob, pool);
   baton->skip_missing_merge_sources = opt_state->skip_missing_merge_sources;
   baton->rev_drop_count = 0; /* used to shift revnums while filtering */
-  baton->dropped_nodes = apr_hash_make(pool);
-  baton->renumber_history = apr_hash_make(pool);
+  baton->dropped_nodes = opt_state->quiet ? NULL : apr_hash_make(pool);
+  baton->renumber_history.base_rev = SVN_INVALID_REVNUM;
+  baton->renumber_history.entries = apr_array_make(pool, 0,
+                                                   sizeof(struct revmap_t));
   baton->last_live_revision = SVN_INVALID_REVNUM;
   baton->oldest_original_rev = SVN_INVALID_REVNUM;
   baton->allow_deltas = FALSE;
@@ -1176,6 +1298,9 @@ do_filter(apr_getopt_t *os,
   SVN_ERR(svn_repos_parse_dumpstream3(pb->in_stream, &filtering_vtable, pb,
                                       TRUE, NULL, NULL, pool));
 
+  /* Flush the buffered output. */
+  SVN_ERR(svn_io_file_flush(pb->out_file, pool));
+
   /* The rest of this is just reporting.  If we aren't reporting, get
      outta here. */
   if (opt_state->quiet)
@@ -1196,28 +1321,16 @@ do_filter(apr_getopt_t *os,
       SVN_ERR(svn_cmdline_fputs(_("Revisions renumbered as follows:\n"),
                                 stderr, subpool));
 
-      /* Get the keys of the hash, sort them, then print the hash keys
-         and values, sorted by keys. */
-      num_keys = apr_hash_count(pb->renumber_history);
-      keys = apr_array_make(pool, num_keys + 1, sizeof(svn_revnum_t));
-      for (hi = apr_hash_first(pool, pb->renumber_history);
-           hi;
-           hi = apr_hash_next(hi))
+      /* The table is sorted by revision already. */
+      for (i = 0; i < pb->renumber_history.entries->nelts; i++)
         {
-          const svn_revnum_t *revnum = apr_hash_this_key(hi);
+          svn_revnum_t this_key = pb->renumber_history.base_rev + i;
+          struct revmap_t *this_val = revmap_get(pb, this_key);
 
-          APR_ARRAY_PUSH(keys, svn_revnum_t) = *revnum;
-        }
-      svn_sort__array(keys, svn_sort_compare_revisions);
-      for (i = 0; i < keys->nelts; i++)
-        {
-          svn_revnum_t this_key;
-          struct revmap_t *this_val;
+          if (!this_val)
+            continue;
 
           svn_pool_clear(subpool);
-          this_key = APR_ARRAY_IDX(keys, i, svn_revnum_t);
-          this_val = apr_hash_get(pb->renumber_history, &this_key,
-                                  sizeof(this_key));
           if (this_val->was_dropped)
             SVN_ERR(svn_cmdline_fprintf(stderr, subpool,
                                         _("   %ld => (dropped)\n"),
@@ -0,0 +1,427 @@
+/*
+ * handover.c : Passing tunnel connections to a running svnserve daemon
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+
+
+#define APR_WANT_STRFUNC
+#include <apr_want.h>
+#include <apr_portable.h>
+
+#include "svn_error.h"
+#include "svn_dirent_uri.h"
+#include "svn_io.h"
+#include "svn_path.h"
+#include "svn_pools.h"
+
+#include "svn_private_config.h"
+#include "private/svn_local_socket.h"
+#include "handover.h"
+
+#ifdef SVNSERVE_HAVE_HANDOVER
+
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+
+#ifdef HAVE_UNISTD_H
+#include <unistd.h>
+#endif
+
+/* Tunnel user names and settings longer than this will be rejected. */
+#define MAX_TUNNEL_USER_LEN 255
+#define MAX_SETTINGS_LEN 255
+
+/* A handover offer consists of the tunnel user name and the settings
+ * string, each including its terminating NUL, and the tunnel's standard
+ * input and output file descriptors.  All of them go out with a single
+ * sendmsg() call.  The daemon replies with a single byte telling whether
+ * it takes the connection.  If it does, the tunnel process then waits
+ * for the daemon to close the socket. */
+#define HANDOVER_FD_COUNT 2
+#define HANDOVER_ACCEPTED 'y'
+#define HANDOVER_REFUSED 'n'
+
+struct handover_listener_t
+{
+  /* The listening socket. */
+  int sock;
+
+  /* Where we created it, in native encoding. */
+  const char *path;
+};
+
+/* Return an error if the process at the other end of SOCK runs as a
+ * different user than we do.  Platforms that can't tell us about our
+ * peer rely on the permissions of the socket file alone. */
+static svn_error_t *
+check_peer(int sock)
+{
+  if (svn_io__local_socket_peer_is_self(sock) != svn_tristate_false)
+    return SVN_NO_ERROR;
+
+  return svn_error_create(SVN_ERR_RA_NOT_AUTHORIZED, NULL,
+                          _("Rejected tunnel handover from another user"));
+}
+
+/* Pool cleanup handler closing the listener in DATA and removing its
+ * socket file. */
+static apr_status_t
+close_listener(void *data)
+{
+  handover_listener_t *listener = data;
+
+  close(listener->sock);
+  unlink(listener->path);
+
+  return APR_SUCCESS;
+}
+
+/* Return FD as an APR file in *FILE that will be closed when POOL gets
+ * cleared or destroyed. */
+static svn_error_t *
+wrap_fd(apr_file_t **file,
+        int fd,
+        apr_pool_t *pool)
+{
+  apr_os_file_t os_file = fd;
+  apr_status_t status = apr_os_pipe_put_ex(file, &os_file, TRUE, pool);
+  if (status)
+    {
+      close(fd);
+      return svn_error_wrap_apr(status, _("Can't take over connection"));
+    }
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+handover__send(svn_boolean_t *handed_over,
+               const char *socket_path,
+               const char *tunnel_user,
+               const char *settings,
+               apr_pool_t *pool)
+{
+  const char *native_path;
+  struct sockaddr_un addr;
+  struct msghdr msg = { 0 };
+  struct iovec iov;
+  union
+    {
+      struct cmsghdr hdr;
+      char buf[CMSG_SPACE(HANDOVER_FD_COUNT * sizeof(int))];
+    } control;
+  struct cmsghdr *cmsg;
+  int fds[HANDOVER_FD_COUNT] = { STDIN_FILENO, STDOUT_FILENO };
+  apr_size_t user_len, settings_len;
+  char *buffer;
+  ssize_t count;
+  char c;
+  int sock;
+
+  *handed_over = FALSE;
+
+  if (   strlen(tunnel_user) > MAX_TUNNEL_USER_LEN
+      || strlen(settings) > MAX_SETTINGS_LEN)
+    return SVN_NO_ERROR;
+
+  SVN_ERR(svn_io__local_socket_address(&native_path, &addr, socket_path,
+                                       pool));
+
+  sock = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (sock < 0)
+    return SVN_NO_ERROR;
+
+  /* No daemon to hand over to?  Then, our caller serves the tunnel. */
+  if (connect(sock, (struct sockaddr *)&addr, sizeof(addr)) < 0)
+    {
+      close(sock);
+      return SVN_NO_ERROR;
+    }
+
+  user_len = strlen(tunnel_user);
+  settings_len = strlen(settings);
+  buffer = apr_palloc(pool, user_len + 1 + settings_len + 1);
+  memcpy(buffer, tunnel_user, user_len + 1);
+  memcpy(buffer + user_len + 1, settings, settings_len + 1);
+
+  iov.iov_base = buffer;
+  iov.iov_len = user_len + 1 + settings_len + 1;
+
+  memset(&control, 0, sizeof(control));
+  msg.msg_iov = &iov;
+  msg.msg_iovlen = 1;
+  msg.msg_control = control.buf;
+  msg.msg_controllen = sizeof(control.buf);
+
+  cmsg = CMSG_FIRSTHDR(&msg);
+  cmsg->cmsg_level = SOL_SOCKET;
+  cmsg->cmsg_type = SCM_RIGHTS;
+  cmsg->cmsg_len = CMSG_LEN(sizeof(fds));
+  memcpy(CMSG_DATA(cmsg), fds, sizeof(fds));
+
+  do
+    count = sendmsg(sock, &msg, 0);
+  while (count < 0 && errno == EINTR);
+
+  /* Nothing has been handed over, if that failed. */
+  if (count != (ssize_t)iov.iov_len)
+    {
+      close(sock);
+      return SVN_NO_ERROR;
+    }
+
+  /* Unless the daemon takes the connection, we serve it ourselves.
+   * It won't touch our descriptors in that case. */
+  do
+    count = read(sock, &c, 1);
+  while (count < 0 && errno == EINTR);
+
+  if (count != 1 || c != HANDOVER_ACCEPTED)
+    {
+      close(sock);
+      return SVN_NO_ERROR;
+    }
+
+  *handed_over = TRUE;
+
+  /* The daemon closes the socket once it is done with our connection.
+   * Until then, keep the tunnel open by not exiting. */
+  do
+    count = read(sock, &c, 1);
+  while (count > 0 || (count < 0 && errno == EINTR));
+
+  close(sock);
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+handover__listen(handover_listener_t **listener,
+                 const char *socket_path,
+                 int backlog,
+                 apr_pool_t *pool)
+{
+  handover_listener_t *result = apr_pcalloc(pool, sizeof(*result));
+  struct sockaddr_un addr;
+
+  SVN_ERR(svn_io__local_socket_address(&result->path, &addr, socket_path,
+                                       pool));
+
+  /* Remove the socket left behind by some earlier daemon. */
+  SVN_ERR(svn_io_remove_file2(socket_path, TRUE, pool));
+
+  result->sock = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (result->sock < 0)
+    return svn_error_wrap_apr(apr_get_netos_error(),
+                              _("Can't create tunnel socket"));
+
+  svn_io__set_cloexec(result->sock);
+  apr_pool_cleanup_register(pool, result, close_listener,
+                            apr_pool_cleanup_null);
+
+  if (bind(result->sock, (struct sockaddr *)&addr, sizeof(addr)) < 0)
+    return svn_error_wrap_apr(apr_get_netos_error(),
+                              _("Can't bind tunnel socket '%s'"),
+                              svn_dirent_local_style(socket_path, pool));
+
+  /* Nobody can connect before we listen, so there is no window in which
+   * other users could sneak in. */
+  if (chmod(result->path, S_IRUSR | S_IWUSR) < 0)
+    return svn_error_wrap_apr(apr_get_os_error(),
+                              _("Can't set permissions on '%s'"),
+                              svn_dirent_local_style(socket_path, pool));
+
+  if (listen(result->sock, backlog) < 0)
+    return svn_error_wrap_apr(apr_get_netos_error(),
+                              _("Can't listen on tunnel socket"));
+
+  *listener = result;
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+handover__accept(handover_t **handover,
+                 handover_listener_t *listener,
+                 apr_pool_t *result_pool)
+{
+  handover_t *result;
+  apr_file_t *control_file;
+  svn_error_t *err;
+  char buffer[MAX_TUNNEL_USER_LEN + 1 + MAX_SETTINGS_LEN + 1];
+  const char *user_end;
+  struct msghdr msg = { 0 };
+  struct iovec iov;
+  union
+    {
+      struct cmsghdr hdr;
+      char buf[CMSG_SPACE(HANDOVER_FD_COUNT * sizeof(int))];
+    } control;
+  struct cmsghdr *cmsg;
+  int fds[HANDOVER_FD_COUNT];
+  int fd_count = 0;
+  ssize_t count;
+  int sock;
+  int i;
+
+  do
+    sock = accept(listener->sock, NULL, NULL);
+  while (sock < 0 && (errno == EINTR || errno == ECONNABORTED));
+
+  if (sock < 0)
+    return svn_error_wrap_apr(apr_get_netos_error(),
+                              _("Can't accept tunnel handover"));
+
+  /* From here on, closing CONTROL_FILE lets the tunnel process exit. */
+  svn_io__set_cloexec(sock);
+  SVN_ERR(wrap_fd(&control_file, sock, result_pool));
+  SVN_ERR(check_peer(sock));
+
+  iov.iov_base = buffer;
+  iov.iov_len = sizeof(buffer);
+
+  memset(&control, 0, sizeof(control));
+  msg.msg_iov = &iov;
+  msg.msg_iovlen = 1;
+  msg.msg_control = control.buf;
+  msg.msg_controllen = sizeof(control.buf);
+
+  do
+    count = recvmsg(sock, &msg, 0);
+  while (count < 0 && errno == EINTR);
+
+  if (count < 0)
+    return svn_error_wrap_apr(apr_get_netos_error(),
+                              _("Can't receive tunnel handover"));
+
+  /* Take ownership of whatever descriptors we received. */
+  for (cmsg = CMSG_FIRSTHDR(&msg); cmsg; cmsg = CMSG_NXTHDR(&msg, cmsg))
+    if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_RIGHTS)
+      {
+        int received = (int)((cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(int));
+        int *data = (int *)CMSG_DATA(cmsg);
+
+        for (i = 0; i < received; i++)
+          {
+            if (fd_count < HANDOVER_FD_COUNT)
+              fds[fd_count] = data[i];
+            else
+              close(data[i]);
+
+            fd_count++;
+          }
+      }
+
+  for (i = 0; i < fd_count && i < HANDOVER_FD_COUNT; i++)
+    svn_io__set_cloexec(fds[i]);
+
+  /* The user name must be followed by the NUL-terminated settings. */
+  user_end = count > 0 ? memchr(buffer, '\0', count) : NULL;
+  if (   fd_count != HANDOVER_FD_COUNT
+      || (msg.msg_flags & (MSG_TRUNC | MSG_CTRUNC))
+      || user_end == NULL
+      || user_end + 1 >= buffer + count
+      || buffer[count - 1] != '\0')
+    {
+      for (i = 0; i < fd_count && i < HANDOVER_FD_COUNT; i++)
+        close(fds[i]);
+
+      return svn_error_create(SVN_ERR_RA_SVN_MALFORMED_DATA, NULL,
+                              _("Malformed tunnel handover"));
+    }
+
+  result = apr_pcalloc(result_pool, sizeof(*result));
+  result->tunnel_user = apr_pstrdup(result_pool, buffer);
+  result->settings = apr_pstrdup(result_pool, user_end + 1);
+  result->control_file = control_file;
+
+  /* Once wrapped, the pool takes care of closing them. */
+  err = wrap_fd(&result->in_file, fds[0], result_pool);
+  if (err)
+    {
+      close(fds[1]);
+      return svn_error_trace(err);
+    }
+  SVN_ERR(wrap_fd(&result->out_file, fds[1], result_pool));
+
+  *handover = result;
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+handover__reply(handover_t *handover,
+                svn_boolean_t accept,
+                apr_pool_t *scratch_pool)
+{
+  char c = accept ? HANDOVER_ACCEPTED : HANDOVER_REFUSED;
+
+  return svn_error_trace(svn_io_file_write_full(handover->control_file,
+                                                &c, 1, NULL,
+                                                scratch_pool));
+}
+
+#else /* !SVNSERVE_HAVE_HANDOVER */
+
+svn_error_t *
+handover__send(svn_boolean_t *handed_over,
+               const char *socket_path,
+               const char *tunnel_user,
+               const char *settings,
+               apr_pool_t *pool)
+{
+  *handed_over = FALSE;
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+handover__listen(handover_listener_t **listener,
+                 const char *socket_path,
+                 int backlog,
+                 apr_pool_t *pool)
+{
+  return svn_error_create(SVN_ERR_UNSUPPORTED_FEATURE, NULL,
+                          _("Tunnel sockets are not supported on this "
+                            "platform"));
+}
+
+svn_error_t *
+handover__accept(handover_t **handover,
+                 handover_listener_t *listener,
+                 apr_pool_t *result_pool)
+{
+  return svn_error_create(SVN_ERR_UNSUPPORTED_FEATURE, NULL,
+                          _("Tunnel sockets are not supported on this "
+                            "platform"));
+}
+
+svn_error_t *
+handover__reply(handover_t *handover,
+                svn_boolean_t accept,
+                apr_pool_t *scratch_pool)
+{
+  return svn_error_create(SVN_ERR_UNSUPPORTED_FEATURE, NULL,
+                          _("Tunnel sockets are not supported on this "
+                            "platform"));
+}
+
+#endif /* SVNSERVE_HAVE_HANDOVER */
@@ -0,0 +1,120 @@
+/*
+ * handover.h : Passing tunnel connections to a running svnserve daemon
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+#ifndef HANDOVER_H
+#define HANDOVER_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+#include <apr_file_io.h>
+
+#include "svn_types.h"
+
+/* Handing file descriptors over to another process requires Unix domain
+ * sockets with SCM_RIGHTS support. */
+#ifndef WIN32
+#include <sys/socket.h>
+#ifdef SCM_RIGHTS
+#define SVNSERVE_HAVE_HANDOVER
+#endif
+#endif
+
+
+
+/* A tunnel connection that some "svnserve -t" process handed over to us.
+ */
+typedef struct handover_t
+{
+  /* Name of the user that the tunnel was established for. */
+  const char *tunnel_user;
+
+  /* Opaque description of the tunnel process' server settings, as passed
+   * to handover__send(). */
+  const char *settings;
+
+  /* The tunnel's standard input and output, i.e. our connection
+   * to the client. */
+  apr_file_t *in_file;
+  apr_file_t *out_file;
+
+  /* The socket connecting us to the tunnel process. */
+  apr_file_t *control_file;
+} handover_t;
+
+/* Opaque listener for handed over tunnel connections. */
+typedef struct handover_listener_t handover_listener_t;
+
+/* Connect to the svnserve daemon listening at SOCKET_PATH and offer it
+ * our standard input and output, together with TUNNEL_USER and SETTINGS.
+ * If the daemon accepts, wait until it is done serving the connection and
+ * set *HANDED_OVER.  If there is no daemon or it refuses the connection,
+ * set *HANDED_OVER to FALSE and leave standard input and output
+ * untouched.  Use POOL for temporary allocations.
+ */
+svn_error_t *
+handover__send(svn_boolean_t *handed_over,
+               const char *socket_path,
+               const char *tunnel_user,
+               const char *settings,
+               apr_pool_t *pool);
+
+/* Create a listener at SOCKET_PATH that accepts connections from
+ * handover__send() with a queue of up to BACKLOG pending handovers.
+ * Only processes running as the same user may connect.  The socket will
+ * be closed and removed when POOL gets cleared or destroyed.  Return the
+ * listener in *LISTENER.
+ */
+svn_error_t *
+handover__listen(handover_listener_t **listener,
+                 const char *socket_path,
+                 int backlog,
+                 apr_pool_t *pool);
+
+/* Wait for the next tunnel connection to be offered to LISTENER and
+ * return it in *HANDOVER, allocated in RESULT_POOL.  The connection stays
+ * open until RESULT_POOL gets cleared or destroyed, at which point the
+ * tunnel process gets notified that we are done.  The caller must call
+ * handover__reply() before using the connection.
+ */
+svn_error_t *
+handover__accept(handover_t **handover,
+                 handover_listener_t *listener,
+                 apr_pool_t *result_pool);
+
+/* Tell the tunnel process that offered HANDOVER whether we ACCEPT its
+ * connection.  If we don't, it will serve the connection itself and the
+ * caller must not touch the connection anymore.  Use SCRATCH_POOL for
+ * temporary allocations.
+ */
+svn_error_t *
+handover__reply(handover_t *handover,
+                svn_boolean_t accept,
+                apr_pool_t *scratch_pool);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* HANDOVER_H */
@@ -32,6 +32,7 @@
 #include <apr_general.h>
 #include <apr_lib.h>
 #include <apr_strings.h>
+#include <apr_thread_proc.h>
 
 #include "svn_compat.h"
 #include "svn_private_config.h"  /* For SVN_PATH_LOCAL_SEPARATOR */
@@ -50,11 +51,15 @@
 #include "svn_props.h"
 #include "svn_mergeinfo.h"
 #include "svn_user.h"
+#include "svn_sorts.h"
 
 #include "private/svn_log.h"
 #include "private/svn_mergeinfo_private.h"
 #include "private/svn_ra_svn_private.h"
 #include "private/svn_fspath.h"
+#include "private/svn_fs_private.h"
+#include "private/svn_fs_fs_private.h"
+#include "private/svn_string_private.h"
 
 #ifdef HAVE_UNISTD_H
 #include <unistd.h>   /* For getpid() */
@@ -843,89 +848,270 @@ static svn_error_t *must_have_access(svn_ra_svn_conn_t *conn,
   return SVN_NO_ERROR;
 }
 
+/* --- RESPONSE CACHE --- */
+
+/* Dirent fields that come from revision properties.  Those may change
+ * at any time, so responses containing them don't get cached.  The same
+ * goes for entry props, which contain svn:author and svn:date. */
+#define REVPROP_DIRENT_FIELDS (SVN_DIRENT_TIME | SVN_DIRENT_LAST_AUTHOR)
+
+/* Responses larger than this will not be cached. */
+#define RESPONSE_CACHE_MAX_SIZE 0x100000
+
+/* Implement svn_cache__serialize_func_t for svn_string_t. */
+static svn_error_t *
+serialize_response(void **data,
+                   apr_size_t *data_len,
+                   void *in,
+                   apr_pool_t *pool)
+{
+  svn_string_t *response = in;
+
+  *data = (void *)response->data;
+  *data_len = response->len;
+
+  return SVN_NO_ERROR;
+}
+
+/* Implement svn_cache__deserialize_func_t for svn_string_t. */
+static svn_error_t *
+deserialize_response(void **out,
+                     void *data,
+                     apr_size_t data_len,
+                     apr_pool_t *pool)
+{
+  svn_string_t *response = apr_palloc(pool, sizeof(*response));
+
+  response->data = data;
+  response->len = data_len;
+  *out = response;
+
+  return SVN_NO_ERROR;
+}
+
+/* Set REPOSITORY->RESPONSE_CACHE to a cache for marshalled responses
+ * that is shared with all other connections to the same repository.
+ * Leave it NULL if there is no global membuffer cache or if the
+ * repository can't tell itself apart from a replacement with the same
+ * UUID.  Allocate the cache in RESULT_POOL and use SCRATCH_POOL for
+ * temporaries. */
+static svn_error_t *
+create_response_cache(repository_t *repository,
+                      apr_pool_t *result_pool,
+                      apr_pool_t *scratch_pool)
+{
+  svn_membuffer_t *membuffer = svn_cache__get_global_membuffer_cache();
+  const char *instance_id = svn_fs__instance_id(repository->fs);
+  const char *prefix;
+
+  repository->response_cache = NULL;
+  if (!membuffer || !instance_id)
+    return SVN_NO_ERROR;
+
+  prefix = apr_pstrcat(scratch_pool, "svnserve:response:", repository->uuid,
+                       "/", instance_id, "/", repository->repos_root, ":",
+                       SVN_VA_NULL);
+  SVN_ERR(svn_cache__create_membuffer_cache(
+            &repository->response_cache, membuffer, serialize_response,
+            deserialize_response, APR_HASH_KEY_STRING, prefix,
+            SVN_CACHE__MEMBUFFER_DEFAULT_PRIORITY, TRUE, FALSE,
+            result_pool, scratch_pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* Return the cache key for the response to the command described by
+ * FORMAT and the following arguments, which must not contain any
+ * user-provided strings, for PATH.  The key covers everything that
+ * the access checks in B depend upon.  Return NULL if the response
+ * must not be cached.  Allocate the result in POOL.
+ *
+ * Cached responses never expire, so callers must only cache data that
+ * is fixed for a given revision, i.e. nothing from revision properties. */
+static const char *
+response_cache_key(server_baton_t *b,
+                   apr_pool_t *pool,
+                   const char *path,
+                   const char *format,
+                   ...)
+{
+  repository_t *repository = b->repository;
+  const char *user = b->client_info->authz_user;
+  const char *authz_id = "";
+  const char *authz_repos_name = "";
+  const char *args;
+  va_list ap;
+
+  if (!repository->response_cache)
+    return NULL;
+
+  /* Without an ID, we can't tell whether the rules are still the same. */
+  if (repository->authzdb)
+    {
+      authz_id = svn_repos__authz_id(repository->authzdb, pool);
+      if (!authz_id)
+        return NULL;
+
+      authz_repos_name = repository->authz_repos_name;
+    }
+
+  if (!user)
+    user = "";
+
+  va_start(ap, format);
+  args = apr_pvsprintf(pool, format, ap);
+  va_end(ap);
+
+  /* Strings that may contain anything get length prefixes. */
+  return apr_psprintf(pool,
+                      "%d %s"
+                      " %" APR_SIZE_T_FMT ":%s"
+                      " %" APR_SIZE_T_FMT ":%s"
+                      " %s %" APR_SIZE_T_FMT ":%s",
+                      (int)current_access(b), authz_id,
+                      strlen(authz_repos_name), authz_repos_name,
+                      strlen(user), user,
+                      args, strlen(path), path);
+}
+
+/* If B's response cache contains a response for KEY, send it over CONN
+ * and set *FOUND.  Otherwise, start recording the response to store it
+ * with response_cache_store().  KEY may be NULL.  Use POOL for
+ * allocations. */
+static svn_error_t *
+response_cache_lookup(svn_boolean_t *found,
+                      svn_ra_svn_conn_t *conn,
+                      server_baton_t *b,
+                      const char *key,
+                      apr_pool_t *pool)
+{
+  svn_string_t *response;
+
+  *found = FALSE;
+  if (!key)
+    return SVN_NO_ERROR;
+
+  SVN_ERR(svn_cache__get((void **)&response, found,
+                         b->repository->response_cache, key, pool));
+  if (*found)
+    return svn_error_trace(svn_ra_svn__write_raw(conn, pool, response->data,
+                                                 response->len));
+
+  svn_ra_svn__start_recording(conn, RESPONSE_CACHE_MAX_SIZE, pool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Store the response recorded on CONN since response_cache_lookup()
+ * under KEY in B's response cache.  KEY may be NULL.  Use POOL for
+ * temporary allocations. */
+static svn_error_t *
+response_cache_store(svn_ra_svn_conn_t *conn,
+                     server_baton_t *b,
+                     const char *key,
+                     apr_pool_t *pool)
+{
+  svn_stringbuf_t *response;
+
+  if (!key)
+    return SVN_NO_ERROR;
+
+  response = svn_ra_svn__stop_recording(conn);
+  if (response)
+    SVN_ERR(svn_cache__set(b->repository->response_cache, key,
+                           svn_stringbuf__morph_into_string(response),
+                           pool));
+
+  return SVN_NO_ERROR;
+}
+
 /* --- REPORTER COMMAND SET --- */
 
 /* To allow for pipelining, reporter commands have no reponses.  If we
  * get an error, we ignore all subsequent reporter commands and return
  * the error finish_report, to be handled by the calling command.
+ *
+ * A report can consist of one command per node in the working copy, so
+ * like the editor commands in libsvn_ra_svn, the parameters are decoded
+ * straight into a report_params_t instead of an intermediate item tree.
  */
 
-static svn_error_t *set_path(svn_ra_svn_conn_t *conn, apr_pool_t *pool,
-                             svn_ra_svn__list_t *params, void *baton)
+/* Union of the parameters of all reporter commands. */
+typedef struct report_params_t
 {
-  report_driver_baton_t *b = baton;
-  const char *path, *lock_token, *depth_word;
+  const char *path;
+  const char *url;
   svn_revnum_t rev;
+  svn_boolean_t start_empty;
+  const char *lock_token;
+  const char *depth_word;
+} report_params_t;
+
+static svn_error_t *set_path(svn_ra_svn_conn_t *conn, apr_pool_t *pool,
+                             const report_params_t *params,
+                             report_driver_baton_t *b)
+{
+  const char *path;
   /* Default to infinity, for old clients that don't send depth. */
   svn_depth_t depth = svn_depth_infinity;
-  svn_boolean_t start_empty;
 
-  SVN_ERR(svn_ra_svn__parse_tuple(params, "crb?(?c)?w",
-                                  &path, &rev, &start_empty, &lock_token,
-                                  &depth_word));
-  if (depth_word)
-    depth = svn_depth_from_word(depth_word);
-  path = svn_relpath_canonicalize(path, pool);
+  if (params->depth_word)
+    depth = svn_depth_from_word(params->depth_word);
+  path = svn_relpath_canonicalize(params->path, pool);
   if (b->from_rev && strcmp(path, "") == 0)
-    *b->from_rev = rev;
+    *b->from_rev = params->rev;
   if (!b->err)
-    b->err = svn_repos_set_path3(b->report_baton, path, rev, depth,
-                                 start_empty, lock_token, pool);
+    b->err = svn_repos_set_path3(b->report_baton, path, params->rev, depth,
+                                 params->start_empty, params->lock_token,
+                                 pool);
   b->entry_counter++;
-  if (!start_empty)
+  if (!params->start_empty)
     b->only_empty_entries = FALSE;
   return SVN_NO_ERROR;
 }
 
 static svn_error_t *delete_path(svn_ra_svn_conn_t *conn, apr_pool_t *pool,
-                                svn_ra_svn__list_t *params, void *baton)
+                                const report_params_t *params,
+                                report_driver_baton_t *b)
 {
-  report_driver_baton_t *b = baton;
   const char *path;
 
-  SVN_ERR(svn_ra_svn__parse_tuple(params, "c", &path));
-  path = svn_relpath_canonicalize(path, pool);
+  path = svn_relpath_canonicalize(params->path, pool);
   if (!b->err)
     b->err = svn_repos_delete_path(b->report_baton, path, pool);
   return SVN_NO_ERROR;
 }
 
 static svn_error_t *link_path(svn_ra_svn_conn_t *conn, apr_pool_t *pool,
-                              svn_ra_svn__list_t *params, void *baton)
+                              const report_params_t *params,
+                              report_driver_baton_t *b)
 {
-  report_driver_baton_t *b = baton;
-  const char *path, *url, *lock_token, *fs_path, *depth_word;
-  svn_revnum_t rev;
-  svn_boolean_t start_empty;
+  const char *path, *url, *fs_path;
   /* Default to infinity, for old clients that don't send depth. */
   svn_depth_t depth = svn_depth_infinity;
 
-  SVN_ERR(svn_ra_svn__parse_tuple(params, "ccrb?(?c)?w",
-                                 &path, &url, &rev, &start_empty,
-                                 &lock_token, &depth_word));
-
   /* ### WHAT?!  The link path is an absolute URL?!  Didn't see that
      coming...   -- cmpilato  */
-  path = svn_relpath_canonicalize(path, pool);
-  url = svn_uri_canonicalize(url, pool);
-  if (depth_word)
-    depth = svn_depth_from_word(depth_word);
+  path = svn_relpath_canonicalize(params->path, pool);
+  url = svn_uri_canonicalize(params->url, pool);
+  if (params->depth_word)
+    depth = svn_depth_from_word(params->depth_word);
   if (!b->err)
     b->err = get_fs_path(svn_path_uri_decode(b->repos_url, pool),
                          svn_path_uri_decode(url, pool),
                          &fs_path);
   if (!b->err)
-    b->err = svn_repos_link_path3(b->report_baton, path, fs_path, rev,
-                                  depth, start_empty, lock_token, pool);
+    b->err = svn_repos_link_path3(b->report_baton, path, fs_path,
+                                  params->rev, depth, params->start_empty,
+                                  params->lock_token, pool);
   b->entry_counter++;
   return SVN_NO_ERROR;
 }
 
 static svn_error_t *finish_report(svn_ra_svn_conn_t *conn, apr_pool_t *pool,
-                                  svn_ra_svn__list_t *params, void *baton)
+                                  const report_params_t *params,
+                                  report_driver_baton_t *b)
 {
-  report_driver_baton_t *b = baton;
-
   /* No arguments to parse. */
   SVN_ERR(trivial_auth_request(conn, pool, b->sb));
   if (!b->err)
@@ -936,25 +1122,131 @@ static svn_error_t *finish_report(svn_ra_svn_conn_t *conn, apr_pool_t *pool,
 static svn_error_t *
 abort_report(svn_ra_svn_conn_t *conn,
              apr_pool_t *pool,
-             svn_ra_svn__list_t *params,
-             void *baton)
+             const report_params_t *params,
+             report_driver_baton_t *b)
 {
-  report_driver_baton_t *b = baton;
-
   /* No arguments to parse. */
   svn_error_clear(svn_repos_abort_report(b->report_baton, pool));
   return SVN_NO_ERROR;
 }
 
-static const svn_ra_svn__cmd_entry_t report_commands[] = {
-  { "set-path",      set_path },
-  { "delete-path",   delete_path },
-  { "link-path",     link_path },
-  { "finish-report", finish_report, NULL, TRUE },
-  { "abort-report",  abort_report,  NULL, TRUE },
+/* Field tables describing the parameters of the reporter commands.
+   They correspond to the following svn_ra_svn__parse_tuple formats. */
+#define FIELD(kind, member) { kind, APR_OFFSETOF(report_params_t, member) }
+#define MARK(kind) { kind, 0 }
+
+/* "crb?(?c)?w" */
+static const svn_ra_svn__field_t set_path_fields[] = {
+  FIELD('c', path), FIELD('r', rev), FIELD('b', start_empty), MARK('?'),
+  MARK('('), MARK('?'), FIELD('c', lock_token), MARK(')'), MARK('?'),
+  FIELD('w', depth_word), MARK(0)
+};
+
+/* "c" */
+static const svn_ra_svn__field_t delete_path_fields[] = {
+  FIELD('c', path), MARK(0)
+};
+
+/* "ccrb?(?c)?w" */
+static const svn_ra_svn__field_t link_path_fields[] = {
+  FIELD('c', path), FIELD('c', url), FIELD('r', rev),
+  FIELD('b', start_empty), MARK('?'), MARK('('), MARK('?'),
+  FIELD('c', lock_token), MARK(')'), MARK('?'), FIELD('w', depth_word),
+  MARK(0)
+};
+
+/* "" */
+static const svn_ra_svn__field_t no_fields[] = {
+  MARK(0)
+};
+
+#undef FIELD
+#undef MARK
+
+typedef struct report_cmd_t
+{
+  const char *cmdname;
+  svn_error_t *(*handler)(svn_ra_svn_conn_t *conn, apr_pool_t *pool,
+                          const report_params_t *params,
+                          report_driver_baton_t *b);
+  const svn_ra_svn__field_t *fields;
+  svn_boolean_t terminate;
+} report_cmd_t;
+
+static const report_cmd_t report_commands[] = {
+  { "set-path",      set_path,      set_path_fields },
+  { "delete-path",   delete_path,   delete_path_fields },
+  { "link-path",     link_path,     link_path_fields },
+  { "finish-report", finish_report, no_fields, TRUE },
+  { "abort-report",  abort_report,  no_fields, TRUE },
   { NULL }
 };
 
+/* Read reporter commands from CONN and pass them to B until the report
+ * has been finished or aborted.  Like svn_ra_svn__handle_commands2(),
+ * write a failure response for command errors and return all other
+ * errors.  Use POOL for temporary allocations.
+ */
+static svn_error_t *
+handle_report_commands(svn_ra_svn_conn_t *conn,
+                       apr_pool_t *pool,
+                       report_driver_baton_t *b)
+{
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  svn_boolean_t terminate = FALSE;
+
+  while (!terminate)
+    {
+      const char *cmdname;
+      const report_cmd_t *command;
+      svn_error_t *err;
+
+      svn_pool_clear(iterpool);
+
+      /* Limit I/O for every command separately. */
+      svn_ra_svn__reset_command_io_counters(conn);
+
+      SVN_ERR(svn_ra_svn__read_command_start(conn, iterpool, &cmdname));
+      for (command = report_commands; command->cmdname; command++)
+        if (strcmp(command->cmdname, cmdname) == 0)
+          break;
+
+      if (command->cmdname)
+        {
+          /* Consume the whole command before executing it. */
+          report_params_t params = { 0 };
+          SVN_ERR(svn_ra_svn__read_fields(conn, iterpool, command->fields,
+                                          &params));
+          SVN_ERR(svn_ra_svn__read_tuple_end(conn, iterpool));
+          err = command->handler(conn, iterpool, &params, b);
+          terminate = command->terminate;
+        }
+      else
+        {
+          SVN_ERR(svn_ra_svn__read_tuple_end(conn, iterpool));
+          err = svn_error_createf(SVN_ERR_RA_SVN_UNKNOWN_CMD, NULL,
+                                  _("Unknown editor command '%s'"), cmdname);
+          err = svn_error_create(SVN_ERR_RA_SVN_CMD_ERR, err, NULL);
+        }
+
+      if (err && err->apr_err == SVN_ERR_RA_SVN_CMD_ERR)
+        {
+          svn_error_t *write_err;
+
+          write_err = svn_ra_svn__write_cmd_failure(
+                          conn, iterpool,
+                          svn_ra_svn__locate_real_error_child(err));
+          svn_error_clear(err);
+          SVN_ERR(write_err);
+        }
+      else
+        SVN_ERR(err);
+    }
+
+  svn_pool_destroy(iterpool);
+  return SVN_NO_ERROR;
+}
+
 /* Accept a report from the client, drive the network editor with the
  * result, and then write an empty command response.  If there is a
  * non-protocol failure, accept_report will abort the edit and return
@@ -1009,7 +1301,7 @@ static svn_error_t *accept_report(svn_boolean_t *only_empty_entry,
   rb.from_rev = from_rev;
   if (from_rev)
     *from_rev = SVN_INVALID_REVNUM;
-  err = svn_ra_svn__handle_commands2(conn, pool, report_commands, &rb, TRUE);
+  err = handle_report_commands(conn, pool, &rb);
   if (err)
     {
       /* Network or protocol error while handling commands. */
@@ -1562,6 +1854,82 @@ commit(svn_ra_svn_conn_t *conn,
   return SVN_NO_ERROR;
 }
 
+/* Fulltexts smaller than this are not worth sending via sendfile. */
+#define SENDFILE_MIN_SIZE 0x10000
+
+/* When sending fulltexts via sendfile, send them as a series of strings
+   of at most this size, just like the buffered code path does.  This
+   keeps the client from having to hold the whole file in memory. */
+#define SENDFILE_CHUNK_SIZE 0x40000
+
+/* If CONN supports sendfile and the contents of FULL_PATH in ROOT are
+   stored verbatim in the repository, set *PLAIN to the location of these
+   contents, allocated in POOL.  Otherwise, set *PLAIN to NULL. */
+static svn_error_t *
+get_plain_contents(svn_fs_fs__ioctl_plain_contents_output_t **plain,
+                   svn_ra_svn_conn_t *conn,
+                   svn_fs_root_t *root,
+                   const char *full_path,
+                   apr_pool_t *pool)
+{
+  svn_fs_fs__ioctl_plain_contents_input_t input;
+  void *output;
+  svn_error_t *err;
+
+  *plain = NULL;
+  if (!svn_ra_svn__can_sendfile(conn))
+    return SVN_NO_ERROR;
+
+  input.root = root;
+  input.path = full_path;
+  err = svn_fs_ioctl(svn_fs_root_fs(root), SVN_FS_FS__IOCTL_PLAIN_CONTENTS,
+                     &input, &output, NULL, NULL, pool, pool);
+
+  /* Other backends simply don't support this. */
+  if (err && err->apr_err == SVN_ERR_FS_UNRECOGNIZED_IOCTL_CODE)
+    {
+      svn_error_clear(err);
+      return SVN_NO_ERROR;
+    }
+  SVN_ERR(err);
+
+  *plain = output;
+  if ((*plain)->file && (*plain)->length < SENDFILE_MIN_SIZE)
+    {
+      SVN_ERR(svn_io_file_close((*plain)->file, pool));
+      *plain = NULL;
+    }
+  else if (!(*plain)->file)
+    {
+      *plain = NULL;
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Send LENGTH bytes starting at OFFSET in FILE as a series of strings
+   to CONN, bypassing the write buffer if possible.  Close FILE
+   afterwards.  Use POOL for temporaries. */
+static svn_error_t *
+send_plain_contents(svn_ra_svn_conn_t *conn,
+                    apr_file_t *file,
+                    apr_off_t offset,
+                    svn_filesize_t length,
+                    apr_pool_t *pool)
+{
+  while (length > 0)
+    {
+      apr_size_t len = (apr_size_t)MIN(length, SENDFILE_CHUNK_SIZE);
+
+      SVN_ERR(svn_ra_svn__write_string_from_file(conn, pool, file, offset,
+                                                 len));
+      offset += len;
+      length -= len;
+    }
+
+  return svn_error_trace(svn_io_file_close(file, pool));
+}
+
 static svn_error_t *
 get_file(svn_ra_svn_conn_t *conn,
          apr_pool_t *pool,
@@ -1572,7 +1940,8 @@ get_file(svn_ra_svn_conn_t *conn,
   const char *path, *full_path, *hex_digest;
   svn_revnum_t rev;
   svn_fs_root_t *root;
-  svn_stream_t *contents;
+  svn_stream_t *contents = NULL;
+  svn_fs_fs__ioctl_plain_contents_output_t *plain = NULL;
   apr_hash_t *props = NULL;
   apr_array_header_t *inherited_props;
   svn_string_t write_str;
@@ -1584,6 +1953,8 @@ get_file(svn_ra_svn_conn_t *conn,
   svn_error_t *err, *write_err;
   int i;
   authz_baton_t ab;
+  const char *key = NULL;
+  svn_boolean_t found;
 
   ab.server = b;
   ab.conn = conn;
@@ -1610,6 +1981,15 @@ get_file(svn_ra_svn_conn_t *conn,
                       svn_log__get_file(full_path, rev,
                                         want_contents, want_props, pool)));
 
+  /* Don't cache file contents; they get sent through other means.
+     Entry props contain revision properties, which may change. */
+  if (!want_contents && !want_props)
+    key = response_cache_key(b, pool, full_path, "get-file %ld %d",
+                             rev, (int)wants_inherited_props);
+  SVN_ERR(response_cache_lookup(&found, conn, b, key, pool));
+  if (found)
+    return SVN_NO_ERROR;
+
   /* Fetch the properties and a stream for the contents. */
   SVN_CMD_ERR(svn_fs_revision_root(&root, b->repository->fs, rev, pool));
   SVN_CMD_ERR(svn_fs_file_checksum(&checksum, svn_checksum_md5, root,
@@ -1625,7 +2005,11 @@ get_file(svn_ra_svn_conn_t *conn,
                           &ab, root, full_path,
                           pool));
   if (want_contents)
-    SVN_CMD_ERR(svn_fs_file_contents(&contents, root, full_path, pool));
+    {
+      SVN_CMD_ERR(get_plain_contents(&plain, conn, root, full_path, pool));
+      if (!plain)
+        SVN_CMD_ERR(svn_fs_file_contents(&contents, root, full_path, pool));
+    }
 
   /* Send successful command response with revision and props. */
   SVN_ERR(svn_ra_svn__write_tuple(conn, pool, "w((?c)r(!", "success",
@@ -1655,7 +2039,14 @@ get_file(svn_ra_svn_conn_t *conn,
   SVN_ERR(svn_ra_svn__write_tuple(conn, pool, "!))"));
 
   /* Now send the file's contents. */
-  if (want_contents)
+  if (want_contents && plain)
+    {
+      SVN_ERR(send_plain_contents(conn, plain->file, plain->offset,
+                                  plain->length, pool));
+      SVN_ERR(svn_ra_svn__write_cstring(conn, pool, ""));
+      SVN_ERR(svn_ra_svn__write_cmd_response(conn, pool, ""));
+    }
+  else if (want_contents)
     {
       err = SVN_NO_ERROR;
       while (1)
@@ -1686,7 +2077,7 @@ get_file(svn_ra_svn_conn_t *conn,
       SVN_ERR(svn_ra_svn__write_cmd_response(conn, pool, ""));
     }
 
-  return SVN_NO_ERROR;
+  return svn_error_trace(response_cache_store(conn, b, key, pool));
 }
 
 /* Translate all the words in DIRENT_FIELDS_LIST into the flags in
@@ -1767,6 +2158,8 @@ get_dir(svn_ra_svn_conn_t *conn,
   svn_ra_svn__list_t *dirent_fields_list = NULL;
   int i;
   authz_baton_t ab;
+  const char *key = NULL;
+  svn_boolean_t found;
 
   ab.server = b;
   ab.conn = conn;
@@ -1795,6 +2188,18 @@ get_dir(svn_ra_svn_conn_t *conn,
                                        want_contents, want_props,
                                        dirent_fields, pool)));
 
+  /* Entry props and some dirent fields contain revision properties,
+     which may change. */
+  if (!want_props && !(want_contents && (dirent_fields
+                                         & REVPROP_DIRENT_FIELDS)))
+    key = response_cache_key(b, pool, full_path, "get-dir %ld %d %x %d",
+                             rev, want_contents,
+                             (unsigned int)dirent_fields,
+                             (int)wants_inherited_props);
+  SVN_ERR(response_cache_lookup(&found, conn, b, key, pool));
+  if (found)
+    return SVN_NO_ERROR;
+
   /* Fetch the root of the appropriate revision. */
   SVN_CMD_ERR(svn_fs_revision_root(&root, b->repository->fs, rev, pool));
 
@@ -1917,7 +2322,9 @@ get_dir(svn_ra_svn_conn_t *conn,
     }
 
   /* Finish response. */
-  return svn_ra_svn__write_tuple(conn, pool, "!))");
+  SVN_ERR(svn_ra_svn__write_tuple(conn, pool, "!))"));
+
+  return svn_error_trace(response_cache_store(conn, b, key, pool));
 }
 
 static svn_error_t *
@@ -2597,6 +3004,9 @@ get_locations(svn_ra_svn_conn_t *conn,
   apr_hash_t *fs_locations;
   const char *abs_path;
   authz_baton_t ab;
+  svn_stringbuf_t *revs_key;
+  const char *key;
+  svn_boolean_t found;
 
   ab.server = b;
   ab.conn = conn;
@@ -2612,6 +3022,7 @@ get_locations(svn_ra_svn_conn_t *conn,
 
   location_revisions = apr_array_make(pool, loc_revs_proto->nelts,
                                       sizeof(svn_revnum_t));
+  revs_key = svn_stringbuf_create_empty(pool);
   for (i = 0; i < loc_revs_proto->nelts; i++)
     {
       elt = &SVN_RA_SVN__LIST_ITEM(loc_revs_proto, i);
@@ -2621,12 +3032,20 @@ get_locations(svn_ra_svn_conn_t *conn,
                                 "not a revision number");
       revision = (svn_revnum_t)(elt->u.number);
       APR_ARRAY_PUSH(location_revisions, svn_revnum_t) = revision;
+      svn_stringbuf_appendcstr(revs_key,
+                               apr_psprintf(pool, "%ld,", revision));
     }
   SVN_ERR(trivial_auth_request(conn, pool, b));
   SVN_ERR(log_command(b, conn, pool, "%s",
                       svn_log__get_locations(abs_path, peg_revision,
                                              location_revisions, pool)));
 
+  key = response_cache_key(b, pool, abs_path, "get-locations %ld %s",
+                           peg_revision, revs_key->data);
+  SVN_ERR(response_cache_lookup(&found, conn, b, key, pool));
+  if (found)
+    return SVN_NO_ERROR;
+
   /* All the parameters are fine - let's perform the query against the
    * repository. */
 
@@ -2668,7 +3087,7 @@ get_locations(svn_ra_svn_conn_t *conn,
 
   SVN_ERR(svn_ra_svn__write_cmd_response(conn, pool, ""));
 
-  return SVN_NO_ERROR;
+  return svn_error_trace(response_cache_store(conn, b, key, pool));
 }
 
 static svn_error_t *gls_receiver(svn_location_segment_t *segment,
@@ -3537,6 +3956,8 @@ get_inherited_props(svn_ra_svn_conn_t *conn,
   apr_pool_t *iterpool = svn_pool_create(pool);
   authz_baton_t ab;
   svn_node_kind_t node_kind;
+  const char *key = NULL;
+  svn_boolean_t found;
 
   ab.server = b;
   ab.conn = conn;
@@ -3556,6 +3977,15 @@ get_inherited_props(svn_ra_svn_conn_t *conn,
                       svn_log__get_inherited_props(full_path, rev,
                                                    iterpool)));
 
+  if (SVN_IS_VALID_REVNUM(rev))
+    key = response_cache_key(b, pool, full_path, "get-iprops %ld", rev);
+  SVN_ERR(response_cache_lookup(&found, conn, b, key, pool));
+  if (found)
+    {
+      svn_pool_destroy(iterpool);
+      return SVN_NO_ERROR;
+    }
+
   /* Fetch the properties and a stream for the contents. */
   SVN_CMD_ERR(svn_fs_revision_root(&root, b->repository->fs, rev, iterpool));
   SVN_CMD_ERR(svn_fs_check_path(&node_kind, root, full_path, pool));
@@ -3586,7 +4016,8 @@ get_inherited_props(svn_ra_svn_conn_t *conn,
 
   SVN_ERR(svn_ra_svn__write_tuple(conn, iterpool, "!))"));
   svn_pool_destroy(iterpool);
-  return SVN_NO_ERROR;
+
+  return svn_error_trace(response_cache_store(conn, b, key, pool));
 }
 
 /* Baton type to be used with list_receiver. */
@@ -3631,6 +4062,8 @@ list(svn_ra_svn_conn_t *conn,
   int i;
   list_receiver_baton_t rb;
   svn_error_t *err, *write_err;
+  const char *key = NULL;
+  svn_boolean_t found;
 
   authz_baton_t ab;
   ab.server = b;
@@ -3675,6 +4108,16 @@ list(svn_ra_svn_conn_t *conn,
                       svn_log__list(full_path, rev, patterns, depth,
                                     rb.dirent_fields, pool)));
 
+  /* Patterns would need to be part of the key; don't bother.  Some
+     dirent fields contain revision properties, which may change. */
+  if (!patterns && !(rb.dirent_fields & REVPROP_DIRENT_FIELDS))
+    key = response_cache_key(b, pool, full_path, "list %ld %s %x", rev,
+                             svn_depth_to_word(depth),
+                             (unsigned int)rb.dirent_fields);
+  SVN_ERR(response_cache_lookup(&found, conn, b, key, pool));
+  if (found)
+    return SVN_NO_ERROR;
+
   /* Fetch the root of the appropriate revision. */
   SVN_CMD_ERR(svn_fs_revision_root(&root, b->repository->fs, rev, pool));
 
@@ -3694,7 +4137,83 @@ list(svn_ra_svn_conn_t *conn,
     }
   SVN_CMD_ERR(err);
 
-  return svn_error_trace(svn_ra_svn__write_cmd_response(conn, pool, ""));
+  SVN_ERR(svn_ra_svn__write_cmd_response(conn, pool, ""));
+
+  return svn_error_trace(response_cache_store(conn, b, key, pool));
+}
+
+/* State shared by all channels of a multiplexed connection. */
+typedef struct mux_server_t
+{
+  /* Channel 0, i.e. the connection that got multiplexed. */
+  svn_ra_svn_conn_t *conn;
+
+  /* Server-global parameters. */
+  serve_params_t *params;
+
+  /* User authenticated on channel 0 at the time of the multiplex command
+     and the repository that user got authenticated for.  USER is NULL
+     for anonymous access.  REPOSITORY lives in channel 0's pool, which
+     outlives all other channels. */
+  const char *user;
+  const repository_t *repository;
+
+#if APR_HAS_THREADS
+  /* Thread accepting new channels, see accept_channels(). */
+  apr_thread_t *acceptor;
+#endif
+} mux_server_t;
+
+#if APR_HAS_THREADS
+static void * APR_THREAD_FUNC accept_channels(apr_thread_t *tid, void *data);
+#endif
+
+static svn_error_t *
+multiplex(svn_ra_svn_conn_t *conn,
+          apr_pool_t *pool,
+          svn_ra_svn__list_t *params,
+          void *baton)
+{
+  server_baton_t *b = baton;
+
+  SVN_ERR(log_command(b, conn, pool, "multiplex"));
+  SVN_ERR(trivial_auth_request(conn, pool, b));
+
+#if APR_HAS_THREADS
+  if (b->params->multiplex && !b->mux)
+    {
+      mux_server_t *mux = apr_pcalloc(b->pool, sizeof(*mux));
+      apr_status_t status;
+
+      mux->conn = conn;
+      mux->params = b->params;
+      mux->user = b->client_info->user;
+      mux->repository = b->repository;
+
+      /* The client switches to multiplexed framing after our response. */
+      SVN_ERR(svn_ra_svn__write_cmd_response(conn, pool, ""));
+      SVN_ERR(svn_ra_svn__mux_start(conn, pool));
+      b->mux = mux;
+
+      /* Without an acceptor, new channels would hang.  Better fail the
+         whole connection. */
+      status = apr_thread_create(&mux->acceptor, NULL, accept_channels,
+                                 mux, b->pool);
+      if (status)
+        {
+          mux->acceptor = NULL;
+          return svn_error_wrap_apr(status, _("Can't create thread"));
+        }
+
+      return SVN_NO_ERROR;
+    }
+#endif
+
+  return svn_error_create(SVN_ERR_RA_SVN_CMD_ERR,
+                          svn_error_create(SVN_ERR_RA_NOT_IMPLEMENTED, NULL,
+                                           _("Connection cannot be "
+                                             "multiplexed")),
+                          NULL);
 }
 
 static const svn_ra_svn__cmd_entry_t main_commands[] = {
@@ -3730,6 +4249,7 @@ static const svn_ra_svn__cmd_entry_t main_commands[] = {
   { "get-deleted-rev", get_deleted_rev },
   { "get-iprops",      get_inherited_props },
   { "list",            list },
+  { "multiplex",       multiplex },
   { NULL }
 };
 
@@ -3812,6 +4332,7 @@ find_repos(const char *url,
   const char *path, *full_path, *fs_path, *hooks_env;
   svn_stringbuf_t *url_buf;
   svn_boolean_t sasl_requested;
+  svn_boolean_t report_prefetch;
 
   /* Skip past the scheme and authority part. */
   path = skip_scheme_part(url);
@@ -3938,6 +4459,12 @@ find_repos(const char *url,
   SVN_ERR(svn_repos_hooks_setenv(repository->repos, hooks_env, scratch_pool));
   repository->hooks_env = apr_pstrdup(result_pool, hooks_env);
 
+  /* Read added sub-trees ahead of checkouts and updates? */
+  SVN_ERR(svn_config_get_bool(cfg, &report_prefetch,
+                              SVN_CONFIG_SECTION_GENERAL,
+                              SVN_CONFIG_OPTION_REPORT_PREFETCH, FALSE));
+  svn_repos__set_report_prefetch(repository->repos, report_prefetch);
+
   return SVN_NO_ERROR;
 }
 
@@ -4116,44 +4643,55 @@ handle_authz_warning(void *baton,
   SVN_UNUSED(scratch_pool);
 }
 
-/* Construct the server baton for CONN using PARAMS and return it in *BATON.
- * It's lifetime is the same as that of CONN.  SCRATCH_POOL
+/* Return TRUE if the user authenticated on channel 0 of MUX may be
+ * used for REPOSITORY without authenticating again.  That requires the
+ * same realm and authentication method.  Moreover, REPOSITORY must be
+ * the one that the user authenticated for or share its password and
+ * authz configuration.  Use SCRATCH_POOL for temporaries.
  */
-static svn_error_t *
-construct_server_baton(server_baton_t **baton,
-                       svn_ra_svn_conn_t *conn,
-                       serve_params_t *params,
-                       apr_pool_t *scratch_pool)
+static svn_boolean_t
+may_inherit_user(const mux_server_t *mux,
+                 const repository_t *repository,
+                 apr_pool_t *scratch_pool)
 {
-  svn_error_t *err, *io_err;
-  apr_uint64_t ver;
-  const char *client_url, *ra_client_string, *client_string;
-  svn_ra_svn__list_t *caplist;
-  apr_pool_t *conn_pool = svn_ra_svn__get_pool(conn);
-  server_baton_t *b = apr_pcalloc(conn_pool, sizeof(*b));
-  fs_warning_baton_t *warn_baton;
-  svn_stringbuf_t *cap_log = svn_stringbuf_create_empty(scratch_pool);
+  const repository_t *origin = mux->repository;
+  const char *origin_authz_id, *authz_id;
 
-  b->repository = apr_pcalloc(conn_pool, sizeof(*b->repository));
-  b->repository->username_case = params->username_case;
-  b->repository->base = params->base;
-  b->repository->pwdb = NULL;
-  b->repository->authzdb = NULL;
-  b->repository->realm = NULL;
-  b->repository->use_sasl = FALSE;
+  if (!mux->user || !origin->realm || !repository->realm
+      || strcmp(origin->realm, repository->realm) != 0
+      || origin->use_sasl != repository->use_sasl)
+    return FALSE;
 
-  b->read_only = params->read_only;
-  b->pool = conn_pool;
-  b->vhost = params->vhost;
+  if (strcmp(origin->repos_root, repository->repos_root) == 0)
+    return TRUE;
 
-  b->logger = params->logger;
-  b->client_info = get_client_info(conn, params, conn_pool);
+  /* The config pool returns the same object for the same file contents. */
+  if (origin->pwdb != repository->pwdb)
+    return FALSE;
+
+  if (!origin->authzdb || !repository->authzdb)
+    return origin->authzdb == repository->authzdb;
 
-  /* Send greeting.  We don't support version 1 any more, so we can
-   * send an empty mechlist. */
+  origin_authz_id = svn_repos__authz_id(origin->authzdb, scratch_pool);
+  authz_id = svn_repos__authz_id(repository->authzdb, scratch_pool);
+
+  return origin_authz_id && authz_id
+      && strcmp(origin_authz_id, authz_id) == 0;
+}
+
+/* Send the server greeting for PARAMS on CONN.  Include the "starttls"
+ * capability if OFFER_TLS is set.  We don't support version 1 any more,
+ * so we can send an empty mechlist.  Use POOL for temporary allocations.
+ */
+static svn_error_t *
+write_greeting(svn_ra_svn_conn_t *conn,
+               serve_params_t *params,
+               svn_boolean_t offer_tls,
+               apr_pool_t *pool)
+{
   if (params->compression_level > 0)
-    SVN_ERR(svn_ra_svn__write_cmd_response(conn, scratch_pool,
-                                           "nn()(wwwwwwwwwwwww)",
+    SVN_ERR(svn_ra_svn__write_tuple(conn, pool,
+                                    "w(nn()(wwwwwwwwwwwwww!", "success",
                                            (apr_uint64_t) 2, (apr_uint64_t) 2,
                                            SVN_RA_SVN_CAP_EDIT_PIPELINE,
                                            SVN_RA_SVN_CAP_SVNDIFF1,
@@ -4167,11 +4705,12 @@ construct_server_baton(server_baton_t **baton,
                                            SVN_RA_SVN_CAP_INHERITED_PROPS,
                                            SVN_RA_SVN_CAP_EPHEMERAL_TXNPROPS,
                                            SVN_RA_SVN_CAP_GET_FILE_REVS_REVERSE,
-                                           SVN_RA_SVN_CAP_LIST
+                                           SVN_RA_SVN_CAP_LIST,
+                                           SVN_RA_SVN_CAP_PIPELINING
                                            ));
   else
-    SVN_ERR(svn_ra_svn__write_cmd_response(conn, scratch_pool,
-                                           "nn()(wwwwwwwwwww)",
+    SVN_ERR(svn_ra_svn__write_tuple(conn, pool,
+                                    "w(nn()(wwwwwwwwwwww!", "success",
                                            (apr_uint64_t) 2, (apr_uint64_t) 2,
                                            SVN_RA_SVN_CAP_EDIT_PIPELINE,
                                            SVN_RA_SVN_CAP_ABSENT_ENTRIES,
@@ -4183,16 +4722,114 @@ construct_server_baton(server_baton_t **baton,
                                            SVN_RA_SVN_CAP_INHERITED_PROPS,
                                            SVN_RA_SVN_CAP_EPHEMERAL_TXNPROPS,
                                            SVN_RA_SVN_CAP_GET_FILE_REVS_REVERSE,
-                                           SVN_RA_SVN_CAP_LIST
+                                           SVN_RA_SVN_CAP_LIST,
+                                           SVN_RA_SVN_CAP_PIPELINING
                                            ));
+  if (params->multiplex)
+    SVN_ERR(svn_ra_svn__write_word(conn, pool,
+                                   SVN_RA_SVN_CAP_MULTIPLEX));
+  if (offer_tls)
+    SVN_ERR(svn_ra_svn__write_word(conn, pool, SVN_RA_SVN_CAP_STARTTLS));
+  SVN_ERR(svn_ra_svn__write_tuple(conn, pool, "!))"));
+
+  return SVN_NO_ERROR;
+}
+
+#ifdef SVN_HAVE_OPENSSL
+/* Return TRUE if ITEM is the client's request to switch to TLS. */
+static svn_boolean_t
+is_starttls(const svn_ra_svn__item_t *item)
+{
+  const svn_ra_svn__item_t *cmd;
+
+  if (item->kind != SVN_RA_SVN_LIST || item->u.list.nelts == 0)
+    return FALSE;
+
+  cmd = &SVN_RA_SVN__LIST_ITEM(&item->u.list, 0);
+  return cmd->kind == SVN_RA_SVN_WORD
+      && strcmp(cmd->u.word.data, "starttls") == 0;
+}
+#endif
+
+/* Construct the server baton for CONN using PARAMS and return it in *BATON.
+ * It's lifetime is the same as that of CONN.  SCRATCH_POOL
+ * If CONN is a channel of the multiplexed connection MUX, it may use
+ * the authentication of that connection.  Otherwise, MUX is NULL.
+ */
+static svn_error_t *
+construct_server_baton(server_baton_t **baton,
+                       svn_ra_svn_conn_t *conn,
+                       serve_params_t *params,
+                       const mux_server_t *mux,
+                       apr_pool_t *scratch_pool)
+{
+  svn_error_t *err, *io_err;
+  apr_uint64_t ver;
+  const char *client_url, *ra_client_string, *client_string;
+  svn_ra_svn__list_t *caplist;
+  svn_ra_svn__item_t *item;
+  svn_boolean_t offer_tls;
+  apr_pool_t *conn_pool = svn_ra_svn__get_pool(conn);
+  server_baton_t *b = apr_pcalloc(conn_pool, sizeof(*b));
+  fs_warning_baton_t *warn_baton;
+  svn_stringbuf_t *cap_log = svn_stringbuf_create_empty(scratch_pool);
+
+  b->repository = apr_pcalloc(conn_pool, sizeof(*b->repository));
+  b->repository->username_case = params->username_case;
+  b->repository->base = params->base;
+  b->repository->pwdb = NULL;
+  b->repository->authzdb = NULL;
+  b->repository->realm = NULL;
+  b->repository->use_sasl = FALSE;
+
+  b->read_only = params->read_only;
+  b->pool = conn_pool;
+  b->vhost = params->vhost;
+  b->params = params;
+  b->mux = NULL;
+
+  b->logger = params->logger;
+  b->client_info = get_client_info(conn, params, conn_pool);
+
+  /* Send greeting.  Offer TLS only on plain svn:// connections; the
+   * channels of a multiplexed connection share the TLS layer of their
+   * main connection. */
+  offer_tls = params->tls_ctx && !params->tunnel && !mux;
+  SVN_ERR(write_greeting(conn, params, offer_tls, scratch_pool));
 
   /* Read client response, which we assume to be in version 2 format:
    * version, capability list, and client URL; then we do an auth
-   * request. */
-  SVN_ERR(svn_ra_svn__read_tuple(conn, scratch_pool, "nlc?c(?c)",
-                                 &ver, &caplist, &client_url,
-                                 &ra_client_string,
-                                 &client_string));
+   * request.  Before that, the client may ask to switch to TLS. */
+  SVN_ERR(svn_ra_svn__read_item(conn, scratch_pool, &item));
+#ifdef SVN_HAVE_OPENSSL
+  if (offer_tls && is_starttls(item))
+    {
+      SVN_ERR(svn_ra_svn__write_cmd_response(conn, scratch_pool, ""));
+      SVN_ERR(svn_ra_svn__tls_accept(conn, params->tls_ctx, scratch_pool));
+
+      /* Start over, now through TLS. */
+      SVN_ERR(write_greeting(conn, params, FALSE, scratch_pool));
+      SVN_ERR(svn_ra_svn__read_item(conn, scratch_pool, &item));
+    }
+  else
+#endif
+  if (offer_tls && params->tls_only)
+    {
+      err = svn_error_create(SVN_ERR_RA_SVN_TLS_ERROR, NULL,
+                             _("This server requires TLS"));
+      io_err = svn_ra_svn__write_cmd_failure(conn, scratch_pool, err);
+      svn_error_clear(err);
+      SVN_ERR(io_err);
+      return svn_ra_svn__flush(conn, scratch_pool);
+    }
+
+  if (item->kind != SVN_RA_SVN_LIST)
+    return svn_error_create(SVN_ERR_RA_SVN_MALFORMED_DATA, NULL,
+                            _("Malformed network data"));
+  SVN_ERR(svn_ra_svn__parse_tuple(&item->u.list, "nlc?c(?c)",
+                                  &ver, &caplist, &client_url,
+                                  &ra_client_string,
+                                  &client_string));
   if (ver != 2)
     return SVN_NO_ERROR;
 
@@ -4260,7 +4897,15 @@ construct_server_baton(server_baton_t **baton,
     }
   if (!err)
     {
-      SVN_ERR(auth_request(conn, scratch_pool, b, READ_ACCESS, FALSE));
+      /* Don't make the user of a multiplexed connection authenticate
+         again for the same realm. */
+      if (mux && may_inherit_user(mux, b->repository, scratch_pool))
+        {
+          b->client_info->user = apr_pstrdup(conn_pool, mux->user);
+          SVN_ERR(trivial_auth_request(conn, scratch_pool, b));
+        }
+      else
+        SVN_ERR(auth_request(conn, scratch_pool, b, READ_ACCESS, FALSE));
       if (current_access(b) == NO_ACCESS)
         err = error_create_and_log(SVN_ERR_RA_NOT_AUTHORIZED, NULL,
                                    "Not authorized for access", b);
@@ -4277,6 +4922,9 @@ construct_server_baton(server_baton_t **baton,
   SVN_ERR(svn_fs_get_uuid(b->repository->fs, &b->repository->uuid,
                           conn_pool));
 
+  if (params->cache_responses)
+    SVN_ERR(create_response_cache(b->repository, conn_pool, scratch_pool));
+
   /* We can't claim mergeinfo capability until we know whether the
      repository supports mergeinfo (i.e., is not a 1.4 repository),
      but we don't get the repository url from the client until after
@@ -4339,6 +4987,184 @@ construct_server_baton(server_baton_t **baton,
   return SVN_NO_ERROR;
 }
 
+#if APR_HAS_THREADS
+
+/* A thread serving a channel, see serve_channel(). */
+typedef struct worker_t
+{
+  /* The thread and the pool that it has been created in. */
+  apr_thread_t *thread;
+  apr_pool_t *pool;
+
+  /* Set once the thread is about to exit. */
+  svn_atomic_t done;
+} worker_t;
+
+/* Baton for serve_channel(). */
+typedef struct channel_baton_t
+{
+  mux_server_t *mux;
+  svn_ra_svn_conn_t *conn;
+  apr_pool_t *pool;
+
+  /* Outlives POOL. */
+  worker_t *worker;
+} channel_baton_t;
+
+/* Serve the channel given by the channel_baton_t DATA until the client
+   closes it.  Then, release its pool. */
+static void * APR_THREAD_FUNC serve_channel(apr_thread_t *tid, void *data)
+{
+  channel_baton_t *channel = data;
+  serve_params_t *params = channel->mux->params;
+  worker_t *worker = channel->worker;
+  server_baton_t *b = NULL;
+  svn_error_t *err;
+
+  err = construct_server_baton(&b, channel->conn, params, channel->mux,
+                               channel->pool);
+  if (!err && b)
+    {
+      /* Channels cannot be multiplexed any further. */
+      b->mux = channel->mux;
+      err = svn_ra_svn__handle_commands2(channel->conn, channel->pool,
+                                         main_commands, b, FALSE);
+    }
+
+  if (err)
+    {
+      logger__log_error(params->logger, err, NULL,
+                        get_client_info(channel->conn, params,
+                                        channel->pool));
+      svn_error_clear(err);
+    }
+
+  /* This also closes the channel. */
+  svn_pool_destroy(channel->pool);
+  svn_atomic_set(&worker->done, TRUE);
+
+  return NULL;
+}
+
+/* Wait for the worker_t at index IDX in WORKERS to exit, release its
+   resources and remove it from WORKERS. */
+static void
+join_worker(apr_array_header_t *workers,
+            int idx)
+{
+  worker_t *worker = APR_ARRAY_IDX(workers, idx, worker_t *);
+  apr_status_t retval;
+
+  apr_thread_join(&retval, worker->thread);
+  svn_pool_destroy(worker->pool);
+
+  APR_ARRAY_IDX(workers, idx, worker_t *)
+    = APR_ARRAY_IDX(workers, workers->nelts - 1, worker_t *);
+  apr_array_pop(workers);
+}
+
+/* Accept new channels on the multiplexed connection given by the
+   mux_server_t DATA and serve each of them in a separate thread.
+   Return once the connection got closed and all channels have ended. */
+static void * APR_THREAD_FUNC accept_channels(apr_thread_t *tid, void *data)
+{
+  mux_server_t *mux = data;
+  apr_pool_t *pool = svn_pool_create(NULL);
+  apr_array_header_t *workers = apr_array_make(pool, 4,
+                                               sizeof(worker_t *));
+  svn_error_t *err = SVN_NO_ERROR;
+  int i;
+
+  while (!err)
+    {
+      apr_pool_t *channel_pool = svn_pool_create(NULL);
+      apr_pool_t *worker_pool;
+      channel_baton_t *channel;
+      svn_ra_svn_conn_t *conn;
+      worker_t *worker;
+      apr_status_t status;
+
+      err = svn_ra_svn__mux_accept(&conn, mux->conn, channel_pool);
+      if (err || !conn)
+        {
+          svn_pool_destroy(channel_pool);
+          break;
+        }
+
+      /* Don't accumulate threads over the lifetime of the connection. */
+      for (i = workers->nelts - 1; i >= 0; --i)
+        if (svn_atomic_read(&APR_ARRAY_IDX(workers, i, worker_t *)->done))
+          join_worker(workers, i);
+
+      worker_pool = svn_pool_create(pool);
+      worker = apr_pcalloc(worker_pool, sizeof(*worker));
+      worker->pool = worker_pool;
+      worker->done = FALSE;
+
+      channel = apr_pcalloc(channel_pool, sizeof(*channel));
+      channel->mux = mux;
+      channel->conn = conn;
+      channel->pool = channel_pool;
+      channel->worker = worker;
+
+      /* If we can't serve the channel, close it.  The client will fall
+         back to a separate connection. */
+      status = apr_thread_create(&worker->thread, NULL, serve_channel,
+                                 channel, worker_pool);
+      if (status)
+        {
+          svn_error_t *thread_err
+            = svn_error_wrap_apr(status, _("Can't create thread"));
+          logger__log_error(mux->params->logger, thread_err, NULL, NULL);
+          svn_error_clear(thread_err);
+          svn_pool_destroy(channel_pool);
+          svn_pool_destroy(worker_pool);
+        }
+      else
+        {
+          APR_ARRAY_PUSH(workers, worker_t *) = worker;
+        }
+    }
+
+  if (err)
+    {
+      logger__log_error(mux->params->logger, err, NULL, NULL);
+      svn_error_clear(err);
+    }
+
+  while (workers->nelts)
+    join_worker(workers, workers->nelts - 1);
+
+  svn_pool_destroy(pool);
+
+  return NULL;
+}
+
+/* Wait for all other channels of the multiplexed CONNECTION to end.
+   Channel 0 never ends on its own, so close the whole connection. */
+static void
+end_multiplexing(connection_t *connection)
+{
+  mux_server_t *mux = connection->baton->mux;
+  apr_status_t retval;
+
+  if (mux->acceptor)
+    {
+      apr_socket_shutdown(connection->usock, APR_SHUTDOWN_READWRITE);
+      apr_thread_join(&retval, mux->acceptor);
+      mux->acceptor = NULL;
+    }
+}
+
+#endif
+
+/* Return TRUE if CONNECTION has been multiplexed. */
+static svn_boolean_t
+is_multiplexed(connection_t *connection)
+{
+  return connection->baton && connection->baton->mux;
+}
+
 svn_error_t *
 serve_interruptable(svn_boolean_t *terminate_p,
                     connection_t *connection,
@@ -4386,7 +5212,7 @@ serve_interruptable(svn_boolean_t *terminate_p,
 
       /* Construct server baton and open the repository for the first time. */
       err = construct_server_baton(&connection->baton, connection->conn,
-                                   connection->params, pool);
+                                   connection->params, NULL, pool);
     }
 
   /* If we can't access the repo for some reason, end this connection. */
@@ -4397,7 +5223,10 @@ serve_interruptable(svn_boolean_t *terminate_p,
   while (!terminate && !err)
     {
       svn_pool_clear(iterpool);
-      if (is_busy && is_busy(connection))
+
+      /* The socket of a multiplexed connection may be read from other
+       * threads at any time.  So, we can't give it away. */
+      if (is_busy && !is_multiplexed(connection) && is_busy(connection))
         {
           svn_boolean_t has_command;
 
@@ -4412,7 +5241,9 @@ serve_interruptable(svn_boolean_t *terminate_p,
                                              connection->conn,
                                              FALSE, iterpool);
 
-          break;
+          /* That command may have been "multiplex". */
+          if (!is_multiplexed(connection))
+            break;
         }
       else
         {
@@ -4428,6 +5259,19 @@ serve_interruptable(svn_boolean_t *terminate_p,
         }
     }
 
+#if APR_HAS_THREADS
+  if (is_multiplexed(connection))
+    end_multiplexing(connection);
+#endif
+
+  /* Report how much data we could send without copying it around. */
+  if (terminate && connection->baton
+      && svn_ra_svn__sendfile_bytes(connection->conn))
+    svn_error_clear(log_command(connection->baton, connection->conn, pool,
+                                "sendfile-bytes %" APR_UINT64_T_FMT,
+                                svn_ra_svn__sendfile_bytes(
+                                                    connection->conn)));
+
   /* error or normal end of session. Close the connection */
   svn_pool_destroy(iterpool);
   if (terminate_p)
@@ -4442,6 +5286,6 @@ svn_error_t *serve(svn_ra_svn_conn_t *conn,
 {
   server_baton_t *baton = NULL;
 
-  SVN_ERR(construct_server_baton(&baton, conn, params, pool));
+  SVN_ERR(construct_server_baton(&baton, conn, params, NULL, pool));
   return svn_ra_svn__handle_commands2(conn, pool, main_commands, baton, FALSE);
 }
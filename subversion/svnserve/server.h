@@ -37,7 +37,9 @@ extern "C" {
 #include "svn_ra_svn.h"
 
 #include "private/svn_atomic.h"
+#include "private/svn_cache.h"
 #include "private/svn_mutex.h"
+#include "private/svn_ra_svn_private.h"
 #include "private/svn_repos_private.h"
 #include "private/svn_subr_private.h"
 
@@ -73,6 +75,9 @@ typedef struct repository_t {
   enum access_type auth_access; /* access granted to authenticated users */
   enum access_type anon_access; /* access granted to annonymous users */
 
+  svn_cache__t *response_cache; /* Marshalled responses to read-only
+                                   commands; NULL if disabled */
+
 } repository_t;
 
 typedef struct client_info_t {
@@ -90,6 +95,8 @@ typedef struct server_baton_t {
                               May be NULL even if log_file is not. */
   svn_boolean_t read_only; /* Disallow write access (global flag) */
   svn_boolean_t vhost;     /* Use virtual-host-based path to repo. */
+  struct serve_params_t *params; /* Server-global parameters */
+  struct mux_server_t *mux; /* Non-NULL, if the connection is multiplexed */
   apr_pool_t *pool;
 } server_baton_t;
 
@@ -159,6 +166,21 @@ typedef struct serve_params_t {
 
   /* Use virtual-host-based path to repo. */
   svn_boolean_t vhost;
+
+  /* True if clients may open further sessions on an existing connection.
+     Each of them will be served by a separate thread. */
+  svn_boolean_t multiplex;
+
+  /* True if responses to read-only commands may be cached and replayed
+     to other clients asking for the same data. */
+  svn_boolean_t cache_responses;
+
+  /* If not NULL, clients connecting via svn:// may switch to TLS using
+     this context. */
+  svn_ra_svn__tls_ctx_t *tls_ctx;
+
+  /* True if svn:// clients that don't switch to TLS are refused. */
+  svn_boolean_t tls_only;
 } serve_params_t;
 
 /* This structure contains all data that describes a client / server
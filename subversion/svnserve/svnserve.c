@@ -28,6 +28,7 @@
 #include <apr_general.h>
 #include <apr_getopt.h>
 #include <apr_network_io.h>
+#include <apr_poll.h>
 #include <apr_signal.h>
 #include <apr_thread_proc.h>
 #include <apr_portable.h>
@@ -49,6 +50,8 @@
 #include "svn_version.h"
 #include "svn_io.h"
 #include "svn_hash.h"
+#include "svn_user.h"
+#include "svn_checksum.h"
 
 #include "svn_private_config.h"
 
@@ -56,6 +59,7 @@
 #include "private/svn_cmdline_private.h"
 #include "private/svn_atomic.h"
 #include "private/svn_mutex.h"
+#include "private/svn_ra_svn_private.h"
 #include "private/svn_subr_private.h"
 
 #if APR_HAS_THREADS
@@ -70,6 +74,7 @@
 
 #include "server.h"
 #include "logger.h"
+#include "handover.h"
 
 /* The strategy for handling incoming connections.  Some of these may be
    unavailable due to platform limitations. */
@@ -145,6 +150,12 @@ enum run_mode {
  */
 #define THREADPOOL_THREAD_IDLE_LIMIT 1000000
 
+/* Maximum number of idle connections that become ready in a single
+ * iteration of the idle connection poller.  This is not a limit to the
+ * number of idle connections itself.
+ */
+#define IDLE_CONNECTIONS_BATCH_SIZE 1024
+
 /* Number of client to server connections that may concurrently in the
  * TCP 3-way handshake state, i.e. are in the process of being created.
  *
@@ -222,6 +233,11 @@ void winservice_notify_stop(void)
 #define SVNSERVE_OPT_MAX_REQUEST     274
 #define SVNSERVE_OPT_MAX_RESPONSE    275
 #define SVNSERVE_OPT_CACHE_NODEPROPS 276
+#define SVNSERVE_OPT_CACHE_RESPONSES 277
+#define SVNSERVE_OPT_TUNNEL_SOCKET   278
+#define SVNSERVE_OPT_TLS_CERT        279
+#define SVNSERVE_OPT_TLS_KEY         280
+#define SVNSERVE_OPT_TLS_ONLY        281
 
 /* Text macro because we can't use #ifdef sections inside a N_("...")
    macro expansion. */
@@ -325,6 +341,14 @@ static const apr_getopt_option_t svnserve__options[] =
         "Default is yes.\n"
         "                             "
         "[used for FSFS repositories only]")},
+    {"cache-responses", SVNSERVE_OPT_CACHE_RESPONSES, 1,
+     N_("enable or disable caching of responses to read-only\n"
+        "                             "
+        "commands like 'ls' and 'info'.  Responses that\n"
+        "                             "
+        "contain revision properties are never cached.\n"
+        "                             "
+        "Default is no.")},
     {"client-speed", SVNSERVE_OPT_CLIENT_SPEED, 1,
      N_("Optimize network handling based on the assumption\n"
         "                             "
@@ -410,6 +434,38 @@ static const apr_getopt_option_t svnserve__options[] =
      N_("tunnel username (default is current uid's name)\n"
         "                             "
         "[mode: tunnel]")},
+    {"tunnel-socket",    SVNSERVE_OPT_TUNNEL_SOCKET, 1,
+     N_("Unix socket at which a daemon takes over tunnel\n"
+        "                             "
+        "connections.  Tunnels hand their connection over\n"
+        "                             "
+        "to that daemon and fall back to serving it them-\n"
+        "                             "
+        "selves if there is none.  The daemon must run as\n"
+        "                             "
+        "the same user and with --threads.  It only takes\n"
+        "                             "
+        "connections from tunnels that use the same -r,\n"
+        "                             "
+        "--read-only and --config-file options and while\n"
+        "                             "
+        "it has fewer than max-threads of them.\n"
+        "                             "
+        "[mode: daemon, tunnel]")},
+#ifdef SVN_HAVE_OPENSSL
+    {"tls-cert",         SVNSERVE_OPT_TLS_CERT, 1,
+     N_("let svn:// clients switch to TLS, using the PEM\n"
+        "                             "
+        "encoded certificate chain in file ARG\n"
+        "                             "
+        "[mode: daemon, listen-once, inetd, service]")},
+    {"tls-key",          SVNSERVE_OPT_TLS_KEY, 1,
+     N_("PEM encoded private key for --tls-cert\n"
+        "                             "
+        "(default: read it from the --tls-cert file)")},
+    {"tls-only",         SVNSERVE_OPT_TLS_ONLY, 0,
+     N_("refuse svn:// clients that don't switch to TLS")},
+#endif
     {"help",             'h', 0, N_("display this help")},
     {"virtual-host",     SVNSERVE_OPT_VIRTUAL_HOST, 0,
      N_("virtual host mode (look for repo in directory\n"
@@ -479,6 +535,11 @@ static svn_error_t * version(svn_boolean_t quiet, apr_pool_t *pool)
                            _("\nCyrus SASL authentication is available.\n"));
 #endif
 
+#ifdef SVN_HAVE_OPENSSL
+  svn_stringbuf_appendcstr(version_footer,
+                           _("\nTLS for svn:// connections is available.\n"));
+#endif
+
   return svn_opt_print_help5(NULL, "svnserve", TRUE, quiet, FALSE,
                              version_footer->data,
                              NULL, NULL, NULL, NULL, NULL, pool);
@@ -614,22 +675,53 @@ static svn_root_pools__t *connection_pools;
 /* The global thread pool serving all connections. */
 static apr_thread_pool_t *threads;
 
+/* Connections that wait for the client to send its next command.
+   They don't occupy any thread in THREADS while being parked here.
+   NULL if the platform does not support thread-safe pollsets; idle
+   connections are then polled round-robin by the worker threads. */
+static apr_pollset_t *idle_connections;
+
 /* Very simple load determination callback for serve_interruptable:
-   With less than half the threads in THREADS in use, we can afford to
-   wait in the socket read() function.  Otherwise, poll them round-robin. */
+   If we can park idle connections, never wait for the next command in a
+   worker thread.  Otherwise, with less than half the threads in THREADS
+   in use, we can afford to wait in the socket read() function.  If more
+   are in use, poll them round-robin. */
 static svn_boolean_t
 is_busy(connection_t *connection)
 {
+  if (idle_connections)
+    return TRUE;
+
   return apr_thread_pool_threads_count(threads) * 2
        > apr_thread_pool_thread_max_get(threads);
 }
 
+/* Add CONNECTION to IDLE_CONNECTIONS.  Return FALSE if that failed.
+
+   Once this returned TRUE, CONNECTION may already be served again by
+   some other thread, i.e. the caller must not access it any further. */
+static svn_boolean_t
+park_connection(connection_t *connection)
+{
+  apr_pollfd_t descriptor = { 0 };
+
+  descriptor.p = connection->pool;
+  descriptor.desc_type = APR_POLL_SOCKET;
+  descriptor.desc.s = connection->usock;
+  descriptor.reqevents = APR_POLLIN;
+  descriptor.client_data = connection;
+
+  return apr_pollset_add(idle_connections, &descriptor) == APR_SUCCESS;
+}
+
 /* Serve the connection given by DATA.  Under high load, serve only
-   the current command (if any) and then put the connection back into
-   THREAD's task pool. */
+   the current command (if any).  Then park the connection until the
+   client sends the next command or, if that is not possible, put it
+   back into THREAD's task pool. */
 static void * APR_THREAD_FUNC serve_thread(apr_thread_t *tid, void *data)
 {
   svn_boolean_t done;
+  svn_boolean_t has_command = TRUE;
   connection_t *connection = data;
   svn_error_t *err;
 
@@ -637,6 +729,13 @@ static void * APR_THREAD_FUNC serve_thread(apr_thread_t *tid, void *data)
 
   /* process the actual request and log errors */
   err = serve_interruptable(&done, connection, is_busy, pool);
+
+  /* Did the client already send its next command (e.g. pipelining)?
+     This also flushes our response to the last one. */
+  if (!err && !done && idle_connections)
+    err = svn_ra_svn__has_command(&has_command, &done, connection->conn,
+                                  pool);
+
   if (err)
     {
       logger__log_error(connection->params->logger, err, NULL,
@@ -647,17 +746,228 @@ static void * APR_THREAD_FUNC serve_thread(apr_thread_t *tid, void *data)
     }
   svn_root_pools__release_pool(pool, connection_pools);
 
-  /* Close or re-schedule connection. */
+  /* Close, park or re-schedule connection. */
   if (done)
     close_connection(connection);
-  else
+  else if (has_command || !park_connection(connection))
     apr_thread_pool_push(threads, serve_thread, connection, 0, NULL);
 
   return NULL;
 }
 
+/* Event loop handing the connections in IDLE_CONNECTIONS back to the
+   worker THREADS as soon as there is data to read for them.  DATA is
+   the serve_params_t to use for logging. */
+static void * APR_THREAD_FUNC poll_thread(apr_thread_t *tid, void *data)
+{
+  serve_params_t *params = data;
+
+  while (1)
+    {
+      apr_int32_t count, i;
+      const apr_pollfd_t *descriptors;
+      apr_status_t status;
+
+      status = apr_pollset_poll(idle_connections, -1, &count, &descriptors);
+      if (APR_STATUS_IS_EINTR(status) || APR_STATUS_IS_TIMEUP(status))
+        continue;
+
+      if (status)
+        {
+          svn_error_t *err = svn_error_wrap_apr(status,
+                                     _("Can't poll idle connections"));
+          logger__log_error(params->logger, err, NULL, NULL);
+          svn_error_clear(err);
+
+          /* Don't spin if the error persists. */
+          apr_sleep(apr_time_from_msec(100));
+          continue;
+        }
+
+      for (i = 0; i < count; ++i)
+        {
+          apr_pollfd_t descriptor = descriptors[i];
+
+          /* Hand the connection over to a worker.  Socket errors and
+             closed connections will be detected there as well. */
+          apr_pollset_remove(idle_connections, &descriptor);
+          apr_thread_pool_push(threads, serve_thread,
+                               descriptor.client_data, 0, NULL);
+        }
+    }
+
+  /* NOTREACHED */
+  return NULL;
+}
+
+#ifdef SVNSERVE_HAVE_HANDOVER
+
+/* Baton for handover_thread(). */
+typedef struct handover_baton_t
+{
+  /* Where tunnel processes hand over their connections. */
+  handover_listener_t *listener;
+
+  /* Server-global parameters. */
+  serve_params_t *params;
+
+  /* Our get_handover_settings().  We only take connections from tunnel
+     processes that would serve them the same way. */
+  const char *settings;
+
+  /* Handed over connections occupy their thread until the client
+     disconnects.  Serve them in a thread pool of their own, so they
+     can't starve the socket connections in THREADS. */
+  apr_thread_pool_t *threads;
+
+  /* Number of connections currently being served by THREADS and the
+     limit beyond which we let the tunnel processes serve them. */
+  volatile svn_atomic_t active;
+  apr_size_t max_active;
+} handover_baton_t;
+
+/* A tunnel connection waiting to be served by serve_handover_thread(). */
+typedef struct handover_task_t
+{
+  handover_t *handover;
+  handover_baton_t *baton;
+
+  /* Root pool from CONNECTION_POOLS owning this structure and the
+     connection's file handles. */
+  apr_pool_t *pool;
+} handover_task_t;
+
+/* Serve the tunnel connection in the handover_task_t DATA as if we were
+   the "svnserve -t" process that handed it over to us.  Unlike sockets,
+   these connections never get parked, i.e. they occupy their worker
+   thread until the client disconnects. */
+static void * APR_THREAD_FUNC
+serve_handover_thread(apr_thread_t *tid, void *data)
+{
+  handover_task_t *task = data;
+  apr_pool_t *pool = task->pool;
+  apr_pool_t *connection_pool = svn_pool_create(pool);
+  serve_params_t *params = apr_pmemdup(pool, task->baton->params,
+                                       sizeof(*params));
+  svn_stream_t *in_stream
+    = svn_stream_from_aprfile2(task->handover->in_file, TRUE, pool);
+  svn_stream_t *out_stream
+    = svn_stream_from_aprfile2(task->handover->out_file, TRUE, pool);
+  svn_ra_svn_conn_t *conn;
+  svn_error_t *err;
+
+  params->tunnel = TRUE;
+  params->tunnel_user = task->handover->tunnel_user;
+  params->multiplex = FALSE;
+
+  conn = svn_ra_svn_create_conn5(NULL, in_stream, out_stream,
+                                 params->compression_level,
+                                 params->zero_copy_limit,
+                                 params->error_check_interval,
+                                 params->max_request_size,
+                                 params->max_response_size,
+                                 connection_pool);
+  err = serve(conn, params, connection_pool);
+  if (err)
+    {
+      logger__log_error(params->logger, err, NULL, NULL);
+      svn_error_clear(err);
+    }
+  svn_pool_destroy(connection_pool);
+
+  /* This closes the connection and lets the tunnel process exit. */
+  svn_atomic_dec(&task->baton->active);
+  svn_root_pools__release_pool(pool, connection_pools);
+
+  return NULL;
+}
+
+/* Accept connections handed over to the handover_baton_t DATA and pass
+   them on to the worker THREADS. */
+static void * APR_THREAD_FUNC handover_thread(apr_thread_t *tid, void *data)
+{
+  handover_baton_t *baton = data;
+
+  while (1)
+    {
+      apr_pool_t *pool = svn_root_pools__acquire_pool(connection_pools);
+      handover_task_t *task = apr_pcalloc(pool, sizeof(*task));
+      svn_boolean_t accept;
+      svn_error_t *err;
+
+      err = handover__accept(&task->handover, baton->listener, pool);
+      if (err)
+        {
+          logger__log_error(baton->params->logger, err, NULL, NULL);
+          svn_error_clear(err);
+          svn_root_pools__release_pool(pool, connection_pools);
+
+          /* Don't spin if the error persists. */
+          apr_sleep(apr_time_from_msec(100));
+          continue;
+        }
+
+      /* Tunnels with different settings and those that would have to
+         wait for a thread serve their connections themselves. */
+      if (strcmp(task->handover->settings, baton->settings))
+        {
+          err = svn_error_create(SVN_ERR_RA_NOT_AUTHORIZED, NULL,
+                                 _("Refused tunnel handover with different "
+                                   "server settings"));
+          logger__log_error(baton->params->logger, err, NULL, NULL);
+          svn_error_clear(err);
+          accept = FALSE;
+        }
+      else
+        accept = svn_atomic_read(&baton->active) < baton->max_active;
+
+      err = handover__reply(task->handover, accept, pool);
+      if (err || !accept)
+        {
+          if (err)
+            logger__log_error(baton->params->logger, err, NULL, NULL);
+          svn_error_clear(err);
+          svn_root_pools__release_pool(pool, connection_pools);
+          continue;
+        }
+
+      svn_atomic_inc(&baton->active);
+      task->baton = baton;
+      task->pool = pool;
+      apr_thread_pool_push(baton->threads, serve_handover_thread, task, 0,
+                           NULL);
+    }
+
+  /* NOTREACHED */
+  return NULL;
+}
+
+#endif /* SVNSERVE_HAVE_HANDOVER */
+
 #endif
 
+/* Return a short string that identifies the server settings in PARAMS
+   and CONFIG_FILENAME that a handed over connection would inherit from
+   the daemon serving it: the repository root, the read-only flag and the
+   configuration (and with it, authn and authz) of the repositories.
+   Allocate the result in POOL. */
+static const char *
+get_handover_settings(const serve_params_t *params,
+                      const char *config_filename,
+                      apr_pool_t *pool)
+{
+  svn_checksum_t *checksum;
+  const char *settings
+    = apr_psprintf(pool, "%" APR_SIZE_T_FMT ":%s %d %d %d %s",
+                   strlen(params->root), params->root,
+                   params->read_only, params->vhost, params->username_case,
+                   config_filename ? config_filename : "-");
+
+  svn_error_clear(svn_checksum(&checksum, svn_checksum_sha1, settings,
+                               strlen(settings), pool));
+  return svn_checksum_to_cstring_display(checksum, pool);
+}
+
 /* Write the PID of the current process as a decimal number, followed by a
    newline to the file FILENAME, using POOL for temporary allocations. */
 static svn_error_t *write_pid_file(const char *filename, apr_pool_t *pool)
@@ -739,6 +1049,14 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
   const char *config_filename = NULL;
   const char *pid_filename = NULL;
   const char *log_filename = NULL;
+  const char *tunnel_socket = NULL;
+#ifdef SVN_HAVE_OPENSSL
+  const char *tls_cert_filename = NULL;
+  const char *tls_key_filename = NULL;
+#endif
+#if APR_HAS_THREADS && defined(SVNSERVE_HAVE_HANDOVER)
+  handover_baton_t *handover_baton = NULL;
+#endif
   svn_node_kind_t kind;
   apr_size_t min_thread_count = THREADPOOL_MIN_SIZE;
   apr_size_t max_thread_count = THREADPOOL_MAX_SIZE;
@@ -774,6 +1092,10 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
   params.error_check_interval = 4096;
   params.max_request_size = MAX_REQUEST_SIZE * 0x100000;
   params.max_response_size = 0;
+  params.multiplex = FALSE;
+  params.cache_responses = FALSE;
+  params.tls_ctx = NULL;
+  params.tls_only = FALSE;
 
   while (1)
     {
@@ -925,6 +1247,11 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
           cache_nodeprops = svn_tristate__from_word(arg) == svn_tristate_true;
           break;
 
+        case SVNSERVE_OPT_CACHE_RESPONSES:
+          params.cache_responses
+            = svn_tristate__from_word(arg) == svn_tristate_true;
+          break;
+
         case SVNSERVE_OPT_BLOCK_READ:
           use_block_read = svn_tristate__from_word(arg) == svn_tristate_true;
           break;
@@ -995,6 +1322,35 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
           SVN_ERR(svn_dirent_get_absolute(&log_filename, log_filename, pool));
           break;
 
+        case SVNSERVE_OPT_TUNNEL_SOCKET:
+          SVN_ERR(svn_utf_cstring_to_utf8(&tunnel_socket, arg, pool));
+          tunnel_socket = svn_dirent_internal_style(tunnel_socket, pool);
+          SVN_ERR(svn_dirent_get_absolute(&tunnel_socket, tunnel_socket,
+                                          pool));
+          break;
+
+#ifdef SVN_HAVE_OPENSSL
+        case SVNSERVE_OPT_TLS_CERT:
+          SVN_ERR(svn_utf_cstring_to_utf8(&tls_cert_filename, arg, pool));
+          tls_cert_filename = svn_dirent_internal_style(tls_cert_filename,
+                                                        pool);
+          SVN_ERR(svn_dirent_get_absolute(&tls_cert_filename,
+                                          tls_cert_filename, pool));
+          break;
+
+        case SVNSERVE_OPT_TLS_KEY:
+          SVN_ERR(svn_utf_cstring_to_utf8(&tls_key_filename, arg, pool));
+          tls_key_filename = svn_dirent_internal_style(tls_key_filename,
+                                                       pool);
+          SVN_ERR(svn_dirent_get_absolute(&tls_key_filename,
+                                          tls_key_filename, pool));
+          break;
+
+        case SVNSERVE_OPT_TLS_ONLY:
+          params.tls_only = TRUE;
+          break;
+#endif
+
         }
     }
 
@@ -1038,6 +1394,14 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
 
   /* construct object pools */
   is_multi_threaded = handling_mode == connection_mode_thread;
+
+  /* Multiplexed connections need threads and caches that support them.
+   * Only the threaded listener waits for all channels to finish. */
+#if APR_HAS_THREADS
+  params.multiplex = is_multi_threaded
+                  && (   run_mode == run_mode_daemon
+                      || run_mode == run_mode_service);
+#endif
   params.fs_config = apr_hash_make(pool);
   svn_hash_sets(params.fs_config, SVN_FS_CONFIG_FSFS_CACHE_DELTAS,
                 cache_txdeltas ? "1" :"0");
@@ -1079,6 +1443,44 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
                _("Option --tunnel-user is only valid in tunnel mode"));
     }
 
+  if (tunnel_socket && run_mode != run_mode_tunnel)
+    {
+      if (run_mode != run_mode_daemon)
+        return svn_error_create(SVN_ERR_CL_ARG_PARSING_ERROR, NULL,
+                 _("Option --tunnel-socket is only valid in daemon and "
+                   "tunnel mode"));
+
+      /* Handed over connections block their worker thread and need
+       * caches that can be shared between threads. */
+      if (handling_mode != connection_mode_thread)
+        return svn_error_create(SVN_ERR_CL_ARG_PARSING_ERROR, NULL,
+                 _("Option --tunnel-socket requires --threads in daemon "
+                   "mode"));
+    }
+
+#ifdef SVN_HAVE_OPENSSL
+  if (tls_cert_filename)
+    {
+      if (run_mode == run_mode_tunnel)
+        return svn_error_create(SVN_ERR_CL_ARG_PARSING_ERROR, NULL,
+                 _("Option --tls-cert is not valid in tunnel mode"));
+
+      /* Load the certificate before forking, so that all connections
+       * share the context and can resume each others' sessions. */
+      SVN_ERR(svn_ra_svn__tls_server_ctx_create(&params.tls_ctx,
+                                                tls_cert_filename,
+                                                tls_key_filename
+                                                  ? tls_key_filename
+                                                  : tls_cert_filename,
+                                                pool));
+    }
+  else if (tls_key_filename || params.tls_only)
+    {
+      return svn_error_create(SVN_ERR_CL_ARG_PARSING_ERROR, NULL,
+               _("Options --tls-key and --tls-only require --tls-cert"));
+    }
+#endif
+
   if (run_mode == run_mode_inetd || run_mode == run_mode_tunnel)
     {
       apr_pool_t *connection_pool;
@@ -1086,6 +1488,24 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
       svn_stream_t *stdin_stream;
       svn_stream_t *stdout_stream;
 
+      /* Let a daemon with warm caches serve us, if there is one. */
+      if (run_mode == run_mode_tunnel && tunnel_socket)
+        {
+          svn_boolean_t handed_over = FALSE;
+          const char *tunnel_user = params.tunnel_user
+                                  ? params.tunnel_user
+                                  : svn_user_get_name(pool);
+
+          if (tunnel_user)
+            SVN_ERR(handover__send(&handed_over, tunnel_socket, tunnel_user,
+                                   get_handover_settings(&params,
+                                                         config_filename,
+                                                         pool),
+                                   pool));
+          if (handed_over)
+            return SVN_NO_ERROR;
+        }
+
       params.tunnel = (run_mode == run_mode_tunnel);
       apr_pool_cleanup_register(pool, pool, apr_pool_cleanup_null,
                                 redirect_stdout);
@@ -1236,6 +1656,22 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
       return svn_error_wrap_apr(status, _("Can't listen on server socket"));
     }
 
+  if (tunnel_socket)
+    {
+#if APR_HAS_THREADS && defined(SVNSERVE_HAVE_HANDOVER)
+      handover_baton = apr_pcalloc(pool, sizeof(*handover_baton));
+      handover_baton->params = &params;
+      handover_baton->settings = get_handover_settings(&params,
+                                                       config_filename,
+                                                       pool);
+      SVN_ERR(handover__listen(&handover_baton->listener, tunnel_socket,
+                               ACCEPT_BACKLOG, pool));
+#else
+      return svn_error_create(SVN_ERR_UNSUPPORTED_FEATURE, NULL,
+               _("Tunnel sockets are not supported on this platform"));
+#endif
+    }
+
 #if APR_HAS_FORK
   if (run_mode != run_mode_listen_once && !foreground)
     /* ### ignoring errors... */
@@ -1323,11 +1759,65 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
 
       /* don't queue requests unless we reached the worker thread limit */
       apr_thread_pool_threshold_set(threads, 0);
+
+      /* Park idle connections outside the worker threads, if the
+         platform provides a suitable pollset (e.g. epoll or kqueue).
+         Otherwise, fall back to polling them round-robin. */
+      status = apr_pollset_create(&idle_connections,
+                                  IDLE_CONNECTIONS_BATCH_SIZE, pool,
+                                  APR_POLLSET_THREADSAFE);
+      if (status == APR_SUCCESS)
+        {
+          apr_thread_t *tid;
+          apr_threadattr_t *tattr;
+
+          status = apr_threadattr_create(&tattr, pool);
+          if (!status)
+            status = apr_threadattr_detach_set(tattr, 1);
+          if (!status)
+            status = apr_thread_create(&tid, tattr, poll_thread, &params,
+                                       pool);
+          if (status)
+            return svn_error_wrap_apr(status,
+                                      _("Can't create poller thread"));
+        }
+      else
+        {
+          idle_connections = NULL;
+        }
     }
   else
     {
       threads = NULL;
+      idle_connections = NULL;
     }
+
+#ifdef SVNSERVE_HAVE_HANDOVER
+  /* Tunnel connections arrive through a separate listener. */
+  if (handover_baton)
+    {
+      apr_thread_t *tid;
+      apr_threadattr_t *tattr;
+
+      handover_baton->max_active = max_thread_count;
+      status = apr_thread_pool_create(&handover_baton->threads, 0,
+                                      max_thread_count, pool);
+      if (status)
+        return svn_error_wrap_apr(status, _("Can't create thread pool"));
+      apr_thread_pool_idle_wait_set(handover_baton->threads,
+                                    THREADPOOL_THREAD_IDLE_LIMIT);
+
+      status = apr_threadattr_create(&tattr, pool);
+      if (!status)
+        status = apr_threadattr_detach_set(tattr, 1);
+      if (!status)
+        status = apr_thread_create(&tid, tattr, handover_thread,
+                                   handover_baton, pool);
+      if (status)
+        return svn_error_wrap_apr(status,
+                                  _("Can't create tunnel listener thread"));
+    }
+#endif
 #endif
 
   while (1)
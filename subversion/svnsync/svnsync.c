@@ -678,6 +678,45 @@ log_properties_normalized(int normalized_rev_props_count,
 }
 
 
+/* Like copy_revprops() but with REV_PROPS being the revision properties
+ * of REV in the source repository and, if SYNC is TRUE, EXISTING_PROPS
+ * those of REV in the repository associated with TO_SESSION.
+ * REV_PROPS may get normalized in place.
+ */
+static svn_error_t *
+copy_fetched_revprops(svn_ra_session_t *to_session,
+                      svn_revnum_t rev,
+                      apr_hash_t *rev_props,
+                      apr_hash_t *existing_props,
+                      svn_boolean_t sync,
+                      svn_boolean_t skip_unchanged,
+                      svn_boolean_t quiet,
+                      const char *source_prop_encoding,
+                      int *normalized_count,
+                      apr_pool_t *pool)
+{
+  int filtered_count = 0;
+
+  /* If necessary, normalize encoding and line ending style and return the count
+     of EOL-normalized properties in int *NORMALIZED_COUNT. */
+  SVN_ERR(svnsync_normalize_revprops(rev_props, normalized_count,
+                                     source_prop_encoding, pool));
+
+  /* Copy all but the svn:svnsync properties. */
+  SVN_ERR(write_revprops(&filtered_count, to_session, rev, rev_props,
+                         skip_unchanged ? existing_props : NULL, pool));
+
+  /* Delete those properties that were in TARGET but not in SOURCE */
+  if (sync)
+    SVN_ERR(remove_props_not_in_source(to_session, rev,
+                                       rev_props, existing_props, pool));
+
+  if (! quiet)
+    SVN_ERR(log_properties_copied(filtered_count > 0, rev, pool));
+
+  return SVN_NO_ERROR;
+}
+
 /* Copy all the revision properties, except for those that have the
  * "svn:sync-" prefix, from revision REV of the repository associated
  * with RA session FROM_SESSION, to the repository associated with RA
@@ -710,7 +749,6 @@ copy_revprops(svn_ra_session_t *from_session,
 {
   apr_pool_t *subpool = svn_pool_create(pool);
   apr_hash_t *existing_props, *rev_props;
-  int filtered_count = 0;
 
   /* Get the list of revision properties on REV of TARGET. We're only interested
      in the property names, but we'll get the values 'for free'. */
@@ -722,22 +760,10 @@ copy_revprops(svn_ra_session_t *from_session,
   /* Get the list of revision properties on REV of SOURCE. */
   SVN_ERR(svn_ra_rev_proplist(from_session, rev, &rev_props, subpool));
 
-  /* If necessary, normalize encoding and line ending style and return the count
-     of EOL-normalized properties in int *NORMALIZED_COUNT. */
-  SVN_ERR(svnsync_normalize_revprops(rev_props, normalized_count,
-                                     source_prop_encoding, pool));
-
-  /* Copy all but the svn:svnsync properties. */
-  SVN_ERR(write_revprops(&filtered_count, to_session, rev, rev_props,
-                         skip_unchanged ? existing_props : NULL, pool));
-
-  /* Delete those properties that were in TARGET but not in SOURCE */
-  if (sync)
-    SVN_ERR(remove_props_not_in_source(to_session, rev,
-                                       rev_props, existing_props, pool));
-
-  if (! quiet)
-    SVN_ERR(log_properties_copied(filtered_count > 0, rev, pool));
+  SVN_ERR(copy_fetched_revprops(to_session, rev, rev_props, existing_props,
+                                sync, skip_unchanged, quiet,
+                                source_prop_encoding, normalized_count,
+                                pool));
 
   svn_pool_destroy(subpool);
 
@@ -1621,6 +1647,10 @@ synchronize_cmd(apr_getopt_t *os, void *b, apr_pool_t *pool)
 
 /*** `svnsync copy-revprops' ***/
 
+/* Maximum number of revisions whose properties do_copy_revprops()
+ * fetches with a single call. */
+#define REVPROPS_BATCH_SIZE 64
+
 /* Copy revision properties to the repository associated with RA
  * session TO_SESSION, using information found in BATON.
  *
@@ -1636,6 +1666,7 @@ do_copy_revprops(svn_ra_session_t *to_session,
   svn_revnum_t i;
   svn_revnum_t step = 1;
   int normalized_rev_props_count = 0;
+  apr_pool_t *iterpool;
 
   SVN_ERR(open_source_session(&from_session, &last_merged_rev,
                               baton->from_url, to_session,
@@ -1660,18 +1691,49 @@ do_copy_revprops(svn_ra_session_t *to_session,
        _("Cannot copy revprops for a revision (%ld) that has not "
          "been synchronized yet"), baton->end_rev);
 
-  /* Now, copy all the requested revisions, in the requested order. */
+  /* Now, copy all the requested revisions, in the requested order.
+     Fetch the revision properties of up to REVPROPS_BATCH_SIZE revisions
+     from both repositories at once, so the RA layers may pipeline the
+     requests. */
   step = (baton->start_rev > baton->end_rev) ? -1 : 1;
-  for (i = baton->start_rev; i != baton->end_rev + step; i = i + step)
+  iterpool = svn_pool_create(pool);
+  for (i = baton->start_rev; i != baton->end_rev + step; )
     {
-      int normalized_count;
+      apr_array_header_t *revs, *from_props, *to_props;
+      int k;
+
+      svn_pool_clear(iterpool);
+
+      revs = apr_array_make(iterpool, REVPROPS_BATCH_SIZE,
+                            sizeof(svn_revnum_t));
+      for (; i != baton->end_rev + step && revs->nelts < REVPROPS_BATCH_SIZE;
+           i = i + step)
+        APR_ARRAY_PUSH(revs, svn_revnum_t) = i;
+
       SVN_ERR(check_cancel(NULL));
-      SVN_ERR(copy_revprops(from_session, to_session, i, TRUE,
-                            baton->skip_unchanged, baton->quiet,
-                            baton->source_prop_encoding, &normalized_count,
-                            pool));
-      normalized_rev_props_count += normalized_count;
+      SVN_ERR(svn_ra__rev_proplists(to_session, &to_props, revs,
+                                    iterpool, iterpool));
+      SVN_ERR(svn_ra__rev_proplists(from_session, &from_props, revs,
+                                    iterpool, iterpool));
+
+      for (k = 0; k < revs->nelts; k++)
+        {
+          int normalized_count;
+          SVN_ERR(check_cancel(NULL));
+          SVN_ERR(copy_fetched_revprops(to_session,
+                                        APR_ARRAY_IDX(revs, k, svn_revnum_t),
+                                        APR_ARRAY_IDX(from_props, k,
+                                                      apr_hash_t *),
+                                        APR_ARRAY_IDX(to_props, k,
+                                                      apr_hash_t *),
+                                        TRUE, baton->skip_unchanged,
+                                        baton->quiet,
+                                        baton->source_prop_encoding,
+                                        &normalized_count, iterpool));
+          normalized_rev_props_count += normalized_count;
+        }
     }
+  svn_pool_destroy(iterpool);
 
   /* Notify about normalized props, if any. */
   SVN_ERR(log_properties_normalized(normalized_rev_props_count, 0, pool));
@@ -1185,6 +1185,54 @@ def checkout_wc_from_drive(sbox):
     # cleanup the virtual drive
     subprocess.call(['subst', '/D', drive +':'])
 
+#----------------------------------------------------------------------
+# svn:// checkouts may fetch each top-level directory over a connection
+# of its own.  The result must not differ from a plain checkout.  Other
+# RA layers ignore the option.
+def checkout_parallel_connections(sbox):
+  "checkout with parallel connections"
+
+  sbox.build()
+  sbox.simple_copy('A/B', 'Z')
+  sbox.simple_mkdir('Y')
+  sbox.simple_add_text("This is the file 'new'.\n", 'Y/new')
+  sbox.simple_propset('p', 'v', 'Y')
+  sbox.simple_commit(message='add more top-level directories')
+
+  wc2_dir = sbox.add_wc_path('2')
+
+  expected_disk = svntest.main.greek_state.copy()
+  expected_disk.add({
+    'Y'         : Item(),
+    'Y/new'     : Item(contents="This is the file 'new'.\n"),
+    'Z'         : Item(),
+    'Z/E'       : Item(),
+    'Z/E/alpha' : Item(contents="This is the file 'alpha'.\n"),
+    'Z/E/beta'  : Item(contents="This is the file 'beta'.\n"),
+    'Z/F'       : Item(),
+    'Z/lambda'  : Item(contents="This is the file 'lambda'.\n"),
+    })
+
+  expected_output = wc.State(wc2_dir, {})
+  for path in expected_disk.desc:
+    expected_output.add({ path : Item(status='A ') })
+
+  svntest.actions.run_and_verify_checkout(sbox.repo_url, wc2_dir,
+                                          expected_output, expected_disk,
+                                          [], '--config-option',
+                                          'servers:global:'
+                                          'svn-max-connections=3')
+
+  expected_status = svntest.actions.get_virginal_state(wc2_dir, 2)
+  for path in ['Y', 'Y/new', 'Z', 'Z/E', 'Z/E/alpha', 'Z/E/beta', 'Z/F',
+               'Z/lambda']:
+    expected_status.add({ path : Item(status='  ', wc_rev=2) })
+  svntest.actions.run_and_verify_status(wc2_dir, expected_status)
+
+  # Properties of top-level directories come with their sub-tree.
+  svntest.actions.run_and_verify_svn(['v\n'], [], 'propget', 'p',
+                                     sbox.ospath('Y', wc2_dir))
+
 #----------------------------------------------------------------------
 
 # list all tests here, starting with None:
@@ -1202,7 +1250,8 @@ test_list = [ None,
               checkout_peg_rev,
               checkout_peg_rev_date,
               co_with_obstructing_local_adds,
-              checkout_wc_from_drive
+              checkout_wc_from_drive,
+              checkout_parallel_connections,
             ]
 
 if __name__ == "__main__":
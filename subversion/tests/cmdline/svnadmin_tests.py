@@ -3965,6 +3965,39 @@ def dump_include_copied_directory(sbox):
   svntest.actions.run_and_verify_svn(expected_output, [],
                                      'log', '-v', '-q', sbox2.repo_url)
 
+@SkipUnless(svntest.main.is_fs_type_fsfs)
+@SkipUnless(svntest.main.python_sqlite_can_read_without_rowid)
+def load_bulk_checkpoint(sbox):
+  "svnadmin load --bulk-checkpoint"
+
+  sbox.build()
+  sbox.simple_append('iota', 'more text\n')
+  sbox.simple_commit()
+  sbox.simple_copy('iota', 'iota-copy')
+  sbox.simple_commit()
+  sbox.simple_add_text('new file\n', 'new')
+  sbox.simple_commit()
+
+  _, dump, _ = svntest.actions.run_and_verify_svnadmin(None, [],
+                                                       'dump', '-q',
+                                                       sbox.repo_dir)
+
+  # Load with a checkpoint after r3; the final checkpoint covering r4
+  # happens at the end of the load.
+  sbox2 = sbox.clone_dependent()
+  sbox2.build(create_wc=False, empty=True)
+  load_and_verify_dumpstream(sbox2, None, [], None, False, dump,
+                             '--bulk-checkpoint', '3')
+  svntest.actions.run_and_verify_svnlook(['4\n'], [], 'youngest',
+                                         sbox2.repo_dir)
+  svntest.actions.run_and_verify_svnadmin(None, [], 'verify', '-q',
+                                          sbox2.repo_dir)
+
+  # All rep-cache entries have been written, including those of r4.
+  revs = [row[0] for row in read_rep_cache(sbox2.repo_dir).values()]
+  if max(revs) != 4:
+    raise svntest.Failure
+
 ########################################################################
 # Run the tests
 
@@ -4043,6 +4076,7 @@ test_list = [ None,
               recover_prunes_rep_cache_when_enabled,
               recover_prunes_rep_cache_when_disabled,
               dump_include_copied_directory,
+              load_bulk_checkpoint,
              ]
 
 if __name__ == '__main__':
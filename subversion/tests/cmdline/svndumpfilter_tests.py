@@ -762,6 +762,24 @@ def drop_all_empty_revisions(sbox):
       None, filtered_err, None, expected_err)
 
 
+def dumpfilter_with_overlapping_prefixes(sbox):
+  "svndumpfilter with nested and partial prefixes"
+
+  sbox.build(empty=True)
+
+  dumpfile_location = os.path.join(os.path.dirname(sys.argv[0]),
+                                   'svndumpfilter_tests_data',
+                                   'greek_tree.dump')
+  dumpfile = svntest.actions.load_dumpfile(dumpfile_location)
+
+  # Prefixes match whole path components only, so '/A/D/gam' and '/A/m'
+  # must not drop 'A/D/gamma' and 'A/mu'.  Prefixes below other prefixes
+  # and prefixes of non-existent paths must not make a difference.
+  _simple_dumpfilter_test(sbox, dumpfile,
+                          'exclude', '/A/D/H/chi', '/A/B/E', '/A/D/gam',
+                          '/A/D/G', '/A/D/H', '/A/m', '/A/B/E/alpha/x',
+                          '/nonexistent')
+
 ########################################################################
 # Run the tests
 
@@ -778,6 +796,7 @@ test_list = [ None,
               accepts_deltas,
               dumpfilter_targets_expect_leading_slash_prefixes,
               drop_all_empty_revisions,
+              dumpfilter_with_overlapping_prefixes,
               ]
 
 if __name__ == '__main__':
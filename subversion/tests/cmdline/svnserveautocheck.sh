@@ -38,6 +38,8 @@
 #
 #  make svnserveautocheck BLOCK_READ=1       # run svnserve --block-read on
 #
+#  make svnserveautocheck CACHE_RESPONSES=1  # run svnserve --cache-responses
+#
 #  make svnserveautocheck THREADED=1         # run svnserve -T
 
 PYTHON=${PYTHON:-python}
@@ -166,6 +168,10 @@ if [ ${BLOCK_READ:+set} ]; then
   SVNSERVE_ARGS="$SVNSERVE_ARGS --block-read on"
 fi
 
+if [ ${CACHE_RESPONSES:+set} ]; then
+  SVNSERVE_ARGS="$SVNSERVE_ARGS --cache-responses yes"
+fi
+
 "$SERVER_CMD" -d -r "$ABS_BUILDDIR/subversion/tests/cmdline" \
             --listen-host 127.0.0.1 \
             --listen-port $SVNSERVE_PORT \
@@ -26,6 +26,8 @@
 #include <apr_general.h>
 #include <apr_pools.h>
 #include <apr_file_io.h>
+#include <apr_network_io.h>
+#include <apr_strings.h>
 #include <assert.h>
 
 #include "svn_error.h"
@@ -36,6 +38,9 @@
 #include "svn_cmdline.h"
 #include "svn_dirent_uri.h"
 #include "svn_hash.h"
+#include "svn_props.h"
+
+#include "private/svn_ra_private.h"
 
 #include "../svn_test.h"
 #include "../svn_test_fs.h"
@@ -143,6 +148,9 @@ typedef struct tunnel_baton_t
   int magic; /* TUNNEL_MAGIC */
   int open_count;
   svn_boolean_t last_check;
+
+  /* Socket at which "test-handover" tunnels hand over their connection. */
+  const char *tunnel_socket;
 } tunnel_baton_t;
 
 #define TUNNEL_MAGIC 0xF00DF00F
@@ -165,13 +173,39 @@ check_tunnel(void *tunnel_baton, const char *tunnel_name)
   if (b->magic != TUNNEL_MAGIC)
     abort();
 
-  b->last_check = (0 == strcmp(tunnel_name, "test"));
+  /* "test-cache" runs svnserve with its response cache enabled and
+     "test-handover" hands the connection over to a running daemon. */
+  b->last_check = (0 == strcmp(tunnel_name, "test")
+                   || 0 == strcmp(tunnel_name, "test-cache")
+                   || 0 == strcmp(tunnel_name, "test-handover"));
   return b->last_check;
 }
 
 static void
 close_tunnel(void *tunnel_context, void *tunnel_baton);
 
+/* Set *SVNSERVE to the absolute path of the svnserve binary under test.
+   Allocate it in POOL. */
+static svn_error_t *
+get_svnserve_path(const char **svnserve,
+                  apr_pool_t *pool)
+{
+  svn_node_kind_t kind;
+
+  SVN_ERR(svn_dirent_get_absolute(svnserve, "../../svnserve/svnserve",
+                                  pool));
+#ifdef WIN32
+  *svnserve = apr_pstrcat(pool, *svnserve, ".exe", SVN_VA_NULL);
+#endif
+  SVN_ERR(svn_io_check_path(*svnserve, &kind, pool));
+  if (kind != svn_node_file)
+    return svn_error_createf(SVN_ERR_TEST_FAILED, NULL,
+                             "Could not find svnserve at %s",
+                             svn_dirent_local_style(*svnserve, pool));
+
+  return SVN_NO_ERROR;
+}
+
 static svn_error_t *
 open_tunnel(svn_stream_t **request, svn_stream_t **response,
             svn_ra_close_tunnel_func_t *close_func, void **close_baton,
@@ -181,26 +215,28 @@ open_tunnel(svn_stream_t **request, svn_stream_t **response,
             svn_cancel_func_t cancel_func, void *cancel_baton,
             apr_pool_t *pool)
 {
-  svn_node_kind_t kind;
   apr_proc_t *proc;
   apr_procattr_t *attr;
   apr_status_t status;
-  const char *args[] = { "svnserve", "-t", "-r", ".", NULL };
+  const char *args[] = { "svnserve", "-t", "-r", ".", NULL, NULL, NULL };
   const char *svnserve;
   tunnel_baton_t *b = tunnel_baton;
   close_baton_t *cb;
 
   SVN_TEST_ASSERT(b->magic == TUNNEL_MAGIC);
 
-  SVN_ERR(svn_dirent_get_absolute(&svnserve, "../../svnserve/svnserve", pool));
-#ifdef WIN32
-  svnserve = apr_pstrcat(pool, svnserve, ".exe", SVN_VA_NULL);
-#endif
-  SVN_ERR(svn_io_check_path(svnserve, &kind, pool));
-  if (kind != svn_node_file)
-    return svn_error_createf(SVN_ERR_TEST_FAILED, NULL,
-                             "Could not find svnserve at %s",
-                             svn_dirent_local_style(svnserve, pool));
+  if (0 == strcmp(tunnel_name, "test-cache"))
+    {
+      args[4] = "--cache-responses";
+      args[5] = "yes";
+    }
+  else if (0 == strcmp(tunnel_name, "test-handover"))
+    {
+      args[4] = "--tunnel-socket";
+      args[5] = b->tunnel_socket;
+    }
+
+  SVN_ERR(get_svnserve_path(&svnserve, pool));
 
   status = apr_procattr_create(&attr, pool);
   if (status == APR_SUCCESS)
@@ -1785,6 +1821,978 @@ commit_locked_file(const svn_test_opts_t *opts, apr_pool_t *pool)
 }
 
 
+/* Compare the batched RA functions against their single-request
+   counterparts on SESSION, which has the tree of commit_tree() in r1.
+   The batches are longer than the pipeline window of ra_svn. */
+static svn_error_t *
+check_batched_requests(svn_ra_session_t *session,
+                       apr_pool_t *pool)
+{
+  static const char *const all_paths[]
+    = { "", "A", "A/B", "A/BB", "A/B/f", "A/BB/g", "X", "A/X" };
+  static const char *const dir_paths[] = { "", "A", "A/B", "A/BB" };
+  apr_array_header_t *paths = apr_array_make(pool, 0, sizeof(const char *));
+  apr_array_header_t *revs = apr_array_make(pool, 0, sizeof(svn_revnum_t));
+  apr_array_header_t *results;
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  svn_node_kind_t kind;
+  int i;
+
+  /* check-path */
+  for (i = 0; i < 40; i++)
+    {
+      APR_ARRAY_PUSH(paths, const char *)
+        = all_paths[i % (sizeof(all_paths) / sizeof(all_paths[0]))];
+      APR_ARRAY_PUSH(revs, svn_revnum_t) = i % 2;
+    }
+
+  SVN_ERR(svn_ra__check_paths(session, &results, paths, revs, pool, pool));
+  SVN_TEST_INT_ASSERT(results->nelts, paths->nelts);
+  for (i = 0; i < paths->nelts; i++)
+    {
+      svn_pool_clear(iterpool);
+      SVN_ERR(svn_ra_check_path(session, APR_ARRAY_IDX(paths, i, const char *),
+                                APR_ARRAY_IDX(revs, i, svn_revnum_t),
+                                &kind, iterpool));
+      SVN_TEST_ASSERT(APR_ARRAY_IDX(results, i, svn_node_kind_t) == kind);
+    }
+
+  /* get-dir */
+  apr_array_clear(paths);
+  apr_array_clear(revs);
+  for (i = 0; i < 40; i++)
+    {
+      APR_ARRAY_PUSH(paths, const char *)
+        = dir_paths[i % (sizeof(dir_paths) / sizeof(dir_paths[0]))];
+      APR_ARRAY_PUSH(revs, svn_revnum_t) = 1;
+    }
+
+  SVN_ERR(svn_ra__get_dirs(session, &results, paths, revs,
+                           SVN_DIRENT_KIND | SVN_DIRENT_CREATED_REV,
+                           pool, pool));
+  SVN_TEST_INT_ASSERT(results->nelts, paths->nelts);
+  for (i = 0; i < paths->nelts; i++)
+    {
+      apr_hash_t *batched = APR_ARRAY_IDX(results, i, apr_hash_t *);
+      apr_hash_t *dirents;
+      apr_hash_index_t *hi;
+
+      svn_pool_clear(iterpool);
+      SVN_ERR(svn_ra_get_dir2(session, &dirents, NULL, NULL,
+                              APR_ARRAY_IDX(paths, i, const char *), 1,
+                              SVN_DIRENT_KIND | SVN_DIRENT_CREATED_REV,
+                              iterpool));
+      SVN_TEST_INT_ASSERT(apr_hash_count(batched), apr_hash_count(dirents));
+      for (hi = apr_hash_first(iterpool, dirents); hi; hi = apr_hash_next(hi))
+        {
+          svn_dirent_t *expected = apr_hash_this_val(hi);
+          svn_dirent_t *actual = svn_hash_gets(batched, apr_hash_this_key(hi));
+
+          SVN_TEST_ASSERT(actual != NULL);
+          SVN_TEST_ASSERT(actual->kind == expected->kind);
+          SVN_TEST_INT_ASSERT(actual->created_rev, expected->created_rev);
+        }
+    }
+
+  /* rev-proplist */
+  apr_array_clear(revs);
+  for (i = 0; i < 40; i++)
+    APR_ARRAY_PUSH(revs, svn_revnum_t) = i % 2;
+
+  SVN_ERR(svn_ra__rev_proplists(session, &results, revs, pool, pool));
+  SVN_TEST_INT_ASSERT(results->nelts, revs->nelts);
+  for (i = 0; i < revs->nelts; i++)
+    {
+      apr_hash_t *batched = APR_ARRAY_IDX(results, i, apr_hash_t *);
+      apr_hash_t *props;
+
+      svn_pool_clear(iterpool);
+      SVN_ERR(svn_ra_rev_proplist(session, APR_ARRAY_IDX(revs, i,
+                                                         svn_revnum_t),
+                                  &props, iterpool));
+      SVN_TEST_INT_ASSERT(apr_hash_count(batched), apr_hash_count(props));
+      SVN_TEST_STRING_ASSERT(
+        ((svn_string_t *)svn_hash_gets(batched, SVN_PROP_REVISION_DATE))->data,
+        ((svn_string_t *)svn_hash_gets(props, SVN_PROP_REVISION_DATE))->data);
+    }
+
+  /* A failing request in the middle of a batch fails the whole batch
+     but leaves the session usable. */
+  apr_array_clear(paths);
+  apr_array_clear(revs);
+  for (i = 0; i < 40; i++)
+    {
+      APR_ARRAY_PUSH(paths, const char *) = (i == 5) ? "A/B/f" : "A";
+      APR_ARRAY_PUSH(revs, svn_revnum_t) = 1;
+    }
+
+  SVN_TEST_ASSERT_ANY_ERROR(svn_ra__get_dirs(session, &results, paths, revs,
+                                             SVN_DIRENT_KIND, pool, pool));
+  SVN_ERR(svn_ra_check_path(session, "A/B", 1, &kind, pool));
+  SVN_TEST_ASSERT(kind == svn_node_dir);
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+batched_requests_local(const svn_test_opts_t *opts,
+                       apr_pool_t *pool)
+{
+  svn_ra_session_t *session;
+
+  SVN_ERR(make_and_open_repos(&session, "test-repo-batched-local", opts,
+                              pool));
+  SVN_ERR(commit_tree(session, pool));
+
+  return svn_error_trace(check_batched_requests(session, pool));
+}
+
+/* Like batched_requests_local but over an ra_svn tunnel, where the
+   requests get pipelined. */
+static svn_error_t *
+batched_requests_tunnel(const svn_test_opts_t *opts,
+                        apr_pool_t *pool)
+{
+  tunnel_baton_t *b = apr_pcalloc(pool, sizeof(*b));
+  apr_pool_t *scratch_pool = svn_pool_create(pool);
+  const char *url;
+  svn_ra_callbacks2_t *cbtable;
+  svn_ra_session_t *session;
+  const char tunnel_repos_name[] = "test-repo-batched-tunnel";
+
+  b->magic = TUNNEL_MAGIC;
+
+  SVN_ERR(svn_test__create_repos(NULL, tunnel_repos_name, opts, scratch_pool));
+
+  /* Immediately close the repository to avoid race condition with svnserve
+  (and then the cleanup code) with BDB when our pool is cleared. */
+  svn_pool_clear(scratch_pool);
+
+  url = apr_pstrcat(pool, "svn+test://localhost/", tunnel_repos_name,
+                    SVN_VA_NULL);
+  SVN_ERR(svn_ra_initialize(pool));
+  SVN_ERR(svn_ra_create_callbacks(&cbtable, pool));
+  cbtable->check_tunnel_func = check_tunnel;
+  cbtable->open_tunnel_func = open_tunnel;
+  cbtable->tunnel_baton = b;
+  SVN_ERR(svn_cmdline_create_auth_baton2(&cbtable->auth_baton,
+                                         TRUE  /* non_interactive */,
+                                         "jrandom", "rayjandom",
+                                         NULL,
+                                         TRUE  /* no_auth_cache */,
+                                         FALSE /* trust_server_cert */,
+                                         FALSE, FALSE, FALSE, FALSE,
+                                         NULL, NULL, NULL, pool));
+
+  SVN_ERR(svn_ra_open4(&session, NULL, url, NULL, cbtable, NULL, NULL,
+                       scratch_pool));
+  SVN_ERR(commit_tree(session, scratch_pool));
+  SVN_ERR(check_batched_requests(session, scratch_pool));
+
+  svn_pool_destroy(scratch_pool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Return in *AUTHOR the last author of A/B/f at revision 1 as reported
+ * by svn_ra_get_dir2() on A/B if USE_DIR is set and by svn_ra_get_file()
+ * otherwise. */
+static svn_error_t *
+get_last_author(const char **author,
+                svn_ra_session_t *session,
+                svn_boolean_t use_dir,
+                apr_pool_t *pool)
+{
+  if (use_dir)
+    {
+      apr_hash_t *dirents;
+      svn_dirent_t *dirent;
+
+      SVN_ERR(svn_ra_get_dir2(session, &dirents, NULL, NULL, "A/B", 1,
+                              SVN_DIRENT_KIND | SVN_DIRENT_LAST_AUTHOR,
+                              pool));
+      dirent = svn_hash_gets(dirents, "f");
+      SVN_TEST_ASSERT(dirent);
+      *author = dirent->last_author;
+    }
+  else
+    {
+      apr_hash_t *props;
+      svn_string_t *value;
+
+      SVN_ERR(svn_ra_get_file(session, "A/B/f", 1, NULL, NULL, &props,
+                              pool));
+      value = svn_hash_gets(props, SVN_PROP_ENTRY_LAST_AUTHOR);
+      SVN_TEST_ASSERT(value);
+      *author = value->data;
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Check that svnserve's response cache never replays outdated revision
+   properties. */
+static svn_error_t *
+response_cache_revprop_change(const svn_test_opts_t *opts,
+                              apr_pool_t *pool)
+{
+  tunnel_baton_t *b = apr_pcalloc(pool, sizeof(*b));
+  apr_pool_t *scratch_pool = svn_pool_create(pool);
+  const char *url;
+  svn_ra_callbacks2_t *cbtable;
+  svn_ra_session_t *session;
+  svn_repos_t *repos;
+  apr_hash_t *dirents1, *dirents2;
+  svn_dirent_t *dirent;
+  const char *author;
+  const char tunnel_repos_name[] = "test-repo-response-cache";
+
+  b->magic = TUNNEL_MAGIC;
+
+  SVN_ERR(svn_test__create_repos(NULL, tunnel_repos_name, opts, scratch_pool));
+
+  /* Immediately close the repository to avoid race condition with svnserve
+  (and then the cleanup code) with BDB when our pool is cleared. */
+  svn_pool_clear(scratch_pool);
+
+  url = apr_pstrcat(pool, "svn+test-cache://localhost/", tunnel_repos_name,
+                    SVN_VA_NULL);
+  SVN_ERR(svn_ra_initialize(pool));
+  SVN_ERR(svn_ra_create_callbacks(&cbtable, pool));
+  cbtable->check_tunnel_func = check_tunnel;
+  cbtable->open_tunnel_func = open_tunnel;
+  cbtable->tunnel_baton = b;
+  SVN_ERR(svn_cmdline_create_auth_baton2(&cbtable->auth_baton,
+                                         TRUE  /* non_interactive */,
+                                         "jrandom", "rayjandom",
+                                         NULL,
+                                         TRUE  /* no_auth_cache */,
+                                         FALSE /* trust_server_cert */,
+                                         FALSE, FALSE, FALSE, FALSE,
+                                         NULL, NULL, NULL, pool));
+
+  SVN_ERR(svn_ra_open4(&session, NULL, url, NULL, cbtable, NULL, NULL,
+                       pool));
+  SVN_ERR(commit_tree(session, scratch_pool));
+
+  /* Cacheable responses are replayed faithfully. */
+  SVN_ERR(svn_ra_get_dir2(session, &dirents1, NULL, NULL, "A", 1,
+                          SVN_DIRENT_KIND, pool));
+  SVN_ERR(svn_ra_get_dir2(session, &dirents2, NULL, NULL, "A", 1,
+                          SVN_DIRENT_KIND, pool));
+  SVN_TEST_INT_ASSERT(apr_hash_count(dirents1), 2);
+  SVN_TEST_INT_ASSERT(apr_hash_count(dirents2), 2);
+  dirent = svn_hash_gets(dirents2, "B");
+  SVN_TEST_ASSERT(dirent && dirent->kind == svn_node_dir);
+  dirent = svn_hash_gets(dirents2, "BB");
+  SVN_TEST_ASSERT(dirent && dirent->kind == svn_node_dir);
+
+  /* Prime whatever svnserve might cache for the revprop-dependent data.
+     The tunnel user made the commit. */
+  SVN_ERR(get_last_author(&author, session, TRUE, scratch_pool));
+  SVN_TEST_ASSERT(author && strcmp(author, "someone-else"));
+  SVN_ERR(get_last_author(&author, session, FALSE, scratch_pool));
+  SVN_TEST_ASSERT(author && strcmp(author, "someone-else"));
+
+  /* Change the author behind svnserve's back. */
+  SVN_ERR(svn_repos_open3(&repos, tunnel_repos_name, NULL, scratch_pool,
+                          scratch_pool));
+  SVN_ERR(svn_fs_change_rev_prop2(svn_repos_fs(repos), 1,
+                                  SVN_PROP_REVISION_AUTHOR, NULL,
+                                  svn_string_create("someone-else",
+                                                    scratch_pool),
+                                  scratch_pool));
+  svn_pool_clear(scratch_pool);
+
+  /* The change must be visible immediately. */
+  SVN_ERR(get_last_author(&author, session, TRUE, scratch_pool));
+  SVN_TEST_STRING_ASSERT(author, "someone-else");
+  SVN_ERR(get_last_author(&author, session, FALSE, scratch_pool));
+  SVN_TEST_STRING_ASSERT(author, "someone-else");
+
+  svn_pool_destroy(scratch_pool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Start an "svnserve -d -T" daemon for the current directory that takes
+   over tunnel connections.  Pass EXTRA_ARG1 and EXTRA_ARG2 to it, unless
+   they are NULL.  Set *SOCKET_PATH to the daemon's tunnel socket and
+   *LOG_PATH to its log file.  The daemon gets killed and both files get
+   removed when POOL is cleared. */
+static svn_error_t *
+start_handover_daemon(const char **socket_path,
+                      const char **log_path,
+                      const char *extra_arg1,
+                      const char *extra_arg2,
+                      apr_pool_t *pool)
+{
+  const char *args[] = { "svnserve", "-d", "-T", "--foreground",
+                         "--listen-host", "127.0.0.1", "--listen-port", "0",
+                         "-r", ".", "--tunnel-socket", NULL,
+                         "--log-file", NULL, NULL, NULL, NULL };
+  const char *svnserve;
+  const char *temp_dir;
+  apr_procattr_t *attr;
+  apr_proc_t *proc;
+  apr_status_t status;
+  svn_node_kind_t kind = svn_node_none;
+  int i;
+
+  SVN_ERR(get_svnserve_path(&svnserve, pool));
+
+  /* Unix socket paths must be short, so use the system's temp dir. */
+  SVN_ERR(svn_io_temp_dir(&temp_dir, pool));
+  SVN_ERR(svn_io_open_unique_file3(NULL, socket_path, temp_dir,
+                                   svn_io_file_del_on_pool_cleanup,
+                                   pool, pool));
+  SVN_ERR(svn_io_remove_file2(*socket_path, FALSE, pool));
+  SVN_ERR(svn_io_open_unique_file3(NULL, log_path, temp_dir,
+                                   svn_io_file_del_on_pool_cleanup,
+                                   pool, pool));
+
+  args[11] = *socket_path;
+  args[13] = *log_path;
+  args[14] = extra_arg1;
+  args[15] = extra_arg2;
+
+  status = apr_procattr_create(&attr, pool);
+  if (status == APR_SUCCESS)
+    status = apr_procattr_cmdtype_set(attr, APR_PROGRAM);
+  proc = apr_palloc(pool, sizeof(*proc));
+  if (status == APR_SUCCESS)
+    status = apr_proc_create(proc,
+                             svn_dirent_local_style(svnserve, pool),
+                             args, NULL, attr, pool);
+  if (status != APR_SUCCESS)
+    return svn_error_wrap_apr(status, "Could not run svnserve");
+  apr_pool_note_subprocess(pool, proc, APR_KILL_ALWAYS);
+
+  /* Wait for the daemon to create its socket. */
+  for (i = 0; i < 100 && kind == svn_node_none; i++)
+    {
+      apr_sleep(apr_time_from_msec(100));
+      SVN_ERR(svn_io_check_path(*socket_path, &kind, pool));
+    }
+
+  if (kind == svn_node_none)
+    return svn_error_create(SVN_ERR_TEST_FAILED, NULL,
+                            "svnserve daemon did not create its socket");
+
+  /* Give it time to start listening. */
+  apr_sleep(apr_time_from_msec(100));
+
+  return SVN_NO_ERROR;
+}
+
+/* Open *SESSION to REPOS_NAME in the current directory through a
+   "test-handover" tunnel that offers its connection to the daemon at
+   SOCKET_PATH.  Allocate everything in POOL. */
+static svn_error_t *
+open_handover_session(svn_ra_session_t **session,
+                      const char *socket_path,
+                      const char *repos_name,
+                      apr_pool_t *pool)
+{
+  tunnel_baton_t *b = apr_pcalloc(pool, sizeof(*b));
+  svn_ra_callbacks2_t *cbtable;
+  const char *url;
+
+  b->magic = TUNNEL_MAGIC;
+  b->tunnel_socket = socket_path;
+
+  url = apr_pstrcat(pool, "svn+test-handover://localhost/", repos_name,
+                    SVN_VA_NULL);
+  SVN_ERR(svn_ra_create_callbacks(&cbtable, pool));
+  cbtable->check_tunnel_func = check_tunnel;
+  cbtable->open_tunnel_func = open_tunnel;
+  cbtable->tunnel_baton = b;
+  SVN_ERR(svn_cmdline_create_auth_baton2(&cbtable->auth_baton,
+                                         TRUE  /* non_interactive */,
+                                         "jrandom", "rayjandom",
+                                         NULL,
+                                         TRUE  /* no_auth_cache */,
+                                         FALSE /* trust_server_cert */,
+                                         FALSE, FALSE, FALSE, FALSE,
+                                         NULL, NULL, NULL, pool));
+
+  SVN_ERR(svn_ra_open4(session, NULL, url, NULL, cbtable, NULL, NULL,
+                       pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* Set *FOUND if the file at LOG_PATH contains TEXT. */
+static svn_error_t *
+log_contains(svn_boolean_t *found,
+             const char *log_path,
+             const char *text,
+             apr_pool_t *pool)
+{
+  svn_stringbuf_t *contents;
+
+  SVN_ERR(svn_stringbuf_from_file2(&contents, log_path, pool));
+  *found = strstr(contents->data, text) != NULL;
+
+  return SVN_NO_ERROR;
+}
+
+/* Skip the handover tests where svnserve can't pass on connections. */
+static svn_error_t *
+check_handover_support(void)
+{
+#if defined(WIN32) || !APR_HAS_THREADS
+  return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL,
+                          "tunnel handover not supported");
+#else
+  return SVN_NO_ERROR;
+#endif
+}
+
+/* Tunnels hand their connection over to a daemon with the same settings. */
+static svn_error_t *
+tunnel_handover(const svn_test_opts_t *opts,
+                apr_pool_t *pool)
+{
+  apr_pool_t *session_pool = svn_pool_create(pool);
+  const char *socket_path, *log_path;
+  svn_ra_session_t *session;
+  svn_revnum_t rev;
+  svn_boolean_t found;
+  const char repos_name[] = "test-repo-tunnel-handover";
+
+  SVN_ERR(check_handover_support());
+  SVN_ERR(svn_ra_initialize(pool));
+  SVN_ERR(svn_test__create_repos(NULL, repos_name, opts, session_pool));
+  svn_pool_clear(session_pool);
+
+  SVN_ERR(start_handover_daemon(&socket_path, &log_path, NULL, NULL, pool));
+  SVN_ERR(open_handover_session(&session, socket_path, repos_name,
+                                session_pool));
+  SVN_ERR(commit_tree(session, session_pool));
+  SVN_ERR(svn_ra_get_latest_revnum(session, &rev, session_pool));
+  SVN_TEST_INT_ASSERT(rev, 1);
+  svn_pool_destroy(session_pool);
+
+  /* The daemon served the connection. */
+  SVN_ERR(log_contains(&found, log_path, "get-latest-rev", pool));
+  SVN_TEST_ASSERT(found);
+
+  return SVN_NO_ERROR;
+}
+
+/* Daemons refuse connections from tunnels with different settings. */
+static svn_error_t *
+tunnel_handover_settings_mismatch(const svn_test_opts_t *opts,
+                                  apr_pool_t *pool)
+{
+  apr_pool_t *session_pool = svn_pool_create(pool);
+  const char *socket_path, *log_path;
+  svn_ra_session_t *session;
+  svn_revnum_t rev;
+  svn_boolean_t found;
+  const char repos_name[] = "test-repo-tunnel-handover-mismatch";
+
+  SVN_ERR(check_handover_support());
+  SVN_ERR(svn_ra_initialize(pool));
+  SVN_ERR(svn_test__create_repos(NULL, repos_name, opts, session_pool));
+  svn_pool_clear(session_pool);
+
+  /* A read-only daemon must not make read-write tunnels read-only. */
+  SVN_ERR(start_handover_daemon(&socket_path, &log_path, "--read-only",
+                                NULL, pool));
+  SVN_ERR(open_handover_session(&session, socket_path, repos_name,
+                                session_pool));
+  SVN_ERR(commit_tree(session, session_pool));
+  SVN_ERR(svn_ra_get_latest_revnum(session, &rev, session_pool));
+  SVN_TEST_INT_ASSERT(rev, 1);
+  svn_pool_destroy(session_pool);
+
+  /* The tunnel served the connection itself. */
+  SVN_ERR(log_contains(&found, log_path, "get-latest-rev", pool));
+  SVN_TEST_ASSERT(!found);
+  SVN_ERR(log_contains(&found, log_path, "Refused tunnel handover", pool));
+  SVN_TEST_ASSERT(found);
+
+  return SVN_NO_ERROR;
+}
+
+/* Daemons don't queue handed over connections when all their threads
+   for them are busy. */
+static svn_error_t *
+tunnel_handover_busy(const svn_test_opts_t *opts,
+                     apr_pool_t *pool)
+{
+  apr_pool_t *session_pool = svn_pool_create(pool);
+  const char *socket_path, *log_path;
+  svn_ra_session_t *session1, *session2;
+  svn_revnum_t rev;
+  svn_boolean_t found;
+  const char repos_name[] = "test-repo-tunnel-handover-busy";
+
+  SVN_ERR(check_handover_support());
+  SVN_ERR(svn_ra_initialize(pool));
+  SVN_ERR(svn_test__create_repos(NULL, repos_name, opts, session_pool));
+  svn_pool_clear(session_pool);
+
+  SVN_ERR(start_handover_daemon(&socket_path, &log_path, "--max-threads",
+                                "1", pool));
+
+  /* The first connection occupies the daemon's only thread ... */
+  SVN_ERR(open_handover_session(&session1, socket_path, repos_name,
+                                session_pool));
+  SVN_ERR(svn_ra_get_latest_revnum(session1, &rev, session_pool));
+  SVN_TEST_INT_ASSERT(rev, 0);
+
+  /* ... so the second tunnel has to serve its connection itself
+     instead of waiting for the first one to finish. */
+  SVN_ERR(open_handover_session(&session2, socket_path, repos_name,
+                                session_pool));
+  SVN_ERR(commit_tree(session2, session_pool));
+
+  SVN_ERR(svn_ra_get_latest_revnum(session1, &rev, session_pool));
+  SVN_TEST_INT_ASSERT(rev, 1);
+  svn_pool_destroy(session_pool);
+
+  SVN_ERR(log_contains(&found, log_path, "get-latest-rev", pool));
+  SVN_TEST_ASSERT(found);
+  SVN_ERR(log_contains(&found, log_path, "commit r1", pool));
+  SVN_TEST_ASSERT(!found);
+
+  return SVN_NO_ERROR;
+}
+
+/* Start an "svnserve -d -T" daemon for the current directory that listens
+   on a free port of the loopback interface.  Pass EXTRA_ARG1 and EXTRA_ARG2
+   to it, unless they are NULL.  Set *ROOT_URL to the URL of the daemon's
+   root directory.  The daemon gets killed when POOL is cleared. */
+static svn_error_t *
+start_listening_daemon(const char **root_url,
+                       const char *extra_arg1,
+                       const char *extra_arg2,
+                       apr_pool_t *pool)
+{
+  const char *args[] = { "svnserve", "-d", "-T", "--foreground",
+                         "--listen-host", "127.0.0.1", "--listen-port", NULL,
+                         "-r", ".", NULL, NULL, NULL };
+  const char *svnserve;
+  apr_sockaddr_t *addr;
+  apr_socket_t *sock;
+  apr_port_t port = 0;
+  apr_procattr_t *attr;
+  apr_proc_t *proc;
+  apr_status_t status;
+  int i;
+
+  SVN_ERR(get_svnserve_path(&svnserve, pool));
+
+  /* Let the system pick a port that is free right now. */
+  status = apr_sockaddr_info_get(&addr, "127.0.0.1", APR_INET, 0, 0, pool);
+  if (status == APR_SUCCESS)
+    status = apr_socket_create(&sock, APR_INET, SOCK_STREAM, APR_PROTO_TCP,
+                               pool);
+  if (status == APR_SUCCESS)
+    {
+      status = apr_socket_bind(sock, addr);
+      if (status == APR_SUCCESS)
+        status = apr_socket_addr_get(&addr, APR_LOCAL, sock);
+      if (status == APR_SUCCESS)
+        port = addr->port;
+      apr_socket_close(sock);
+    }
+  if (status == APR_SUCCESS)
+    status = apr_sockaddr_info_get(&addr, "127.0.0.1", APR_INET, port, 0,
+                                   pool);
+  if (status != APR_SUCCESS)
+    return svn_error_wrap_apr(status, "Could not find a free port");
+
+  args[7] = apr_itoa(pool, port);
+  args[10] = extra_arg1;
+  args[11] = extra_arg2;
+
+  status = apr_procattr_create(&attr, pool);
+  if (status == APR_SUCCESS)
+    status = apr_procattr_cmdtype_set(attr, APR_PROGRAM);
+  proc = apr_palloc(pool, sizeof(*proc));
+  if (status == APR_SUCCESS)
+    status = apr_proc_create(proc,
+                             svn_dirent_local_style(svnserve, pool),
+                             args, NULL, attr, pool);
+  if (status != APR_SUCCESS)
+    return svn_error_wrap_apr(status, "Could not run svnserve");
+  apr_pool_note_subprocess(pool, proc, APR_KILL_ALWAYS);
+
+  /* Wait for the daemon to accept connections. */
+  for (i = 0; i < 100; i++)
+    {
+      apr_sleep(apr_time_from_msec(100));
+      status = apr_socket_create(&sock, APR_INET, SOCK_STREAM,
+                                 APR_PROTO_TCP, pool);
+      if (status == APR_SUCCESS)
+        {
+          status = apr_socket_connect(sock, addr);
+          apr_socket_close(sock);
+        }
+      if (status == APR_SUCCESS)
+        break;
+    }
+
+  if (status != APR_SUCCESS)
+    return svn_error_create(SVN_ERR_TEST_FAILED, NULL,
+                            "svnserve daemon did not start listening");
+
+  *root_url = apr_psprintf(pool, "svn://127.0.0.1:%d", (int)port);
+
+  return SVN_NO_ERROR;
+}
+
+/* Skip the multiplexing tests where svnserve can't multiplex. */
+static svn_error_t *
+check_multiplex_support(void)
+{
+#if !APR_HAS_THREADS
+  return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL,
+                          "multiplexed connections not supported");
+#else
+  return SVN_NO_ERROR;
+#endif
+}
+
+/* Create the repository REPOS_NAME with a "secret" directory in r1 and
+   an svnserve.conf that grants ANON_ACCESS to anonymous users and takes
+   the users of REALM from the PASSWD file and the rules from the AUTHZ
+   file.  Use POOL for all allocations. */
+static svn_error_t *
+create_realm_repos(const char *repos_name,
+                   const char *anon_access,
+                   const char *passwd,
+                   const char *authz,
+                   const char *realm,
+                   const svn_test_opts_t *opts,
+                   apr_pool_t *pool)
+{
+  svn_repos_t *repos;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *root;
+  svn_revnum_t rev;
+
+  SVN_ERR(svn_test__create_repos(&repos, repos_name, opts, pool));
+  SVN_ERR(svn_fs_begin_txn2(&txn, svn_repos_fs(repos), 0, 0, pool));
+  SVN_ERR(svn_fs_txn_root(&root, txn, pool));
+  SVN_ERR(svn_fs_make_dir(root, "secret", pool));
+  SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &rev, txn, pool));
+  SVN_TEST_INT_ASSERT(rev, 1);
+
+  SVN_ERR(svn_io_file_create(svn_repos_svnserve_conf(repos, pool),
+                             apr_psprintf(pool,
+                                          "[general]\n"
+                                          "anon-access = %s\n"
+                                          "auth-access = write\n"
+                                          "password-db = %s\n"
+                                          "authz-db = %s\n"
+                                          "realm = %s\n",
+                                          anon_access, passwd, authz,
+                                          realm),
+                             pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* Set *VISIBLE if the user of SESSION may see the "secret" directory. */
+static svn_error_t *
+secret_visible(svn_boolean_t *visible,
+               svn_ra_session_t *session,
+               apr_pool_t *pool)
+{
+  apr_hash_t *dirents;
+
+  SVN_ERR(svn_ra_get_dir2(session, &dirents, NULL, NULL, "", 1,
+                          SVN_DIRENT_KIND, pool));
+  *visible = svn_hash_gets(dirents, "secret") != NULL;
+
+  return SVN_NO_ERROR;
+}
+
+/* Channels of a multiplexed connection only inherit the user of the main
+   connection for repositories that authenticate users the same way. */
+static svn_error_t *
+multiplex_inherit_user(const svn_test_opts_t *opts,
+                       apr_pool_t *pool)
+{
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  const char *root_url, *url, *conf_dir;
+  const char *passwd, *other_passwd, *authz, *other_authz;
+  svn_ra_callbacks2_t *cbtable;
+  svn_ra_session_t *session;
+  apr_size_t i;
+  const char repos_name[] = "test-repo-mux-inherit";
+
+  /* The channels open repositories nested in the main one, which look
+     like paths in the main repository to the client.  Anonymous users
+     may list them but only jrandom may see their "secret" directory. */
+  static const struct
+    {
+      const char *name;
+      svn_boolean_t other_realm;
+      svn_boolean_t other_passwd;
+      svn_boolean_t other_authz;
+    } channels[] =
+    {
+      { "same",   FALSE, FALSE, FALSE },
+      { "realm",  TRUE,  FALSE, FALSE },
+      { "passwd", FALSE, TRUE,  FALSE },
+      { "authz",  FALSE, FALSE, TRUE  }
+    };
+
+  SVN_ERR(check_multiplex_support());
+  SVN_ERR(svn_ra_initialize(pool));
+
+  SVN_ERR(svn_dirent_get_absolute(&conf_dir, repos_name, pool));
+  conf_dir = svn_dirent_join(conf_dir, "conf", pool);
+  passwd = svn_dirent_join(conf_dir, "passwd", pool);
+  other_passwd = svn_dirent_join(conf_dir, "other-passwd", pool);
+  authz = svn_dirent_join(conf_dir, "authz", pool);
+  other_authz = svn_dirent_join(conf_dir, "other-authz", pool);
+
+  SVN_ERR(create_realm_repos(repos_name, "none", passwd, authz,
+                             "mux realm", opts, iterpool));
+  svn_pool_clear(iterpool);
+
+  SVN_ERR(svn_io_file_create(passwd,
+                             "[users]\n"
+                             "jrandom = rayjandom\n",
+                             pool));
+  SVN_ERR(svn_io_file_create(other_passwd,
+                             "[users]\n"
+                             "jrandom = rayjandom\n"
+                             "harry = harryssecret\n",
+                             pool));
+  SVN_ERR(svn_io_file_create(authz,
+                             "[/]\n"
+                             "* = r\n"
+                             "jrandom = rw\n"
+                             "[/secret]\n"
+                             "* =\n"
+                             "jrandom = r\n",
+                             pool));
+  SVN_ERR(svn_io_file_create(other_authz,
+                             "[/]\n"
+                             "* = r\n"
+                             "jrandom = rw\n"
+                             "[/secret]\n"
+                             "* =\n"
+                             "jrandom = r\n"
+                             "[/other]\n"
+                             "jrandom = r\n",
+                             pool));
+
+  for (i = 0; i < sizeof(channels) / sizeof(channels[0]); i++)
+    {
+      svn_pool_clear(iterpool);
+      SVN_ERR(create_realm_repos(svn_relpath_join(repos_name,
+                                                  channels[i].name,
+                                                  iterpool),
+                                 "read",
+                                 channels[i].other_passwd ? other_passwd
+                                                          : passwd,
+                                 channels[i].other_authz ? other_authz
+                                                         : authz,
+                                 channels[i].other_realm ? "other realm"
+                                                         : "mux realm",
+                                 opts, iterpool));
+    }
+  svn_pool_clear(iterpool);
+
+  SVN_ERR(start_listening_daemon(&root_url, NULL, NULL, pool));
+
+  SVN_ERR(svn_ra_create_callbacks(&cbtable, pool));
+  SVN_ERR(svn_cmdline_create_auth_baton2(&cbtable->auth_baton,
+                                         TRUE  /* non_interactive */,
+                                         "jrandom", "rayjandom",
+                                         NULL,
+                                         TRUE  /* no_auth_cache */,
+                                         FALSE /* trust_server_cert */,
+                                         FALSE, FALSE, FALSE, FALSE,
+                                         NULL, NULL, NULL, pool));
+
+  /* The main repository admits authenticated users only. */
+  url = apr_pstrcat(pool, root_url, "/", repos_name, SVN_VA_NULL);
+  SVN_ERR(svn_ra_open4(&session, NULL, url, NULL, cbtable, NULL, NULL,
+                       pool));
+
+  /* Channels that don't inherit jrandom stay anonymous. */
+  for (i = 0; i < sizeof(channels) / sizeof(channels[0]); i++)
+    {
+      svn_ra_session_t *channel;
+      svn_boolean_t visible;
+      svn_boolean_t compatible = !channels[i].other_realm
+                              && !channels[i].other_passwd
+                              && !channels[i].other_authz;
+
+      svn_pool_clear(iterpool);
+      SVN_ERR(svn_ra__dup_session(&channel, session,
+                                  svn_path_url_add_component2(
+                                    url, channels[i].name, iterpool),
+                                  iterpool, iterpool));
+      SVN_ERR(secret_visible(&visible, channel, iterpool));
+
+      if (visible != compatible)
+        return svn_error_createf(SVN_ERR_TEST_FAILED, NULL,
+                                 "Channel to '%s' %s the user",
+                                 channels[i].name,
+                                 visible ? "inherited" : "did not inherit");
+    }
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Set *COUNT to the number of times TEXT occurs in the file at LOG_PATH. */
+static svn_error_t *
+log_count(int *count,
+          const char *log_path,
+          const char *text,
+          apr_pool_t *pool)
+{
+  svn_stringbuf_t *contents;
+  const char *found;
+
+  SVN_ERR(svn_stringbuf_from_file2(&contents, log_path, pool));
+  *count = 0;
+  for (found = strstr(contents->data, text);
+       found;
+       found = strstr(found + 1, text))
+    ++*count;
+
+  return SVN_NO_ERROR;
+}
+
+/* Fetch "big" in r1 through SESSION and check that it equals CONTENTS. */
+static svn_error_t *
+check_big_file(svn_ra_session_t *session,
+               const svn_stringbuf_t *contents,
+               apr_pool_t *pool)
+{
+  svn_stringbuf_t *fetched = svn_stringbuf_create_empty(pool);
+
+  SVN_ERR(svn_ra_get_file(session, "big", 1,
+                          svn_stream_from_stringbuf(fetched, pool),
+                          NULL, NULL, pool));
+  SVN_TEST_INT_ASSERT(fetched->len, contents->len);
+  SVN_TEST_ASSERT(memcmp(fetched->data, contents->data, contents->len) == 0);
+
+  return SVN_NO_ERROR;
+}
+
+/* svnserve sends large fulltexts that FSFS stores verbatim via sendfile.
+   Multiplexed connections copy them through their buffers instead.  The
+   client gets the same contents either way. */
+static svn_error_t *
+get_file_sendfile(const svn_test_opts_t *opts,
+                  apr_pool_t *pool)
+{
+  apr_pool_t *session_pool = svn_pool_create(pool);
+  const char *root_url, *url, *log_path, *temp_dir, *sendfile_line;
+  svn_stringbuf_t *contents;
+  svn_repos_t *repos;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *root;
+  svn_stream_t *stream;
+  svn_revnum_t rev;
+  svn_ra_callbacks2_t *cbtable;
+  svn_ra_session_t *session, *channel;
+  apr_size_t len;
+  int count, i;
+  const char repos_name[] = "test-repo-get-file-sendfile";
+
+  if (strcmp(opts->fs_type, SVN_FS_TYPE_FSFS) != 0)
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL,
+                            "sendfile needs FSFS");
+
+  SVN_ERR(check_multiplex_support());
+  SVN_ERR(svn_ra_initialize(pool));
+
+  /* Without compression, FSFS stores new fulltexts verbatim.  Several
+     times svnserve's chunk size and not too regular. */
+  SVN_ERR(svn_test__create_repos(NULL, repos_name, opts, session_pool));
+  SVN_ERR(svn_io_file_create(svn_dirent_join_many(session_pool, repos_name,
+                                                  "db", "fsfs.conf",
+                                                  SVN_VA_NULL),
+                             "[deltification]\n"
+                             "compression = none\n",
+                             session_pool));
+  SVN_ERR(svn_repos_open3(&repos, repos_name, NULL, session_pool,
+                          session_pool));
+
+  contents = svn_stringbuf_create_ensure(0xC0123, pool);
+  for (i = 0; i < 0xC0123; i++)
+    svn_stringbuf_appendbyte(contents, (char)(i * 7 + i / 251));
+
+  SVN_ERR(svn_fs_begin_txn2(&txn, svn_repos_fs(repos), 0, 0, session_pool));
+  SVN_ERR(svn_fs_txn_root(&root, txn, session_pool));
+  SVN_ERR(svn_fs_make_file(root, "big", session_pool));
+  SVN_ERR(svn_fs_apply_text(&stream, root, "big", NULL, session_pool));
+  len = contents->len;
+  SVN_ERR(svn_stream_write(stream, contents->data, &len));
+  SVN_ERR(svn_stream_close(stream));
+  SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &rev, txn, session_pool));
+  SVN_TEST_INT_ASSERT(rev, 1);
+  svn_pool_clear(session_pool);
+
+  SVN_ERR(svn_io_temp_dir(&temp_dir, pool));
+  SVN_ERR(svn_io_open_unique_file3(NULL, &log_path, temp_dir,
+                                   svn_io_file_del_on_pool_cleanup,
+                                   pool, pool));
+  SVN_ERR(start_listening_daemon(&root_url, "--log-file", log_path, pool));
+
+  SVN_ERR(svn_ra_create_callbacks(&cbtable, pool));
+  SVN_ERR(svn_test__init_auth_baton(&cbtable->auth_baton, pool));
+  url = apr_pstrcat(pool, root_url, "/", repos_name, SVN_VA_NULL);
+
+  /* Fetch through a multiplexed connection first ... */
+  SVN_ERR(svn_ra_open4(&session, NULL, url, NULL, cbtable, NULL, NULL,
+                       session_pool));
+  SVN_ERR(svn_ra__dup_session(&channel, session, NULL, session_pool,
+                              session_pool));
+  SVN_ERR(check_big_file(session, contents, session_pool));
+  SVN_ERR(check_big_file(channel, contents, session_pool));
+  svn_pool_clear(session_pool);
+
+  /* ... and then through a plain one. */
+  SVN_ERR(svn_ra_open4(&session, NULL, url, NULL, cbtable, NULL, NULL,
+                       session_pool));
+  SVN_ERR(check_big_file(session, contents, session_pool));
+  svn_pool_destroy(session_pool);
+
+#if APR_HAS_SENDFILE
+  /* svnserve logs the sendfile total when the connection ends.  Only the
+     plain connection sent anything that way. */
+  sendfile_line = apr_psprintf(pool, "sendfile-bytes %" APR_SIZE_T_FMT,
+                               contents->len);
+  for (i = 0; i < 100; i++)
+    {
+      SVN_ERR(log_count(&count, log_path, sendfile_line, pool));
+      if (count)
+        break;
+
+      apr_sleep(apr_time_from_msec(100));
+    }
+
+  SVN_TEST_INT_ASSERT(count, 1);
+  SVN_ERR(log_count(&count, log_path, "sendfile-bytes", pool));
+  SVN_TEST_INT_ASSERT(count, 1);
+#else
+  sendfile_line = "sendfile-bytes";
+  SVN_ERR(log_count(&count, log_path, sendfile_line, pool));
+  SVN_TEST_INT_ASSERT(count, 0);
+#endif
+
+  return SVN_NO_ERROR;
+}
+
 /* The test table.  */
 
 static int max_threads = 4;
@@ -1820,6 +2828,22 @@ static struct svn_test_descriptor_t test_funcs[] =
                        "check how last change applies to empty commit"),
     SVN_TEST_OPTS_PASS(commit_locked_file,
                        "check commit editor for a locked file"),
+    SVN_TEST_OPTS_PASS(batched_requests_local,
+                       "batched requests over ra_local"),
+    SVN_TEST_OPTS_PASS(batched_requests_tunnel,
+                       "pipelined batched requests over ra_svn"),
+    SVN_TEST_OPTS_PASS(response_cache_revprop_change,
+                       "svnserve response cache and revprop changes"),
+    SVN_TEST_OPTS_PASS(tunnel_handover,
+                       "hand tunnel connections over to a daemon"),
+    SVN_TEST_OPTS_PASS(tunnel_handover_settings_mismatch,
+                       "refuse handover with different settings"),
+    SVN_TEST_OPTS_PASS(tunnel_handover_busy,
+                       "refuse handover while the daemon is busy"),
+    SVN_TEST_OPTS_PASS(multiplex_inherit_user,
+                       "channels inherit users of compatible realms"),
+    SVN_TEST_OPTS_PASS(get_file_sendfile,
+                       "get-file via sendfile and its fallback"),
     SVN_TEST_NULL
   };
 
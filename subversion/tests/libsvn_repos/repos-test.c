@@ -40,6 +40,7 @@
 #include "svn_sorts.h"
 #include "svn_version.h"
 #include "private/svn_repos_private.h"
+#include "private/svn_fspath.h"
 #include "private/svn_dep_compat.h"
 
 /* be able to look into svn_config_t */
@@ -897,6 +898,88 @@ node_locations2(const svn_test_opts_t *opts,
   return SVN_NO_ERROR;
 }
 
+/* Create the repository NAME with the UUID UUID (if not NULL).  In r1, add
+   the file FROM_DIR/file, and in r2 copy FROM_DIR to /copy.  Return the
+   filesystem in *FS. */
+static svn_error_t *
+create_copied_file_repos(svn_fs_t **fs,
+                         const char *name,
+                         const char *uuid,
+                         const char *from_dir,
+                         const svn_test_opts_t *opts,
+                         apr_pool_t *pool)
+{
+  apr_pool_t *subpool = svn_pool_create(pool);
+  svn_repos_t *repos;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *txn_root, *root;
+  svn_revnum_t youngest_rev = 0;
+
+  SVN_ERR(svn_test__create_repos(&repos, name, opts, pool));
+  *fs = svn_repos_fs(repos);
+  if (uuid)
+    SVN_ERR(svn_fs_set_uuid(*fs, uuid, pool));
+
+  SVN_ERR(svn_fs_begin_txn(&txn, *fs, youngest_rev, subpool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, subpool));
+  SVN_ERR(svn_fs_make_dir(txn_root, from_dir, subpool));
+  SVN_ERR(svn_fs_make_file(txn_root,
+                           svn_fspath__join(from_dir, "file", subpool),
+                           subpool));
+  SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &youngest_rev, txn, subpool));
+  SVN_TEST_ASSERT(SVN_IS_VALID_REVNUM(youngest_rev));
+  svn_pool_clear(subpool);
+
+  SVN_ERR(svn_fs_begin_txn(&txn, *fs, youngest_rev, subpool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, subpool));
+  SVN_ERR(svn_fs_revision_root(&root, *fs, youngest_rev, subpool));
+  SVN_ERR(svn_fs_copy(root, from_dir, txn_root, "/copy", subpool));
+  SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &youngest_rev, txn, subpool));
+  SVN_TEST_ASSERT(SVN_IS_VALID_REVNUM(youngest_rev));
+  svn_pool_destroy(subpool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Node locations that have been traced in a repository must not be
+   reported for a replacement with the same UUID at the same path. */
+static svn_error_t *
+node_locations_replaced_repos(const svn_test_opts_t *opts,
+                              apr_pool_t *pool)
+{
+  svn_fs_t *fs;
+  const char *uuid;
+
+  SVN_ERR(create_copied_file_repos(&fs, "test-repo-node-locations-replaced",
+                                   NULL, "/foo", opts, pool));
+  {
+    struct locations_info info[] =
+      {
+        { 1, "/foo/file" },
+        { 2, "/copy/file" },
+        { 0 }
+      };
+    SVN_ERR(check_locations(fs, info, "/copy/file", 2, pool));
+  }
+
+  /* Replace the repository, as a dump / load cycle with a different
+     history would do. */
+  SVN_ERR(svn_fs_get_uuid(fs, &uuid, pool));
+  SVN_ERR(create_copied_file_repos(&fs, "test-repo-node-locations-replaced",
+                                   uuid, "/bar", opts, pool));
+  {
+    struct locations_info info[] =
+      {
+        { 1, "/bar/file" },
+        { 2, "/copy/file" },
+        { 0 }
+      };
+    SVN_ERR(check_locations(fs, info, "/copy/file", 2, pool));
+  }
+
+  return SVN_NO_ERROR;
+}
+
 
 
 /* Testing the reporter. */
@@ -3274,6 +3357,134 @@ reporter_depth_exclude(const svn_test_opts_t *opts,
 }
 
 
+
+/* Check that a report with prefetching enabled drives the editor
+   exactly like one without it. */
+static svn_error_t *
+reporter_prefetch(const svn_test_opts_t *opts,
+                  apr_pool_t *pool)
+{
+  svn_repos_t *repos;
+  svn_fs_t *fs;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *txn_root;
+  svn_revnum_t youngest_rev;
+  const svn_delta_editor_t *editor;
+  void *edit_baton, *report_baton;
+  int i;
+  apr_pool_t *subpool = svn_pool_create(pool);
+  static svn_test__tree_entry_t entries[] = {
+    { "iota",        "This is the file 'iota'.\n" },
+    { "A",           0 },
+    { "A/mu",        "This is the file 'mu'.\n" },
+    { "A/B",         0 },
+    { "A/B/lambda",  "This is the file 'lambda'.\n" },
+    { "A/B/E",       0 },
+    { "A/B/E/alpha", "This is the file 'alpha'.\n" },
+    { "A/B/E/beta",  "This is the file 'beta'.\n" },
+    { "A/B/F",       0 },
+    { "A/C",         0 },
+    { "A/D",         0 },
+    { "A/D/gamma",   "This is the file 'gamma'.\n" },
+    { "A/D/G",       0 },
+    { "A/D/G/pi",    "This is the file 'pi'.\n" },
+    { "A/D/G/rho",   "This is the file 'rho'.\n" },
+    { "A/D/G/tau",   "This is the file 'tau'.\n" },
+    { "A/D/H",       0 },
+    { "A/D/H/chi",   "This is the file 'chi'.\n" },
+    { "A/D/H/psi",   "This is the file 'psi'.\n" },
+    { "A/D/H/omega", "This is the file 'omega'.\n" },
+    { "X",           0 },
+    { "X/x",         "This is the file 'x'.\n" },
+    { "Y",           0 },
+    { "Y/y",         "This is the file 'y'.\n" },
+    { "Z",           0 },
+    { "Z/Z1",        0 },
+    { "Z/Z1/z",      "This is the file 'z'.\n" }
+  };
+
+  /* Create a repository with several top-level directories, so that
+     a checkout report schedules more than one prefetch task. */
+  SVN_ERR(svn_test__create_repos(&repos, "test-repo-reporter-prefetch",
+                                 opts, pool));
+  fs = svn_repos_fs(repos);
+
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, 0, subpool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, subpool));
+  SVN_ERR(svn_test__create_greek_tree(txn_root, subpool));
+  {
+    static svn_test__txn_script_command_t script_entries[] = {
+      { 'a', "X",      NULL },
+      { 'a', "X/x",    "This is the file 'x'.\n" },
+      { 'a', "Y",      NULL },
+      { 'a', "Y/y",    "This is the file 'y'.\n" },
+      { 'a', "Z",      NULL },
+      { 'a', "Z/Z1",   NULL },
+      { 'a', "Z/Z1/z", "This is the file 'z'.\n" }
+    };
+    SVN_ERR(svn_test__txn_script_exec(txn_root,
+                                      script_entries,
+                                      sizeof(script_entries)/
+                                       sizeof(script_entries[0]),
+                                      subpool));
+  }
+  SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &youngest_rev, txn, subpool));
+  SVN_TEST_ASSERT(SVN_IS_VALID_REVNUM(youngest_rev));
+  svn_pool_clear(subpool);
+
+  svn_repos__set_report_prefetch(repos, TRUE);
+
+  /* Run the same checkout report twice, the second one reusing the
+     shared threads left behind by the first one.  Record the editor
+     commands in a temporary txn each time. */
+  for (i = 0; i < 2; ++i)
+    {
+      SVN_ERR(svn_fs_begin_txn(&txn, fs, 0, subpool));
+      SVN_ERR(svn_fs_txn_root(&txn_root, txn, subpool));
+      SVN_ERR(dir_delta_get_editor(&editor, &edit_baton, fs,
+                                   txn_root, "", subpool));
+
+      SVN_ERR(svn_repos_begin_report3(&report_baton, youngest_rev, repos,
+                                      "/", "", NULL, TRUE,
+                                      svn_depth_infinity, FALSE, FALSE,
+                                      editor, edit_baton, NULL, NULL, 0,
+                                      subpool));
+      SVN_ERR(svn_repos_set_path3(report_baton, "", 0,
+                                  svn_depth_infinity,
+                                  FALSE, NULL, subpool));
+      SVN_ERR(svn_repos_finish_report(report_baton, subpool));
+
+      SVN_ERR(svn_test__validate_tree(txn_root,
+                                      entries,
+                                      sizeof(entries)/sizeof(entries[0]),
+                                      subpool));
+
+      SVN_ERR(svn_fs_abort_txn(txn, subpool));
+      svn_pool_clear(subpool);
+    }
+
+  /* An aborted report must stop its prefetch tasks cleanly. */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, 0, subpool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, subpool));
+  SVN_ERR(dir_delta_get_editor(&editor, &edit_baton, fs,
+                               txn_root, "", subpool));
+  SVN_ERR(svn_repos_begin_report3(&report_baton, youngest_rev, repos,
+                                  "/", "", NULL, TRUE,
+                                  svn_depth_infinity, FALSE, FALSE,
+                                  editor, edit_baton, NULL, NULL, 0,
+                                  subpool));
+  SVN_ERR(svn_repos_set_path3(report_baton, "", 0,
+                              svn_depth_infinity,
+                              FALSE, NULL, subpool));
+  SVN_ERR(svn_repos_abort_report(report_baton, subpool));
+  SVN_ERR(svn_fs_abort_txn(txn, subpool));
+
+  svn_pool_destroy(subpool);
+
+  return SVN_NO_ERROR;
+}
+
+
 
 /* Test if prop values received by the server are validated.
  * These tests "send" property values to the server and diagnose the
@@ -3643,6 +3854,139 @@ test_get_file_revs(const svn_test_opts_t *opts,
   return SVN_NO_ERROR;
 }
 
+/* Baton for file_rev_contents_handler(). */
+typedef struct file_rev_contents_baton_t {
+    /* Fulltexts reconstructed so far, indexed by revision. */
+    svn_stringbuf_t *contents[10];
+
+    /* Fulltext of the last revision reported. */
+    svn_stringbuf_t *last;
+
+    apr_pool_t *pool;
+} file_rev_contents_baton_t;
+
+/* Reconstruct the fulltext of REV from the delta that will be sent
+   against the previous revision and store it in the
+   file_rev_contents_baton_t given by BATON. */
+static svn_error_t *
+file_rev_contents_handler(void *baton, const char *path, svn_revnum_t rev,
+                          apr_hash_t *rev_props,
+                          svn_boolean_t result_of_merge,
+                          svn_txdelta_window_handler_t *delta_handler,
+                          void **delta_baton,
+                          apr_array_header_t *prop_diffs,
+                          apr_pool_t *pool)
+{
+  file_rev_contents_baton_t *b = baton;
+
+  SVN_TEST_ASSERT(rev > 0 && rev < (svn_revnum_t)(sizeof(b->contents)
+                                                 / sizeof(b->contents[0])));
+
+  if (delta_handler)
+    {
+      svn_stringbuf_t *target = svn_stringbuf_create_empty(b->pool);
+      svn_txdelta_apply(svn_stream_from_stringbuf(b->last, b->pool),
+                        svn_stream_from_stringbuf(target, b->pool),
+                        NULL, NULL, b->pool, delta_handler, delta_baton);
+      b->last = target;
+    }
+
+  b->contents[rev] = b->last;
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+test_get_file_revs_contents(const svn_test_opts_t *opts,
+                            apr_pool_t *pool)
+{
+  svn_repos_t *repos;
+  svn_fs_t *fs;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *txn_root;
+  svn_revnum_t youngest_rev = 0;
+  apr_pool_t *subpool = svn_pool_create(pool);
+  svn_revnum_t start;
+  const char *expected[] = {
+    NULL,
+    "This is the file 'iota'.\n",
+    "line 1\nline 2\n",
+    "line 1\nline 2\n",
+    "line 1\nline 2\nline 3\n",
+    "",
+    "line 4\n",
+  };
+
+  SVN_ERR(svn_test__create_repos(&repos, "test-repo-get-filerevs-contents",
+                                 opts, pool));
+  fs = svn_repos_fs(repos);
+
+  /* r1: the greek tree. */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, youngest_rev, subpool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, subpool));
+  SVN_ERR(svn_test__create_greek_tree(txn_root, subpool));
+  SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &youngest_rev, txn, subpool));
+  svn_pool_clear(subpool);
+
+  /* r2: text change. */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, youngest_rev, subpool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, subpool));
+  SVN_ERR(svn_test__set_file_contents(txn_root, "iota", expected[2],
+                                      subpool));
+  SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &youngest_rev, txn, subpool));
+  svn_pool_clear(subpool);
+
+  /* r3: property change only. */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, youngest_rev, subpool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, subpool));
+  SVN_ERR(svn_fs_change_node_prop(txn_root, "iota", "prop",
+                                  svn_string_create("value", subpool),
+                                  subpool));
+  SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &youngest_rev, txn, subpool));
+  svn_pool_clear(subpool);
+
+  /* r4 - r6: more text changes, including an empty file. */
+  while (youngest_rev < 6)
+    {
+      SVN_ERR(svn_fs_begin_txn(&txn, fs, youngest_rev, subpool));
+      SVN_ERR(svn_fs_txn_root(&txn_root, txn, subpool));
+      SVN_ERR(svn_test__set_file_contents(txn_root, "iota",
+                                          expected[youngest_rev + 1],
+                                          subpool));
+      SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &youngest_rev, txn,
+                                      subpool));
+      svn_pool_clear(subpool);
+    }
+
+  /* Every reported revision must reconstruct to the right fulltext,
+     whether or not the range starts at the file's first revision. */
+  for (start = 1; start <= 4; start += 3)
+    {
+      file_rev_contents_baton_t baton = { { NULL } };
+      svn_revnum_t rev;
+
+      baton.last = svn_stringbuf_create_empty(subpool);
+      baton.pool = subpool;
+
+      SVN_ERR(svn_repos_get_file_revs2(repos, "/iota", start, youngest_rev,
+                                       FALSE, NULL, NULL,
+                                       file_rev_contents_handler, &baton,
+                                       subpool));
+
+      for (rev = start; rev <= youngest_rev; ++rev)
+        {
+          SVN_TEST_ASSERT(baton.contents[rev]);
+          SVN_TEST_STRING_ASSERT(baton.contents[rev]->data, expected[rev]);
+        }
+
+      svn_pool_clear(subpool);
+    }
+
+  svn_pool_destroy(subpool);
+
+  return SVN_NO_ERROR;
+}
+
 static svn_error_t *
 issue_4060(const svn_test_opts_t *opts,
            apr_pool_t *pool)
@@ -4483,6 +4827,8 @@ static struct svn_test_descriptor_t test_funcs[] =
                        "test svn_repos_node_locations"),
     SVN_TEST_OPTS_PASS(node_locations2,
                        "test svn_repos_node_locations some more"),
+    SVN_TEST_OPTS_PASS(node_locations_replaced_repos,
+                       "test node locations of a replaced repository"),
     SVN_TEST_OPTS_PASS(rmlocks,
                        "test removal of defunct locks"),
     SVN_TEST_PASS2(authz,
@@ -4501,12 +4847,16 @@ static struct svn_test_descriptor_t test_funcs[] =
                        "test svn_repos_node_location_segments"),
     SVN_TEST_OPTS_PASS(reporter_depth_exclude,
                        "test reporter and svn_depth_exclude"),
+    SVN_TEST_OPTS_PASS(reporter_prefetch,
+                       "test reporter with prefetching enabled"),
     SVN_TEST_OPTS_PASS(prop_validation,
                        "test if revprops are validated by repos"),
     SVN_TEST_OPTS_PASS(get_logs,
                        "test svn_repos_get_logs ranges and limits"),
     SVN_TEST_OPTS_PASS(test_get_file_revs,
                        "test svn_repos_get_file_revsN"),
+    SVN_TEST_OPTS_PASS(test_get_file_revs_contents,
+                       "test svn_repos_get_file_revsN deltas"),
     SVN_TEST_OPTS_PASS(issue_4060,
                        "test issue 4060"),
     SVN_TEST_OPTS_PASS(test_delete_repos,
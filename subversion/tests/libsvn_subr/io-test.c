@@ -1042,6 +1042,72 @@ test_install_stream_over_readonly_file(apr_pool_t *pool)
   return SVN_NO_ERROR;
 }
 
+static svn_error_t *
+test_copy_file_contents(apr_pool_t *pool)
+{
+  const char *tmp_dir;
+  const char *src_abspath;
+  const char *dst_abspath;
+  svn_stringbuf_t *content;
+  svn_stringbuf_t *actual_content;
+  apr_file_t *src_file;
+  svn_stream_t *stream;
+  int i;
+
+  SVN_ERR(svn_test_make_sandbox_dir(&tmp_dir, "test_copy_file_contents",
+                                    pool));
+
+  src_abspath = svn_dirent_join(tmp_dir, "src", pool);
+  dst_abspath = svn_dirent_join(tmp_dir, "dst", pool);
+
+  /* Larger than a stream chunk, and not a multiple of the block size. */
+  content = svn_stringbuf_create_empty(pool);
+  for (i = 0; i < 20000; i++)
+    svn_stringbuf_appendcstr(content, apr_psprintf(pool, "line %d\n", i));
+  SVN_ERR(svn_io_file_create(src_abspath, content->data, pool));
+
+  /* Through an install stream, like the working copy does. */
+  SVN_ERR(svn_io_file_open(&src_file, src_abspath, APR_READ, APR_OS_DEFAULT,
+                           pool));
+  SVN_ERR(svn_stream__create_for_install(&stream, tmp_dir, pool, pool));
+  SVN_ERR(svn_io__copy_file_contents(src_file, svn_stream__aprfile(stream),
+                                     pool));
+  SVN_ERR(svn_io_file_close(src_file, pool));
+  SVN_ERR(svn_stream__install_stream(stream, dst_abspath, TRUE, pool));
+
+  SVN_ERR(svn_stringbuf_from_file2(&actual_content, dst_abspath, pool));
+  SVN_TEST_ASSERT(svn_stringbuf_compare(actual_content, content));
+
+  /* And through svn_io_copy_file(), also for an empty file. */
+  SVN_ERR(svn_io_copy_file(src_abspath, dst_abspath, FALSE, pool));
+  SVN_ERR(svn_stringbuf_from_file2(&actual_content, dst_abspath, pool));
+  SVN_TEST_ASSERT(svn_stringbuf_compare(actual_content, content));
+
+  SVN_ERR(svn_io_file_create_empty(src_abspath, pool));
+  SVN_ERR(svn_io_copy_file(src_abspath, dst_abspath, FALSE, pool));
+  SVN_ERR(svn_stringbuf_from_file2(&actual_content, dst_abspath, pool));
+  SVN_TEST_ASSERT(actual_content->len == 0);
+
+#ifdef __linux__
+  /* Files in procfs report a size of 0 and the kernel may not copy
+     anything from them, without an error. */
+  SVN_ERR(svn_stringbuf_from_file2(&content, "/proc/version", pool));
+  SVN_TEST_ASSERT(content->len > 0);
+  SVN_ERR(svn_io_file_open(&src_file, "/proc/version", APR_READ,
+                           APR_OS_DEFAULT, pool));
+  SVN_ERR(svn_stream__create_for_install(&stream, tmp_dir, pool, pool));
+  SVN_ERR(svn_io__copy_file_contents(src_file, svn_stream__aprfile(stream),
+                                     pool));
+  SVN_ERR(svn_io_file_close(src_file, pool));
+  SVN_ERR(svn_stream__install_stream(stream, dst_abspath, TRUE, pool));
+
+  SVN_ERR(svn_stringbuf_from_file2(&actual_content, dst_abspath, pool));
+  SVN_TEST_ASSERT(svn_stringbuf_compare(actual_content, content));
+#endif
+
+  return SVN_NO_ERROR;
+}
+
 static svn_error_t *
 test_file_size_get(apr_pool_t *pool)
 {
@@ -1274,6 +1340,8 @@ static struct svn_test_descriptor_t test_funcs[] =
                    "test svn_io_remove_dir2() with read-only directory"),
     SVN_TEST_PASS2(test_rmtree_all_readonly,
                    "test svn_io_remove_dir2() with read-only tree"),
+    SVN_TEST_PASS2(test_copy_file_contents,
+                   "test svn_io__copy_file_contents()"),
     SVN_TEST_NULL
   };
 
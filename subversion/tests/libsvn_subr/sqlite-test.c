@@ -170,6 +170,79 @@ test_sqlite_txn_commit_busy(apr_pool_t *pool)
   return SVN_NO_ERROR;
 }
 
+static svn_error_t *
+test_sqlite_wal_commit(apr_pool_t *pool)
+{
+  svn_sqlite__db_t *sdb1;
+  svn_sqlite__db_t *sdb2;
+  const char *db_abspath;
+  svn_boolean_t wal;
+
+  static const char *const statements[] = {
+    "CREATE TABLE test (one TEXT NOT NULL PRIMARY KEY)",
+
+    "INSERT INTO test(one) VALUES ('foo')",
+
+    "INSERT INTO test(one) VALUES ('bar')",
+
+    "SELECT one from test",
+
+    NULL
+  };
+
+  /* Open two db connections, like test_sqlite_txn_commit_busy(), but
+     switch the database to write-ahead logging first. */
+  SVN_ERR(open_db(&sdb1, &db_abspath, "wal_commit",
+                  statements, 250, pool));
+  SVN_ERR(svn_sqlite__exec_statements(sdb1, 0));
+  SVN_ERR(svn_sqlite__set_wal(&wal, sdb1, svn_tristate_true, -1,
+                              pool));
+  SVN_TEST_ASSERT(wal);
+
+  /* Without a preference, the database keeps its journal mode. */
+  SVN_ERR(svn_sqlite__set_wal(&wal, sdb1, svn_tristate_unknown, -1,
+                              pool));
+  SVN_TEST_ASSERT(wal);
+
+  /* Opening another connection must not switch the journal mode back. */
+  SVN_ERR(svn_sqlite__open(&sdb2, db_abspath, svn_sqlite__mode_readwrite,
+                           statements, 0, NULL, 250, pool, pool));
+  SVN_ERR(svn_sqlite__set_cache_size(sdb2, 4096, -1, pool));
+
+  /* Begin a read transaction on the second connection. */
+  SVN_ERR(svn_sqlite__begin_transaction(sdb2));
+  SVN_ERR(svn_sqlite__exec_statements(sdb2, 3 /* SELECT */));
+
+  /* With write-ahead logging, the concurrent reader doesn't prevent the
+     write transaction from being committed. */
+  SVN_ERR(svn_sqlite__begin_transaction(sdb1));
+  SVN_ERR(svn_sqlite__exec_statements(sdb1, 1 /* INSERT */));
+  SVN_ERR(svn_sqlite__finish_transaction(sdb1, SVN_NO_ERROR));
+
+  /* Switching back doesn't wait for the reader and doesn't fail either. */
+  SVN_ERR(svn_sqlite__set_wal(&wal, sdb1, svn_tristate_false, -1,
+                              pool));
+  SVN_TEST_ASSERT(wal);
+
+  SVN_ERR(svn_sqlite__finish_transaction(sdb2, SVN_NO_ERROR));
+
+  /* The reader sees the committed row in its next transaction and can
+     write as well. */
+  SVN_ERR(svn_sqlite__begin_transaction(sdb2));
+  SVN_ERR(svn_sqlite__exec_statements(sdb2, 2 /* INSERT */));
+  SVN_ERR(svn_sqlite__finish_transaction(sdb2, SVN_NO_ERROR));
+  SVN_ERR(svn_sqlite__close(sdb2));
+
+  /* Without other connections, the journal mode can be switched back. */
+  SVN_ERR(svn_sqlite__set_wal(&wal, sdb1, svn_tristate_false, -1,
+                              pool));
+  SVN_TEST_ASSERT(!wal);
+
+  SVN_ERR(svn_sqlite__close(sdb1));
+
+  return SVN_NO_ERROR;
+}
+
 
 static int max_threads = 1;
 
@@ -180,6 +253,8 @@ static struct svn_test_descriptor_t test_funcs[] =
                    "sqlite reset"),
     SVN_TEST_PASS2(test_sqlite_txn_commit_busy,
                    "sqlite busy on transaction commit"),
+    SVN_TEST_PASS2(test_sqlite_wal_commit,
+                   "sqlite write-ahead log allows concurrent reads"),
     SVN_TEST_NULL
   };
 
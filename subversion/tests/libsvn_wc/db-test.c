@@ -1402,6 +1402,117 @@ test_work_queue(apr_pool_t *pool)
   return SVN_NO_ERROR;
 }
 
+static svn_error_t *
+test_work_queue_lookahead(apr_pool_t *pool)
+{
+  svn_wc__db_t *db;
+  const char *local_abspath;
+  svn_skel_t *work_item;
+  apr_uint64_t ids[3];
+  apr_uint64_t id;
+  int i;
+
+  SVN_ERR(create_open(&db, &local_abspath, "test_work_queue_lookahead",
+                      pool));
+
+  /* Create three work items.  */
+  for (i = 0; i < 3; i++)
+    {
+      work_item = svn_skel__make_empty_list(pool);
+      svn_skel__prepend_int(i, work_item, pool);
+      SVN_ERR(svn_wc__db_wq_add(db, local_abspath, work_item, pool));
+    }
+
+  /* Looking ahead returns the items in order, without completing any.  */
+  SVN_ERR(svn_wc__db_wq_fetch_next(&ids[0], &work_item, db, local_abspath,
+                                   0, pool, pool));
+  SVN_TEST_ASSERT(detect_work_item(work_item) == 0);
+
+  for (i = 1; i < 3; i++)
+    {
+      SVN_ERR(svn_wc__db_wq_fetch_after(&ids[i], &work_item,
+                                        db, local_abspath, ids[i - 1],
+                                        pool, pool));
+      SVN_TEST_ASSERT(detect_work_item(work_item) == i);
+    }
+
+  SVN_ERR(svn_wc__db_wq_fetch_after(&id, &work_item, db, local_abspath,
+                                    ids[2], pool, pool));
+  SVN_TEST_ASSERT(id == 0 && work_item == NULL);
+
+  SVN_ERR(svn_wc__db_wq_fetch_next(&id, &work_item, db, local_abspath,
+                                   0, pool, pool));
+  SVN_TEST_ASSERT(id == ids[0] && detect_work_item(work_item) == 0);
+
+  /* Completing an item completes all items before it as well.  */
+  SVN_ERR(svn_wc__db_wq_fetch_next(&id, &work_item, db, local_abspath,
+                                   ids[1], pool, pool));
+  SVN_TEST_ASSERT(id == ids[2] && detect_work_item(work_item) == 2);
+
+  SVN_ERR(svn_wc__db_wq_fetch_next(&id, &work_item, db, local_abspath,
+                                   ids[2], pool, pool));
+  SVN_TEST_ASSERT(id == 0 && work_item == NULL);
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+test_batch(apr_pool_t *pool)
+{
+  svn_wc__db_t *db;
+  svn_wc__db_t *db2;
+  const char *local_abspath;
+  svn_skel_t *work_item;
+  apr_uint64_t id;
+
+  SVN_ERR(create_open(&db, &local_abspath, "test_batch", pool));
+  SVN_ERR(svn_wc__db_open(&db2, NULL, FALSE, TRUE, pool, pool));
+
+  /* Without a batch, flushing does nothing. */
+  SVN_ERR(svn_wc__db_batch_flush(db, local_abspath, pool));
+
+  SVN_ERR(svn_wc__db_batch_begin(db, local_abspath, pool));
+
+  work_item = svn_skel__make_empty_list(pool);
+  svn_skel__prepend_int(0, work_item, pool);
+  SVN_ERR(svn_wc__db_wq_add(db, local_abspath, work_item, pool));
+
+  /* The batch sees its own changes ... */
+  SVN_ERR(svn_wc__db_wq_fetch_next(&id, &work_item, db, local_abspath,
+                                   0, pool, pool));
+  SVN_TEST_ASSERT(detect_work_item(work_item) == 0);
+
+  /* ... but nobody else does, before it has been flushed. */
+  SVN_ERR(svn_wc__db_wq_fetch_next(&id, &work_item, db2, local_abspath,
+                                   0, pool, pool));
+  SVN_TEST_ASSERT(work_item == NULL);
+
+  SVN_ERR(svn_wc__db_batch_flush(db, local_abspath, pool));
+
+  SVN_ERR(svn_wc__db_wq_fetch_next(&id, &work_item, db2, local_abspath,
+                                   0, pool, pool));
+  SVN_TEST_ASSERT(detect_work_item(work_item) == 0);
+
+  /* Changes after a flush go into the next batch. */
+  SVN_ERR(svn_wc__db_wq_fetch_next(&id, &work_item, db, local_abspath,
+                                   id, pool, pool));
+  SVN_TEST_ASSERT(work_item == NULL);
+
+  SVN_ERR(svn_wc__db_wq_fetch_next(&id, &work_item, db2, local_abspath,
+                                   0, pool, pool));
+  SVN_TEST_ASSERT(detect_work_item(work_item) == 0);
+
+  SVN_ERR(svn_wc__db_batch_end(db, local_abspath, pool));
+
+  SVN_ERR(svn_wc__db_wq_fetch_next(&id, &work_item, db2, local_abspath,
+                                   0, pool, pool));
+  SVN_TEST_ASSERT(work_item == NULL);
+
+  SVN_ERR(svn_wc__db_close(db2));
+
+  return SVN_NO_ERROR;
+}
+
 static svn_error_t *
 test_externals_store(apr_pool_t *pool)
 {
@@ -1548,6 +1659,10 @@ static struct svn_test_descriptor_t test_funcs[] =
                    "relocating a node"),
     SVN_TEST_PASS2(test_work_queue,
                    "work queue processing"),
+    SVN_TEST_PASS2(test_work_queue_lookahead,
+                   "work queue look-ahead"),
+    SVN_TEST_PASS2(test_batch,
+                   "batching changes"),
     SVN_TEST_PASS2(test_externals_store,
                    "externals store"),
     SVN_TEST_NULL
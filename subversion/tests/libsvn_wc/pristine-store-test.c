@@ -35,6 +35,7 @@
 #include "svn_io.h"
 
 #include "svn_dirent_uri.h"
+#include "svn_hash.h"
 #include "svn_pools.h"
 #include "svn_repos.h"
 #include "svn_wc.h"
@@ -306,6 +307,287 @@ reject_mismatching_text(const svn_test_opts_t *opts,
 #endif
 }
 
+/* Install the same text into two working copies that share a pristine
+ * store, then remove it from both and clean up the shared store. */
+static svn_error_t *
+pristine_shared_store(const svn_test_opts_t *opts,
+                      apr_pool_t *pool)
+{
+  svn_wc__db_t *db;
+  const char *wc1_abspath, *wc2_abspath, *store_abspath;
+  svn_config_t *config;
+  svn_stream_t *contents;
+  int i;
+
+  const char data[] = "Blah";
+  svn_checksum_t *data_sha1, *data_md5;
+
+  SVN_ERR(create_repos_and_wc(&wc1_abspath, &db,
+                              "pristine_shared_store_1", opts, pool));
+  SVN_ERR(create_repos_and_wc(&wc2_abspath, &db,
+                              "pristine_shared_store_2", opts, pool));
+
+  store_abspath = svn_dirent_join(svn_dirent_dirname(wc1_abspath, pool),
+                                  "pristine_shared_store", pool);
+  SVN_ERR(svn_io_remove_dir2(store_abspath, TRUE, NULL, NULL, pool));
+  svn_test_add_dir_cleanup(store_abspath);
+
+  SVN_ERR(svn_config_create2(&config, FALSE, FALSE, pool));
+  svn_config_set(config, SVN_CONFIG_SECTION_WORKING_COPY,
+                 SVN_CONFIG_OPTION_SHARED_PRISTINE_STORE,
+                 svn_dirent_local_style(store_abspath, pool));
+  SVN_ERR(svn_wc__db_open(&db, config, FALSE, TRUE, pool, pool));
+
+  for (i = 0; i < 2; i++)
+    {
+      const char *wc_abspath = i ? wc2_abspath : wc1_abspath;
+      svn_wc__db_install_data_t *install_data;
+      svn_stream_t *pristine_stream;
+      svn_boolean_t present;
+      apr_size_t sz;
+
+      SVN_ERR(svn_wc__db_pristine_prepare_install(&pristine_stream,
+                                                  &install_data,
+                                                  &data_sha1, &data_md5,
+                                                  db, wc_abspath,
+                                                  pool, pool));
+
+      sz = strlen(data);
+      SVN_ERR(svn_stream_write(pristine_stream, data, &sz));
+      SVN_ERR(svn_stream_close(pristine_stream));
+
+      SVN_ERR(svn_wc__db_pristine_install(install_data,
+                                          data_sha1, data_md5, pool));
+
+      SVN_ERR(svn_wc__db_pristine_check(&present, db, wc_abspath, data_sha1,
+                                        pool));
+      SVN_TEST_ASSERT(present);
+    }
+
+  /* Both working copies and the store share one file. */
+  {
+    const char *pristine_abspath;
+    apr_finfo_t finfo;
+
+    SVN_ERR(svn_wc__db_pristine_get_path(&pristine_abspath, db, wc2_abspath,
+                                         data_sha1, pool, pool));
+    SVN_ERR(svn_io_stat(&finfo, pristine_abspath, APR_FINFO_NLINK, pool));
+    if (finfo.valid & APR_FINFO_NLINK)
+      SVN_TEST_ASSERT(finfo.nlink == 3);
+  }
+
+  /* The text can be read from the store without a working copy. */
+  SVN_ERR(svn_wc__db_pristine_read_shared(&contents, db, data_sha1,
+                                          pool, pool));
+  SVN_TEST_ASSERT(contents != NULL);
+  {
+    char buffer[4];
+    apr_size_t len = 4;
+
+    SVN_ERR(svn_stream_read_full(contents, buffer, &len));
+    SVN_TEST_ASSERT(len == 4);
+    SVN_TEST_ASSERT(memcmp(buffer, data, len) == 0);
+  }
+  SVN_ERR(svn_stream_close(contents));
+
+  /* While one working copy still uses it, cleanup keeps it. */
+  SVN_ERR(svn_wc__db_pristine_remove(db, wc1_abspath, data_sha1, pool));
+  SVN_ERR(svn_wc__db_pristine_cleanup(db, wc1_abspath, pool));
+  SVN_ERR(svn_wc__db_pristine_read_shared(&contents, db, data_sha1,
+                                          pool, pool));
+  SVN_TEST_ASSERT(contents != NULL);
+  SVN_ERR(svn_stream_close(contents));
+
+  SVN_ERR(svn_wc__db_pristine_remove(db, wc2_abspath, data_sha1, pool));
+  SVN_ERR(svn_wc__db_pristine_cleanup(db, wc2_abspath, pool));
+
+  /* APR doesn't report link counts on all platforms; cleanup keeps the
+     files then. */
+#if !defined(WIN32)
+  SVN_ERR(svn_wc__db_pristine_read_shared(&contents, db, data_sha1,
+                                          pool, pool));
+  SVN_TEST_ASSERT(contents == NULL);
+#endif
+
+  return SVN_NO_ERROR;
+}
+
+
+/* A text in the shared pristine store that doesn't match its name must
+ * neither be linked into working copies nor be read. */
+static svn_error_t *
+pristine_shared_store_corrupt(const svn_test_opts_t *opts,
+                              apr_pool_t *pool)
+{
+  svn_wc__db_t *db;
+  const char *wc_abspath, *store_abspath, *shared_abspath;
+  const char *pristine_abspath;
+  svn_config_t *config;
+  svn_wc__db_install_data_t *install_data;
+  svn_stream_t *pristine_stream;
+  svn_stream_t *contents;
+  svn_stringbuf_t *buf;
+  const char *hexdigest;
+  apr_size_t sz;
+
+  const char data[] = "Blah";
+  svn_checksum_t *data_sha1, *data_md5;
+
+  SVN_ERR(create_repos_and_wc(&wc_abspath, &db,
+                              "pristine_shared_store_corrupt", opts, pool));
+
+  store_abspath = svn_dirent_join(svn_dirent_dirname(wc_abspath, pool),
+                                  "pristine_shared_store_corrupt_store",
+                                  pool);
+  SVN_ERR(svn_io_remove_dir2(store_abspath, TRUE, NULL, NULL, pool));
+  svn_test_add_dir_cleanup(store_abspath);
+
+  /* Put something else into the store under the name of DATA. */
+  SVN_ERR(svn_checksum(&data_sha1, svn_checksum_sha1, data, strlen(data),
+                       pool));
+  hexdigest = svn_checksum_to_cstring(data_sha1, pool);
+  shared_abspath = svn_dirent_join_many(pool, store_abspath,
+                                        apr_pstrmemdup(pool, hexdigest, 2),
+                                        apr_pstrcat(pool, hexdigest,
+                                                    ".svn-base",
+                                                    SVN_VA_NULL),
+                                        SVN_VA_NULL);
+  SVN_ERR(svn_io_make_dir_recursively(svn_dirent_dirname(shared_abspath,
+                                                         pool),
+                                      pool));
+  SVN_ERR(svn_io_file_create(shared_abspath, "Evil", pool));
+
+  SVN_ERR(svn_config_create2(&config, FALSE, FALSE, pool));
+  svn_config_set(config, SVN_CONFIG_SECTION_WORKING_COPY,
+                 SVN_CONFIG_OPTION_SHARED_PRISTINE_STORE,
+                 svn_dirent_local_style(store_abspath, pool));
+  SVN_ERR(svn_wc__db_open(&db, config, FALSE, TRUE, pool, pool));
+
+  SVN_ERR(svn_wc__db_pristine_read_shared(&contents, db, data_sha1,
+                                          pool, pool));
+  SVN_TEST_ASSERT(contents == NULL);
+
+  SVN_ERR(svn_wc__db_pristine_prepare_install(&pristine_stream,
+                                              &install_data,
+                                              &data_sha1, &data_md5,
+                                              db, wc_abspath,
+                                              pool, pool));
+  sz = strlen(data);
+  SVN_ERR(svn_stream_write(pristine_stream, data, &sz));
+  SVN_ERR(svn_stream_close(pristine_stream));
+  SVN_ERR(svn_wc__db_pristine_install(install_data,
+                                      data_sha1, data_md5, pool));
+
+  /* The working copy keeps a private copy of the real text. */
+  SVN_ERR(svn_wc__db_pristine_get_path(&pristine_abspath, db, wc_abspath,
+                                       data_sha1, pool, pool));
+  SVN_ERR(svn_stringbuf_from_file2(&buf, pristine_abspath, pool));
+  SVN_TEST_STRING_ASSERT(buf->data, data);
+  {
+    apr_finfo_t finfo;
+
+    SVN_ERR(svn_io_stat(&finfo, pristine_abspath, APR_FINFO_NLINK, pool));
+    if (finfo.valid & APR_FINFO_NLINK)
+      SVN_TEST_ASSERT(finfo.nlink == 1);
+  }
+
+  return SVN_NO_ERROR;
+}
+
+
+/* Dehydrate the pristine text of a file and read it back, restored from
+ * the unmodified working file. */
+static svn_error_t *
+pristine_lazy(const svn_test_opts_t *opts,
+              apr_pool_t *pool)
+{
+  svn_test__sandbox_t b;
+  svn_wc__db_t *db;
+  svn_config_t *config;
+  const char *local_abspath;
+  const svn_checksum_t *checksum;
+  svn_stream_t *contents;
+  svn_stringbuf_t *buf;
+  svn_boolean_t present;
+  int format;
+  svn_error_t *err;
+
+  SVN_ERR(svn_test__sandbox_create(&b, "pristine_lazy", opts, pool));
+  SVN_ERR(sbox_file_write(&b, "f", "Blah"));
+  SVN_ERR(sbox_wc_add(&b, "f"));
+  SVN_ERR(sbox_wc_commit(&b, ""));
+  local_abspath = sbox_wc_path(&b, "f");
+
+  SVN_ERR(svn_config_create2(&config, FALSE, FALSE, pool));
+  svn_config_set_bool(config, SVN_CONFIG_SECTION_WORKING_COPY,
+                      SVN_CONFIG_OPTION_LAZY_PRISTINES, TRUE);
+  SVN_ERR(svn_wc__db_open(&db, config, FALSE, TRUE, pool, pool));
+
+  SVN_ERR(svn_wc__db_read_pristine_info(NULL, NULL, NULL, NULL, NULL, NULL,
+                                        &checksum, NULL, NULL, NULL,
+                                        db, local_abspath, pool, pool));
+
+  /* The option doesn't apply to existing working copies. */
+  SVN_ERR(svn_wc__db_pristine_dehydrate(db, local_abspath, checksum, pool));
+  SVN_ERR(svn_wc__db_pristine_check(&present, db, local_abspath, checksum,
+                                    pool));
+  SVN_TEST_ASSERT(present);
+
+  SVN_ERR(svn_wc__db_enable_lazy_pristines(db, local_abspath, pool));
+  SVN_ERR(svn_wc__db_temp_get_format(&format, db, b.wc_abspath, pool));
+  SVN_TEST_ASSERT(format == SVN_WC__LAZY_PRISTINES_VERSION);
+
+  SVN_ERR(svn_wc__db_pristine_dehydrate(db, local_abspath, checksum, pool));
+  SVN_ERR(svn_wc__db_pristine_check(&present, db, local_abspath, checksum,
+                                    pool));
+  SVN_TEST_ASSERT(! present);
+
+  SVN_ERR(svn_wc__db_pristine_read(&contents, NULL, db, local_abspath,
+                                   checksum, pool, pool));
+  SVN_ERR(svn_stringbuf_from_stream(&buf, contents, 4, pool));
+  SVN_TEST_STRING_ASSERT(buf->data, "Blah");
+  SVN_ERR(svn_wc__db_pristine_check(&present, db, local_abspath, checksum,
+                                    pool));
+  SVN_TEST_ASSERT(present);
+
+  /* A modified working file doesn't help and there is no way to reach the
+     repository through DB. */
+  SVN_ERR(svn_wc__db_pristine_dehydrate(db, local_abspath, checksum, pool));
+  SVN_ERR(sbox_file_write(&b, "f", "Modified"));
+  err = svn_wc__db_pristine_read(&contents, NULL, db, local_abspath,
+                                 checksum, pool, pool);
+  SVN_TEST_ASSERT_ERROR(err, SVN_ERR_WC_CORRUPT_TEXT_BASE);
+
+  /* A working copy checked out with the option is lazy from the start. */
+  {
+    apr_hash_t *cfg_hash = apr_hash_make(pool);
+    svn_client_ctx_t *ctx;
+    svn_opt_revision_t head_rev = { svn_opt_revision_head, { 0 } };
+    const char *wc2_abspath;
+
+    wc2_abspath = svn_dirent_join(svn_dirent_dirname(b.wc_abspath, pool),
+                                  "pristine_lazy_2", pool);
+    SVN_ERR(svn_io_remove_dir2(wc2_abspath, TRUE, NULL, NULL, pool));
+    svn_test_add_dir_cleanup(wc2_abspath);
+
+    svn_hash_sets(cfg_hash, SVN_CONFIG_CATEGORY_CONFIG, config);
+    SVN_ERR(svn_client_create_context2(&ctx, cfg_hash, pool));
+    SVN_ERR(svn_client_checkout3(NULL, b.repos_url, wc2_abspath,
+                                 &head_rev, &head_rev, svn_depth_infinity,
+                                 TRUE, FALSE, ctx, pool));
+
+    SVN_ERR(svn_wc_check_wc2(&format, ctx->wc_ctx, wc2_abspath, pool));
+    SVN_TEST_ASSERT(format == SVN_WC__LAZY_PRISTINES_VERSION);
+
+    local_abspath = svn_dirent_join(wc2_abspath, "f", pool);
+    SVN_ERR(svn_wc__db_pristine_check(&present, ctx->wc_ctx->db,
+                                      local_abspath, checksum, pool));
+    SVN_TEST_ASSERT(! present);
+  }
+
+  return SVN_NO_ERROR;
+}
+
 
 static int max_threads = -1;
 
@@ -318,6 +600,12 @@ static struct svn_test_descriptor_t test_funcs[] =
                        "pristine_delete_while_open"),
     SVN_TEST_OPTS_PASS(reject_mismatching_text,
                        "reject_mismatching_text"),
+    SVN_TEST_OPTS_PASS(pristine_shared_store,
+                       "pristine_shared_store"),
+    SVN_TEST_OPTS_PASS(pristine_shared_store_corrupt,
+                       "pristine_shared_store_corrupt"),
+    SVN_TEST_OPTS_PASS(pristine_lazy,
+                       "pristine_lazy"),
     SVN_TEST_NULL
   };
 
@@ -105,6 +105,9 @@ static const int slow_statements[] =
   /* Designed as slow to avoid penalty on other queries */
   STMT_SELECT_UNREFERENCED_PRISTINES,
 
+  /* Full NODES scan, only used when restoring a dehydrated pristine */
+  STMT_SELECT_OTHER_PRISTINE_ORIGINS,
+
   /* Slow, but just if foreign keys are enabled:
    * STMT_DELETE_PRISTINE_IF_UNREFERENCED,
    */
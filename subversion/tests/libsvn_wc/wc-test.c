@@ -21,6 +21,8 @@
  * ====================================================================
  */
 
+#include <string.h>
+
 #include <apr_pools.h>
 #include <apr_general.h>
 #include <apr_md5.h>
@@ -35,6 +37,7 @@
 #include "svn_wc.h"
 #include "svn_client.h"
 #include "svn_hash.h"
+#include "svn_props.h"
 
 #include "utils.h"
 
@@ -43,11 +46,25 @@
 #include "private/svn_dep_compat.h"
 #include "../../libsvn_wc/wc.h"
 #include "../../libsvn_wc/wc_db.h"
+#include "../../libsvn_wc/workqueue.h"
+#include "../../libsvn_wc/fsmonitor.h"
 #define SVN_WC__I_AM_WC_DB
 #include "../../libsvn_wc/wc_db_private.h"
 
 #include "../svn_test.h"
 
+#include "svn_private_config.h"
+
+#if defined(HAVE_SYS_INOTIFY_H) && APR_HAS_THREADS
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <apr_thread_proc.h>
+
+/* Run the file system monitor tests. */
+#define WC_TEST_FSMONITOR
+#endif
+
 #ifdef _MSC_VER
 #pragma warning(disable: 4221) /* nonstandard extension used */
 #endif
@@ -493,6 +510,1090 @@ test_internal_file_modified(const svn_test_opts_t *opts, apr_pool_t *pool)
   return SVN_NO_ERROR;
 }
 
+/* A file with a new timestamp is verified without reading its pristine,
+ * also when it has keywords. */
+static svn_error_t *
+test_internal_file_modified_touched(const svn_test_opts_t *opts,
+                                    apr_pool_t *pool)
+{
+  svn_test__sandbox_t b;
+  svn_boolean_t modified;
+  const char *iota_path;
+  const char *kw_path;
+  const svn_checksum_t *checksum;
+  apr_time_t time;
+
+  SVN_ERR(svn_test__sandbox_create(&b, "internal_file_modified_touched",
+                                   opts, pool));
+  SVN_ERR(sbox_add_and_commit_greek_tree(&b));
+  SVN_ERR(sbox_file_write(&b, "kw", "$Id$\n"));
+  SVN_ERR(sbox_wc_add(&b, "kw"));
+  SVN_ERR(sbox_wc_propset(&b, SVN_PROP_KEYWORDS, "Id", "kw"));
+  SVN_ERR(sbox_wc_commit(&b, ""));
+
+  iota_path = sbox_wc_path(&b, "iota");
+  kw_path = sbox_wc_path(&b, "kw");
+
+  /* Remove the pristine of 'kw', which can't be restored from its
+     working file. */
+  SVN_ERR(svn_wc__db_read_pristine_info(NULL, NULL, NULL, NULL, NULL, NULL,
+                                        &checksum, NULL, NULL, NULL,
+                                        b.wc_ctx->db, kw_path, pool, pool));
+  {
+    const char *pristine_abspath;
+
+    SVN_ERR(svn_wc__db_pristine_get_path(&pristine_abspath, b.wc_ctx->db,
+                                         kw_path, checksum, pool, pool));
+    SVN_ERR(svn_io_remove_file2(pristine_abspath, FALSE, pool));
+  }
+
+  SVN_ERR(svn_io_file_affected_time(&time, kw_path, pool));
+  SVN_ERR(svn_io_set_file_affected_time(time + apr_time_from_sec(1),
+                                        kw_path, pool));
+  SVN_ERR(svn_wc__internal_file_modified_p(&modified, b.wc_ctx->db,
+                                           kw_path, FALSE, pool));
+  SVN_TEST_ASSERT(!modified);
+
+  /* Same size, new content and a new timestamp. */
+  SVN_ERR(svn_io_file_affected_time(&time, iota_path, pool));
+  SVN_ERR(sbox_file_write(&b, "iota", "This is the file 'IOTA'.\n"));
+  SVN_ERR(svn_io_set_file_affected_time(time + apr_time_from_sec(1),
+                                        iota_path, pool));
+  SVN_ERR(svn_wc__internal_file_modified_p(&modified, b.wc_ctx->db,
+                                           iota_path, FALSE, pool));
+  SVN_TEST_ASSERT(modified);
+
+  SVN_ERR(svn_wc__internal_file_modified_p(&modified, b.wc_ctx->db,
+                                           iota_path, TRUE, pool));
+  SVN_TEST_ASSERT(modified);
+
+  return SVN_NO_ERROR;
+}
+
+/* A status run without a lock records the size and timestamp of a
+ * touched, unmodified file, unless someone else holds the lock. */
+static svn_error_t *
+test_status_records_touched_fileinfo(const svn_test_opts_t *opts,
+                                     apr_pool_t *pool)
+{
+  svn_test__sandbox_t b;
+  svn_wc_context_t *other_ctx;
+  svn_wc__text_check_t *check;
+  svn_wc_status3_t *status;
+  svn_boolean_t modified;
+  const char *iota_path;
+  apr_time_t time;
+
+  SVN_ERR(svn_test__sandbox_create(&b, "status_records_touched_fileinfo",
+                                   opts, pool));
+  SVN_ERR(sbox_add_and_commit_greek_tree(&b));
+  iota_path = sbox_wc_path(&b, "iota");
+
+  SVN_ERR(svn_io_file_affected_time(&time, iota_path, pool));
+  SVN_ERR(svn_io_set_file_affected_time(time + apr_time_from_sec(1),
+                                        iota_path, pool));
+
+  /* The touched file needs a content pass ... */
+  SVN_ERR(svn_wc__text_check_prepare(&check, &modified, b.wc_ctx->db,
+                                     iota_path, FALSE, pool, pool));
+  SVN_TEST_ASSERT(check != NULL);
+
+  /* ... until a status run found it unmodified. */
+  SVN_ERR(svn_wc_status3(&status, b.wc_ctx, iota_path, pool, pool));
+  SVN_TEST_ASSERT(status->node_status == svn_wc_status_normal);
+
+  SVN_ERR(svn_wc__text_check_prepare(&check, &modified, b.wc_ctx->db,
+                                     iota_path, FALSE, pool, pool));
+  SVN_TEST_ASSERT(check == NULL && !modified);
+
+  /* While another client holds the lock, the status run leaves the
+     recorded information alone. */
+  SVN_ERR(svn_wc_context_create(&other_ctx, NULL, pool, pool));
+  SVN_ERR(svn_wc__acquire_write_lock(NULL, other_ctx, b.wc_abspath, FALSE,
+                                     pool, pool));
+
+  SVN_ERR(svn_io_set_file_affected_time(time + apr_time_from_sec(2),
+                                        iota_path, pool));
+  SVN_ERR(svn_wc_status3(&status, b.wc_ctx, iota_path, pool, pool));
+  SVN_TEST_ASSERT(status->node_status == svn_wc_status_normal);
+
+  SVN_ERR(svn_wc__text_check_prepare(&check, &modified, b.wc_ctx->db,
+                                     iota_path, FALSE, pool, pool));
+  SVN_TEST_ASSERT(check != NULL);
+
+  SVN_ERR(svn_wc__release_write_lock(other_ctx, b.wc_abspath, pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* Cleanup replays a queue of file removals and installations, some of
+ * which depend on each other, in queue order.  Afterwards, the recorded
+ * size and timestamp of all files match the files themselves. */
+static svn_error_t *
+test_cleanup_replays_file_items(const svn_test_opts_t *opts,
+                                apr_pool_t *pool)
+{
+  svn_test__sandbox_t b;
+  const char *files[] = { "iota", "A/mu", "A/B/lambda", "A/D/gamma",
+                          "A/D/G/pi", "A/D/H/chi", "A/C/f", NULL };
+  const char *stray_path, *dir_path, *rho_path;
+  svn_skel_t *work_items = NULL;
+  svn_skel_t *work_item;
+  svn_wc__text_check_t *check;
+  svn_boolean_t modified;
+  svn_node_kind_t kind;
+  apr_time_t time;
+  int i;
+
+  SVN_ERR(svn_test__sandbox_create(&b, "cleanup_replays_file_items",
+                                   opts, pool));
+  SVN_ERR(sbox_add_and_commit_greek_tree(&b));
+  SVN_ERR(sbox_file_write(&b, "A/C/f", "This is the file 'f'.\n"));
+  SVN_ERR(sbox_wc_add(&b, "A/C/f"));
+  SVN_ERR(sbox_wc_commit(&b, ""));
+
+  stray_path = sbox_wc_path(&b, "A/stray");
+  SVN_ERR(sbox_file_write(&b, "A/stray", "stray\n"));
+
+  /* A file obstructs the directory of A/C/f.  Installing the file can't
+     start before the obstruction is gone. */
+  dir_path = sbox_wc_path(&b, "A/C");
+  SVN_ERR(svn_io_remove_dir2(dir_path, FALSE, NULL, NULL, pool));
+  SVN_ERR(sbox_file_write(&b, "A/C", "obstruction\n"));
+
+  /* Cleanup must also repair the recorded information of files that
+     were merely touched. */
+  rho_path = sbox_wc_path(&b, "A/D/G/rho");
+  SVN_ERR(svn_io_file_affected_time(&time, rho_path, pool));
+  SVN_ERR(svn_io_set_file_affected_time(time + apr_time_from_sec(1),
+                                        rho_path, pool));
+
+  /* Remove all files, then install them again and remove STRAY_PATH. */
+  for (i = 0; files[i]; i++)
+    {
+      SVN_ERR(svn_wc__wq_build_file_remove(&work_item, b.wc_ctx->db,
+                                           b.wc_abspath,
+                                           sbox_wc_path(&b, files[i]),
+                                           pool, pool));
+      work_items = svn_wc__wq_merge(work_items, work_item, pool);
+    }
+  SVN_ERR(svn_wc__wq_build_file_remove(&work_item, b.wc_ctx->db,
+                                       b.wc_abspath, dir_path,
+                                       pool, pool));
+  work_items = svn_wc__wq_merge(work_items, work_item, pool);
+  for (i = 0; files[i]; i++)
+    {
+      SVN_ERR(svn_wc__wq_build_file_install(&work_item, b.wc_ctx->db,
+                                            sbox_wc_path(&b, files[i]),
+                                            NULL, FALSE, TRUE,
+                                            pool, pool));
+      work_items = svn_wc__wq_merge(work_items, work_item, pool);
+    }
+  SVN_ERR(svn_wc__wq_build_file_remove(&work_item, b.wc_ctx->db,
+                                       b.wc_abspath, stray_path,
+                                       pool, pool));
+  work_items = svn_wc__wq_merge(work_items, work_item, pool);
+
+  SVN_ERR(svn_wc__db_wq_add(b.wc_ctx->db, b.wc_abspath, work_items, pool));
+
+  SVN_ERR(svn_wc_cleanup4(b.wc_ctx, b.wc_abspath, FALSE, TRUE, FALSE, FALSE,
+                          NULL, NULL, NULL, NULL, pool));
+
+  for (i = 0; files[i]; i++)
+    {
+      const char *local_abspath = sbox_wc_path(&b, files[i]);
+      svn_stringbuf_t *contents;
+
+      SVN_ERR(svn_stringbuf_from_file2(&contents, local_abspath, pool));
+      SVN_TEST_STRING_ASSERT(contents->data,
+                             apr_psprintf(pool, "This is the file '%s'.\n",
+                                          svn_relpath_basename(files[i],
+                                                               NULL)));
+
+      SVN_ERR(svn_wc__text_check_prepare(&check, &modified, b.wc_ctx->db,
+                                         local_abspath, FALSE, pool, pool));
+      SVN_TEST_ASSERT(check == NULL && !modified);
+    }
+
+  SVN_ERR(svn_wc__text_check_prepare(&check, &modified, b.wc_ctx->db,
+                                     rho_path, FALSE, pool, pool));
+  SVN_TEST_ASSERT(check == NULL && !modified);
+
+  SVN_ERR(svn_io_check_path(dir_path, &kind, pool));
+  SVN_TEST_ASSERT(kind == svn_node_dir);
+
+  SVN_ERR(svn_io_check_path(stray_path, &kind, pool));
+  SVN_TEST_ASSERT(kind == svn_node_none);
+
+  return SVN_NO_ERROR;
+}
+
+/* Running the work queue installs a long run of files in parallel, but
+ * still in queue order where items depend on each other. */
+static svn_error_t *
+test_wq_parallel_install(const svn_test_opts_t *opts,
+                         apr_pool_t *pool)
+{
+  svn_test__sandbox_t b;
+  svn_skel_t *work_items = NULL;
+  svn_skel_t *work_item;
+  svn_stringbuf_t *contents;
+  svn_boolean_t modified;
+  svn_node_kind_t kind;
+  apr_uint64_t id;
+  const char *path;
+  int i;
+
+  SVN_ERR(svn_test__sandbox_create(&b, "wq_parallel_install", opts, pool));
+  SVN_ERR(sbox_add_and_commit_greek_tree(&b));
+  for (i = 0; i < 100; i++)
+    {
+      path = apr_psprintf(pool, "A/C/f%02d", i);
+      SVN_ERR(sbox_file_write(&b, path, apr_psprintf(pool, "file %d\n", i)));
+      SVN_ERR(sbox_wc_add(&b, path));
+    }
+  SVN_ERR(sbox_wc_commit(&b, ""));
+
+  /* More files than a single run takes. */
+  for (i = 0; i < 100; i++)
+    {
+      path = sbox_wc_path(&b, apr_psprintf(pool, "A/C/f%02d", i));
+      SVN_ERR(svn_io_remove_file2(path, FALSE, pool));
+      SVN_ERR(svn_wc__wq_build_file_install(&work_item, b.wc_ctx->db, path,
+                                            NULL, FALSE, TRUE, pool, pool));
+      work_items = svn_wc__wq_merge(work_items, work_item, pool);
+    }
+
+  /* Installing a file and removing it, ... */
+  SVN_ERR(svn_wc__wq_build_file_install(&work_item, b.wc_ctx->db,
+                                        sbox_wc_path(&b, "A/mu"),
+                                        NULL, FALSE, TRUE, pool, pool));
+  work_items = svn_wc__wq_merge(work_items, work_item, pool);
+  SVN_ERR(svn_wc__wq_build_file_remove(&work_item, b.wc_ctx->db,
+                                       b.wc_abspath, sbox_wc_path(&b, "A/mu"),
+                                       pool, pool));
+  work_items = svn_wc__wq_merge(work_items, work_item, pool);
+
+  /* ... removing a file and installing it, ... */
+  SVN_ERR(svn_wc__wq_build_file_remove(&work_item, b.wc_ctx->db,
+                                       b.wc_abspath, sbox_wc_path(&b, "iota"),
+                                       pool, pool));
+  work_items = svn_wc__wq_merge(work_items, work_item, pool);
+  SVN_ERR(svn_wc__wq_build_file_install(&work_item, b.wc_ctx->db,
+                                        sbox_wc_path(&b, "iota"),
+                                        NULL, FALSE, TRUE, pool, pool));
+  work_items = svn_wc__wq_merge(work_items, work_item, pool);
+
+  /* ... and removing the source of an installation must all happen in
+     that order. */
+  SVN_ERR(sbox_file_write(&b, "A/source", "source\n"));
+  SVN_ERR(svn_wc__wq_build_file_install(&work_item, b.wc_ctx->db,
+                                        sbox_wc_path(&b, "A/B/lambda"),
+                                        sbox_wc_path(&b, "A/source"),
+                                        FALSE, FALSE, pool, pool));
+  work_items = svn_wc__wq_merge(work_items, work_item, pool);
+  SVN_ERR(svn_wc__wq_build_file_remove(&work_item, b.wc_ctx->db,
+                                       b.wc_abspath,
+                                       sbox_wc_path(&b, "A/source"),
+                                       pool, pool));
+  work_items = svn_wc__wq_merge(work_items, work_item, pool);
+
+  SVN_ERR(svn_wc__db_wq_add(b.wc_ctx->db, b.wc_abspath, work_items, pool));
+  SVN_ERR(svn_wc__wq_run(b.wc_ctx->db, b.wc_abspath, NULL, NULL, pool));
+
+  for (i = 0; i < 100; i++)
+    {
+      path = sbox_wc_path(&b, apr_psprintf(pool, "A/C/f%02d", i));
+      SVN_ERR(svn_stringbuf_from_file2(&contents, path, pool));
+      SVN_TEST_STRING_ASSERT(contents->data,
+                             apr_psprintf(pool, "file %d\n", i));
+
+      SVN_ERR(svn_wc__internal_file_modified_p(&modified, b.wc_ctx->db,
+                                               path, FALSE, pool));
+      SVN_TEST_ASSERT(!modified);
+    }
+
+  SVN_ERR(svn_io_check_path(sbox_wc_path(&b, "A/mu"), &kind, pool));
+  SVN_TEST_ASSERT(kind == svn_node_none);
+  SVN_ERR(svn_stringbuf_from_file2(&contents, sbox_wc_path(&b, "iota"),
+                                   pool));
+  SVN_TEST_STRING_ASSERT(contents->data, "This is the file 'iota'.\n");
+  SVN_ERR(svn_stringbuf_from_file2(&contents, sbox_wc_path(&b, "A/B/lambda"),
+                                   pool));
+  SVN_TEST_STRING_ASSERT(contents->data, "source\n");
+  SVN_ERR(svn_io_check_path(sbox_wc_path(&b, "A/source"), &kind, pool));
+  SVN_TEST_ASSERT(kind == svn_node_none);
+
+  SVN_ERR(svn_wc__db_wq_fetch_next(&id, &work_item, b.wc_ctx->db,
+                                   b.wc_abspath, 0, pool, pool));
+  SVN_TEST_ASSERT(id == 0 && work_item == NULL);
+
+  return SVN_NO_ERROR;
+}
+
+/* If installations of a parallel run fail, the queue runner reports the
+ * first failing item in queue order and leaves the whole run queued. */
+static svn_error_t *
+test_wq_parallel_install_error(const svn_test_opts_t *opts,
+                               apr_pool_t *pool)
+{
+  svn_test__sandbox_t b;
+  const char *files[] = { "iota", "A/D/gamma", "A/B/lambda", "A/mu", NULL };
+  apr_uint64_t ids[4];
+  svn_skel_t *work_items = NULL;
+  svn_skel_t *work_item;
+  svn_stringbuf_t *contents;
+  svn_error_t *err;
+  apr_uint64_t id;
+  int i, run;
+
+  SVN_ERR(svn_test__sandbox_create(&b, "wq_parallel_install_error",
+                                   opts, pool));
+  SVN_ERR(sbox_add_and_commit_greek_tree(&b));
+
+  for (i = 0; files[i]; i++)
+    {
+      SVN_ERR(svn_wc__wq_build_file_install(&work_item, b.wc_ctx->db,
+                                            sbox_wc_path(&b, files[i]),
+                                            NULL, FALSE, TRUE, pool, pool));
+      work_items = svn_wc__wq_merge(work_items, work_item, pool);
+    }
+  SVN_ERR(svn_wc__db_wq_add(b.wc_ctx->db, b.wc_abspath, work_items, pool));
+
+  SVN_ERR(svn_wc__db_wq_fetch_next(&ids[0], &work_item, b.wc_ctx->db,
+                                   b.wc_abspath, 0, pool, pool));
+  for (i = 1; files[i]; i++)
+    SVN_ERR(svn_wc__db_wq_fetch_after(&ids[i], &work_item, b.wc_ctx->db,
+                                      b.wc_abspath, ids[i - 1], pool, pool));
+
+  /* Files where A/D and A/B should be make both of their installations
+     fail, in whichever order they get to run. */
+  SVN_ERR(svn_io_remove_dir2(sbox_wc_path(&b, "A/D"), FALSE, NULL, NULL,
+                             pool));
+  SVN_ERR(svn_io_remove_dir2(sbox_wc_path(&b, "A/B"), FALSE, NULL, NULL,
+                             pool));
+  SVN_ERR(sbox_file_write(&b, "A/D", "not a directory\n"));
+  SVN_ERR(sbox_file_write(&b, "A/B", "not a directory\n"));
+
+  for (run = 0; run < 5; run++)
+    {
+      err = svn_wc__wq_run(b.wc_ctx->db, b.wc_abspath, NULL, NULL, pool);
+      SVN_TEST_ASSERT(err && err->apr_err == SVN_ERR_WC_BAD_ADM_LOG);
+      SVN_TEST_ASSERT(strstr(err->message,
+                             apr_psprintf(pool, "work item %d ",
+                                          (int)ids[1])) != NULL);
+      svn_error_clear(err);
+
+      SVN_ERR(svn_wc__db_wq_fetch_next(&id, &work_item, b.wc_ctx->db,
+                                       b.wc_abspath, 0, pool, pool));
+#if APR_HAS_THREADS
+      SVN_TEST_ASSERT(id == ids[0]);
+#else
+      /* Without threads, items are run and completed one by one. */
+      SVN_TEST_ASSERT(id == ids[1]);
+#endif
+    }
+
+  /* Once the problem is gone, the whole run succeeds. */
+  SVN_ERR(svn_io_remove_file2(sbox_wc_path(&b, "A/D"), FALSE, pool));
+  SVN_ERR(svn_io_remove_file2(sbox_wc_path(&b, "A/B"), FALSE, pool));
+  SVN_ERR(svn_wc__wq_run(b.wc_ctx->db, b.wc_abspath, NULL, NULL, pool));
+
+  for (i = 0; files[i]; i++)
+    {
+      SVN_ERR(svn_stringbuf_from_file2(&contents, sbox_wc_path(&b, files[i]),
+                                       pool));
+      SVN_TEST_STRING_ASSERT(contents->data,
+                             apr_psprintf(pool, "This is the file '%s'.\n",
+                                          svn_relpath_basename(files[i],
+                                                               NULL)));
+    }
+
+  SVN_ERR(svn_wc__db_wq_fetch_next(&id, &work_item, b.wc_ctx->db,
+                                   b.wc_abspath, 0, pool, pool));
+  SVN_TEST_ASSERT(id == 0 && work_item == NULL);
+
+  return SVN_NO_ERROR;
+}
+
+/* An update receives file texts and installs their pristines while the
+ * update editor batches its DB changes. */
+static svn_error_t *
+test_update_installs_pristines(const svn_test_opts_t *opts,
+                               apr_pool_t *pool)
+{
+  svn_test__sandbox_t b;
+  svn_stringbuf_t *contents;
+  svn_boolean_t modified;
+
+  SVN_ERR(svn_test__sandbox_create(&b, "update_installs_pristines",
+                                   opts, pool));
+  SVN_ERR(sbox_add_and_commit_greek_tree(&b));
+  SVN_ERR(sbox_file_write(&b, "iota", "new iota\n"));
+  SVN_ERR(sbox_file_write(&b, "A/new", "new file\n"));
+  SVN_ERR(sbox_wc_add(&b, "A/new"));
+  SVN_ERR(sbox_wc_commit(&b, ""));
+
+  /* Receive all texts of r1, then the changed and added ones of r2. */
+  SVN_ERR(sbox_wc_update(&b, "", 0));
+  SVN_ERR(sbox_wc_update(&b, "", 1));
+  SVN_ERR(sbox_wc_update(&b, "", 2));
+
+  SVN_ERR(svn_stringbuf_from_file2(&contents, sbox_wc_path(&b, "iota"),
+                                   pool));
+  SVN_TEST_STRING_ASSERT(contents->data, "new iota\n");
+  SVN_ERR(svn_stringbuf_from_file2(&contents, sbox_wc_path(&b, "A/new"),
+                                   pool));
+  SVN_TEST_STRING_ASSERT(contents->data, "new file\n");
+  SVN_ERR(svn_stringbuf_from_file2(&contents, sbox_wc_path(&b, "A/mu"),
+                                   pool));
+  SVN_TEST_STRING_ASSERT(contents->data, "This is the file 'mu'.\n");
+
+  SVN_ERR(svn_wc__internal_file_modified_p(&modified, b.wc_ctx->db,
+                                           sbox_wc_path(&b, "iota"),
+                                           TRUE, pool));
+  SVN_TEST_ASSERT(!modified);
+
+  return SVN_NO_ERROR;
+}
+
+/* Baton for status_order_func(). */
+typedef struct status_order_baton_t
+{
+  /* Working copy root; reported paths are relative to it. */
+  const char *wc_abspath;
+
+  /* "relpath status" strings in callback order. */
+  apr_array_header_t *reports;
+} status_order_baton_t;
+
+/* Implements svn_wc_status_func4_t, recording the callbacks. */
+static svn_error_t *
+status_order_func(void *baton,
+                  const char *local_abspath,
+                  const svn_wc_status3_t *status,
+                  apr_pool_t *scratch_pool)
+{
+  status_order_baton_t *b = baton;
+  apr_pool_t *pool = b->reports->pool;
+
+  APR_ARRAY_PUSH(b->reports, const char *)
+    = apr_psprintf(pool, "%s %d",
+                   svn_dirent_skip_ancestor(b->wc_abspath, local_abspath),
+                   (int)status->node_status);
+
+  return SVN_NO_ERROR;
+}
+
+/* The status walker compares files and reads directories in worker
+ * threads but still reports every node once, in depth-first order with
+ * sorted siblings, and with the same results as a sequential walk. */
+static svn_error_t *
+test_status_walk_parallel(const svn_test_opts_t *opts,
+                          apr_pool_t *pool)
+{
+  svn_test__sandbox_t b;
+  status_order_baton_t sb;
+  apr_array_header_t *expected;
+  apr_time_t time;
+  const char *path;
+  int i, run;
+
+  SVN_ERR(svn_test__sandbox_create(&b, "status_walk_parallel", opts, pool));
+  SVN_ERR(sbox_add_and_commit_greek_tree(&b));
+
+  /* Give the threads something to do. */
+  for (i = 0; i < 40; i++)
+    {
+      path = apr_psprintf(pool, "A/C/f%02d", i);
+      SVN_ERR(sbox_file_write(&b, path, "file\n"));
+      SVN_ERR(sbox_wc_add(&b, path));
+    }
+  SVN_ERR(sbox_wc_commit(&b, ""));
+
+  /* Same size changes with new timestamps and unchanged but touched files
+     need a content comparison. */
+  for (i = 0; i < 40; i++)
+    {
+      path = sbox_wc_path(&b, apr_psprintf(pool, "A/C/f%02d", i));
+      SVN_ERR(svn_io_file_affected_time(&time, path, pool));
+      if (i % 3 == 0)
+        SVN_ERR(sbox_file_write(&b, path, "FILE\n"));
+      SVN_ERR(svn_io_set_file_affected_time(time + apr_time_from_sec(1),
+                                            path, pool));
+    }
+  path = sbox_wc_path(&b, "iota");
+  SVN_ERR(svn_io_file_affected_time(&time, path, pool));
+  SVN_ERR(sbox_file_write(&b, "iota", "This is the file 'IOTA'.\n"));
+  SVN_ERR(svn_io_set_file_affected_time(time + apr_time_from_sec(1),
+                                        path, pool));
+  SVN_ERR(sbox_file_write(&b, "A/mu", "new mu\n"));
+  SVN_ERR(svn_io_remove_file2(sbox_wc_path(&b, "A/D/G/rho"), FALSE, pool));
+  SVN_ERR(sbox_file_write(&b, "A/D/zeta", "unversioned\n"));
+
+  expected = apr_array_make(pool, 64, sizeof(const char *));
+#define EXPECT(relpath, status) \
+  APR_ARRAY_PUSH(expected, const char *) \
+    = apr_psprintf(pool, "%s %d", (relpath), (int)(status))
+
+  EXPECT("", svn_wc_status_normal);
+  EXPECT("A", svn_wc_status_normal);
+  EXPECT("A/B", svn_wc_status_normal);
+  EXPECT("A/B/E", svn_wc_status_normal);
+  EXPECT("A/B/E/alpha", svn_wc_status_normal);
+  EXPECT("A/B/E/beta", svn_wc_status_normal);
+  EXPECT("A/B/F", svn_wc_status_normal);
+  EXPECT("A/B/lambda", svn_wc_status_normal);
+  EXPECT("A/C", svn_wc_status_normal);
+  for (i = 0; i < 40; i++)
+    EXPECT(apr_psprintf(pool, "A/C/f%02d", i),
+           i % 3 == 0 ? svn_wc_status_modified : svn_wc_status_normal);
+  EXPECT("A/D", svn_wc_status_normal);
+  EXPECT("A/D/G", svn_wc_status_normal);
+  EXPECT("A/D/G/pi", svn_wc_status_normal);
+  EXPECT("A/D/G/rho", svn_wc_status_missing);
+  EXPECT("A/D/G/tau", svn_wc_status_normal);
+  EXPECT("A/D/H", svn_wc_status_normal);
+  EXPECT("A/D/H/chi", svn_wc_status_normal);
+  EXPECT("A/D/H/omega", svn_wc_status_normal);
+  EXPECT("A/D/H/psi", svn_wc_status_normal);
+  EXPECT("A/D/gamma", svn_wc_status_normal);
+  EXPECT("A/D/zeta", svn_wc_status_unversioned);
+  EXPECT("A/mu", svn_wc_status_modified);
+  EXPECT("iota", svn_wc_status_modified);
+#undef EXPECT
+
+  /* The order must not depend on which thread finishes first. */
+  for (run = 0; run < 5; run++)
+    {
+      apr_pool_t *iterpool = svn_pool_create(pool);
+
+      sb.wc_abspath = b.wc_abspath;
+      sb.reports = apr_array_make(iterpool, 64, sizeof(const char *));
+      SVN_ERR(svn_wc_walk_status(b.wc_ctx, b.wc_abspath, svn_depth_infinity,
+                                 TRUE /* get_all */, FALSE /* no_ignore */,
+                                 FALSE /* ignore_text_mods */, NULL,
+                                 status_order_func, &sb, NULL, NULL,
+                                 iterpool));
+
+      SVN_TEST_INT_ASSERT(sb.reports->nelts, expected->nelts);
+      for (i = 0; i < expected->nelts; i++)
+        SVN_TEST_STRING_ASSERT(APR_ARRAY_IDX(sb.reports, i, const char *),
+                               APR_ARRAY_IDX(expected, i, const char *));
+
+      svn_pool_destroy(iterpool);
+    }
+
+  return SVN_NO_ERROR;
+}
+
+#ifdef WC_TEST_FSMONITOR
+
+/* A working copy monitor running in a thread of the test process. */
+typedef struct fsmonitor_thread_t
+{
+  /* The working copy that it watches. */
+  const char *wcroot_abspath;
+
+  /* Set to make svn_wc__fsmonitor_run() return. */
+  volatile svn_boolean_t stop;
+
+  /* The result of svn_wc__fsmonitor_run(). */
+  svn_error_t *err;
+
+  /* Used by the thread only.  Destroying it removes the socket. */
+  apr_pool_t *pool;
+
+  /* NULL once stopped. */
+  apr_thread_t *thread;
+} fsmonitor_thread_t;
+
+/* Implements svn_cancel_func_t for a fsmonitor_thread_t. */
+static svn_error_t *
+fsmonitor_cancel(void *baton)
+{
+  fsmonitor_thread_t *monitor = baton;
+
+  if (monitor->stop)
+    return svn_error_create(SVN_ERR_CANCELLED, NULL, NULL);
+
+  return SVN_NO_ERROR;
+}
+
+/* Thread function running the fsmonitor_thread_t in BATON. */
+static void * APR_THREAD_FUNC
+fsmonitor_thread_func(apr_thread_t *thread, void *baton)
+{
+  fsmonitor_thread_t *monitor = baton;
+
+  monitor->err = svn_wc__fsmonitor_run(monitor->wcroot_abspath,
+                                       fsmonitor_cancel, monitor,
+                                       monitor->pool);
+
+  apr_thread_exit(thread, APR_SUCCESS);
+  return NULL;
+}
+
+/* Stop MONITOR if it is still running and return the error that it
+ * stopped with, if that was not the cancellation. */
+static svn_error_t *
+stop_fsmonitor(fsmonitor_thread_t *monitor)
+{
+  apr_status_t retval;
+  svn_error_t *err;
+
+  if (!monitor->thread)
+    return SVN_NO_ERROR;
+
+  /* The monitor checks for cancellation at least once a second. */
+  monitor->stop = TRUE;
+  apr_thread_join(&retval, monitor->thread);
+  monitor->thread = NULL;
+  svn_pool_destroy(monitor->pool);
+
+  err = monitor->err;
+  monitor->err = SVN_NO_ERROR;
+  if (err && err->apr_err == SVN_ERR_CANCELLED)
+    {
+      svn_error_clear(err);
+      return SVN_NO_ERROR;
+    }
+
+  return svn_error_trace(err);
+}
+
+/* Pool pre-cleanup handler stopping the fsmonitor_thread_t in DATA, so that
+ * a failing test does not leave it running on freed memory. */
+static apr_status_t
+stop_fsmonitor_cleanup(void *data)
+{
+  svn_error_clear(stop_fsmonitor(data));
+  return APR_SUCCESS;
+}
+
+/* Start a monitor for the working copy of B in a new thread, allocated in
+ * POOL, return it in *MONITOR and wait until it answers queries. */
+static svn_error_t *
+start_fsmonitor(fsmonitor_thread_t **monitor,
+                svn_test__sandbox_t *b,
+                apr_pool_t *pool)
+{
+  fsmonitor_thread_t *m = apr_pcalloc(pool, sizeof(*m));
+  apr_status_t status;
+  int i;
+
+  m->wcroot_abspath = b->wc_abspath;
+  m->pool = svn_pool_create(pool);
+
+  status = apr_thread_create(&m->thread, NULL, fsmonitor_thread_func, m,
+                             pool);
+  if (status)
+    return svn_error_wrap_apr(status, "Can't create monitor thread");
+
+  apr_pool_pre_cleanup_register(pool, m, stop_fsmonitor_cleanup);
+
+  for (i = 0; i < 100; i++)
+    {
+      apr_pool_t *iterpool = svn_pool_create(pool);
+      svn_wc__fsmonitor_t *fsmonitor;
+
+      SVN_ERR(svn_wc__fsmonitor_query(&fsmonitor, b->wc_abspath,
+                                      iterpool, iterpool));
+      svn_pool_destroy(iterpool);
+
+      if (fsmonitor)
+        {
+          *monitor = m;
+          return SVN_NO_ERROR;
+        }
+
+      apr_sleep(apr_time_from_msec(100));
+    }
+
+  return svn_error_create(SVN_ERR_TEST_FAILED, stop_fsmonitor(m),
+                          "Monitor did not start");
+}
+
+/* Set *CLEAN to whether the monitor of B reports RELPATH as clean. */
+static svn_error_t *
+fsmonitor_is_clean(svn_boolean_t *clean,
+                   svn_test__sandbox_t *b,
+                   const char *relpath,
+                   apr_pool_t *pool)
+{
+  svn_wc__fsmonitor_t *fsmonitor;
+
+  SVN_ERR(svn_wc__fsmonitor_query(&fsmonitor, b->wc_abspath, pool, pool));
+  SVN_TEST_ASSERT(fsmonitor != NULL);
+
+  *clean = svn_wc__fsmonitor_is_clean(fsmonitor, sbox_wc_path(b, relpath));
+  return SVN_NO_ERROR;
+}
+
+/* Walk the whole working copy of B and return the "relpath status"
+ * strings of the status walker in *REPORTS, allocated in POOL. */
+static svn_error_t *
+walk_all(apr_array_header_t **reports,
+         svn_test__sandbox_t *b,
+         apr_pool_t *pool)
+{
+  status_order_baton_t sb;
+
+  sb.wc_abspath = b->wc_abspath;
+  sb.reports = apr_array_make(pool, 32, sizeof(const char *));
+  SVN_ERR(svn_wc_walk_status(b->wc_ctx, b->wc_abspath, svn_depth_infinity,
+                             TRUE /* get_all */, FALSE /* no_ignore */,
+                             FALSE /* ignore_text_mods */, NULL,
+                             status_order_func, &sb, NULL, NULL, pool));
+
+  *reports = sb.reports;
+  return SVN_NO_ERROR;
+}
+
+/* Return TRUE if REPORTS contain RELPATH with STATUS. */
+static svn_boolean_t
+reported(const apr_array_header_t *reports,
+         const char *relpath,
+         enum svn_wc_status_kind status,
+         apr_pool_t *pool)
+{
+  const char *expected = apr_psprintf(pool, "%s %d", relpath, (int)status);
+  int i;
+
+  for (i = 0; i < reports->nelts; i++)
+    if (strcmp(APR_ARRAY_IDX(reports, i, const char *), expected) == 0)
+      return TRUE;
+
+  return FALSE;
+}
+
+/* Create the Greek tree in B with recorded sizes and timestamps that the
+ * status walker can trust. */
+static svn_error_t *
+create_monitored_tree(svn_test__sandbox_t *b,
+                      apr_pool_t *pool)
+{
+  SVN_ERR(sbox_add_and_commit_greek_tree(b));
+  SVN_ERR(svn_wc_cleanup4(b->wc_ctx, b->wc_abspath,
+                          FALSE /* break_locks */,
+                          TRUE /* fix_recorded_timestamps */,
+                          FALSE /* clear_dav_cache */,
+                          FALSE /* vacuum_pristines */,
+                          NULL, NULL, NULL, NULL, pool));
+  return SVN_NO_ERROR;
+}
+
+/* Set *SOCK to a new connection to the monitor socket of B. */
+static svn_error_t *
+connect_fsmonitor(int *sock,
+                  svn_test__sandbox_t *b,
+                  apr_pool_t *pool)
+{
+  struct sockaddr_un addr;
+  const char *path = svn_dirent_join_many(pool, b->wc_abspath,
+                                          svn_wc_get_adm_dir(pool),
+                                          "fsmonitor", SVN_VA_NULL);
+
+  SVN_TEST_ASSERT(strlen(path) < sizeof(addr.sun_path));
+  memset(&addr, 0, sizeof(addr));
+  addr.sun_family = AF_UNIX;
+  strcpy(addr.sun_path, path);
+
+  *sock = socket(AF_UNIX, SOCK_STREAM, 0);
+  SVN_TEST_ASSERT(*sock >= 0);
+  if (connect(*sock, (struct sockaddr *)&addr, sizeof(addr)) < 0)
+    {
+      close(*sock);
+      return svn_error_wrap_apr(apr_get_netos_error(),
+                                "Can't connect to monitor");
+    }
+
+  return SVN_NO_ERROR;
+}
+
+#endif /* WC_TEST_FSMONITOR */
+
+/* The file system monitor tells the status walker which directories it
+ * does not need to read, and forgets everything once wc.db changes. */
+static svn_error_t *
+test_fsmonitor_wc_db_change(const svn_test_opts_t *opts,
+                            apr_pool_t *pool)
+{
+#ifdef WC_TEST_FSMONITOR
+  svn_test__sandbox_t b;
+  fsmonitor_thread_t *monitor;
+  apr_array_header_t *reports;
+  svn_boolean_t clean;
+
+  SVN_ERR(svn_test__sandbox_create(&b, "fsmonitor_wc_db_change", opts,
+                                   pool));
+  SVN_ERR(create_monitored_tree(&b, pool));
+  SVN_ERR(start_fsmonitor(&monitor, &b, pool));
+
+  /* A new monitor knows nothing ... */
+  SVN_ERR(fsmonitor_is_clean(&clean, &b, "A/D", pool));
+  SVN_TEST_ASSERT(!clean);
+
+  /* ... until a full status walk tells it what it found. */
+  SVN_ERR(walk_all(&reports, &b, pool));
+  SVN_ERR(fsmonitor_is_clean(&clean, &b, "A/D", pool));
+  SVN_TEST_ASSERT(clean);
+  SVN_ERR(fsmonitor_is_clean(&clean, &b, "", pool));
+  SVN_TEST_ASSERT(clean);
+
+  /* A changed file only affects its directory. */
+  SVN_ERR(sbox_file_write(&b, "A/B/lambda", "new lambda\n"));
+  SVN_ERR(fsmonitor_is_clean(&clean, &b, "A/B", pool));
+  SVN_TEST_ASSERT(!clean);
+  SVN_ERR(fsmonitor_is_clean(&clean, &b, "A/D", pool));
+  SVN_TEST_ASSERT(clean);
+
+  SVN_ERR(walk_all(&reports, &b, pool));
+  SVN_TEST_ASSERT(reported(reports, "A/B/lambda", svn_wc_status_modified,
+                           pool));
+  SVN_TEST_ASSERT(reported(reports, "A/D/gamma", svn_wc_status_normal,
+                           pool));
+
+  /* Changing wc.db changes what clean means. */
+  SVN_ERR(sbox_wc_propset(&b, "key", "value", "iota"));
+  SVN_ERR(fsmonitor_is_clean(&clean, &b, "A/D", pool));
+  SVN_TEST_ASSERT(!clean);
+  SVN_ERR(fsmonitor_is_clean(&clean, &b, "", pool));
+  SVN_TEST_ASSERT(!clean);
+
+  SVN_ERR(walk_all(&reports, &b, pool));
+  SVN_TEST_ASSERT(reported(reports, "iota", svn_wc_status_modified, pool));
+  SVN_TEST_ASSERT(reported(reports, "A/B/lambda", svn_wc_status_modified,
+                           pool));
+
+  return svn_error_trace(stop_fsmonitor(monitor));
+#else
+  return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL,
+                          "Working copy monitors need inotify and threads");
+#endif
+}
+
+/* A socket left behind by a monitor that went away neither breaks status
+ * walks nor keeps a new monitor from starting. */
+static svn_error_t *
+test_fsmonitor_stale_socket(const svn_test_opts_t *opts,
+                            apr_pool_t *pool)
+{
+#ifdef WC_TEST_FSMONITOR
+  svn_test__sandbox_t b;
+  fsmonitor_thread_t *monitor;
+  svn_wc__fsmonitor_t *fsmonitor;
+  apr_array_header_t *reports;
+  struct sockaddr_un addr;
+  svn_boolean_t clean;
+  const char *path;
+  int sock;
+
+  SVN_ERR(svn_test__sandbox_create(&b, "fsmonitor_stale_socket", opts,
+                                   pool));
+  SVN_ERR(create_monitored_tree(&b, pool));
+
+  /* Bind the monitor's socket and go away without removing it. */
+  path = svn_dirent_join_many(pool, b.wc_abspath, svn_wc_get_adm_dir(pool),
+                              "fsmonitor", SVN_VA_NULL);
+  SVN_TEST_ASSERT(strlen(path) < sizeof(addr.sun_path));
+  memset(&addr, 0, sizeof(addr));
+  addr.sun_family = AF_UNIX;
+  strcpy(addr.sun_path, path);
+
+  sock = socket(AF_UNIX, SOCK_STREAM, 0);
+  SVN_TEST_ASSERT(sock >= 0);
+  if (bind(sock, (struct sockaddr *)&addr, sizeof(addr)) < 0)
+    {
+      close(sock);
+      return svn_error_wrap_apr(apr_get_netos_error(),
+                                "Can't bind '%s'", path);
+    }
+  close(sock);
+
+  SVN_ERR(svn_wc__fsmonitor_query(&fsmonitor, b.wc_abspath, pool, pool));
+  SVN_TEST_ASSERT(fsmonitor == NULL);
+
+  SVN_ERR(sbox_file_write(&b, "A/mu", "new mu\n"));
+  SVN_ERR(walk_all(&reports, &b, pool));
+  SVN_TEST_ASSERT(reported(reports, "A/mu", svn_wc_status_modified, pool));
+  SVN_TEST_ASSERT(reported(reports, "iota", svn_wc_status_normal, pool));
+
+  /* A new monitor takes the socket over. */
+  SVN_ERR(start_fsmonitor(&monitor, &b, pool));
+  SVN_ERR(walk_all(&reports, &b, pool));
+  SVN_ERR(fsmonitor_is_clean(&clean, &b, "A/D", pool));
+  SVN_TEST_ASSERT(clean);
+
+  return svn_error_trace(stop_fsmonitor(monitor));
+#else
+  return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL,
+                          "Working copy monitors need inotify and threads");
+#endif
+}
+
+/* When the kernel drops file system events, the monitor must not claim to
+ * know anything until the next full status walk. */
+static svn_error_t *
+test_fsmonitor_overflow(const svn_test_opts_t *opts,
+                        apr_pool_t *pool)
+{
+#ifdef WC_TEST_FSMONITOR
+  svn_test__sandbox_t b;
+  fsmonitor_thread_t *monitor;
+  apr_array_header_t *reports;
+  svn_stringbuf_t *contents;
+  svn_stringbuf_t *response;
+  svn_boolean_t clean;
+  apr_int64_t max_events;
+  apr_pool_t *iterpool;
+  const char *path;
+  svn_error_t *err;
+  char buffer[256];
+  ssize_t len;
+  int sock;
+  int i;
+
+  /* Each round below queues three events. */
+  err = svn_stringbuf_from_file2(&contents,
+                                 "/proc/sys/fs/inotify/max_queued_events",
+                                 pool);
+  if (!err)
+    {
+      svn_stringbuf_strip_whitespace(contents);
+      err = svn_cstring_atoi64(&max_events, contents->data);
+    }
+  if (err)
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, err,
+                            "Can't read the inotify queue size");
+  if (max_events > 64 * 1024)
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL,
+                            "The inotify queue is too large to overflow");
+
+  SVN_ERR(svn_test__sandbox_create(&b, "fsmonitor_overflow", opts, pool));
+  SVN_ERR(create_monitored_tree(&b, pool));
+  SVN_ERR(start_fsmonitor(&monitor, &b, pool));
+  SVN_ERR(walk_all(&reports, &b, pool));
+  SVN_ERR(fsmonitor_is_clean(&clean, &b, "A/D", pool));
+  SVN_TEST_ASSERT(clean);
+
+  /* Keep the monitor busy waiting for our request, so that it can't read
+     any events while we flood its queue. */
+  SVN_ERR(connect_fsmonitor(&sock, &b, pool));
+  apr_sleep(apr_time_from_msec(200));
+
+  path = sbox_wc_path(&b, "A/C/flood");
+  iterpool = svn_pool_create(pool);
+  for (i = 0; i < max_events; i++)
+    {
+      svn_pool_clear(iterpool);
+      err = svn_io_file_create_empty(path, iterpool);
+      if (!err)
+        err = svn_io_remove_file2(path, FALSE, iterpool);
+      if (err)
+        {
+          close(sock);
+          return svn_error_trace(err);
+        }
+    }
+  svn_pool_destroy(iterpool);
+
+  response = svn_stringbuf_create_empty(pool);
+  if (send(sock, "query\n", 6, MSG_NOSIGNAL) != 6
+      || shutdown(sock, SHUT_WR) < 0)
+    {
+      close(sock);
+      return svn_error_wrap_apr(apr_get_netos_error(),
+                                "Can't send monitor request");
+    }
+  while ((len = recv(sock, buffer, sizeof(buffer), 0)) > 0)
+    svn_stringbuf_appendbytes(response, buffer, len);
+  close(sock);
+
+  SVN_TEST_ASSERT(strncmp(response->data, "invalid ", 8) == 0);
+  SVN_ERR(fsmonitor_is_clean(&clean, &b, "A/D", pool));
+  SVN_TEST_ASSERT(!clean);
+
+  /* The next full walk makes it useful again. */
+  SVN_ERR(walk_all(&reports, &b, pool));
+  SVN_ERR(fsmonitor_is_clean(&clean, &b, "A/D", pool));
+  SVN_TEST_ASSERT(clean);
+
+  return svn_error_trace(stop_fsmonitor(monitor));
+#else
+  return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL,
+                          "Working copy monitors need inotify and threads");
+#endif
+}
+
+/* The update editor creates an added directory on disk right away, while
+ * it batches its DB changes.  An interrupted edit must not leave that
+ * directory unversioned behind. */
+static svn_error_t *
+test_update_interrupted_add_directory(const svn_test_opts_t *opts,
+                                      apr_pool_t *pool)
+{
+  svn_test__sandbox_t b;
+  apr_pool_t *edit_pool = svn_pool_create(pool);
+  const svn_delta_editor_t *editor;
+  void *edit_baton, *root_baton, *a_baton, *new_baton;
+  svn_revnum_t target_revision;
+  svn_wc_context_t *other_ctx;
+  svn_node_kind_t kind;
+  svn_boolean_t tree_conflicted;
+  const char *new_abspath;
+
+  SVN_ERR(svn_test__sandbox_create(&b, "update_interrupted_add_directory",
+                                   opts, pool));
+  SVN_ERR(sbox_add_and_commit_greek_tree(&b));
+  SVN_ERR(sbox_wc_mkdir(&b, "A/new"));
+  SVN_ERR(sbox_wc_commit(&b, ""));
+  SVN_ERR(sbox_wc_update(&b, "", 1));
+  new_abspath = sbox_wc_path(&b, "A/new");
+
+  /* Start the update to r2, but stop right after adding A/new. */
+  SVN_ERR(svn_wc__acquire_write_lock(NULL, b.wc_ctx, b.wc_abspath, FALSE,
+                                     pool, pool));
+  SVN_ERR(svn_wc_get_update_editor4(&editor, &edit_baton, &target_revision,
+                                    b.wc_ctx, b.wc_abspath, "",
+                                    FALSE, svn_depth_infinity, FALSE,
+                                    FALSE, FALSE, FALSE, FALSE,
+                                    NULL, NULL, NULL, NULL, NULL, NULL,
+                                    NULL, NULL, NULL, NULL, NULL, NULL,
+                                    edit_pool, pool));
+  SVN_ERR(editor->set_target_revision(edit_baton, 2, edit_pool));
+  SVN_ERR(editor->open_root(edit_baton, 1, edit_pool, &root_baton));
+  SVN_ERR(editor->open_directory("A", root_baton, 1, edit_pool, &a_baton));
+  SVN_ERR(editor->add_directory("A/new", a_baton, NULL, SVN_INVALID_REVNUM,
+                                edit_pool, &new_baton));
+
+  /* The directory exists, so its node must have been committed:  a crash
+   * right now would roll back everything that is still batched.  Another
+   * DB connection only sees what has been committed. */
+  SVN_ERR(svn_io_check_path(new_abspath, &kind, pool));
+  SVN_TEST_ASSERT(kind == svn_node_dir);
+  SVN_ERR(svn_wc_context_create(&other_ctx, NULL, pool, pool));
+  SVN_ERR(svn_wc_read_kind2(&kind, other_ctx, new_abspath, TRUE, TRUE,
+                            pool));
+  SVN_TEST_ASSERT(kind == svn_node_dir);
+  SVN_ERR(svn_wc_context_destroy(other_ctx));
+
+  SVN_ERR(editor->abort_edit(edit_baton, edit_pool));
+  svn_pool_destroy(edit_pool);
+  SVN_ERR(svn_wc__release_write_lock(b.wc_ctx, b.wc_abspath, pool));
+
+  /* The next update completes the directory without a conflict. */
+  SVN_ERR(sbox_wc_update(&b, "", 2));
+  SVN_ERR(svn_wc_read_kind2(&kind, b.wc_ctx, new_abspath, FALSE, FALSE,
+                            pool));
+  SVN_TEST_ASSERT(kind == svn_node_dir);
+  SVN_ERR(svn_wc_conflicted_p3(NULL, NULL, &tree_conflicted, b.wc_ctx,
+                               new_abspath, pool));
+  SVN_TEST_ASSERT(!tree_conflicted);
+
+  return SVN_NO_ERROR;
+}
+
 /* ---------------------------------------------------------------------- */
 /* The list of test functions */
 
@@ -515,6 +1616,28 @@ static struct svn_test_descriptor_t test_funcs[] =
                        "test legacy commit2"),
     SVN_TEST_OPTS_PASS(test_internal_file_modified,
                        "test internal_file_modified"),
+    SVN_TEST_OPTS_PASS(test_internal_file_modified_touched,
+                       "test internal_file_modified after touch"),
+    SVN_TEST_OPTS_PASS(test_status_records_touched_fileinfo,
+                       "test status recording touched file info"),
+    SVN_TEST_OPTS_PASS(test_cleanup_replays_file_items,
+                       "test cleanup replaying file work items"),
+    SVN_TEST_OPTS_PASS(test_wq_parallel_install,
+                       "test installing files in parallel"),
+    SVN_TEST_OPTS_PASS(test_wq_parallel_install_error,
+                       "test failing parallel file installations"),
+    SVN_TEST_OPTS_PASS(test_update_installs_pristines,
+                       "test update installing pristines in a batch"),
+    SVN_TEST_OPTS_PASS(test_update_interrupted_add_directory,
+                       "test interrupted update after add_directory"),
+    SVN_TEST_OPTS_PASS(test_status_walk_parallel,
+                       "test parallel status walk order"),
+    SVN_TEST_OPTS_PASS(test_fsmonitor_wc_db_change,
+                       "test monitor forgetting on wc.db changes"),
+    SVN_TEST_OPTS_PASS(test_fsmonitor_stale_socket,
+                       "test monitor socket left behind"),
+    SVN_TEST_OPTS_PASS(test_fsmonitor_overflow,
+                       "test monitor event queue overflow"),
     SVN_TEST_NULL
   };
 
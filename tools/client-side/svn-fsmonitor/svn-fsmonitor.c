@@ -0,0 +1,129 @@
+/*
+ * svn-fsmonitor.c:  Keep track of changed directories in a working copy
+ *                   so that 'svn status' can skip the unchanged ones.
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+#include <string.h>
+
+#include <apr_general.h>
+
+#include "svn_cmdline.h"
+#include "svn_pools.h"
+#include "svn_wc.h"
+#include "svn_dirent_uri.h"
+#include "svn_error.h"
+#include "svn_opt.h"
+#include "svn_utf.h"
+
+#include "private/svn_cmdline_private.h"
+#include "private/svn_wc_private.h"
+
+#include "svn_private_config.h"
+
+static void
+usage(FILE *stream)
+{
+  svn_error_clear(svn_cmdline_fputs(
+    _("usage: svn-fsmonitor [WCPATH]\n"
+      "\n"
+      "  Watch the working copy containing WCPATH (default: '.') for\n"
+      "  changes until interrupted.  While it runs, 'svn status' and\n"
+      "  'svn commit' don't read directories from disk that did not change\n"
+      "  since the last status walk over the whole working copy.\n"),
+    stream, NULL));
+}
+
+static svn_error_t *
+sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
+{
+  const char *path = ".";
+  const char *local_abspath;
+  const char *wcroot_abspath;
+  svn_wc_context_t *wc_ctx;
+  svn_error_t *err;
+
+  if (argc > 2
+      || (argc == 2 && (!strcmp(argv[1], "-h")
+                        || !strcmp(argv[1], "--help"))))
+    {
+      usage(argc > 2 ? stderr : stdout);
+      *exit_code = (argc > 2) ? EXIT_FAILURE : EXIT_SUCCESS;
+      return SVN_NO_ERROR;
+    }
+
+  if (argc == 2)
+    SVN_ERR(svn_utf_cstring_to_utf8(&path, argv[1], pool));
+
+  SVN_ERR(svn_dirent_get_absolute(&local_abspath,
+                                  svn_dirent_internal_style(path, pool),
+                                  pool));
+  SVN_ERR(svn_wc_context_create(&wc_ctx, NULL, pool, pool));
+  SVN_ERR(svn_wc__get_wcroot(&wcroot_abspath, wc_ctx, local_abspath,
+                             pool, pool));
+
+  /* The monitor doesn't need the working copy database while it runs. */
+  SVN_ERR(svn_wc_context_destroy(wc_ctx));
+
+  err = svn_wc__fsmonitor_run(wcroot_abspath,
+                              svn_cmdline__setup_cancellation_handler(),
+                              NULL, pool);
+
+  /* Being interrupted is the normal way to stop the monitor. */
+  if (err && err->apr_err == SVN_ERR_CANCELLED)
+    {
+      svn_error_clear(err);
+      return SVN_NO_ERROR;
+    }
+
+  return svn_error_trace(err);
+}
+
+int
+main(int argc, const char *argv[])
+{
+  apr_pool_t *pool;
+  int exit_code = EXIT_SUCCESS;
+  svn_error_t *err;
+
+  /* Initialize the app. */
+  if (svn_cmdline_init("svn-fsmonitor", stderr) != EXIT_SUCCESS)
+    return EXIT_FAILURE;
+
+  /* Create our top-level pool.  Use a separate mutexless allocator,
+   * given this application is single threaded.
+   */
+  pool = apr_allocator_owner_get(svn_pool_create_allocator(FALSE));
+
+  err = sub_main(&exit_code, argc, argv, pool);
+
+  if (err)
+    {
+      exit_code = EXIT_FAILURE;
+      svn_cmdline_handle_exit_error(err, NULL, "svn-fsmonitor: ");
+    }
+
+  svn_pool_destroy(pool);
+
+  svn_cmdline__cancellation_exit();
+
+  return exit_code;
+}
@@ -0,0 +1,107 @@
+#!/bin/sh
+
+# Licensed to the Apache Software Foundation (ASF) under one
+# or more contributor license agreements.  See the NOTICE file
+# distributed with this work for additional information
+# regarding copyright ownership.  The ASF licenses this file
+# to you under the Apache License, Version 2.0 (the
+# "License"); you may not use this file except in compliance
+# with the License.  You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing,
+# software distributed under the License is distributed on an
+# "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+# KIND, either express or implied.  See the License for the
+# specific language governing permissions and limitations
+# under the License.
+
+# usage: filter_throughput.sh [PREFIXES] [REVISIONS] [LOOPS]
+#
+# Measures the throughput of svndumpfilter for many include prefixes.
+#
+# First, every dump file of the svndumpfilter_tests.py test data is
+# filtered LOOPS times with PREFIXES prefixes, most of which don't match
+# anything.  Then a synthetic dump with REVISIONS revisions of 100 files
+# each is filtered once, renumbering the revisions and dropping the
+# empty ones.  The script reports the wall clock time of each step.
+#
+# Set SVNDUMPFILTER_OLD to another svndumpfilter binary to compare both.
+
+# if using the installed svndumpfilter, you may need to adapt the following.
+
+SVNDUMPFILTER=${SVNDUMPFILTER:-svndumpfilter}
+
+PREFIXES=${1:-2000}
+REVISIONS=${2:-20000}
+LOOPS=${3:-200}
+FILES=100
+
+TESTDATA="$(dirname "$0")/../../../../subversion/tests/cmdline/svndumpfilter_tests_data"
+WORKDIR="$(pwd)/dumpfilter_bench"
+
+make_data() {
+  rm -rf "$WORKDIR"
+  mkdir -p "$WORKDIR"
+
+  # Most prefixes match nothing; every tenth one matches a synthetic
+  # directory and a few match paths of the test data.
+  awk -v n="$PREFIXES" 'BEGIN {
+    print "/A/D/G"; print "/trunk/A/B"; print "/branches";
+    for (i = 0; i < n; i++)
+      if (i % 10 == 0) printf "/d%d\n", i; else printf "/x%d/y\n", i;
+  }' > "$WORKDIR/prefixes"
+
+  awk -v revs="$REVISIONS" -v files="$FILES" 'BEGIN {
+    print "SVN-fs-dump-format-version: 2\n";
+    print "UUID: 00000000-0000-0000-0000-000000000000\n";
+    print "Revision-number: 0";
+    print "Prop-content-length: 10\nContent-length: 10\n\nPROPS-END\n";
+    for (r = 1; r <= revs; r++) {
+      printf "Revision-number: %d\n", r;
+      print "Prop-content-length: 10\nContent-length: 10\n\nPROPS-END\n";
+      printf "Node-path: d%d\nNode-kind: dir\nNode-action: add\n", r;
+      print "Prop-content-length: 10\nContent-length: 10\n\nPROPS-END\n\n";
+      for (f = 0; f < files; f++) {
+        text = sprintf("file %d/%d\n", r, f);
+        printf "Node-path: d%d/f%d\nNode-kind: file\nNode-action: add\n", r, f;
+        printf "Prop-content-length: 10\nText-content-length: %d\n",
+               length(text);
+        printf "Content-length: %d\n\nPROPS-END\n%s\n\n",
+               length(text) + 10, text;
+      }
+    }
+  }' > "$WORKDIR/synthetic.dump"
+}
+
+run_filter() {
+  filter=$1
+
+  start=$(date +%s)
+  for dump in "$TESTDATA"/*.dump; do
+    i=0
+    while [ $i -lt $LOOPS ]; do
+      $filter include -q --targets "$WORKDIR/prefixes" \
+        < "$dump" > /dev/null 2>&1
+      i=$((i+1))
+    done
+  done
+  end=$(date +%s)
+  echo "$filter: test data, $LOOPS loops: $((end-start)) s"
+
+  start=$(date +%s)
+  $filter include -q --drop-empty-revs --renumber-revs \
+    --targets "$WORKDIR/prefixes" \
+    < "$WORKDIR/synthetic.dump" > "$WORKDIR/filtered.dump"
+  end=$(date +%s)
+  echo "$filter: $REVISIONS revisions," \
+       "$(wc -c < "$WORKDIR/synthetic.dump") bytes: $((end-start)) s"
+}
+
+make_data
+run_filter "$SVNDUMPFILTER"
+if [ -n "$SVNDUMPFILTER_OLD" ]; then
+  run_filter "$SVNDUMPFILTER_OLD"
+fi
+rm -rf "$WORKDIR"
@@ -0,0 +1,126 @@
+#!/bin/sh
+
+# Licensed to the Apache Software Foundation (ASF) under one
+# or more contributor license agreements.  See the NOTICE file
+# distributed with this work for additional information
+# regarding copyright ownership.  The ASF licenses this file
+# to you under the Apache License, Version 2.0 (the
+# "License"); you may not use this file except in compliance
+# with the License.  You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing,
+# software distributed under the License is distributed on an
+# "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+# KIND, either express or implied.  See the License for the
+# specific language governing permissions and limitations
+# under the License.
+
+# usage: tls_vs_ssh.sh [SESSIONS] [PORT]
+#
+# Compares encrypted access via svn:// with TLS (svnserve --tls-cert)
+# against svn+ssh:// and plain svn://.
+#
+# A repository with a few thousand files is created and served by a
+# local svnserve daemon on PORT.  For each access method, the script
+# reports the wall clock time of SESSIONS 'svn info' runs, which is
+# dominated by connection setup, and of one checkout, which shows the
+# throughput.  The checkouts use svn-max-connections = 4; the additional
+# svn:// sessions run over the first, multiplexed connection or resume
+# its TLS session.
+# Separate processes do not share TLS sessions, so every 'svn info' run
+# performs a full handshake, just like ssh does.
+#
+# svn+ssh:// needs passwordless ssh access to localhost and the svnserve
+# binary below in the PATH of the remote shell.
+
+# if using the installed svn, you may need to adapt the following.
+
+SVN=${SVN:-svn}
+SVNADMIN=${SVNADMIN:-svnadmin}
+SVNSERVE=${SVNSERVE:-svnserve}
+OPENSSL=${OPENSSL:-openssl}
+
+SESSIONS=${1:-50}
+PORT=${2:-3691}
+DIRS=50
+FILES=100
+
+WORKDIR="$(pwd)/tls_bench"
+
+make_repo() {
+  rm -rf "$WORKDIR"
+  mkdir -p "$WORKDIR/import"
+  $SVNADMIN create "$WORKDIR/repo"
+
+  d=0
+  while [ $d -lt $DIRS ]; do
+    mkdir "$WORKDIR/import/d$d"
+    f=0
+    while [ $f -lt $FILES ]; do
+      head -c 4096 /dev/urandom > "$WORKDIR/import/d$d/f$f"
+      f=$((f+1))
+    done
+    d=$((d+1))
+  done
+
+  $SVN import -q -m "import" "$WORKDIR/import" "file://$WORKDIR/repo/trunk"
+  rm -rf "$WORKDIR/import"
+}
+
+start_server() {
+  $OPENSSL req -x509 -newkey ec -pkeyopt ec_paramgen_curve:prime256v1 \
+           -nodes -days 1 -subj "/CN=localhost" \
+           -addext "subjectAltName=DNS:localhost" \
+           -keyout "$WORKDIR/key.pem" -out "$WORKDIR/cert.pem" 2> /dev/null
+
+  $SVNSERVE -d -T --listen-host localhost --listen-port $PORT \
+            -r "$WORKDIR" --pid-file "$WORKDIR/svnserve.pid" \
+            --tls-cert "$WORKDIR/cert.pem" --tls-key "$WORKDIR/key.pem"
+  sleep 1
+}
+
+stop_server() {
+  kill $(cat "$WORKDIR/svnserve.pid")
+}
+
+# Write a client configuration for svn-tls = $1 to directory $2.
+make_config() {
+  mkdir -p "$2"
+  printf '[global]\nsvn-tls = %s\nssl-authority-files = %s\n' \
+         "$1" "$WORKDIR/cert.pem" > "$2/servers"
+  printf 'svn-max-connections = 4\n' >> "$2/servers"
+}
+
+run_method() {
+  name=$1
+  url=$2
+  config=$3
+
+  start=$(date +%s.%N)
+  i=0
+  while [ $i -lt $SESSIONS ]; do
+    $SVN info --config-dir "$config" "$url/trunk" > /dev/null
+    i=$((i+1))
+  done
+  mid=$(date +%s.%N)
+  $SVN checkout -q --config-dir "$config" "$url/trunk" "$WORKDIR/wc-$name"
+  end=$(date +%s.%N)
+  rm -rf "$WORKDIR/wc-$name"
+
+  echo "$name: $SESSIONS sessions in $(echo "$mid - $start" | bc) s," \
+       "checkout in $(echo "$end - $mid" | bc) s"
+}
+
+make_repo
+start_server
+make_config no "$WORKDIR/config-plain"
+make_config yes "$WORKDIR/config-tls"
+
+run_method plain "svn://localhost:$PORT/repo" "$WORKDIR/config-plain"
+run_method tls "svn://localhost:$PORT/repo" "$WORKDIR/config-tls"
+run_method ssh "svn+ssh://localhost$WORKDIR/repo" "$WORKDIR/config-plain"
+
+stop_server
+rm -rf "$WORKDIR"
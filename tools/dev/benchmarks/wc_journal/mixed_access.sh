@@ -0,0 +1,127 @@
+#!/bin/sh
+
+# Licensed to the Apache Software Foundation (ASF) under one
+# or more contributor license agreements.  See the NOTICE file
+# distributed with this work for additional information
+# regarding copyright ownership.  The ASF licenses this file
+# to you under the Apache License, Version 2.0 (the
+# "License"); you may not use this file except in compliance
+# with the License.  You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing,
+# software distributed under the License is distributed on an
+# "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+# KIND, either express or implied.  See the License for the
+# specific language governing permissions and limitations
+# under the License.
+
+# usage: mixed_access.sh [READERS] [ROUNDS]
+#
+# Measures how working copy writers (update) and readers (status, as
+# run by IDEs polling the working copy) get in each other's way, once
+# with the default rollback journal and once with write-ahead logging
+# (the [working-copy] journal-mode option).
+#
+# For each mode, a repository with a few thousand files is created and
+# checked out.  Then ROUNDS updates between two revisions are run while
+# READERS processes run 'svn status' in a loop.  The script reports the
+# wall clock time of the updates, the number of completed status runs
+# and the number of status runs that failed because the working copy
+# was busy.
+
+# if using the installed svn, you may need to adapt the following.
+
+SVN=${SVN:-svn}
+SVNADMIN=${SVNADMIN:-svnadmin}
+
+READERS=${1:-4}
+ROUNDS=${2:-10}
+DIRS=50
+FILES=100
+
+WORKDIR="$(pwd)/wc_journal_bench"
+
+make_repo() {
+  rm -rf "$WORKDIR"
+  mkdir -p "$WORKDIR/import"
+  $SVNADMIN create "$WORKDIR/repo"
+  REPOURL="file://$WORKDIR/repo"
+
+  d=0
+  while [ $d -lt $DIRS ]; do
+    mkdir "$WORKDIR/import/d$d"
+    f=0
+    while [ $f -lt $FILES ]; do
+      echo "file $d/$f" > "$WORKDIR/import/d$d/f$f"
+      f=$((f+1))
+    done
+    d=$((d+1))
+  done
+
+  $SVN import -q -m "import" "$WORKDIR/import" "$REPOURL/trunk"
+  $SVN checkout -q "$REPOURL/trunk" "$WORKDIR/modify"
+
+  # r2 touches every other directory
+  d=0
+  while [ $d -lt $DIRS ]; do
+    f=0
+    while [ $f -lt $FILES ]; do
+      echo "changed" >> "$WORKDIR/modify/d$d/f$f"
+      f=$((f+1))
+    done
+    d=$((d+2))
+  done
+  $SVN commit -q -m "modify" "$WORKDIR/modify"
+}
+
+run_mode() {
+  mode=$1
+  config="$WORKDIR/config-$mode"
+  wc="$WORKDIR/wc-$mode"
+
+  mkdir -p "$config"
+  printf '[working-copy]\njournal-mode = %s\n' "$mode" > "$config/config"
+
+  $SVN checkout -q --config-dir "$config" -r1 "$REPOURL/trunk" "$wc"
+
+  rm -f "$WORKDIR/reader-"*
+  r=0
+  while [ $r -lt $READERS ]; do
+    (
+      while [ ! -f "$WORKDIR/stop" ]; do
+        if $SVN status -q --config-dir "$config" "$wc" > /dev/null 2>&1
+        then
+          echo ok >> "$WORKDIR/reader-$r"
+        else
+          echo busy >> "$WORKDIR/reader-$r"
+        fi
+      done
+    ) &
+    r=$((r+1))
+  done
+
+  start=$(date +%s)
+  i=0
+  while [ $i -lt $ROUNDS ]; do
+    $SVN update -q --config-dir "$config" -r2 "$wc"
+    $SVN update -q --config-dir "$config" -r1 "$wc"
+    i=$((i+1))
+  done
+  end=$(date +%s)
+
+  touch "$WORKDIR/stop"
+  wait
+  rm -f "$WORKDIR/stop"
+
+  ok=$(cat "$WORKDIR/reader-"* | grep -c ok)
+  busy=$(cat "$WORKDIR/reader-"* | grep -c busy)
+  echo "$mode: $((ROUNDS*2)) updates in $((end-start)) s," \
+       "$ok status runs, $busy failed"
+}
+
+make_repo
+run_mode default
+run_mode wal
+rm -rf "$WORKDIR"